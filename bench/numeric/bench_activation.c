@@ -0,0 +1,235 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_activation.c
+ * @brief Activation row kernels against per-element scalar loops, per CPU level.
+ *
+ * The baselines call the scalar activations (libm underneath) once per element, which is what
+ * callers did before the row kernels existed. Half rows are timed through the lookup tables,
+ * the fused kernels and the three-pass widen/activate/narrow path the fused kernels replace.
+ * Softmax is compared with the former three-pass loop (max, expf and sum, divide).
+ * Throughput is elements per second.
+ */
+
+#include "core/cpu.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/activation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_ELEMENTS (1u << 26) // elements per case
+
+typedef void (*BenchActivationRow)(const float* input, float* output, size_t length);
+
+typedef struct BenchActivation {
+    const char* name;
+    float (*scalar)(float x); // baseline, applied per element
+    BenchActivationRow row;
+    int function; // ActivationFunction for the half rows, or -1
+} BenchActivation;
+
+static float bench_expf(float x) {
+    return expf(x);
+}
+
+static const BenchActivation BENCH_ACTIVATIONS[] = {
+    {"exp", bench_expf, activate_exp_row, -1},
+    {"relu", activate_relu, activate_relu_row, ACTIVATION_RELU},
+    {"sigmoid", activate_sigmoid, activate_sigmoid_row, ACTIVATION_SIGMOID},
+    {"tanh", activate_tanh, activate_tanh_row, ACTIVATION_TANH},
+    {"silu", activate_silu, activate_silu_row, ACTIVATION_SILU},
+    {"gelu", activate_gelu_exact, activate_gelu_row, ACTIVATION_GELU},
+    {"gelu_tanh", activate_gelu_approximation, activate_gelu_tanh_row, ACTIVATION_GELU_TANH},
+};
+
+#define BENCH_ACTIVATION_COUNT (sizeof(BENCH_ACTIVATIONS) / sizeof(BenchActivation))
+
+static void bench_activation(size_t length) {
+    float* input = malloc(length * sizeof(float));
+    float* output = malloc(length * sizeof(float));
+    uint16_t* input16 = malloc(length * sizeof(uint16_t));
+    uint16_t* input16b = malloc(length * sizeof(uint16_t));
+    uint16_t* output16 = malloc(length * sizeof(uint16_t));
+    size_t iterations = BENCH_ELEMENTS / length;
+
+    // Typical pre-activation range; the kernels cost the same anywhere.
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        input[i] = (lehmer_generate_float() - 0.5f) * 16.0f;
+    }
+    quantize_row_fp16(input, input16, length);
+    quantize_row_bf16(input, input16b, length);
+
+    printf("length=%zu, iterations=%zu\n", length, iterations);
+
+    for (size_t f = 0; f < BENCH_ACTIVATION_COUNT; f++) {
+        const BenchActivation* bench = &BENCH_ACTIVATIONS[f];
+        char label[64];
+
+        double start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            for (size_t j = 0; j < length; j++) {
+                output[j] = bench->scalar(input[j]);
+            }
+            BENCH_KEEP(output[0]);
+        }
+        snprintf(label, sizeof(label), "  %s scalar loop", bench->name);
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+        for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+            cpu_level_set((CpuLevel) level);
+
+            start = bench_now();
+            for (size_t i = 0; i < iterations; i++) {
+                bench->row(input, output, length);
+                BENCH_KEEP(output[0]);
+            }
+            snprintf(label, sizeof(label), "  %s row (%s)", bench->name, cpu_level_name(level));
+            bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+        }
+        cpu_level_set(cpu_level_detected());
+
+        if (bench->function < 0) {
+            continue;
+        }
+
+        // Builds the table outside the timed loop.
+        ActivationFunction function = (ActivationFunction) bench->function;
+        activate_row_fp16(function, input16, output16, 1);
+
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            activate_row_fp16(function, input16, output16, length);
+            BENCH_KEEP(output16[0]);
+        }
+        snprintf(label, sizeof(label), "  %s fp16 table", bench->name);
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+        // Widen into a full fp32 buffer, activate, narrow: the path the fused rows replace.
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            dequantize_row_fp16(input16, output, length);
+            activate_row(function, output, output, length);
+            quantize_row_fp16(output, output16, length);
+            BENCH_KEEP(output16[0]);
+        }
+        snprintf(label, sizeof(label), "  %s fp16 three passes", bench->name);
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            activate_row_fp16_fused(function, input16, output16, length);
+            BENCH_KEEP(output16[0]);
+        }
+        snprintf(label, sizeof(label), "  %s fp16 fused", bench->name);
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+        activate_row_bf16(function, input16b, output16, 1);
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            activate_row_bf16(function, input16b, output16, length);
+            BENCH_KEEP(output16[0]);
+        }
+        snprintf(label, sizeof(label), "  %s bf16 table", bench->name);
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            activate_row_bf16_fused(function, input16b, output16, length);
+            BENCH_KEEP(output16[0]);
+        }
+        snprintf(label, sizeof(label), "  %s bf16 fused", bench->name);
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+    }
+
+    free(input);
+    free(output);
+    free(input16);
+    free(input16b);
+    free(output16);
+}
+
+// The softmax loop before the online kernel: three passes with libm expf.
+static void bench_softmax_three_pass(const float* input, float* output, size_t length) {
+    float max = input[0];
+    for (size_t i = 1; i < length; i++) {
+        max = input[i] > max ? input[i] : max;
+    }
+
+    float sum = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        output[i] = expf(input[i] - max);
+        sum += output[i];
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        output[i] /= sum;
+    }
+}
+
+static void bench_softmax(size_t length) {
+    float* input = malloc(length * sizeof(float));
+    float* output = malloc(length * sizeof(float));
+    size_t iterations = BENCH_ELEMENTS / length;
+    ThreadPool* pool = thread_pool_create(0);
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        input[i] = (lehmer_generate_float() - 0.5f) * 32.0f;
+    }
+
+    printf("softmax length=%zu, iterations=%zu\n", length, iterations);
+
+    double start = bench_now();
+    for (size_t i = 0; i < iterations; i++) {
+        bench_softmax_three_pass(input, output, length);
+        BENCH_KEEP(output[0]);
+    }
+    bench_print("  three-pass loop", bench_now() - start, iterations, (double) length, "elem");
+
+    char label[64];
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+        cpu_level_set((CpuLevel) level);
+
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            activate_softmax(input, output, length);
+            BENCH_KEEP(output[0]);
+        }
+        snprintf(label, sizeof(label), "  activate_softmax (%s)", cpu_level_name(level));
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++) {
+        activate_log_softmax(input, output, length);
+        BENCH_KEEP(output[0]);
+    }
+    bench_print("  activate_log_softmax", bench_now() - start, iterations, (double) length, "elem");
+
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++) {
+        activate_softmax_parallel(pool, input, output, length, 1.0f);
+        BENCH_KEEP(output[0]);
+    }
+    snprintf(label, sizeof(label), "  activate_softmax_parallel (%zu)", thread_pool_size(pool));
+    bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+    thread_pool_free(pool);
+    free(input);
+    free(output);
+}
+
+int main(void) {
+    printf("cpu=%s\n", cpu_level_name(cpu_level_detected()));
+    bench_activation(4096);
+    bench_activation(1 << 22);
+    bench_softmax(1 << 18);
+    bench_softmax(1 << 22);
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file bench/numeric/bench_analysis.c
+ * @brief Accuracy and speed of every float and quantized round trip, per distribution.
+ *
+ * Each synthetic distribution is quantized to every storage type and back; the report lists the
+ * storage cost, the error metrics from numeric/analysis.h and the throughput of the fastest pass
+ * in each direction. Passing a tensor file runs the same report over each of its fp32, fp16 and
+ * bf16 tensors, so the formats can be judged on real weights as well. The comparator and the
+ * error pass are then timed on their own, per CPU level and across the default thread pool.
+ *
+ * Usage: bench_analysis [tensors.bin]
+ */
+
+#include "core/cpu.h"
+#include "core/memory.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/analysis.h"
+#include "numeric/convert.h"
+#include "numeric/tensor_file.h"
+#include "numeric/type.h"
+
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_LENGTH (1u << 20)
+#define BENCH_REPEATS 5
+#define BENCH_ITERATIONS 16
+
+static const DataTypeId BENCH_TYPES[] = {
+    TYPE_FLOAT32,
+    TYPE_FLOAT16,
+    TYPE_BFLOAT16,
+    TYPE_FLOAT8_E4M3,
+    TYPE_FLOAT8_E5M2,
+    TYPE_QUANT8,
+    TYPE_BLOCK_Q8,
+    TYPE_QUANT4,
+    TYPE_BLOCK_Q4,
+};
+
+static void bench_report(ThreadPool* pool, const char* source, const float* x, size_t length) {
+    printf("%s (%zu elements)\n", source, length);
+    printf(
+        "  %-12s %6s %11s %11s %9s %10s %8s %8s\n",
+        "type",
+        "bits",
+        "max_abs",
+        "rmse",
+        "snr_db",
+        "cosine",
+        "ulp_p50",
+        "ulp_p99"
+    );
+
+    char label[64];
+    for (size_t t = 0; t < sizeof(BENCH_TYPES) / sizeof(BENCH_TYPES[0]); t++) {
+        DataTypeId id = BENCH_TYPES[t];
+        AnalysisReport report;
+        if (!analysis_round_trip(pool, x, length, id, BENCH_REPEATS, &report)) {
+            printf("  %-12s failed\n", data_type_name(id));
+            continue;
+        }
+
+        const AnalysisStats* s = &report.stats;
+        printf(
+            "  %-12s %6.2f %11.4e %11.4e %9.2f %10.7f %8u %8u\n",
+            data_type_name(id),
+            report.bits_per_value,
+            s->max_abs,
+            s->rmse,
+            s->snr_db,
+            s->cosine,
+            analysis_ulp_percentile(s, 0.5),
+            analysis_ulp_percentile(s, 0.99)
+        );
+        snprintf(label, sizeof(label), "    quantize %s", data_type_name(id));
+        bench_print(label, report.quantize_seconds, 1, (double) length, "elem");
+        snprintf(label, sizeof(label), "    dequantize %s", data_type_name(id));
+        bench_print(label, report.dequantize_seconds, 1, (double) length, "elem");
+    }
+}
+
+// Reports every fp32, fp16 and bf16 tensor in `path`, widened to fp32 first.
+static void bench_report_file(ThreadPool* pool, const char* path) {
+    TensorFile file;
+    if (TENSOR_FILE_SUCCESS != tensor_file_open(&file, path, TENSOR_FILE_ADVICE_SEQUENTIAL)) {
+        printf("%s: cannot open tensor file\n", path);
+        return;
+    }
+
+    for (size_t i = 0; i < tensor_file_count(&file); i++) {
+        Tensor t;
+        if (!tensor_file_get(&file, i, &t) || !tensor_is_contiguous(&t)
+            || (TYPE_FLOAT32 != t.type && TYPE_FLOAT16 != t.type && TYPE_BFLOAT16 != t.type)) {
+            continue;
+        }
+        size_t length = tensor_count(&t);
+        float* x = memory_alloc(length * sizeof(float), alignof(float));
+        if (x && length > 0 && convert_row(t.data, t.type, x, TYPE_FLOAT32, length)) {
+            bench_report(pool, tensor_file_name(&file, i), x, length);
+        }
+        memory_free(x);
+    }
+    tensor_file_close(&file);
+}
+
+int main(int argc, char** argv) {
+    float* x = malloc(BENCH_LENGTH * sizeof(float));
+    float* y = malloc(BENCH_LENGTH * sizeof(float));
+    if (!x || !y) {
+        return 1;
+    }
+    ThreadPool* pool = thread_pool_create(0);
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 42);
+    for (AnalysisDistribution d = ANALYSIS_UNIFORM; d < ANALYSIS_DISTRIBUTION_COUNT; d++) {
+        analysis_fill(&r, x, BENCH_LENGTH, d, 1.0f);
+        bench_report(pool, analysis_distribution_name(d), x, BENCH_LENGTH);
+    }
+    if (argc > 1) {
+        bench_report_file(pool, argv[1]);
+    }
+
+    // The comparator and the error pass on their own, against a bf16 copy of a normal row.
+    analysis_fill(&r, x, BENCH_LENGTH, ANALYSIS_NORMAL, 1.0f);
+    for (size_t i = 0; i < BENCH_LENGTH; i++) {
+        y[i] = dequantize_scalar_bf16(quantize_scalar_bf16(x[i]));
+    }
+    printf("comparison (%u elements)\n", BENCH_LENGTH);
+
+    double work = (double) BENCH_LENGTH;
+    char label[64];
+    AnalysisStats stats;
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        const char* name = cpu_level_name(level);
+
+        double start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            size_t count = analysis_close_count(x, y, BENCH_LENGTH, 1e-2f, 1e-6f);
+            BENCH_KEEP(count);
+        }
+        snprintf(label, sizeof(label), "  close_count (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            analysis_compare(NULL, x, y, BENCH_LENGTH, &stats);
+            BENCH_KEEP(stats.rmse);
+        }
+        snprintf(label, sizeof(label), "  compare (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        analysis_compare(pool, x, y, BENCH_LENGTH, &stats);
+        BENCH_KEEP(stats.rmse);
+    }
+    snprintf(label, sizeof(label), "  compare parallel (%zu)", thread_pool_size(pool));
+    bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    thread_pool_free(pool);
+    free(x);
+    free(y);
+    return 0;
+}
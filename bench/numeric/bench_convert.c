@@ -0,0 +1,149 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_convert.c
+ * @brief Row conversion throughput per type pair and CPU level.
+ *
+ * The baseline is the per-element path quantize_row() used before the conversion engine:
+ * quantize_scalar() with its type switch for every value. Pairs cover the direct integer
+ * kernels, the int64 path between integers and the fp32 tile path. Throughput is elements
+ * per second.
+ */
+
+#include "core/cpu.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/convert.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_ELEMENTS (1u << 27) // elements per case
+
+typedef struct BenchPair {
+    DataTypeId input;
+    DataTypeId output;
+} BenchPair;
+
+static const BenchPair BENCH_PAIRS[] = {
+    {TYPE_FLOAT32, TYPE_INT8},
+    {TYPE_INT8, TYPE_FLOAT32},
+    {TYPE_FLOAT32, TYPE_UINT16},
+    {TYPE_UINT32, TYPE_FLOAT32},
+    {TYPE_FLOAT32, TYPE_BOOL},
+    {TYPE_INT32, TYPE_INT8},
+    {TYPE_FLOAT16, TYPE_BFLOAT16},
+    {TYPE_BLOCK_Q8, TYPE_FLOAT16},
+    {TYPE_INT16, TYPE_BLOCK_Q4},
+};
+
+#define BENCH_PAIR_COUNT (sizeof(BENCH_PAIRS) / sizeof(BenchPair))
+
+static void bench_convert(size_t length) {
+    float* values = malloc(length * sizeof(float));
+    void* input = malloc(data_type_row_size(TYPE_BLOCK_Q8, length) + length * sizeof(float));
+    void* output = malloc(data_type_row_size(TYPE_BLOCK_Q8, length) + length * sizeof(float));
+    size_t iterations = BENCH_ELEMENTS / length;
+    double work = (double) length;
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        values[i] = (lehmer_generate_float() - 0.5f) * 200.0f;
+    }
+
+    printf("length=%zu, iterations=%zu\n", length, iterations);
+
+    double start = bench_now();
+    for (size_t i = 0; i < iterations; i++) {
+        for (size_t j = 0; j < length; j++) {
+            quantize_scalar(values[j], (uint16_t*) output + j, TYPE_FLOAT16);
+        }
+        BENCH_KEEP(((uint16_t*) output)[0]);
+    }
+    bench_print("  float32 -> float16 per element", bench_now() - start, iterations, work, "elem");
+
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++) {
+        convert_row(values, TYPE_FLOAT32, output, TYPE_FLOAT16, length);
+        BENCH_KEEP(((uint16_t*) output)[0]);
+    }
+    bench_print("  float32 -> float16 convert_row", bench_now() - start, iterations, work, "elem");
+
+    for (size_t p = 0; p < BENCH_PAIR_COUNT; p++) {
+        const BenchPair* pair = &BENCH_PAIRS[p];
+        convert_row(values, TYPE_FLOAT32, input, pair->input, length);
+
+        for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+            cpu_level_set((CpuLevel) level);
+            char label[64];
+
+            start = bench_now();
+            for (size_t i = 0; i < iterations; i++) {
+                convert_row(input, pair->input, output, pair->output, length);
+                BENCH_KEEP(((uint8_t*) output)[0]);
+            }
+            snprintf(
+                label,
+                sizeof(label),
+                "  %s -> %s (%s)",
+                data_type_name(pair->input),
+                data_type_name(pair->output),
+                cpu_level_name(level)
+            );
+            bench_print(label, bench_now() - start, iterations, work, "elem");
+        }
+        cpu_level_set(cpu_level_detected());
+    }
+
+    free(values);
+    free(input);
+    free(output);
+}
+
+// A 4096 x 4096 fp32 matrix to fp16, split into rows and tiles over the pool.
+static void bench_convert_rows(void) {
+    size_t rows = 4096;
+    size_t cols = 4096;
+    float* input = calloc(rows * cols, sizeof(float));
+    uint16_t* output = calloc(rows * cols, sizeof(uint16_t));
+    ThreadPool* pool = thread_pool_create(0);
+    size_t iterations = 8;
+    double work = (double) (rows * cols);
+
+    // Faults the pages in before timing.
+    convert_rows(NULL, input, TYPE_FLOAT32, cols * 4, output, TYPE_FLOAT16, cols * 2, rows, cols);
+
+    double start = bench_now();
+    for (size_t i = 0; i < iterations; i++) {
+        convert_rows(
+            NULL, input, TYPE_FLOAT32, cols * 4, output, TYPE_FLOAT16, cols * 2, rows, cols
+        );
+        BENCH_KEEP(output[0]);
+    }
+    bench_print("  convert_rows serial", bench_now() - start, iterations, work, "elem");
+
+    char label[64];
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++) {
+        convert_rows(
+            pool, input, TYPE_FLOAT32, cols * 4, output, TYPE_FLOAT16, cols * 2, rows, cols
+        );
+        BENCH_KEEP(output[0]);
+    }
+    snprintf(label, sizeof(label), "  convert_rows (%zu threads)", thread_pool_size(pool));
+    bench_print(label, bench_now() - start, iterations, work, "elem");
+
+    thread_pool_free(pool);
+    free(input);
+    free(output);
+}
+
+int main(void) {
+    printf("cpu=%s\n", cpu_level_name(cpu_level_detected()));
+    bench_convert(4096);
+    bench_convert(1 << 22);
+    bench_convert_rows();
+    return 0;
+}
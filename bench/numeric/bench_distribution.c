@@ -0,0 +1,146 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_distribution.c
+ * @brief Sampler throughput against lehmer-based baselines.
+ *
+ * The baselines are what callers wrote with only `lehmer_generate_*`: libm Box-Muller for
+ * normals and `%` for bounded integers. Box-Muller is timed at every CPU level; the other
+ * samplers only dispatch through the generator, so they run once on Philox at the detected level.
+ */
+
+#include "core/cpu.h"
+#include "test/bench.h"
+#include "numeric/activation.h"
+#include "numeric/distribution.h"
+#include "numeric/lehmer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_COUNT (1u << 20)
+#define BENCH_ITERATIONS 8
+#define BENCH_CATEGORIES 32000 // a vocabulary-sized softmax
+
+static void bench_lehmer(float* values, uint32_t* indices) {
+    double work = BENCH_COUNT;
+
+    lehmer_initialize(LEHMER_SEED);
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t i = 0; i + 1 < BENCH_COUNT; i += 2) {
+            float u1 = 1.0f - lehmer_generate_float();
+            float u2 = lehmer_generate_float();
+            float radius = sqrtf(-2.0f * logf(u1));
+            values[i] = radius * cosf(6.2831853f * u2);
+            values[i + 1] = radius * sinf(6.2831853f * u2);
+        }
+        BENCH_KEEP(values[0]);
+    }
+    bench_print("  lehmer box-muller (libm)", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t i = 0; i < BENCH_COUNT; i++) {
+            indices[i] = (uint32_t) lehmer_generate_int32() % 1000;
+        }
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print("  lehmer modulo (biased)", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+}
+
+int main(void) {
+    float* values = malloc(BENCH_COUNT * sizeof(float));
+    uint32_t* indices = malloc(BENCH_COUNT * sizeof(uint32_t));
+    if (NULL == values || NULL == indices) {
+        return 1;
+    }
+
+    double work = BENCH_COUNT;
+    printf("elements=%u\n", BENCH_COUNT);
+    bench_lehmer(values, indices);
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 42);
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        char label[64];
+        snprintf(label, sizeof(label), "  box-muller (%s)", cpu_level_name(level));
+        double start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            random_fill_normal_box_muller(&r, values, BENCH_COUNT, 0.0f, 1.0f);
+            BENCH_KEEP(values[0]);
+        }
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        random_fill_normal(&r, values, BENCH_COUNT, 0.0f, 1.0f);
+        BENCH_KEEP(values[0]);
+    }
+    bench_print("  ziggurat normal", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        random_fill_exponential(&r, values, BENCH_COUNT, 1.0f);
+        BENCH_KEEP(values[0]);
+    }
+    bench_print("  ziggurat exponential", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        random_fill_bounded(&r, indices, BENCH_COUNT, 1000);
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print("  bounded (lemire)", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        random_shuffle(&r, indices, BENCH_COUNT, sizeof(uint32_t));
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print("  shuffle", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    // Categorical over a softmax: alias sampling against a linear CDF scan per draw.
+    float* logits = malloc(BENCH_CATEGORIES * sizeof(float));
+    float* probabilities = malloc(BENCH_CATEGORIES * sizeof(float));
+    random_fill_normal(&r, logits, BENCH_CATEGORIES, 0.0f, 2.0f);
+    activate_softmax(logits, probabilities, BENCH_CATEGORIES);
+
+    RandomAlias table;
+    start = bench_now();
+    random_alias_create(&table, probabilities, BENCH_CATEGORIES);
+    bench_print("  alias build", bench_now() - start, 1, BENCH_CATEGORIES, "elem");
+
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        random_fill_categorical(&r, &table, indices, BENCH_COUNT);
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print("  categorical (alias)", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    size_t scans = 1024;
+    start = bench_now();
+    for (size_t i = 0; i < scans; i++) {
+        float u = random_float(&r);
+        float cdf = 0.0f;
+        size_t j = 0;
+        while (j + 1 < BENCH_CATEGORIES && (cdf += probabilities[j]) <= u) {
+            j++;
+        }
+        indices[i] = (uint32_t) j;
+    }
+    BENCH_KEEP(indices[0]);
+    bench_print("  categorical (cdf scan)", bench_now() - start, 1, (double) scans, "elem");
+
+    random_alias_free(&table);
+    free(logits);
+    free(probabilities);
+    free(values);
+    free(indices);
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_dot.c
+ * @brief Quantized and fp16 dot products against dequantize-then-fp32, per CPU level.
+ *
+ * The baselines widen the rows with the row conversions and run a plain fp32 loop, which is
+ * what callers did before the fused kernels existed. Throughput is elements per second.
+ */
+
+#include "core/cpu.h"
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/dot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_ELEMENTS (1u << 27) // elements per case
+
+#define BENCH_VNNI (CPU_FEATURE_AVX_VNNI | CPU_FEATURE_AVX512_VNNI)
+
+typedef enum BenchDotCase {
+    BENCH_DOT_Q8_BASELINE,
+    BENCH_DOT_Q8,
+    BENCH_DOT_Q4_BASELINE,
+    BENCH_DOT_Q4,
+    BENCH_DOT_FP16_BASELINE,
+    BENCH_DOT_FP16,
+    BENCH_DOT_COUNT,
+} BenchDotCase;
+
+static const char* BENCH_DOT_NAME[BENCH_DOT_COUNT] = {
+    [BENCH_DOT_Q8_BASELINE] = "baseline q8_q8",
+    [BENCH_DOT_Q8] = "dot_block_q8_q8",
+    [BENCH_DOT_Q4_BASELINE] = "baseline q4_q8",
+    [BENCH_DOT_Q4] = "dot_block_q4_q8",
+    [BENCH_DOT_FP16_BASELINE] = "baseline fp16_fp32",
+    [BENCH_DOT_FP16] = "dot_fp16_fp32",
+};
+
+typedef struct BenchDotRows {
+    size_t length;
+    float* y;
+    float* xd;
+    float* yd;
+    BlockQ8* x8;
+    BlockQ4* x4;
+    BlockQ8* y8;
+    uint16_t* x16;
+} BenchDotRows;
+
+static float bench_dot_fp32(const float* x, const float* y, size_t length) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+static float bench_dot_run(BenchDotCase kind, BenchDotRows* r) {
+    switch (kind) {
+        case BENCH_DOT_Q8_BASELINE:
+            dequantize_row_block_q8(r->x8, r->xd, r->length);
+            dequantize_row_block_q8(r->y8, r->yd, r->length);
+            return bench_dot_fp32(r->xd, r->yd, r->length);
+        case BENCH_DOT_Q8:
+            return dot_block_q8_q8(r->x8, r->y8, r->length);
+        case BENCH_DOT_Q4_BASELINE:
+            dequantize_row_block_q4(r->x4, r->xd, r->length);
+            dequantize_row_block_q8(r->y8, r->yd, r->length);
+            return bench_dot_fp32(r->xd, r->yd, r->length);
+        case BENCH_DOT_Q4:
+            return dot_block_q4_q8(r->x4, r->y8, r->length);
+        case BENCH_DOT_FP16_BASELINE:
+            dequantize_row_fp16(r->x16, r->xd, r->length);
+            return bench_dot_fp32(r->xd, r->y, r->length);
+        case BENCH_DOT_FP16:
+        default:
+            return dot_fp16_fp32(r->x16, r->y, r->length);
+    }
+}
+
+static void bench_dot(size_t length) {
+    size_t blocks = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    float* x = malloc(length * sizeof(float));
+    BenchDotRows rows = {
+        .length = length,
+        .y = malloc(length * sizeof(float)),
+        .xd = malloc(length * sizeof(float)),
+        .yd = malloc(length * sizeof(float)),
+        .x8 = malloc(blocks * sizeof(BlockQ8)),
+        .x4 = malloc(blocks * sizeof(BlockQ4)),
+        .y8 = malloc(blocks * sizeof(BlockQ8)),
+        .x16 = malloc(length * sizeof(uint16_t)),
+    };
+    size_t iterations = BENCH_ELEMENTS / length;
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        x[i] = lehmer_generate_float() - 0.5f;
+        rows.y[i] = lehmer_generate_float() - 0.5f;
+    }
+    quantize_row_block_q8(x, rows.x8, length);
+    quantize_row_block_q4(x, rows.x4, length);
+    quantize_row_block_q8(rows.y, rows.y8, length);
+    quantize_row_fp16(x, rows.x16, length);
+
+    printf("length=%zu, iterations=%zu\n", length, iterations);
+
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+        cpu_level_set((CpuLevel) level);
+        cpu_features_mask(0);
+
+        // First pass without VNNI (and with the baselines); a second pass if the level has it.
+        bool vnni = level >= CPU_LEVEL_AVX2
+                    && (cpu_has(CPU_FEATURE_AVX_VNNI) || cpu_has(CPU_FEATURE_AVX512_VNNI));
+        for (int pass = 0; pass < 1 + vnni; pass++) {
+            cpu_features_mask(0 == pass ? BENCH_VNNI : 0);
+
+            for (int kind = 0; kind < BENCH_DOT_COUNT; kind++) {
+                bool baseline = 0 == kind % 2;
+                if (pass > 0 && (baseline || BENCH_DOT_FP16 == kind)) {
+                    continue;
+                }
+
+                double start = bench_now();
+                for (size_t i = 0; i < iterations; i++) {
+                    BENCH_KEEP(bench_dot_run((BenchDotCase) kind, &rows));
+                }
+
+                char label[64];
+                snprintf(
+                    label,
+                    sizeof(label),
+                    "  %s (%s%s)",
+                    BENCH_DOT_NAME[kind],
+                    cpu_level_name(level),
+                    pass > 0 ? "+vnni" : ""
+                );
+                bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+            }
+        }
+    }
+
+    cpu_features_mask(0);
+    cpu_level_set(cpu_level_detected());
+    free(x);
+    free(rows.y);
+    free(rows.xd);
+    free(rows.yd);
+    free(rows.x8);
+    free(rows.x4);
+    free(rows.y8);
+    free(rows.x16);
+}
+
+int main(void) {
+    printf("cpu=%s\n", cpu_level_name(cpu_level_detected()));
+    bench_dot(4096);
+    bench_dot(1 << 22);
+    return 0;
+}
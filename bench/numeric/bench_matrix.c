@@ -0,0 +1,146 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_matrix.c
+ * @brief SGEMM against a naive triple loop, and GEMV per weight type, in FLOP/s.
+ *
+ * GEMM runs single-threaded at every supported CPU level, then (on multi-core machines) on a
+ * pool with one thread per online CPU. GEMV uses a 4096 x 4096 weight matrix, which streams from memory for every type.
+ */
+
+#include "core/cpu.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/matrix.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_FLOP 4e9 // floating-point operations per case
+
+static void bench_fill(float* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        values[i] = lehmer_generate_float() * 2.0f - 1.0f;
+    }
+}
+
+static void bench_naive(size_t n, const float* a, const float* b, float* c) {
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            float sum = 0.0f;
+            for (size_t p = 0; p < n; p++) {
+                sum += a[i * n + p] * b[p * n + j];
+            }
+            c[i * n + j] = sum;
+        }
+    }
+}
+
+static void bench_gemm(ThreadPool* pool, size_t n) {
+    float* a = malloc(n * n * sizeof(float));
+    float* b = malloc(n * n * sizeof(float));
+    float* c = malloc(n * n * sizeof(float));
+    double flop = 2.0 * (double) n * (double) n * (double) n;
+    size_t iterations = (size_t) (BENCH_FLOP / flop) + 1;
+    char label[64];
+
+    lehmer_initialize(LEHMER_SEED);
+    bench_fill(a, n * n);
+    bench_fill(b, n * n);
+
+    printf("gemm n=%zu, iterations=%zu\n", n, iterations);
+
+    // The naive loop gets one iteration: it is slow enough on its own.
+    double start = bench_now();
+    bench_naive(n, a, b, c);
+    BENCH_KEEP(c[0]);
+    bench_print("  naive triple loop", bench_now() - start, 1, flop, "FLOP");
+
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+        cpu_level_set((CpuLevel) level);
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            matrix_gemm_fp32(NULL, n, n, n, a, n, b, n, c, n);
+            BENCH_KEEP(c[0]);
+        }
+        snprintf(label, sizeof(label), "  matrix_gemm_fp32 (%s)", cpu_level_name(level));
+        bench_print(label, bench_now() - start, iterations, flop, "FLOP");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    if (thread_pool_size(pool) > 1) {
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            matrix_gemm_fp32(pool, n, n, n, a, n, b, n, c, n);
+            BENCH_KEEP(c[0]);
+        }
+        snprintf(label, sizeof(label), "  matrix_gemm_fp32 (%zu threads)", thread_pool_size(pool));
+        bench_print(label, bench_now() - start, iterations, flop, "FLOP");
+    }
+
+    free(a);
+    free(b);
+    free(c);
+}
+
+static void bench_gemv(ThreadPool* pool, size_t rows, size_t cols) {
+    float* dense = malloc(rows * cols * sizeof(float));
+    void* w = malloc(rows * data_type_row_size(TYPE_FLOAT32, cols));
+    float* x = malloc(cols * sizeof(float));
+    float* y = malloc(rows * sizeof(float));
+    double flop = 2.0 * (double) rows * (double) cols;
+    size_t iterations = (size_t) (BENCH_FLOP / flop / 8) + 1;
+    char label[64];
+
+    lehmer_initialize(LEHMER_SEED);
+    bench_fill(dense, rows * cols);
+    bench_fill(x, cols);
+
+    printf("gemv rows=%zu, cols=%zu, iterations=%zu\n", rows, cols, iterations);
+
+    DataTypeId types[] = {TYPE_FLOAT32, TYPE_FLOAT16, TYPE_BLOCK_Q8, TYPE_BLOCK_Q4};
+    for (size_t t = 0; t < sizeof(types) / sizeof(DataTypeId); t++) {
+        size_t stride = data_type_row_size(types[t], cols);
+        for (size_t r = 0; r < rows; r++) {
+            quantize_row(dense + r * cols, (uint8_t*) w + r * stride, cols, types[t]);
+        }
+
+        size_t runs = thread_pool_size(pool) > 1 ? 2 : 1;
+        for (size_t threaded = 0; threaded < runs; threaded++) {
+            ThreadPool* p = threaded ? pool : NULL;
+            double start = bench_now();
+            for (size_t i = 0; i < iterations; i++) {
+                matrix_gemv(p, types[t], w, rows, cols, x, y);
+                BENCH_KEEP(y[0]);
+            }
+            snprintf(
+                label,
+                sizeof(label),
+                "  matrix_gemv %s (%zu threads)",
+                data_type_name(types[t]),
+                thread_pool_size(p)
+            );
+            bench_print(label, bench_now() - start, iterations, flop, "FLOP");
+        }
+    }
+
+    free(dense);
+    free(w);
+    free(x);
+    free(y);
+}
+
+int main(void) {
+    ThreadPool* pool = thread_pool_create(0);
+    printf("cpu=%s, threads=%zu\n", cpu_level_name(cpu_level_detected()), thread_pool_size(pool));
+
+    bench_gemm(pool, 256);
+    bench_gemm(pool, 512);
+    bench_gemm(pool, 1024);
+    bench_gemv(pool, 4096, 4096);
+
+    thread_pool_free(pool);
+    return 0;
+}
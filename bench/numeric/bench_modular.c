@@ -0,0 +1,145 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file bench/numeric/bench_modular.c
+ * @brief Modular array kernels against `%`, and NTT convolution against schoolbook.
+ *
+ * The array kernels run at every CPU level. Convolution multiplies two n-term polynomials mod
+ * 998244353 for n = 2^10 through 2^22. Schoolbook is O(n^2) and is only timed up to 2^14; larger
+ * sizes report its time scaled up quadratically from 2^14, marked "est".
+ */
+
+#include "core/cpu.h"
+#include "test/bench.h"
+#include "numeric/distribution.h"
+#include "numeric/modular.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_COUNT (1u << 20)
+#define BENCH_ITERATIONS 16
+#define BENCH_SCHOOLBOOK_LOG 14
+#define BENCH_NTT_LOG 22
+
+static void bench_schoolbook(
+    const uint32_t* a, const uint32_t* b, uint64_t* c, size_t n, uint32_t p
+) {
+    for (size_t k = 0; k + 1 < 2 * n; k++) {
+        c[k] = 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            c[i + j] = (c[i + j] + (uint64_t) a[i] * b[j]) % p;
+        }
+    }
+}
+
+// Read back so `%` below divides by a runtime modulus, as a caller's would, rather than by a
+// constant the compiler can strength-reduce.
+static volatile uint32_t bench_modulus = MODULAR_PRIME_998244353;
+
+static void bench_arrays(Random* r, uint32_t* a, uint32_t* b, uint32_t* c) {
+    uint32_t p = bench_modulus;
+    double work = BENCH_COUNT;
+    random_fill_bounded(r, a, BENCH_COUNT, p);
+    random_fill_bounded(r, b, BENCH_COUNT, p);
+
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t i = 0; i < BENCH_COUNT; i++) {
+            c[i] = (uint32_t) ((uint64_t) a[i] * b[i] % p);
+        }
+        BENCH_KEEP(c[0]);
+    }
+    bench_print("  mul (%)", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    ModularBarrett barrett;
+    ModularMontgomery montgomery;
+    modular_barrett_create(&barrett, p);
+    modular_montgomery_create(&montgomery, p);
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        const char* name = cpu_level_name(level);
+        char label[64];
+
+        snprintf(label, sizeof(label), "  add (%s)", name);
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            modular_add(a, b, c, BENCH_COUNT, p);
+            BENCH_KEEP(c[0]);
+        }
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        snprintf(label, sizeof(label), "  mul barrett (%s)", name);
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            modular_mul_barrett(&barrett, a, b, c, BENCH_COUNT);
+            BENCH_KEEP(c[0]);
+        }
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        snprintf(label, sizeof(label), "  mul montgomery (%s)", name);
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            modular_mul_montgomery(&montgomery, a, b, c, BENCH_COUNT);
+            BENCH_KEEP(c[0]);
+        }
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+    }
+    cpu_level_set(cpu_level_detected());
+}
+
+int main(void) {
+    size_t largest = (size_t) 1 << BENCH_NTT_LOG;
+    uint32_t* a = malloc(largest * sizeof(uint32_t));
+    uint32_t* b = malloc(largest * sizeof(uint32_t));
+    uint32_t* c = malloc(2 * largest * sizeof(uint32_t));
+    uint64_t* wide = malloc(2 * ((size_t) 1 << BENCH_SCHOOLBOOK_LOG) * sizeof(uint64_t));
+    if (!a || !b || !c || !wide) {
+        return 1;
+    }
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 42);
+    printf("elements=%u\n", BENCH_COUNT);
+    bench_arrays(&r, a, b, c);
+
+    uint32_t p = bench_modulus;
+    double schoolbook = 0.0;
+    for (int log = 10; log <= BENCH_NTT_LOG; log += 2) {
+        size_t n = (size_t) 1 << log;
+        random_fill_bounded(&r, a, n, p);
+        random_fill_bounded(&r, b, n, p);
+        char label[64];
+
+        if (log <= BENCH_SCHOOLBOOK_LOG) {
+            double start = bench_now();
+            bench_schoolbook(a, b, wide, n, p);
+            BENCH_KEEP(wide[n]);
+            schoolbook = bench_now() - start;
+            snprintf(label, sizeof(label), "  schoolbook 2^%d", log);
+            bench_print(label, schoolbook, 1, (double) n, "coef");
+        } else {
+            double scaled = schoolbook * (double) ((size_t) 1 << 2 * (log - BENCH_SCHOOLBOOK_LOG));
+            snprintf(label, sizeof(label), "  schoolbook 2^%d (est)", log);
+            bench_print(label, scaled, 1, (double) n, "coef");
+        }
+
+        size_t iterations = log <= 16 ? 16 : 2;
+        double start = bench_now();
+        for (size_t it = 0; it < iterations; it++) {
+            modular_convolve(a, n, b, n, c, p);
+            BENCH_KEEP(c[n]);
+        }
+        snprintf(label, sizeof(label), "  ntt convolve 2^%d", log);
+        bench_print(label, bench_now() - start, iterations, (double) n, "coef");
+    }
+
+    free(a);
+    free(b);
+    free(c);
+    free(wide);
+    return 0;
+}
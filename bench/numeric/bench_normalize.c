@@ -0,0 +1,169 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file bench/numeric/bench_normalize.c
+ * @brief RMSNorm and LayerNorm rows at every CPU level, against a multi-pass baseline.
+ *
+ * The baseline is the ad hoc LayerNorm the fused kernels replace: a pass for the mean, one for
+ * the variance, one to normalize and one for the weight and bias. Batches are timed serially and
+ * across the default thread pool.
+ */
+
+#include "core/cpu.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/distribution.h"
+#include "numeric/normalize.h"
+#include "numeric/type.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_ROWS 256
+#define BENCH_LENGTH 4096
+#define BENCH_ITERATIONS 16
+#define BENCH_EPSILON 1e-5f
+
+static void bench_layer_multipass(
+    const float* x, float* y, const float* weight, const float* bias, size_t length
+) {
+    float mean = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        mean += x[i];
+    }
+    mean /= (float) length;
+    float variance = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        variance += (x[i] - mean) * (x[i] - mean);
+    }
+    float scale = 1.0f / sqrtf(variance / (float) length + BENCH_EPSILON);
+    for (size_t i = 0; i < length; i++) {
+        y[i] = (x[i] - mean) * scale;
+    }
+    for (size_t i = 0; i < length; i++) {
+        y[i] = y[i] * weight[i] + bias[i];
+    }
+}
+
+int main(void) {
+    const size_t count = (size_t) BENCH_ROWS * BENCH_LENGTH;
+    float* x = malloc(count * sizeof(float));
+    float* y = malloc(count * sizeof(float));
+    float* weight = malloc(BENCH_LENGTH * sizeof(float));
+    float* bias = malloc(BENCH_LENGTH * sizeof(float));
+    uint16_t* fp16 = malloc(count * sizeof(uint16_t));
+    uint16_t* bf16 = malloc(count * sizeof(uint16_t));
+    uint16_t* half = malloc(count * sizeof(uint16_t));
+    if (!x || !y || !weight || !bias || !fp16 || !bf16 || !half) {
+        return 1;
+    }
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 42);
+    random_fill_normal(&r, x, count, 0.0f, 2.0f);
+    random_fill_uniform(&r, weight, BENCH_LENGTH, 0.5f, 1.5f);
+    random_fill_uniform(&r, bias, BENCH_LENGTH, -1.0f, 1.0f);
+    quantize_row_fp16(x, fp16, count);
+    quantize_row_bf16(x, bf16, count);
+    printf("rows=%u length=%u\n", BENCH_ROWS, BENCH_LENGTH);
+
+    double work = (double) count;
+    char label[64];
+
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        for (size_t row = 0; row < BENCH_ROWS; row++) {
+            size_t offset = row * BENCH_LENGTH;
+            bench_layer_multipass(x + offset, y + offset, weight, bias, BENCH_LENGTH);
+        }
+        BENCH_KEEP(y[0]);
+    }
+    bench_print("  layer multi-pass", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        const char* name = cpu_level_name(level);
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            normalize_layer_rows(
+                NULL, TYPE_FLOAT32, x, y, weight, bias, BENCH_ROWS, BENCH_LENGTH, BENCH_EPSILON
+            );
+            BENCH_KEEP(y[0]);
+        }
+        snprintf(label, sizeof(label), "  layer fp32 (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            normalize_rms_rows(
+                NULL, TYPE_FLOAT32, x, y, weight, BENCH_ROWS, BENCH_LENGTH, BENCH_EPSILON
+            );
+            BENCH_KEEP(y[0]);
+        }
+        snprintf(label, sizeof(label), "  rms fp32 (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            normalize_layer_rows(
+                NULL,
+                TYPE_FLOAT16,
+                fp16,
+                half,
+                weight,
+                bias,
+                BENCH_ROWS,
+                BENCH_LENGTH,
+                BENCH_EPSILON
+            );
+            BENCH_KEEP(half[0]);
+        }
+        snprintf(label, sizeof(label), "  layer fp16 (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            normalize_rms_rows(
+                NULL, TYPE_BFLOAT16, bf16, half, weight, BENCH_ROWS, BENCH_LENGTH, BENCH_EPSILON
+            );
+            BENCH_KEEP(half[0]);
+        }
+        snprintf(label, sizeof(label), "  rms bf16 (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    ThreadPool* pool = thread_pool_create(0);
+    size_t threads = thread_pool_size(pool);
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        normalize_layer_rows(
+            pool, TYPE_FLOAT32, x, y, weight, bias, BENCH_ROWS, BENCH_LENGTH, BENCH_EPSILON
+        );
+        BENCH_KEEP(y[0]);
+    }
+    snprintf(label, sizeof(label), "  layer fp32 parallel (%zu)", threads);
+    bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        normalize_rms_rows(
+            pool, TYPE_BFLOAT16, bf16, half, weight, BENCH_ROWS, BENCH_LENGTH, BENCH_EPSILON
+        );
+        BENCH_KEEP(half[0]);
+    }
+    snprintf(label, sizeof(label), "  rms bf16 parallel (%zu)", threads);
+    bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+    thread_pool_free(pool);
+
+    free(x);
+    free(y);
+    free(weight);
+    free(bias);
+    free(fp16);
+    free(bf16);
+    free(half);
+    return 0;
+}
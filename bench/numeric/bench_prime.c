@@ -0,0 +1,148 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file bench/numeric/bench_prime.c
+ * @brief Segmented sieve against trial division.
+ *
+ * Trial division is what `prime_sample_create` used to do and only runs to 10^7. The sieve is
+ * timed with and without the wheel pre-sieve, on the caller and on a pool of every CPU, and
+ * finally counts the primes below 10^10 (455052511).
+ *
+ * Miller-Rabin is timed per candidate on odd numbers just below 2^32 and 2^62, one call at a time
+ * and through the batch API at every CPU level, with trial division as the 32-bit baseline.
+ */
+
+#include "core/cpu.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/prime.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_TRIAL 10000000ull
+#define BENCH_SIEVE 1000000000ull
+#define BENCH_LARGE 10000000000ull
+#define BENCH_CANDIDATES (1u << 16)
+
+static uint64_t bench_trial(uint64_t high) {
+    uint64_t count = high > 2;
+    for (uint64_t n = 3; n < high; n += 2) {
+        bool prime = true;
+        for (uint64_t d = 3; d * d <= n; d += 2) {
+            if (n % d == 0) {
+                prime = false;
+                break;
+            }
+        }
+        count += prime;
+    }
+    return count;
+}
+
+static bool bench_trial_one(uint64_t n) {
+    for (uint64_t d = 3; d * d <= n; d += 2) {
+        if (n % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bench_miller_rabin(uint64_t top, bool trial) {
+    uint64_t* n = malloc(BENCH_CANDIDATES * sizeof(uint64_t));
+    bool* prime = malloc(BENCH_CANDIDATES * sizeof(bool));
+    if (NULL == n || NULL == prime) {
+        return;
+    }
+    for (size_t i = 0; i < BENCH_CANDIDATES; i++) {
+        n[i] = top - 2 * i;
+    }
+
+    char label[64];
+    double work = BENCH_CANDIDATES;
+    double start;
+    if (trial) {
+        start = bench_now();
+        for (size_t i = 0; i < BENCH_CANDIDATES; i++) {
+            prime[i] = bench_trial_one(n[i]);
+        }
+        BENCH_KEEP(prime[0]);
+        snprintf(label, sizeof(label), "  trial division 2^%d", 64 - __builtin_clzll(top));
+        bench_print(label, bench_now() - start, 1, work, "n");
+    }
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_CANDIDATES; i++) {
+        prime[i] = prime_miller_rabin(n[i]);
+    }
+    BENCH_KEEP(prime[0]);
+    snprintf(label, sizeof(label), "  miller-rabin 2^%d", 64 - __builtin_clzll(top));
+    bench_print(label, bench_now() - start, 1, work, "n");
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        snprintf(
+            label,
+            sizeof(label),
+            "  miller-rabin batch 2^%d (%s)",
+            64 - __builtin_clzll(top),
+            cpu_level_name(level)
+        );
+        start = bench_now();
+        prime_miller_rabin_batch(n, prime, BENCH_CANDIDATES);
+        BENCH_KEEP(prime[0]);
+        bench_print(label, bench_now() - start, 1, work, "n");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(n);
+    free(prime);
+}
+
+static void bench_count(
+    const char* label, uint64_t high, ThreadPool* pool, const PrimeSieveOptions* options
+) {
+    uint64_t count = 0;
+    double start = bench_now();
+    prime_count(0, high, pool, options, &count);
+    double elapsed = bench_now() - start;
+    BENCH_KEEP(count);
+    bench_print(label, elapsed, 1, (double) high, "int");
+}
+
+int main(void) {
+    ThreadPool* pool = thread_pool_create(0);
+    printf("threads=%zu\n", thread_pool_size(pool));
+
+    bench_miller_rabin(UINT32_MAX, true);
+    bench_miller_rabin(((uint64_t) 1 << 62) - 1, false);
+
+    double start = bench_now();
+    uint64_t count = bench_trial(BENCH_TRIAL);
+    BENCH_KEEP(count);
+    bench_print("  trial division 1e7", bench_now() - start, 1, (double) BENCH_TRIAL, "int");
+
+    PrimeSieveOptions plain = {0, false};
+    bench_count("  sieve 1e7", BENCH_TRIAL, NULL, NULL);
+    bench_count("  sieve 1e9 (no wheel)", BENCH_SIEVE, NULL, &plain);
+    bench_count("  sieve 1e9", BENCH_SIEVE, NULL, NULL);
+
+    start = bench_now();
+    PrimeSieve sieve;
+    uint64_t prime = 0;
+    uint64_t sum = 0;
+    prime_sieve_create(&sieve, 0, BENCH_SIEVE, NULL);
+    while (prime_sieve_next(&sieve, &prime)) {
+        sum += prime;
+    }
+    prime_sieve_free(&sieve);
+    BENCH_KEEP(sum);
+    bench_print("  sieve 1e9 (iterate)", bench_now() - start, 1, (double) BENCH_SIEVE, "int");
+
+    bench_count("  sieve 1e9 (pool)", BENCH_SIEVE, pool, NULL);
+    bench_count("  sieve 1e10 (pool)", BENCH_LARGE, pool, NULL);
+    thread_pool_free(pool);
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_random.c
+ * @brief Generator throughput: lehmer against the explicit-state generators.
+ *
+ * Every case fills the same buffer so the figures are bytes of output per second. Lehmer and the
+ * single-draw cases call once per value; the fills run each generator over the whole buffer, and
+ * Philox is timed at every CPU level since only its fill is vectorized.
+ */
+
+#include "core/cpu.h"
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "numeric/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_COUNT (1u << 20) // 64-bit values per pass, 8 MiB
+#define BENCH_ITERATIONS 16
+
+static const char* const BENCH_KIND_NAMES[RANDOM_KIND_COUNT] = {
+    [RANDOM_XOSHIRO256] = "xoshiro256**",
+    [RANDOM_PCG64] = "pcg64",
+    [RANDOM_PHILOX] = "philox4x32",
+};
+
+static void bench_lehmer(uint64_t* buffer) {
+    size_t iterations = BENCH_ITERATIONS;
+    double bytes = (double) BENCH_COUNT * sizeof(uint64_t);
+
+    uint32_t* words = (uint32_t*) buffer;
+    lehmer_initialize(LEHMER_SEED);
+    double start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < 2 * BENCH_COUNT; i++) {
+            words[i] = (uint32_t) lehmer_generate_int32();
+        }
+        BENCH_KEEP(words[0]);
+    }
+    bench_print("  lehmer int32", bench_now() - start, iterations, bytes, "B");
+
+    double* values = (double*) buffer;
+    start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < BENCH_COUNT; i++) {
+            values[i] = lehmer_generate_double();
+        }
+        BENCH_KEEP(values[0]);
+    }
+    bench_print("  lehmer double", bench_now() - start, iterations, bytes, "B");
+}
+
+static void bench_kind(RandomKind kind, uint64_t* buffer) {
+    size_t iterations = BENCH_ITERATIONS;
+    double bytes = (double) BENCH_COUNT * sizeof(uint64_t);
+    char label[64];
+
+    Random r;
+    random_seed(&r, kind, 42);
+    double start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < BENCH_COUNT; i++) {
+            buffer[i] = random_u64(&r);
+        }
+        BENCH_KEEP(buffer[0]);
+    }
+    snprintf(label, sizeof(label), "  %s u64 single", BENCH_KIND_NAMES[kind]);
+    bench_print(label, bench_now() - start, iterations, bytes, "B");
+
+    start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        random_fill_u64(&r, buffer, BENCH_COUNT);
+        BENCH_KEEP(buffer[0]);
+    }
+    snprintf(label, sizeof(label), "  %s u64 fill", BENCH_KIND_NAMES[kind]);
+    bench_print(label, bench_now() - start, iterations, bytes, "B");
+
+    start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        random_fill_u32(&r, (uint32_t*) buffer, 2 * BENCH_COUNT);
+        BENCH_KEEP(buffer[0]);
+    }
+    snprintf(label, sizeof(label), "  %s u32 fill", BENCH_KIND_NAMES[kind]);
+    bench_print(label, bench_now() - start, iterations, bytes, "B");
+
+    start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        random_fill_double(&r, (double*) buffer, BENCH_COUNT);
+        BENCH_KEEP(buffer[0]);
+    }
+    snprintf(label, sizeof(label), "  %s double fill", BENCH_KIND_NAMES[kind]);
+    bench_print(label, bench_now() - start, iterations, bytes, "B");
+}
+
+int main(void) {
+    uint64_t* buffer = malloc(BENCH_COUNT * sizeof(uint64_t));
+    if (NULL == buffer) {
+        return 1;
+    }
+
+    printf("values=%u, bytes=%zu\n", BENCH_COUNT, BENCH_COUNT * sizeof(uint64_t));
+    bench_lehmer(buffer);
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        printf("level=%s\n", cpu_level_name(level));
+        for (RandomKind kind = 0; kind < RANDOM_KIND_COUNT; kind++) {
+            // Only Philox dispatches; the others would repeat the same numbers.
+            if (RANDOM_PHILOX == kind || CPU_LEVEL_SCALAR == level) {
+                bench_kind(kind, buffer);
+            }
+        }
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file bench/numeric/bench_reduce.c
+ * @brief Reductions and prefix scans at every CPU level and summation mode.
+ *
+ * Each sum also reports its relative error against a double-precision sum of the same row, so
+ * the cost of pairwise and Kahan accumulation can be read next to what they buy. The row holds
+ * positive values, where a naive fp32 sum drifts furthest.
+ */
+
+#include "core/cpu.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/distribution.h"
+#include "numeric/reduce.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_COUNT (1u << 22)
+#define BENCH_ITERATIONS 16
+
+static const ReduceMode BENCH_MODES[] = {REDUCE_NAIVE, REDUCE_PAIRWISE, REDUCE_KAHAN};
+static const char* BENCH_MODE_NAMES[] = {"naive", "pairwise", "kahan"};
+
+int main(void) {
+    float* x = malloc(BENCH_COUNT * sizeof(float));
+    float* y = malloc(BENCH_COUNT * sizeof(float));
+    float* output = malloc(BENCH_COUNT * sizeof(float));
+    if (!x || !y || !output) {
+        return 1;
+    }
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 42);
+    random_fill_uniform(&r, x, BENCH_COUNT, 0.0f, 1.0f);
+    random_fill_uniform(&r, y, BENCH_COUNT, -1.0f, 1.0f);
+
+    double exact = 0.0;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        exact += (double) x[i];
+    }
+    printf("elements=%u\n", BENCH_COUNT);
+
+    double work = BENCH_COUNT;
+    char label[64];
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        const char* name = cpu_level_name(level);
+
+        for (size_t m = 0; m < sizeof(BENCH_MODES) / sizeof(ReduceMode); m++) {
+            float sum = 0.0f;
+            double start = bench_now();
+            for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+                sum = reduce_sum(x, BENCH_COUNT, BENCH_MODES[m]);
+                BENCH_KEEP(sum);
+            }
+            snprintf(label, sizeof(label), "  sum %s (%s)", BENCH_MODE_NAMES[m], name);
+            bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+            printf("    relative error %.3e\n", fabs((double) sum - exact) / exact);
+        }
+
+        double start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            float dot = reduce_dot(x, y, BENCH_COUNT, REDUCE_NAIVE);
+            BENCH_KEEP(dot);
+        }
+        snprintf(label, sizeof(label), "  dot naive (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            float mean, variance;
+            reduce_moments(x, BENCH_COUNT, REDUCE_PAIRWISE, &mean, &variance);
+            BENCH_KEEP(variance);
+        }
+        snprintf(label, sizeof(label), "  moments pairwise (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            size_t index = reduce_argmax(x, BENCH_COUNT);
+            BENCH_KEEP(index);
+        }
+        snprintf(label, sizeof(label), "  argmax (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            reduce_scan_inclusive(x, output, BENCH_COUNT, REDUCE_NAIVE);
+            BENCH_KEEP(output[0]);
+        }
+        snprintf(label, sizeof(label), "  scan naive (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            reduce_scan_inclusive(x, output, BENCH_COUNT, REDUCE_KAHAN);
+            BENCH_KEEP(output[0]);
+        }
+        snprintf(label, sizeof(label), "  scan kahan (%s)", name);
+        bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    ThreadPool* pool = thread_pool_create(0);
+    size_t threads = thread_pool_size(pool);
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        float sum = reduce_sum_parallel(pool, x, BENCH_COUNT, REDUCE_KAHAN);
+        BENCH_KEEP(sum);
+    }
+    snprintf(label, sizeof(label), "  sum kahan parallel (%zu)", threads);
+    bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+    start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        reduce_scan_inclusive_parallel(pool, x, output, BENCH_COUNT, REDUCE_KAHAN);
+        BENCH_KEEP(output[0]);
+    }
+    snprintf(label, sizeof(label), "  scan kahan parallel (%zu)", threads);
+    bench_print(label, bench_now() - start, BENCH_ITERATIONS, work, "elem");
+    thread_pool_free(pool);
+
+    free(x);
+    free(y);
+    free(output);
+    return 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file bench/numeric/bench_sparse.c
+ * @brief Sparse products against their dense counterparts, per sparsity and CPU level.
+ *
+ * A square weight matrix is pruned to each density and multiplied with a vector (SpMV against
+ * matrix_gemv) and with a thin activation matrix (SpMM against matrix_gemm_fp32). CSR is timed
+ * at every CPU level; the other formats and value types at the detected level, serially and
+ * across the default thread pool. Throughput counts stored values, zeros of a BSR block included.
+ */
+
+#include "core/cpu.h"
+#include "core/thread.h"
+#include "test/bench.h"
+#include "numeric/matrix.h"
+#include "numeric/random.h"
+#include "numeric/sparse.h"
+#include "numeric/type.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SIZE 4096
+#define BENCH_BATCH 32 // columns of the SpMM operand
+#define BENCH_ITERATIONS 16
+#define BENCH_SPMM_ITERATIONS 4
+
+static const float BENCH_DENSITIES[] = {0.1f, 0.05f, 0.01f};
+
+typedef struct BenchSparseCase {
+    const char* name;
+    SparseFormat format;
+    DataTypeId type;
+    size_t block_rows;
+    size_t block_cols;
+} BenchSparseCase;
+
+static const BenchSparseCase BENCH_CASES[] = {
+    {"csr fp32", SPARSE_CSR, TYPE_FLOAT32, 1, 1},
+    {"csr fp16", SPARSE_CSR, TYPE_FLOAT16, 1, 1},
+    {"csr e4m3", SPARSE_CSR, TYPE_FLOAT8_E4M3, 1, 1},
+    {"csc fp32", SPARSE_CSC, TYPE_FLOAT32, 1, 1},
+    {"bsr 4x4 fp32", SPARSE_BSR, TYPE_FLOAT32, 4, 4},
+    {"bsr 1x32 q8", SPARSE_BSR, TYPE_BLOCK_Q8, 1, 32},
+};
+
+static bool bench_build(SparseMatrix* m, const BenchSparseCase* c, const float* dense) {
+    switch (c->format) {
+        case SPARSE_CSR:
+            return sparse_csr_from_dense(m, c->type, dense, BENCH_SIZE, BENCH_SIZE, BENCH_SIZE, 0);
+        case SPARSE_CSC:
+            return sparse_csc_from_dense(m, c->type, dense, BENCH_SIZE, BENCH_SIZE, BENCH_SIZE, 0);
+        case SPARSE_BSR:
+            return sparse_bsr_from_dense(
+                m,
+                c->type,
+                dense,
+                BENCH_SIZE,
+                BENCH_SIZE,
+                BENCH_SIZE,
+                0,
+                c->block_rows,
+                c->block_cols
+            );
+    }
+    return false;
+}
+
+static double bench_stored(const SparseMatrix* m) {
+    return (double) (m->count * m->block_rows * m->block_cols);
+}
+
+static void bench_spmv(
+    ThreadPool* pool, const SparseMatrix* m, const char* label, const float* x, float* y
+) {
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+        sparse_spmv(pool, m, x, y);
+        BENCH_KEEP(y[0]);
+    }
+    bench_print(label, bench_now() - start, BENCH_ITERATIONS, bench_stored(m), "nnz");
+}
+
+static void bench_spmm(
+    ThreadPool* pool, const SparseMatrix* m, const char* label, const float* b, float* c
+) {
+    double start = bench_now();
+    for (size_t it = 0; it < BENCH_SPMM_ITERATIONS; it++) {
+        sparse_spmm(pool, m, b, BENCH_BATCH, c, BENCH_BATCH, BENCH_BATCH);
+        BENCH_KEEP(c[0]);
+    }
+    double flops = 2.0 * bench_stored(m) * BENCH_BATCH;
+    bench_print(label, bench_now() - start, BENCH_SPMM_ITERATIONS, flops, "FLOP");
+}
+
+int main(void) {
+    const size_t count = (size_t) BENCH_SIZE * BENCH_SIZE;
+    float* dense = malloc(count * sizeof(float));
+    float* x = malloc(BENCH_SIZE * sizeof(float));
+    float* y = malloc(BENCH_SIZE * sizeof(float));
+    float* b = malloc(BENCH_SIZE * BENCH_BATCH * sizeof(float));
+    float* c = malloc(BENCH_SIZE * BENCH_BATCH * sizeof(float));
+    ThreadPool* pool = thread_pool_create(0);
+    if (!dense || !x || !y || !b || !c) {
+        return 1;
+    }
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 42);
+    random_fill_float(&r, x, BENCH_SIZE);
+    random_fill_float(&r, b, BENCH_SIZE * BENCH_BATCH);
+    printf(
+        "size=%ux%u batch=%u threads=%zu\n",
+        BENCH_SIZE,
+        BENCH_SIZE,
+        BENCH_BATCH,
+        thread_pool_size(pool)
+    );
+
+    char label[64];
+    for (size_t d = 0; d < sizeof(BENCH_DENSITIES) / sizeof(BENCH_DENSITIES[0]); d++) {
+        float density = BENCH_DENSITIES[d];
+        for (size_t i = 0; i < count; i++) {
+            dense[i] = random_float(&r) < density ? random_float(&r) - 0.5f : 0.0f;
+        }
+        printf("density=%.2f\n", (double) density);
+
+        // The dense baselines touch every element, so they count all of them.
+        double start = bench_now();
+        for (size_t it = 0; it < BENCH_ITERATIONS; it++) {
+            matrix_gemv(NULL, TYPE_FLOAT32, dense, BENCH_SIZE, BENCH_SIZE, x, y);
+            BENCH_KEEP(y[0]);
+        }
+        double work = (double) count;
+        bench_print("  dense gemv fp32", bench_now() - start, BENCH_ITERATIONS, work, "elem");
+
+        start = bench_now();
+        for (size_t it = 0; it < BENCH_SPMM_ITERATIONS; it++) {
+            matrix_gemm_fp32(
+                NULL,
+                BENCH_SIZE,
+                BENCH_BATCH,
+                BENCH_SIZE,
+                dense,
+                BENCH_SIZE,
+                b,
+                BENCH_BATCH,
+                c,
+                BENCH_BATCH
+            );
+            BENCH_KEEP(c[0]);
+        }
+        double flops = 2.0 * work * BENCH_BATCH;
+        bench_print("  dense gemm fp32", bench_now() - start, BENCH_SPMM_ITERATIONS, flops, "FLOP");
+
+        for (size_t k = 0; k < sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]); k++) {
+            const BenchSparseCase* bc = &BENCH_CASES[k];
+            SparseMatrix m;
+            if (!bench_build(&m, bc, dense)) {
+                printf("  %s: build failed\n", bc->name);
+                continue;
+            }
+
+            if (0 == k) {
+                for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+                    cpu_level_set(level);
+                    const char* name = cpu_level_name(level);
+                    snprintf(label, sizeof(label), "  spmv %s (%s)", bc->name, name);
+                    bench_spmv(NULL, &m, label, x, y);
+                }
+                cpu_level_set(cpu_level_detected());
+            } else {
+                snprintf(label, sizeof(label), "  spmv %s", bc->name);
+                bench_spmv(NULL, &m, label, x, y);
+            }
+            snprintf(label, sizeof(label), "  spmv %s parallel", bc->name);
+            bench_spmv(pool, &m, label, x, y);
+
+            snprintf(label, sizeof(label), "  spmm %s", bc->name);
+            bench_spmm(NULL, &m, label, b, c);
+            snprintf(label, sizeof(label), "  spmm %s parallel", bc->name);
+            bench_spmm(pool, &m, label, b, c);
+            sparse_free(&m);
+        }
+    }
+
+    thread_pool_free(pool);
+    free(dense);
+    free(x);
+    free(y);
+    free(b);
+    free(c);
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_tensor_file.c
+ * @brief Load time of a tensor file: read() into buffers against mapping it.
+ *
+ * The file holds BENCH_TENSORS fp32 tensors. The baseline reads every tensor into its own
+ * malloc'd buffer, as loaders did before tensor files. The mapped path opens the file and looks
+ * up every tensor, then, separately, touches one value per page to show what the first pass
+ * over the weights pays instead. Both run against a warm page cache, so the gap is copying and
+ * allocation, not disk.
+ */
+
+#include "test/bench.h"
+#include "numeric/tensor.h"
+#include "numeric/tensor_file.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BENCH_PATH "bench_tensor_file.bin"
+#define BENCH_TENSORS 64
+#define BENCH_ROWS 1024
+#define BENCH_COLS 1024 // 4 MiB per tensor
+
+int main(void) {
+    size_t shape[2] = {BENCH_ROWS, BENCH_COLS};
+    size_t bytes = BENCH_ROWS * BENCH_COLS * sizeof(float);
+    double work = (double) BENCH_TENSORS * (double) bytes;
+
+    Tensor source;
+    tensor_create(&source, TYPE_FLOAT32, 2, shape, NULL);
+    TensorFileItem items[BENCH_TENSORS];
+    char names[BENCH_TENSORS][16];
+    for (size_t i = 0; i < BENCH_TENSORS; i++) {
+        snprintf(names[i], sizeof(names[i]), "layer.%zu", i);
+        items[i] = (TensorFileItem) {names[i], &source};
+    }
+    if (TENSOR_FILE_SUCCESS != tensor_file_write(BENCH_PATH, items, BENCH_TENSORS)) {
+        return 1;
+    }
+    tensor_free(&source);
+
+    printf("tensors=%d, bytes=%zu\n", BENCH_TENSORS, BENCH_TENSORS * bytes);
+
+    // Warms the page cache.
+    TensorFile file;
+    tensor_file_open(&file, BENCH_PATH, TENSOR_FILE_ADVICE_WILLNEED);
+    tensor_file_close(&file);
+
+    size_t iterations = 4;
+    double start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        int fd = open(BENCH_PATH, O_RDONLY);
+        tensor_file_open(&file, BENCH_PATH, TENSOR_FILE_ADVICE_NORMAL);
+        float* buffers[BENCH_TENSORS];
+        for (size_t i = 0; i < BENCH_TENSORS; i++) {
+            Tensor t;
+            tensor_file_get(&file, i, &t);
+            buffers[i] = malloc(bytes);
+            off_t offset = (off_t) ((const uint8_t*) t.data - file.map);
+            BENCH_KEEP(pread(fd, buffers[i], bytes, offset));
+        }
+        tensor_file_close(&file);
+        close(fd);
+        for (size_t i = 0; i < BENCH_TENSORS; i++) {
+            BENCH_KEEP(buffers[i][0]);
+            free(buffers[i]);
+        }
+    }
+    bench_print("  read into buffers", bench_now() - start, iterations, work, "B");
+
+    start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        tensor_file_open(&file, BENCH_PATH, TENSOR_FILE_ADVICE_NORMAL);
+        for (size_t i = 0; i < BENCH_TENSORS; i++) {
+            Tensor t;
+            tensor_file_find(&file, names[i], &t);
+            BENCH_KEEP(t.data);
+        }
+        tensor_file_close(&file);
+    }
+    bench_print("  map and look up", bench_now() - start, iterations, work, "B");
+
+    start = bench_now();
+    for (size_t it = 0; it < iterations; it++) {
+        tensor_file_open(&file, BENCH_PATH, TENSOR_FILE_ADVICE_NORMAL);
+        float sum = 0.0f;
+        for (size_t i = 0; i < BENCH_TENSORS; i++) {
+            Tensor t;
+            tensor_file_get(&file, i, &t);
+            for (size_t j = 0; j < bytes / sizeof(float); j += 1024) {
+                sum += ((const float*) t.data)[j];
+            }
+        }
+        BENCH_KEEP(sum);
+        tensor_file_close(&file);
+    }
+    bench_print("  map and touch every page", bench_now() - start, iterations, work, "B");
+
+    remove(BENCH_PATH);
+    return 0;
+}
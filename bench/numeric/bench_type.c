@@ -0,0 +1,245 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/numeric/bench_type.c
+ * @brief fp16/bf16, FP8 and Q8/Q4 block row throughput at every supported CPU level.
+ *
+ * fp16/bf16 throughput counts bytes read plus bytes written (6 per element); FP8 and block
+ * formats report elements per second together with their round-trip error. FP8 rows are scaled
+ * to their format's range, and the fp16 to E4M3 case runs through convert_row(). The short row
+ * stays in L1; the long row streams from memory.
+ */
+
+#include "core/cpu.h"
+#include "test/bench.h"
+#include "numeric/convert.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_BYTES (1u << 28) // bytes converted per case
+
+static void bench_rows(size_t length) {
+    float* values = malloc(length * sizeof(float));
+    uint16_t* halves = malloc(length * sizeof(uint16_t));
+    size_t iterations = BENCH_BYTES / (length * 6);
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        values[i] = (lehmer_generate_float() - 0.5f) * 1000.0f;
+    }
+    quantize_row_fp16(values, halves, length);
+
+    double work = (double) length * 6;
+    printf("length=%zu, iterations=%zu\n", length, iterations);
+
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+        cpu_level_set((CpuLevel) level);
+        char label[64];
+
+        double start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            quantize_row_fp16(values, halves, length);
+            BENCH_KEEP(halves[0]);
+        }
+        snprintf(label, sizeof(label), "  quantize_row_fp16 (%s)", cpu_level_name(level));
+        bench_print(label, bench_now() - start, iterations, work, "B");
+
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            dequantize_row_fp16(halves, values, length);
+            BENCH_KEEP(values[0]);
+        }
+        snprintf(label, sizeof(label), "  dequantize_row_fp16 (%s)", cpu_level_name(level));
+        bench_print(label, bench_now() - start, iterations, work, "B");
+
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            quantize_row_bf16(values, halves, length);
+            BENCH_KEEP(halves[0]);
+        }
+        snprintf(label, sizeof(label), "  quantize_row_bf16 (%s)", cpu_level_name(level));
+        bench_print(label, bench_now() - start, iterations, work, "B");
+
+        start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            dequantize_row_bf16(halves, values, length);
+            BENCH_KEEP(values[0]);
+        }
+        snprintf(label, sizeof(label), "  dequantize_row_bf16 (%s)", cpu_level_name(level));
+        bench_print(label, bench_now() - start, iterations, work, "B");
+    }
+
+    cpu_level_set(cpu_level_detected());
+    free(values);
+    free(halves);
+}
+
+static void bench_blocks(size_t length) {
+    float* values = malloc(length * sizeof(float));
+    void* blocks = malloc(data_type_row_size(TYPE_BLOCK_Q8, length));
+    size_t iterations = BENCH_BYTES / (length * 6);
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        values[i] = (lehmer_generate_float() - 0.5f) * 1000.0f;
+    }
+
+    printf("length=%zu, iterations=%zu\n", length, iterations);
+
+    DataTypeId ids[] = {TYPE_BLOCK_Q8, TYPE_BLOCK_Q4};
+    for (size_t t = 0; t < 2; t++) {
+        QuantizeError error;
+        quantize_row_error(values, length, ids[t], &error);
+        printf(
+            "  %s: %.2fx smaller than fp32, max_abs=%g, rmse=%g, relative_rmse=%g\n",
+            data_type_name(ids[t]),
+            (double) (length * sizeof(float)) / (double) error.bytes,
+            error.max_abs,
+            error.rmse,
+            error.relative_rmse
+        );
+    }
+
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+        cpu_level_set((CpuLevel) level);
+        char label[64];
+
+        for (size_t t = 0; t < 2; t++) {
+            double start = bench_now();
+            for (size_t i = 0; i < iterations; i++) {
+                quantize_row(values, blocks, length, ids[t]);
+                BENCH_KEEP(((uint8_t*) blocks)[0]);
+            }
+            snprintf(
+                label,
+                sizeof(label),
+                "  quantize_row_%s (%s)",
+                data_type_name(ids[t]),
+                cpu_level_name(level)
+            );
+            bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+            start = bench_now();
+            for (size_t i = 0; i < iterations; i++) {
+                dequantize_row(blocks, values, length, ids[t]);
+                BENCH_KEEP(values[0]);
+            }
+            snprintf(
+                label,
+                sizeof(label),
+                "  dequantize_row_%s (%s)",
+                data_type_name(ids[t]),
+                cpu_level_name(level)
+            );
+            bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+        }
+    }
+
+    cpu_level_set(cpu_level_detected());
+    free(values);
+    free(blocks);
+}
+
+static void bench_fp8(size_t length) {
+    float* values = malloc(length * sizeof(float));
+    float* restored = malloc(length * sizeof(float));
+    uint16_t* halves = malloc(length * sizeof(uint16_t));
+    uint8_t* bytes = malloc(length);
+    size_t iterations = BENCH_BYTES / (length * 5);
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        values[i] = (lehmer_generate_float() - 0.5f) * 1000.0f;
+    }
+    quantize_row_fp16(values, halves, length);
+
+    printf("length=%zu, iterations=%zu\n", length, iterations);
+
+    const char* names[] = {"e4m3", "e5m2"};
+    float scales[] = {
+        quantize_row_scale_e4m3(values, length),
+        quantize_row_scale_e5m2(values, length),
+    };
+    void (*quantize[])(const float*, uint8_t*, size_t, float) = {
+        quantize_row_e4m3_scaled,
+        quantize_row_e5m2_scaled,
+    };
+    void (*dequantize[])(const uint8_t*, float*, size_t, float) = {
+        dequantize_row_e4m3_scaled,
+        dequantize_row_e5m2_scaled,
+    };
+
+    for (size_t t = 0; t < 2; t++) {
+        quantize[t](values, bytes, length, scales[t]);
+        dequantize[t](bytes, restored, length, scales[t]);
+        double squared_error = 0.0;
+        double squared_input = 0.0;
+        for (size_t i = 0; i < length; i++) {
+            double e = (double) restored[i] - (double) values[i];
+            squared_error += e * e;
+            squared_input += (double) values[i] * (double) values[i];
+        }
+        printf(
+            "  %s: scale=%g, relative_rmse=%g\n",
+            names[t],
+            (double) scales[t],
+            sqrt(squared_error / squared_input)
+        );
+    }
+
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+        cpu_level_set((CpuLevel) level);
+        char label[64];
+
+        for (size_t t = 0; t < 2; t++) {
+            double start = bench_now();
+            for (size_t i = 0; i < iterations; i++) {
+                quantize[t](values, bytes, length, scales[t]);
+                BENCH_KEEP(bytes[0]);
+            }
+            snprintf(
+                label, sizeof(label), "  quantize_row_%s (%s)", names[t], cpu_level_name(level)
+            );
+            bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+
+            start = bench_now();
+            for (size_t i = 0; i < iterations; i++) {
+                dequantize[t](bytes, restored, length, scales[t]);
+                BENCH_KEEP(restored[0]);
+            }
+            snprintf(
+                label, sizeof(label), "  dequantize_row_%s (%s)", names[t], cpu_level_name(level)
+            );
+            bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+        }
+
+        double start = bench_now();
+        for (size_t i = 0; i < iterations; i++) {
+            convert_row(halves, TYPE_FLOAT16, bytes, TYPE_FLOAT8_E4M3, length);
+            BENCH_KEEP(bytes[0]);
+        }
+        snprintf(label, sizeof(label), "  fp16 -> e4m3 (%s)", cpu_level_name(level));
+        bench_print(label, bench_now() - start, iterations, (double) length, "elem");
+    }
+
+    cpu_level_set(cpu_level_detected());
+    free(values);
+    free(restored);
+    free(halves);
+    free(bytes);
+}
+
+int main(void) {
+    printf("cpu=%s\n", cpu_level_name(cpu_level_detected()));
+    bench_rows(4096);
+    bench_rows(1 << 24);
+    bench_blocks(4096);
+    bench_blocks(1 << 24);
+    bench_fp8(4096);
+    bench_fp8(1 << 24);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/sort/bench_merge.c
+ * @brief Stable merge sort against qsort on random and presorted key/value records.
+ */
+
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "sort/merge.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_COUNT 1000000
+#define BENCH_ITERATIONS 5
+
+typedef struct BenchRecord {
+    uint32_t key;
+    uint32_t value;
+} BenchRecord;
+
+static int bench_compare(const void* a, const void* b) {
+    uint32_t ka = ((const BenchRecord*) a)->key;
+    uint32_t kb = ((const BenchRecord*) b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+static void bench_run(const char* label, const BenchRecord* source, BenchRecord* work, bool merge) {
+    double elapsed = 0.0;
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        memcpy(work, source, BENCH_COUNT * sizeof(BenchRecord));
+        double start = bench_now();
+        if (merge) {
+            merge_sort(work, BENCH_COUNT, sizeof(BenchRecord), bench_compare);
+        } else {
+            qsort(work, BENCH_COUNT, sizeof(BenchRecord), bench_compare);
+        }
+        elapsed += bench_now() - start;
+        BENCH_KEEP(work[0].value);
+    }
+    bench_print(label, elapsed, BENCH_ITERATIONS, BENCH_COUNT, "rec");
+}
+
+int main(void) {
+    BenchRecord* source = malloc(BENCH_COUNT * sizeof(BenchRecord));
+    BenchRecord* work = malloc(BENCH_COUNT * sizeof(BenchRecord));
+
+    static const char* patterns[] = {"random", "sorted", "reversed", "append 1%", "sorted runs"};
+
+    for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        lehmer_initialize(LEHMER_SEED);
+        for (size_t i = 0; i < BENCH_COUNT; i++) {
+            uint32_t key = (uint32_t) lehmer_generate_int32();
+            switch (p) {
+                case 1:
+                    key = (uint32_t) i;
+                    break;
+                case 2:
+                    key = (uint32_t) (BENCH_COUNT - i);
+                    break;
+                case 3:
+                    key = i < BENCH_COUNT - BENCH_COUNT / 100 ? (uint32_t) i : key % BENCH_COUNT;
+                    break;
+                case 4:
+                    key = (uint32_t) (i % 10000) * 100 + (uint32_t) (i / 10000);
+                    break;
+                default:
+                    break;
+            }
+            source[i] = (BenchRecord){key, (uint32_t) i};
+        }
+
+        printf("records=%d, pattern=%s\n", BENCH_COUNT, patterns[p]);
+        bench_run("  qsort (baseline)", source, work, false);
+        bench_run("  merge_sort", source, work, true);
+    }
+
+    free(source);
+    free(work);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/sort/bench_search.c
+ * @brief Eytzinger and S-tree lookups against bsearch over growing sorted arrays.
+ */
+
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "sort/search.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_QUERIES 2000000
+
+static int bench_compare(const void* a, const void* b) {
+    int32_t ka = *(const int32_t*) a;
+    int32_t kb = *(const int32_t*) b;
+    return (ka > kb) - (ka < kb);
+}
+
+static int32_t bench_draw(void) {
+    return (int32_t) ((uint32_t) lehmer_generate_int32() ^ ((uint32_t) lehmer_generate_int32() << 16));
+}
+
+int main(void) {
+    static const size_t sizes[] = {1 << 10, 1 << 16, 1 << 20, 1 << 24};
+
+    int32_t* queries = malloc(BENCH_QUERIES * sizeof(int32_t));
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t count = sizes[s];
+        int32_t* keys = malloc(count * sizeof(int32_t));
+
+        lehmer_initialize(LEHMER_SEED);
+        for (size_t i = 0; i < count; i++) {
+            keys[i] = bench_draw();
+        }
+        qsort(keys, count, sizeof(int32_t), bench_compare);
+
+        // Present keys, so bsearch does the same amount of work as a bound query.
+        for (size_t i = 0; i < BENCH_QUERIES; i++) {
+            queries[i] = keys[(size_t) lehmer_generate_int32() % count];
+        }
+
+        SearchEytzinger* eytzinger = search_eytzinger_create(keys, count);
+        SearchTree* tree = search_tree_create(keys, count);
+
+        printf("keys=%zu, queries=%d\n", count, BENCH_QUERIES);
+
+        size_t sum = 0;
+        double start = bench_now();
+        for (size_t i = 0; i < BENCH_QUERIES; i++) {
+            int32_t* hit = bsearch(&queries[i], keys, count, sizeof(int32_t), bench_compare);
+            sum += (size_t) (hit - keys);
+        }
+        bench_print("  bsearch (baseline)", bench_now() - start, 1, BENCH_QUERIES, "q");
+
+        start = bench_now();
+        for (size_t i = 0; i < BENCH_QUERIES; i++) {
+            sum += search_eytzinger_lower_bound(eytzinger, queries[i]);
+        }
+        bench_print("  search_eytzinger_lower_bound", bench_now() - start, 1, BENCH_QUERIES, "q");
+
+        start = bench_now();
+        for (size_t i = 0; i < BENCH_QUERIES; i++) {
+            sum += search_tree_lower_bound(tree, queries[i]);
+        }
+        bench_print("  search_tree_lower_bound", bench_now() - start, 1, BENCH_QUERIES, "q");
+
+        BENCH_KEEP(sum);
+        search_eytzinger_free(eytzinger);
+        search_tree_free(tree);
+        free(keys);
+    }
+
+    free(queries);
+    return 0;
+}
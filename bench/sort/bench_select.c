@@ -0,0 +1,119 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/sort/bench_select.c
+ * @brief Top-k, selection and argsort over vocabulary-sized logit vectors.
+ */
+
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "sort/select.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_TOP_K 40
+#define BENCH_ITERATIONS 50
+
+static const float* bench_keys;
+
+static int bench_index_compare(const void* a, const void* b) {
+    float fa = bench_keys[*(const uint32_t*) a];
+    float fb = bench_keys[*(const uint32_t*) b];
+    return (fa < fb) - (fa > fb); // descending
+}
+
+static int bench_float_compare(const void* a, const void* b) {
+    float fa = *(const float*) a;
+    float fb = *(const float*) b;
+    return (fa > fb) - (fa < fb);
+}
+
+static void bench_vocabulary(size_t length) {
+    float* logits = malloc(length * sizeof(float));
+    float* scratch = malloc(length * sizeof(float));
+    uint32_t* indices = malloc(length * sizeof(uint32_t));
+    float values[BENCH_TOP_K];
+
+    // Logit-like scores: mostly small, a thin tail of large ones.
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        float u = lehmer_generate_float();
+        logits[i] = u * u * u * 20.0f - 5.0f;
+    }
+    bench_keys = logits;
+
+    printf("vocabulary=%zu k=%d\n", length, BENCH_TOP_K);
+
+    double start = bench_now();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        for (size_t j = 0; j < length; j++) {
+            indices[j] = (uint32_t) j;
+        }
+        qsort(indices, length, sizeof(uint32_t), bench_index_compare);
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print("  qsort argsort (baseline)", bench_now() - start, BENCH_ITERATIONS, (double) length, "elem");
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        select_argsort_float(logits, length, indices, SELECT_DESCENDING);
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print("  select_argsort_float", bench_now() - start, BENCH_ITERATIONS, (double) length, "elem");
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        select_argpartition_float(logits, length, BENCH_TOP_K, indices, SELECT_DESCENDING);
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print(
+        "  select_argpartition_float", bench_now() - start, BENCH_ITERATIONS, (double) length, "elem"
+    );
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        select_top_k_float(logits, length, BENCH_TOP_K, indices, values);
+        BENCH_KEEP(indices[0]);
+    }
+    bench_print("  select_top_k_float", bench_now() - start, BENCH_ITERATIONS, (double) length, "elem");
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        memcpy(scratch, logits, length * sizeof(float));
+        qsort(scratch, length, sizeof(float), bench_float_compare);
+        BENCH_KEEP(scratch[length / 2]);
+    }
+    bench_print("  qsort median (baseline)", bench_now() - start, BENCH_ITERATIONS, (double) length, "elem");
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        memcpy(scratch, logits, length * sizeof(float));
+        BENCH_KEEP(select_nth_float(scratch, length, length / 2));
+    }
+    bench_print("  select_nth_float median", bench_now() - start, BENCH_ITERATIONS, (double) length, "elem");
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        memcpy(scratch, logits, length * sizeof(float));
+        select_partial_sort_float(scratch, length, BENCH_TOP_K);
+        BENCH_KEEP(scratch[0]);
+    }
+    bench_print(
+        "  select_partial_sort_float", bench_now() - start, BENCH_ITERATIONS, (double) length, "elem"
+    );
+
+    free(logits);
+    free(scratch);
+    free(indices);
+}
+
+int main(void) {
+    static const size_t sizes[] = {32000, 32768, 65536, 128256, 151936, 262144};
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_vocabulary(sizes[i]);
+    }
+    return 0;
+}
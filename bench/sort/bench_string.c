@@ -0,0 +1,87 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file bench/sort/bench_string.c
+ * @brief String sorting over synthetic path lists.
+ */
+
+#include "test/bench.h"
+#include "numeric/lehmer.h"
+#include "sort/string.h"
+#include "utf8/raw.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_COUNT 200000
+#define BENCH_ITERATIONS 5
+
+static int bench_strcmp(const void* a, const void* b) {
+    return strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+static int bench_utf8_compare(const void* a, const void* b) {
+    return utf8_raw_compare(*(char* const*) a, *(char* const*) b);
+}
+
+static void bench_run(const char* label, char** source, char** work, int mode) {
+    double elapsed = 0.0;
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        memcpy(work, source, BENCH_COUNT * sizeof(char*));
+        double start = bench_now();
+        switch (mode) {
+            case 0:
+                qsort(work, BENCH_COUNT, sizeof(char*), bench_strcmp);
+                break;
+            case 1:
+                qsort(work, BENCH_COUNT, sizeof(char*), bench_utf8_compare);
+                break;
+            case 2:
+                string_sort_multikey(work, BENCH_COUNT);
+                break;
+            default:
+                string_sort_radix(work, BENCH_COUNT, NULL);
+                break;
+        }
+        elapsed += bench_now() - start;
+        BENCH_KEEP(work[0]);
+    }
+    bench_print(label, elapsed, BENCH_ITERATIONS, BENCH_COUNT, "str");
+}
+
+int main(void) {
+    static const char* dirs[] = {"/home/user/", "src/", "include/", "tests/", "docs/", "Γλώσσα/"};
+    static const char* names[] = {"memory", "logger", "arena", "значение", "heap", "list"};
+
+    char** source = malloc(BENCH_COUNT * sizeof(char*));
+    char** work = malloc(BENCH_COUNT * sizeof(char*));
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        char buffer[256] = {0};
+        size_t depth = 1 + (size_t) lehmer_generate_int32() % 6;
+        for (size_t d = 0; d < depth; d++) {
+            strcat(buffer, dirs[(size_t) lehmer_generate_int32() % 6]);
+        }
+        char leaf[32];
+        snprintf(
+            leaf, sizeof(leaf), "%s_%d.c", names[(size_t) lehmer_generate_int32() % 6], (int) (i % 997)
+        );
+        strcat(buffer, leaf);
+        source[i] = strdup(buffer);
+    }
+
+    printf("paths=%d\n", BENCH_COUNT);
+    bench_run("  qsort + strcmp (baseline)", source, work, 0);
+    bench_run("  qsort + utf8_raw_compare (baseline)", source, work, 1);
+    bench_run("  string_sort_multikey", source, work, 2);
+    bench_run("  string_sort_radix", source, work, 3);
+
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        free(source[i]);
+    }
+    free(source);
+    free(work);
+    return 0;
+}
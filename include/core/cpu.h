@@ -0,0 +1,117 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/core/cpu.h
+ * @brief Runtime CPU feature detection for selecting SIMD kernels.
+ *
+ * Features are read once with CPUID (and XGETBV, so vector state the OS does not save is never
+ * reported). Kernels are grouped into levels; a module keeps one kernel table per level and
+ * indexes it with `cpu_level()`, so the choice costs a load per call, not a CPUID.
+ *
+ * `cpu_level_set()` lowers the active level, which lets tests and benchmarks exercise every
+ * kernel variant on one machine.
+ *
+ * Kernels above the compile-time baseline are built with per-function target attributes
+ * (`CPU_TARGET_*`) rather than global `-m` flags, so the library still runs on older CPUs.
+ */
+
+#ifndef DSA_CPU_H
+#define DSA_CPU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define CPU_X86 1
+    #define CPU_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+    #define CPU_TARGET_AVX512 \
+        __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx2,fma,f16c")))
+    #define CPU_TARGET_AVX512_BF16 \
+        __attribute__((target("avx512bf16,avx512f,avx512bw,avx512vl,avx512dq,avx2,fma,f16c")))
+#else
+    #define CPU_X86 0
+#endif
+
+/**
+ * @brief Individual instruction set extensions.
+ */
+typedef enum CpuFeature {
+    CPU_FEATURE_SSE2 = 1u << 0,
+    CPU_FEATURE_SSE41 = 1u << 1,
+    CPU_FEATURE_POPCNT = 1u << 2,
+    CPU_FEATURE_AVX = 1u << 3,
+    CPU_FEATURE_F16C = 1u << 4,
+    CPU_FEATURE_FMA = 1u << 5,
+    CPU_FEATURE_AVX2 = 1u << 6,
+    CPU_FEATURE_AVX_VNNI = 1u << 7,
+    CPU_FEATURE_AVX512F = 1u << 8,
+    CPU_FEATURE_AVX512BW = 1u << 9,
+    CPU_FEATURE_AVX512DQ = 1u << 10,
+    CPU_FEATURE_AVX512VL = 1u << 11,
+    CPU_FEATURE_AVX512_VNNI = 1u << 12,
+    CPU_FEATURE_AVX512_BF16 = 1u << 13,
+} CpuFeature;
+
+/**
+ * @brief Kernel levels, each a superset of the one before.
+ */
+typedef enum CpuLevel {
+    CPU_LEVEL_SCALAR, /**< Portable C. */
+    CPU_LEVEL_SSE2, /**< x86-64 baseline. */
+    CPU_LEVEL_AVX2, /**< AVX2 + FMA + F16C. */
+    CPU_LEVEL_AVX512, /**< AVX-512 F/BW/DQ/VL. */
+    CPU_LEVEL_COUNT /**< Number of levels. */
+} CpuLevel;
+
+/**
+ * @brief Features available at the active level.
+ *
+ * Features above the active level are masked out, e.g. AVX512_BF16 disappears after
+ * `cpu_level_set(CPU_LEVEL_AVX2)`.
+ */
+uint32_t cpu_features(void);
+
+/**
+ * @brief True if every feature in `features` is available at the active level.
+ */
+bool cpu_has(uint32_t features);
+
+/**
+ * @brief Active kernel level: the best detected level, unless lowered by `cpu_level_set()`.
+ */
+CpuLevel cpu_level(void);
+
+/**
+ * @brief Best level the CPU and OS support.
+ */
+CpuLevel cpu_level_detected(void);
+
+/**
+ * @brief Sets the active kernel level.
+ *
+ * @return False (and no change) if the CPU does not support `level`.
+ */
+bool cpu_level_set(CpuLevel level);
+
+/**
+ * @brief Hides `features` from `cpu_features()` and `cpu_has()`; 0 shows them again.
+ *
+ * Like `cpu_level_set()`, this exists so tests and benchmarks can reach the fallback taken
+ * when an optional extension (e.g. VNNI) is missing.
+ */
+void cpu_features_mask(uint32_t features);
+
+/**
+ * @brief Short lowercase name of a level, e.g. "avx2".
+ */
+const char* cpu_level_name(CpuLevel level);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // DSA_CPU_H
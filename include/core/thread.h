@@ -0,0 +1,73 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/core/thread.h
+ * @brief Fixed-size thread pool for data-parallel loops.
+ *
+ * `thread_pool_parallel_for()` splits `[0, count)` into one contiguous range per thread and
+ * blocks until every range is done. The split depends only on `count`, `grain` and the pool
+ * size, so a task that reduces per range and combines the partials in thread order gives the
+ * same result on every run.
+ *
+ * The calling thread runs the first range itself; a pool of `n` threads starts `n - 1` workers.
+ * A NULL pool runs the whole loop on the caller, so kernels can take an optional pool.
+ *
+ * A pool runs one loop at a time: do not call `thread_pool_parallel_for()` on the same pool
+ * concurrently or from inside one of its tasks.
+ */
+
+#ifndef DSA_THREAD_H
+#define DSA_THREAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+
+/**
+ * @brief Processes `[begin, end)`. `thread` is the range index, in `[0, thread_pool_size())`.
+ */
+typedef void (*ThreadTask)(void* context, size_t begin, size_t end, size_t thread);
+
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * @brief Online CPU count (at least 1).
+ */
+size_t thread_count_online(void);
+
+/**
+ * @brief Creates a pool of `threads` threads, counting the caller; 0 means one per online CPU.
+ *
+ * If some workers cannot be started the pool runs with fewer threads rather than failing.
+ *
+ * @return The pool, or NULL if memory runs out.
+ */
+ThreadPool* thread_pool_create(size_t threads);
+
+/**
+ * @brief Stops the workers and frees the pool. Accepts NULL.
+ */
+void thread_pool_free(ThreadPool* pool);
+
+/**
+ * @brief Threads that share a loop, counting the caller (1 for a NULL pool).
+ */
+size_t thread_pool_size(const ThreadPool* pool);
+
+/**
+ * @brief Runs `task` over `[0, count)` split into contiguous ranges and waits for all of them.
+ *
+ * Range boundaries are multiples of `grain` (0 is treated as 1), except the end of the last
+ * range. Fewer ranges than threads are used when `count` is small; idle threads get no call.
+ */
+void thread_pool_parallel_for(
+    ThreadPool* pool, size_t count, size_t grain, ThreadTask task, void* context
+);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // DSA_THREAD_H
@@ -12,6 +12,7 @@
 #ifndef NUMERIC_ACTIVATION_H
 #define NUMERIC_ACTIVATION_H
 
+#include "core/thread.h"
 #include "numeric/type.h" // For math.h, M_PI, etc.
 
 /**
@@ -120,10 +121,144 @@ float activate_gelu_approximation(float x);
 /**
  * @brief Computes the softmax function for a 1D array.
  *
+ * Runs the online kernel described under "Softmax" below; `input` and `output` may be the same
+ * array.
+ *
  * @param input The input array.
  * @param output The output array (softmax probabilities).
  * @param length The number of elements in the input/output arrays.
  */
 void activate_softmax(const float* input, float* output, size_t length);
 
+/**
+ * @name Row Kernels
+ *
+ * Array versions of the activations above, built on polynomial approximations of exp, tanh and
+ * the normal CDF (erf) instead of per-element libm calls, with SSE2 and AVX2/FMA paths chosen
+ * by the active CPU level. `input` and `output` may be the same array (in-place operation).
+ *
+ * Maximum error over all 2^32 fp32 inputs, in units in the last place of the exact result
+ * (subnormal results are measured in subnormal ulps), measured against double-precision libm:
+ *
+ * | Function                 | scalar | SSE2 | AVX2 |
+ * |--------------------------|--------|------|------|
+ * | activate_exp_row         |   0.99 | 0.99 | 1.01 |
+ * | activate_relu_row        |      0 |    0 |    0 |
+ * | activate_sigmoid_row     |   2.83 | 2.83 | 2.83 |
+ * | activate_tanh_row        |   1.33 | 1.33 | 1.33 |
+ * | activate_silu_row        |   3.69 | 3.69 | 3.69 |
+ * | activate_gelu_row        |   5.84 | 5.84 | 4.68 |
+ * | activate_gelu_tanh_row   |   4.64 | 4.64 | 4.33 |
+ *
+ * AVX-512 runs the AVX2 kernels. The SSE2 and scalar kernels do the same arithmetic; AVX2 fuses
+ * multiply-adds, so its results differ in the last bit or so.
+ *
+ * NaN inputs give NaN (ReLU gives 0, like `activate_relu()`); infinities give the limits.
+ * @{
+ */
+
+/**
+ * @brief Element-wise activations that have row kernels.
+ */
+typedef enum ActivationFunction {
+    ACTIVATION_RELU, /**< max(0, x) */
+    ACTIVATION_SIGMOID, /**< 1 / (1 + exp(-x)) */
+    ACTIVATION_TANH, /**< tanh(x) */
+    ACTIVATION_SILU, /**< x * sigmoid(x) */
+    ACTIVATION_GELU, /**< x * Φ(x), the exact (erf) form */
+    ACTIVATION_GELU_TANH, /**< The tanh form of GELU, as in `activate_gelu_approximation()` */
+    ACTIVATION_COUNT /**< Number of activations */
+} ActivationFunction;
+
+void activate_exp_row(const float* input, float* output, size_t length);
+void activate_relu_row(const float* input, float* output, size_t length);
+void activate_sigmoid_row(const float* input, float* output, size_t length);
+void activate_tanh_row(const float* input, float* output, size_t length);
+void activate_silu_row(const float* input, float* output, size_t length);
+void activate_gelu_row(const float* input, float* output, size_t length);
+void activate_gelu_tanh_row(const float* input, float* output, size_t length);
+
+/**
+ * @brief Applies `function` to a row; the row kernels above by enum.
+ */
+void activate_row(ActivationFunction function, const float* input, float* output, size_t length);
+
+/**
+ * @brief Applies `function` to a row of fp16 values through a 65536-entry lookup table.
+ *
+ * Each table entry is the exact activation of that half, rounded to fp16, so results are
+ * correctly rounded up to the double rounding through fp32. Tables (128 KiB each) are built on
+ * first use and shared by all threads. ReLU, which is exact either way, and any table that
+ * cannot be allocated use `activate_row_fp16_fused()` instead. `input` and `output` may be the
+ * same array.
+ */
+void activate_row_fp16(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+);
+
+/**
+ * @brief `activate_row_fp16()` for bf16 rows, with tables of its own.
+ */
+void activate_row_bf16(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+);
+
+/**
+ * @brief Applies `function` to a row of fp16 values in one streaming pass without tables.
+ *
+ * Each vector of halves is widened in registers, run through the fp32 row kernel and narrowed
+ * again, so the result is bit-identical to `dequantize_row_fp16()`, `activate_row()` and
+ * `quantize_row_fp16()` in sequence, with a third of the memory traffic and no buffer. Prefer
+ * this over the table when the table's cache footprint matters more than its speed.
+ */
+void activate_row_fp16_fused(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+);
+
+/**
+ * @brief `activate_row_fp16_fused()` for bf16 rows.
+ */
+void activate_row_bf16_fused(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+);
+
+/** @} */
+
+/**
+ * @name Softmax
+ *
+ * softmax(x)_i = exp(x_i / T - m) / Σ_j exp(x_j / T - m) with m = max_j x_j / T, and
+ * log_softmax(x)_i = x_i / T - m - log Σ_j exp(x_j / T - m), for a temperature T > 0.
+ *
+ * The kernels read the input twice instead of three times. The first pass keeps a running max
+ * and a sum of exponentials that is rescaled by exp(old max - new max) whenever the max grows
+ * (checked once per block of four vectors, not per element). The running sum is Kahan
+ * compensated, so long rows keep about fp32 accuracy. The second pass writes the normalized
+ * outputs. Both passes use the vectorized exp of the row kernels above.
+ *
+ * The parallel versions split the row into contiguous chunks of the thread pool. Each chunk
+ * returns its (max, sum) partial, and the partials are merged in chunk order, so the result does
+ * not depend on scheduling. Chunks are at least 16384 elements, so shorter rows run on the
+ * caller. A NULL pool runs serially.
+ *
+ * `input` and `output` may be the same array (in-place operation).
+ * @{
+ */
+
+void activate_softmax_temperature(
+    const float* input, float* output, size_t length, float temperature
+);
+void activate_log_softmax(const float* input, float* output, size_t length);
+void activate_log_softmax_temperature(
+    const float* input, float* output, size_t length, float temperature
+);
+void activate_softmax_parallel(
+    ThreadPool* pool, const float* input, float* output, size_t length, float temperature
+);
+void activate_log_softmax_parallel(
+    ThreadPool* pool, const float* input, float* output, size_t length, float temperature
+);
+
+/** @} */
+
 #endif // NUMERIC_ACTIVATION_H
@@ -0,0 +1,190 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file include/numeric/analysis.h
+ * @brief Accuracy and speed of quantized round trips over fp32 rows.
+ *
+ * Every DataTypeId trades bits for error in its own way, and the error a model sees depends on
+ * the distribution it stores: a Q8 row with one outlier spends its whole scale on that outlier,
+ * while fp16 and bf16 keep a relative error whatever the magnitudes. The functions here measure
+ * that cost directly on a reference row and its restored copy:
+ *
+ * - `analysis_close_count` and `analysis_find_far` compare rows element by element with the same
+ *   rule as is_close_float(), but with explicit relative and absolute tolerances and one vector
+ *   pass over the row.
+ * - `analysis_compare` reports the largest absolute error, RMSE, signal-to-noise ratio, cosine
+ *   similarity and a histogram of distances in fp32 units in the last place (ULPs).
+ * - `analysis_round_trip` quantizes a row to any DataTypeId and back, times both directions and
+ *   compares the result with the input.
+ * - `analysis_fill` draws the synthetic rows the measurements are usually run on.
+ *
+ * Moments are accumulated in double, so the reported error does not depend on the length of the
+ * row. The parallel split follows core/thread.h: contiguous ranges of at least ANALYSIS_GRAIN
+ * elements whose partials are combined in range order, so a fixed thread count always reports
+ * the same values and a NULL pool reports the serial ones.
+ */
+
+#ifndef NUMERIC_ANALYSIS_H
+#define NUMERIC_ANALYSIS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "core/thread.h"
+#include "numeric/random.h"
+#include "numeric/type.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ANALYSIS_GRAIN 16384 // elements per thread range, at least
+#define ANALYSIS_ULP_BINS 33 // bin 0 holds exact matches, bin k distances in [2^(k-1), 2^k)
+
+/**
+ * @name Comparison
+ *
+ * A pair is close when the values are equal (including infinities of the same sign), or when
+ * both are finite and |a - b| <= max(relative * max(|a|, |b|), absolute). NaN is never close.
+ * @{
+ */
+
+/**
+ * @brief Number of pairs in `a` and `b` that are close.
+ */
+size_t analysis_close_count(
+    const float* a, const float* b, size_t length, float relative, float absolute
+);
+
+/**
+ * @brief Index of the first pair that is not close, or `length` if every pair is.
+ */
+size_t analysis_find_far(
+    const float* a, const float* b, size_t length, float relative, float absolute
+);
+
+/** @} */
+
+/**
+ * @name Error Statistics
+ * @{
+ */
+
+/**
+ * @brief Error of `actual` measured against `reference`.
+ *
+ * With e_i = actual_i - reference_i, x_i = reference_i and y_i = actual_i:
+ *
+ * - snr_db is 10 log10(Σ x_i^2 / Σ e_i^2): +inf for an exact copy, -inf for a zero reference.
+ * - cosine is Σ x_i y_i / sqrt(Σ x_i^2 Σ y_i^2): 1 when both rows are zero, 0 when only one is.
+ *
+ * Pairs holding NaN are counted in `unordered` and left out of the histogram; they still
+ * propagate into the moments, as IEEE arithmetic would.
+ */
+typedef struct AnalysisStats {
+    size_t length; /**< Pairs compared */
+    double max_abs; /**< Largest |e_i| */
+    double rmse; /**< sqrt(Σ e_i^2 / length) */
+    double snr_db; /**< Signal-to-noise ratio in decibels */
+    double cosine; /**< Cosine similarity */
+    size_t unordered; /**< Pairs where either value is NaN */
+    uint32_t ulp_max; /**< Largest distance in fp32 ULPs */
+    size_t ulp[ANALYSIS_ULP_BINS]; /**< Pairs per power-of-two distance in fp32 ULPs */
+} AnalysisStats;
+
+/**
+ * @brief Compares `actual` with `reference` over `length` elements. `length` must be nonzero.
+ */
+void analysis_compare(
+    ThreadPool* pool,
+    const float* reference,
+    const float* actual,
+    size_t length,
+    AnalysisStats* stats
+);
+
+/**
+ * @brief Distance between two floats in fp32 ULPs: the number of representable values between
+ * them, with -0 and +0 counted as one value. Either argument being NaN gives UINT32_MAX.
+ */
+uint32_t analysis_ulp_distance(float a, float b);
+
+/**
+ * @brief Smallest distance, in fp32 ULPs, at or below which `fraction` of the ordered pairs lie,
+ * read from the histogram: the upper edge of the bin where the running count reaches it.
+ */
+uint32_t analysis_ulp_percentile(const AnalysisStats* stats, double fraction);
+
+/** @} */
+
+/**
+ * @name Round Trips
+ * @{
+ */
+
+/**
+ * @brief Storage, error and speed of one DataTypeId over one row.
+ */
+typedef struct AnalysisReport {
+    DataTypeId id; /**< Storage type */
+    size_t bytes; /**< Quantized row size, including block scales */
+    double bits_per_value; /**< 8 * bytes / length */
+    double quantize_seconds; /**< Fastest of the timed fp32 -> id passes */
+    double dequantize_seconds; /**< Fastest of the timed id -> fp32 passes */
+    AnalysisStats stats; /**< Restored row measured against the input */
+} AnalysisReport;
+
+/**
+ * @brief Quantizes `input` to `id` and back `repeats` times, keeping the fastest pass in each
+ * direction, and compares the restored row with the input.
+ *
+ * Conversion runs through quantize_row() and dequantize_row(), so the timings are those of the
+ * serial row kernels at the current CPU level; `pool` only splits the comparison. A `repeats`
+ * of 0 is read as 1. Returns false for an unknown type, a zero length or a failed allocation.
+ */
+bool analysis_round_trip(
+    ThreadPool* pool,
+    const float* input,
+    size_t length,
+    DataTypeId id,
+    size_t repeats,
+    AnalysisReport* report
+);
+
+/** @} */
+
+/**
+ * @name Synthetic Rows
+ * @{
+ */
+
+typedef enum AnalysisDistribution {
+    ANALYSIS_UNIFORM, /**< Uniform in [-scale, scale) */
+    ANALYSIS_NORMAL, /**< Normal with mean 0 and standard deviation `scale` */
+    ANALYSIS_LAPLACE, /**< Laplace with mean 0 and standard deviation `scale`: heavier tails */
+    ANALYSIS_OUTLIER, /**< Normal, with length / ANALYSIS_OUTLIER_RATE random picks scaled by 64 */
+    ANALYSIS_DISTRIBUTION_COUNT,
+} AnalysisDistribution;
+
+#define ANALYSIS_OUTLIER_RATE 1024 // elements per outlier
+
+/**
+ * @brief Fills `output` from `distribution`.
+ */
+void analysis_fill(
+    Random* random, float* output, size_t length, AnalysisDistribution distribution, float scale
+);
+
+/**
+ * @brief Name of `distribution`, or "unknown".
+ */
+const char* analysis_distribution_name(AnalysisDistribution distribution);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_ANALYSIS_H
@@ -0,0 +1,75 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/numeric/convert.h
+ *
+ * @brief Row conversion between any two data types.
+ *
+ * Every (input type, output type) pair in DataTypeId is supported and resolves to one of:
+ *
+ * - Copy: both types are the same.
+ * - Direct: one side is fp32. fp16, bf16, FP8 and the block formats use their row kernels from
+ *   numeric/type.h; the integer types and bool have SSE2 and AVX2 kernels chosen by the active
+ *   CPU level (AVX-512 reuses AVX2) that are bit-exact with the scalar path.
+ * - Integer: both sides are integers or bool. Values pass through an int64 tile, so 32-bit
+ *   integers are never rounded.
+ * - Float: anything else. The input is decoded to an fp32 tile that stays in L1 and encoded
+ *   from there, so both halves run their direct kernels.
+ *
+ * Encoding to an integer type rounds to nearest even and saturates to the type's range; NaN
+ * becomes 0. Encoding to bool yields 1 for any non-zero value, including NaN, and decoding
+ * treats any non-zero byte as true. TYPE_CHAR converts as an unsigned byte. TYPE_QUANT8 and
+ * TYPE_QUANT4 hold one scale per element (pair) and only have scalar codecs; a row of odd
+ * length pads the last Q4 pair with zero.
+ *
+ * Row sizes follow `data_type_row_size()`. Input and output must not overlap.
+ */
+
+#ifndef NUMERIC_CONVERT_H
+#define NUMERIC_CONVERT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "core/thread.h"
+#include "numeric/type.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Converts `length` elements from `input_type` to `output_type`.
+ *
+ * @return False if either type is not a DataTypeId.
+ */
+bool convert_row(
+    const void* input, DataTypeId input_type, void* output, DataTypeId output_type, size_t length
+);
+
+/**
+ * @brief Converts `rows` rows of `length` elements between strided buffers.
+ *
+ * Row `r` starts `r * input_stride` bytes into `input` and `r * output_stride` bytes into
+ * `output`. Long rows are split into tiles of whole blocks, and rows and tiles are spread over
+ * the thread pool (NULL runs on the caller). The result does not depend on the pool.
+ *
+ * @return False if either type is not a DataTypeId.
+ */
+bool convert_rows(
+    ThreadPool* pool,
+    const void* input,
+    DataTypeId input_type,
+    size_t input_stride,
+    void* output,
+    DataTypeId output_type,
+    size_t output_stride,
+    size_t rows,
+    size_t length
+);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_CONVERT_H
@@ -0,0 +1,138 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/numeric/distribution.h
+ * @brief Distributions and sampling over the generators in `numeric/random.h`.
+ *
+ * - Bounded integers use Lemire's multiply-shift with rejection, so every value in the range is
+ *   exactly equally likely and the common case costs one multiply and no division.
+ * - Normal and exponential variates use the ziggurat (Marsaglia & Tsang, 2000): one 64-bit draw,
+ *   a table lookup and a compare for ~98% of samples.
+ * - `random_fill_normal_box_muller` trades the ziggurat's branches for a branch-free transform
+ *   that runs in SIMD registers, for filling large tensors.
+ * - Categorical sampling uses Vose's alias table: O(n) to build, O(1) per sample.
+ *
+ * Each fill is a deterministic function of the generator state and its arguments. Fills draw
+ * their raw bits in batches, so unlike `random_fill_u32` and friends they need not match the
+ * same number of single-value calls.
+ */
+
+#ifndef NUMERIC_DISTRIBUTION_H
+#define NUMERIC_DISTRIBUTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "numeric/random.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @name Uniform
+ * @{
+ */
+
+/**
+ * @brief Uniform integer in [0, bound); `bound` must be non-zero.
+ */
+uint32_t random_bounded_u32(Random* random, uint32_t bound);
+uint64_t random_bounded_u64(Random* random, uint64_t bound);
+
+/**
+ * @brief Uniform integer in [low, high); requires low < high.
+ */
+int64_t random_range(Random* random, int64_t low, int64_t high);
+
+void random_fill_bounded(Random* random, uint32_t* output, size_t length, uint32_t bound);
+void random_fill_range(Random* random, int32_t* output, size_t length, int32_t low, int32_t high);
+
+/**
+ * @brief Uniform floats in [low, high); requires finite low < high, which may span the whole
+ * finite range.
+ */
+void random_fill_uniform(Random* random, float* output, size_t length, float low, float high);
+
+/** @} */
+
+/**
+ * @name Normal and Exponential
+ * @{
+ */
+
+double random_normal(Random* random); /**< Standard normal, ziggurat */
+double random_exponential(Random* random); /**< Exponential with rate 1, ziggurat */
+
+void random_fill_normal(Random* random, float* output, size_t length, float mean, float stddev);
+void random_fill_exponential(Random* random, float* output, size_t length, float rate);
+
+/**
+ * @brief Normal variates by the Box-Muller transform, vectorized per CPU level.
+ *
+ * Each pair of 24-bit uniforms gives two outputs, so the tails are truncated at
+ * sqrt(-2 ln 2^-24) ≈ 5.77 standard deviations, which is immaterial for weight initialization.
+ * The log and sine are single-precision polynomials; results agree across CPU levels to a few
+ * ulp, not bit for bit.
+ */
+void random_fill_normal_box_muller(
+    Random* random, float* output, size_t length, float mean, float stddev
+);
+
+/** @} */
+
+/**
+ * @name Sampling
+ * @{
+ */
+
+/**
+ * @brief Fisher-Yates shuffle of `count` elements of `size` bytes, in place.
+ */
+void random_shuffle(Random* random, void* base, size_t count, size_t size);
+
+/**
+ * @brief Uniform sample of `k` elements from `input` without replacement.
+ *
+ * Uses Li's Algorithm L, which draws O(k log(count / k)) numbers rather than one per element.
+ * The sample is in no particular order.
+ *
+ * @return The number of elements written, min(k, count).
+ */
+size_t random_reservoir(
+    Random* random, const void* input, size_t count, size_t size, void* output, size_t k
+);
+
+/**
+ * @brief Alias table for sampling indices in proportion to non-negative weights.
+ *
+ * Weights need not be normalized, so the output of `activate_softmax` and raw counts both work.
+ */
+typedef struct RandomAlias {
+    size_t count;
+    float* probability; /**< Chance of keeping column i rather than taking its alias */
+    uint32_t* alias;
+} RandomAlias;
+
+/**
+ * @brief Builds a table over `count` weights.
+ *
+ * @return false if count is 0 or above UINT32_MAX, a weight is negative or not finite, the
+ *         weights sum to 0, or allocation fails.
+ */
+bool random_alias_create(RandomAlias* table, const float* weights, size_t count);
+void random_alias_free(RandomAlias* table);
+
+uint32_t random_alias_sample(Random* random, const RandomAlias* table);
+void random_fill_categorical(
+    Random* random, const RandomAlias* table, uint32_t* output, size_t length
+);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_DISTRIBUTION_H
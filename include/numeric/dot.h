@@ -0,0 +1,61 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/numeric/dot.h
+ *
+ * @brief Dot products over quantized and half-precision rows.
+ *
+ * The block kernels multiply the integer quants of matching blocks and apply both fp16 scales
+ * once per block, so a row is never dequantized to fp32:
+ *
+ *   x · y = Σ_b (dx_b · dy_b) · Σ_i qx_bi · qy_bi
+ *
+ * Each block's integer sum is exact. The per-block scaled sums are accumulated in fp32, and the
+ * SIMD variants (SSE2 `pmaddwd`; AVX2 `pmaddubsw` + `pmaddwd`; AVX-VNNI and AVX512-VNNI
+ * `vpdpbusd`) add them in a different order than the scalar reference, so results agree to
+ * rounding rather than bit for bit. The variant is chosen per call from the active CPU level
+ * and features (see core/cpu.h).
+ *
+ * `length` counts elements; block rows hold ceil(length / BLOCK_SIZE) blocks, and the zero
+ * padding of a partial last block contributes nothing. Q8 quants must lie in [-127, 127], which
+ * is what `quantize_row_block_q8()` produces: the SIMD kernels take |qx| as an unsigned byte and
+ * move the sign onto qy, and -128 has no positive counterpart.
+ */
+
+#ifndef NUMERIC_DOT_H
+#define NUMERIC_DOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "numeric/type.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Dot product of two Q8 block rows.
+ */
+float dot_block_q8_q8(const BlockQ8* x, const BlockQ8* y, size_t length);
+
+/**
+ * @brief Dot product of a Q4 block row (e.g. weights) with a Q8 block row (e.g. activations).
+ */
+float dot_block_q4_q8(const BlockQ4* x, const BlockQ8* y, size_t length);
+
+/**
+ * @brief Dot product of an fp16 row with an fp32 row, widening `x` in registers.
+ */
+float dot_fp16_fp32(const uint16_t* x, const float* y, size_t length);
+
+/**
+ * @brief Dot product of two fp32 rows.
+ */
+float dot_fp32(const float* x, const float* y, size_t length);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_DOT_H
@@ -0,0 +1,78 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/numeric/matrix.h
+ *
+ * @brief Dense matrix products: SGEMM and GEMV over fp32, fp16 and block-quantized weights.
+ *
+ * Matrices are row-major with explicit leading dimensions (elements between consecutive rows).
+ *
+ * GEMM follows the usual cache-blocked scheme: B is packed into KC x NC panels of NR columns
+ * and A into MC x KC panels of MR rows, so the register-blocked MR x NR micro-kernel streams
+ * both operands contiguously. Row blocks of C are spread over the thread pool; each thread
+ * packs its own A panels.
+ *
+ * GEMV multiplies each weight row with `x` using the numeric/dot kernels, so fp16 and
+ * quantized weights are widened or multiplied in registers and never dequantized to memory.
+ * For the block formats `x` is first quantized to Q8 once per call.
+ *
+ * Every function takes an optional thread pool (NULL runs on the caller).
+ */
+
+#ifndef NUMERIC_MATRIX_H
+#define NUMERIC_MATRIX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "core/thread.h"
+#include "numeric/type.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief C = A · B for fp32 A (m x k), B (k x n) and C (m x n).
+ *
+ * C is overwritten and must not alias A or B. With k = 0, C is zeroed.
+ *
+ * @return False if the packing buffers cannot be allocated (C is then unspecified).
+ */
+bool matrix_gemm_fp32(
+    ThreadPool* pool,
+    size_t m,
+    size_t n,
+    size_t k,
+    const float* a,
+    size_t lda,
+    const float* b,
+    size_t ldb,
+    float* c,
+    size_t ldc
+);
+
+/**
+ * @brief y = W · x for a weight matrix W of `rows` x `cols` elements of `type`.
+ *
+ * W's rows are stored back to back, each `data_type_row_size(type, cols)` bytes, so a block
+ * format pads every row to whole blocks. Supported types: TYPE_FLOAT32, TYPE_FLOAT16,
+ * TYPE_BLOCK_Q8 and TYPE_BLOCK_Q4.
+ *
+ * @return False for an unsupported type or if the Q8 copy of `x` cannot be allocated.
+ */
+bool matrix_gemv(
+    ThreadPool* pool,
+    DataTypeId type,
+    const void* w,
+    size_t rows,
+    size_t cols,
+    const float* x,
+    float* y
+);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_MATRIX_H
@@ -0,0 +1,197 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file include/numeric/modular.h
+ * @brief Modular arithmetic over 31-bit moduli: reduction contexts, array kernels and the NTT.
+ *
+ * `%` on a product costs a hardware division, tens of cycles, and has no SIMD form. Both contexts
+ * here trade it for multiplies by constants fixed when the modulus is chosen
+ * (docs/numeric/ModularArithmetic.md covers `%` itself):
+ *
+ * - Barrett works on ordinary residues and any modulus: q = floor(x / m) is estimated with a
+ *   precomputed 2^2k / m and corrected by at most two subtractions.
+ * - Montgomery works on residues scaled by R = 2^32 (x is held as xR mod m) and needs an odd
+ *   modulus. A product then reduces with two multiplies and one subtraction, so it is the faster
+ *   of the two for long chains of multiplications, such as NTT butterflies.
+ *
+ * Moduli are below 2^31 so that a sum of two residues fits in 32 bits and the array kernels can
+ * keep eight residues per AVX2 register. Array kernels take residues already below the modulus.
+ *
+ * The number-theoretic transform is the DFT over Z/p for a prime p = c * 2^k + 1, whose
+ * multiplicative group holds every power-of-two root of unity up to 2^k. Convolution through it
+ * is exact modulo p, so integer convolutions whose true coefficients stay below p come out exact.
+ */
+
+#ifndef NUMERIC_MODULAR_H
+#define NUMERIC_MODULAR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MODULAR_LIMIT ((uint32_t) 1 << 31) // moduli are in [2, MODULAR_LIMIT)
+
+/**
+ * @name NTT-Friendly Primes
+ * @{
+ */
+
+#define MODULAR_PRIME_998244353 998244353u // 119 * 2^23 + 1, generator 3
+#define MODULAR_PRIME_469762049 469762049u // 7 * 2^26 + 1, generator 3
+#define MODULAR_PRIME_2013265921 2013265921u // 15 * 2^27 + 1, generator 31
+
+/** @} */
+
+/**
+ * @name Reduction Contexts
+ * @{
+ */
+
+typedef struct ModularBarrett {
+    uint32_t modulus;
+    uint32_t factor; /**< floor(2^(2k) / modulus) */
+    uint32_t shift; /**< k, with 2^(k - 1) < modulus <= 2^k */
+} ModularBarrett;
+
+typedef struct ModularMontgomery {
+    uint32_t modulus;
+    uint32_t inverse; /**< modulus^-1 mod 2^32 */
+    uint32_t one; /**< R mod modulus, 1 in Montgomery form */
+    uint32_t square; /**< R^2 mod modulus, converts into Montgomery form */
+} ModularMontgomery;
+
+/**
+ * @return false unless 2 <= modulus < MODULAR_LIMIT.
+ */
+bool modular_barrett_create(ModularBarrett* context, uint32_t modulus);
+
+/**
+ * @brief a * b mod m for residues a, b < m.
+ */
+uint32_t modular_barrett_multiply(const ModularBarrett* context, uint32_t a, uint32_t b);
+
+/**
+ * @return false unless the modulus is odd and 3 <= modulus < MODULAR_LIMIT.
+ */
+bool modular_montgomery_create(ModularMontgomery* context, uint32_t modulus);
+
+/**
+ * @brief a * b * R^-1 mod m: the product of two Montgomery residues, in Montgomery form.
+ *
+ * With one operand in Montgomery form and the other ordinary, the result is the ordinary product.
+ */
+uint32_t modular_montgomery_multiply(const ModularMontgomery* context, uint32_t a, uint32_t b);
+
+uint32_t modular_montgomery_to(const ModularMontgomery* context, uint32_t x);
+uint32_t modular_montgomery_from(const ModularMontgomery* context, uint32_t x);
+
+/** @} */
+
+/**
+ * @name Array Kernels
+ *
+ * Element-wise over `count` residues. `output` may alias either input.
+ * @{
+ */
+
+void modular_add(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+);
+
+void modular_sub(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+);
+
+void modular_mul_barrett(
+    const ModularBarrett* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+);
+
+/**
+ * @brief Montgomery products; see modular_montgomery_multiply() for which forms come out.
+ */
+void modular_mul_montgomery(
+    const ModularMontgomery* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+);
+
+void modular_to_montgomery(
+    const ModularMontgomery* context, const uint32_t* input, uint32_t* output, size_t count
+);
+
+void modular_from_montgomery(
+    const ModularMontgomery* context, const uint32_t* input, uint32_t* output, size_t count
+);
+
+/** @} */
+
+/**
+ * @name Number-Theoretic Transform
+ *
+ * The forward transform is decimation in frequency and leaves its output in bit-reversed order;
+ * the inverse takes that order back to natural order and divides by the size, so
+ * inverse(forward(x)) = x. Pointwise products are order-blind, so convolution never permutes.
+ * @{
+ */
+
+typedef struct ModularNtt {
+    ModularMontgomery context;
+    size_t size; /**< Power of two dividing modulus - 1 */
+    uint32_t* roots; /**< roots[h + j] = w_2h^j for h = 1, 2, ..., size / 2 (Montgomery form) */
+    uint32_t* inverse_roots; /**< The same for w_2h^-j */
+    uint32_t scale; /**< size^-1 in Montgomery form */
+} ModularNtt;
+
+/**
+ * @return false if `modulus` is not an odd prime below MODULAR_LIMIT, `size` is not a power of
+ * two dividing modulus - 1, or allocation fails.
+ */
+bool modular_ntt_create(ModularNtt* ntt, uint32_t modulus, size_t size);
+
+void modular_ntt_free(ModularNtt* ntt);
+
+/**
+ * @brief In place; `values` holds `size` residues in natural order, then in bit-reversed order.
+ */
+void modular_ntt_forward(const ModularNtt* ntt, uint32_t* values);
+
+/**
+ * @brief In place; bit-reversed order in, natural order out, scaled by size^-1.
+ */
+void modular_ntt_inverse(const ModularNtt* ntt, uint32_t* values);
+
+/**
+ * @brief Linear convolution mod `modulus`: output[k] = sum a[i] * b[k - i], for
+ * a_count + b_count - 1 outputs.
+ *
+ * Inputs need not be reduced. Short operands are multiplied directly; the rest go through an NTT
+ * of the next power of two, which must divide modulus - 1 (see the NTT-friendly primes above).
+ *
+ * @return false if the modulus is unsuitable or allocation fails; `output` is then untouched.
+ */
+bool modular_convolve(
+    const uint32_t* a,
+    size_t a_count,
+    const uint32_t* b,
+    size_t b_count,
+    uint32_t* output,
+    uint32_t modulus
+);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_MODULAR_H
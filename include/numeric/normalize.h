@@ -0,0 +1,130 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file include/numeric/normalize.h
+ * @brief RMSNorm and LayerNorm over fp32, fp16 and bf16 rows.
+ *
+ * For a row x of n elements, a weight w and a bias b:
+ *
+ *   RMSNorm:   y_i = x_i / sqrt(Σ x_j^2 / n + ε) · w_i
+ *   LayerNorm: y_i = (x_i - μ) / sqrt(σ^2 + ε) · w_i + b_i
+ *
+ * where μ = Σ x_j / n and σ^2 = Σ (x_j - μ)^2 / n.
+ *
+ * Each row is read twice: one pass gathers the statistics and a second applies the scale, weight
+ * and bias as it writes. LayerNorm gathers Σ (x_j - x_0) and Σ (x_j - x_0)^2 in its single
+ * statistics pass. Shifting by the row's first element keeps the variance from cancelling away
+ * on rows far from zero, which the textbook E[x^2] - E[x]^2 does not.
+ *
+ * fp16 and bf16 rows are widened a tile at a time into an fp32 buffer that stays in L1, run
+ * through the same fp32 kernels and narrowed on the way out with the row conversions of
+ * numeric/type.h. Weights and biases are always fp32. Either may be NULL, meaning 1 and 0.
+ *
+ * The kernels have scalar, SSE2 and AVX2 paths chosen by the active CPU level (AVX-512 runs the
+ * AVX2 kernels). They sum in different orders, so levels agree to rounding rather than bit for
+ * bit. `input` and `output` may be the same row (in-place operation). `length` must be nonzero
+ * and `epsilon` non-negative.
+ */
+
+#ifndef NUMERIC_NORMALIZE_H
+#define NUMERIC_NORMALIZE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "core/thread.h"
+#include "numeric/type.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @name Rows
+ * @{
+ */
+
+void normalize_rms(
+    const float* input, float* output, const float* weight, size_t length, float epsilon
+);
+
+void normalize_rms_fp16(
+    const uint16_t* input, uint16_t* output, const float* weight, size_t length, float epsilon
+);
+
+void normalize_rms_bf16(
+    const uint16_t* input, uint16_t* output, const float* weight, size_t length, float epsilon
+);
+
+void normalize_layer(
+    const float* input,
+    float* output,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float epsilon
+);
+
+void normalize_layer_fp16(
+    const uint16_t* input,
+    uint16_t* output,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float epsilon
+);
+
+void normalize_layer_bf16(
+    const uint16_t* input,
+    uint16_t* output,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float epsilon
+);
+
+/** @} */
+
+/**
+ * @name Batches
+ *
+ * `rows` rows of `length` elements of `type`, stored back to back, each normalized on its own
+ * with the shared weight and bias. Rows are spread over the thread pool (NULL runs on the
+ * caller); every row is computed the same way whichever thread takes it, so the result does not
+ * depend on the pool.
+ *
+ * @return False unless `type` is TYPE_FLOAT32, TYPE_FLOAT16 or TYPE_BFLOAT16.
+ * @{
+ */
+
+bool normalize_rms_rows(
+    ThreadPool* pool,
+    DataTypeId type,
+    const void* input,
+    void* output,
+    const float* weight,
+    size_t rows,
+    size_t length,
+    float epsilon
+);
+
+bool normalize_layer_rows(
+    ThreadPool* pool,
+    DataTypeId type,
+    const void* input,
+    void* output,
+    const float* weight,
+    const float* bias,
+    size_t rows,
+    size_t length,
+    float epsilon
+);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_NORMALIZE_H
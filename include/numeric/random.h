@@ -0,0 +1,136 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/numeric/random.h
+ * @brief Seedable, splittable pseudo-random generators with explicit state.
+ *
+ * Unlike `numeric/lehmer.h`, every generator here lives in a caller-owned `Random`, so a worker
+ * can carry its own stream and results are reproducible however work is scheduled.
+ *
+ * | Kind                 | Period          | Jump        | Long jump   | Streams             |
+ * |----------------------|-----------------|-------------|-------------|---------------------|
+ * | RANDOM_XOSHIRO256    | 2^256 - 1       | 2^128 draws | 2^192 draws | `stream` jumps      |
+ * | RANDOM_PCG64         | 2^128 / stream  | 2^64 draws  | 2^96 draws  | 2^127 increments    |
+ * | RANDOM_PHILOX        | 2^128 blocks    | 2^32 blocks | 2^48 blocks | 2^64 blocks apart   |
+ *
+ * - xoshiro256** (Blackman & Vigna): 256 bits of state, one 64-bit output per step.
+ * - PCG64 (O'Neill), XSL-RR output over a 128-bit LCG; identical to pcg-c's pcg64_random_r.
+ * - Philox4x32-10 (Salmon et al., Random123): a keyed bijection of a 128-bit counter, giving
+ *   four 32-bit words per counter value (a "block"). Blocks are independent, so bulk fills
+ *   compute several at once in SIMD registers and jumps are counter additions.
+ *
+ * Draws are defined per kind so that single calls and bulk fills give the same sequence: the
+ * 64-bit generators emit the top half of a 64-bit draw for each u32, and Philox joins two
+ * consecutive words (low word first) for each u64. Floats take the top 24 bits of a u32 draw
+ * and doubles the top 53 bits of a u64 draw, so both lie in [0, 1).
+ *
+ * @warning Not suitable for cryptographic purposes.
+ */
+
+#ifndef NUMERIC_RANDOM_H
+#define NUMERIC_RANDOM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum RandomKind {
+    RANDOM_XOSHIRO256, /**< xoshiro256** */
+    RANDOM_PCG64, /**< PCG XSL-RR 128/64 */
+    RANDOM_PHILOX, /**< Philox4x32-10 */
+    RANDOM_KIND_COUNT /**< Number of generators */
+} RandomKind;
+
+typedef struct RandomXoshiro {
+    uint64_t s[4];
+} RandomXoshiro;
+
+typedef struct RandomPcg {
+    uint64_t state[2]; /**< 128-bit LCG state, low word first */
+    uint64_t increment[2]; /**< Odd 128-bit increment selecting the stream */
+} RandomPcg;
+
+typedef struct RandomPhilox {
+    uint32_t key[2];
+    uint64_t counter[2]; /**< Next block to compute, low word first */
+    uint32_t buffer[4]; /**< Current block */
+    uint32_t index; /**< Next unused word of `buffer`; 4 when empty */
+} RandomPhilox;
+
+/**
+ * @brief A generator of any kind; copy it to fork the sequence.
+ */
+typedef struct Random {
+    RandomKind kind;
+    union {
+        RandomXoshiro xoshiro;
+        RandomPcg pcg;
+        RandomPhilox philox;
+    };
+} Random;
+
+/**
+ * @name Seeding
+ * @{
+ */
+
+/**
+ * @brief Seeds stream 0 of `kind`.
+ */
+void random_seed(Random* random, RandomKind kind, uint64_t seed);
+
+/**
+ * @brief Seeds stream `stream` of `kind`; see the table above for how streams are separated.
+ *
+ * The same (kind, seed, stream) always gives the same sequence, so worker `i` of a parallel job
+ * can take stream `i` and get results that do not depend on the thread count. xoshiro streams
+ * cost `stream` jumps to set up; the others are O(1).
+ */
+void random_stream(Random* random, RandomKind kind, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Advances by the kind's jump distance, as if that many draws were taken.
+ */
+void random_jump(Random* random);
+
+/**
+ * @brief Advances by the kind's long-jump distance.
+ */
+void random_long_jump(Random* random);
+
+/** @} */
+
+/**
+ * @name Draws
+ * @{
+ */
+
+uint32_t random_u32(Random* random);
+uint64_t random_u64(Random* random);
+float random_float(Random* random); /**< Uniform in [0, 1) with 24 random bits */
+double random_double(Random* random); /**< Uniform in [0, 1) with 53 random bits */
+
+/** @} */
+
+/**
+ * @name Bulk Fills
+ *
+ * Each fill continues the sequence exactly as `length` single draws would.
+ * @{
+ */
+
+void random_fill_u32(Random* random, uint32_t* output, size_t length);
+void random_fill_u64(Random* random, uint64_t* output, size_t length);
+void random_fill_float(Random* random, float* output, size_t length);
+void random_fill_double(Random* random, double* output, size_t length);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_RANDOM_H
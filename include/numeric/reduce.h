@@ -0,0 +1,148 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file include/numeric/reduce.h
+ * @brief Reductions and prefix scans over fp32 rows.
+ *
+ * A running fp32 sum loses about one rounding per element, so its error grows with the row
+ * length and a long row of small terms can stop growing altogether once the sum dwarfs them.
+ * Every sum here takes a ReduceMode that picks how much of that error to pay down:
+ *
+ * - REDUCE_NAIVE keeps independent partial sums in each vector lane and folds them at the end.
+ *   It is the fastest and its error still grows linearly, though divided by the lane count.
+ * - REDUCE_PAIRWISE sums blocks of REDUCE_BLOCK elements naively and adds the block sums as a
+ *   balanced tree, so the error grows with log2 of the number of blocks.
+ * - REDUCE_KAHAN carries the rounding error of every addition in a second accumulator
+ *   (TwoSum, error-free), so the error stays near one rounding of the total whatever the length.
+ *   Products in a dot product are still rounded once each before they are added.
+ *
+ * For prefix scans, REDUCE_PAIRWISE restarts the running sum every REDUCE_BLOCK elements and adds
+ * a block offset, which bounds the chain of roundings behind any one output; REDUCE_KAHAN also
+ * compensates the offsets.
+ *
+ * Lanes, blocks and the CPU level change the order of additions, so levels agree to rounding, not
+ * bit for bit. The parallel versions split the row into contiguous ranges of at least
+ * REDUCE_GRAIN elements, reduce each range on its own and combine the partials in range order.
+ * The split depends only on the length and the pool size (see core/thread.h), so a fixed thread
+ * count always gives the same result, and a NULL pool gives the serial result.
+ *
+ * Extrema skip NaN. A row holding only NaN has NaN as its minimum and maximum and index 0 as its
+ * argmin and argmax. Ties resolve to the first index, at every level and thread count.
+ */
+
+#ifndef NUMERIC_REDUCE_H
+#define NUMERIC_REDUCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "core/thread.h"
+
+#include <stddef.h>
+
+#define REDUCE_BLOCK 256 // elements per naive leaf of a pairwise sum or per scan block
+#define REDUCE_GRAIN 16384 // elements per thread range, at least
+
+typedef enum ReduceMode {
+    REDUCE_NAIVE,
+    REDUCE_PAIRWISE,
+    REDUCE_KAHAN,
+} ReduceMode;
+
+/**
+ * @name Reductions
+ *
+ * An empty row sums to 0.
+ * @{
+ */
+
+float reduce_sum(const float* x, size_t length, ReduceMode mode);
+
+float reduce_dot(const float* x, const float* y, size_t length, ReduceMode mode);
+
+/**
+ * @brief Σ |x_i|.
+ */
+float reduce_norm_l1(const float* x, size_t length, ReduceMode mode);
+
+/**
+ * @brief sqrt(Σ x_i^2). The squares are summed in fp32, so elements beyond about 1.8e19 in
+ * magnitude overflow to infinity.
+ */
+float reduce_norm_l2(const float* x, size_t length, ReduceMode mode);
+
+/**
+ * @brief Mean and population variance Σ (x_i - mean)^2 / length, in two passes.
+ *
+ * The second pass sums squared deviations from the computed mean rather than subtracting
+ * squares of large sums, so rows far from zero keep their variance. `length` must be nonzero.
+ */
+void reduce_moments(const float* x, size_t length, ReduceMode mode, float* mean, float* variance);
+
+/** @} */
+
+/**
+ * @name Extrema
+ *
+ * `length` must be nonzero.
+ * @{
+ */
+
+float reduce_min(const float* x, size_t length);
+float reduce_max(const float* x, size_t length);
+size_t reduce_argmin(const float* x, size_t length);
+size_t reduce_argmax(const float* x, size_t length);
+
+/** @} */
+
+/**
+ * @name Prefix Scans
+ *
+ * Inclusive: output[i] = x_0 + ... + x_i. Exclusive: output[i] = x_0 + ... + x_(i - 1), with
+ * output[0] = 0. `output` may be `x` (in-place operation).
+ * @{
+ */
+
+void reduce_scan_inclusive(const float* x, float* output, size_t length, ReduceMode mode);
+void reduce_scan_exclusive(const float* x, float* output, size_t length, ReduceMode mode);
+
+/** @} */
+
+/**
+ * @name Parallel Reductions
+ *
+ * The functions above over the ranges of `pool`. Scans take two passes: range totals first,
+ * then each range is scanned from the sum of the totals before it.
+ * @{
+ */
+
+float reduce_sum_parallel(ThreadPool* pool, const float* x, size_t length, ReduceMode mode);
+float reduce_dot_parallel(
+    ThreadPool* pool, const float* x, const float* y, size_t length, ReduceMode mode
+);
+float reduce_norm_l1_parallel(ThreadPool* pool, const float* x, size_t length, ReduceMode mode);
+float reduce_norm_l2_parallel(ThreadPool* pool, const float* x, size_t length, ReduceMode mode);
+void reduce_moments_parallel(
+    ThreadPool* pool, const float* x, size_t length, ReduceMode mode, float* mean, float* variance
+);
+
+float reduce_min_parallel(ThreadPool* pool, const float* x, size_t length);
+float reduce_max_parallel(ThreadPool* pool, const float* x, size_t length);
+size_t reduce_argmin_parallel(ThreadPool* pool, const float* x, size_t length);
+size_t reduce_argmax_parallel(ThreadPool* pool, const float* x, size_t length);
+
+void reduce_scan_inclusive_parallel(
+    ThreadPool* pool, const float* x, float* output, size_t length, ReduceMode mode
+);
+void reduce_scan_exclusive_parallel(
+    ThreadPool* pool, const float* x, float* output, size_t length, ReduceMode mode
+);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_REDUCE_H
@@ -0,0 +1,174 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file include/numeric/sparse.h
+ *
+ * @brief Sparse matrices in CSR, CSC and blocked-CSR form, with SpMV and SpMM over fp32.
+ *
+ * | Format     | offsets          | indices                 | values                         |
+ * |------------|------------------|-------------------------|--------------------------------|
+ * | SPARSE_CSR | rows + 1         | column of each value    | row by row                     |
+ * | SPARSE_CSC | cols + 1         | row of each value       | column by column               |
+ * | SPARSE_BSR | block rows + 1   | block column of a block | dense blocks, row-major inside |
+ *
+ * Indices are sorted within each row (or column) and fit in 31 bits, as the gathers read them
+ * as signed lanes. A blocked-CSR (BSR) matrix stores every block of `block_rows` x `block_cols`
+ * elements that holds at least one kept value, zeros included, so its products run dense inner
+ * loops over the block and need one index per block rather than one per value.
+ *
+ * Values may be stored in any of TYPE_FLOAT32, TYPE_FLOAT16, TYPE_BFLOAT16, TYPE_FLOAT8_E4M3 and
+ * TYPE_FLOAT8_E5M2, and a BSR matrix whose blocks are a whole number of BLOCK_SIZE columns wide
+ * may also use TYPE_BLOCK_Q8 or TYPE_BLOCK_Q4, each block row then quantized as one block row.
+ * Narrow values are widened in registers or in small L1-resident tiles, never as a whole matrix.
+ * For the block formats `x` is quantized to Q8 once per SpMV, as in matrix_gemv(), and the
+ * products use the numeric/dot integer kernels.
+ *
+ * SpMV with CSR gathers `x` through the column indices (AVX2 and AVX512 gathers); SpMM adds
+ * scaled rows of the dense operand, so its inner loop is a contiguous AXPY. Work is split over
+ * the thread pool by row ranges. CSR and BSR balance the ranges by stored values, CSC by rows,
+ * each thread searching every column for its own rows. Every output row is computed by one
+ * thread in a fixed order, so results do not depend on the thread count; CPU levels agree to
+ * rounding. A NULL pool runs on the caller.
+ */
+
+#ifndef NUMERIC_SPARSE_H
+#define NUMERIC_SPARSE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "core/thread.h"
+#include "numeric/type.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum SparseFormat {
+    SPARSE_CSR, /**< Compressed sparse rows */
+    SPARSE_CSC, /**< Compressed sparse columns */
+    SPARSE_BSR, /**< Compressed sparse rows of dense blocks */
+} SparseFormat;
+
+/**
+ * @brief A sparse matrix of `rows` x `cols` elements. Build with one of the sparse_*_from_dense()
+ * functions and release with sparse_free().
+ */
+typedef struct SparseMatrix {
+    SparseFormat format; /**< Layout of offsets, indices and values */
+    DataTypeId type; /**< Storage type of the values */
+    size_t rows; /**< Rows of the matrix */
+    size_t cols; /**< Columns of the matrix */
+    size_t block_rows; /**< Rows per block (1 for CSR and CSC) */
+    size_t block_cols; /**< Columns per block (1 for CSR and CSC) */
+    size_t count; /**< Stored values for CSR and CSC, stored blocks for BSR */
+    size_t stride; /**< Bytes per stored value or block */
+    size_t* offsets; /**< Start of each row, column or block row in `indices`, plus the end */
+    uint32_t* indices; /**< Column, row or block column of each stored value or block */
+    void* values; /**< `count` values or blocks of `type` */
+} SparseMatrix;
+
+/**
+ * @name Builders
+ *
+ * Each builder reads a row-major fp32 matrix with leading dimension `ld` and keeps the elements
+ * whose magnitude is greater than `threshold` (0 keeps every nonzero), along with every NaN, so
+ * products propagate it as the dense ones do. An existing matrix is not freed first. On failure
+ * nothing is allocated and `matrix` is zeroed.
+ * @{
+ */
+
+/**
+ * @return False for an unsupported value type, dimensions past INT32_MAX or a failed allocation.
+ */
+bool sparse_csr_from_dense(
+    SparseMatrix* matrix,
+    DataTypeId type,
+    const float* dense,
+    size_t rows,
+    size_t cols,
+    size_t ld,
+    float threshold
+);
+
+/**
+ * @return False for an unsupported value type, dimensions past INT32_MAX or a failed allocation.
+ */
+bool sparse_csc_from_dense(
+    SparseMatrix* matrix,
+    DataTypeId type,
+    const float* dense,
+    size_t rows,
+    size_t cols,
+    size_t ld,
+    float threshold
+);
+
+/**
+ * @brief Keeps every `block_rows` x `block_cols` block holding an element above `threshold`.
+ *
+ * @return False unless `rows` and `cols` are multiples of the block shape, and for the same
+ *         reasons as the other builders. Block formats also need `block_cols` to be a multiple
+ *         of BLOCK_SIZE.
+ */
+bool sparse_bsr_from_dense(
+    SparseMatrix* matrix,
+    DataTypeId type,
+    const float* dense,
+    size_t rows,
+    size_t cols,
+    size_t ld,
+    float threshold,
+    size_t block_rows,
+    size_t block_cols
+);
+
+/**
+ * @brief Releases the arrays of `matrix` and zeroes it. Accepts NULL and zeroed matrices.
+ */
+void sparse_free(SparseMatrix* matrix);
+
+/**
+ * @brief Writes `matrix` to a row-major fp32 matrix with leading dimension `ld`, zeros included.
+ */
+void sparse_to_dense(const SparseMatrix* matrix, float* dense, size_t ld);
+
+/** @} */
+
+/**
+ * @name Products
+ * @{
+ */
+
+/**
+ * @brief y = A · x for `x` of A.cols elements and `y` of A.rows elements.
+ *
+ * `y` is overwritten and must not alias `x`.
+ *
+ * @return False if the Q8 copy of `x` cannot be allocated.
+ */
+bool sparse_spmv(ThreadPool* pool, const SparseMatrix* a, const float* x, float* y);
+
+/**
+ * @brief C = A · B for a dense row-major B (A.cols x n) and C (A.rows x n).
+ *
+ * C is overwritten and must not alias B.
+ */
+void sparse_spmm(
+    ThreadPool* pool,
+    const SparseMatrix* a,
+    const float* b,
+    size_t ldb,
+    float* c,
+    size_t ldc,
+    size_t n
+);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_SPARSE_H
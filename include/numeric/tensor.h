@@ -0,0 +1,229 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/numeric/tensor.h
+ *
+ * @brief N-dimensional tensors over DataType with zero-copy views.
+ *
+ * A Tensor is a small value type: a data pointer, an element type, a shape and per-axis strides
+ * counted in elements. Slicing, transposing, reshaping and broadcasting only rewrite the shape
+ * and strides, so a view shares its parent's storage and must not outlive it. Only a tensor
+ * returned by tensor_create() owns its storage; copying the struct yields another view.
+ *
+ * Storage is 64-byte aligned and comes from a TensorAllocator, which defaults to memory_alloc().
+ * Rows of packed types (block formats and TYPE_QUANT4) are padded to whole storage units, so
+ * their last axis always has stride 1 and views may not split a unit: the last axis cannot be
+ * moved, broadcast or sliced off a unit boundary.
+ *
+ * The kernels at the end take views directly. Rows whose last axis has stride 1 go straight to
+ * the row kernels; anything else is gathered into a small buffer first.
+ */
+
+#ifndef NUMERIC_TENSOR_H
+#define NUMERIC_TENSOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "allocator/arena.h"
+#include "core/thread.h"
+#include "numeric/activation.h"
+#include "numeric/type.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TENSOR_RANK_MAX 8 /**< Axes per tensor */
+#define TENSOR_ALIGNMENT 64 /**< Alignment of tensor storage in bytes */
+
+/**
+ * @brief Source of tensor storage.
+ *
+ * `free` may be NULL for allocators that release memory in bulk, such as arenas.
+ */
+typedef struct TensorAllocator {
+    void* (*alloc)(void* context, size_t size, size_t alignment);
+    void (*free)(void* context, void* pointer);
+    void* context;
+} TensorAllocator;
+
+typedef struct Tensor {
+    void* data; /**< First element */
+    DataTypeId type; /**< Element type */
+    size_t rank; /**< Number of axes */
+    size_t shape[TENSOR_RANK_MAX]; /**< Elements along each axis */
+    size_t stride[TENSOR_RANK_MAX]; /**< Elements between neighbours along each axis */
+    void* storage; /**< Owned allocation, or NULL for views */
+    TensorAllocator allocator; /**< Releases `storage` */
+} Tensor;
+
+/**
+ * @name Allocators
+ * @{
+ */
+
+/**
+ * @brief memory_alloc() and memory_free().
+ */
+TensorAllocator tensor_allocator_default(void);
+
+/**
+ * @brief Allocates from `arena`; memory comes back when the arena is reset or freed.
+ */
+TensorAllocator tensor_allocator_arena(Arena* arena);
+
+/** @} */
+
+/**
+ * @name Lifetime
+ * @{
+ */
+
+/**
+ * @brief Allocates a zeroed, contiguous tensor.
+ *
+ * @param allocator NULL selects tensor_allocator_default().
+ * @return False for an invalid type or rank, or if the allocation fails.
+ */
+bool tensor_create(
+    Tensor* tensor,
+    DataTypeId type,
+    size_t rank,
+    const size_t* shape,
+    const TensorAllocator* allocator
+);
+
+/**
+ * @brief Views an existing contiguous buffer laid out as tensor_create() would lay it out.
+ */
+Tensor tensor_wrap(void* data, DataTypeId type, size_t rank, const size_t* shape);
+
+/**
+ * @brief Releases an owning tensor's storage. Views are left alone.
+ */
+void tensor_free(Tensor* tensor);
+
+/** @} */
+
+/**
+ * @name Queries
+ * @{
+ */
+
+/**
+ * @brief Number of elements.
+ */
+size_t tensor_count(const Tensor* tensor);
+
+/**
+ * @brief True if the elements are laid out exactly as tensor_create() lays them out.
+ *
+ * Axes of length 1 are ignored, since their stride is never used.
+ */
+bool tensor_is_contiguous(const Tensor* tensor);
+
+/**
+ * @brief Address of the element at `index` (one coordinate per axis).
+ *
+ * For packed types this is the storage unit holding the element.
+ */
+void* tensor_at(const Tensor* tensor, const size_t* index);
+
+/** @} */
+
+/**
+ * @name Views
+ *
+ * Each returns false, leaving `view` untouched, if the arguments are out of range or the view
+ * would need a copy. `view` may be the source tensor itself; an owning source then loses
+ * ownership, so keep the owner separate.
+ * @{
+ */
+
+/**
+ * @brief Elements begin, begin + step, ... before end along `axis`.
+ */
+bool tensor_slice(
+    const Tensor* tensor, size_t axis, size_t begin, size_t end, size_t step, Tensor* view
+);
+
+/**
+ * @brief Swaps two axes.
+ */
+bool tensor_transpose(const Tensor* tensor, size_t axis0, size_t axis1, Tensor* view);
+
+/**
+ * @brief Reorders all axes: axis `i` of the view is axis `axes[i]` of the tensor.
+ */
+bool tensor_permute(const Tensor* tensor, const size_t* axes, Tensor* view);
+
+/**
+ * @brief Same elements in row-major order under a new shape.
+ *
+ * Succeeds whenever each group of merged or split axes is contiguous within itself, which
+ * covers every contiguous tensor. Packed types must keep their last axis.
+ */
+bool tensor_reshape(const Tensor* tensor, size_t rank, const size_t* shape, Tensor* view);
+
+/**
+ * @brief Broadcasts to `shape` with NumPy rules: axes are matched from the right, and axes of
+ * length 1 or missing ones repeat with stride 0.
+ */
+bool tensor_broadcast(const Tensor* tensor, size_t rank, const size_t* shape, Tensor* view);
+
+/** @} */
+
+/**
+ * @name Kernels
+ * @{
+ */
+
+/**
+ * @brief Copies `input` into `output`, converting between any two types (numeric/convert.h).
+ *
+ * Shapes must match; broadcast `input` first to repeat it. Outer axes that collapse into one
+ * strided axis are handed to convert_rows() in a single call.
+ */
+bool tensor_convert(ThreadPool* pool, const Tensor* input, Tensor* output);
+
+/**
+ * @brief Elementwise activation of fp32, fp16 or bf16 tensors of the same shape and type.
+ */
+bool tensor_activate(ActivationFunction function, const Tensor* input, Tensor* output);
+
+/**
+ * @brief Softmax with temperature along the last axis of fp32 tensors of the same shape.
+ *
+ * Rows are spread over the pool; a single row is split inside activate_softmax_parallel().
+ * A strided last axis is gathered into one row buffer per thread.
+ *
+ * @return False for mismatched shapes or types, a non-positive temperature, or when the row
+ *         buffers cannot be allocated; `output` is then left untouched.
+ */
+bool tensor_softmax(ThreadPool* pool, const Tensor* input, Tensor* output, float temperature);
+
+/**
+ * @brief C = A · B for 2D fp32 tensors.
+ *
+ * A, B and C may be any views; operands whose last axis is not unit-stride (a transposed
+ * view, say) are packed into a contiguous copy first. C must have a unit-stride last axis.
+ *
+ * @return False on mismatched shapes or types, or if memory runs out.
+ */
+bool tensor_gemm(ThreadPool* pool, const Tensor* a, const Tensor* b, Tensor* c);
+
+/**
+ * @brief y = W · x for a 2D weight tensor of any matrix_gemv() type and 1D fp32 x and y.
+ *
+ * W's rows must be stored back to back, as tensor_create() stores them.
+ */
+bool tensor_gemv(ThreadPool* pool, const Tensor* w, const Tensor* x, Tensor* y);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_TENSOR_H
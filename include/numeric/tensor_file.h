@@ -0,0 +1,167 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/numeric/tensor_file.h
+ *
+ * @brief Memory-mapped tensor container for zero-copy loading.
+ *
+ * A tensor file is a fixed header, a table of fixed-size entries and a data section:
+ *
+ * | Part    | Contents                                                          |
+ * |---------|-------------------------------------------------------------------|
+ * | header  | magic, version, entry count, data offset and size                 |
+ * | entries | name, DataTypeId, rank, shape, offset and size of each tensor     |
+ * | data    | raw tensor bytes as tensor_create() lays them out, each 64-aligned |
+ *
+ * All integers are little-endian. Opening a file maps it read-only and checks only the header,
+ * so startup costs the same for a kilobyte and for many gigabytes; each entry is validated when
+ * it is first looked up, and its pages are read in by the kernel when they are first touched.
+ * Tensors handed out point straight into the mapping: they are views that must not be written
+ * to and must not outlive the file.
+ */
+
+#ifndef NUMERIC_TENSOR_FILE_H
+#define NUMERIC_TENSOR_FILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "numeric/tensor.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TENSOR_FILE_MAGIC 0x46544141u /**< "AATF" read as a little-endian uint32 */
+#define TENSOR_FILE_VERSION 1u /**< Format version written and accepted */
+#define TENSOR_FILE_NAME_MAX 64 /**< Bytes per name, including the terminating NUL */
+
+/**
+ * @brief Possible outcomes for tensor file operations.
+ */
+typedef enum TensorFileState {
+    TENSOR_FILE_SUCCESS, /**< Operation completed. */
+    TENSOR_FILE_ERROR_ARGUMENT, /**< Invalid path, name or tensor. */
+    TENSOR_FILE_ERROR_MEMORY, /**< Packing a strided tensor ran out of memory. */
+    TENSOR_FILE_ERROR_IO, /**< Open, stat, map or write failure. */
+    TENSOR_FILE_ERROR_FORMAT /**< Bad magic, version or header bounds. */
+} TensorFileState;
+
+/**
+ * @brief Access pattern hint applied to the whole mapping with madvise().
+ */
+typedef enum TensorFileAdvice {
+    TENSOR_FILE_ADVICE_NORMAL, /**< Kernel default readahead. */
+    TENSOR_FILE_ADVICE_SEQUENTIAL, /**< One pass front to back, e.g. streaming a dataset. */
+    TENSOR_FILE_ADVICE_WILLNEED /**< Start reading everything now, e.g. model weights. */
+} TensorFileAdvice;
+
+/**
+ * @brief On-disk header.
+ */
+typedef struct TensorFileHeader {
+    uint32_t magic; /**< TENSOR_FILE_MAGIC */
+    uint32_t version; /**< TENSOR_FILE_VERSION */
+    uint64_t count; /**< Number of entries */
+    uint64_t data_offset; /**< Start of the data section, a multiple of TENSOR_ALIGNMENT */
+    uint64_t data_size; /**< Bytes in the data section */
+} TensorFileHeader;
+
+/**
+ * @brief On-disk table entry, directly after the header.
+ */
+typedef struct TensorFileEntry {
+    char name[TENSOR_FILE_NAME_MAX]; /**< NUL-terminated and NUL-padded */
+    uint32_t type; /**< DataTypeId */
+    uint32_t rank; /**< Number of axes, at most TENSOR_RANK_MAX */
+    uint64_t shape[TENSOR_RANK_MAX]; /**< Elements along each axis; unused axes are 0 */
+    uint64_t offset; /**< From the data section, a multiple of TENSOR_ALIGNMENT */
+    uint64_t size; /**< Bytes of tensor data */
+} TensorFileEntry;
+
+static_assert(sizeof(TensorFileHeader) == 32, "TensorFileHeader must have no padding");
+static_assert(sizeof(TensorFileEntry) == 152, "TensorFileEntry must have no padding");
+
+/**
+ * @brief An open, mapped tensor file.
+ */
+typedef struct TensorFile {
+    const uint8_t* map; /**< Whole file, read-only */
+    size_t size; /**< Bytes mapped */
+    const TensorFileHeader* header;
+    const TensorFileEntry* entries;
+    const uint8_t* data; /**< Start of the data section */
+} TensorFile;
+
+/**
+ * @brief A named tensor to write.
+ */
+typedef struct TensorFileItem {
+    const char* name; /**< Shorter than TENSOR_FILE_NAME_MAX */
+    const Tensor* tensor; /**< Any view; strided views are packed while writing */
+} TensorFileItem;
+
+/**
+ * @name Writing
+ * @{
+ */
+
+/**
+ * @brief Writes `items` to `path`, creating or truncating it.
+ *
+ * @return TENSOR_FILE_SUCCESS, or an error state; a failed write leaves a partial file.
+ */
+TensorFileState tensor_file_write(const char* path, const TensorFileItem* items, size_t count);
+
+/** @} */
+
+/**
+ * @name Reading
+ * @{
+ */
+
+/**
+ * @brief Maps `path` and validates its header. Entries are validated on lookup.
+ */
+TensorFileState tensor_file_open(TensorFile* file, const char* path, TensorFileAdvice advice);
+
+/**
+ * @brief Unmaps the file. Tensors taken from it become invalid.
+ */
+void tensor_file_close(TensorFile* file);
+
+/**
+ * @brief Number of entries.
+ */
+size_t tensor_file_count(const TensorFile* file);
+
+/**
+ * @brief Name of entry `index`, or NULL if out of range or not NUL-terminated.
+ */
+const char* tensor_file_name(const TensorFile* file, size_t index);
+
+/**
+ * @brief Validates entry `index` and points `tensor` at its data.
+ *
+ * @return False, leaving `tensor` untouched, if the entry is out of range or malformed.
+ */
+bool tensor_file_get(const TensorFile* file, size_t index, Tensor* tensor);
+
+/**
+ * @brief Looks up an entry by name (a linear scan of the table) and points `tensor` at it.
+ */
+bool tensor_file_find(const TensorFile* file, const char* name, Tensor* tensor);
+
+/**
+ * @brief Asks the kernel to start reading a tensor's pages (MADV_WILLNEED).
+ */
+void tensor_file_prefetch(const TensorFile* file, const Tensor* tensor);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // NUMERIC_TENSOR_FILE_H
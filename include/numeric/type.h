@@ -6,7 +6,7 @@
  * @brief API for numeric data types and conversions.
  *
  * Features:
- * - Single and half-precision floating-point support.
+ * - Single, half and 8-bit (FP8 E4M3/E5M2) floating-point support.
  * - 8-bit and 4-bit quantized integer support.
  * - Minimal dependencies with a consistent, extensible design.
  */
@@ -38,6 +38,10 @@ extern "C" {
 #define Q8_ELEMENTS BLOCK_SIZE /**< Elements in an 8-bit quantized block */
 #define Q4_NIBBLES (BLOCK_SIZE / 2) /**< Nibbles in a 4-bit quantized block */
 
+// Largest finite 8-bit floating-point values
+#define FP8_E4M3_MAX 448.0f /**< S.1111.110 */
+#define FP8_E5M2_MAX 57344.0f /**< S.11110.11 */
+
 // Union for floating-point bit manipulation
 typedef union FloatBits {
     float value; /**< Floating-point value */
@@ -56,6 +60,30 @@ typedef QuantBits Q4; /**< 4-bit quantization */
 typedef QuantBits Q8Row[Q8_ELEMENTS]; /**< Array of 8-bit quantized values */
 typedef QuantBits Q4Row[Q4_NIBBLES]; /**< Array of 4-bit quantized values */
 
+/**
+ * Block quantization: one fp16 scale per BLOCK_SIZE elements.
+ *
+ * - Q8: `x = quants[i] * scale`, with `scale = max|x| / 127`.
+ * - Q4: `x = (nibble - 8) * scale`, with `scale = m / -8` where `m` is the element of largest
+ *   magnitude, so that element maps exactly to nibble 0. Element `i < 16` is the low nibble of
+ *   `nibbles[i]` and element `i + 16` the high nibble.
+ *
+ * A row of `n` elements occupies `ceil(n / BLOCK_SIZE)` blocks; a partial last block is padded
+ * with zeros.
+ */
+typedef struct BlockQ8 {
+    uint16_t scale; /**< fp16 step size */
+    int8_t quants[BLOCK_SIZE]; /**< Signed steps */
+} BlockQ8;
+
+typedef struct BlockQ4 {
+    uint16_t scale; /**< fp16 step size */
+    uint8_t nibbles[Q4_NIBBLES]; /**< Biased 4-bit steps, two per byte */
+} BlockQ4;
+
+static_assert(sizeof(BlockQ8) == 2 + BLOCK_SIZE, "BlockQ8 must be packed (34 bytes)");
+static_assert(sizeof(BlockQ4) == 2 + BLOCK_SIZE / 2, "BlockQ4 must be packed (18 bytes)");
+
 // Supported data types
 typedef enum DataTypeId {
     TYPE_FLOAT32, /**< 32-bit floating-point (IEEE-754) */
@@ -71,6 +99,10 @@ typedef enum DataTypeId {
     TYPE_UINT8, /**< 8-bit unsigned integer */
     TYPE_BOOL, /**< Boolean */
     TYPE_CHAR, /**< 1-byte character */
+    TYPE_BLOCK_Q8, /**< 8-bit blocks of BLOCK_SIZE elements with one fp16 scale */
+    TYPE_BLOCK_Q4, /**< 4-bit blocks of BLOCK_SIZE elements with one fp16 scale */
+    TYPE_FLOAT8_E4M3, /**< 8-bit floating-point, 4-bit exponent (OCP FP8 E4M3) */
+    TYPE_FLOAT8_E5M2, /**< 8-bit floating-point, 5-bit exponent (OCP FP8 E5M2) */
     TYPE_COUNT /**< Total number of types */
 } DataTypeId;
 
@@ -88,6 +120,7 @@ typedef struct DataType {
     uint32_t size; /**< Size in bytes */
     DataTypeSign sign; /**< Signed/unsigned status */
     DataTypeId id; /**< Unique identifier */
+    uint32_t block; /**< Elements per `size` bytes for packed types (0 for scalar types) */
 } DataType;
 
 // Static array of supported types
@@ -98,7 +131,7 @@ static const DataType TYPES[TYPE_COUNT] = {
     [TYPE_BFLOAT16]
     = {"bfloat16", alignof(uint16_t), sizeof(uint16_t), TYPE_IS_UNSIGNED, TYPE_BFLOAT16},
     [TYPE_QUANT8] = {"qint8", alignof(Q8), sizeof(Q8), TYPE_NOT_APPLICABLE, TYPE_QUANT8},
-    [TYPE_QUANT4] = {"qint4", alignof(Q4), sizeof(Q4), TYPE_NOT_APPLICABLE, TYPE_QUANT4},
+    [TYPE_QUANT4] = {"qint4", alignof(Q4), sizeof(Q4), TYPE_NOT_APPLICABLE, TYPE_QUANT4, 2},
     [TYPE_INT32] = {"int32", alignof(int32_t), sizeof(int32_t), TYPE_IS_SIGNED, TYPE_INT32},
     [TYPE_INT16] = {"int16", alignof(int16_t), sizeof(int16_t), TYPE_IS_SIGNED, TYPE_INT16},
     [TYPE_INT8] = {"int8", alignof(int8_t), sizeof(int8_t), TYPE_IS_SIGNED, TYPE_INT8},
@@ -107,12 +140,24 @@ static const DataType TYPES[TYPE_COUNT] = {
     [TYPE_UINT8] = {"uint8", alignof(uint8_t), sizeof(uint8_t), TYPE_IS_UNSIGNED, TYPE_UINT8},
     [TYPE_BOOL] = {"bool", alignof(bool), sizeof(bool), TYPE_NOT_APPLICABLE, TYPE_BOOL},
     [TYPE_CHAR] = {"char", alignof(char), sizeof(char), TYPE_IS_UNSIGNED, TYPE_CHAR},
+    [TYPE_BLOCK_Q8] = {
+        "block_q8", alignof(BlockQ8), sizeof(BlockQ8), TYPE_NOT_APPLICABLE, TYPE_BLOCK_Q8, BLOCK_SIZE
+    },
+    [TYPE_BLOCK_Q4] = {
+        "block_q4", alignof(BlockQ4), sizeof(BlockQ4), TYPE_NOT_APPLICABLE, TYPE_BLOCK_Q4, BLOCK_SIZE
+    },
+    [TYPE_FLOAT8_E4M3]
+    = {"float8_e4m3", alignof(uint8_t), sizeof(uint8_t), TYPE_IS_UNSIGNED, TYPE_FLOAT8_E4M3},
+    [TYPE_FLOAT8_E5M2]
+    = {"float8_e5m2", alignof(uint8_t), sizeof(uint8_t), TYPE_IS_UNSIGNED, TYPE_FLOAT8_E5M2},
 };
 
 // Data type management
 const DataType* data_type_get(DataTypeId id); /**< Retrieve metadata by type ID */
 uint32_t data_type_size(DataTypeId id); /**< Get size of type by ID */
 const char* data_type_name(DataTypeId id); /**< Get name of type by ID */
+uint32_t data_type_block(DataTypeId id); /**< Elements per storage unit (1 for scalar types) */
+size_t data_type_row_size(DataTypeId id, size_t length); /**< Bytes needed for `length` elements */
 
 // Scalar conversions
 
@@ -128,6 +173,24 @@ float dequantize_scalar_fp16(uint16_t bits); /**< Dequantize 16-bit to 32-bit fl
 uint16_t quantize_scalar_bf16(float value); /**< Quantize 32-bit float to 16-bit */
 float dequantize_scalar_bf16(uint16_t bits); /**< Dequantize 16-bit to 32-bit float */
 
+/**
+ * 8-bit floating-point (OCP FP8)
+ *
+ * - E4M3: exponent bias 7 and no infinities; S.1111.111 is NaN. Largest finite value 448,
+ *   smallest subnormal 2^-9.
+ * - E5M2: exponent bias 15 with IEEE-754 infinities and NaNs, i.e. the top byte of an fp16.
+ *   Largest finite value 57344, smallest subnormal 2^-16.
+ *
+ * Encoding rounds to nearest even and saturates: a finite value beyond the largest finite one
+ * becomes it, keeping its sign. Infinity saturates the same way in E4M3, which cannot hold it,
+ * and stays infinite in E5M2. NaN becomes 0x7F (E4M3) or 0x7E (E5M2) with its sign. Decoding is
+ * exact and looks the value up in a 256-entry table; NaNs decode quiet, as vcvtph2ps does.
+ */
+uint8_t quantize_scalar_e4m3(float value); /**< Quantize 32-bit float to FP8 E4M3 */
+float dequantize_scalar_e4m3(uint8_t bits); /**< Dequantize FP8 E4M3 to 32-bit float */
+uint8_t quantize_scalar_e5m2(float value); /**< Quantize 32-bit float to FP8 E5M2 */
+float dequantize_scalar_e5m2(uint8_t bits); /**< Dequantize FP8 E5M2 to 32-bit float */
+
 // 8-bit integer quantization
 Q8 quantize_scalar_q8(float value); /**< Quantize 32-bit float to 8-bit */
 float dequantize_scalar_q8(Q8 q8); /**< Dequantize 8-bit to 32-bit float */
@@ -137,7 +200,7 @@ Q4 quantize_scalar_q4(float a, float b); /**< Quantize two floats to 4-bit */
 float dequantize_scalar_q4_index(Q4 q4, uint32_t index); /**< Dequantize by index */
 void dequantize_scalar_q4_reference(Q4 q4, float* a, float* b); /**< Dequantize to references */
 
-// Supports 32, 16, and 8-bit formats. Q4 is excluded.
+// Supports 32, 16, and 8-bit formats, FP8 included. Q4 is excluded.
 bool quantize_scalar(const float input, void* output, DataTypeId id);
 bool dequantize_scalar(const void* input, float* output, DataTypeId id);
 
@@ -151,6 +214,33 @@ void dequantize_row_fp16(const uint16_t* input, float* output, size_t length);
 void quantize_row_bf16(const float* input, uint16_t* output, size_t length);
 void dequantize_row_bf16(const uint16_t* input, float* output, size_t length);
 
+/**
+ * 8-bit floating-point rows. The plain forms are bit-exact with the scalar codecs at every CPU
+ * level. The scaled forms keep `x ≈ decode(q) * scale`: quantizing encodes `x * (1 / scale)`,
+ * with the reciprocal rounded once per row (so a value next to a rounding midpoint may encode
+ * differently than `x / scale` would), and dequantizing multiplies by `scale` after decoding.
+ * `scale` must be finite and at least FLT_MIN, as quantize_row_scale_*() return, so that its
+ * reciprocal is finite. fp16 rows go through convert_row() (numeric/convert.h), which
+ * widens them exactly in L1-sized tiles, so they encode as their fp32 values would.
+ */
+void quantize_row_e4m3(const float* input, uint8_t* output, size_t length);
+void dequantize_row_e4m3(const uint8_t* input, float* output, size_t length);
+void quantize_row_e5m2(const float* input, uint8_t* output, size_t length);
+void dequantize_row_e5m2(const uint8_t* input, float* output, size_t length);
+
+void quantize_row_e4m3_scaled(const float* input, uint8_t* output, size_t length, float scale);
+void dequantize_row_e4m3_scaled(const uint8_t* input, float* output, size_t length, float scale);
+void quantize_row_e5m2_scaled(const float* input, uint8_t* output, size_t length, float scale);
+void dequantize_row_e5m2_scaled(const uint8_t* input, float* output, size_t length, float scale);
+
+/**
+ * The scale that maps the largest finite magnitude of `input` onto the format's largest finite
+ * value, so a scaled row uses the whole range without saturating. NaN and infinity are skipped;
+ * a row without a non-zero finite value gets 1.
+ */
+float quantize_row_scale_e4m3(const float* input, size_t length);
+float quantize_row_scale_e5m2(const float* input, size_t length);
+
 // 8-bit integer quantization
 void quantize_row_q8(const float* input, Q8Row output, size_t length);
 void dequantize_row_q8(const Q8Row input, float* output, size_t length);
@@ -159,10 +249,35 @@ void dequantize_row_q8(const Q8Row input, float* output, size_t length);
 void quantize_row_q4(const float* input, Q4Row output, size_t length);
 void dequantize_row_q4(const Q4Row input, float* output, size_t length);
 
-// Supports 32, 16, and 8-bit formats. Q4 is excluded.
+// Block quantization; `output`/`input` hold ceil(length / BLOCK_SIZE) blocks
+void quantize_row_block_q8(const float* input, BlockQ8* output, size_t length);
+void dequantize_row_block_q8(const BlockQ8* input, float* output, size_t length);
+void quantize_row_block_q4(const float* input, BlockQ4* output, size_t length);
+void dequantize_row_block_q4(const BlockQ4* input, float* output, size_t length);
+
+// Supports every type; shorthands for convert_row() to and from fp32 (see numeric/convert.h).
 bool quantize_row(const float* input, void* output, size_t length, DataTypeId id);
 bool dequantize_row(const void* input, float* output, size_t length, DataTypeId id);
 
+// Round-trip error
+
+/**
+ * Error of quantizing then dequantizing a row.
+ */
+typedef struct QuantizeError {
+    double max_abs; /**< Largest absolute error */
+    double rmse; /**< Root mean square error */
+    double relative_rmse; /**< RMSE divided by the RMS of the input (0 for an all-zero input) */
+    size_t bytes; /**< Storage used by the quantized row */
+} QuantizeError;
+
+/**
+ * Quantizes `input` to `id` and back, and reports the error and the storage used.
+ *
+ * @return False if `id` is not a DataTypeId or memory runs out.
+ */
+bool quantize_row_error(const float* input, size_t length, DataTypeId id, QuantizeError* error);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -0,0 +1,114 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/sort/external.h
+ * @brief External merge sort for fixed-size record files larger than memory.
+ *
+ * The sort runs in two phases:
+ * - Run generation: the input is consumed in chunks bounded by the memory budget, each chunk is
+ *   sorted in memory and spilled to an anonymous temporary file (a "run").
+ * - Merging: runs are merged `fan_in` at a time with a loser tree until a single run remains,
+ *   which is written to the output path.
+ *
+ * All file access is large and sequential. Each stream is double buffered, and a background
+ * thread per stream prefetches (readers) or drains (writers) the idle buffer while the caller
+ * sorts or merges, so reading, merging and writing overlap.
+ *
+ * @note Records are opaque, fixed-size byte blobs. The input size must be a multiple of the
+ * record size.
+ */
+
+#ifndef SORT_EXTERNAL_H
+#define SORT_EXTERNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Default memory budget for run generation and merging (256 MiB).
+ */
+#ifndef EXTERNAL_SORT_MEMORY_BUDGET
+    #define EXTERNAL_SORT_MEMORY_BUDGET ((size_t) 1 << 28)
+#endif
+
+/**
+ * @brief Default size of a single sequential I/O buffer (1 MiB).
+ */
+#ifndef EXTERNAL_SORT_IO_BUFFER
+    #define EXTERNAL_SORT_IO_BUFFER ((size_t) 1 << 20)
+#endif
+
+/**
+ * @brief Default maximum number of runs merged in a single pass.
+ */
+#ifndef EXTERNAL_SORT_FAN_IN
+    #define EXTERNAL_SORT_FAN_IN 64
+#endif
+
+/**
+ * @brief Possible outcomes for external sort operations.
+ */
+typedef enum ExternalSortState {
+    EXTERNAL_SORT_SUCCESS, /**< Output file is fully sorted. */
+    EXTERNAL_SORT_ERROR_ARGUMENT, /**< Invalid configuration or path. */
+    EXTERNAL_SORT_ERROR_MEMORY, /**< Buffer allocation failed. */
+    EXTERNAL_SORT_ERROR_IO, /**< Read, write, map or temporary file failure. */
+    EXTERNAL_SORT_ERROR_FORMAT /**< Input size is not a multiple of the record size. */
+} ExternalSortState;
+
+/**
+ * @brief Record comparison function.
+ *
+ * Same contract as `qsort`: negative, zero or positive for less, equal or greater.
+ */
+typedef int (*ExternalSortCompare)(const void* a, const void* b);
+
+/**
+ * @brief Tunables for an external sort.
+ */
+typedef struct ExternalSortConfig {
+    ExternalSortCompare compare; /**< Record comparison function. */
+    size_t record_size; /**< Size of a single record in bytes. */
+    size_t memory_budget; /**< Upper bound on buffer memory in bytes. */
+    size_t io_buffer_size; /**< Size of one sequential I/O buffer in bytes. */
+    size_t fan_in; /**< Maximum number of runs merged per pass (>= 2). */
+    const char* temp_dir; /**< Directory for runs (NULL uses $TMPDIR or /tmp). */
+    bool use_mmap; /**< Map the input file instead of reading it. */
+    bool use_direct_io; /**< Bypass the page cache with O_DIRECT where supported. */
+    bool use_threads; /**< Overlap I/O with sorting and merging. */
+} ExternalSortConfig;
+
+/**
+ * @brief Returns a configuration populated with the default tunables.
+ *
+ * @param record_size Size of a single record in bytes.
+ * @param compare Record comparison function.
+ * @return Default configuration.
+ */
+ExternalSortConfig external_sort_config(size_t record_size, ExternalSortCompare compare);
+
+/**
+ * @brief Sorts the records in `input_path` and writes them to `output_path`.
+ *
+ * Memory use is bounded by `config->memory_budget`. The effective fan-in is the smaller of
+ * `config->fan_in` and the number of double-buffered readers that fit in the budget. Records
+ * that compare equal are emitted in run order, so the merge itself never reorders ties.
+ *
+ * @param input_path Path to the unsorted record file.
+ * @param output_path Path to the sorted record file (created or truncated).
+ * @param config Sort configuration.
+ * @return EXTERNAL_SORT_SUCCESS on success, an error state otherwise.
+ */
+ExternalSortState external_sort_file(
+    const char* input_path, const char* output_path, const ExternalSortConfig* config
+);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // SORT_EXTERNAL_H
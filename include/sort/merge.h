@@ -0,0 +1,71 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/sort/merge.h
+ * @brief Stable, adaptive natural merge sort (timsort-style) for fixed-size records.
+ *
+ * The input is scanned for existing runs (non-descending, or strictly descending and reversed
+ * in place); short runs are extended with binary insertion sort. Runs are merged under the
+ * timsort stack invariants, and merges switch to galloping (exponential search) when one side
+ * keeps winning, so presorted, reversed and append-mostly inputs cost close to O(n).
+ *
+ * Merging uses a scratch buffer sized to the shorter run. When that would exceed the buffer
+ * limit, the merge is split by rotation until the pieces fit, so a bounded (even empty) buffer
+ * still sorts stably, just with more element moves.
+ */
+
+#ifndef SORT_MERGE_H
+#define SORT_MERGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+
+/**
+ * @brief Record comparison function.
+ *
+ * Same contract as `qsort`: negative, zero or positive for less, equal or greater.
+ */
+typedef int (*MergeSortCompare)(const void* a, const void* b);
+
+/**
+ * @brief Stably sorts `count` records of `size` bytes.
+ *
+ * Allocates a scratch buffer of at most `count / 2` records on demand. If that allocation
+ * fails the sort degrades to rotation merges instead of failing.
+ *
+ * @param base Array to sort.
+ * @param count Number of records.
+ * @param size Size of a single record in bytes.
+ * @param compare Record comparison function.
+ */
+void merge_sort(void* base, size_t count, size_t size, MergeSortCompare compare);
+
+/**
+ * @brief Stably sorts `count` records of `size` bytes using a caller-provided buffer.
+ *
+ * Never allocates. Merges whose shorter side exceeds `buffer_size` bytes are split by rotation.
+ *
+ * @param base Array to sort.
+ * @param count Number of records.
+ * @param size Size of a single record in bytes.
+ * @param compare Record comparison function.
+ * @param buffer Scratch memory (may be NULL if `buffer_size` is 0).
+ * @param buffer_size Size of `buffer` in bytes.
+ */
+void merge_sort_buffer(
+    void* base,
+    size_t count,
+    size_t size,
+    MergeSortCompare compare,
+    void* buffer,
+    size_t buffer_size
+);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // SORT_MERGE_H
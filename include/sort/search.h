@@ -0,0 +1,119 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/sort/search.h
+ * @brief Cache-friendly static search layouts for sorted `int32_t` arrays.
+ *
+ * Binary search over a plain sorted array touches a new cache line on nearly every level. Both
+ * layouts here are built once from a sorted array and answer lower/upper bound queries with the
+ * rank the key would have in that array, so they are drop-in replacements for repeated lookups:
+ * - Eytzinger: the keys in BFS order of an implicit binary tree. The descent is branchless, and
+ *   the 16 great-grandchildren four levels down share one cache line, which is prefetched.
+ * - S-tree: an implicit static B-tree with 16 keys (one cache line) per node. Each node is
+ *   resolved with a single SIMD compare-and-count, so a query costs about log17(n) misses.
+ *
+ * @note Ranks are `uint32_t`, so inputs are limited to `UINT32_MAX - 1` keys.
+ */
+
+#ifndef SORT_SEARCH_H
+#define SORT_SEARCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Keys per S-tree node; 16 `int32_t` fill one 64-byte cache line.
+#define SEARCH_TREE_BLOCK 16
+
+/**
+ * @brief Sorted keys in Eytzinger (BFS) order.
+ */
+typedef struct SearchEytzinger {
+    int32_t* keys; /**< 1-based tree of `count` keys; slot 0 is unused. */
+    uint32_t* ranks; /**< Rank of each key in the source array, parallel to `keys`. */
+    size_t count; /**< Number of keys. */
+} SearchEytzinger;
+
+/**
+ * @brief Sorted keys in an implicit static B-tree of SEARCH_TREE_BLOCK keys per node.
+ *
+ * Node `k` has children `k * (SEARCH_TREE_BLOCK + 1) + i + 1` for `i` in [0, SEARCH_TREE_BLOCK].
+ * The last node is padded with `INT32_MAX`, whose rank is `count`.
+ */
+typedef struct SearchTree {
+    int32_t* keys; /**< `blocks * SEARCH_TREE_BLOCK` keys, cache-line aligned. */
+    uint32_t* ranks; /**< Rank of each key in the source array, parallel to `keys`. */
+    size_t blocks; /**< Number of nodes. */
+    size_t count; /**< Number of keys. */
+} SearchTree;
+
+/**
+ * @name Eytzinger Layout
+ * @{
+ */
+
+/**
+ * @brief Builds an Eytzinger layout from a sorted array.
+ *
+ * @param sorted Keys in non-decreasing order (may be NULL if `count` is 0).
+ * @param count Number of keys.
+ * @return New layout, or NULL on allocation failure or if `count` is too large.
+ */
+SearchEytzinger* search_eytzinger_create(const int32_t* sorted, size_t count);
+
+/**
+ * @brief Frees an Eytzinger layout.
+ */
+void search_eytzinger_free(SearchEytzinger* tree);
+
+/**
+ * @brief Rank of the first key not less than `key`, or `count` if there is none.
+ */
+size_t search_eytzinger_lower_bound(const SearchEytzinger* tree, int32_t key);
+
+/**
+ * @brief Rank of the first key greater than `key`, or `count` if there is none.
+ */
+size_t search_eytzinger_upper_bound(const SearchEytzinger* tree, int32_t key);
+
+/** @} */
+
+/**
+ * @name S-tree Layout
+ * @{
+ */
+
+/**
+ * @brief Builds an implicit static B-tree from a sorted array.
+ *
+ * @param sorted Keys in non-decreasing order (may be NULL if `count` is 0).
+ * @param count Number of keys.
+ * @return New tree, or NULL on allocation failure or if `count` is too large.
+ */
+SearchTree* search_tree_create(const int32_t* sorted, size_t count);
+
+/**
+ * @brief Frees an S-tree.
+ */
+void search_tree_free(SearchTree* tree);
+
+/**
+ * @brief Rank of the first key not less than `key`, or `count` if there is none.
+ */
+size_t search_tree_lower_bound(const SearchTree* tree, int32_t key);
+
+/**
+ * @brief Rank of the first key greater than `key`, or `count` if there is none.
+ */
+size_t search_tree_upper_bound(const SearchTree* tree, int32_t key);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // SORT_SEARCH_H
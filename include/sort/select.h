@@ -0,0 +1,192 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/sort/select.h
+ * @brief Selection, partial sorting and index sorting for float score arrays.
+ *
+ * Sampling only needs the best few entries of a probability or logit vector, so fully sorting
+ * it is wasted work. This module provides:
+ * - Introselect (nth element) and partial sort, in place, with an O(n log n) worst case.
+ * - A streaming top-k heap whose input scan skips whole blocks below the current threshold.
+ * - Argpartition and argsort, which return index arrays and leave the scores untouched.
+ *
+ * @note Inputs must not contain NaN. Index arrays are `uint32_t`, so lengths are limited to
+ * `UINT32_MAX` elements.
+ */
+
+#ifndef SORT_SELECT_H
+#define SORT_SELECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Ordering for index-returning functions.
+ */
+typedef enum SelectOrder {
+    SELECT_ASCENDING, /**< Smallest value first. */
+    SELECT_DESCENDING /**< Largest value first. */
+} SelectOrder;
+
+/**
+ * @brief Streaming top-k accumulator.
+ *
+ * Holds the k largest values seen so far in a min-heap, so the root is the admission threshold
+ * for the next candidate.
+ */
+typedef struct SelectTopK {
+    float* values; /**< Heap of retained values. */
+    uint32_t* indices; /**< Source indices parallel to `values`. */
+    size_t capacity; /**< Number of values to retain (k). */
+    size_t count; /**< Number of values currently retained. */
+} SelectTopK;
+
+/**
+ * @name In-place Selection
+ * @{
+ */
+
+/**
+ * @brief Rearranges `data` so that `data[nth]` holds the value it would have if sorted.
+ *
+ * Every element before `nth` is less than or equal to it and every element after is greater
+ * than or equal to it.
+ *
+ * @param data Array to rearrange.
+ * @param length Number of elements.
+ * @param nth Position to place (must be < length).
+ * @return The value at `data[nth]`.
+ */
+float select_nth_float(float* data, size_t length, size_t nth);
+
+/**
+ * @brief Sorts the `k` smallest elements into `data[0..k)` in ascending order.
+ *
+ * The order of the remaining elements is unspecified.
+ *
+ * @param data Array to rearrange.
+ * @param length Number of elements.
+ * @param k Number of leading elements to sort (clamped to length).
+ */
+void select_partial_sort_float(float* data, size_t length, size_t k);
+
+/** @} */
+
+/**
+ * @name Streaming Top-K
+ * @{
+ */
+
+/**
+ * @brief Creates a top-k accumulator.
+ *
+ * @param k Number of values to retain (must be > 0).
+ * @return Pointer to the accumulator, or NULL on failure.
+ */
+SelectTopK* select_top_k_create(size_t k);
+
+/**
+ * @brief Frees a top-k accumulator.
+ *
+ * @param top Accumulator to free.
+ */
+void select_top_k_free(SelectTopK* top);
+
+/**
+ * @brief Empties a top-k accumulator for reuse.
+ *
+ * @param top Accumulator to reset.
+ */
+void select_top_k_reset(SelectTopK* top);
+
+/**
+ * @brief Feeds a block of values into the accumulator.
+ *
+ * Blocks must arrive in increasing index order. Ties are then resolved in favor of the
+ * earlier index, which lets the scan reject anything not strictly above the threshold.
+ *
+ * @param top Accumulator.
+ * @param data Values to consider.
+ * @param length Number of values.
+ * @param offset Index of `data[0]` in the overall stream.
+ */
+void select_top_k_push(SelectTopK* top, const float* data, size_t length, size_t offset);
+
+/**
+ * @brief Sorts the retained values in descending order and copies them out.
+ *
+ * The accumulator is left empty and can be reused for a new stream.
+ *
+ * @param top Accumulator.
+ * @param indices Output indices (may be NULL), at least `top->count` entries.
+ * @param values Output values (may be NULL), at least `top->count` entries.
+ * @return Number of entries written.
+ */
+size_t select_top_k_finish(SelectTopK* top, uint32_t* indices, float* values);
+
+/**
+ * @brief One-shot top-k over a full array.
+ *
+ * @param data Values to consider.
+ * @param length Number of values.
+ * @param k Number of values to retain.
+ * @param indices Output indices in descending value order (may be NULL).
+ * @param values Output values in descending order (may be NULL).
+ * @return Number of entries written (min(k, length)), or 0 on failure.
+ */
+size_t select_top_k_float(
+    const float* data, size_t length, size_t k, uint32_t* indices, float* values
+);
+
+/** @} */
+
+/**
+ * @name Index Selection
+ * @{
+ */
+
+/**
+ * @brief Computes an index permutation partitioned around position `kth`.
+ *
+ * After the call, `data[indices[kth]]` is the value that would be at `kth` if sorted in the
+ * requested order, entries before it come no later in that order and entries after come no
+ * earlier. `data` is not modified.
+ *
+ * @param data Values to partition.
+ * @param length Number of values.
+ * @param kth Position to place (must be < length).
+ * @param indices Output permutation of `length` entries.
+ * @param order Sort order.
+ * @return true on success, false on allocation failure or invalid arguments.
+ */
+bool select_argpartition_float(
+    const float* data, size_t length, size_t kth, uint32_t* indices, SelectOrder order
+);
+
+/**
+ * @brief Computes the stable sorting permutation of `data`.
+ *
+ * Uses an LSD radix sort over the order-preserving integer image of each float, so the cost
+ * is linear in `length`. Equal values keep their original relative order. `data` is not
+ * modified.
+ *
+ * @param data Values to sort.
+ * @param length Number of values.
+ * @param indices Output permutation of `length` entries.
+ * @param order Sort order.
+ * @return true on success, false on allocation failure or invalid arguments.
+ */
+bool select_argsort_float(const float* data, size_t length, uint32_t* indices, SelectOrder order);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // SORT_SELECT_H
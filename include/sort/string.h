@@ -0,0 +1,55 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/sort/string.h
+ * @brief Sorting of null-terminated byte strings (paths, tokens, UTF-8 text).
+ *
+ * Comparison sorts re-scan shared prefixes on every compare, which dominates the cost for path
+ * lists and token vocabularies. The routines here inspect each byte once per recursion level:
+ * - Multikey quicksort partitions on a single byte at a time, caching that byte per string so
+ *   the partition loop never dereferences string pointers.
+ * - MSD radix sort distributes on one byte per level, skips runs of levels where every string
+ *   shares the same byte, and can emit the longest-common-prefix (LCP) array for free.
+ *
+ * Order is plain unsigned byte order, identical to `strcmp`. For valid UTF-8 that is also
+ * code-point order, so no decoding or validation is done while sorting; validate once up front
+ * (e.g. with `utf8_raw_is_valid`) if the input is untrusted.
+ */
+
+#ifndef SORT_STRING_H
+#define SORT_STRING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Sorts strings with cached-character multikey quicksort.
+ *
+ * @param strings Array of string pointers to reorder.
+ * @param count Number of strings.
+ * @return true on success, false on allocation failure or invalid arguments.
+ */
+bool string_sort_multikey(char** strings, size_t count);
+
+/**
+ * @brief Sorts strings with an LCP-aware MSD radix sort.
+ *
+ * Small buckets are finished with multikey quicksort.
+ *
+ * @param strings Array of string pointers to reorder.
+ * @param count Number of strings.
+ * @param lcp Optional output of `count` entries: `lcp[i]` is the length of the common prefix of
+ * `strings[i - 1]` and `strings[i]` after sorting, and `lcp[0]` is 0. May be NULL.
+ * @return true on success, false on allocation failure or invalid arguments.
+ */
+bool string_sort_radix(char** strings, size_t count, size_t* lcp);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // SORT_STRING_H
@@ -0,0 +1,52 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file include/test/bench.h
+ * @brief Minimal wall-clock benchmarking helpers for C.
+ *
+ * Provides a monotonic clock and a uniform report line so benchmark executables under `bench/`
+ * print comparable timings and throughputs.
+ */
+
+#ifndef DSA_TEST_BENCH_H
+#define DSA_TEST_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+
+/**
+ * @brief Prevents the compiler from discarding a computed value.
+ *
+ * @param value Pointer to the value to keep alive.
+ */
+#define BENCH_KEEP(value) __asm__ volatile("" : : "g"(value) : "memory")
+
+/**
+ * @brief Returns the current monotonic time in seconds.
+ *
+ * @return Seconds since an arbitrary, fixed point in the past.
+ */
+double bench_now(void);
+
+/**
+ * @brief Prints a single benchmark result.
+ *
+ * Reports the mean time per iteration and the throughput of `work` units per iteration,
+ * scaled to K/M/G (e.g. `work` in bytes and `unit` "B" prints GB/s).
+ *
+ * @param label Name of the benchmark case.
+ * @param seconds Total elapsed time in seconds.
+ * @param iterations Number of iterations timed.
+ * @param work Units of work performed per iteration.
+ * @param unit Name of a unit of work (e.g. "B", "elem", "FLOP").
+ */
+void bench_print(const char* label, double seconds, size_t iterations, double work, const char* unit);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // DSA_TEST_BENCH_H
@@ -0,0 +1,160 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/core/cpu.c
+ * @brief Runtime CPU feature detection for selecting SIMD kernels.
+ */
+
+#include "core/cpu.h"
+
+#include <pthread.h>
+
+#if CPU_X86
+    #include <cpuid.h>
+#endif
+
+// Features each level may use; anything else is masked out when the level is lowered.
+static const uint32_t CPU_LEVEL_FEATURES[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = 0,
+    [CPU_LEVEL_SSE2] = CPU_FEATURE_SSE2 | CPU_FEATURE_SSE41 | CPU_FEATURE_POPCNT,
+    [CPU_LEVEL_AVX2] = CPU_FEATURE_SSE2 | CPU_FEATURE_SSE41 | CPU_FEATURE_POPCNT | CPU_FEATURE_AVX
+                       | CPU_FEATURE_F16C | CPU_FEATURE_FMA | CPU_FEATURE_AVX2
+                       | CPU_FEATURE_AVX_VNNI,
+    [CPU_LEVEL_AVX512] = UINT32_MAX,
+};
+
+static const char* CPU_LEVEL_NAME[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = "scalar",
+    [CPU_LEVEL_SSE2] = "sse2",
+    [CPU_LEVEL_AVX2] = "avx2",
+    [CPU_LEVEL_AVX512] = "avx512",
+};
+
+static pthread_once_t cpu_once = PTHREAD_ONCE_INIT;
+static uint32_t cpu_detected_features = 0;
+static CpuLevel cpu_detected_level = CPU_LEVEL_SCALAR;
+static int cpu_active_level = -1; // accessed atomically; -1 until detection has run
+static uint32_t cpu_masked_features = 0; // accessed atomically
+
+/**
+ * Private Functions
+ */
+
+#if CPU_X86
+// Extended control register 0: which register states the OS saves on context switch.
+static uint64_t cpu_xgetbv(void) {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t) edx << 32) | eax;
+}
+#endif
+
+static void cpu_detect(void) {
+    uint32_t features = 0;
+
+#if CPU_X86
+    unsigned eax, ebx, ecx, edx;
+    unsigned max_leaf = __get_cpuid_max(0, NULL);
+
+    if (max_leaf >= 1 && __get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        features |= (edx & bit_SSE2) ? CPU_FEATURE_SSE2 : 0;
+        features |= (ecx & bit_SSE4_1) ? CPU_FEATURE_SSE41 : 0;
+        features |= (ecx & bit_POPCNT) ? CPU_FEATURE_POPCNT : 0;
+
+        // AVX state (XMM + YMM) must be enabled by the OS before any VEX instruction is safe.
+        bool osxsave = ecx & bit_OSXSAVE;
+        uint64_t xcr0 = osxsave ? cpu_xgetbv() : 0;
+        bool ymm = (xcr0 & 0x6) == 0x6;
+        bool zmm = (xcr0 & 0xE6) == 0xE6; // adds opmask and both halves of ZMM
+
+        if (ymm && (ecx & bit_AVX)) {
+            features |= CPU_FEATURE_AVX;
+            features |= (ecx & bit_F16C) ? CPU_FEATURE_F16C : 0;
+            features |= (ecx & bit_FMA) ? CPU_FEATURE_FMA : 0;
+
+            if (max_leaf >= 7 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+                unsigned subleaves = eax;
+                features |= (ebx & bit_AVX2) ? CPU_FEATURE_AVX2 : 0;
+
+                if (zmm && (ebx & bit_AVX512F)) {
+                    features |= CPU_FEATURE_AVX512F;
+                    features |= (ebx & bit_AVX512BW) ? CPU_FEATURE_AVX512BW : 0;
+                    features |= (ebx & bit_AVX512DQ) ? CPU_FEATURE_AVX512DQ : 0;
+                    features |= (ebx & bit_AVX512VL) ? CPU_FEATURE_AVX512VL : 0;
+                    features |= (ecx & (1u << 11)) ? CPU_FEATURE_AVX512_VNNI : 0;
+                }
+
+                if (subleaves >= 1 && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+                    features |= (eax & (1u << 4)) ? CPU_FEATURE_AVX_VNNI : 0;
+                    if (features & CPU_FEATURE_AVX512F) {
+                        features |= (eax & (1u << 5)) ? CPU_FEATURE_AVX512_BF16 : 0;
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    const uint32_t avx2 = CPU_FEATURE_AVX2 | CPU_FEATURE_FMA | CPU_FEATURE_F16C;
+    const uint32_t avx512 = CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW | CPU_FEATURE_AVX512DQ
+                            | CPU_FEATURE_AVX512VL;
+
+    CpuLevel level = CPU_LEVEL_SCALAR;
+    if (features & CPU_FEATURE_SSE2) {
+        level = CPU_LEVEL_SSE2;
+        if ((features & avx2) == avx2) {
+            level = CPU_LEVEL_AVX2;
+            if ((features & avx512) == avx512) {
+                level = CPU_LEVEL_AVX512;
+            }
+        }
+    }
+
+    cpu_detected_features = features;
+    cpu_detected_level = level;
+    __atomic_store_n(&cpu_active_level, (int) level, __ATOMIC_RELEASE);
+}
+
+/**
+ * Public Functions
+ */
+
+uint32_t cpu_features(void) {
+    CpuLevel level = cpu_level(); // runs detection first
+    uint32_t masked = __atomic_load_n(&cpu_masked_features, __ATOMIC_ACQUIRE);
+    return cpu_detected_features & CPU_LEVEL_FEATURES[level] & ~masked;
+}
+
+bool cpu_has(uint32_t features) {
+    return (cpu_features() & features) == features;
+}
+
+CpuLevel cpu_level(void) {
+    int level = __atomic_load_n(&cpu_active_level, __ATOMIC_ACQUIRE);
+    if (level < 0) {
+        pthread_once(&cpu_once, cpu_detect);
+        level = __atomic_load_n(&cpu_active_level, __ATOMIC_ACQUIRE);
+    }
+    return (CpuLevel) level;
+}
+
+CpuLevel cpu_level_detected(void) {
+    pthread_once(&cpu_once, cpu_detect);
+    return cpu_detected_level;
+}
+
+bool cpu_level_set(CpuLevel level) {
+    if (level >= CPU_LEVEL_COUNT || level > cpu_level_detected()) {
+        return false;
+    }
+    __atomic_store_n(&cpu_active_level, (int) level, __ATOMIC_RELEASE);
+    return true;
+}
+
+void cpu_features_mask(uint32_t features) {
+    __atomic_store_n(&cpu_masked_features, features, __ATOMIC_RELEASE);
+}
+
+const char* cpu_level_name(CpuLevel level) {
+    return level < CPU_LEVEL_COUNT ? CPU_LEVEL_NAME[level] : "unknown";
+}
@@ -0,0 +1,208 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/core/thread.c
+ * @brief Fixed-size thread pool for data-parallel loops.
+ */
+
+#include "core/thread.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * Private Definitions
+ */
+
+typedef struct ThreadWorker {
+    pthread_t thread;
+    ThreadPool* pool;
+    size_t index; // Range index served by this worker (1-based; the caller serves 0)
+} ThreadWorker;
+
+struct ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t start; // Signals a new generation (or shutdown) to the workers
+    pthread_cond_t done; // Signals the caller when `pending` reaches zero
+    ThreadWorker* workers;
+    size_t size; // Threads including the caller
+
+    // Current loop, published under `lock` by bumping `generation`.
+    ThreadTask task;
+    void* context;
+    size_t count;
+    size_t grain;
+    size_t ranges; // Ranges in use for this loop (<= size)
+    size_t pending; // Worker ranges not yet finished
+    size_t generation;
+    bool quit;
+};
+
+/**
+ * Private Functions
+ */
+
+// Range `index` of `ranges`: equal shares of whole grains, the remainder spread from the front.
+static void thread_range(
+    size_t count, size_t grain, size_t ranges, size_t index, size_t* begin, size_t* end
+) {
+    size_t units = (count + grain - 1) / grain;
+    size_t share = units / ranges;
+    size_t extra = units % ranges;
+
+    size_t first = index * share + (index < extra ? index : extra);
+    size_t last = first + share + (index < extra ? 1 : 0);
+
+    *begin = first * grain < count ? first * grain : count;
+    *end = last * grain < count ? last * grain : count;
+}
+
+static void thread_run(ThreadPool* pool, size_t index) {
+    size_t begin, end;
+    thread_range(pool->count, pool->grain, pool->ranges, index, &begin, &end);
+    if (begin < end) {
+        pool->task(pool->context, begin, end, index);
+    }
+}
+
+static void* thread_worker_main(void* arg) {
+    ThreadWorker* worker = (ThreadWorker*) arg;
+    ThreadPool* pool = worker->pool;
+    size_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->quit) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+
+        if (worker->index >= pool->ranges) {
+            continue; // not needed for this loop
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+        thread_run(pool, worker->index);
+        pthread_mutex_lock(&pool->lock);
+
+        if (0 == --pool->pending) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/**
+ * Public Functions
+ */
+
+size_t thread_count_online(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t) n : 1;
+}
+
+ThreadPool* thread_pool_create(size_t threads) {
+    if (0 == threads) {
+        threads = thread_count_online();
+    }
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->workers = calloc(threads, sizeof(ThreadWorker));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Worker i serves range i; stop at the first failure so ranges stay dense.
+    pool->size = 1;
+    for (size_t i = 1; i < threads; i++) {
+        ThreadWorker* worker = &pool->workers[i - 1];
+        worker->pool = pool;
+        worker->index = i;
+        if (0 != pthread_create(&worker->thread, NULL, thread_worker_main, worker)) {
+            break;
+        }
+        pool->size++;
+    }
+
+    return pool;
+}
+
+void thread_pool_free(ThreadPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 1; i < pool->size; i++) {
+        pthread_join(pool->workers[i - 1].thread, NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t thread_pool_size(const ThreadPool* pool) {
+    return pool ? pool->size : 1;
+}
+
+void thread_pool_parallel_for(
+    ThreadPool* pool, size_t count, size_t grain, ThreadTask task, void* context
+) {
+    if (0 == count) {
+        return;
+    }
+    if (0 == grain) {
+        grain = 1;
+    }
+
+    size_t units = (count + grain - 1) / grain;
+    size_t ranges = thread_pool_size(pool);
+    ranges = units < ranges ? units : ranges;
+
+    if (1 == ranges) {
+        task(context, 0, count, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    pool->grain = grain;
+    pool->ranges = ranges;
+    pool->pending = ranges - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    thread_run(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
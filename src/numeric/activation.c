@@ -9,8 +9,19 @@
  * Covers basic functions (e.g., Sigmoid, ReLU) and advanced ones (e.g., GELU, SiLU).
  */
 
+#include "core/cpu.h"
 #include "numeric/activation.h"
 
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
 // Binary Step Activation Function
 float activate_binary_step(float x) {
     return x >= 0.0f ? 1.0f : 0.0f;
@@ -65,28 +76,1370 @@ float activate_gelu_approximation(float x) {
     return 0.5f * x * (1.0f + tanhf(SQRT_2_PI * (x + 0.044715f * x_cubed)));
 }
 
-// Computes the softmax function for a 1D array.
-void activate_softmax(const float* input, float* output, size_t length) {
-    assert(input != NULL && output != NULL);
-    assert(length > 0);
+/**
+ * Row Kernels
+ *
+ * exp(x) = 2^n * exp(r) with n = round(x / ln 2) and r = x - n ln 2 (Cody-Waite, |r| <= ln2 / 2),
+ * and a degree-7 polynomial for exp(r) (Cephes `expf`). 2^n is applied as two factors so the
+ * exponent field never overflows on the way to a subnormal result.
+ *
+ * Functions that multiply a tiny exp() by something else ask for exp(x) * 2^32 instead, so the
+ * factor stays normal and only the last multiply by 2^-32 rounds into the subnormal range.
+ *
+ * GELU uses Φ(x) = 0.5 + x g(x^2) for |x| <= 0.75. Above that, with a = |x|,
+ * a Φ(-a) = 0.5 exp(-a^2 / 2) M(1 / (1 + 0.3 a)), so GELU is x - that for x > 0 and its negation
+ * for x < 0. g and M are Chebyshev fits of the scaled erf and erfc (relative error near 1e-8);
+ * M tends to sqrt(2 / pi) and never cancels, unlike a fit of erfc alone. The exponent -a^2 / 2
+ * is formed in double and carried as hi + lo floats, since rounding it to fp32 alone would cost
+ * up to 2^-24 * a^2 / 2 relative error in the tail. The tanh form of GELU forms its sigmoid
+ * argument the same way.
+ */
+
+#define ACTIVATION_EXP_HI 88.8f // exp() overflows above ~88.72
+#define ACTIVATION_EXP_LO -120.0f // and rounds to zero below ~-103.97, even scaled by 2^32
+#define ACTIVATION_LOG2E 1.44269504088896341f
+#define ACTIVATION_LN2_HI 0.693359375f // 9 significant bits: n * LN2_HI is exact
+#define ACTIVATION_LN2_LO -2.12194440e-4f
+#define ACTIVATION_ROUND 0x1.8p23f // adding and subtracting rounds to an integer
+
+#define ACTIVATION_BIAS 32
+#define ACTIVATION_UNBIAS 0x1.0p-32f
+
+#define ACTIVATION_TANH_SMALL 0.625f // tanh polynomial below, exp() form above
+#define ACTIVATION_GELU_SMALL 0.75f // Φ polynomial at or below, erfc form above
+#define ACTIVATION_GELU_TAIL -15.0f // both GELUs round to -0 below -14.5
+#define ACTIVATION_GELU_A_SCALE 3.55555556f // t = x^2 / (0.75^2 / 2) - 1
+#define ACTIVATION_GELU_B_SCALE 3.20503139f // t = (s - mid) / half over s in [1/5.2, 1/1.225]
+#define ACTIVATION_GELU_B_SHIFT 1.6163522f
+#define ACTIVATION_GELU_S_MIN 0.192307692f // s at |x| = 14; M is not fitted beyond
+#define ACTIVATION_GELU_S_RATE 0.3f
+#define ACTIVATION_GELU_TANH_RATE 0.044715
+#define ACTIVATION_GELU_TANH_SCALE 0.79788456080286535588 // sqrt(2 / pi) in double
+
+static const float ACTIVATION_EXP_P[] = {
+    1.9875691500E-4f,
+    1.3981999507E-3f,
+    8.3334519073E-3f,
+    4.1665795894E-2f,
+    1.6666665459E-1f,
+    5.0000001201E-1f,
+};
+
+static const float ACTIVATION_TANH_P[] = {
+    -5.70498872745E-3f,
+    2.06390887954E-2f,
+    -5.37397155531E-2f,
+    1.33314422036E-1f,
+    -3.33332819422E-1f,
+};
+
+// g(t), highest power first.
+static const float ACTIVATION_GELU_A[] = {
+    -1.47675383e-08f,
+    6.443654e-07f,
+    -2.36855449e-05f,
+    0.000713851477f,
+    -0.0171990078f,
+    0.381005079f,
+};
+
+// M(t), highest power first.
+static const float ACTIVATION_GELU_B[] = {
+    9.00836596e-07f,
+    -5.54264852e-06f,
+    -1.53236269e-05f,
+    0.000102890779f,
+    0.000373745395f,
+    -0.00130660343f,
+    -0.0132041918f,
+    -0.0483462214f,
+    -0.103274316f,
+    -0.12220744f,
+    0.738230765f,
+};
+
+#define ACTIVATION_LENGTH(a) (sizeof(a) / sizeof((a)[0]))
+
+#define ACTIVATION_SOFTMAX_GRAIN 16384 // elements per thread chunk
+
+// Running max of z = x * scale and the sum of exp(z - max) over the elements seen so far.
+typedef struct ActivationSoftmax {
+    float max;
+    float sum;
+} ActivationSoftmax;
+
+// Starts at -FLT_MAX rather than -inf so max - new max is never -inf - (-inf).
+#define ACTIVATION_SOFTMAX_EMPTY ((ActivationSoftmax) {-FLT_MAX, 0.0f})
 
-    // Step 1: Find the maximum value for numerical stability
-    float max_val = input[0];
-    for (size_t i = 1; i < length; i++) {
-        if (input[i] > max_val) {
-            max_val = input[i];
+typedef void (*ActivationRow)(const float* input, float* output, size_t length);
+typedef ActivationSoftmax (*ActivationSoftmaxReduce)(
+    const float* input, size_t length, float scale
+);
+typedef void (*ActivationSoftmaxNormalize)(
+    const float* input, float* output, size_t length, float scale, float max, float factor
+);
+
+typedef void (*ActivationHalfRow)(const uint16_t* input, uint16_t* output, size_t length);
+
+typedef struct ActivationKernels {
+    ActivationRow exp;
+    ActivationRow relu;
+    ActivationRow sigmoid;
+    ActivationRow tanh;
+    ActivationRow silu;
+    ActivationRow gelu;
+    ActivationRow gelu_tanh;
+    ActivationSoftmaxReduce softmax_reduce; // online (max, sum) pass
+    ActivationSoftmaxNormalize softmax_normalize; // exp(x * scale - max) * factor
+    ActivationHalfRow fp16[ACTIVATION_COUNT]; // fused widen, activate, narrow
+    ActivationHalfRow bf16[ACTIVATION_COUNT];
+} ActivationKernels;
+
+// Scalar Kernels
+
+static inline float activation_pow2_scalar(int32_t n) {
+    uint32_t bits = (uint32_t) (n + 127) << 23;
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+// exp(x) * 2^bias
+static inline float activation_exp_scalar(float x, int32_t bias) {
+    if (isnan(x)) {
+        return x;
+    }
+    x = x > ACTIVATION_EXP_HI ? ACTIVATION_EXP_HI : x;
+    x = x < ACTIVATION_EXP_LO ? ACTIVATION_EXP_LO : x;
+
+    float n = (x * ACTIVATION_LOG2E + ACTIVATION_ROUND) - ACTIVATION_ROUND;
+    float r = x - n * ACTIVATION_LN2_HI;
+    r = r - n * ACTIVATION_LN2_LO;
+
+    float p = ACTIVATION_EXP_P[0];
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_EXP_P); i++) {
+        p = p * r + ACTIVATION_EXP_P[i];
+    }
+    float y = p * (r * r) + r + 1.0f;
+
+    int32_t k = (int32_t) n + bias;
+    int32_t k1 = k >> 1;
+    return y * activation_pow2_scalar(k1) * activation_pow2_scalar(k - k1);
+}
+
+// exp(hi + lo) * 2^bias for a double exponent w, clamped and split into two floats.
+static inline float activation_exp_split_scalar(double w, int32_t bias) {
+    w = w < (double) ACTIVATION_EXP_LO ? (double) ACTIVATION_EXP_LO : w;
+    float hi = (float) w;
+    float lo = (float) (w - (double) hi);
+    return activation_exp_scalar(hi, bias) * (1.0f + lo);
+}
+
+// The gated kernels return NaN unchanged, as the vector kernels do; otherwise its sign would be
+// whichever operand order the compiler picks for the final products.
+static inline float activation_sigmoid_scalar(float x) {
+    if (isnan(x)) {
+        return x;
+    }
+    float e = activation_exp_scalar(-fabsf(x), 0);
+    float r = 1.0f / (1.0f + e);
+    return x < 0.0f ? e * r : r;
+}
+
+static inline float activation_tanh_scalar(float x) {
+    float a = fabsf(x);
+    if (a < ACTIVATION_TANH_SMALL) {
+        float z = x * x;
+        float p = ACTIVATION_TANH_P[0];
+        for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_TANH_P); i++) {
+            p = p * z + ACTIVATION_TANH_P[i];
         }
+        return p * z * x + x;
     }
+    float e = activation_exp_scalar(a + a, 0);
+    return copysignf(1.0f - 2.0f / (e + 1.0f), x);
+}
 
-    // Step 2: Compute the exponentials and their sum
-    float sum = 0.0f;
+static inline float activation_silu_scalar(float x) {
+    if (isnan(x)) {
+        return x;
+    }
+    x = x < ACTIVATION_EXP_LO ? ACTIVATION_EXP_LO : x;
+    float e = activation_exp_scalar(-fabsf(x), ACTIVATION_BIAS);
+    float r = 1.0f / (1.0f + e * ACTIVATION_UNBIAS);
+    return x < 0.0f ? x * e * r * ACTIVATION_UNBIAS : x * r;
+}
+
+static inline float activation_gelu_scalar(float x) {
+    if (isnan(x)) {
+        return x;
+    }
+    x = x < ACTIVATION_GELU_TAIL ? ACTIVATION_GELU_TAIL : x;
+    float a = fabsf(x);
+
+    if (a <= ACTIVATION_GELU_SMALL) {
+        float t = x * x * ACTIVATION_GELU_A_SCALE - 1.0f;
+        float g = ACTIVATION_GELU_A[0];
+        for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_GELU_A); i++) {
+            g = g * t + ACTIVATION_GELU_A[i];
+        }
+        return x * (0.5f + x * g);
+    }
+
+    float e = activation_exp_split_scalar(-0.5 * (double) x * (double) x, ACTIVATION_BIAS);
+    float s = 1.0f / (1.0f + ACTIVATION_GELU_S_RATE * a);
+    s = s < ACTIVATION_GELU_S_MIN ? ACTIVATION_GELU_S_MIN : s;
+    float t = s * ACTIVATION_GELU_B_SCALE - ACTIVATION_GELU_B_SHIFT;
+    float m = ACTIVATION_GELU_B[0];
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_GELU_B); i++) {
+        m = m * t + ACTIVATION_GELU_B[i];
+    }
+    float c = 0.5f * e * m * ACTIVATION_UNBIAS; // |x| Φ(-|x|)
+    return x < 0.0f ? -c : x - c;
+}
+
+static inline float activation_gelu_tanh_scalar(float x) {
+    if (isnan(x)) {
+        return x;
+    }
+    x = x < ACTIVATION_GELU_TAIL ? ACTIVATION_GELU_TAIL : x;
+    double a = fabs((double) x);
+    double w = -2.0 * ACTIVATION_GELU_TANH_SCALE * a * (1.0 + ACTIVATION_GELU_TANH_RATE * a * a);
+    float e = activation_exp_split_scalar(w, ACTIVATION_BIAS);
+    float r = 1.0f / (1.0f + e * ACTIVATION_UNBIAS);
+    return x < 0.0f ? x * e * r * ACTIVATION_UNBIAS : x * r;
+}
+
+#define ACTIVATION_ROW_SCALAR(name, op) \
+    static void name(const float* input, float* output, size_t length) { \
+        for (size_t i = 0; i < length; i++) { \
+            output[i] = op(input[i]); \
+        } \
+    }
+
+static inline float activation_exp_unbiased_scalar(float x) {
+    return activation_exp_scalar(x, 0);
+}
+
+ACTIVATION_ROW_SCALAR(activation_exp_row_scalar, activation_exp_unbiased_scalar)
+ACTIVATION_ROW_SCALAR(activation_relu_row_scalar, activate_relu)
+ACTIVATION_ROW_SCALAR(activation_sigmoid_row_scalar, activation_sigmoid_scalar)
+ACTIVATION_ROW_SCALAR(activation_tanh_row_scalar, activation_tanh_scalar)
+ACTIVATION_ROW_SCALAR(activation_silu_row_scalar, activation_silu_scalar)
+ACTIVATION_ROW_SCALAR(activation_gelu_row_scalar, activation_gelu_scalar)
+ACTIVATION_ROW_SCALAR(activation_gelu_tanh_row_scalar, activation_gelu_tanh_scalar)
+
+// Half rows: one element at a time through the scalar conversions, never leaving registers.
+#define ACTIVATION_ROW_HALF_SCALAR(name, op, widen, narrow) \
+    static void name(const uint16_t* input, uint16_t* output, size_t length) { \
+        for (size_t i = 0; i < length; i++) { \
+            output[i] = narrow(op(widen(input[i]))); \
+        } \
+    }
+
+#define ACTIVATION_ROWS_HALF_SCALAR(function, op) \
+    ACTIVATION_ROW_HALF_SCALAR( \
+        activation_##function##_row_fp16_scalar, op, dequantize_scalar_fp16, quantize_scalar_fp16 \
+    ) \
+    ACTIVATION_ROW_HALF_SCALAR( \
+        activation_##function##_row_bf16_scalar, op, dequantize_scalar_bf16, quantize_scalar_bf16 \
+    )
+
+ACTIVATION_ROWS_HALF_SCALAR(relu, activate_relu)
+ACTIVATION_ROWS_HALF_SCALAR(sigmoid, activation_sigmoid_scalar)
+ACTIVATION_ROWS_HALF_SCALAR(tanh, activation_tanh_scalar)
+ACTIVATION_ROWS_HALF_SCALAR(silu, activation_silu_scalar)
+ACTIVATION_ROWS_HALF_SCALAR(gelu, activation_gelu_scalar)
+ACTIVATION_ROWS_HALF_SCALAR(gelu_tanh, activation_gelu_tanh_scalar)
+
+// Combines two partials over disjoint ranges.
+static ActivationSoftmax activation_softmax_merge(ActivationSoftmax a, ActivationSoftmax b) {
+    float max = a.max > b.max ? a.max : b.max;
+    float sum = a.sum * activation_exp_scalar(a.max - max, 0)
+                + b.sum * activation_exp_scalar(b.max - max, 0);
+    return (ActivationSoftmax) {max, sum};
+}
+
+// Folds the per-lane partials in lane order.
+static ActivationSoftmax activation_softmax_lanes(const float* max, const float* sum, size_t n) {
+    ActivationSoftmax state = ACTIVATION_SOFTMAX_EMPTY;
+    for (size_t i = 0; i < n; i++) {
+        state = activation_softmax_merge(state, (ActivationSoftmax) {max[i], sum[i]});
+    }
+    return state;
+}
+
+// Rescales once per block: the block max is found first, then its exponentials are summed and
+// added to the running sum with Kahan compensation (rows reach 10^5 - 10^6 elements).
+static ActivationSoftmax activation_softmax_reduce_scalar(
+    const float* input, size_t length, float scale
+) {
+    ActivationSoftmax state = ACTIVATION_SOFTMAX_EMPTY;
+    float carry = 0.0f;
+    for (size_t i = 0; i < length; i += 16) {
+        size_t n = length - i < 16 ? length - i : 16;
+
+        float block = -FLT_MAX;
+        for (size_t j = 0; j < n; j++) {
+            float z = input[i + j] * scale;
+            block = z > block ? z : block;
+        }
+        if (block > state.max) {
+            float rescale = activation_exp_scalar(state.max - block, 0);
+            state.sum *= rescale;
+            carry *= rescale;
+            state.max = block;
+        }
+
+        float sum = 0.0f;
+        for (size_t j = 0; j < n; j++) {
+            sum += activation_exp_scalar(input[i + j] * scale - state.max, 0);
+        }
+        float y = sum - carry;
+        float t = state.sum + y;
+        carry = (t - state.sum) - y;
+        state.sum = t;
+    }
+    return state;
+}
+
+static void activation_softmax_normalize_scalar(
+    const float* input, float* output, size_t length, float scale, float max, float factor
+) {
     for (size_t i = 0; i < length; i++) {
-        output[i] = expf(input[i] - max_val);
-        sum += output[i];
+        output[i] = activation_exp_scalar(input[i] * scale - max, 0) * factor;
     }
+}
 
-    // Step 3: Normalize the exponentials
+// log_softmax is a shift, so every level shares this loop.
+static void activation_log_softmax_shift(
+    const float* input, float* output, size_t length, float scale, float offset
+) {
     for (size_t i = 0; i < length; i++) {
-        output[i] /= sum;
+        output[i] = input[i] * scale - offset;
+    }
+}
+
+// SSE2 Kernels
+
+#if defined(__SSE2__)
+
+// Lanes of b where mask is set, else a.
+static inline __m128 activation_select_sse2(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+static inline __m128 activation_abs_sse2(__m128 x) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+}
+
+static inline __m128 activation_pow2_sse2(__m128i n) {
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+}
+
+// exp(x) * 2^bias; min/max take x second so NaN passes through the clamp.
+static inline __m128 activation_exp_sse2(__m128 x, int32_t bias) {
+    x = _mm_min_ps(_mm_set1_ps(ACTIVATION_EXP_HI), x);
+    x = _mm_max_ps(_mm_set1_ps(ACTIVATION_EXP_LO), x);
+
+    __m128 round = _mm_set1_ps(ACTIVATION_ROUND);
+    __m128 n = _mm_mul_ps(x, _mm_set1_ps(ACTIVATION_LOG2E));
+    n = _mm_sub_ps(_mm_add_ps(n, round), round);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(ACTIVATION_LN2_HI)));
+    r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(ACTIVATION_LN2_LO)));
+
+    __m128 p = _mm_set1_ps(ACTIVATION_EXP_P[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_EXP_P); i++) {
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(ACTIVATION_EXP_P[i]));
+    }
+    __m128 y = _mm_add_ps(_mm_mul_ps(p, _mm_mul_ps(r, r)), r);
+    y = _mm_add_ps(y, _mm_set1_ps(1.0f));
+
+    __m128i k = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(bias));
+    __m128i k1 = _mm_srai_epi32(k, 1);
+    y = _mm_mul_ps(y, activation_pow2_sse2(k1));
+    return _mm_mul_ps(y, activation_pow2_sse2(_mm_sub_epi32(k, k1)));
+}
+
+// exp(w) * 2^bias for exponents given as two double pairs (lanes 0-1 and 2-3).
+static inline __m128 activation_exp_split_sse2(__m128d w0, __m128d w1, int32_t bias) {
+    __m128d lo_clamp = _mm_set1_pd((double) ACTIVATION_EXP_LO);
+    w0 = _mm_max_pd(lo_clamp, w0);
+    w1 = _mm_max_pd(lo_clamp, w1);
+
+    __m128 h0 = _mm_cvtpd_ps(w0);
+    __m128 h1 = _mm_cvtpd_ps(w1);
+    __m128 l0 = _mm_cvtpd_ps(_mm_sub_pd(w0, _mm_cvtps_pd(h0)));
+    __m128 l1 = _mm_cvtpd_ps(_mm_sub_pd(w1, _mm_cvtps_pd(h1)));
+
+    __m128 e = activation_exp_sse2(_mm_movelh_ps(h0, h1), bias);
+    return _mm_mul_ps(e, _mm_add_ps(_mm_set1_ps(1.0f), _mm_movelh_ps(l0, l1)));
+}
+
+static inline __m128 activation_sigmoid_sse2(__m128 x) {
+    __m128 e = activation_exp_sse2(_mm_or_ps(x, _mm_set1_ps(-0.0f)), 0);
+    __m128 r = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_set1_ps(1.0f), e));
+    return activation_select_sse2(_mm_cmplt_ps(x, _mm_setzero_ps()), r, _mm_mul_ps(e, r));
+}
+
+static inline __m128 activation_tanh_sse2(__m128 x) {
+    __m128 a = activation_abs_sse2(x);
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 p = _mm_set1_ps(ACTIVATION_TANH_P[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_TANH_P); i++) {
+        p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(ACTIVATION_TANH_P[i]));
+    }
+    __m128 small = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), x), x);
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 e = activation_exp_sse2(_mm_add_ps(a, a), 0);
+    __m128 large = _mm_sub_ps(one, _mm_div_ps(_mm_set1_ps(2.0f), _mm_add_ps(e, one)));
+    large = _mm_or_ps(large, _mm_and_ps(x, _mm_set1_ps(-0.0f)));
+
+    __m128 mask = _mm_cmplt_ps(a, _mm_set1_ps(ACTIVATION_TANH_SMALL));
+    return activation_select_sse2(mask, large, small);
+}
+
+// x * sigmoid(t) given e = exp(-|t|) * 2^32, where t has the sign of x.
+static inline __m128 activation_gate_sse2(__m128 x, __m128 e) {
+    __m128 unbias = _mm_set1_ps(ACTIVATION_UNBIAS);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 r = _mm_div_ps(one, _mm_add_ps(one, _mm_mul_ps(e, unbias)));
+    __m128 negative = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, e), r), unbias);
+    return activation_select_sse2(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_mul_ps(x, r), negative);
+}
+
+static inline __m128 activation_silu_sse2(__m128 x) {
+    x = _mm_max_ps(_mm_set1_ps(ACTIVATION_EXP_LO), x);
+    __m128 e = activation_exp_sse2(_mm_or_ps(x, _mm_set1_ps(-0.0f)), ACTIVATION_BIAS);
+    return activation_gate_sse2(x, e);
+}
+
+static inline __m128 activation_gelu_sse2(__m128 x) {
+    x = _mm_max_ps(_mm_set1_ps(ACTIVATION_GELU_TAIL), x);
+    __m128 a = activation_abs_sse2(x);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+
+    __m128 t = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(x, x), _mm_set1_ps(ACTIVATION_GELU_A_SCALE)), one);
+    __m128 g = _mm_set1_ps(ACTIVATION_GELU_A[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_GELU_A); i++) {
+        g = _mm_add_ps(_mm_mul_ps(g, t), _mm_set1_ps(ACTIVATION_GELU_A[i]));
     }
+    __m128 small = _mm_mul_ps(x, _mm_add_ps(half, _mm_mul_ps(x, g)));
+
+    __m128d x0 = _mm_cvtps_pd(x);
+    __m128d x1 = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+    __m128d scale = _mm_set1_pd(-0.5);
+    __m128d w0 = _mm_mul_pd(_mm_mul_pd(x0, x0), scale);
+    __m128d w1 = _mm_mul_pd(_mm_mul_pd(x1, x1), scale);
+    __m128 e = activation_exp_split_sse2(w0, w1, ACTIVATION_BIAS);
+
+    __m128 s = _mm_div_ps(one, _mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(ACTIVATION_GELU_S_RATE), a)));
+    s = _mm_max_ps(_mm_set1_ps(ACTIVATION_GELU_S_MIN), s);
+    t = _mm_mul_ps(s, _mm_set1_ps(ACTIVATION_GELU_B_SCALE));
+    t = _mm_sub_ps(t, _mm_set1_ps(ACTIVATION_GELU_B_SHIFT));
+    __m128 m = _mm_set1_ps(ACTIVATION_GELU_B[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_GELU_B); i++) {
+        m = _mm_add_ps(_mm_mul_ps(m, t), _mm_set1_ps(ACTIVATION_GELU_B[i]));
+    }
+    __m128 c = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(half, e), m), _mm_set1_ps(ACTIVATION_UNBIAS));
+    __m128 negative = _mm_xor_ps(c, _mm_set1_ps(-0.0f));
+    __m128 large = activation_select_sse2(
+        _mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(x, c), negative
+    );
+
+    __m128 mask = _mm_cmple_ps(a, _mm_set1_ps(ACTIVATION_GELU_SMALL));
+    return activation_select_sse2(mask, large, small);
+}
+
+static inline __m128 activation_gelu_tanh_sse2(__m128 x) {
+    x = _mm_max_ps(_mm_set1_ps(ACTIVATION_GELU_TAIL), x);
+    __m128 a = activation_abs_sse2(x);
+
+    __m128d a0 = _mm_cvtps_pd(a);
+    __m128d a1 = _mm_cvtps_pd(_mm_movehl_ps(a, a));
+    __m128d one = _mm_set1_pd(1.0);
+    __m128d rate = _mm_set1_pd(ACTIVATION_GELU_TANH_RATE);
+    __m128d scale = _mm_set1_pd(-2.0 * ACTIVATION_GELU_TANH_SCALE);
+    __m128d w0 = _mm_add_pd(one, _mm_mul_pd(rate, _mm_mul_pd(a0, a0)));
+    __m128d w1 = _mm_add_pd(one, _mm_mul_pd(rate, _mm_mul_pd(a1, a1)));
+    w0 = _mm_mul_pd(_mm_mul_pd(scale, a0), w0);
+    w1 = _mm_mul_pd(_mm_mul_pd(scale, a1), w1);
+
+    return activation_gate_sse2(x, activation_exp_split_sse2(w0, w1, ACTIVATION_BIAS));
+}
+
+static inline __m128 activation_exp_unbiased_sse2(__m128 x) {
+    return activation_exp_sse2(x, 0);
+}
+
+// ReLU maps NaN to 0 like activate_relu(): maxps returns its second operand on NaN.
+static inline __m128 activation_relu_sse2(__m128 x) {
+    return _mm_max_ps(x, _mm_setzero_ps());
+}
+
+// The tail goes through a padded copy so it sees the same arithmetic as the body.
+    #define ACTIVATION_ROW_SSE2(name, op) \
+        static void name(const float* input, float* output, size_t length) { \
+            size_t i = 0; \
+            for (; i + 4 <= length; i += 4) { \
+                _mm_storeu_ps(output + i, op(_mm_loadu_ps(input + i))); \
+            } \
+            if (i < length) { \
+                float tail[4] = {0}; \
+                memcpy(tail, input + i, (length - i) * sizeof(float)); \
+                _mm_storeu_ps(tail, op(_mm_loadu_ps(tail))); \
+                memcpy(output + i, tail, (length - i) * sizeof(float)); \
+            } \
+        }
+
+ACTIVATION_ROW_SSE2(activation_exp_row_sse2, activation_exp_unbiased_sse2)
+ACTIVATION_ROW_SSE2(activation_relu_row_sse2, activation_relu_sse2)
+ACTIVATION_ROW_SSE2(activation_sigmoid_row_sse2, activation_sigmoid_sse2)
+ACTIVATION_ROW_SSE2(activation_tanh_row_sse2, activation_tanh_sse2)
+ACTIVATION_ROW_SSE2(activation_silu_row_sse2, activation_silu_sse2)
+ACTIVATION_ROW_SSE2(activation_gelu_row_sse2, activation_gelu_sse2)
+ACTIVATION_ROW_SSE2(activation_gelu_tanh_row_sse2, activation_gelu_tanh_sse2)
+
+// One block of 16 elements: per-lane max first, then one rescale and four exp() vectors.
+static inline void activation_softmax_block_sse2(
+    const float* input, __m128 scale, __m128* max, __m128* sum, __m128* carry
+) {
+    __m128 z0 = _mm_mul_ps(_mm_loadu_ps(input), scale);
+    __m128 z1 = _mm_mul_ps(_mm_loadu_ps(input + 4), scale);
+    __m128 z2 = _mm_mul_ps(_mm_loadu_ps(input + 8), scale);
+    __m128 z3 = _mm_mul_ps(_mm_loadu_ps(input + 12), scale);
+
+    __m128 next = _mm_max_ps(_mm_max_ps(z0, z1), _mm_max_ps(z2, z3));
+    next = _mm_max_ps(*max, next);
+    __m128 rescale = activation_exp_sse2(_mm_sub_ps(*max, next), 0);
+    *max = next;
+
+    __m128 e0 = activation_exp_sse2(_mm_sub_ps(z0, next), 0);
+    __m128 e1 = activation_exp_sse2(_mm_sub_ps(z1, next), 0);
+    __m128 e2 = activation_exp_sse2(_mm_sub_ps(z2, next), 0);
+    __m128 e3 = activation_exp_sse2(_mm_sub_ps(z3, next), 0);
+    __m128 block = _mm_add_ps(_mm_add_ps(e0, e1), _mm_add_ps(e2, e3));
+
+    // Kahan step on the rescaled running sum.
+    __m128 total = _mm_mul_ps(*sum, rescale);
+    __m128 y = _mm_sub_ps(block, _mm_mul_ps(*carry, rescale));
+    __m128 t = _mm_add_ps(total, y);
+    *carry = _mm_sub_ps(_mm_sub_ps(t, total), y);
+    *sum = t;
+}
+
+static ActivationSoftmax activation_softmax_reduce_sse2(
+    const float* input, size_t length, float scale
+) {
+    __m128 vscale = _mm_set1_ps(scale);
+    __m128 max = _mm_set1_ps(-FLT_MAX);
+    __m128 sum = _mm_setzero_ps();
+    __m128 carry = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        activation_softmax_block_sse2(input + i, vscale, &max, &sum, &carry);
+    }
+    if (i < length) {
+        // -inf padding adds exp(-inf) = 0 to the sums.
+        float tail[16];
+        for (size_t j = 0; j < 16; j++) {
+            tail[j] = i + j < length ? input[i + j] : -INFINITY;
+        }
+        activation_softmax_block_sse2(tail, vscale, &max, &sum, &carry);
+    }
+
+    float lane_max[4], lane_sum[4];
+    _mm_storeu_ps(lane_max, max);
+    _mm_storeu_ps(lane_sum, _mm_sub_ps(sum, carry));
+    return activation_softmax_lanes(lane_max, lane_sum, 4);
+}
+
+static void activation_softmax_normalize_sse2(
+    const float* input, float* output, size_t length, float scale, float max, float factor
+) {
+    __m128 vscale = _mm_set1_ps(scale);
+    __m128 vmax = _mm_set1_ps(max);
+    __m128 vfactor = _mm_set1_ps(factor);
+
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 z = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(input + i), vscale), vmax);
+        _mm_storeu_ps(output + i, _mm_mul_ps(activation_exp_sse2(z, 0), vfactor));
+    }
+    if (i < length) {
+        float tail[4] = {0};
+        memcpy(tail, input + i, (length - i) * sizeof(float));
+        __m128 z = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(tail), vscale), vmax);
+        _mm_storeu_ps(tail, _mm_mul_ps(activation_exp_sse2(z, 0), vfactor));
+        memcpy(output + i, tail, (length - i) * sizeof(float));
+    }
+}
+
+#else
+
+    #define activation_exp_row_sse2 activation_exp_row_scalar
+    #define activation_relu_row_sse2 activation_relu_row_scalar
+    #define activation_sigmoid_row_sse2 activation_sigmoid_row_scalar
+    #define activation_tanh_row_sse2 activation_tanh_row_scalar
+    #define activation_silu_row_sse2 activation_silu_row_scalar
+    #define activation_gelu_row_sse2 activation_gelu_row_scalar
+    #define activation_gelu_tanh_row_sse2 activation_gelu_tanh_row_scalar
+    #define activation_softmax_reduce_sse2 activation_softmax_reduce_scalar
+    #define activation_softmax_normalize_sse2 activation_softmax_normalize_scalar
+
+#endif // __SSE2__
+
+/**
+ * SSE2 has no half conversions, and the bit-level ones in type.c are long enough that inlining
+ * them here would only duplicate them; half rows at this level go through an L1-sized fp32 tile
+ * instead, which still reads and writes each half exactly once.
+ */
+#define ACTIVATION_HALF_TILE 256
+
+#define ACTIVATION_ROW_HALF_TILE(name, row, widen, narrow) \
+    static void name(const uint16_t* input, uint16_t* output, size_t length) { \
+        float tile[ACTIVATION_HALF_TILE]; \
+        for (size_t i = 0; i < length; i += ACTIVATION_HALF_TILE) { \
+            size_t n = length - i < ACTIVATION_HALF_TILE ? length - i : ACTIVATION_HALF_TILE; \
+            widen(input + i, tile, n); \
+            row(tile, tile, n); \
+            narrow(tile, output + i, n); \
+        } \
+    }
+
+#define ACTIVATION_ROWS_HALF_TILE(function, row) \
+    ACTIVATION_ROW_HALF_TILE( \
+        activation_##function##_row_fp16_sse2, row, dequantize_row_fp16, quantize_row_fp16 \
+    ) \
+    ACTIVATION_ROW_HALF_TILE( \
+        activation_##function##_row_bf16_sse2, row, dequantize_row_bf16, quantize_row_bf16 \
+    )
+
+ACTIVATION_ROWS_HALF_TILE(relu, activation_relu_row_sse2)
+ACTIVATION_ROWS_HALF_TILE(sigmoid, activation_sigmoid_row_sse2)
+ACTIVATION_ROWS_HALF_TILE(tanh, activation_tanh_row_sse2)
+ACTIVATION_ROWS_HALF_TILE(silu, activation_silu_row_sse2)
+ACTIVATION_ROWS_HALF_TILE(gelu, activation_gelu_row_sse2)
+ACTIVATION_ROWS_HALF_TILE(gelu_tanh, activation_gelu_tanh_row_sse2)
+
+// AVX2 Kernels
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline __m256 activation_select_avx2(__m256 mask, __m256 a, __m256 b) {
+    return _mm256_blendv_ps(a, b, mask);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_abs_avx2(__m256 x) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_pow2_avx2(__m256i n) {
+    return _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23)
+    );
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_exp_avx2(__m256 x, int32_t bias) {
+    x = _mm256_min_ps(_mm256_set1_ps(ACTIVATION_EXP_HI), x);
+    x = _mm256_max_ps(_mm256_set1_ps(ACTIVATION_EXP_LO), x);
+
+    __m256 n = _mm256_round_ps(
+        _mm256_mul_ps(x, _mm256_set1_ps(ACTIVATION_LOG2E)),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC
+    );
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ACTIVATION_LN2_HI), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ACTIVATION_LN2_LO), r);
+
+    __m256 p = _mm256_set1_ps(ACTIVATION_EXP_P[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_EXP_P); i++) {
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(ACTIVATION_EXP_P[i]));
+    }
+    __m256 y = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r);
+    y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+    __m256i k = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(bias));
+    __m256i k1 = _mm256_srai_epi32(k, 1);
+    y = _mm256_mul_ps(y, activation_pow2_avx2(k1));
+    return _mm256_mul_ps(y, activation_pow2_avx2(_mm256_sub_epi32(k, k1)));
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_exp_split_avx2(
+    __m256d w0, __m256d w1, int32_t bias
+) {
+    __m256d lo_clamp = _mm256_set1_pd((double) ACTIVATION_EXP_LO);
+    w0 = _mm256_max_pd(lo_clamp, w0);
+    w1 = _mm256_max_pd(lo_clamp, w1);
+
+    __m128 h0 = _mm256_cvtpd_ps(w0);
+    __m128 h1 = _mm256_cvtpd_ps(w1);
+    __m128 l0 = _mm256_cvtpd_ps(_mm256_sub_pd(w0, _mm256_cvtps_pd(h0)));
+    __m128 l1 = _mm256_cvtpd_ps(_mm256_sub_pd(w1, _mm256_cvtps_pd(h1)));
+
+    __m256 e = activation_exp_avx2(_mm256_set_m128(h1, h0), bias);
+    __m256 lo = _mm256_set_m128(l1, l0);
+    return _mm256_fmadd_ps(e, lo, e);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_sigmoid_avx2(__m256 x) {
+    __m256 e = activation_exp_avx2(_mm256_or_ps(x, _mm256_set1_ps(-0.0f)), 0);
+    __m256 r = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_set1_ps(1.0f), e));
+    __m256 negative = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+    return activation_select_avx2(negative, r, _mm256_mul_ps(e, r));
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_tanh_avx2(__m256 x) {
+    __m256 a = activation_abs_avx2(x);
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 p = _mm256_set1_ps(ACTIVATION_TANH_P[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_TANH_P); i++) {
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(ACTIVATION_TANH_P[i]));
+    }
+    __m256 small = _mm256_fmadd_ps(_mm256_mul_ps(p, z), x, x);
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 e = activation_exp_avx2(_mm256_add_ps(a, a), 0);
+    __m256 large = _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(e, one)));
+    large = _mm256_or_ps(large, _mm256_and_ps(x, _mm256_set1_ps(-0.0f)));
+
+    __m256 mask = _mm256_cmp_ps(a, _mm256_set1_ps(ACTIVATION_TANH_SMALL), _CMP_LT_OQ);
+    return activation_select_avx2(mask, large, small);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_gate_avx2(__m256 x, __m256 e) {
+    __m256 unbias = _mm256_set1_ps(ACTIVATION_UNBIAS);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 r = _mm256_div_ps(one, _mm256_fmadd_ps(e, unbias, one));
+    __m256 negative = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(x, e), r), unbias);
+    __m256 mask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+    return activation_select_avx2(mask, _mm256_mul_ps(x, r), negative);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_silu_avx2(__m256 x) {
+    x = _mm256_max_ps(_mm256_set1_ps(ACTIVATION_EXP_LO), x);
+    __m256 e = activation_exp_avx2(_mm256_or_ps(x, _mm256_set1_ps(-0.0f)), ACTIVATION_BIAS);
+    return activation_gate_avx2(x, e);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_gelu_avx2(__m256 x) {
+    x = _mm256_max_ps(_mm256_set1_ps(ACTIVATION_GELU_TAIL), x);
+    __m256 a = activation_abs_avx2(x);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 half = _mm256_set1_ps(0.5f);
+
+    __m256 t = _mm256_fmsub_ps(_mm256_mul_ps(x, x), _mm256_set1_ps(ACTIVATION_GELU_A_SCALE), one);
+    __m256 g = _mm256_set1_ps(ACTIVATION_GELU_A[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_GELU_A); i++) {
+        g = _mm256_fmadd_ps(g, t, _mm256_set1_ps(ACTIVATION_GELU_A[i]));
+    }
+    __m256 small = _mm256_mul_ps(x, _mm256_fmadd_ps(x, g, half));
+
+    __m256d x0 = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+    __m256d x1 = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+    __m256d scale = _mm256_set1_pd(-0.5);
+    __m256d w0 = _mm256_mul_pd(_mm256_mul_pd(x0, x0), scale);
+    __m256d w1 = _mm256_mul_pd(_mm256_mul_pd(x1, x1), scale);
+    __m256 e = activation_exp_split_avx2(w0, w1, ACTIVATION_BIAS);
+
+    __m256 s = _mm256_fmadd_ps(_mm256_set1_ps(ACTIVATION_GELU_S_RATE), a, one);
+    s = _mm256_max_ps(_mm256_set1_ps(ACTIVATION_GELU_S_MIN), _mm256_div_ps(one, s));
+    t = _mm256_fmsub_ps(
+        s, _mm256_set1_ps(ACTIVATION_GELU_B_SCALE), _mm256_set1_ps(ACTIVATION_GELU_B_SHIFT)
+    );
+    __m256 m = _mm256_set1_ps(ACTIVATION_GELU_B[0]);
+    for (size_t i = 1; i < ACTIVATION_LENGTH(ACTIVATION_GELU_B); i++) {
+        m = _mm256_fmadd_ps(m, t, _mm256_set1_ps(ACTIVATION_GELU_B[i]));
+    }
+    __m256 c = _mm256_mul_ps(_mm256_mul_ps(half, e), m);
+    c = _mm256_mul_ps(c, _mm256_set1_ps(ACTIVATION_UNBIAS));
+    __m256 negative = _mm256_xor_ps(c, _mm256_set1_ps(-0.0f));
+    __m256 sign = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+    __m256 large = activation_select_avx2(sign, _mm256_sub_ps(x, c), negative);
+
+    __m256 mask = _mm256_cmp_ps(a, _mm256_set1_ps(ACTIVATION_GELU_SMALL), _CMP_LE_OQ);
+    return activation_select_avx2(mask, large, small);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_gelu_tanh_avx2(__m256 x) {
+    x = _mm256_max_ps(_mm256_set1_ps(ACTIVATION_GELU_TAIL), x);
+    __m256 a = activation_abs_avx2(x);
+
+    __m256d a0 = _mm256_cvtps_pd(_mm256_castps256_ps128(a));
+    __m256d a1 = _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1));
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d rate = _mm256_set1_pd(ACTIVATION_GELU_TANH_RATE);
+    __m256d scale = _mm256_set1_pd(-2.0 * ACTIVATION_GELU_TANH_SCALE);
+    __m256d w0 = _mm256_fmadd_pd(rate, _mm256_mul_pd(a0, a0), one);
+    __m256d w1 = _mm256_fmadd_pd(rate, _mm256_mul_pd(a1, a1), one);
+    w0 = _mm256_mul_pd(_mm256_mul_pd(scale, a0), w0);
+    w1 = _mm256_mul_pd(_mm256_mul_pd(scale, a1), w1);
+
+    return activation_gate_avx2(x, activation_exp_split_avx2(w0, w1, ACTIVATION_BIAS));
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_exp_unbiased_avx2(__m256 x) {
+    return activation_exp_avx2(x, 0);
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_relu_avx2(__m256 x) {
+    return _mm256_max_ps(x, _mm256_setzero_ps());
+}
+
+    #define ACTIVATION_ROW_AVX2(name, op) \
+        CPU_TARGET_AVX2 static void name(const float* input, float* output, size_t length) { \
+            size_t i = 0; \
+            for (; i + 8 <= length; i += 8) { \
+                _mm256_storeu_ps(output + i, op(_mm256_loadu_ps(input + i))); \
+            } \
+            if (i < length) { \
+                float tail[8] = {0}; \
+                memcpy(tail, input + i, (length - i) * sizeof(float)); \
+                _mm256_storeu_ps(tail, op(_mm256_loadu_ps(tail))); \
+                memcpy(output + i, tail, (length - i) * sizeof(float)); \
+            } \
+        }
+
+ACTIVATION_ROW_AVX2(activation_exp_row_avx2, activation_exp_unbiased_avx2)
+ACTIVATION_ROW_AVX2(activation_relu_row_avx2, activation_relu_avx2)
+ACTIVATION_ROW_AVX2(activation_sigmoid_row_avx2, activation_sigmoid_avx2)
+ACTIVATION_ROW_AVX2(activation_tanh_row_avx2, activation_tanh_avx2)
+ACTIVATION_ROW_AVX2(activation_silu_row_avx2, activation_silu_avx2)
+ACTIVATION_ROW_AVX2(activation_gelu_row_avx2, activation_gelu_avx2)
+ACTIVATION_ROW_AVX2(activation_gelu_tanh_row_avx2, activation_gelu_tanh_avx2)
+
+// Half conversions bit-exact with quantize_row_fp16() and friends at this level.
+CPU_TARGET_AVX2 static inline __m256 activation_load_fp16_avx2(const uint16_t* input) {
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) input));
+}
+
+CPU_TARGET_AVX2 static inline void activation_store_fp16_avx2(uint16_t* output, __m256 x) {
+    __m128i h = _mm256_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT);
+    __m256i unordered = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    __m128i nan = _mm_packs_epi32(
+        _mm256_castsi256_si128(unordered), _mm256_extracti128_si256(unordered, 1)
+    );
+    __m128i canonical = _mm_or_si128(
+        _mm_and_si128(h, _mm_set1_epi16((short) 0x8000)), _mm_set1_epi16(0x7E00)
+    );
+    _mm_storeu_si128((__m128i*) output, _mm_blendv_epi8(h, canonical, nan));
+}
+
+CPU_TARGET_AVX2 static inline __m256 activation_load_bf16_avx2(const uint16_t* input) {
+    __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) input));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(w, 16));
+}
+
+// Round to nearest even, subnormals flushed to signed zero, NaNs quieted.
+CPU_TARGET_AVX2 static inline void activation_store_bf16_avx2(uint16_t* output, __m256 x) {
+    const __m256i exponent_mask = _mm256_set1_epi32(0x7F800000);
+    __m256i w = _mm256_castps_si256(x);
+
+    __m256i magnitude = _mm256_and_si256(w, _mm256_set1_epi32(0x7FFFFFFF));
+    __m256i nan = _mm256_cmpgt_epi32(magnitude, exponent_mask);
+    __m256i subnormal = _mm256_cmpeq_epi32(
+        _mm256_and_si256(w, exponent_mask), _mm256_setzero_si256()
+    );
+
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(w, 16), _mm256_set1_epi32(1));
+    __m256i round = _mm256_add_epi32(_mm256_set1_epi32(0x7FFF), lsb);
+    __m256i result = _mm256_srli_epi32(_mm256_add_epi32(w, round), 16);
+    __m256i sign = _mm256_and_si256(w, _mm256_set1_epi32((int) 0x80000000));
+    result = _mm256_blendv_epi8(result, _mm256_srli_epi32(sign, 16), subnormal);
+    __m256i quiet = _mm256_or_si256(_mm256_srli_epi32(w, 16), _mm256_set1_epi32(0x40));
+    result = _mm256_blendv_epi8(result, quiet, nan);
+
+    __m128i packed = _mm_packus_epi32(
+        _mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1)
+    );
+    _mm_storeu_si128((__m128i*) output, packed);
+}
+
+    #define ACTIVATION_ROW_HALF_AVX2(name, op, load, store) \
+        CPU_TARGET_AVX2 static void name(const uint16_t* input, uint16_t* output, size_t length) { \
+            size_t i = 0; \
+            for (; i + 8 <= length; i += 8) { \
+                store(output + i, op(load(input + i))); \
+            } \
+            if (i < length) { \
+                uint16_t tail[8] = {0}; \
+                memcpy(tail, input + i, (length - i) * sizeof(uint16_t)); \
+                store(tail, op(load(tail))); \
+                memcpy(output + i, tail, (length - i) * sizeof(uint16_t)); \
+            } \
+        }
+
+    #define ACTIVATION_ROWS_HALF_AVX2(function, op) \
+        ACTIVATION_ROW_HALF_AVX2( \
+            activation_##function##_row_fp16_avx2, \
+            op, \
+            activation_load_fp16_avx2, \
+            activation_store_fp16_avx2 \
+        ) \
+        ACTIVATION_ROW_HALF_AVX2( \
+            activation_##function##_row_bf16_avx2, \
+            op, \
+            activation_load_bf16_avx2, \
+            activation_store_bf16_avx2 \
+        )
+
+ACTIVATION_ROWS_HALF_AVX2(relu, activation_relu_avx2)
+ACTIVATION_ROWS_HALF_AVX2(sigmoid, activation_sigmoid_avx2)
+ACTIVATION_ROWS_HALF_AVX2(tanh, activation_tanh_avx2)
+ACTIVATION_ROWS_HALF_AVX2(silu, activation_silu_avx2)
+ACTIVATION_ROWS_HALF_AVX2(gelu, activation_gelu_avx2)
+ACTIVATION_ROWS_HALF_AVX2(gelu_tanh, activation_gelu_tanh_avx2)
+
+CPU_TARGET_AVX2 static inline void activation_softmax_block_avx2(
+    const float* input, __m256 scale, __m256* max, __m256* sum, __m256* carry
+) {
+    __m256 z0 = _mm256_mul_ps(_mm256_loadu_ps(input), scale);
+    __m256 z1 = _mm256_mul_ps(_mm256_loadu_ps(input + 8), scale);
+    __m256 z2 = _mm256_mul_ps(_mm256_loadu_ps(input + 16), scale);
+    __m256 z3 = _mm256_mul_ps(_mm256_loadu_ps(input + 24), scale);
+
+    __m256 next = _mm256_max_ps(_mm256_max_ps(z0, z1), _mm256_max_ps(z2, z3));
+    next = _mm256_max_ps(*max, next);
+    __m256 rescale = activation_exp_avx2(_mm256_sub_ps(*max, next), 0);
+    *max = next;
+
+    __m256 e0 = activation_exp_avx2(_mm256_sub_ps(z0, next), 0);
+    __m256 e1 = activation_exp_avx2(_mm256_sub_ps(z1, next), 0);
+    __m256 e2 = activation_exp_avx2(_mm256_sub_ps(z2, next), 0);
+    __m256 e3 = activation_exp_avx2(_mm256_sub_ps(z3, next), 0);
+    __m256 block = _mm256_add_ps(_mm256_add_ps(e0, e1), _mm256_add_ps(e2, e3));
+
+    // Kahan step on the rescaled running sum.
+    __m256 total = _mm256_mul_ps(*sum, rescale);
+    __m256 y = _mm256_sub_ps(block, _mm256_mul_ps(*carry, rescale));
+    __m256 t = _mm256_add_ps(total, y);
+    *carry = _mm256_sub_ps(_mm256_sub_ps(t, total), y);
+    *sum = t;
+}
+
+CPU_TARGET_AVX2 static ActivationSoftmax activation_softmax_reduce_avx2(
+    const float* input, size_t length, float scale
+) {
+    __m256 vscale = _mm256_set1_ps(scale);
+    __m256 max = _mm256_set1_ps(-FLT_MAX);
+    __m256 sum = _mm256_setzero_ps();
+    __m256 carry = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        activation_softmax_block_avx2(input + i, vscale, &max, &sum, &carry);
+    }
+    if (i < length) {
+        // -inf padding adds exp(-inf) = 0 to the sums.
+        float tail[32];
+        for (size_t j = 0; j < 32; j++) {
+            tail[j] = i + j < length ? input[i + j] : -INFINITY;
+        }
+        activation_softmax_block_avx2(tail, vscale, &max, &sum, &carry);
+    }
+
+    float lane_max[8], lane_sum[8];
+    _mm256_storeu_ps(lane_max, max);
+    _mm256_storeu_ps(lane_sum, _mm256_sub_ps(sum, carry));
+    return activation_softmax_lanes(lane_max, lane_sum, 8);
+}
+
+CPU_TARGET_AVX2 static void activation_softmax_normalize_avx2(
+    const float* input, float* output, size_t length, float scale, float max, float factor
+) {
+    __m256 vscale = _mm256_set1_ps(scale);
+    __m256 vmax = _mm256_set1_ps(max);
+    __m256 vfactor = _mm256_set1_ps(factor);
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256 z = _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(input + i), vscale), vmax);
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(activation_exp_avx2(z, 0), vfactor));
+    }
+    if (i < length) {
+        float tail[8] = {0};
+        memcpy(tail, input + i, (length - i) * sizeof(float));
+        __m256 z = _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(tail), vscale), vmax);
+        _mm256_storeu_ps(tail, _mm256_mul_ps(activation_exp_avx2(z, 0), vfactor));
+        memcpy(output + i, tail, (length - i) * sizeof(float));
+    }
+}
+
+#endif // CPU_X86
+
+#define ACTIVATION_HALF_ROWS(type, level) \
+    { \
+        [ACTIVATION_RELU] = activation_relu_row_##type##_##level, \
+        [ACTIVATION_SIGMOID] = activation_sigmoid_row_##type##_##level, \
+        [ACTIVATION_TANH] = activation_tanh_row_##type##_##level, \
+        [ACTIVATION_SILU] = activation_silu_row_##type##_##level, \
+        [ACTIVATION_GELU] = activation_gelu_row_##type##_##level, \
+        [ACTIVATION_GELU_TANH] = activation_gelu_tanh_row_##type##_##level, \
+    }
+
+// AVX-512 runs the AVX2 kernels: these are latency-bound polynomial chains, and the 256-bit
+// versions already keep the FMA ports busy without the wider-vector frequency penalty.
+static const ActivationKernels ACTIVATION_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {
+        activation_exp_row_scalar,
+        activation_relu_row_scalar,
+        activation_sigmoid_row_scalar,
+        activation_tanh_row_scalar,
+        activation_silu_row_scalar,
+        activation_gelu_row_scalar,
+        activation_gelu_tanh_row_scalar,
+        activation_softmax_reduce_scalar,
+        activation_softmax_normalize_scalar,
+        ACTIVATION_HALF_ROWS(fp16, scalar),
+        ACTIVATION_HALF_ROWS(bf16, scalar),
+    },
+    [CPU_LEVEL_SSE2] = {
+        activation_exp_row_sse2,
+        activation_relu_row_sse2,
+        activation_sigmoid_row_sse2,
+        activation_tanh_row_sse2,
+        activation_silu_row_sse2,
+        activation_gelu_row_sse2,
+        activation_gelu_tanh_row_sse2,
+        activation_softmax_reduce_sse2,
+        activation_softmax_normalize_sse2,
+        ACTIVATION_HALF_ROWS(fp16, sse2),
+        ACTIVATION_HALF_ROWS(bf16, sse2),
+    },
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {
+        activation_exp_row_avx2,
+        activation_relu_row_avx2,
+        activation_sigmoid_row_avx2,
+        activation_tanh_row_avx2,
+        activation_silu_row_avx2,
+        activation_gelu_row_avx2,
+        activation_gelu_tanh_row_avx2,
+        activation_softmax_reduce_avx2,
+        activation_softmax_normalize_avx2,
+        ACTIVATION_HALF_ROWS(fp16, avx2),
+        ACTIVATION_HALF_ROWS(bf16, avx2),
+    },
+    [CPU_LEVEL_AVX512] = {
+        activation_exp_row_avx2,
+        activation_relu_row_avx2,
+        activation_sigmoid_row_avx2,
+        activation_tanh_row_avx2,
+        activation_silu_row_avx2,
+        activation_gelu_row_avx2,
+        activation_gelu_tanh_row_avx2,
+        activation_softmax_reduce_avx2,
+        activation_softmax_normalize_avx2,
+        ACTIVATION_HALF_ROWS(fp16, avx2),
+        ACTIVATION_HALF_ROWS(bf16, avx2),
+    },
+#endif
+};
+
+static const ActivationKernels* activation_kernels(void) {
+    return &ACTIVATION_KERNELS[cpu_level()];
+}
+
+// Reference activations in double for the fp16 tables.
+static double activation_reference(ActivationFunction function, double x) {
+    switch (function) {
+        case ACTIVATION_RELU:
+            return x > 0.0 ? x : 0.0;
+        case ACTIVATION_SIGMOID:
+            return 1.0 / (1.0 + exp(-x));
+        case ACTIVATION_TANH:
+            return tanh(x);
+        case ACTIVATION_SILU:
+            return x < -1000.0 ? 0.0 : x / (1.0 + exp(-x));
+        case ACTIVATION_GELU:
+            return x < -1000.0 ? 0.0 : 0.5 * x * erfc(-x / sqrt(2.0));
+        case ACTIVATION_GELU_TANH: {
+            if (x < -1000.0) {
+                return 0.0;
+            }
+            double u = x + ACTIVATION_GELU_TANH_RATE * x * x * x;
+            double t = 2.0 * ACTIVATION_GELU_TANH_SCALE * u;
+            return x / (1.0 + exp(-t));
+        }
+        default:
+            return NAN;
+    }
+}
+
+// Tables per function, fp16 first and bf16 second; accessed atomically and built on demand.
+static uint16_t* activation_tables[2][ACTIVATION_COUNT];
+
+static const uint16_t* activation_table(ActivationFunction function, bool bf16) {
+    uint16_t** slot = &activation_tables[bf16][function];
+    uint16_t* table = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (table) {
+        return table;
+    }
+
+    table = malloc(65536 * sizeof(uint16_t));
+    if (!table) {
+        return NULL;
+    }
+    for (uint32_t bits = 0; bits < 65536; bits++) {
+        if (bf16) {
+            double x = (double) dequantize_scalar_bf16((uint16_t) bits);
+            table[bits] = quantize_scalar_bf16((float) activation_reference(function, x));
+        } else {
+            double x = (double) dequantize_scalar_fp16((uint16_t) bits);
+            table[bits] = quantize_scalar_fp16((float) activation_reference(function, x));
+        }
+    }
+
+    // Another thread may have published its table first; keep that one.
+    uint16_t* expected = NULL;
+    if (!__atomic_compare_exchange_n(
+            slot, &expected, table, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+        )) {
+        free(table);
+        table = expected;
+    }
+    return table;
+}
+
+/**
+ * ReLU is exact through fp32 and cheaper than a lookup, so it always takes the fused row; the
+ * rest use the table, or the fused row if the table cannot be allocated.
+ */
+static void activation_row_half(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length, bool bf16
+) {
+    const ActivationKernels* kernels = activation_kernels();
+    ActivationHalfRow fused = bf16 ? kernels->bf16[function] : kernels->fp16[function];
+
+    const uint16_t* table = ACTIVATION_RELU == function ? NULL : activation_table(function, bf16);
+    if (!table) {
+        fused(input, output, length);
+        return;
+    }
+    for (size_t i = 0; i < length; i++) {
+        output[i] = table[input[i]];
+    }
+}
+
+typedef struct ActivationSoftmaxTask {
+    const ActivationKernels* kernels;
+    const float* input;
+    float* output;
+    float scale; // 1 / temperature
+    ActivationSoftmax* partials; // one per range
+    float max;
+    float factor; // 1 / sum, or max + log(sum) for log_softmax
+    bool logarithm;
+} ActivationSoftmaxTask;
+
+static void activation_softmax_reduce_task(void* context, size_t begin, size_t end, size_t thread) {
+    ActivationSoftmaxTask* task = (ActivationSoftmaxTask*) context;
+    task->partials[thread] = task->kernels->softmax_reduce(
+        task->input + begin, end - begin, task->scale
+    );
+}
+
+static void activation_softmax_normalize_task(
+    void* context, size_t begin, size_t end, size_t thread
+) {
+    (void) thread;
+    ActivationSoftmaxTask* task = (ActivationSoftmaxTask*) context;
+    if (task->logarithm) {
+        activation_log_softmax_shift(
+            task->input + begin, task->output + begin, end - begin, task->scale, task->factor
+        );
+    } else {
+        task->kernels->softmax_normalize(
+            task->input + begin,
+            task->output + begin,
+            end - begin,
+            task->scale,
+            task->max,
+            task->factor
+        );
+    }
+}
+
+static void activation_softmax(
+    ThreadPool* pool,
+    const float* input,
+    float* output,
+    size_t length,
+    float temperature,
+    bool logarithm
+) {
+    assert(input != NULL && output != NULL);
+    assert(length > 0);
+    assert(temperature > 0.0f);
+
+    // Without room for the partials, run on the caller.
+    ActivationSoftmax local;
+    size_t threads = thread_pool_size(pool);
+    ActivationSoftmax* partials = threads > 1 ? malloc(threads * sizeof(ActivationSoftmax)) : NULL;
+    if (!partials) {
+        pool = NULL;
+        threads = 1;
+        partials = &local;
+    }
+    for (size_t i = 0; i < threads; i++) {
+        partials[i] = ACTIVATION_SOFTMAX_EMPTY; // ranges left idle for short rows
+    }
+
+    ActivationSoftmaxTask task = {
+        .kernels = activation_kernels(),
+        .input = input,
+        .output = output,
+        .scale = 1.0f / temperature,
+        .partials = partials,
+        .logarithm = logarithm,
+    };
+    thread_pool_parallel_for(
+        pool, length, ACTIVATION_SOFTMAX_GRAIN, activation_softmax_reduce_task, &task
+    );
+
+    ActivationSoftmax total = partials[0];
+    for (size_t i = 1; i < threads; i++) {
+        total = activation_softmax_merge(total, partials[i]);
+    }
+    if (partials != &local) {
+        free(partials);
+    }
+
+    task.max = total.max;
+    task.factor = logarithm ? total.max + logf(total.sum) : 1.0f / total.sum;
+    thread_pool_parallel_for(
+        pool, length, ACTIVATION_SOFTMAX_GRAIN, activation_softmax_normalize_task, &task
+    );
+}
+
+/**
+ * Public Row Functions
+ */
+
+void activate_exp_row(const float* input, float* output, size_t length) {
+    assert(input != NULL && output != NULL);
+    activation_kernels()->exp(input, output, length);
+}
+
+void activate_relu_row(const float* input, float* output, size_t length) {
+    assert(input != NULL && output != NULL);
+    activation_kernels()->relu(input, output, length);
+}
+
+void activate_sigmoid_row(const float* input, float* output, size_t length) {
+    assert(input != NULL && output != NULL);
+    activation_kernels()->sigmoid(input, output, length);
+}
+
+void activate_tanh_row(const float* input, float* output, size_t length) {
+    assert(input != NULL && output != NULL);
+    activation_kernels()->tanh(input, output, length);
+}
+
+void activate_silu_row(const float* input, float* output, size_t length) {
+    assert(input != NULL && output != NULL);
+    activation_kernels()->silu(input, output, length);
+}
+
+void activate_gelu_row(const float* input, float* output, size_t length) {
+    assert(input != NULL && output != NULL);
+    activation_kernels()->gelu(input, output, length);
+}
+
+void activate_gelu_tanh_row(const float* input, float* output, size_t length) {
+    assert(input != NULL && output != NULL);
+    activation_kernels()->gelu_tanh(input, output, length);
+}
+
+void activate_row(ActivationFunction function, const float* input, float* output, size_t length) {
+    assert(function < ACTIVATION_COUNT);
+
+    switch (function) {
+        case ACTIVATION_RELU:
+            activate_relu_row(input, output, length);
+            break;
+        case ACTIVATION_SIGMOID:
+            activate_sigmoid_row(input, output, length);
+            break;
+        case ACTIVATION_TANH:
+            activate_tanh_row(input, output, length);
+            break;
+        case ACTIVATION_SILU:
+            activate_silu_row(input, output, length);
+            break;
+        case ACTIVATION_GELU:
+            activate_gelu_row(input, output, length);
+            break;
+        case ACTIVATION_GELU_TANH:
+            activate_gelu_tanh_row(input, output, length);
+            break;
+        default:
+            break;
+    }
+}
+
+void activate_row_fp16(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+) {
+    assert(function < ACTIVATION_COUNT);
+    assert(input != NULL && output != NULL);
+    activation_row_half(function, input, output, length, false);
+}
+
+void activate_row_bf16(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+) {
+    assert(function < ACTIVATION_COUNT);
+    assert(input != NULL && output != NULL);
+    activation_row_half(function, input, output, length, true);
+}
+
+void activate_row_fp16_fused(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+) {
+    assert(function < ACTIVATION_COUNT);
+    assert(input != NULL && output != NULL);
+    activation_kernels()->fp16[function](input, output, length);
+}
+
+void activate_row_bf16_fused(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+) {
+    assert(function < ACTIVATION_COUNT);
+    assert(input != NULL && output != NULL);
+    activation_kernels()->bf16[function](input, output, length);
+}
+
+void activate_softmax(const float* input, float* output, size_t length) {
+    activation_softmax(NULL, input, output, length, 1.0f, false);
+}
+
+void activate_softmax_temperature(
+    const float* input, float* output, size_t length, float temperature
+) {
+    activation_softmax(NULL, input, output, length, temperature, false);
+}
+
+void activate_log_softmax(const float* input, float* output, size_t length) {
+    activation_softmax(NULL, input, output, length, 1.0f, true);
+}
+
+void activate_log_softmax_temperature(
+    const float* input, float* output, size_t length, float temperature
+) {
+    activation_softmax(NULL, input, output, length, temperature, true);
+}
+
+void activate_softmax_parallel(
+    ThreadPool* pool, const float* input, float* output, size_t length, float temperature
+) {
+    activation_softmax(pool, input, output, length, temperature, false);
+}
+
+void activate_log_softmax_parallel(
+    ThreadPool* pool, const float* input, float* output, size_t length, float temperature
+) {
+    activation_softmax(pool, input, output, length, temperature, true);
 }
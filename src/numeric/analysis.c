@@ -0,0 +1,599 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file src/numeric/analysis.c
+ * @brief Accuracy and speed of quantized round trips over fp32 rows.
+ */
+
+#include "core/cpu.h"
+#include "core/memory.h"
+#include "numeric/analysis.h"
+#include "numeric/constant.h"
+#include "numeric/distribution.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#define ANALYSIS_TILE 4096 // elements per moments-then-histogram step (16 KiB per row, L1-resident)
+#define ANALYSIS_OUTLIER_SCALE 64.0f
+
+// Σ e^2, Σ x^2, Σ y^2 and Σ x y in double, and the largest |e| (NaN skipped).
+typedef struct AnalysisMoments {
+    double error;
+    double reference;
+    double actual;
+    double cross;
+    double max_abs;
+} AnalysisMoments;
+
+typedef size_t (*AnalysisClose)(
+    const float* a, const float* b, size_t length, float relative, float absolute
+);
+typedef void (*AnalysisAccumulate)(
+    const float* x, const float* y, size_t length, AnalysisMoments* moments
+);
+
+typedef struct AnalysisKernels {
+    AnalysisClose count;
+    AnalysisClose find;
+    AnalysisAccumulate moments;
+} AnalysisKernels;
+
+// Scalar Kernels
+
+static inline bool analysis_close_scalar(float a, float b, float relative, float absolute) {
+    if (a == b) {
+        return true;
+    }
+    float abs_a = fabsf(a);
+    float abs_b = fabsf(b);
+    if (!(abs_a < INFINITY) || !(abs_b < INFINITY)) {
+        return false;
+    }
+    return fabsf(a - b) <= fmaxf(relative * fmaxf(abs_a, abs_b), absolute);
+}
+
+static size_t analysis_count_scalar(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += analysis_close_scalar(a[i], b[i], relative, absolute);
+    }
+    return count;
+}
+
+static size_t analysis_find_scalar(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    for (size_t i = 0; i < length; i++) {
+        if (!analysis_close_scalar(a[i], b[i], relative, absolute)) {
+            return i;
+        }
+    }
+    return length;
+}
+
+static void analysis_moments_scalar(
+    const float* x, const float* y, size_t length, AnalysisMoments* moments
+) {
+    for (size_t i = 0; i < length; i++) {
+        double xi = (double) x[i];
+        double yi = (double) y[i];
+        double e = yi - xi;
+        moments->error += e * e;
+        moments->reference += xi * xi;
+        moments->actual += yi * yi;
+        moments->cross += xi * yi;
+        moments->max_abs = fabs(e) > moments->max_abs ? fabs(e) : moments->max_abs;
+    }
+}
+
+// SSE2 Kernels
+
+#if defined(__SSE2__)
+
+// All-ones lanes where the pair is close, by the same rule as analysis_close_scalar().
+static inline __m128 analysis_close_sse2(__m128 a, __m128 b, __m128 relative, __m128 absolute) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 infinity = _mm_set1_ps(INFINITY);
+    __m128 abs_a = _mm_andnot_ps(sign, a);
+    __m128 abs_b = _mm_andnot_ps(sign, b);
+    __m128 finite = _mm_and_ps(_mm_cmplt_ps(abs_a, infinity), _mm_cmplt_ps(abs_b, infinity));
+    __m128 tolerance = _mm_max_ps(_mm_mul_ps(relative, _mm_max_ps(abs_a, abs_b)), absolute);
+    __m128 near = _mm_cmple_ps(_mm_andnot_ps(sign, _mm_sub_ps(a, b)), tolerance);
+    return _mm_or_ps(_mm_cmpeq_ps(a, b), _mm_and_ps(finite, near));
+}
+
+static size_t analysis_count_sse2(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    __m128 r = _mm_set1_ps(relative);
+    __m128 t = _mm_set1_ps(absolute);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 close = analysis_close_sse2(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i), r, t);
+        count += (size_t) __builtin_popcount((unsigned) _mm_movemask_ps(close));
+    }
+    return count + analysis_count_scalar(a + i, b + i, length - i, relative, absolute);
+}
+
+static size_t analysis_find_sse2(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    __m128 r = _mm_set1_ps(relative);
+    __m128 t = _mm_set1_ps(absolute);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 close = analysis_close_sse2(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i), r, t);
+        unsigned far = ~(unsigned) _mm_movemask_ps(close) & 0xFu;
+        if (far) {
+            return i + (size_t) __builtin_ctz(far);
+        }
+    }
+    return i + analysis_find_scalar(a + i, b + i, length - i, relative, absolute);
+}
+
+static inline double analysis_hsum_sse2(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static void analysis_moments_sse2(
+    const float* x, const float* y, size_t length, AnalysisMoments* moments
+) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d error = _mm_setzero_pd();
+    __m128d reference = _mm_setzero_pd();
+    __m128d actual = _mm_setzero_pd();
+    __m128d cross = _mm_setzero_pd();
+    __m128d max_abs = _mm_set1_pd(moments->max_abs);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 xs = _mm_loadu_ps(x + i);
+        __m128 ys = _mm_loadu_ps(y + i);
+        for (int half = 0; half < 2; half++) {
+            __m128d xd = _mm_cvtps_pd(xs);
+            __m128d yd = _mm_cvtps_pd(ys);
+            __m128d e = _mm_sub_pd(yd, xd);
+            error = _mm_add_pd(error, _mm_mul_pd(e, e));
+            reference = _mm_add_pd(reference, _mm_mul_pd(xd, xd));
+            actual = _mm_add_pd(actual, _mm_mul_pd(yd, yd));
+            cross = _mm_add_pd(cross, _mm_mul_pd(xd, yd));
+            max_abs = _mm_max_pd(_mm_andnot_pd(sign, e), max_abs); // keeps max_abs on NaN
+            xs = _mm_movehl_ps(xs, xs);
+            ys = _mm_movehl_ps(ys, ys);
+        }
+    }
+    moments->error += analysis_hsum_sse2(error);
+    moments->reference += analysis_hsum_sse2(reference);
+    moments->actual += analysis_hsum_sse2(actual);
+    moments->cross += analysis_hsum_sse2(cross);
+    max_abs = _mm_max_sd(max_abs, _mm_unpackhi_pd(max_abs, max_abs));
+    moments->max_abs = _mm_cvtsd_f64(max_abs);
+    analysis_moments_scalar(x + i, y + i, length - i, moments);
+}
+
+#else
+
+    #define analysis_count_sse2 analysis_count_scalar
+    #define analysis_find_sse2 analysis_find_scalar
+    #define analysis_moments_sse2 analysis_moments_scalar
+
+#endif // __SSE2__
+
+// AVX2 Kernels
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline __m256 analysis_close_avx2(
+    __m256 a, __m256 b, __m256 relative, __m256 absolute
+) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 infinity = _mm256_set1_ps(INFINITY);
+    __m256 abs_a = _mm256_andnot_ps(sign, a);
+    __m256 abs_b = _mm256_andnot_ps(sign, b);
+    __m256 finite = _mm256_and_ps(
+        _mm256_cmp_ps(abs_a, infinity, _CMP_LT_OQ), _mm256_cmp_ps(abs_b, infinity, _CMP_LT_OQ)
+    );
+    __m256 tolerance = _mm256_max_ps(
+        _mm256_mul_ps(relative, _mm256_max_ps(abs_a, abs_b)), absolute
+    );
+    __m256 near = _mm256_cmp_ps(
+        _mm256_andnot_ps(sign, _mm256_sub_ps(a, b)), tolerance, _CMP_LE_OQ
+    );
+    return _mm256_or_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ), _mm256_and_ps(finite, near));
+}
+
+CPU_TARGET_AVX2 static size_t analysis_count_avx2(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    __m256 r = _mm256_set1_ps(relative);
+    __m256 t = _mm256_set1_ps(absolute);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256 close = analysis_close_avx2(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), r, t);
+        count += (size_t) __builtin_popcount((unsigned) _mm256_movemask_ps(close));
+    }
+    return count + analysis_count_sse2(a + i, b + i, length - i, relative, absolute);
+}
+
+CPU_TARGET_AVX2 static size_t analysis_find_avx2(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    __m256 r = _mm256_set1_ps(relative);
+    __m256 t = _mm256_set1_ps(absolute);
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256 close = analysis_close_avx2(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), r, t);
+        unsigned far = ~(unsigned) _mm256_movemask_ps(close) & 0xFFu;
+        if (far) {
+            return i + (size_t) __builtin_ctz(far);
+        }
+    }
+    return i + analysis_find_sse2(a + i, b + i, length - i, relative, absolute);
+}
+
+CPU_TARGET_AVX2 static inline double analysis_hsum_avx2(__m256d v) {
+    __m128d h = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+}
+
+CPU_TARGET_AVX2 static void analysis_moments_avx2(
+    const float* x, const float* y, size_t length, AnalysisMoments* moments
+) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d error = _mm256_setzero_pd();
+    __m256d reference = _mm256_setzero_pd();
+    __m256d actual = _mm256_setzero_pd();
+    __m256d cross = _mm256_setzero_pd();
+    __m256d max_abs = _mm256_set1_pd(moments->max_abs);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m256d xd = _mm256_cvtps_pd(_mm_loadu_ps(x + i));
+        __m256d yd = _mm256_cvtps_pd(_mm_loadu_ps(y + i));
+        __m256d e = _mm256_sub_pd(yd, xd);
+        error = _mm256_fmadd_pd(e, e, error);
+        reference = _mm256_fmadd_pd(xd, xd, reference);
+        actual = _mm256_fmadd_pd(yd, yd, actual);
+        cross = _mm256_fmadd_pd(xd, yd, cross);
+        max_abs = _mm256_max_pd(_mm256_andnot_pd(sign, e), max_abs);
+    }
+    moments->error += analysis_hsum_avx2(error);
+    moments->reference += analysis_hsum_avx2(reference);
+    moments->actual += analysis_hsum_avx2(actual);
+    moments->cross += analysis_hsum_avx2(cross);
+    __m128d m = _mm_max_pd(_mm256_castpd256_pd128(max_abs), _mm256_extractf128_pd(max_abs, 1));
+    moments->max_abs = _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+    analysis_moments_scalar(x + i, y + i, length - i, moments);
+}
+
+#endif // CPU_X86
+
+// AVX512 reuses the AVX2 kernels: two fp32 streams per element keep the rows memory-bound.
+static const AnalysisKernels ANALYSIS_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {
+        analysis_count_scalar,
+        analysis_find_scalar,
+        analysis_moments_scalar,
+    },
+    [CPU_LEVEL_SSE2] = {
+        analysis_count_sse2,
+        analysis_find_sse2,
+        analysis_moments_sse2,
+    },
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {
+        analysis_count_avx2,
+        analysis_find_avx2,
+        analysis_moments_avx2,
+    },
+    [CPU_LEVEL_AVX512] = {
+        analysis_count_avx2,
+        analysis_find_avx2,
+        analysis_moments_avx2,
+    },
+#endif
+};
+
+static const AnalysisKernels* analysis_kernels(void) {
+    return &ANALYSIS_KERNELS[cpu_level()];
+}
+
+/**
+ * Comparison
+ */
+
+size_t analysis_close_count(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    assert(length == 0 || (a != NULL && b != NULL));
+    return analysis_kernels()->count(a, b, length, relative, absolute);
+}
+
+size_t analysis_find_far(
+    const float* a, const float* b, size_t length, float relative, float absolute
+) {
+    assert(length == 0 || (a != NULL && b != NULL));
+    return analysis_kernels()->find(a, b, length, relative, absolute);
+}
+
+/**
+ * Error Statistics
+ */
+
+// Maps the sign-magnitude fp32 bits onto a line where neighbouring floats differ by 1: negative
+// values become minus their magnitude bits. Branch-free, as signs in real rows are a coin toss.
+static inline int64_t analysis_ulp_key(float value) {
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int32_t sign = bits >> 31;
+    return (int64_t) ((bits ^ (sign & INT32_MAX)) - sign);
+}
+
+// Distance between two non-NaN floats, at most 0xFF000000 (from -inf to +inf).
+static inline uint32_t analysis_ulp_ordered(float a, float b) {
+    int64_t d = analysis_ulp_key(a) - analysis_ulp_key(b);
+    return (uint32_t) (d < 0 ? -d : d);
+}
+
+uint32_t analysis_ulp_distance(float a, float b) {
+    return isnan(a) || isnan(b) ? UINT32_MAX : analysis_ulp_ordered(a, b);
+}
+
+uint32_t analysis_ulp_percentile(const AnalysisStats* stats, double fraction) {
+    assert(stats != NULL);
+    double target = fraction * (double) (stats->length - stats->unordered);
+    size_t running = 0;
+    for (size_t k = 0; k < ANALYSIS_ULP_BINS; k++) {
+        running += stats->ulp[k];
+        if ((double) running >= target) {
+            return k == 0 ? 0 : (uint32_t) ((UINT64_C(1) << k) - 1);
+        }
+    }
+    return stats->ulp_max;
+}
+
+typedef struct AnalysisPartial {
+    AnalysisMoments moments;
+    size_t unordered;
+    uint32_t ulp_max;
+    size_t ulp[ANALYSIS_ULP_BINS];
+} AnalysisPartial;
+
+typedef struct AnalysisTask {
+    const AnalysisKernels* kernels;
+    const float* x;
+    const float* y;
+    AnalysisPartial* partials;
+} AnalysisTask;
+
+// Most pairs of a row land in the same few bins, so consecutive increments of one counter would
+// wait on each other through memory; four interleaved copies of the counters break that chain.
+static void analysis_histogram(const float* x, const float* y, size_t length, AnalysisPartial* p) {
+    size_t ulp[4][ANALYSIS_ULP_BINS] = {{0}};
+    size_t unordered = 0;
+    uint32_t ulp_max = p->ulp_max;
+    for (size_t i = 0; i < length; i++) {
+        if (isnan(x[i]) || isnan(y[i])) {
+            unordered++;
+            continue;
+        }
+        uint32_t d = analysis_ulp_ordered(x[i], y[i]);
+        ulp[i & 3][(d != 0) * (32 - __builtin_clz(d | 1))]++;
+        ulp_max = d > ulp_max ? d : ulp_max;
+    }
+    for (size_t k = 0; k < ANALYSIS_ULP_BINS; k++) {
+        p->ulp[k] += ulp[0][k] + ulp[1][k] + ulp[2][k] + ulp[3][k];
+    }
+    p->unordered += unordered;
+    p->ulp_max = ulp_max;
+}
+
+// Tiles keep each stretch of both rows in L1 between the vector pass and the histogram pass.
+static void analysis_range(
+    const AnalysisKernels* kernels,
+    const float* x,
+    const float* y,
+    size_t length,
+    AnalysisPartial* partial
+) {
+    for (size_t i = 0; i < length; i += ANALYSIS_TILE) {
+        size_t n = MIN(ANALYSIS_TILE, length - i);
+        kernels->moments(x + i, y + i, n, &partial->moments);
+        analysis_histogram(x + i, y + i, n, partial);
+    }
+}
+
+static void analysis_compare_task(void* context, size_t begin, size_t end, size_t thread) {
+    AnalysisTask* task = (AnalysisTask*) context;
+    analysis_range(
+        task->kernels, task->x + begin, task->y + begin, end - begin, &task->partials[thread]
+    );
+}
+
+void analysis_compare(
+    ThreadPool* pool,
+    const float* reference,
+    const float* actual,
+    size_t length,
+    AnalysisStats* stats
+) {
+    assert(reference != NULL);
+    assert(actual != NULL);
+    assert(stats != NULL);
+    assert(length > 0);
+
+    // Without room for the partials, the loop runs on the caller.
+    AnalysisPartial local;
+    size_t threads = thread_pool_size(pool);
+    AnalysisPartial* partials = threads > 1 ? calloc(threads, sizeof(AnalysisPartial)) : NULL;
+    if (!partials) {
+        pool = NULL;
+        threads = 1;
+        partials = &local;
+        memset(&local, 0, sizeof(local));
+    }
+
+    AnalysisTask task = {analysis_kernels(), reference, actual, partials};
+    thread_pool_parallel_for(pool, length, ANALYSIS_GRAIN, analysis_compare_task, &task);
+
+    AnalysisMoments m = {0.0, 0.0, 0.0, 0.0, 0.0};
+    memset(stats, 0, sizeof(*stats));
+    for (size_t t = 0; t < threads; t++) {
+        const AnalysisPartial* p = &partials[t];
+        m.error += p->moments.error;
+        m.reference += p->moments.reference;
+        m.actual += p->moments.actual;
+        m.cross += p->moments.cross;
+        m.max_abs = MAX(m.max_abs, p->moments.max_abs);
+        stats->unordered += p->unordered;
+        stats->ulp_max = MAX(stats->ulp_max, p->ulp_max);
+        for (size_t k = 0; k < ANALYSIS_ULP_BINS; k++) {
+            stats->ulp[k] += p->ulp[k];
+        }
+    }
+    if (partials != &local) {
+        free(partials);
+    }
+
+    stats->length = length;
+    stats->max_abs = m.max_abs;
+    stats->rmse = sqrt(m.error / (double) length);
+    if (m.error == 0.0) {
+        stats->snr_db = HUGE_VAL;
+    } else {
+        stats->snr_db = m.reference > 0.0 ? 10.0 * log10(m.reference / m.error) : -HUGE_VAL;
+    }
+    if (m.reference == 0.0 || m.actual == 0.0) {
+        stats->cosine = m.reference == m.actual ? 1.0 : 0.0;
+    } else {
+        stats->cosine = m.cross / sqrt(m.reference * m.actual);
+    }
+}
+
+/**
+ * Round Trips
+ */
+
+static double analysis_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+bool analysis_round_trip(
+    ThreadPool* pool,
+    const float* input,
+    size_t length,
+    DataTypeId id,
+    size_t repeats,
+    AnalysisReport* report
+) {
+    assert(input != NULL);
+    assert(report != NULL);
+
+    const DataType* type = data_type_get(id);
+    if (!type || length == 0) {
+        return false;
+    }
+
+    size_t bytes = data_type_row_size(id, length);
+    void* quantized = memory_alloc(bytes, type->alignment);
+    float* restored = memory_alloc(length * sizeof(float), alignof(float));
+    if (!quantized || !restored) {
+        memory_free(quantized);
+        memory_free(restored);
+        return false;
+    }
+
+    bool ok = true;
+    double quantize_seconds = HUGE_VAL;
+    double dequantize_seconds = HUGE_VAL;
+    for (size_t r = 0; ok && r < MAX(repeats, 1); r++) {
+        double start = analysis_now();
+        ok = quantize_row(input, quantized, length, id);
+        double middle = analysis_now();
+        ok = ok && dequantize_row(quantized, restored, length, id);
+        double end = analysis_now();
+        quantize_seconds = MIN(quantize_seconds, middle - start);
+        dequantize_seconds = MIN(dequantize_seconds, end - middle);
+    }
+
+    if (ok) {
+        report->id = id;
+        report->bytes = bytes;
+        report->bits_per_value = 8.0 * (double) bytes / (double) length;
+        report->quantize_seconds = quantize_seconds;
+        report->dequantize_seconds = dequantize_seconds;
+        analysis_compare(pool, input, restored, length, &report->stats);
+    }
+
+    memory_free(quantized);
+    memory_free(restored);
+    return ok;
+}
+
+/**
+ * Synthetic Rows
+ */
+
+void analysis_fill(
+    Random* random, float* output, size_t length, AnalysisDistribution distribution, float scale
+) {
+    assert(random != NULL);
+    assert(length == 0 || output != NULL);
+
+    switch (distribution) {
+        case ANALYSIS_UNIFORM:
+            random_fill_uniform(random, output, length, -scale, scale);
+            break;
+        case ANALYSIS_LAPLACE:
+            // Exponential magnitudes with rate sqrt(2) / scale have variance scale^2 once signed.
+            random_fill_exponential(random, output, length, sqrtf(2.0f) / scale);
+            for (size_t i = 0; i < length; i += 32) {
+                uint32_t signs = random_u32(random);
+                for (size_t j = i; j < MIN(i + 32, length); j++, signs >>= 1) {
+                    output[j] = (signs & 1u) ? -output[j] : output[j];
+                }
+            }
+            break;
+        case ANALYSIS_OUTLIER:
+            random_fill_normal(random, output, length, 0.0f, scale);
+            for (size_t k = 0; k < length / ANALYSIS_OUTLIER_RATE; k++) {
+                size_t i = (size_t) (random_double(random) * (double) length);
+                output[i] *= ANALYSIS_OUTLIER_SCALE;
+            }
+            break;
+        case ANALYSIS_NORMAL:
+        default:
+            random_fill_normal(random, output, length, 0.0f, scale);
+            break;
+    }
+}
+
+const char* analysis_distribution_name(AnalysisDistribution distribution) {
+    switch (distribution) {
+        case ANALYSIS_UNIFORM:
+            return "uniform";
+        case ANALYSIS_NORMAL:
+            return "normal";
+        case ANALYSIS_LAPLACE:
+            return "laplace";
+        case ANALYSIS_OUTLIER:
+            return "outlier";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,1014 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/numeric/convert.c
+ *
+ * @brief Row conversion between any two data types.
+ */
+
+#include "core/cpu.h"
+#include "numeric/convert.h"
+
+#include <stdalign.h>
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+/**
+ * Private Definitions
+ */
+
+#define CONVERT_TILE 1024 // elements per fp32/int64 tile; a multiple of every block size
+#define CONVERT_CHUNK (64 * CONVERT_TILE) // elements per scheduling unit of convert_rows()
+
+typedef void (*ConvertRow)(const void* input, void* output, size_t length);
+typedef void (*ConvertWiden)(const void* input, int64_t* output, size_t length);
+typedef void (*ConvertNarrow)(const int64_t* input, void* output, size_t length);
+
+typedef struct ConvertKernels {
+    ConvertRow encode[TYPE_COUNT]; /**< fp32 to the type */
+    ConvertRow decode[TYPE_COUNT]; /**< The type to fp32 */
+} ConvertKernels;
+
+/**
+ * Converts one row using the encoders and decoders in `kernels`. Offsets into block and packed
+ * rows are whole multiples of CONVERT_TILE, so every tile starts on a block boundary.
+ */
+typedef void (*ConvertPath)(
+    const ConvertKernels* kernels,
+    const uint8_t* input,
+    DataTypeId input_type,
+    uint8_t* output,
+    DataTypeId output_type,
+    size_t length
+);
+
+/**
+ * Scalar Kernels
+ *
+ * The reference semantics: fp32 rounds to nearest even and saturates, NaN becomes 0.
+ */
+
+static inline int64_t convert_saturate(float x, int64_t lo, int64_t hi) {
+    if (isnan(x)) {
+        return 0;
+    }
+    if (x <= (float) lo) {
+        return lo;
+    }
+    if (x >= (float) hi) {
+        return hi;
+    }
+    return (int64_t) rintf(x);
+}
+
+static inline int64_t convert_clamp(int64_t x, int64_t lo, int64_t hi) {
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+#define CONVERT_INTEGER_SCALAR(name, type, lo, hi) \
+    static void convert_encode_##name##_scalar(const void* input, void* output, size_t length) { \
+        const float* x = input; \
+        type* y = output; \
+        for (size_t i = 0; i < length; i++) { \
+            y[i] = (type) convert_saturate(x[i], lo, hi); \
+        } \
+    } \
+\
+    static void convert_decode_##name##_scalar(const void* input, void* output, size_t length) { \
+        const type* x = input; \
+        float* y = output; \
+        for (size_t i = 0; i < length; i++) { \
+            y[i] = (float) x[i]; \
+        } \
+    } \
+\
+    static void convert_widen_##name(const void* input, int64_t* output, size_t length) { \
+        const type* x = input; \
+        for (size_t i = 0; i < length; i++) { \
+            output[i] = x[i]; \
+        } \
+    } \
+\
+    static void convert_narrow_##name(const int64_t* input, void* output, size_t length) { \
+        type* y = output; \
+        for (size_t i = 0; i < length; i++) { \
+            y[i] = (type) convert_clamp(input[i], lo, hi); \
+        } \
+    }
+
+CONVERT_INTEGER_SCALAR(int8, int8_t, INT8_MIN, INT8_MAX)
+CONVERT_INTEGER_SCALAR(int16, int16_t, INT16_MIN, INT16_MAX)
+CONVERT_INTEGER_SCALAR(int32, int32_t, INT32_MIN, INT32_MAX)
+CONVERT_INTEGER_SCALAR(uint8, uint8_t, 0, UINT8_MAX)
+CONVERT_INTEGER_SCALAR(uint16, uint16_t, 0, UINT16_MAX)
+CONVERT_INTEGER_SCALAR(uint32, uint32_t, 0, UINT32_MAX)
+
+// Bool is read as a byte so that any non-zero value counts as true.
+static void convert_encode_bool_scalar(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint8_t* y = output;
+    for (size_t i = 0; i < length; i++) {
+        y[i] = x[i] != 0.0f;
+    }
+}
+
+static void convert_decode_bool_scalar(const void* input, void* output, size_t length) {
+    const uint8_t* x = input;
+    float* y = output;
+    for (size_t i = 0; i < length; i++) {
+        y[i] = x[i] ? 1.0f : 0.0f;
+    }
+}
+
+static void convert_widen_bool(const void* input, int64_t* output, size_t length) {
+    const uint8_t* x = input;
+    for (size_t i = 0; i < length; i++) {
+        output[i] = x[i] != 0;
+    }
+}
+
+static void convert_narrow_bool(const int64_t* input, void* output, size_t length) {
+    uint8_t* y = output;
+    for (size_t i = 0; i < length; i++) {
+        y[i] = input[i] != 0;
+    }
+}
+
+static const ConvertWiden CONVERT_WIDEN[TYPE_COUNT] = {
+    [TYPE_INT32] = convert_widen_int32,
+    [TYPE_INT16] = convert_widen_int16,
+    [TYPE_INT8] = convert_widen_int8,
+    [TYPE_UINT32] = convert_widen_uint32,
+    [TYPE_UINT16] = convert_widen_uint16,
+    [TYPE_UINT8] = convert_widen_uint8,
+    [TYPE_BOOL] = convert_widen_bool,
+    [TYPE_CHAR] = convert_widen_uint8,
+};
+
+static const ConvertNarrow CONVERT_NARROW[TYPE_COUNT] = {
+    [TYPE_INT32] = convert_narrow_int32,
+    [TYPE_INT16] = convert_narrow_int16,
+    [TYPE_INT8] = convert_narrow_int8,
+    [TYPE_UINT32] = convert_narrow_uint32,
+    [TYPE_UINT16] = convert_narrow_uint16,
+    [TYPE_UINT8] = convert_narrow_uint8,
+    [TYPE_BOOL] = convert_narrow_bool,
+    [TYPE_CHAR] = convert_narrow_uint8,
+};
+
+/**
+ * Shared Kernels
+ *
+ * fp16, bf16, FP8 and the block formats dispatch on the CPU level themselves.
+ */
+
+static void convert_copy_fp32(const void* input, void* output, size_t length) {
+    memcpy(output, input, length * sizeof(float));
+}
+
+static void convert_encode_fp16(const void* input, void* output, size_t length) {
+    quantize_row_fp16(input, output, length);
+}
+
+static void convert_decode_fp16(const void* input, void* output, size_t length) {
+    dequantize_row_fp16(input, output, length);
+}
+
+static void convert_encode_bf16(const void* input, void* output, size_t length) {
+    quantize_row_bf16(input, output, length);
+}
+
+static void convert_decode_bf16(const void* input, void* output, size_t length) {
+    dequantize_row_bf16(input, output, length);
+}
+
+static void convert_encode_e4m3(const void* input, void* output, size_t length) {
+    quantize_row_e4m3(input, output, length);
+}
+
+static void convert_decode_e4m3(const void* input, void* output, size_t length) {
+    dequantize_row_e4m3(input, output, length);
+}
+
+static void convert_encode_e5m2(const void* input, void* output, size_t length) {
+    quantize_row_e5m2(input, output, length);
+}
+
+static void convert_decode_e5m2(const void* input, void* output, size_t length) {
+    dequantize_row_e5m2(input, output, length);
+}
+
+static void convert_encode_quant8(const void* input, void* output, size_t length) {
+    quantize_row_q8(input, output, length);
+}
+
+static void convert_decode_quant8(const void* input, void* output, size_t length) {
+    dequantize_row_q8(input, output, length);
+}
+
+// An odd element shares its Q4 pair with a zero, which leaves the pair's scale unchanged.
+static void convert_encode_quant4(const void* input, void* output, size_t length) {
+    const float* x = input;
+    Q4* y = output;
+    size_t even = length & ~(size_t) 1;
+    if (even) {
+        quantize_row_q4(x, y, even);
+    }
+    if (length & 1) {
+        y[even / 2] = quantize_scalar_q4(x[even], 0.0f);
+    }
+}
+
+static void convert_decode_quant4(const void* input, void* output, size_t length) {
+    const Q4* x = input;
+    float* y = output;
+    size_t even = length & ~(size_t) 1;
+    if (even) {
+        dequantize_row_q4(x, y, even);
+    }
+    if (length & 1) {
+        y[even] = dequantize_scalar_q4_index(x[even / 2], 0);
+    }
+}
+
+static void convert_encode_block_q8(const void* input, void* output, size_t length) {
+    quantize_row_block_q8(input, output, length);
+}
+
+static void convert_decode_block_q8(const void* input, void* output, size_t length) {
+    dequantize_row_block_q8(input, output, length);
+}
+
+static void convert_encode_block_q4(const void* input, void* output, size_t length) {
+    quantize_row_block_q4(input, output, length);
+}
+
+static void convert_decode_block_q4(const void* input, void* output, size_t length) {
+    dequantize_row_block_q4(input, output, length);
+}
+
+/**
+ * SSE2 Kernels
+ *
+ * cvtps2dq rounds to nearest even under the default MXCSR, like rintf(). Lanes are clamped in
+ * fp32 first (NaN lanes zeroed), so the saturating packs never saturate and the result matches
+ * the scalar path bit for bit. 32-bit lanes out of range are fixed up after the conversion.
+ */
+
+#if defined(__SSE2__)
+
+static inline __m128i convert_clamp_sse2(__m128 x, __m128 lo, __m128 hi) {
+    x = _mm_and_ps(x, _mm_cmpord_ps(x, x));
+    return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(x, lo), hi));
+}
+
+// cvtps2dq returns INT32_MIN for NaN and out-of-range lanes; the high ones flip to INT32_MAX.
+static inline __m128i convert_int32_sse2(__m128 x) {
+    __m128i big = _mm_castps_si128(_mm_cmpge_ps(x, _mm_set1_ps(0x1.0p31f)));
+    __m128i ordered = _mm_castps_si128(_mm_cmpord_ps(x, x));
+    return _mm_and_si128(_mm_xor_si128(_mm_cvtps_epi32(x), big), ordered);
+}
+
+// Lanes at or above 2^31 are converted from x - 2^31 and get their top bit back.
+static inline __m128i convert_uint32_sse2(__m128 x) {
+    const __m128 half = _mm_set1_ps(0x1.0p31f);
+    x = _mm_max_ps(x, _mm_setzero_ps()); // NaN and negatives become 0
+    __m128 big = _mm_cmpge_ps(x, half);
+    __m128i huge = _mm_castps_si128(_mm_cmpge_ps(x, _mm_set1_ps(0x1.0p32f)));
+    __m128i v = _mm_cvtps_epi32(_mm_sub_ps(x, _mm_and_ps(big, half)));
+    v = _mm_xor_si128(v, _mm_and_si128(_mm_castps_si128(big), _mm_set1_epi32(INT32_MIN)));
+    return _mm_or_si128(v, huge);
+}
+
+// Exact halves: hi * 2^16 and lo are both representable, so the sum rounds once.
+static inline __m128 convert_from_uint32_sse2(__m128i v) {
+    __m128 hi = _mm_cvtepi32_ps(_mm_srli_epi32(v, 16));
+    __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0xFFFF)));
+    return _mm_add_ps(_mm_mul_ps(hi, _mm_set1_ps(65536.0f)), lo);
+}
+
+static inline void convert_store_int16_sse2(float* y, __m128i v) {
+    _mm_storeu_ps(y, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)));
+    _mm_storeu_ps(y + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)));
+}
+
+static inline void convert_store_uint16_sse2(float* y, __m128i v) {
+    __m128i zero = _mm_setzero_si128();
+    _mm_storeu_ps(y, _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)));
+    _mm_storeu_ps(y + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)));
+}
+
+static inline void convert_store_uint8_sse2(float* y, __m128i v) {
+    __m128i zero = _mm_setzero_si128();
+    convert_store_uint16_sse2(y, _mm_unpacklo_epi8(v, zero));
+    convert_store_uint16_sse2(y + 8, _mm_unpackhi_epi8(v, zero));
+}
+
+static void convert_encode_int8_sse2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    int8_t* y = output;
+    const __m128 lo = _mm_set1_ps(INT8_MIN);
+    const __m128 hi = _mm_set1_ps(INT8_MAX);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i a = convert_clamp_sse2(_mm_loadu_ps(x + i), lo, hi);
+        __m128i b = convert_clamp_sse2(_mm_loadu_ps(x + i + 4), lo, hi);
+        __m128i c = convert_clamp_sse2(_mm_loadu_ps(x + i + 8), lo, hi);
+        __m128i d = convert_clamp_sse2(_mm_loadu_ps(x + i + 12), lo, hi);
+        __m128i v = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128((__m128i*) (y + i), v);
+    }
+    convert_encode_int8_scalar(x + i, y + i, length - i);
+}
+
+static void convert_encode_uint8_sse2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint8_t* y = output;
+    const __m128 lo = _mm_setzero_ps();
+    const __m128 hi = _mm_set1_ps(UINT8_MAX);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i a = convert_clamp_sse2(_mm_loadu_ps(x + i), lo, hi);
+        __m128i b = convert_clamp_sse2(_mm_loadu_ps(x + i + 4), lo, hi);
+        __m128i c = convert_clamp_sse2(_mm_loadu_ps(x + i + 8), lo, hi);
+        __m128i d = convert_clamp_sse2(_mm_loadu_ps(x + i + 12), lo, hi);
+        __m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128((__m128i*) (y + i), v);
+    }
+    convert_encode_uint8_scalar(x + i, y + i, length - i);
+}
+
+static void convert_encode_int16_sse2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    int16_t* y = output;
+    const __m128 lo = _mm_set1_ps(INT16_MIN);
+    const __m128 hi = _mm_set1_ps(INT16_MAX);
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i a = convert_clamp_sse2(_mm_loadu_ps(x + i), lo, hi);
+        __m128i b = convert_clamp_sse2(_mm_loadu_ps(x + i + 4), lo, hi);
+        _mm_storeu_si128((__m128i*) (y + i), _mm_packs_epi32(a, b));
+    }
+    convert_encode_int16_scalar(x + i, y + i, length - i);
+}
+
+// SSE2 has no unsigned 32-to-16 pack: bias into the signed range, pack, and flip the top bit.
+static void convert_encode_uint16_sse2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint16_t* y = output;
+    const __m128 lo = _mm_setzero_ps();
+    const __m128 hi = _mm_set1_ps(UINT16_MAX);
+    const __m128i bias = _mm_set1_epi32(32768);
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i a = _mm_sub_epi32(convert_clamp_sse2(_mm_loadu_ps(x + i), lo, hi), bias);
+        __m128i b = _mm_sub_epi32(convert_clamp_sse2(_mm_loadu_ps(x + i + 4), lo, hi), bias);
+        __m128i v = _mm_xor_si128(_mm_packs_epi32(a, b), _mm_set1_epi16(INT16_MIN));
+        _mm_storeu_si128((__m128i*) (y + i), v);
+    }
+    convert_encode_uint16_scalar(x + i, y + i, length - i);
+}
+
+static void convert_encode_int32_sse2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    int32_t* y = output;
+
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        _mm_storeu_si128((__m128i*) (y + i), convert_int32_sse2(_mm_loadu_ps(x + i)));
+    }
+    convert_encode_int32_scalar(x + i, y + i, length - i);
+}
+
+static void convert_encode_uint32_sse2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint32_t* y = output;
+
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        _mm_storeu_si128((__m128i*) (y + i), convert_uint32_sse2(_mm_loadu_ps(x + i)));
+    }
+    convert_encode_uint32_scalar(x + i, y + i, length - i);
+}
+
+// cmpneq is unordered, so NaN lanes are true like `x != 0.0f`.
+static void convert_encode_bool_sse2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint8_t* y = output;
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i a = _mm_castps_si128(_mm_cmpneq_ps(_mm_loadu_ps(x + i), zero));
+        __m128i b = _mm_castps_si128(_mm_cmpneq_ps(_mm_loadu_ps(x + i + 4), zero));
+        __m128i c = _mm_castps_si128(_mm_cmpneq_ps(_mm_loadu_ps(x + i + 8), zero));
+        __m128i d = _mm_castps_si128(_mm_cmpneq_ps(_mm_loadu_ps(x + i + 12), zero));
+        __m128i v = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128((__m128i*) (y + i), _mm_and_si128(v, _mm_set1_epi8(1)));
+    }
+    convert_encode_bool_scalar(x + i, y + i, length - i);
+}
+
+static void convert_decode_int8_sse2(const void* input, void* output, size_t length) {
+    const int8_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (x + i));
+        convert_store_int16_sse2(y + i, _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8));
+        convert_store_int16_sse2(y + i + 8, _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8));
+    }
+    convert_decode_int8_scalar(x + i, y + i, length - i);
+}
+
+static void convert_decode_uint8_sse2(const void* input, void* output, size_t length) {
+    const uint8_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        convert_store_uint8_sse2(y + i, _mm_loadu_si128((const __m128i*) (x + i)));
+    }
+    convert_decode_uint8_scalar(x + i, y + i, length - i);
+}
+
+static void convert_decode_int16_sse2(const void* input, void* output, size_t length) {
+    const int16_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        convert_store_int16_sse2(y + i, _mm_loadu_si128((const __m128i*) (x + i)));
+    }
+    convert_decode_int16_scalar(x + i, y + i, length - i);
+}
+
+static void convert_decode_uint16_sse2(const void* input, void* output, size_t length) {
+    const uint16_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        convert_store_uint16_sse2(y + i, _mm_loadu_si128((const __m128i*) (x + i)));
+    }
+    convert_decode_uint16_scalar(x + i, y + i, length - i);
+}
+
+static void convert_decode_int32_sse2(const void* input, void* output, size_t length) {
+    const int32_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (x + i));
+        _mm_storeu_ps(y + i, _mm_cvtepi32_ps(v));
+    }
+    convert_decode_int32_scalar(x + i, y + i, length - i);
+}
+
+static void convert_decode_uint32_sse2(const void* input, void* output, size_t length) {
+    const uint32_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (x + i));
+        _mm_storeu_ps(y + i, convert_from_uint32_sse2(v));
+    }
+    convert_decode_uint32_scalar(x + i, y + i, length - i);
+}
+
+static void convert_decode_bool_sse2(const void* input, void* output, size_t length) {
+    const uint8_t* x = input;
+    float* y = output;
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (x + i));
+        v = _mm_andnot_si128(_mm_cmpeq_epi8(v, zero), _mm_set1_epi8(1));
+        convert_store_uint8_sse2(y + i, v);
+    }
+    convert_decode_bool_scalar(x + i, y + i, length - i);
+}
+
+#else
+    #define convert_encode_int8_sse2 convert_encode_int8_scalar
+    #define convert_encode_uint8_sse2 convert_encode_uint8_scalar
+    #define convert_encode_int16_sse2 convert_encode_int16_scalar
+    #define convert_encode_uint16_sse2 convert_encode_uint16_scalar
+    #define convert_encode_int32_sse2 convert_encode_int32_scalar
+    #define convert_encode_uint32_sse2 convert_encode_uint32_scalar
+    #define convert_encode_bool_sse2 convert_encode_bool_scalar
+    #define convert_decode_int8_sse2 convert_decode_int8_scalar
+    #define convert_decode_uint8_sse2 convert_decode_uint8_scalar
+    #define convert_decode_int16_sse2 convert_decode_int16_scalar
+    #define convert_decode_uint16_sse2 convert_decode_uint16_scalar
+    #define convert_decode_int32_sse2 convert_decode_int32_scalar
+    #define convert_decode_uint32_sse2 convert_decode_uint32_scalar
+    #define convert_decode_bool_sse2 convert_decode_bool_scalar
+#endif // __SSE2__
+
+/**
+ * AVX2 Kernels
+ *
+ * Same scheme as SSE2 on eight lanes. The 256-bit packs work per 128-bit lane, so packed
+ * results are put back in order with a cross-lane permute.
+ */
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline __m256i convert_clamp_avx2(__m256 x, __m256 lo, __m256 hi) {
+    x = _mm256_and_ps(x, _mm256_cmp_ps(x, x, _CMP_ORD_Q));
+    return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, lo), hi));
+}
+
+CPU_TARGET_AVX2 static inline __m256i convert_int32_avx2(__m256 x) {
+    __m256i big = _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_set1_ps(0x1.0p31f), _CMP_GE_OQ));
+    __m256i ordered = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_ORD_Q));
+    return _mm256_and_si256(_mm256_xor_si256(_mm256_cvtps_epi32(x), big), ordered);
+}
+
+CPU_TARGET_AVX2 static inline __m256i convert_uint32_avx2(__m256 x) {
+    const __m256 half = _mm256_set1_ps(0x1.0p31f);
+    x = _mm256_max_ps(x, _mm256_setzero_ps());
+    __m256 big = _mm256_cmp_ps(x, half, _CMP_GE_OQ);
+    __m256i huge = _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_set1_ps(0x1.0p32f), _CMP_GE_OQ));
+    __m256i v = _mm256_cvtps_epi32(_mm256_sub_ps(x, _mm256_and_ps(big, half)));
+    v = _mm256_xor_si256(
+        v, _mm256_and_si256(_mm256_castps_si256(big), _mm256_set1_epi32(INT32_MIN))
+    );
+    return _mm256_or_si256(v, huge);
+}
+
+CPU_TARGET_AVX2 static inline __m256 convert_from_uint32_avx2(__m256i v) {
+    __m256 hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16));
+    __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xFFFF)));
+    return _mm256_add_ps(_mm256_mul_ps(hi, _mm256_set1_ps(65536.0f)), lo);
+}
+
+// Bytes of packs_epi16(packs_epi32(a, b), packs_epi32(c, d)) hold a0-3 b0-3 c0-3 d0-3 a4-7 ...
+CPU_TARGET_AVX2 static inline __m256i convert_order_bytes_avx2(__m256i v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+CPU_TARGET_AVX2 static void
+convert_encode_int8_avx2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    int8_t* y = output;
+    const __m256 lo = _mm256_set1_ps(INT8_MIN);
+    const __m256 hi = _mm256_set1_ps(INT8_MAX);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i a = convert_clamp_avx2(_mm256_loadu_ps(x + i), lo, hi);
+        __m256i b = convert_clamp_avx2(_mm256_loadu_ps(x + i + 8), lo, hi);
+        __m256i c = convert_clamp_avx2(_mm256_loadu_ps(x + i + 16), lo, hi);
+        __m256i d = convert_clamp_avx2(_mm256_loadu_ps(x + i + 24), lo, hi);
+        __m256i v = _mm256_packs_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+        _mm256_storeu_si256((__m256i*) (y + i), convert_order_bytes_avx2(v));
+    }
+    convert_encode_int8_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_encode_uint8_avx2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint8_t* y = output;
+    const __m256 lo = _mm256_setzero_ps();
+    const __m256 hi = _mm256_set1_ps(UINT8_MAX);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i a = convert_clamp_avx2(_mm256_loadu_ps(x + i), lo, hi);
+        __m256i b = convert_clamp_avx2(_mm256_loadu_ps(x + i + 8), lo, hi);
+        __m256i c = convert_clamp_avx2(_mm256_loadu_ps(x + i + 16), lo, hi);
+        __m256i d = convert_clamp_avx2(_mm256_loadu_ps(x + i + 24), lo, hi);
+        __m256i v = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+        _mm256_storeu_si256((__m256i*) (y + i), convert_order_bytes_avx2(v));
+    }
+    convert_encode_uint8_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_encode_int16_avx2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    int16_t* y = output;
+    const __m256 lo = _mm256_set1_ps(INT16_MIN);
+    const __m256 hi = _mm256_set1_ps(INT16_MAX);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i a = convert_clamp_avx2(_mm256_loadu_ps(x + i), lo, hi);
+        __m256i b = convert_clamp_avx2(_mm256_loadu_ps(x + i + 8), lo, hi);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i*) (y + i), v);
+    }
+    convert_encode_int16_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_encode_uint16_avx2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint16_t* y = output;
+    const __m256 lo = _mm256_setzero_ps();
+    const __m256 hi = _mm256_set1_ps(UINT16_MAX);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i a = convert_clamp_avx2(_mm256_loadu_ps(x + i), lo, hi);
+        __m256i b = convert_clamp_avx2(_mm256_loadu_ps(x + i + 8), lo, hi);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i*) (y + i), v);
+    }
+    convert_encode_uint16_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_encode_int32_avx2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    int32_t* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        _mm256_storeu_si256((__m256i*) (y + i), convert_int32_avx2(_mm256_loadu_ps(x + i)));
+    }
+    convert_encode_int32_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_encode_uint32_avx2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint32_t* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        _mm256_storeu_si256((__m256i*) (y + i), convert_uint32_avx2(_mm256_loadu_ps(x + i)));
+    }
+    convert_encode_uint32_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_encode_bool_avx2(const void* input, void* output, size_t length) {
+    const float* x = input;
+    uint8_t* y = output;
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i m[4];
+        for (size_t j = 0; j < 4; j++) {
+            __m256 mask = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 8 * j), zero, _CMP_NEQ_UQ);
+            m[j] = _mm256_castps_si256(mask);
+        }
+        __m256i v = _mm256_packs_epi16(
+            _mm256_packs_epi32(m[0], m[1]), _mm256_packs_epi32(m[2], m[3])
+        );
+        v = _mm256_and_si256(convert_order_bytes_avx2(v), _mm256_set1_epi8(1));
+        _mm256_storeu_si256((__m256i*) (y + i), v);
+    }
+    convert_encode_bool_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_decode_int8_avx2(const void* input, void* output, size_t length) {
+    const int8_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*) (x + i)));
+        _mm256_storeu_ps(y + i, _mm256_cvtepi32_ps(v));
+    }
+    convert_decode_int8_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_decode_uint8_avx2(const void* input, void* output, size_t length) {
+    const uint8_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (x + i)));
+        _mm256_storeu_ps(y + i, _mm256_cvtepi32_ps(v));
+    }
+    convert_decode_uint8_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_decode_int16_avx2(const void* input, void* output, size_t length) {
+    const int16_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) (x + i)));
+        _mm256_storeu_ps(y + i, _mm256_cvtepi32_ps(v));
+    }
+    convert_decode_int16_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_decode_uint16_avx2(const void* input, void* output, size_t length) {
+    const uint16_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (x + i)));
+        _mm256_storeu_ps(y + i, _mm256_cvtepi32_ps(v));
+    }
+    convert_decode_uint16_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_decode_int32_avx2(const void* input, void* output, size_t length) {
+    const int32_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (x + i));
+        _mm256_storeu_ps(y + i, _mm256_cvtepi32_ps(v));
+    }
+    convert_decode_int32_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_decode_uint32_avx2(const void* input, void* output, size_t length) {
+    const uint32_t* x = input;
+    float* y = output;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (x + i));
+        _mm256_storeu_ps(y + i, convert_from_uint32_avx2(v));
+    }
+    convert_decode_uint32_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+convert_decode_bool_avx2(const void* input, void* output, size_t length) {
+    const uint8_t* x = input;
+    float* y = output;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (x + i)));
+        __m256 mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero));
+        _mm256_storeu_ps(y + i, _mm256_andnot_ps(mask, one));
+    }
+    convert_decode_bool_scalar(x + i, y + i, length - i);
+}
+
+#endif // CPU_X86
+
+// Every level shares these; the integer and bool entries differ per level.
+#define CONVERT_SHARED_ENCODE \
+    [TYPE_FLOAT32] = convert_copy_fp32, [TYPE_FLOAT16] = convert_encode_fp16, \
+    [TYPE_BFLOAT16] = convert_encode_bf16, [TYPE_QUANT8] = convert_encode_quant8, \
+    [TYPE_QUANT4] = convert_encode_quant4, [TYPE_BLOCK_Q8] = convert_encode_block_q8, \
+    [TYPE_BLOCK_Q4] = convert_encode_block_q4, [TYPE_FLOAT8_E4M3] = convert_encode_e4m3, \
+    [TYPE_FLOAT8_E5M2] = convert_encode_e5m2
+
+#define CONVERT_SHARED_DECODE \
+    [TYPE_FLOAT32] = convert_copy_fp32, [TYPE_FLOAT16] = convert_decode_fp16, \
+    [TYPE_BFLOAT16] = convert_decode_bf16, [TYPE_QUANT8] = convert_decode_quant8, \
+    [TYPE_QUANT4] = convert_decode_quant4, [TYPE_BLOCK_Q8] = convert_decode_block_q8, \
+    [TYPE_BLOCK_Q4] = convert_decode_block_q4, [TYPE_FLOAT8_E4M3] = convert_decode_e4m3, \
+    [TYPE_FLOAT8_E5M2] = convert_decode_e5m2
+
+#define CONVERT_LEVEL_KERNELS(level) \
+    { \
+        .encode = { \
+            CONVERT_SHARED_ENCODE, \
+            [TYPE_INT32] = convert_encode_int32_##level, \
+            [TYPE_INT16] = convert_encode_int16_##level, \
+            [TYPE_INT8] = convert_encode_int8_##level, \
+            [TYPE_UINT32] = convert_encode_uint32_##level, \
+            [TYPE_UINT16] = convert_encode_uint16_##level, \
+            [TYPE_UINT8] = convert_encode_uint8_##level, \
+            [TYPE_BOOL] = convert_encode_bool_##level, \
+            [TYPE_CHAR] = convert_encode_uint8_##level, \
+        }, \
+        .decode = { \
+            CONVERT_SHARED_DECODE, \
+            [TYPE_INT32] = convert_decode_int32_##level, \
+            [TYPE_INT16] = convert_decode_int16_##level, \
+            [TYPE_INT8] = convert_decode_int8_##level, \
+            [TYPE_UINT32] = convert_decode_uint32_##level, \
+            [TYPE_UINT16] = convert_decode_uint16_##level, \
+            [TYPE_UINT8] = convert_decode_uint8_##level, \
+            [TYPE_BOOL] = convert_decode_bool_##level, \
+            [TYPE_CHAR] = convert_decode_uint8_##level, \
+        }, \
+    }
+
+static const ConvertKernels CONVERT_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = CONVERT_LEVEL_KERNELS(scalar),
+    [CPU_LEVEL_SSE2] = CONVERT_LEVEL_KERNELS(sse2),
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = CONVERT_LEVEL_KERNELS(avx2),
+    [CPU_LEVEL_AVX512] = CONVERT_LEVEL_KERNELS(avx2),
+#endif
+};
+
+/**
+ * Conversion Paths
+ */
+
+static void convert_path_copy(
+    const ConvertKernels* kernels,
+    const uint8_t* input,
+    DataTypeId input_type,
+    uint8_t* output,
+    DataTypeId output_type,
+    size_t length
+) {
+    (void) kernels;
+    (void) output_type;
+    memcpy(output, input, data_type_row_size(input_type, length));
+}
+
+static void convert_path_encode(
+    const ConvertKernels* kernels,
+    const uint8_t* input,
+    DataTypeId input_type,
+    uint8_t* output,
+    DataTypeId output_type,
+    size_t length
+) {
+    (void) input_type;
+    kernels->encode[output_type](input, output, length);
+}
+
+static void convert_path_decode(
+    const ConvertKernels* kernels,
+    const uint8_t* input,
+    DataTypeId input_type,
+    uint8_t* output,
+    DataTypeId output_type,
+    size_t length
+) {
+    (void) output_type;
+    kernels->decode[input_type](input, output, length);
+}
+
+static void convert_path_integer(
+    const ConvertKernels* kernels,
+    const uint8_t* input,
+    DataTypeId input_type,
+    uint8_t* output,
+    DataTypeId output_type,
+    size_t length
+) {
+    (void) kernels;
+    int64_t tile[CONVERT_TILE];
+    size_t input_size = data_type_size(input_type);
+    size_t output_size = data_type_size(output_type);
+
+    for (size_t i = 0; i < length; i += CONVERT_TILE) {
+        size_t n = length - i < CONVERT_TILE ? length - i : CONVERT_TILE;
+        CONVERT_WIDEN[input_type](input + i * input_size, tile, n);
+        CONVERT_NARROW[output_type](tile, output + i * output_size, n);
+    }
+}
+
+static void convert_path_float(
+    const ConvertKernels* kernels,
+    const uint8_t* input,
+    DataTypeId input_type,
+    uint8_t* output,
+    DataTypeId output_type,
+    size_t length
+) {
+    alignas(64) float tile[CONVERT_TILE];
+
+    for (size_t i = 0; i < length; i += CONVERT_TILE) {
+        size_t n = length - i < CONVERT_TILE ? length - i : CONVERT_TILE;
+        kernels->decode[input_type](input + data_type_row_size(input_type, i), tile, n);
+        kernels->encode[output_type](tile, output + data_type_row_size(output_type, i), n);
+    }
+}
+
+static ConvertPath convert_path(DataTypeId input_type, DataTypeId output_type) {
+    if (input_type == output_type) {
+        return convert_path_copy;
+    }
+    if (input_type == TYPE_FLOAT32) {
+        return convert_path_encode;
+    }
+    if (output_type == TYPE_FLOAT32) {
+        return convert_path_decode;
+    }
+    if (CONVERT_WIDEN[input_type] && CONVERT_NARROW[output_type]) {
+        return convert_path_integer;
+    }
+    return convert_path_float;
+}
+
+/**
+ * Strided Rows
+ */
+
+typedef struct ConvertTask {
+    const ConvertKernels* kernels;
+    ConvertPath path;
+    const uint8_t* input;
+    DataTypeId input_type;
+    size_t input_stride;
+    uint8_t* output;
+    DataTypeId output_type;
+    size_t output_stride;
+    size_t length;
+    size_t chunks; // per row
+} ConvertTask;
+
+static void convert_rows_task(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const ConvertTask* t = context;
+
+    for (size_t item = begin; item < end; item++) {
+        size_t row = item / t->chunks;
+        size_t offset = item % t->chunks * CONVERT_CHUNK;
+        size_t n = t->length - offset < CONVERT_CHUNK ? t->length - offset : CONVERT_CHUNK;
+
+        const uint8_t* input = t->input + row * t->input_stride;
+        uint8_t* output = t->output + row * t->output_stride;
+        t->path(
+            t->kernels,
+            input + data_type_row_size(t->input_type, offset),
+            t->input_type,
+            output + data_type_row_size(t->output_type, offset),
+            t->output_type,
+            n
+        );
+    }
+}
+
+/**
+ * Public Functions
+ */
+
+bool convert_row(
+    const void* input, DataTypeId input_type, void* output, DataTypeId output_type, size_t length
+) {
+    return convert_rows(NULL, input, input_type, 0, output, output_type, 0, 1, length);
+}
+
+bool convert_rows(
+    ThreadPool* pool,
+    const void* input,
+    DataTypeId input_type,
+    size_t input_stride,
+    void* output,
+    DataTypeId output_type,
+    size_t output_stride,
+    size_t rows,
+    size_t length
+) {
+    if (input_type >= TYPE_COUNT || output_type >= TYPE_COUNT) {
+        return false;
+    }
+    if (0 == rows || 0 == length) {
+        return true;
+    }
+
+    assert(input != NULL);
+    assert(output != NULL);
+
+    ConvertTask task = {
+        .kernels = &CONVERT_KERNELS[cpu_level()],
+        .path = convert_path(input_type, output_type),
+        .input = input,
+        .input_type = input_type,
+        .input_stride = input_stride,
+        .output = output,
+        .output_type = output_type,
+        .output_stride = output_stride,
+        .length = length,
+        .chunks = (length + CONVERT_CHUNK - 1) / CONVERT_CHUNK,
+    };
+
+    // Short rows are grouped so that each scheduling unit covers about one chunk.
+    size_t grain = task.chunks > 1 ? 1 : CONVERT_CHUNK / length;
+    if (1 == rows * task.chunks) {
+        convert_rows_task(&task, 0, 1, 0);
+    } else {
+        thread_pool_parallel_for(pool, rows * task.chunks, grain, convert_rows_task, &task);
+    }
+    return true;
+}
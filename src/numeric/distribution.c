@@ -0,0 +1,840 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/numeric/distribution.c
+ * @brief Distributions and sampling over the generators in `numeric/random.h`.
+ *
+ * Based on:
+ *  - "Fast Random Integer Generation in an Interval" by Lemire (2019)
+ *    @ref https://arxiv.org/abs/1805.10941
+ *  - "The Ziggurat Method for Generating Random Variables" by Marsaglia & Tsang (2000)
+ *    @ref https://doi.org/10.18637/jss.v005.i08
+ *  - "A Linear Algorithm For Generating Random Numbers With a Given Distribution" by Vose (1991)
+ *    @ref https://doi.org/10.1109/32.92917
+ *  - "Reservoir-Sampling Algorithms of Time Complexity O(n(1 + log(N/n)))" by Li (1994)
+ *    @ref https://doi.org/10.1145/198429.198435
+ */
+
+#include "core/cpu.h"
+#include "numeric/distribution.h"
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+/**
+ * Private Definitions
+ */
+
+__extension__ typedef unsigned __int128 RandomU128;
+
+#define RANDOM_TILE 256 // raw draws generated at a time by the fills
+
+static inline size_t random_tile(size_t remaining) {
+    return remaining < RANDOM_TILE ? remaining : RANDOM_TILE;
+}
+
+// Uniform in (0, 1), for logarithms.
+static inline double random_open(Random* random) {
+    return ((double) (random_u64(random) >> 12) + 0.5) * 0x1.0p-52;
+}
+
+/**
+ * Bounded Integers
+ *
+ * x * bound / 2^w lands in [0, bound) and is exact unless the low word of the product falls
+ * below 2^w mod bound; only then is the (slow) modulo computed, and the draw is retried.
+ */
+
+uint32_t random_bounded_u32(Random* random, uint32_t bound) {
+    assert(bound > 0);
+
+    uint64_t m = (uint64_t) random_u32(random) * bound;
+    uint32_t low = (uint32_t) m;
+    if (low < bound) {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            m = (uint64_t) random_u32(random) * bound;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+uint64_t random_bounded_u64(Random* random, uint64_t bound) {
+    assert(bound > 0);
+
+    RandomU128 m = (RandomU128) random_u64(random) * bound;
+    uint64_t low = (uint64_t) m;
+    if (low < bound) {
+        uint64_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            m = (RandomU128) random_u64(random) * bound;
+            low = (uint64_t) m;
+        }
+    }
+    return (uint64_t) (m >> 64);
+}
+
+int64_t random_range(Random* random, int64_t low, int64_t high) {
+    assert(low < high);
+    uint64_t span = (uint64_t) high - (uint64_t) low;
+    return (int64_t) ((uint64_t) low + random_bounded_u64(random, span));
+}
+
+void random_fill_bounded(Random* random, uint32_t* output, size_t length, uint32_t bound) {
+    assert(bound > 0);
+    assert(output != NULL || 0 == length);
+
+    uint32_t threshold = (0u - bound) % bound;
+    uint32_t bits[RANDOM_TILE];
+    for (size_t i = 0; i < length; i += RANDOM_TILE) {
+        size_t n = random_tile(length - i);
+        random_fill_u32(random, bits, n);
+        for (size_t j = 0; j < n; j++) {
+            uint64_t m = (uint64_t) bits[j] * bound;
+            while ((uint32_t) m < threshold) {
+                m = (uint64_t) random_u32(random) * bound;
+            }
+            output[i + j] = (uint32_t) (m >> 32);
+        }
+    }
+}
+
+void random_fill_range(Random* random, int32_t* output, size_t length, int32_t low, int32_t high) {
+    assert(low < high);
+
+    // Written in place as offsets, then shifted; both views are the same 32-bit words.
+    uint32_t* offsets = (uint32_t*) output;
+    random_fill_bounded(random, offsets, length, (uint32_t) ((int64_t) high - low));
+    for (size_t i = 0; i < length; i++) {
+        output[i] = (int32_t) ((int64_t) low + offsets[i]);
+    }
+}
+
+void random_fill_uniform(Random* random, float* output, size_t length, float low, float high) {
+    assert(low < high);
+
+    // low + span * u can round up to high; the largest float below it stands in. Bounds further
+    // apart than FLT_MAX overflow the span, so they blend the two bounds instead, each term
+    // staying within its bound, and clamp the rounding at low.
+    float span = high - low;
+    float below = nextafterf(high, low);
+    bool wide = isinf(span);
+    for (size_t i = 0; i < length; i += RANDOM_TILE) {
+        size_t n = random_tile(length - i);
+        random_fill_float(random, output + i, n);
+        for (size_t j = 0; j < n; j++) {
+            float u = output[i + j];
+            float value = wide ? fmaxf(low * (1.0f - u) + high * u, low) : low + span * u;
+            output[i + j] = value < high ? value : below;
+        }
+    }
+}
+
+/**
+ * Ziggurat
+ *
+ * The density is covered by `layers` equal-area strips: x[0] is the width the base strip would
+ * have as a rectangle (it carries the tail), x[1] = r, and x[layers] = 0 at the peak. A sample
+ * picks a strip and a point in it; it is accepted outright if it falls under the next strip's
+ * edge, and otherwise tested against the density (the wedge) or drawn from the tail.
+ */
+
+#define RANDOM_NORMAL_LAYERS 128
+#define RANDOM_NORMAL_R 3.442619855899
+#define RANDOM_NORMAL_V 9.91256303526217e-3
+
+#define RANDOM_EXPONENTIAL_LAYERS 256
+#define RANDOM_EXPONENTIAL_R 7.69711747013104972
+#define RANDOM_EXPONENTIAL_V 3.949659822581572e-3
+
+static double random_normal_x[RANDOM_NORMAL_LAYERS + 1];
+static double random_normal_f[RANDOM_NORMAL_LAYERS + 1];
+static double random_exponential_x[RANDOM_EXPONENTIAL_LAYERS + 1];
+static double random_exponential_f[RANDOM_EXPONENTIAL_LAYERS + 1];
+static pthread_once_t random_ziggurat_once = PTHREAD_ONCE_INIT;
+
+static double random_normal_density(double x) {
+    return exp(-0.5 * x * x);
+}
+
+static double random_normal_inverse(double y) {
+    return sqrt(-2.0 * log(y));
+}
+
+static double random_exponential_density(double x) {
+    return exp(-x);
+}
+
+static double random_exponential_inverse(double y) {
+    return -log(y);
+}
+
+static void random_ziggurat_build(
+    double* x,
+    double* f,
+    size_t layers,
+    double r,
+    double v,
+    double (*density)(double),
+    double (*inverse)(double)
+) {
+    x[0] = v / density(r);
+    x[1] = r;
+    for (size_t i = 1; i + 1 < layers; i++) {
+        x[i + 1] = inverse(density(x[i]) + v / x[i]);
+    }
+    x[layers] = 0.0;
+
+    for (size_t i = 0; i <= layers; i++) {
+        f[i] = density(x[i]);
+    }
+}
+
+static void random_ziggurat_initialize(void) {
+    random_ziggurat_build(
+        random_normal_x,
+        random_normal_f,
+        RANDOM_NORMAL_LAYERS,
+        RANDOM_NORMAL_R,
+        RANDOM_NORMAL_V,
+        random_normal_density,
+        random_normal_inverse
+    );
+    random_ziggurat_build(
+        random_exponential_x,
+        random_exponential_f,
+        RANDOM_EXPONENTIAL_LAYERS,
+        RANDOM_EXPONENTIAL_R,
+        RANDOM_EXPONENTIAL_V,
+        random_exponential_density,
+        random_exponential_inverse
+    );
+}
+
+// One attempt from 64 random bits: the strip from the low bits, the position from the top 53.
+static inline bool random_normal_try(Random* random, uint64_t bits, double* value) {
+    size_t i = bits & (RANDOM_NORMAL_LAYERS - 1);
+    double u = (double) (int64_t) (bits >> 11) * 0x1.0p-52 - 1.0; // [-1, 1)
+    double x = u * random_normal_x[i];
+
+    if (fabs(x) < random_normal_x[i + 1]) {
+        *value = x;
+        return true;
+    }
+
+    if (0 == i) {
+        // Marsaglia's tail method: exponential proposals beyond r.
+        double a, b;
+        do {
+            a = -log(random_open(random)) / RANDOM_NORMAL_R;
+            b = -log(random_open(random));
+        } while (b + b < a * a);
+        *value = u < 0.0 ? -(RANDOM_NORMAL_R + a) : RANDOM_NORMAL_R + a;
+        return true;
+    }
+
+    double f0 = random_normal_f[i];
+    double y = f0 + random_double(random) * (random_normal_f[i + 1] - f0);
+    *value = x;
+    return y < random_normal_density(x);
+}
+
+static inline bool random_exponential_try(Random* random, uint64_t bits, double* value) {
+    size_t i = bits & (RANDOM_EXPONENTIAL_LAYERS - 1);
+    double x = (double) (int64_t) (bits >> 11) * 0x1.0p-53 * random_exponential_x[i];
+
+    if (x < random_exponential_x[i + 1]) {
+        *value = x;
+        return true;
+    }
+
+    if (0 == i) {
+        // The tail of an exponential is an exponential shifted by r.
+        *value = RANDOM_EXPONENTIAL_R - log(random_open(random));
+        return true;
+    }
+
+    double f0 = random_exponential_f[i];
+    double y = f0 + random_double(random) * (random_exponential_f[i + 1] - f0);
+    *value = x;
+    return y < random_exponential_density(x);
+}
+
+double random_normal(Random* random) {
+    pthread_once(&random_ziggurat_once, random_ziggurat_initialize);
+
+    double value;
+    while (!random_normal_try(random, random_u64(random), &value)) {}
+    return value;
+}
+
+double random_exponential(Random* random) {
+    pthread_once(&random_ziggurat_once, random_ziggurat_initialize);
+
+    double value;
+    while (!random_exponential_try(random, random_u64(random), &value)) {}
+    return value;
+}
+
+// Attempts take their bits from a batch; rejections and tails draw extra values singly.
+#define RANDOM_ZIGGURAT_FILL(try, transform)                             \
+    do {                                                                 \
+        pthread_once(&random_ziggurat_once, random_ziggurat_initialize); \
+        uint64_t bits[RANDOM_TILE];                                      \
+        size_t used = 0;                                                 \
+        size_t drawn = 0;                                                \
+        for (size_t i = 0; i < length; i++) {                            \
+            double value;                                                \
+            do {                                                         \
+                if (used == drawn) {                                     \
+                    drawn = random_tile(length - i);                     \
+                    random_fill_u64(random, bits, drawn);                \
+                    used = 0;                                            \
+                }                                                        \
+            } while (!try(random, bits[used++], &value));                \
+            output[i] = transform;                                       \
+        }                                                                \
+    } while (0)
+
+void random_fill_normal(Random* random, float* output, size_t length, float mean, float stddev) {
+    assert(output != NULL || 0 == length);
+    RANDOM_ZIGGURAT_FILL(random_normal_try, mean + stddev * (float) value);
+}
+
+void random_fill_exponential(Random* random, float* output, size_t length, float rate) {
+    assert(output != NULL || 0 == length);
+    assert(rate > 0.0f);
+    RANDOM_ZIGGURAT_FILL(random_exponential_try, (float) value / rate);
+}
+
+/**
+ * Box-Muller
+ *
+ * z0, z1 = sqrt(-2 ln u1) (cos 2πu2, sin 2πu2). Both uniforms come from 24-bit integers: u1 is
+ * (k + 1) 2^-24 in (0, 1], and 2πu2 is reduced exactly in integers to the nearest quarter turn
+ * j plus an angle in [-π/4, π/4], where Cephes' sinf/cosf polynomials apply. ln is Cephes' logf.
+ * Each kernel takes 2 * half words: u1 from the first half, u2 from the second, and writes the
+ * cosine outputs to the first half of `output` and the sines to the second.
+ */
+
+#define RANDOM_SQRT2 1.41421356237309504880f
+#define RANDOM_TURN 0x1.921FB6p-22f // 2π / 2^24
+
+typedef void (*RandomBoxMuller)(
+    const uint32_t* bits, float* output, size_t half, float mean, float stddev
+);
+
+#define RANDOM_LOG_P0 7.0376836292e-2f
+#define RANDOM_LOG_P1 -1.1514610310e-1f
+#define RANDOM_LOG_P2 1.1676998740e-1f
+#define RANDOM_LOG_P3 -1.2420140846e-1f
+#define RANDOM_LOG_P4 1.4249322787e-1f
+#define RANDOM_LOG_P5 -1.6668057665e-1f
+#define RANDOM_LOG_P6 2.0000714765e-1f
+#define RANDOM_LOG_P7 -2.4999993993e-1f
+#define RANDOM_LOG_P8 3.3333331174e-1f
+#define RANDOM_LOG_Q1 -2.12194440e-4f
+#define RANDOM_LOG_Q2 0.693359375f
+
+#define RANDOM_SIN_P0 -1.9515295891e-4f
+#define RANDOM_SIN_P1 8.3321608736e-3f
+#define RANDOM_SIN_P2 -1.6666654611e-1f
+#define RANDOM_COS_P0 2.443315711809948e-5f
+#define RANDOM_COS_P1 -1.388731625493765e-3f
+#define RANDOM_COS_P2 4.166664568298827e-2f
+
+// ln(x) for normal, positive x.
+static inline float random_log_scalar(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int32_t e = (int32_t) (bits >> 23) - 127;
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > RANDOM_SQRT2) {
+        m -= m * 0.5f;
+        e++;
+    }
+
+    float fe = (float) e;
+    float t = m - 1.0f;
+    float z = t * t;
+    float p = RANDOM_LOG_P0;
+    p = p * t + RANDOM_LOG_P1;
+    p = p * t + RANDOM_LOG_P2;
+    p = p * t + RANDOM_LOG_P3;
+    p = p * t + RANDOM_LOG_P4;
+    p = p * t + RANDOM_LOG_P5;
+    p = p * t + RANDOM_LOG_P6;
+    p = p * t + RANDOM_LOG_P7;
+    p = p * t + RANDOM_LOG_P8;
+    float y = p * t * z;
+    y += RANDOM_LOG_Q1 * fe;
+    y += -0.5f * z;
+    t += y;
+    return t + RANDOM_LOG_Q2 * fe;
+}
+
+static inline void random_box_muller_pair(
+    uint32_t radius_bits, uint32_t angle_bits, float* cosine, float* sine, float mean, float stddev
+) {
+    float u = (float) ((radius_bits >> 8) + 1) * 0x1.0p-24f;
+    float radius = stddev * sqrtf(-2.0f * random_log_scalar(u));
+
+    int32_t k = (int32_t) (angle_bits >> 8);
+    int32_t j = (k + (1 << 21)) >> 22;
+    float a = (float) (k - (j << 22)) * RANDOM_TURN;
+    float z = a * a;
+    float s = ((RANDOM_SIN_P0 * z + RANDOM_SIN_P1) * z + RANDOM_SIN_P2) * z * a + a;
+    float c = ((RANDOM_COS_P0 * z + RANDOM_COS_P1) * z + RANDOM_COS_P2) * z * z - 0.5f * z + 1.0f;
+
+    uint32_t q = (uint32_t) j & 3;
+    float sv = q & 1 ? c : s;
+    float cv = q & 1 ? s : c;
+    sv = q & 2 ? -sv : sv;
+    cv = (q + 1) & 2 ? -cv : cv;
+
+    *cosine = mean + radius * cv;
+    *sine = mean + radius * sv;
+}
+
+static void random_box_muller_scalar(
+    const uint32_t* bits, float* output, size_t half, float mean, float stddev
+) {
+    for (size_t j = 0; j < half; j++) {
+        random_box_muller_pair(
+            bits[j], bits[half + j], &output[j], &output[half + j], mean, stddev
+        );
+    }
+}
+
+#if defined(__SSE2__)
+
+static inline __m128 random_select_sse2(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 random_log_sse2(__m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(
+        _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)
+    ));
+    __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(RANDOM_SQRT2));
+    m = _mm_sub_ps(m, _mm_and_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+    __m128 fe = _mm_add_ps(_mm_cvtepi32_ps(e), _mm_and_ps(big, _mm_set1_ps(1.0f)));
+
+    __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+    __m128 z = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(RANDOM_LOG_P0);
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P1));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P2));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P3));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P4));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P5));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P6));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P7));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(RANDOM_LOG_P8));
+    __m128 y = _mm_mul_ps(_mm_mul_ps(p, t), z);
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(RANDOM_LOG_Q1), fe));
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(-0.5f), z));
+    t = _mm_add_ps(t, y);
+    return _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(RANDOM_LOG_Q2), fe));
+}
+
+static void random_box_muller_sse2(
+    const uint32_t* bits, float* output, size_t half, float mean, float stddev
+) {
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128 vmean = _mm_set1_ps(mean);
+    const __m128 vstddev = _mm_set1_ps(stddev);
+
+    size_t j = 0;
+    for (; j + 4 <= half; j += 4) {
+        __m128i r = _mm_loadu_si128((const __m128i*) (bits + j));
+        __m128i k = _mm_srli_epi32(_mm_loadu_si128((const __m128i*) (bits + half + j)), 8);
+
+        __m128 u = _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_add_epi32(_mm_srli_epi32(r, 8), one)), _mm_set1_ps(0x1.0p-24f)
+        );
+        __m128 radius = _mm_mul_ps(
+            vstddev, _mm_sqrt_ps(_mm_mul_ps(_mm_set1_ps(-2.0f), random_log_sse2(u)))
+        );
+
+        __m128i q = _mm_srli_epi32(_mm_add_epi32(k, _mm_set1_epi32(1 << 21)), 22);
+        __m128 a = _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_sub_epi32(k, _mm_slli_epi32(q, 22))), _mm_set1_ps(RANDOM_TURN)
+        );
+        __m128 z = _mm_mul_ps(a, a);
+        __m128 s = _mm_mul_ps(_mm_set1_ps(RANDOM_SIN_P0), z);
+        s = _mm_add_ps(s, _mm_set1_ps(RANDOM_SIN_P1));
+        s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(RANDOM_SIN_P2));
+        s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), a), a);
+        __m128 c = _mm_mul_ps(_mm_set1_ps(RANDOM_COS_P0), z);
+        c = _mm_add_ps(c, _mm_set1_ps(RANDOM_COS_P1));
+        c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(RANDOM_COS_P2));
+        c = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+        c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+        __m128 sv = random_select_sse2(swap, c, s);
+        __m128 cv = random_select_sse2(swap, s, c);
+        sv = _mm_xor_ps(sv, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30)));
+        cv = _mm_xor_ps(
+            cv, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30))
+        );
+
+        _mm_storeu_ps(output + j, _mm_add_ps(vmean, _mm_mul_ps(radius, cv)));
+        _mm_storeu_ps(output + half + j, _mm_add_ps(vmean, _mm_mul_ps(radius, sv)));
+    }
+
+    for (; j < half; j++) {
+        random_box_muller_pair(
+            bits[j], bits[half + j], &output[j], &output[half + j], mean, stddev
+        );
+    }
+}
+
+#else
+
+    #define random_box_muller_sse2 random_box_muller_scalar
+
+#endif // __SSE2__
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline __m256 random_log_avx2(__m256 x) {
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)
+    ));
+    __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(RANDOM_SQRT2), _CMP_GT_OQ);
+    m = _mm256_sub_ps(m, _mm256_and_ps(big, _mm256_mul_ps(m, _mm256_set1_ps(0.5f))));
+    __m256 fe = _mm256_add_ps(_mm256_cvtepi32_ps(e), _mm256_and_ps(big, _mm256_set1_ps(1.0f)));
+
+    __m256 t = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    __m256 z = _mm256_mul_ps(t, t);
+    __m256 p = _mm256_set1_ps(RANDOM_LOG_P0);
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P4));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P5));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P6));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P7));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(RANDOM_LOG_P8));
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, t), z);
+    y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(RANDOM_LOG_Q1), fe));
+    y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(-0.5f), z));
+    t = _mm256_add_ps(t, y);
+    return _mm256_add_ps(t, _mm256_mul_ps(_mm256_set1_ps(RANDOM_LOG_Q2), fe));
+}
+
+CPU_TARGET_AVX2 static void random_box_muller_avx2(
+    const uint32_t* bits, float* output, size_t half, float mean, float stddev
+) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256 vmean = _mm256_set1_ps(mean);
+    const __m256 vstddev = _mm256_set1_ps(stddev);
+
+    size_t j = 0;
+    for (; j + 8 <= half; j += 8) {
+        __m256i r = _mm256_loadu_si256((const __m256i*) (bits + j));
+        __m256i k = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i*) (bits + half + j)), 8);
+
+        __m256 u = _mm256_mul_ps(
+            _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_srli_epi32(r, 8), one)),
+            _mm256_set1_ps(0x1.0p-24f)
+        );
+        __m256 radius = _mm256_mul_ps(
+            vstddev, _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), random_log_avx2(u)))
+        );
+
+        __m256i q = _mm256_srli_epi32(_mm256_add_epi32(k, _mm256_set1_epi32(1 << 21)), 22);
+        __m256 a = _mm256_mul_ps(
+            _mm256_cvtepi32_ps(_mm256_sub_epi32(k, _mm256_slli_epi32(q, 22))),
+            _mm256_set1_ps(RANDOM_TURN)
+        );
+        __m256 z = _mm256_mul_ps(a, a);
+        __m256 s = _mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(RANDOM_SIN_P0), z), _mm256_set1_ps(RANDOM_SIN_P1)
+        );
+        s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(RANDOM_SIN_P2));
+        s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), a), a);
+        __m256 c = _mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(RANDOM_COS_P0), z), _mm256_set1_ps(RANDOM_COS_P1)
+        );
+        c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(RANDOM_COS_P2));
+        c = _mm256_sub_ps(
+            _mm256_mul_ps(_mm256_mul_ps(c, z), z), _mm256_mul_ps(_mm256_set1_ps(0.5f), z)
+        );
+        c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+        __m256 sv = _mm256_blendv_ps(s, c, swap);
+        __m256 cv = _mm256_blendv_ps(c, s, swap);
+        sv = _mm256_xor_ps(
+            sv, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, two), 30))
+        );
+        cv = _mm256_xor_ps(
+            cv,
+            _mm256_castsi256_ps(
+                _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), two), 30)
+            )
+        );
+
+        _mm256_storeu_ps(output + j, _mm256_add_ps(vmean, _mm256_mul_ps(radius, cv)));
+        _mm256_storeu_ps(output + half + j, _mm256_add_ps(vmean, _mm256_mul_ps(radius, sv)));
+    }
+
+    for (; j < half; j++) {
+        random_box_muller_pair(
+            bits[j], bits[half + j], &output[j], &output[half + j], mean, stddev
+        );
+    }
+}
+
+#endif // CPU_X86
+
+// AVX-512 runs the AVX2 kernel.
+static const RandomBoxMuller RANDOM_BOX_MULLER[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = random_box_muller_scalar,
+    [CPU_LEVEL_SSE2] = random_box_muller_sse2,
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = random_box_muller_avx2,
+    [CPU_LEVEL_AVX512] = random_box_muller_avx2,
+#endif
+};
+
+void random_fill_normal_box_muller(
+    Random* random, float* output, size_t length, float mean, float stddev
+) {
+    assert(output != NULL || 0 == length);
+
+    RandomBoxMuller kernel = RANDOM_BOX_MULLER[cpu_level()];
+    uint32_t bits[RANDOM_TILE];
+    float tile[RANDOM_TILE];
+    for (size_t i = 0; i < length; i += RANDOM_TILE) {
+        size_t n = random_tile(length - i);
+        size_t half = (n + 1) / 2;
+        random_fill_u32(random, bits, 2 * half);
+        if (n == 2 * half) {
+            kernel(bits, output + i, half, mean, stddev);
+        } else {
+            kernel(bits, tile, half, mean, stddev);
+            memcpy(output + i, tile, n * sizeof(float));
+        }
+    }
+}
+
+/**
+ * Shuffling and Reservoir Sampling
+ */
+
+static inline size_t random_index(Random* random, size_t bound) {
+    if (bound <= UINT32_MAX) {
+        return random_bounded_u32(random, (uint32_t) bound);
+    }
+    return (size_t) random_bounded_u64(random, bound);
+}
+
+static void random_swap(uint8_t* a, uint8_t* b, size_t size) {
+    uint8_t buffer[64];
+    while (size) {
+        size_t n = size < sizeof(buffer) ? size : sizeof(buffer);
+        memcpy(buffer, a, n);
+        memcpy(a, b, n);
+        memcpy(b, buffer, n);
+        a += n;
+        b += n;
+        size -= n;
+    }
+}
+
+void random_shuffle(Random* random, void* base, size_t count, size_t size) {
+    assert(base != NULL || 0 == count);
+
+    uint8_t* bytes = base;
+    for (size_t i = count; i > 1; i--) {
+        size_t j = random_index(random, i);
+        if (j != i - 1) {
+            random_swap(bytes + j * size, bytes + (i - 1) * size, size);
+        }
+    }
+}
+
+size_t random_reservoir(
+    Random* random, const void* input, size_t count, size_t size, void* output, size_t k
+) {
+    assert(input != NULL || 0 == count);
+    assert(output != NULL || 0 == k);
+
+    const uint8_t* in = input;
+    uint8_t* out = output;
+    if (count <= k) {
+        memcpy(out, in, count * size);
+        return count;
+    }
+    memcpy(out, in, k * size);
+    if (0 == k) {
+        return 0;
+    }
+
+    // w is the largest of k uniform keys; the next item to beat it is a geometric skip away.
+    double w = exp(log(random_open(random)) / (double) k);
+    size_t i = k - 1;
+    for (;;) {
+        double skip = floor(log(random_open(random)) / log1p(-w));
+        if (!(skip < (double) (count - 1 - i))) {
+            break;
+        }
+        i += (size_t) skip + 1;
+        memcpy(out + random_index(random, k) * size, in + i * size, size);
+        w *= exp(log(random_open(random)) / (double) k);
+    }
+    return k;
+}
+
+/**
+ * Alias Tables
+ */
+
+bool random_alias_create(RandomAlias* table, const float* weights, size_t count) {
+    assert(table != NULL);
+    assert(weights != NULL || 0 == count);
+
+    memset(table, 0, sizeof(*table));
+    if (0 == count || count > UINT32_MAX) {
+        return false;
+    }
+
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        if (!(weights[i] >= 0.0f) || isinf(weights[i])) {
+            return false;
+        }
+        sum += (double) weights[i];
+    }
+    if (!(sum > 0.0) || isinf(sum)) {
+        return false;
+    }
+
+    float* probability = malloc(count * sizeof(float));
+    uint32_t* alias = malloc(count * sizeof(uint32_t));
+    double* scaled = malloc(count * sizeof(double));
+    uint32_t* work = malloc(count * sizeof(uint32_t));
+    if (!probability || !alias || !scaled || !work) {
+        free(probability);
+        free(alias);
+        free(scaled);
+        free(work);
+        return false;
+    }
+
+    // Under-full columns stack up from the front of `work`, over-full ones down from the back.
+    size_t small = 0;
+    size_t large = 0;
+    for (size_t i = 0; i < count; i++) {
+        scaled[i] = (double) weights[i] * (double) count / sum;
+        if (scaled[i] < 1.0) {
+            work[small++] = (uint32_t) i;
+        } else {
+            work[count - ++large] = (uint32_t) i;
+        }
+    }
+
+    // Each under-full column is topped up from an over-full one, which may become under-full.
+    while (small && large) {
+        uint32_t s = work[--small];
+        uint32_t l = work[count - large];
+        probability[s] = (float) scaled[s];
+        alias[s] = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if (scaled[l] < 1.0) {
+            large--;
+            work[small++] = l;
+        }
+    }
+
+    // What is left is full up to rounding.
+    while (large) {
+        uint32_t l = work[count - large--];
+        probability[l] = 1.0f;
+        alias[l] = l;
+    }
+    while (small) {
+        uint32_t s = work[--small];
+        probability[s] = 1.0f;
+        alias[s] = s;
+    }
+
+    free(scaled);
+    free(work);
+    table->count = count;
+    table->probability = probability;
+    table->alias = alias;
+    return true;
+}
+
+void random_alias_free(RandomAlias* table) {
+    if (NULL == table) {
+        return;
+    }
+
+    free(table->probability);
+    free(table->alias);
+    memset(table, 0, sizeof(*table));
+}
+
+// The column from the top 32 bits (Lemire), the coin from the low 24.
+static inline bool random_alias_try(const RandomAlias* table, uint64_t bits, uint32_t* index) {
+    uint32_t count = (uint32_t) table->count;
+    uint64_t m = (bits >> 32) * count;
+    if ((uint32_t) m < count && (uint32_t) m < (0u - count) % count) {
+        return false;
+    }
+
+    uint32_t column = (uint32_t) (m >> 32);
+    float coin = (float) (bits & 0xFFFFFFu) * 0x1.0p-24f;
+    *index = coin < table->probability[column] ? column : table->alias[column];
+    return true;
+}
+
+uint32_t random_alias_sample(Random* random, const RandomAlias* table) {
+    assert(table != NULL && table->count > 0);
+
+    uint32_t index;
+    while (!random_alias_try(table, random_u64(random), &index)) {}
+    return index;
+}
+
+void random_fill_categorical(
+    Random* random, const RandomAlias* table, uint32_t* output, size_t length
+) {
+    assert(table != NULL && table->count > 0);
+    assert(output != NULL || 0 == length);
+
+    uint64_t bits[RANDOM_TILE];
+    for (size_t i = 0; i < length; i += RANDOM_TILE) {
+        size_t n = random_tile(length - i);
+        random_fill_u64(random, bits, n);
+        for (size_t j = 0; j < n; j++) {
+            if (!random_alias_try(table, bits[j], &output[i + j])) {
+                output[i + j] = random_alias_sample(random, table);
+            }
+        }
+    }
+}
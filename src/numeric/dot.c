@@ -0,0 +1,471 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/numeric/dot.c
+ *
+ * @brief Dot products over quantized and half-precision rows.
+ */
+
+#include "core/cpu.h"
+#include "numeric/dot.h"
+
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+typedef float (*DotBlockQ8Q8)(const BlockQ8* x, const BlockQ8* y, size_t blocks);
+typedef float (*DotBlockQ4Q8)(const BlockQ4* x, const BlockQ8* y, size_t blocks);
+typedef float (*DotFp16Fp32)(const uint16_t* x, const float* y, size_t length);
+typedef float (*DotFp32)(const float* x, const float* y, size_t length);
+
+typedef struct DotKernels {
+    DotBlockQ8Q8 q8_q8;
+    DotBlockQ4Q8 q4_q8;
+    DotFp16Fp32 fp16_fp32;
+    DotFp32 fp32;
+} DotKernels;
+
+/**
+ * dequantize_scalar_fp16() with the bit casts inlined. The exported function goes through
+ * several calls into the library, which costs more than the 32 products of a block.
+ */
+static inline float dot_fp16(uint16_t bits) {
+    const uint32_t w = (uint32_t) bits << 16;
+    const uint32_t two_w = w + w;
+
+    uint32_t normalized = (two_w >> 4) + (0xE0u << 23);
+    uint32_t denormalized = (two_w >> 17) | (126u << 23);
+    float n, d;
+    memcpy(&n, &normalized, sizeof(float));
+    memcpy(&d, &denormalized, sizeof(float));
+    n *= 0x1.0p-112f;
+    d -= 0.5f;
+
+    uint32_t result;
+    memcpy(&result, two_w < (1u << 27) ? &d : &n, sizeof(uint32_t));
+    result |= w & 0x80000000;
+
+    float value;
+    memcpy(&value, &result, sizeof(float));
+    return value;
+}
+
+// Product of the two block scales.
+static inline float dot_scale(uint16_t x, uint16_t y) {
+    return dot_fp16(x) * dot_fp16(y);
+}
+
+// Scalar Kernels
+
+static float dot_blocks_q8_q8_scalar(const BlockQ8* x, const BlockQ8* y, size_t blocks) {
+    float sum = 0.0f;
+    for (size_t b = 0; b < blocks; b++) {
+        int32_t s = 0;
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            s += (int32_t) x[b].quants[i] * (int32_t) y[b].quants[i];
+        }
+        sum += dot_scale(x[b].scale, y[b].scale) * (float) s;
+    }
+    return sum;
+}
+
+static float dot_blocks_q4_q8_scalar(const BlockQ4* x, const BlockQ8* y, size_t blocks) {
+    float sum = 0.0f;
+    for (size_t b = 0; b < blocks; b++) {
+        int32_t s = 0;
+        for (size_t i = 0; i < Q4_NIBBLES; i++) {
+            int32_t lo = (int32_t) (x[b].nibbles[i] & 0x0F) - 8;
+            int32_t hi = (int32_t) (x[b].nibbles[i] >> 4) - 8;
+            s += lo * (int32_t) y[b].quants[i] + hi * (int32_t) y[b].quants[i + Q4_NIBBLES];
+        }
+        sum += dot_scale(x[b].scale, y[b].scale) * (float) s;
+    }
+    return sum;
+}
+
+static float dot_fp16_fp32_scalar(const uint16_t* x, const float* y, size_t length) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        sum += dot_fp16(x[i]) * y[i];
+    }
+    return sum;
+}
+
+static float dot_fp32_scalar(const float* x, const float* y, size_t length) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+// SSE2 Kernels
+
+#if defined(__SSE2__)
+
+static inline float dot_hsum_sse2(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+// Sums of products of 16 signed bytes, widened to int16 (SSE2 has no pmaddubsw).
+static inline __m128i dot_madd_int8_sse2(__m128i a, __m128i b) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i sa = _mm_cmpgt_epi8(zero, a);
+    __m128i sb = _mm_cmpgt_epi8(zero, b);
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(a, sa), _mm_unpacklo_epi8(b, sb));
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(a, sa), _mm_unpackhi_epi8(b, sb));
+    return _mm_add_epi32(lo, hi);
+}
+
+static float dot_blocks_q8_q8_sse2(const BlockQ8* x, const BlockQ8* y, size_t blocks) {
+    __m128 sum = _mm_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m128i x0 = _mm_loadu_si128((const __m128i*) x[b].quants);
+        __m128i x1 = _mm_loadu_si128((const __m128i*) (x[b].quants + 16));
+        __m128i y0 = _mm_loadu_si128((const __m128i*) y[b].quants);
+        __m128i y1 = _mm_loadu_si128((const __m128i*) (y[b].quants + 16));
+        __m128i s = _mm_add_epi32(dot_madd_int8_sse2(x0, y0), dot_madd_int8_sse2(x1, y1));
+        __m128 d = _mm_set1_ps(dot_scale(x[b].scale, y[b].scale));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(s), d));
+    }
+    return dot_hsum_sse2(sum);
+}
+
+static float dot_blocks_q4_q8_sse2(const BlockQ4* x, const BlockQ8* y, size_t blocks) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i bias = _mm_set1_epi8(8);
+    __m128 sum = _mm_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m128i v = _mm_loadu_si128((const __m128i*) x[b].nibbles);
+        __m128i x0 = _mm_sub_epi8(_mm_and_si128(v, mask), bias);
+        __m128i x1 = _mm_sub_epi8(_mm_and_si128(_mm_srli_epi16(v, 4), mask), bias);
+        __m128i y0 = _mm_loadu_si128((const __m128i*) y[b].quants);
+        __m128i y1 = _mm_loadu_si128((const __m128i*) (y[b].quants + 16));
+        __m128i s = _mm_add_epi32(dot_madd_int8_sse2(x0, y0), dot_madd_int8_sse2(x1, y1));
+        __m128 d = _mm_set1_ps(dot_scale(x[b].scale, y[b].scale));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(s), d));
+    }
+    return dot_hsum_sse2(sum);
+}
+
+// Widens through a small buffer with the SSE2 row conversion; SSE2 has no vcvtph2ps.
+static float dot_fp16_fp32_sse2(const uint16_t* x, const float* y, size_t length) {
+    float buffer[256];
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    size_t i = 0;
+    while (i + 8 <= length) {
+        size_t n = length - i < 256 ? (length - i) & ~(size_t) 7 : 256;
+        dequantize_row_fp16(x + i, buffer, n);
+        for (size_t k = 0; k < n; k += 8) {
+            __m128 y0 = _mm_loadu_ps(y + i + k);
+            __m128 y1 = _mm_loadu_ps(y + i + k + 4);
+            s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(buffer + k), y0));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(buffer + k + 4), y1));
+        }
+        i += n;
+    }
+    return dot_hsum_sse2(_mm_add_ps(s0, s1)) + dot_fp16_fp32_scalar(x + i, y + i, length - i);
+}
+
+static float dot_fp32_sse2(const float* x, const float* y, size_t length) {
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(y + i + 4)));
+    }
+    return dot_hsum_sse2(_mm_add_ps(s0, s1)) + dot_fp32_scalar(x + i, y + i, length - i);
+}
+
+#else
+
+    #define dot_blocks_q8_q8_sse2 dot_blocks_q8_q8_scalar
+    #define dot_blocks_q4_q8_sse2 dot_blocks_q4_q8_scalar
+    #define dot_fp16_fp32_sse2 dot_fp16_fp32_scalar
+    #define dot_fp32_sse2 dot_fp32_scalar
+
+#endif // __SSE2__
+
+// AVX2 and AVX-512 Kernels
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline float dot_hsum_avx2(__m256 v) {
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+// Product of the two block scales; vcvtph2ps widens every half exactly.
+CPU_TARGET_AVX2 static inline float dot_scale_avx2(uint16_t x, uint16_t y) {
+    return _cvtsh_ss(x) * _cvtsh_ss(y);
+}
+
+// Unpacks 16 nibble pairs to 32 signed steps: low nibbles are elements 0-15, high 16-31.
+CPU_TARGET_AVX2 static inline __m256i dot_unpack_q4_avx2(const uint8_t* nibbles) {
+    __m128i v = _mm_loadu_si128((const __m128i*) nibbles);
+    __m256i q = _mm256_set_m128i(_mm_srli_epi16(v, 4), v);
+    return _mm256_sub_epi8(_mm256_and_si256(q, _mm256_set1_epi8(0x0F)), _mm256_set1_epi8(8));
+}
+
+// Eight int32 partial sums of x * y over 32 signed bytes. pmaddubsw multiplies unsigned by
+// signed bytes, so |x| is paired with y carrying x's sign; with |x|, |y| <= 127 the int16 pair
+// sums cannot saturate.
+CPU_TARGET_AVX2 static inline __m256i dot_int8_avx2(__m256i x, __m256i y) {
+    __m256i p = _mm256_maddubs_epi16(_mm256_sign_epi8(x, x), _mm256_sign_epi8(y, x));
+    return _mm256_madd_epi16(p, _mm256_set1_epi16(1));
+}
+
+CPU_TARGET_AVX2 static float
+dot_blocks_q8_q8_avx2(const BlockQ8* x, const BlockQ8* y, size_t blocks) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m256i qx = _mm256_loadu_si256((const __m256i*) x[b].quants);
+        __m256i qy = _mm256_loadu_si256((const __m256i*) y[b].quants);
+        __m256 d = _mm256_set1_ps(dot_scale_avx2(x[b].scale, y[b].scale));
+        sum = _mm256_fmadd_ps(_mm256_cvtepi32_ps(dot_int8_avx2(qx, qy)), d, sum);
+    }
+    return dot_hsum_avx2(sum);
+}
+
+CPU_TARGET_AVX2 static float
+dot_blocks_q4_q8_avx2(const BlockQ4* x, const BlockQ8* y, size_t blocks) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m256i qx = dot_unpack_q4_avx2(x[b].nibbles);
+        __m256i qy = _mm256_loadu_si256((const __m256i*) y[b].quants);
+        __m256 d = _mm256_set1_ps(dot_scale_avx2(x[b].scale, y[b].scale));
+        sum = _mm256_fmadd_ps(_mm256_cvtepi32_ps(dot_int8_avx2(qx, qy)), d, sum);
+    }
+    return dot_hsum_avx2(sum);
+}
+
+CPU_TARGET_AVX2 static float dot_fp16_fp32_avx2(const uint16_t* x, const float* y, size_t length) {
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256 x0 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) (x + i)));
+        __m256 x1 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) (x + i + 8)));
+        s0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y + i), s0);
+        s1 = _mm256_fmadd_ps(x1, _mm256_loadu_ps(y + i + 8), s1);
+    }
+    return dot_hsum_avx2(_mm256_add_ps(s0, s1)) + dot_fp16_fp32_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX2 static float dot_fp32_avx2(const float* x, const float* y, size_t length) {
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps();
+    __m256 s3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 16), _mm256_loadu_ps(y + i + 16), s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 24), _mm256_loadu_ps(y + i + 24), s3);
+    }
+    for (; i + 8 <= length; i += 8) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+    }
+    __m256 sum = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+    return dot_hsum_avx2(sum) + dot_fp32_scalar(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX512 static float dot_fp32_avx512(const float* x, const float* y, size_t length) {
+    __m512 s0 = _mm512_setzero_ps();
+    __m512 s1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+        s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), s1);
+    }
+    float sum = _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+    return sum + dot_fp32_avx2(x + i, y + i, length - i);
+}
+
+CPU_TARGET_AVX512 static float
+dot_fp16_fp32_avx512(const uint16_t* x, const float* y, size_t length) {
+    __m512 s0 = _mm512_setzero_ps();
+    __m512 s1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m512 x0 = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*) (x + i)));
+        __m512 x1 = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*) (x + i + 16)));
+        s0 = _mm512_fmadd_ps(x0, _mm512_loadu_ps(y + i), s0);
+        s1 = _mm512_fmadd_ps(x1, _mm512_loadu_ps(y + i + 16), s1);
+    }
+    float sum = _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+    return sum + dot_fp16_fp32_avx2(x + i, y + i, length - i);
+}
+
+/**
+ * VNNI kernels: vpdpbusd multiplies unsigned by signed bytes and adds each group of four
+ * straight into int32 lanes, replacing the pmaddubsw/pmaddwd pair. AVX-VNNI (VEX) and
+ * AVX512-VNNI (EVEX, 256-bit with VL) are the same instruction behind different feature bits.
+ */
+
+    #define DOT_TARGET_AVX_VNNI __attribute__((target("avxvnni,avx2,fma,f16c")))
+    #define DOT_TARGET_AVX512_VNNI \
+        __attribute__((target("avx512vnni,avx512vl,avx512f,avx512bw,avx2,fma,f16c")))
+
+DOT_TARGET_AVX_VNNI static float
+dot_blocks_q8_q8_avx_vnni(const BlockQ8* x, const BlockQ8* y, size_t blocks) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m256i qx = _mm256_loadu_si256((const __m256i*) x[b].quants);
+        __m256i qy = _mm256_loadu_si256((const __m256i*) y[b].quants);
+        __m256i s = _mm256_dpbusd_avx_epi32(
+            _mm256_setzero_si256(), _mm256_sign_epi8(qx, qx), _mm256_sign_epi8(qy, qx)
+        );
+        __m256 d = _mm256_set1_ps(dot_scale_avx2(x[b].scale, y[b].scale));
+        sum = _mm256_fmadd_ps(_mm256_cvtepi32_ps(s), d, sum);
+    }
+    return dot_hsum_avx2(sum);
+}
+
+DOT_TARGET_AVX_VNNI static float
+dot_blocks_q4_q8_avx_vnni(const BlockQ4* x, const BlockQ8* y, size_t blocks) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m256i qx = dot_unpack_q4_avx2(x[b].nibbles);
+        __m256i qy = _mm256_loadu_si256((const __m256i*) y[b].quants);
+        __m256i s = _mm256_dpbusd_avx_epi32(
+            _mm256_setzero_si256(), _mm256_sign_epi8(qx, qx), _mm256_sign_epi8(qy, qx)
+        );
+        __m256 d = _mm256_set1_ps(dot_scale_avx2(x[b].scale, y[b].scale));
+        sum = _mm256_fmadd_ps(_mm256_cvtepi32_ps(s), d, sum);
+    }
+    return dot_hsum_avx2(sum);
+}
+
+DOT_TARGET_AVX512_VNNI static float
+dot_blocks_q8_q8_avx512_vnni(const BlockQ8* x, const BlockQ8* y, size_t blocks) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m256i qx = _mm256_loadu_si256((const __m256i*) x[b].quants);
+        __m256i qy = _mm256_loadu_si256((const __m256i*) y[b].quants);
+        __m256i s = _mm256_dpbusd_epi32(
+            _mm256_setzero_si256(), _mm256_sign_epi8(qx, qx), _mm256_sign_epi8(qy, qx)
+        );
+        __m256 d = _mm256_set1_ps(dot_scale_avx2(x[b].scale, y[b].scale));
+        sum = _mm256_fmadd_ps(_mm256_cvtepi32_ps(s), d, sum);
+    }
+    return dot_hsum_avx2(sum);
+}
+
+DOT_TARGET_AVX512_VNNI static float
+dot_blocks_q4_q8_avx512_vnni(const BlockQ4* x, const BlockQ8* y, size_t blocks) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t b = 0; b < blocks; b++) {
+        __m256i qx = dot_unpack_q4_avx2(x[b].nibbles);
+        __m256i qy = _mm256_loadu_si256((const __m256i*) y[b].quants);
+        __m256i s = _mm256_dpbusd_epi32(
+            _mm256_setzero_si256(), _mm256_sign_epi8(qx, qx), _mm256_sign_epi8(qy, qx)
+        );
+        __m256 d = _mm256_set1_ps(dot_scale_avx2(x[b].scale, y[b].scale));
+        sum = _mm256_fmadd_ps(_mm256_cvtepi32_ps(s), d, sum);
+    }
+    return dot_hsum_avx2(sum);
+}
+
+#endif // CPU_X86
+
+static const DotKernels DOT_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {
+        dot_blocks_q8_q8_scalar,
+        dot_blocks_q4_q8_scalar,
+        dot_fp16_fp32_scalar,
+        dot_fp32_scalar,
+    },
+    [CPU_LEVEL_SSE2] = {
+        dot_blocks_q8_q8_sse2,
+        dot_blocks_q4_q8_sse2,
+        dot_fp16_fp32_sse2,
+        dot_fp32_sse2,
+    },
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {
+        dot_blocks_q8_q8_avx2,
+        dot_blocks_q4_q8_avx2,
+        dot_fp16_fp32_avx2,
+        dot_fp32_avx2,
+    },
+    [CPU_LEVEL_AVX512] = {
+        dot_blocks_q8_q8_avx2,
+        dot_blocks_q4_q8_avx2,
+        dot_fp16_fp32_avx512,
+        dot_fp32_avx512,
+    },
+#endif
+};
+
+#if CPU_X86
+static const DotKernels DOT_KERNELS_AVX_VNNI = {
+    dot_blocks_q8_q8_avx_vnni,
+    dot_blocks_q4_q8_avx_vnni,
+    dot_fp16_fp32_avx2,
+    dot_fp32_avx2,
+};
+
+static const DotKernels DOT_KERNELS_AVX512_VNNI = {
+    dot_blocks_q8_q8_avx512_vnni,
+    dot_blocks_q4_q8_avx512_vnni,
+    dot_fp16_fp32_avx512,
+    dot_fp32_avx512,
+};
+#endif
+
+// The level's table, upgraded to a VNNI variant when the CPU has one.
+static const DotKernels* dot_kernels(void) {
+#if CPU_X86
+    if (cpu_has(CPU_FEATURE_AVX512_VNNI)) {
+        return &DOT_KERNELS_AVX512_VNNI;
+    }
+    if (cpu_has(CPU_FEATURE_AVX_VNNI)) {
+        return &DOT_KERNELS_AVX_VNNI;
+    }
+#endif
+    return &DOT_KERNELS[cpu_level()];
+}
+
+/**
+ * Public Functions
+ */
+
+float dot_block_q8_q8(const BlockQ8* x, const BlockQ8* y, size_t length) {
+    assert(x != NULL);
+    assert(y != NULL);
+
+    return dot_kernels()->q8_q8(x, y, (length + BLOCK_SIZE - 1) / BLOCK_SIZE);
+}
+
+float dot_block_q4_q8(const BlockQ4* x, const BlockQ8* y, size_t length) {
+    assert(x != NULL);
+    assert(y != NULL);
+
+    return dot_kernels()->q4_q8(x, y, (length + BLOCK_SIZE - 1) / BLOCK_SIZE);
+}
+
+float dot_fp16_fp32(const uint16_t* x, const float* y, size_t length) {
+    assert(x != NULL);
+    assert(y != NULL);
+
+    return dot_kernels()->fp16_fp32(x, y, length);
+}
+
+float dot_fp32(const float* x, const float* y, size_t length) {
+    assert(x != NULL);
+    assert(y != NULL);
+
+    return dot_kernels()->fp32(x, y, length);
+}
@@ -0,0 +1,413 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/numeric/matrix.c
+ *
+ * @brief Dense matrix products: SGEMM and GEMV over fp32, fp16 and block-quantized weights.
+ */
+
+#include "core/cpu.h"
+#include "core/memory.h"
+#include "numeric/dot.h"
+#include "numeric/matrix.h"
+
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#endif
+
+/**
+ * Private Definitions
+ */
+
+#define MATRIX_ALIGNMENT 64 // packed panels start on a cache line
+#define MATRIX_KC 256 // depth of a packed block: one A micro-panel plus one B micro-panel in L1
+#define MATRIX_MC_PANELS 16 // MC = 16 * MR rows of A per thread block (L2)
+#define MATRIX_NC_PANELS 128 // NC = 128 * NR columns of B per packed block (L3)
+#define MATRIX_MR_MAX 12
+#define MATRIX_NR_MAX 32
+#define MATRIX_GEMV_GRAIN 16 // rows per scheduling unit
+
+/**
+ * Computes an MR x NR tile from packed panels: `a` holds `kc` columns of MR values, `b` holds
+ * `kc` rows of NR values. The tile is stored to (or, with `accumulate`, added to) `c`.
+ */
+typedef void (*MatrixKernel)(
+    size_t kc, const float* a, const float* b, float* c, size_t ldc, bool accumulate
+);
+
+typedef struct MatrixGemmKernel {
+    MatrixKernel run;
+    size_t mr;
+    size_t nr;
+} MatrixGemmKernel;
+
+typedef struct MatrixGemm {
+    const MatrixGemmKernel* kernel;
+    const float* a;
+    const float* b;
+    float* c;
+    size_t lda;
+    size_t ldb;
+    size_t ldc;
+    size_t m;
+    size_t mc; // rows per block of C handed to a thread (multiple of MR)
+    size_t nc; // columns of the current packed B block
+    size_t kc; // depth of the current packed block
+    size_t jc; // first column of the current packed B block
+    size_t pc; // first depth index of the current packed block
+    float* packed_a; // one MC x KC buffer per thread
+    float* packed_b; // KC x NC
+} MatrixGemm;
+
+/**
+ * Micro-kernels
+ */
+
+static void matrix_kernel_scalar(
+    size_t kc, const float* a, const float* b, float* c, size_t ldc, bool accumulate
+) {
+    float acc[4][16] = {{0}};
+    for (size_t p = 0; p < kc; p++) {
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t j = 0; j < 16; j++) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += 4;
+        b += 16;
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 16; j++) {
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i][j] : acc[i][j];
+        }
+    }
+}
+
+#if CPU_X86
+
+// 6 x 16: twelve ymm accumulators, two B loads and six broadcasts per step.
+CPU_TARGET_AVX2 static void matrix_kernel_avx2(
+    size_t kc, const float* a, const float* b, float* c, size_t ldc, bool accumulate
+) {
+    __m256 acc[6][2];
+    for (size_t i = 0; i < 6; i++) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+        for (size_t i = 0; i < 6; i++) {
+            __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += 6;
+        b += 16;
+    }
+
+    for (size_t i = 0; i < 6; i++) {
+        float* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_loadu_ps(row));
+            acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_loadu_ps(row + 8));
+        }
+        _mm256_storeu_ps(row, acc[i][0]);
+        _mm256_storeu_ps(row + 8, acc[i][1]);
+    }
+}
+
+// 12 x 32: twenty-four zmm accumulators, two B loads and twelve broadcasts per step.
+CPU_TARGET_AVX512 static void matrix_kernel_avx512(
+    size_t kc, const float* a, const float* b, float* c, size_t ldc, bool accumulate
+) {
+    __m512 acc[12][2];
+    for (size_t i = 0; i < 12; i++) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; p++) {
+        __m512 b0 = _mm512_load_ps(b);
+        __m512 b1 = _mm512_load_ps(b + 16);
+        for (size_t i = 0; i < 12; i++) {
+            __m512 ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += 12;
+        b += 32;
+    }
+
+    for (size_t i = 0; i < 12; i++) {
+        float* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_ps(acc[i][0], _mm512_loadu_ps(row));
+            acc[i][1] = _mm512_add_ps(acc[i][1], _mm512_loadu_ps(row + 16));
+        }
+        _mm512_storeu_ps(row, acc[i][0]);
+        _mm512_storeu_ps(row + 16, acc[i][1]);
+    }
+}
+
+#endif // CPU_X86
+
+// The scalar kernel is written for auto-vectorization, which covers the SSE2 level.
+static const MatrixGemmKernel MATRIX_GEMM_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {matrix_kernel_scalar, 4, 16},
+    [CPU_LEVEL_SSE2] = {matrix_kernel_scalar, 4, 16},
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {matrix_kernel_avx2, 6, 16},
+    [CPU_LEVEL_AVX512] = {matrix_kernel_avx512, 12, 32},
+#endif
+};
+
+/**
+ * Packing
+ */
+
+// Packs rows [i0, i0 + mc) x depth [pc, pc + kc) of A into MR-row panels, zero-padding rows.
+static void matrix_pack_a(const MatrixGemm* g, size_t i0, size_t mc, float* out) {
+    size_t mr = g->kernel->mr;
+    for (size_t ir = 0; ir < mc; ir += mr) {
+        for (size_t p = 0; p < g->kc; p++) {
+            for (size_t r = 0; r < mr; r++) {
+                size_t i = i0 + ir + r;
+                *out++ = ir + r < mc ? g->a[i * g->lda + g->pc + p] : 0.0f;
+            }
+        }
+    }
+}
+
+// Packs NR-column panels [begin, end) of the current B block, zero-padding columns.
+static void matrix_pack_b(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const MatrixGemm* g = (const MatrixGemm*) context;
+    size_t nr = g->kernel->nr;
+
+    for (size_t panel = begin; panel < end; panel++) {
+        float* out = g->packed_b + panel * nr * g->kc;
+        size_t j0 = panel * nr;
+        size_t width = g->nc - j0 < nr ? g->nc - j0 : nr;
+        for (size_t p = 0; p < g->kc; p++) {
+            const float* row = g->b + (g->pc + p) * g->ldb + g->jc + j0;
+            memcpy(out, row, width * sizeof(float));
+            memset(out + width, 0, (nr - width) * sizeof(float));
+            out += nr;
+        }
+    }
+}
+
+// Runs the micro-kernel over row blocks [begin, end) of C for the current packed B block.
+static void matrix_gemm_blocks(void* context, size_t begin, size_t end, size_t thread) {
+    const MatrixGemm* g = (const MatrixGemm*) context;
+    const MatrixGemmKernel* kernel = g->kernel;
+    size_t mr = kernel->mr;
+    size_t nr = kernel->nr;
+    bool accumulate = g->pc > 0;
+    float* packed_a = g->packed_a + thread * MATRIX_MC_PANELS * MATRIX_MR_MAX * MATRIX_KC;
+    alignas(MATRIX_ALIGNMENT) float tile[MATRIX_MR_MAX * MATRIX_NR_MAX];
+
+    for (size_t block = begin; block < end; block++) {
+        size_t i0 = block * g->mc;
+        size_t mc = g->m - i0 < g->mc ? g->m - i0 : g->mc;
+        matrix_pack_a(g, i0, mc, packed_a);
+
+        for (size_t jr = 0; jr < g->nc; jr += nr) {
+            const float* b = g->packed_b + jr * g->kc;
+            size_t width = g->nc - jr < nr ? g->nc - jr : nr;
+
+            for (size_t ir = 0; ir < mc; ir += mr) {
+                const float* a = packed_a + ir * g->kc;
+                size_t height = mc - ir < mr ? mc - ir : mr;
+                float* c = g->c + (i0 + ir) * g->ldc + g->jc + jr;
+
+                if (height == mr && width == nr) {
+                    kernel->run(g->kc, a, b, c, g->ldc, accumulate);
+                    continue;
+                }
+
+                // Edge tile: compute the full tile aside and copy out the valid part.
+                kernel->run(g->kc, a, b, tile, nr, false);
+                for (size_t i = 0; i < height; i++) {
+                    for (size_t j = 0; j < width; j++) {
+                        float v = tile[i * nr + j];
+                        c[i * g->ldc + j] = accumulate ? c[i * g->ldc + j] + v : v;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * GEMV
+ */
+
+typedef struct MatrixGemv {
+    DataTypeId type;
+    const uint8_t* w;
+    size_t stride; // bytes per weight row
+    size_t cols;
+    const float* x;
+    const BlockQ8* xq; // x quantized, for the block formats
+    float* y;
+} MatrixGemv;
+
+static void matrix_gemv_rows(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const MatrixGemv* g = (const MatrixGemv*) context;
+
+    for (size_t r = begin; r < end; r++) {
+        const void* row = g->w + r * g->stride;
+        switch (g->type) {
+            case TYPE_FLOAT32:
+                g->y[r] = dot_fp32((const float*) row, g->x, g->cols);
+                break;
+            case TYPE_FLOAT16:
+                g->y[r] = dot_fp16_fp32((const uint16_t*) row, g->x, g->cols);
+                break;
+            case TYPE_BLOCK_Q8:
+                g->y[r] = dot_block_q8_q8((const BlockQ8*) row, g->xq, g->cols);
+                break;
+            case TYPE_BLOCK_Q4:
+                g->y[r] = dot_block_q4_q8((const BlockQ4*) row, g->xq, g->cols);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * Public Functions
+ */
+
+bool matrix_gemm_fp32(
+    ThreadPool* pool,
+    size_t m,
+    size_t n,
+    size_t k,
+    const float* a,
+    size_t lda,
+    const float* b,
+    size_t ldb,
+    float* c,
+    size_t ldc
+) {
+    assert(a != NULL || 0 == m * k);
+    assert(b != NULL || 0 == k * n);
+    assert(c != NULL || 0 == m * n);
+
+    if (0 == m || 0 == n) {
+        return true;
+    }
+    if (0 == k) {
+        for (size_t i = 0; i < m; i++) {
+            memset(c + i * ldc, 0, n * sizeof(float));
+        }
+        return true;
+    }
+
+    const MatrixGemmKernel* kernel = &MATRIX_GEMM_KERNELS[cpu_level()];
+    size_t threads = thread_pool_size(pool);
+
+    // Shrink the row block so every thread has work when m is small.
+    size_t mc = MATRIX_MC_PANELS * kernel->mr;
+    size_t share = (m + threads - 1) / threads;
+    share = (share + kernel->mr - 1) / kernel->mr * kernel->mr;
+    mc = share < mc ? share : mc;
+
+    size_t nc_max = MATRIX_NC_PANELS * kernel->nr;
+    size_t a_size = threads * MATRIX_MC_PANELS * MATRIX_MR_MAX * MATRIX_KC * sizeof(float);
+    size_t b_size = MATRIX_KC * nc_max * sizeof(float);
+
+    MatrixGemm g = {
+        .kernel = kernel,
+        .a = a,
+        .b = b,
+        .c = c,
+        .lda = lda,
+        .ldb = ldb,
+        .ldc = ldc,
+        .m = m,
+        .mc = mc,
+        .packed_a = memory_alloc(a_size, MATRIX_ALIGNMENT),
+        .packed_b = memory_alloc(b_size, MATRIX_ALIGNMENT),
+    };
+    if (!g.packed_a || !g.packed_b) {
+        memory_free(g.packed_a);
+        memory_free(g.packed_b);
+        return false;
+    }
+
+    size_t blocks = (m + mc - 1) / mc;
+    for (g.jc = 0; g.jc < n; g.jc += nc_max) {
+        g.nc = n - g.jc < nc_max ? n - g.jc : nc_max;
+        size_t panels = (g.nc + kernel->nr - 1) / kernel->nr;
+
+        for (g.pc = 0; g.pc < k; g.pc += MATRIX_KC) {
+            g.kc = k - g.pc < MATRIX_KC ? k - g.pc : MATRIX_KC;
+            thread_pool_parallel_for(pool, panels, 1, matrix_pack_b, &g);
+            thread_pool_parallel_for(pool, blocks, 1, matrix_gemm_blocks, &g);
+        }
+    }
+
+    memory_free(g.packed_a);
+    memory_free(g.packed_b);
+    return true;
+}
+
+bool matrix_gemv(
+    ThreadPool* pool,
+    DataTypeId type,
+    const void* w,
+    size_t rows,
+    size_t cols,
+    const float* x,
+    float* y
+) {
+    assert(w != NULL || 0 == rows);
+    assert(x != NULL || 0 == cols);
+    assert(y != NULL || 0 == rows);
+
+    bool block = TYPE_BLOCK_Q8 == type || TYPE_BLOCK_Q4 == type;
+    if (!block && TYPE_FLOAT32 != type && TYPE_FLOAT16 != type) {
+        return false;
+    }
+    if (0 == rows) {
+        return true;
+    }
+    if (0 == cols) {
+        memset(y, 0, rows * sizeof(float));
+        return true;
+    }
+
+    MatrixGemv g = {
+        .type = type,
+        .w = (const uint8_t*) w,
+        .stride = data_type_row_size(type, cols),
+        .cols = cols,
+        .x = x,
+        .y = y,
+    };
+
+    BlockQ8* xq = NULL;
+    if (block) {
+        xq = memory_alloc(data_type_row_size(TYPE_BLOCK_Q8, cols), alignof(BlockQ8));
+        if (!xq) {
+            return false;
+        }
+        quantize_row_block_q8(x, xq, cols);
+        g.xq = xq;
+    }
+
+    thread_pool_parallel_for(pool, rows, MATRIX_GEMV_GRAIN, matrix_gemv_rows, &g);
+
+    memory_free(xq);
+    return true;
+}
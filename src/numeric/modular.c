@@ -0,0 +1,724 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file src/numeric/modular.c
+ * @brief Barrett and Montgomery reduction, modular array kernels and the NTT.
+ *
+ * The vector kernels hold eight 32-bit residues per register, but `_mm256_mul_epu32` only
+ * multiplies the even 32-bit lanes into 64-bit products. Every product is therefore taken twice,
+ * once for the even lanes and once for the odd lanes shifted down, and the two halves are
+ * blended back together after reduction.
+ */
+
+#include "core/cpu.h"
+#include "numeric/modular.h"
+#include "numeric/prime.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#endif
+
+#define MODULAR_DIRECT 32 // shorter operands convolve directly
+#define MODULAR_LANES 8 // residues per AVX2 register; smaller NTT stages stay scalar
+#define MODULAR_BLOCK 8192 // NTT values per cache block (32 KiB)
+
+/**
+ * Scalar Reduction
+ */
+
+bool modular_barrett_create(ModularBarrett* context, uint32_t modulus) {
+    assert(context != NULL);
+
+    if (2 > modulus || modulus >= MODULAR_LIMIT) {
+        return false;
+    }
+
+    uint32_t shift = 32 - (uint32_t) __builtin_clz(modulus - 1); // ceil(log2(modulus))
+    context->modulus = modulus;
+    context->shift = shift;
+    context->factor = (uint32_t) (((uint64_t) 1 << (2 * shift)) / modulus); // < 2^(shift + 1)
+    return true;
+}
+
+// x < m^2 <= 2^2k. The estimate of x / m is low by at most 2 (HAC 14.42).
+static inline uint32_t modular_barrett_reduce(const ModularBarrett* context, uint64_t x) {
+    uint64_t q = ((x >> (context->shift - 1)) * context->factor) >> (context->shift + 1);
+    uint64_t m = context->modulus;
+    uint64_t r = x - q * m;
+    r -= m & -(uint64_t) (r >= m); // masks, not branches: the outcomes are data-dependent
+    r -= m & -(uint64_t) (r >= m);
+    return (uint32_t) r;
+}
+
+uint32_t modular_barrett_multiply(const ModularBarrett* context, uint32_t a, uint32_t b) {
+    return modular_barrett_reduce(context, (uint64_t) a * b);
+}
+
+bool modular_montgomery_create(ModularMontgomery* context, uint32_t modulus) {
+    assert(context != NULL);
+
+    if (3 > modulus || modulus >= MODULAR_LIMIT || 0 == (modulus & 1)) {
+        return false;
+    }
+
+    uint32_t inverse = modulus; // correct to 3 bits; each Newton step doubles that
+    for (int i = 0; i < 4; i++) {
+        inverse *= 2 - modulus * inverse;
+    }
+
+    context->modulus = modulus;
+    context->inverse = inverse;
+    context->one = (uint32_t) (((uint64_t) 1 << 32) % modulus);
+    context->square = (uint32_t) ((uint64_t) context->one * context->one % modulus);
+    return true;
+}
+
+// q = t * m^-1 mod 2^32 makes qm agree with t in the low word, so t / R - qm / R is exact and
+// lies in (-m, m): no 64-bit sum that could carry.
+static inline uint32_t modular_montgomery_one(
+    const ModularMontgomery* context, uint32_t a, uint32_t b
+) {
+    uint64_t t = (uint64_t) a * b;
+    uint32_t q = (uint32_t) t * context->inverse;
+    uint32_t high = (uint32_t) ((uint64_t) q * context->modulus >> 32);
+    uint32_t r = (uint32_t) (t >> 32) - high;
+    return r + (context->modulus & -(uint32_t) ((uint32_t) (t >> 32) < high));
+}
+
+uint32_t modular_montgomery_multiply(const ModularMontgomery* context, uint32_t a, uint32_t b) {
+    return modular_montgomery_one(context, a, b);
+}
+
+uint32_t modular_montgomery_to(const ModularMontgomery* context, uint32_t x) {
+    return modular_montgomery_one(context, x, context->square);
+}
+
+uint32_t modular_montgomery_from(const ModularMontgomery* context, uint32_t x) {
+    return modular_montgomery_one(context, x, 1);
+}
+
+static inline uint32_t modular_add_scalar_one(uint32_t a, uint32_t b, uint32_t m) {
+    uint32_t s = a + b;
+    return s - (m & -(uint32_t) (s >= m));
+}
+
+static inline uint32_t modular_sub_scalar_one(uint32_t a, uint32_t b, uint32_t m) {
+    return a - b + (m & -(uint32_t) (a < b));
+}
+
+/**
+ * Kernels
+ *
+ * The NTT butterflies take one twiddle per pair: decimation in frequency writes (u + v, (u - v)w)
+ * and decimation in time (u + vw, u - vw). Twiddles are in Montgomery form and the data is not,
+ * so every product comes out ordinary.
+ */
+
+typedef void (*ModularBinary)(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+);
+typedef void (*ModularBarrettRow)(
+    const ModularBarrett* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+);
+typedef void (*ModularMontgomeryRow)(
+    const ModularMontgomery* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+);
+typedef void (*ModularButterfly)(
+    const ModularMontgomery* context, uint32_t* x, uint32_t* y, const uint32_t* w, size_t count
+);
+
+typedef struct ModularKernels {
+    ModularBinary add;
+    ModularBinary sub;
+    ModularBarrettRow mul_barrett;
+    ModularMontgomeryRow mul_montgomery;
+    ModularButterfly dif;
+    ModularButterfly dit;
+} ModularKernels;
+
+// Scalar Kernels
+
+static void modular_add_scalar(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+) {
+    for (size_t i = 0; i < count; i++) {
+        output[i] = modular_add_scalar_one(a[i], b[i], modulus);
+    }
+}
+
+static void modular_sub_scalar(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+) {
+    for (size_t i = 0; i < count; i++) {
+        output[i] = modular_sub_scalar_one(a[i], b[i], modulus);
+    }
+}
+
+static void modular_mul_barrett_scalar(
+    const ModularBarrett* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+) {
+    for (size_t i = 0; i < count; i++) {
+        output[i] = modular_barrett_reduce(context, (uint64_t) a[i] * b[i]);
+    }
+}
+
+static void modular_mul_montgomery_scalar(
+    const ModularMontgomery* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+) {
+    for (size_t i = 0; i < count; i++) {
+        output[i] = modular_montgomery_one(context, a[i], b[i]);
+    }
+}
+
+static void modular_dif_scalar(
+    const ModularMontgomery* context, uint32_t* x, uint32_t* y, const uint32_t* w, size_t count
+) {
+    uint32_t m = context->modulus;
+    for (size_t j = 0; j < count; j++) {
+        uint32_t u = x[j];
+        uint32_t v = y[j];
+        x[j] = modular_add_scalar_one(u, v, m);
+        y[j] = modular_montgomery_one(context, modular_sub_scalar_one(u, v, m), w[j]);
+    }
+}
+
+static void modular_dit_scalar(
+    const ModularMontgomery* context, uint32_t* x, uint32_t* y, const uint32_t* w, size_t count
+) {
+    uint32_t m = context->modulus;
+    for (size_t j = 0; j < count; j++) {
+        uint32_t u = x[j];
+        uint32_t v = modular_montgomery_one(context, y[j], w[j]);
+        x[j] = modular_add_scalar_one(u, v, m);
+        y[j] = modular_sub_scalar_one(u, v, m);
+    }
+}
+
+// SSE2 lacks an unsigned 32-bit min and multiplies two lanes per register: scalar kernels.
+#define modular_add_sse2 modular_add_scalar
+#define modular_sub_sse2 modular_sub_scalar
+#define modular_mul_barrett_sse2 modular_mul_barrett_scalar
+#define modular_mul_montgomery_sse2 modular_mul_montgomery_scalar
+#define modular_dif_sse2 modular_dif_scalar
+#define modular_dit_sse2 modular_dit_scalar
+
+// AVX2 Kernels
+
+#if CPU_X86
+
+// With a, b < m < 2^31: a sum at or above m is the smaller after subtracting m, and a sum below
+// m wraps past 2^31 when m is subtracted, so an unsigned min picks the residue either way.
+CPU_TARGET_AVX2 static inline __m256i modular_add_avx2_one(__m256i a, __m256i b, __m256i m) {
+    __m256i s = _mm256_add_epi32(a, b);
+    return _mm256_min_epu32(s, _mm256_sub_epi32(s, m));
+}
+
+CPU_TARGET_AVX2 static inline __m256i modular_sub_avx2_one(__m256i a, __m256i b, __m256i m) {
+    __m256i d = _mm256_sub_epi32(a, b);
+    return _mm256_min_epu32(d, _mm256_add_epi32(d, m));
+}
+
+CPU_TARGET_AVX2 static inline __m256i modular_montgomery_avx2_one(
+    __m256i a, __m256i b, __m256i m, __m256i inverse
+) {
+    __m256i t_even = _mm256_mul_epu32(a, b);
+    __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i q_even = _mm256_mul_epu32(t_even, inverse);
+    __m256i q_odd = _mm256_mul_epu32(t_odd, inverse);
+    __m256i qm_even = _mm256_mul_epu32(q_even, m);
+    __m256i qm_odd = _mm256_mul_epu32(q_odd, m);
+
+    __m256i t = _mm256_blend_epi32(_mm256_srli_epi64(t_even, 32), t_odd, 0xaa);
+    __m256i qm = _mm256_blend_epi32(_mm256_srli_epi64(qm_even, 32), qm_odd, 0xaa);
+    __m256i r = _mm256_sub_epi32(t, qm);
+    return _mm256_add_epi32(r, _mm256_and_si256(_mm256_cmpgt_epi32(qm, t), m));
+}
+
+// One half (even or odd lanes) of a Barrett product, in 64-bit lanes: x - qm < 3m < 2^33.
+CPU_TARGET_AVX2 static inline __m256i modular_barrett_avx2_half(
+    __m256i x, __m256i factor, __m256i m, __m128i low, __m128i high
+) {
+    __m256i q = _mm256_srl_epi64(_mm256_mul_epu32(_mm256_srl_epi64(x, low), factor), high);
+    __m256i r = _mm256_sub_epi64(x, _mm256_mul_epu32(q, m));
+    r = _mm256_sub_epi64(r, _mm256_andnot_si256(_mm256_cmpgt_epi64(m, r), m));
+    return _mm256_sub_epi64(r, _mm256_andnot_si256(_mm256_cmpgt_epi64(m, r), m));
+}
+
+CPU_TARGET_AVX2 static void modular_add_avx2(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+) {
+    __m256i m = _mm256_set1_epi32((int32_t) modulus);
+    size_t i = 0;
+    for (; i + MODULAR_LANES <= count; i += MODULAR_LANES) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*) (b + i));
+        _mm256_storeu_si256((__m256i*) (output + i), modular_add_avx2_one(va, vb, m));
+    }
+    modular_add_scalar(a + i, b + i, output + i, count - i, modulus);
+}
+
+CPU_TARGET_AVX2 static void modular_sub_avx2(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+) {
+    __m256i m = _mm256_set1_epi32((int32_t) modulus);
+    size_t i = 0;
+    for (; i + MODULAR_LANES <= count; i += MODULAR_LANES) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*) (b + i));
+        _mm256_storeu_si256((__m256i*) (output + i), modular_sub_avx2_one(va, vb, m));
+    }
+    modular_sub_scalar(a + i, b + i, output + i, count - i, modulus);
+}
+
+CPU_TARGET_AVX2 static void modular_mul_barrett_avx2(
+    const ModularBarrett* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+) {
+    __m256i m = _mm256_set1_epi64x(context->modulus);
+    __m256i factor = _mm256_set1_epi64x(context->factor);
+    __m128i low = _mm_cvtsi32_si128((int) context->shift - 1);
+    __m128i high = _mm_cvtsi32_si128((int) context->shift + 1);
+
+    size_t i = 0;
+    for (; i + MODULAR_LANES <= count; i += MODULAR_LANES) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*) (b + i));
+        __m256i even = _mm256_mul_epu32(va, vb);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(va, 32), _mm256_srli_epi64(vb, 32));
+        even = modular_barrett_avx2_half(even, factor, m, low, high);
+        odd = modular_barrett_avx2_half(odd, factor, m, low, high);
+        __m256i r = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+        _mm256_storeu_si256((__m256i*) (output + i), r);
+    }
+    modular_mul_barrett_scalar(context, a + i, b + i, output + i, count - i);
+}
+
+CPU_TARGET_AVX2 static void modular_mul_montgomery_avx2(
+    const ModularMontgomery* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+) {
+    __m256i m = _mm256_set1_epi32((int32_t) context->modulus);
+    __m256i inverse = _mm256_set1_epi32((int32_t) context->inverse);
+
+    size_t i = 0;
+    for (; i + MODULAR_LANES <= count; i += MODULAR_LANES) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*) (b + i));
+        __m256i r = modular_montgomery_avx2_one(va, vb, m, inverse);
+        _mm256_storeu_si256((__m256i*) (output + i), r);
+    }
+    modular_mul_montgomery_scalar(context, a + i, b + i, output + i, count - i);
+}
+
+// Called with count a multiple of MODULAR_LANES.
+CPU_TARGET_AVX2 static void modular_dif_avx2(
+    const ModularMontgomery* context, uint32_t* x, uint32_t* y, const uint32_t* w, size_t count
+) {
+    __m256i m = _mm256_set1_epi32((int32_t) context->modulus);
+    __m256i inverse = _mm256_set1_epi32((int32_t) context->inverse);
+    for (size_t j = 0; j < count; j += MODULAR_LANES) {
+        __m256i u = _mm256_loadu_si256((const __m256i*) (x + j));
+        __m256i v = _mm256_loadu_si256((const __m256i*) (y + j));
+        __m256i vw = _mm256_loadu_si256((const __m256i*) (w + j));
+        __m256i d = modular_sub_avx2_one(u, v, m);
+        _mm256_storeu_si256((__m256i*) (x + j), modular_add_avx2_one(u, v, m));
+        _mm256_storeu_si256((__m256i*) (y + j), modular_montgomery_avx2_one(d, vw, m, inverse));
+    }
+}
+
+CPU_TARGET_AVX2 static void modular_dit_avx2(
+    const ModularMontgomery* context, uint32_t* x, uint32_t* y, const uint32_t* w, size_t count
+) {
+    __m256i m = _mm256_set1_epi32((int32_t) context->modulus);
+    __m256i inverse = _mm256_set1_epi32((int32_t) context->inverse);
+    for (size_t j = 0; j < count; j += MODULAR_LANES) {
+        __m256i u = _mm256_loadu_si256((const __m256i*) (x + j));
+        __m256i v = _mm256_loadu_si256((const __m256i*) (y + j));
+        __m256i vw = _mm256_loadu_si256((const __m256i*) (w + j));
+        v = modular_montgomery_avx2_one(v, vw, m, inverse);
+        _mm256_storeu_si256((__m256i*) (x + j), modular_add_avx2_one(u, v, m));
+        _mm256_storeu_si256((__m256i*) (y + j), modular_sub_avx2_one(u, v, m));
+    }
+}
+
+#endif // CPU_X86
+
+static const ModularKernels MODULAR_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {
+        modular_add_scalar,
+        modular_sub_scalar,
+        modular_mul_barrett_scalar,
+        modular_mul_montgomery_scalar,
+        modular_dif_scalar,
+        modular_dit_scalar,
+    },
+    [CPU_LEVEL_SSE2] = {
+        modular_add_sse2,
+        modular_sub_sse2,
+        modular_mul_barrett_sse2,
+        modular_mul_montgomery_sse2,
+        modular_dif_sse2,
+        modular_dit_sse2,
+    },
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {
+        modular_add_avx2,
+        modular_sub_avx2,
+        modular_mul_barrett_avx2,
+        modular_mul_montgomery_avx2,
+        modular_dif_avx2,
+        modular_dit_avx2,
+    },
+    [CPU_LEVEL_AVX512] = {
+        modular_add_avx2,
+        modular_sub_avx2,
+        modular_mul_barrett_avx2,
+        modular_mul_montgomery_avx2,
+        modular_dif_avx2,
+        modular_dit_avx2,
+    },
+#endif
+};
+
+static const ModularKernels* modular_kernels(void) {
+    return &MODULAR_KERNELS[cpu_level()];
+}
+
+/**
+ * Array Kernels
+ */
+
+void modular_add(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+) {
+    assert(2 <= modulus && modulus < MODULAR_LIMIT);
+    modular_kernels()->add(a, b, output, count, modulus);
+}
+
+void modular_sub(
+    const uint32_t* a, const uint32_t* b, uint32_t* output, size_t count, uint32_t modulus
+) {
+    assert(2 <= modulus && modulus < MODULAR_LIMIT);
+    modular_kernels()->sub(a, b, output, count, modulus);
+}
+
+void modular_mul_barrett(
+    const ModularBarrett* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+) {
+    assert(context != NULL);
+    modular_kernels()->mul_barrett(context, a, b, output, count);
+}
+
+void modular_mul_montgomery(
+    const ModularMontgomery* context,
+    const uint32_t* a,
+    const uint32_t* b,
+    uint32_t* output,
+    size_t count
+) {
+    assert(context != NULL);
+    modular_kernels()->mul_montgomery(context, a, b, output, count);
+}
+
+// Multiplies every element by the same Montgomery factor, a block of copies at a time.
+static void modular_scale(
+    const ModularMontgomery* context,
+    const uint32_t* input,
+    uint32_t* output,
+    size_t count,
+    uint32_t factor
+) {
+    uint32_t block[64];
+    for (size_t i = 0; i < 64; i++) {
+        block[i] = factor;
+    }
+
+    const ModularKernels* kernels = modular_kernels();
+    for (size_t i = 0; i < count; i += 64) {
+        size_t n = count - i < 64 ? count - i : 64;
+        kernels->mul_montgomery(context, input + i, block, output + i, n);
+    }
+}
+
+void modular_to_montgomery(
+    const ModularMontgomery* context, const uint32_t* input, uint32_t* output, size_t count
+) {
+    assert(context != NULL);
+    modular_scale(context, input, output, count, context->square);
+}
+
+void modular_from_montgomery(
+    const ModularMontgomery* context, const uint32_t* input, uint32_t* output, size_t count
+) {
+    assert(context != NULL);
+    modular_scale(context, input, output, count, 1);
+}
+
+/**
+ * Number-Theoretic Transform
+ */
+
+// Smallest generator of (Z/p)*: g is one iff g^((p - 1) / q) != 1 for every prime q | p - 1.
+static uint32_t modular_generator(uint32_t p) {
+    uint32_t factors[32];
+    size_t count = 0;
+    uint32_t rest = p - 1;
+    for (uint32_t q = 2; q * q <= rest; q++) {
+        if (0 == rest % q) {
+            factors[count++] = q;
+            while (0 == rest % q) {
+                rest /= q;
+            }
+        }
+    }
+    if (rest > 1) {
+        factors[count++] = rest;
+    }
+
+    for (uint32_t g = 2;; g++) {
+        bool generator = true;
+        for (size_t i = 0; generator && i < count; i++) {
+            generator = 1 != prime_modular_exponent(g, (p - 1) / factors[i], p);
+        }
+        if (generator) {
+            return g;
+        }
+    }
+}
+
+// powers[j] = w^j for j < count, in eight interleaved chains so the multiplies overlap.
+static void modular_ntt_powers(
+    const ModularMontgomery* context, uint32_t* powers, size_t count, uint32_t w
+) {
+    powers[0] = context->one;
+    for (size_t j = 1; j < count && j < 8; j++) {
+        powers[j] = modular_montgomery_one(context, powers[j - 1], w);
+    }
+    if (count > 8) {
+        uint32_t step = modular_montgomery_one(context, powers[7], w); // w^8
+        for (size_t j = 8; j < count; j++) {
+            powers[j] = modular_montgomery_one(context, powers[j - 8], step);
+        }
+    }
+}
+
+bool modular_ntt_create(ModularNtt* ntt, uint32_t modulus, size_t size) {
+    assert(ntt != NULL);
+
+    memset(ntt, 0, sizeof(*ntt));
+    if (!modular_montgomery_create(&ntt->context, modulus) || !prime_miller_rabin(modulus)) {
+        return false;
+    }
+    if (0 == size || (size & (size - 1)) || 0 != (modulus - 1) % size) {
+        return false;
+    }
+
+    ntt->size = size;
+    ntt->roots = malloc(size * sizeof(uint32_t));
+    ntt->inverse_roots = malloc(size * sizeof(uint32_t));
+    if (!ntt->roots || !ntt->inverse_roots) {
+        modular_ntt_free(ntt);
+        return false;
+    }
+
+    const ModularMontgomery* context = &ntt->context;
+    uint32_t g = modular_generator(modulus);
+    if (size >= 2) {
+        size_t half = size / 2;
+        uint32_t w = (uint32_t) prime_modular_exponent(g, (modulus - 1) / size, modulus);
+        uint32_t w_inverse = (uint32_t) prime_modular_exponent(w, modulus - 2, modulus);
+        modular_ntt_powers(context, ntt->roots + half, half, modular_montgomery_to(context, w));
+        modular_ntt_powers(
+            context, ntt->inverse_roots + half, half, modular_montgomery_to(context, w_inverse)
+        );
+
+        // w_2h = w_size^(size / 2h), so every narrower stage is a strided copy of the widest.
+        for (size_t h = half / 2; h >= 1; h >>= 1) {
+            for (size_t j = 0; j < h; j++) {
+                ntt->roots[h + j] = ntt->roots[half + j * (half / h)];
+                ntt->inverse_roots[h + j] = ntt->inverse_roots[half + j * (half / h)];
+            }
+        }
+    }
+    ntt->roots[0] = ntt->inverse_roots[0] = context->one; // unused
+
+    uint32_t size_inverse = (uint32_t) prime_modular_exponent(size, modulus - 2, modulus);
+    ntt->scale = modular_montgomery_to(context, size_inverse);
+    return true;
+}
+
+void modular_ntt_free(ModularNtt* ntt) {
+    if (NULL == ntt) {
+        return;
+    }
+
+    free(ntt->roots);
+    free(ntt->inverse_roots);
+    memset(ntt, 0, sizeof(*ntt));
+}
+
+// One stage over `length` values. Stages narrower than a register run the scalar butterfly.
+static void modular_ntt_pass(
+    const ModularNtt* ntt,
+    uint32_t* values,
+    size_t length,
+    size_t h,
+    const uint32_t* roots,
+    ModularButterfly wide,
+    ModularButterfly narrow
+) {
+    ModularButterfly butterfly = h >= MODULAR_LANES ? wide : narrow;
+    for (size_t start = 0; start < length; start += 2 * h) {
+        butterfly(&ntt->context, values + start, values + start + h, roots + h, h);
+    }
+}
+
+// Once the butterflies are narrower than MODULAR_BLOCK, blocks of that size are independent: each
+// runs all of its remaining stages while it is in cache, instead of one stage per sweep of the
+// whole array.
+void modular_ntt_forward(const ModularNtt* ntt, uint32_t* values) {
+    assert(ntt != NULL && values != NULL);
+
+    ModularButterfly dif = modular_kernels()->dif;
+    size_t block = ntt->size < MODULAR_BLOCK ? ntt->size : MODULAR_BLOCK;
+    for (size_t h = ntt->size / 2; h >= block; h >>= 1) {
+        modular_ntt_pass(ntt, values, ntt->size, h, ntt->roots, dif, modular_dif_scalar);
+    }
+    for (size_t start = 0; start < ntt->size; start += block) {
+        for (size_t h = block / 2; h >= 1; h >>= 1) {
+            modular_ntt_pass(ntt, values + start, block, h, ntt->roots, dif, modular_dif_scalar);
+        }
+    }
+}
+
+// `scale` is the Montgomery factor applied at the end: size^-1, or more when the caller owes
+// a factor of R from an earlier Montgomery product.
+static void modular_ntt_inverse_scaled(const ModularNtt* ntt, uint32_t* values, uint32_t scale) {
+    ModularButterfly dit = modular_kernels()->dit;
+    const uint32_t* roots = ntt->inverse_roots;
+    size_t block = ntt->size < MODULAR_BLOCK ? ntt->size : MODULAR_BLOCK;
+    for (size_t start = 0; start < ntt->size; start += block) {
+        for (size_t h = 1; h < block; h <<= 1) {
+            modular_ntt_pass(ntt, values + start, block, h, roots, dit, modular_dit_scalar);
+        }
+    }
+    for (size_t h = block; h < ntt->size; h <<= 1) {
+        modular_ntt_pass(ntt, values, ntt->size, h, roots, dit, modular_dit_scalar);
+    }
+    modular_scale(&ntt->context, values, values, ntt->size, scale);
+}
+
+void modular_ntt_inverse(const ModularNtt* ntt, uint32_t* values) {
+    assert(ntt != NULL && values != NULL);
+    modular_ntt_inverse_scaled(ntt, values, ntt->scale);
+}
+
+static void modular_convolve_direct(
+    const uint32_t* a,
+    size_t a_count,
+    const uint32_t* b,
+    size_t b_count,
+    uint32_t* output,
+    const ModularBarrett* context
+) {
+    uint32_t m = context->modulus;
+    memset(output, 0, (a_count + b_count - 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < a_count; i++) {
+        uint32_t ai = a[i] % m;
+        for (size_t j = 0; j < b_count; j++) {
+            uint32_t product = modular_barrett_reduce(context, (uint64_t) ai * (b[j] % m));
+            output[i + j] = modular_add_scalar_one(output[i + j], product, m);
+        }
+    }
+}
+
+bool modular_convolve(
+    const uint32_t* a,
+    size_t a_count,
+    const uint32_t* b,
+    size_t b_count,
+    uint32_t* output,
+    uint32_t modulus
+) {
+    ModularBarrett barrett;
+    if (!modular_barrett_create(&barrett, modulus)) {
+        return false;
+    }
+    if (0 == a_count || 0 == b_count) {
+        return true;
+    }
+    assert(a != NULL && b != NULL && output != NULL);
+
+    if (a_count <= MODULAR_DIRECT || b_count <= MODULAR_DIRECT) {
+        modular_convolve_direct(a, a_count, b, b_count, output, &barrett);
+        return true;
+    }
+
+    size_t count = a_count + b_count - 1;
+    size_t size = 1;
+    while (size < count) {
+        size <<= 1;
+    }
+
+    ModularNtt ntt;
+    if (!modular_ntt_create(&ntt, modulus, size)) {
+        return false;
+    }
+    uint32_t* fa = calloc(size, sizeof(uint32_t));
+    uint32_t* fb = calloc(size, sizeof(uint32_t));
+    if (!fa || !fb) {
+        free(fa);
+        free(fb);
+        modular_ntt_free(&ntt);
+        return false;
+    }
+
+    for (size_t i = 0; i < a_count; i++) {
+        fa[i] = a[i] % modulus;
+    }
+    for (size_t i = 0; i < b_count; i++) {
+        fb[i] = b[i] % modulus;
+    }
+
+    modular_ntt_forward(&ntt, fa);
+    modular_ntt_forward(&ntt, fb);
+    modular_mul_montgomery(&ntt.context, fa, fb, fa, size); // ab / R
+    // size^-1 * R in Montgomery form puts back the R the pointwise product took off.
+    modular_ntt_inverse_scaled(&ntt, fa, modular_montgomery_to(&ntt.context, ntt.scale));
+    memcpy(output, fa, count * sizeof(uint32_t));
+
+    free(fa);
+    free(fb);
+    modular_ntt_free(&ntt);
+    return true;
+}
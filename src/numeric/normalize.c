@@ -0,0 +1,466 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file src/numeric/normalize.c
+ * @brief RMSNorm and LayerNorm over fp32, fp16 and bf16 rows.
+ */
+
+#include "core/cpu.h"
+#include "numeric/normalize.h"
+
+#include <assert.h>
+#include <math.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#define NORMALIZE_TILE 512 // fp32 elements per half-precision tile (2 KiB, L1-resident)
+#define NORMALIZE_GRAIN 16384 // elements per batch chunk, at least
+
+// Σ (x_i - shift) and Σ (x_i - shift)^2 over one pass.
+typedef struct NormalizeStats {
+    float sum;
+    float squares;
+} NormalizeStats;
+
+typedef NormalizeStats (*NormalizeMoments)(const float* x, size_t length, float shift);
+
+// y_i = (x_i - shift) * scale * w_i + b_i, with NULL w and b read as 1 and 0.
+typedef void (*NormalizeApply)(
+    const float* x,
+    float* y,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float shift,
+    float scale
+);
+
+typedef struct NormalizeKernels {
+    NormalizeMoments moments;
+    NormalizeApply apply;
+} NormalizeKernels;
+
+// Scalar Kernels
+
+static NormalizeStats normalize_moments_scalar(const float* x, size_t length, float shift) {
+    NormalizeStats stats = {0.0f, 0.0f};
+    for (size_t i = 0; i < length; i++) {
+        float d = x[i] - shift;
+        stats.sum += d;
+        stats.squares += d * d;
+    }
+    return stats;
+}
+
+static void normalize_apply_scalar(
+    const float* x,
+    float* y,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float shift,
+    float scale
+) {
+    for (size_t i = 0; i < length; i++) {
+        float v = (x[i] - shift) * scale;
+        v = weight ? v * weight[i] : v;
+        y[i] = bias ? v + bias[i] : v;
+    }
+}
+
+// SSE2 Kernels
+
+#if defined(__SSE2__)
+
+static inline float normalize_hsum_sse2(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static NormalizeStats normalize_moments_sse2(const float* x, size_t length, float shift) {
+    __m128 c = _mm_set1_ps(shift);
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    __m128 q0 = _mm_setzero_ps();
+    __m128 q1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(x + i), c);
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(x + i + 4), c);
+        s0 = _mm_add_ps(s0, d0);
+        s1 = _mm_add_ps(s1, d1);
+        q0 = _mm_add_ps(q0, _mm_mul_ps(d0, d0));
+        q1 = _mm_add_ps(q1, _mm_mul_ps(d1, d1));
+    }
+    NormalizeStats tail = normalize_moments_scalar(x + i, length - i, shift);
+    tail.sum += normalize_hsum_sse2(_mm_add_ps(s0, s1));
+    tail.squares += normalize_hsum_sse2(_mm_add_ps(q0, q1));
+    return tail;
+}
+
+static void normalize_apply_sse2(
+    const float* x,
+    float* y,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float shift,
+    float scale
+) {
+    __m128 c = _mm_set1_ps(shift);
+    __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), c), s);
+        if (weight) {
+            v = _mm_mul_ps(v, _mm_loadu_ps(weight + i));
+        }
+        if (bias) {
+            v = _mm_add_ps(v, _mm_loadu_ps(bias + i));
+        }
+        _mm_storeu_ps(y + i, v);
+    }
+    normalize_apply_scalar(
+        x + i,
+        y + i,
+        weight ? weight + i : NULL,
+        bias ? bias + i : NULL,
+        length - i,
+        shift,
+        scale
+    );
+}
+
+#else
+
+    #define normalize_moments_sse2 normalize_moments_scalar
+    #define normalize_apply_sse2 normalize_apply_scalar
+
+#endif // __SSE2__
+
+// AVX2 Kernels
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline float normalize_hsum_avx2(__m256 v) {
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+CPU_TARGET_AVX2 static NormalizeStats normalize_moments_avx2(
+    const float* x, size_t length, float shift
+) {
+    __m256 c = _mm256_set1_ps(shift);
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    __m256 q0 = _mm256_setzero_ps();
+    __m256 q1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(x + i), c);
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(x + i + 8), c);
+        s0 = _mm256_add_ps(s0, d0);
+        s1 = _mm256_add_ps(s1, d1);
+        q0 = _mm256_fmadd_ps(d0, d0, q0);
+        q1 = _mm256_fmadd_ps(d1, d1, q1);
+    }
+    for (; i + 8 <= length; i += 8) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(x + i), c);
+        s0 = _mm256_add_ps(s0, d0);
+        q0 = _mm256_fmadd_ps(d0, d0, q0);
+    }
+    NormalizeStats tail = normalize_moments_scalar(x + i, length - i, shift);
+    tail.sum += normalize_hsum_avx2(_mm256_add_ps(s0, s1));
+    tail.squares += normalize_hsum_avx2(_mm256_add_ps(q0, q1));
+    return tail;
+}
+
+CPU_TARGET_AVX2 static void normalize_apply_avx2(
+    const float* x,
+    float* y,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float shift,
+    float scale
+) {
+    __m256 c = _mm256_set1_ps(shift);
+    __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), c), s);
+        if (weight) {
+            v = _mm256_mul_ps(v, _mm256_loadu_ps(weight + i));
+        }
+        if (bias) {
+            v = _mm256_add_ps(v, _mm256_loadu_ps(bias + i));
+        }
+        _mm256_storeu_ps(y + i, v);
+    }
+    normalize_apply_scalar(
+        x + i,
+        y + i,
+        weight ? weight + i : NULL,
+        bias ? bias + i : NULL,
+        length - i,
+        shift,
+        scale
+    );
+}
+
+#endif // CPU_X86
+
+static const NormalizeKernels NORMALIZE_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {normalize_moments_scalar, normalize_apply_scalar},
+    [CPU_LEVEL_SSE2] = {normalize_moments_sse2, normalize_apply_sse2},
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {normalize_moments_avx2, normalize_apply_avx2},
+    [CPU_LEVEL_AVX512] = {normalize_moments_avx2, normalize_apply_avx2},
+#endif
+};
+
+/**
+ * Row Drivers
+ */
+
+// What every row of a call shares.
+typedef struct NormalizeParams {
+    const NormalizeKernels* kernels;
+    const float* weight;
+    const float* bias;
+    size_t length;
+    float epsilon;
+    bool centered; // LayerNorm
+} NormalizeParams;
+
+static NormalizeParams normalize_params(
+    const float* weight, const float* bias, size_t length, float epsilon, bool centered
+) {
+    assert(length > 0);
+    assert(epsilon >= 0.0f);
+
+    return (NormalizeParams) {
+        .kernels = &NORMALIZE_KERNELS[cpu_level()],
+        .weight = weight,
+        .bias = bias,
+        .length = length,
+        .epsilon = epsilon,
+        .centered = centered,
+    };
+}
+
+// Turns the statistics into the apply pass's shift and scale; *shift holds the stats' shift.
+static float normalize_scale(const NormalizeParams* params, NormalizeStats stats, float* shift) {
+    float n = (float) params->length;
+    if (!params->centered) {
+        return 1.0f / sqrtf(stats.squares / n + params->epsilon);
+    }
+    float offset = stats.sum / n;
+    float variance = stats.squares / n - offset * offset;
+    *shift += offset;
+    return 1.0f / sqrtf((variance > 0.0f ? variance : 0.0f) + params->epsilon);
+}
+
+static void normalize_row_fp32(const NormalizeParams* params, const float* x, float* y) {
+    float shift = params->centered ? x[0] : 0.0f;
+    NormalizeStats stats = params->kernels->moments(x, params->length, shift);
+    float scale = normalize_scale(params, stats, &shift);
+    params->kernels->apply(x, y, params->weight, params->bias, params->length, shift, scale);
+}
+
+static void normalize_row_half(
+    const NormalizeParams* params, bool bf16, const uint16_t* x, uint16_t* y
+) {
+    void (*widen)(const uint16_t*, float*, size_t) = bf16 ? dequantize_row_bf16
+                                                          : dequantize_row_fp16;
+    void (*narrow)(const float*, uint16_t*, size_t) = bf16 ? quantize_row_bf16
+                                                           : quantize_row_fp16;
+    float tile[NORMALIZE_TILE];
+    size_t length = params->length;
+
+    float shift = 0.0f;
+    NormalizeStats stats = {0.0f, 0.0f};
+    for (size_t i = 0; i < length; i += NORMALIZE_TILE) {
+        size_t n = length - i < NORMALIZE_TILE ? length - i : NORMALIZE_TILE;
+        widen(x + i, tile, n);
+        if (0 == i && params->centered) {
+            shift = tile[0];
+        }
+        NormalizeStats part = params->kernels->moments(tile, n, shift);
+        stats.sum += part.sum;
+        stats.squares += part.squares;
+    }
+    float scale = normalize_scale(params, stats, &shift);
+
+    for (size_t i = 0; i < length; i += NORMALIZE_TILE) {
+        size_t n = length - i < NORMALIZE_TILE ? length - i : NORMALIZE_TILE;
+        widen(x + i, tile, n);
+        params->kernels->apply(
+            tile,
+            tile,
+            params->weight ? params->weight + i : NULL,
+            params->bias ? params->bias + i : NULL,
+            n,
+            shift,
+            scale
+        );
+        narrow(tile, y + i, n);
+    }
+}
+
+static void normalize_row(
+    const NormalizeParams* params, DataTypeId type, const void* input, void* output
+) {
+    if (TYPE_FLOAT32 == type) {
+        normalize_row_fp32(params, (const float*) input, (float*) output);
+    } else {
+        normalize_row_half(
+            params, TYPE_BFLOAT16 == type, (const uint16_t*) input, (uint16_t*) output
+        );
+    }
+}
+
+typedef struct NormalizeTask {
+    const NormalizeParams* params;
+    DataTypeId type;
+    const uint8_t* input;
+    uint8_t* output;
+    size_t stride; // bytes per row
+} NormalizeTask;
+
+static void normalize_rows_task(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    NormalizeTask* task = (NormalizeTask*) context;
+    for (size_t r = begin; r < end; r++) {
+        size_t offset = r * task->stride;
+        normalize_row(task->params, task->type, task->input + offset, task->output + offset);
+    }
+}
+
+static bool normalize_rows(
+    ThreadPool* pool,
+    DataTypeId type,
+    const void* input,
+    void* output,
+    const NormalizeParams* params,
+    size_t rows
+) {
+    if (TYPE_FLOAT32 != type && TYPE_FLOAT16 != type && TYPE_BFLOAT16 != type) {
+        return false;
+    }
+    assert(input != NULL && output != NULL);
+
+    NormalizeTask task = {
+        .params = params,
+        .type = type,
+        .input = (const uint8_t*) input,
+        .output = (uint8_t*) output,
+        .stride = data_type_row_size(type, params->length),
+    };
+    size_t grain = params->length < NORMALIZE_GRAIN ? NORMALIZE_GRAIN / params->length : 1;
+    thread_pool_parallel_for(pool, rows, grain, normalize_rows_task, &task);
+    return true;
+}
+
+/**
+ * Public Functions
+ */
+
+void normalize_rms(
+    const float* input, float* output, const float* weight, size_t length, float epsilon
+) {
+    assert(input != NULL && output != NULL);
+    NormalizeParams params = normalize_params(weight, NULL, length, epsilon, false);
+    normalize_row_fp32(&params, input, output);
+}
+
+void normalize_rms_fp16(
+    const uint16_t* input, uint16_t* output, const float* weight, size_t length, float epsilon
+) {
+    assert(input != NULL && output != NULL);
+    NormalizeParams params = normalize_params(weight, NULL, length, epsilon, false);
+    normalize_row_half(&params, false, input, output);
+}
+
+void normalize_rms_bf16(
+    const uint16_t* input, uint16_t* output, const float* weight, size_t length, float epsilon
+) {
+    assert(input != NULL && output != NULL);
+    NormalizeParams params = normalize_params(weight, NULL, length, epsilon, false);
+    normalize_row_half(&params, true, input, output);
+}
+
+void normalize_layer(
+    const float* input,
+    float* output,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float epsilon
+) {
+    assert(input != NULL && output != NULL);
+    NormalizeParams params = normalize_params(weight, bias, length, epsilon, true);
+    normalize_row_fp32(&params, input, output);
+}
+
+void normalize_layer_fp16(
+    const uint16_t* input,
+    uint16_t* output,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float epsilon
+) {
+    assert(input != NULL && output != NULL);
+    NormalizeParams params = normalize_params(weight, bias, length, epsilon, true);
+    normalize_row_half(&params, false, input, output);
+}
+
+void normalize_layer_bf16(
+    const uint16_t* input,
+    uint16_t* output,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    float epsilon
+) {
+    assert(input != NULL && output != NULL);
+    NormalizeParams params = normalize_params(weight, bias, length, epsilon, true);
+    normalize_row_half(&params, true, input, output);
+}
+
+bool normalize_rms_rows(
+    ThreadPool* pool,
+    DataTypeId type,
+    const void* input,
+    void* output,
+    const float* weight,
+    size_t rows,
+    size_t length,
+    float epsilon
+) {
+    NormalizeParams params = normalize_params(weight, NULL, length, epsilon, false);
+    return normalize_rows(pool, type, input, output, &params, rows);
+}
+
+bool normalize_layer_rows(
+    ThreadPool* pool,
+    DataTypeId type,
+    const void* input,
+    void* output,
+    const float* weight,
+    const float* bias,
+    size_t rows,
+    size_t length,
+    float epsilon
+) {
+    NormalizeParams params = normalize_params(weight, bias, length, epsilon, true);
+    return normalize_rows(pool, type, input, output, &params, rows);
+}
@@ -1,114 +1,826 @@
 /**
  * Copyright © 2024 Austin Berrio
  *
- * @file src/prime.c
- *
- * @note Will need Mersenne twister for enhanced statistical properties. Use
- * Lehmer LCG PRNG for now since that's mostly implemented.
+ * @file src/numeric/prime.c
  */
 
-#include "logger.h"
-#include "memory.h"
+#include "core/cpu.h"
+#include "core/logger.h"
 #include "numeric/prime.h"
 
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#endif
 
-int32_t prime_modular_exponent(int32_t a, int32_t b, uint32_t m) {
-    int32_t result = 1;
-    a = a % m; // Ensuring base is within bounds of modulus
+__extension__ typedef unsigned __int128 PrimeU128;
 
+uint64_t prime_modular_exponent(uint64_t a, uint64_t b, uint64_t m) {
+    assert(m != 0);
+
+    uint64_t result = 1 % m;
+    a %= m;
     while (0 < b) {
-        if (b % 2 == 1) {
-            result = (result * a) % m;
+        if (b & 1) {
+            result = (uint64_t) ((PrimeU128) result * a % m);
         }
-        b = b >> 1; // Right-shift b by 1 (dividing by 2)
-        a = (a * a) % m; // Square a and reduce modulo m
+        b >>= 1;
+        a = (uint64_t) ((PrimeU128) a * a % m);
     }
-
     return result;
 }
 
-bool prime_miller_rabin(uint32_t n, uint16_t k) {
-    if (n <= 1 || (n > 2 && n % 2 == 0)) {
-        return false; // Handle non-prime edge cases
+/**
+ * Montgomery Arithmetic
+ *
+ * For odd n and R = 2^64, x is held as xR mod n. The reduction of T = ab < nR takes
+ * m = T * n^-1 mod R, so mn agrees with T in the low word and T / R - mn / R lies in (-n, n):
+ * one subtraction and a conditional add, with no 128-bit addition that could carry out.
+ */
+
+typedef struct PrimeMontgomery {
+    uint64_t n;
+    uint64_t inverse; // n^-1 mod 2^64
+    uint64_t one; // R mod n
+    uint64_t square; // R^2 mod n
+} PrimeMontgomery;
+
+static uint64_t prime_inverse_u64(uint64_t n) {
+    uint64_t x = n; // correct to 3 bits for odd n; each step doubles that
+    for (int i = 0; i < 5; i++) {
+        x *= 2 - n * x;
     }
+    return x;
+}
+
+static void prime_montgomery_create(PrimeMontgomery* m, uint64_t n) {
+    m->n = n;
+    m->inverse = prime_inverse_u64(n);
+    m->one = -n % n;
+    m->square = (uint64_t) ((PrimeU128) m->one * m->one % n);
+}
+
+static inline uint64_t prime_montgomery_multiply(const PrimeMontgomery* m, uint64_t a, uint64_t b) {
+    PrimeU128 t = (PrimeU128) a * b;
+    uint64_t q = (uint64_t) t * m->inverse;
+    uint64_t high = (uint64_t) ((PrimeU128) q * m->n >> 64);
+    uint64_t r = (uint64_t) (t >> 64) - high;
+    return (uint64_t) (t >> 64) < high ? r + m->n : r;
+}
 
-    int32_t s = n - 1;
-    while ((s & 1) == 0) {
-        s >>= 1; // Remove factors of 2
+// n - 1 = d * 2^s with n odd; true if n is a strong probable prime to base a.
+static bool prime_witness(const PrimeMontgomery* m, uint64_t a, uint64_t d, int s) {
+    a %= m->n;
+    if (0 == a) {
+        return true;
     }
 
-    lehmer_initialize(k);
-    for (int16_t i = 0; i < k; ++i) {
-        // Generate the next value using modulo
-        int32_t seed = lehmer_generate_int32();
+    uint64_t minus_one = m->n - m->one;
+    uint64_t base = prime_montgomery_multiply(m, a, m->square);
+    uint64_t x = m->one;
+    for (; d; d >>= 1) { // right to left: the squaring chain runs beside the product
+        if (d & 1) {
+            x = prime_montgomery_multiply(m, x, base);
+        }
+        base = prime_montgomery_multiply(m, base, base);
+    }
 
-        // Generate a random base in the range [2, n-2]
-        int32_t a = 2 + (seed % (n - 3));
-        int32_t x = prime_modular_exponent(a, s, n);
+    if (x == m->one || x == minus_one) {
+        return true;
+    }
+    for (int r = 1; r < s; r++) {
+        x = prime_montgomery_multiply(m, x, x);
+        if (x == minus_one) {
+            return true;
+        }
+    }
+    return false;
+}
 
-        if (x == 1 || x == n - 1) {
-            continue;
+static const uint64_t PRIME_WITNESSES_32[] = {2, 7, 61};
+static const uint64_t PRIME_WITNESSES_64[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+// n is divisible by odd p iff n * p^-1 mod 2^64 <= (2^64 - 1) / p, one multiply and no division.
+typedef struct PrimeDivisor {
+    uint64_t p;
+    uint64_t inverse;
+    uint64_t limit;
+} PrimeDivisor;
+
+static const PrimeDivisor PRIME_SMALL[] = {
+    {3, 0xaaaaaaaaaaaaaaabu, 0x5555555555555555u},
+    {5, 0xcccccccccccccccdu, 0x3333333333333333u},
+    {7, 0x6db6db6db6db6db7u, 0x2492492492492492u},
+    {11, 0x2e8ba2e8ba2e8ba3u, 0x1745d1745d1745d1u},
+    {13, 0x4ec4ec4ec4ec4ec5u, 0x13b13b13b13b13b1u},
+    {17, 0xf0f0f0f0f0f0f0f1u, 0x0f0f0f0f0f0f0f0fu},
+    {19, 0x86bca1af286bca1bu, 0x0d79435e50d79435u},
+    {23, 0xd37a6f4de9bd37a7u, 0x0b21642c8590b216u},
+    {29, 0x34f72c234f72c235u, 0x08d3dcb08d3dcb08u},
+    {31, 0xef7bdef7bdef7bdfu, 0x0842108421084210u},
+    {37, 0x14c1bacf914c1badu, 0x06eb3e45306eb3e4u},
+};
+#define PRIME_SMALL_SQUARE (41 * 41) // below this, surviving the screen means prime
+
+// Decides n by small factors where it can; returns false when Miller-Rabin is still needed.
+static bool prime_screen(uint64_t n, bool* prime) {
+    if (n < 2 || 0 == (n & 1)) {
+        *prime = 2 == n;
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(PRIME_SMALL) / sizeof(PrimeDivisor); i++) {
+        if (n * PRIME_SMALL[i].inverse <= PRIME_SMALL[i].limit) {
+            *prime = n == PRIME_SMALL[i].p;
+            return true;
+        }
+    }
+    if (n < PRIME_SMALL_SQUARE) {
+        *prime = true;
+        return true;
+    }
+    return false;
+}
+
+static bool prime_miller_rabin_odd(uint64_t n) {
+    PrimeMontgomery m;
+    prime_montgomery_create(&m, n);
+    int s = __builtin_ctzll(n - 1);
+    uint64_t d = (n - 1) >> s;
+
+    const uint64_t* witnesses = PRIME_WITNESSES_64;
+    size_t count = sizeof(PRIME_WITNESSES_64) / sizeof(uint64_t);
+    if (n <= UINT32_MAX) {
+        witnesses = PRIME_WITNESSES_32;
+        count = sizeof(PRIME_WITNESSES_32) / sizeof(uint64_t);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!prime_witness(&m, witnesses[i], d, s)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool prime_miller_rabin(uint64_t n) {
+    bool prime;
+    if (prime_screen(n, &prime)) {
+        return prime;
+    }
+    return prime_miller_rabin_odd(n);
+}
+
+/**
+ * Batch Kernels
+ *
+ * Candidates below 2^32 run with R = 2^32, one per 64-bit lane, because a 32 x 32 -> 64-bit
+ * multiply is all SSE2/AVX2 offer. Lanes differ in n, d and s: the exponent is walked right to
+ * left up to the longest d in the block, with the product blended in where a lane's bit is set,
+ * and the squaring tail runs to the largest s, a lane's result frozen once r reaches its own s.
+ * A block stops early once every lane has failed a witness. Each kernel takes blocks of
+ * PRIME_LANES screened odd candidates and writes 1 for prime.
+ */
+
+#define PRIME_LANES 4
+#define PRIME_BATCH 256 // candidates gathered before a kernel call, a multiple of PRIME_LANES
+
+typedef struct PrimeBatch {
+    uint32_t n[PRIME_BATCH];
+    uint32_t inverse[PRIME_BATCH]; // n^-1 mod 2^32
+    uint32_t one[PRIME_BATCH]; // 2^32 mod n
+    uint32_t square[PRIME_BATCH]; // 2^64 mod n
+    uint32_t d[PRIME_BATCH];
+    uint32_t s[PRIME_BATCH];
+    size_t index[PRIME_BATCH]; // position in the caller's arrays
+    uint8_t prime[PRIME_BATCH];
+    size_t count;
+} PrimeBatch;
+
+typedef void (*PrimeBatchKernel)(PrimeBatch* batch, size_t count);
+
+static inline uint32_t prime_montgomery_multiply_u32(
+    uint32_t a, uint32_t b, uint32_t n, uint32_t inverse
+) {
+    uint64_t t = (uint64_t) a * b;
+    uint32_t q = (uint32_t) t * inverse;
+    uint32_t high = (uint32_t) ((uint64_t) q * n >> 32);
+    uint32_t r = (uint32_t) (t >> 32) - high;
+    return (uint32_t) (t >> 32) < high ? r + n : r;
+}
+
+static void prime_batch_scalar(PrimeBatch* batch, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t n = batch->n[i];
+        uint32_t inverse = batch->inverse[i];
+        uint32_t minus_one = n - batch->one[i];
+        bool prime = true;
+
+        for (size_t w = 0; prime && w < sizeof(PRIME_WITNESSES_32) / sizeof(uint64_t); w++) {
+            uint32_t base = prime_montgomery_multiply_u32(
+                (uint32_t) PRIME_WITNESSES_32[w], batch->square[i], n, inverse
+            );
+            uint32_t x = batch->one[i];
+            for (uint32_t e = batch->d[i]; e; e >>= 1) {
+                if (e & 1) {
+                    x = prime_montgomery_multiply_u32(x, base, n, inverse);
+                }
+                base = prime_montgomery_multiply_u32(base, base, n, inverse);
+            }
+
+            bool passed = x == batch->one[i] || x == minus_one;
+            for (uint32_t r = 1; !passed && r < batch->s[i]; r++) {
+                x = prime_montgomery_multiply_u32(x, x, n, inverse);
+                passed = x == minus_one;
+            }
+            prime = passed;
+        }
+        batch->prime[i] = prime;
+    }
+}
+
+#if CPU_X86
+
+// Lanes hold values below 2^32 in 64-bit slots; only the low halves feed each multiply.
+CPU_TARGET_AVX2 static inline __m256i prime_montgomery_multiply_avx2(
+    __m256i a, __m256i b, __m256i n, __m256i inverse
+) {
+    __m256i t = _mm256_mul_epu32(a, b);
+    __m256i q = _mm256_mul_epu32(t, inverse);
+    __m256i high = _mm256_srli_epi64(_mm256_mul_epu32(q, n), 32);
+    __m256i r = _mm256_sub_epi64(_mm256_srli_epi64(t, 32), high);
+    __m256i negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), r);
+    return _mm256_add_epi64(r, _mm256_and_si256(negative, n));
+}
+
+CPU_TARGET_AVX2 static inline __m256i prime_load_avx2(const uint32_t* x) {
+    return _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*) x));
+}
+
+CPU_TARGET_AVX2 static void prime_batch_avx2(PrimeBatch* batch, size_t count) {
+    for (size_t i = 0; i < count; i += PRIME_LANES) {
+        __m256i n = prime_load_avx2(batch->n + i);
+        __m256i inverse = prime_load_avx2(batch->inverse + i);
+        __m256i one = prime_load_avx2(batch->one + i);
+        __m256i square = prime_load_avx2(batch->square + i);
+        __m256i d = prime_load_avx2(batch->d + i);
+        __m256i s = prime_load_avx2(batch->s + i);
+        __m256i minus_one = _mm256_sub_epi64(n, one);
+
+        __m256i lowest = _mm256_set1_epi64x(1);
+        uint32_t s_max = 0;
+        uint32_t d_max = 0;
+        for (size_t j = 0; j < PRIME_LANES; j++) {
+            s_max = batch->s[i + j] > s_max ? batch->s[i + j] : s_max;
+            d_max |= batch->d[i + j];
         }
+        int bits = 32 - __builtin_clz(d_max);
 
-        bool is_composite = true;
-        for (int32_t r = s; r != n - 1; r <<= 1) {
-            x = (x * x) % n;
+        __m256i composite = _mm256_setzero_si256();
+        for (size_t w = 0; w < sizeof(PRIME_WITNESSES_32) / sizeof(uint64_t); w++) {
+            __m256i a = _mm256_set1_epi64x((long long) PRIME_WITNESSES_32[w]);
+            __m256i base = prime_montgomery_multiply_avx2(a, square, n, inverse);
+            __m256i x = one;
+            for (int bit = 0; bit < bits; bit++) {
+                __m256i product = prime_montgomery_multiply_avx2(x, base, n, inverse);
+                __m256i set = _mm256_sub_epi64(
+                    _mm256_setzero_si256(),
+                    _mm256_and_si256(_mm256_srl_epi64(d, _mm_cvtsi32_si128(bit)), lowest)
+                );
+                x = _mm256_blendv_epi8(x, product, set);
+                base = prime_montgomery_multiply_avx2(base, base, n, inverse);
+            }
 
-            if (x == 1) {
-                return false; // Definitely composite
+            __m256i passed = _mm256_or_si256(
+                _mm256_cmpeq_epi64(x, one), _mm256_cmpeq_epi64(x, minus_one)
+            );
+            for (uint32_t r = 1; r < s_max; r++) {
+                x = prime_montgomery_multiply_avx2(x, x, n, inverse);
+                __m256i active = _mm256_cmpgt_epi64(s, _mm256_set1_epi64x(r));
+                passed = _mm256_or_si256(
+                    passed, _mm256_and_si256(active, _mm256_cmpeq_epi64(x, minus_one))
+                );
             }
-            if (x == n - 1) {
-                is_composite = false;
+            __m256i failed = _mm256_cmpeq_epi64(passed, _mm256_setzero_si256());
+            composite = _mm256_or_si256(composite, failed);
+            if (0xf == _mm256_movemask_pd(_mm256_castsi256_pd(composite))) {
                 break;
             }
         }
 
-        if (is_composite) {
-            return false;
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(composite));
+        for (size_t j = 0; j < PRIME_LANES; j++) {
+            batch->prime[i + j] = !((mask >> j) & 1);
         }
     }
+}
 
-    return true;
+#endif // CPU_X86
+
+// SSE2 has the multiply but no 64-bit compare, so the sign fix-up would cost more than it saves.
+static const PrimeBatchKernel PRIME_BATCH_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = prime_batch_scalar,
+    [CPU_LEVEL_SSE2] = prime_batch_scalar,
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = prime_batch_avx2,
+    [CPU_LEVEL_AVX512] = prime_batch_avx2,
+#endif
+};
+
+static uint32_t prime_inverse_u32(uint32_t n) {
+    uint32_t x = n;
+    for (int i = 0; i < 4; i++) {
+        x *= 2 - n * x;
+    }
+    return x;
 }
 
-PrimeSample* prime_sample_create(uint32_t size) {
-    if (2 > size) {
-        LOG_ERROR("Prime number sample size must be greater than 2.\n");
+static void prime_batch_push(PrimeBatch* batch, uint32_t n, size_t index) {
+    size_t i = batch->count++;
+    uint32_t one = -n % n;
+    int s = __builtin_ctz(n - 1);
+    batch->n[i] = n;
+    batch->inverse[i] = prime_inverse_u32(n);
+    batch->one[i] = one;
+    batch->square[i] = (uint32_t) ((uint64_t) one * one % n);
+    batch->d[i] = (n - 1) >> s;
+    batch->s[i] = (uint32_t) s;
+    batch->index[i] = index;
+}
+
+static void prime_batch_flush(PrimeBatch* batch, bool* prime) {
+    if (0 == batch->count) {
+        return;
+    }
+
+    // Pad the last block with a known prime rather than branch on a partial one.
+    size_t count = batch->count;
+    while (batch->count % PRIME_LANES) {
+        prime_batch_push(batch, 65537, SIZE_MAX);
+    }
+    PRIME_BATCH_KERNELS[cpu_level()](batch, batch->count);
+
+    for (size_t i = 0; i < count; i++) {
+        prime[batch->index[i]] = batch->prime[i];
+    }
+    batch->count = 0;
+}
+
+void prime_miller_rabin_batch(const uint64_t* n, bool* prime, size_t count) {
+    assert(count == 0 || (n != NULL && prime != NULL));
+
+    PrimeBatch batch;
+    batch.count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (prime_screen(n[i], &prime[i])) {
+            continue;
+        }
+        if (n[i] > UINT32_MAX) {
+            prime[i] = prime_miller_rabin_odd(n[i]);
+            continue;
+        }
+        prime_batch_push(&batch, (uint32_t) n[i], i);
+        if (PRIME_BATCH == batch.count) {
+            prime_batch_flush(&batch, prime);
+        }
+    }
+    prime_batch_flush(&batch, prime);
+}
+
+uint64_t prime_next(uint64_t n) {
+    if (n <= 2) {
+        return 2;
+    }
+
+    for (n |= 1; n >= 3; n += 2) { // wraps to 1 past 2^64 - 1
+        if (prime_miller_rabin(n)) {
+            return n;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Segmented Sieve
+ *
+ * Odd index k stands for 2k + 1. The sieving prime p crosses off p^2, p^2 + 2p, ... which are
+ * odd indices (p^2 - 1) / 2 + jp, so every prime walks its segment with stride p. Segment s holds
+ * odd indices [s * span, (s + 1) * span) with span = 64 * words, so segments start on word
+ * boundaries of the global bitmap and line up with the wheel pattern.
+ */
+
+#define PRIME_WHEEL_WORDS 15015 // 3 * 5 * 7 * 11 * 13 odd indices, times 64 bits
+#define PRIME_WHEEL_LARGEST 13
+
+static const uint32_t PRIME_WHEEL_PRIMES[] = {3, 5, 7, 11, 13};
+
+static uint64_t prime_wheel[PRIME_WHEEL_WORDS];
+static pthread_once_t prime_wheel_once = PTHREAD_ONCE_INIT;
+
+// Marks the wheel primes themselves too; segments clear them again.
+static void prime_wheel_initialize(void) {
+    for (size_t i = 0; i < sizeof(PRIME_WHEEL_PRIMES) / sizeof(uint32_t); i++) {
+        uint32_t p = PRIME_WHEEL_PRIMES[i];
+        for (uint64_t k = (p - 1) / 2; k < (uint64_t) PRIME_WHEEL_WORDS * 64; k += p) {
+            prime_wheel[k >> 6] |= (uint64_t) 1 << (k & 63);
+        }
+    }
+}
+
+static void prime_sieve_resolve(const PrimeSieveOptions* options, size_t* words, bool* wheel) {
+    size_t bytes = options && options->segment_bytes ? options->segment_bytes
+                                                      : PRIME_SIEVE_SEGMENT_BYTES;
+    *words = (bytes + 7) / 8;
+    *wheel = options ? options->wheel : true;
+}
+
+static uint64_t prime_isqrt(uint64_t n) {
+    uint64_t r = (uint64_t) sqrt((double) n);
+    while (r * r > n) {
+        r--;
+    }
+    while ((r + 1) * (r + 1) <= n) {
+        r++;
+    }
+    return r;
+}
+
+// Odd primes up to `limit` by a plain sieve; limit is below 2^25 here.
+static uint32_t* prime_sieve_base(uint64_t limit, size_t* count) {
+    size_t n = (size_t) (limit + 1) / 2; // odd indices of 1, 3, ..., limit
+    uint8_t* composite = calloc(n ? n : 1, 1);
+    if (NULL == composite) {
         return NULL;
     }
 
-    // Allocate memory for sampling
-    PrimeSample* sample = (PrimeSample*) malloc(sizeof(PrimeSample));
-    // Allocate memory for number of sampled data points
-    sample->data = malloc(size * sizeof(int16_t));
+    size_t found = 0;
+    for (size_t k = 1; k < n; k++) {
+        if (composite[k]) {
+            continue;
+        }
+        found++;
+        uint64_t p = 2 * k + 1;
+        for (uint64_t j = (p * p - 1) / 2; j < n; j += p) {
+            composite[j] = 1;
+        }
+    }
 
-    uint32_t j = 0;
+    uint32_t* primes = malloc((found ? found : 1) * sizeof(uint32_t));
+    if (primes) {
+        size_t i = 0;
+        for (size_t k = 1; k < n; k++) {
+            if (!composite[k]) {
+                primes[i++] = (uint32_t) (2 * k + 1);
+            }
+        }
+    }
+    free(composite);
+    *count = found;
+    return primes;
+}
 
-    // Handle the first prime (2) directly.
-    sample->data[j++] = 2;
+// Number of leading sieving primes the wheel pattern already covers.
+static size_t prime_sieve_first(const uint32_t* primes, size_t count, bool wheel) {
+    size_t first = 0;
+    while (wheel && first < count && primes[first] <= PRIME_WHEEL_LARGEST) {
+        first++;
+    }
+    return first;
+}
 
-    // Generate primes starting from 3
-    for (uint32_t i = 3; i <= size; i += 2) {
-        bool is_prime = true;
+// Sets the next odd index each prime crosses off at or after `start`.
+static void prime_sieve_seek(const uint32_t* primes, uint64_t* next, size_t count, uint64_t start) {
+    for (size_t i = 0; i < count; i++) {
+        uint64_t p = primes[i];
+        uint64_t square = (p * p - 1) / 2;
+        next[i] = start <= square ? square : start + (p - (start - square) % p) % p;
+    }
+}
 
-        for (uint32_t divisor = 3; divisor * divisor <= i; divisor += 2) {
-            if (i % divisor == 0) {
-                is_prime = false;
-                break;
+static void prime_bits_set(uint64_t* bits, uint64_t from, uint64_t to) {
+    for (uint64_t k = from; k < to;) {
+        if (0 == (k & 63) && k + 64 <= to) {
+            bits[k >> 6] = UINT64_MAX;
+            k += 64;
+        } else {
+            bits[k >> 6] |= (uint64_t) 1 << (k & 63);
+            k++;
+        }
+    }
+}
+
+typedef struct PrimeSegment {
+    uint64_t* bits;
+    size_t words;
+    uint64_t k_begin;
+    uint64_t k_end;
+    const uint32_t* primes;
+    uint64_t* next;
+    size_t first;
+    size_t count;
+    bool wheel;
+} PrimeSegment;
+
+static void prime_sieve_segment(const PrimeSegment* s, uint64_t segment) {
+    uint64_t* bits = s->bits;
+    uint64_t span = (uint64_t) s->words * 64;
+    uint64_t start = segment * span;
+    uint64_t end = start + span;
+
+    if (s->wheel) {
+        size_t offset = (size_t) ((start / 64) % PRIME_WHEEL_WORDS);
+        for (size_t w = 0; w < s->words;) {
+            size_t n = PRIME_WHEEL_WORDS - offset;
+            n = n < s->words - w ? n : s->words - w;
+            memcpy(bits + w, prime_wheel + offset, n * sizeof(uint64_t));
+            w += n;
+            offset = 0;
+        }
+        for (size_t i = 0; i < sizeof(PRIME_WHEEL_PRIMES) / sizeof(uint32_t); i++) {
+            uint64_t k = (PRIME_WHEEL_PRIMES[i] - 1) / 2;
+            if (k >= start && k < end) {
+                bits[(k - start) >> 6] &= ~((uint64_t) 1 << ((k - start) & 63));
             }
         }
+    } else {
+        memset(bits, 0, s->words * sizeof(uint64_t));
+    }
+
+    if (0 == start) {
+        bits[0] |= 1; // 1 is not prime
+    }
 
-        if (is_prime) {
-            sample->data[j++] = i;
+    for (size_t i = s->first; i < s->count; i++) {
+        uint64_t p = s->primes[i];
+        uint64_t k = s->next[i];
+        for (; k < end; k += p) {
+            uint64_t j = k - start;
+            bits[j >> 6] |= (uint64_t) 1 << (j & 63);
         }
+        s->next[i] = k;
     }
 
-    // Resize array to actual number of primes found
-    sample->data = realloc(sample->data, j * sizeof(int16_t));
-    sample->size = j;
+    if (s->k_begin > start) {
+        prime_bits_set(bits, 0, (s->k_begin < end ? s->k_begin : end) - start);
+    }
+    if (s->k_end < end) {
+        prime_bits_set(bits, (s->k_end > start ? s->k_end : start) - start, span);
+    }
+}
+
+static uint64_t prime_segment_count(const PrimeSegment* s) {
+    uint64_t composite = 0;
+    for (size_t w = 0; w < s->words; w++) {
+        composite += (uint64_t) __builtin_popcountll(s->bits[w]);
+    }
+    return (uint64_t) s->words * 64 - composite;
+}
+
+bool prime_sieve_create(
+    PrimeSieve* sieve, uint64_t low, uint64_t high, const PrimeSieveOptions* options
+) {
+    assert(sieve != NULL);
+
+    memset(sieve, 0, sizeof(*sieve));
+    if (high > PRIME_SIEVE_LIMIT) {
+        return false;
+    }
+
+    sieve->high = high;
+    sieve->two = low <= 2 && 2 < high;
+    if (low >= high || low / 2 >= high / 2) {
+        return true; // no odd candidates; only 2, if anything
+    }
+
+    size_t words;
+    bool wheel;
+    prime_sieve_resolve(options, &words, &wheel);
+    pthread_once(&prime_wheel_once, prime_wheel_initialize);
+
+    size_t count = 0;
+    uint32_t* primes = prime_sieve_base(prime_isqrt(high - 1), &count);
+    uint64_t* bits = malloc(words * sizeof(uint64_t));
+    uint64_t* next = malloc((count ? count : 1) * sizeof(uint64_t));
+    if (!primes || !bits || !next) {
+        free(primes);
+        free(bits);
+        free(next);
+        return false;
+    }
+
+    uint64_t span = (uint64_t) words * 64;
+    sieve->k_begin = low / 2;
+    sieve->k_end = high / 2;
+    sieve->segment = sieve->k_begin / span;
+    sieve->segment_end = (sieve->k_end + span - 1) / span;
+    sieve->bits = bits;
+    sieve->words = words;
+    sieve->primes = primes;
+    sieve->next = next;
+    sieve->count = count;
+    sieve->first = prime_sieve_first(primes, count, wheel);
+    sieve->wheel = wheel;
+
+    prime_sieve_seek(primes, next, count, sieve->segment * span);
+    PrimeSegment segment = {
+        bits, words, sieve->k_begin, sieve->k_end, primes, next, sieve->first, count, wheel
+    };
+    prime_sieve_segment(&segment, sieve->segment);
+    return true;
+}
+
+bool prime_sieve_next(PrimeSieve* sieve, uint64_t* prime) {
+    assert(sieve != NULL);
+    assert(prime != NULL);
+
+    if (sieve->two) {
+        sieve->two = false;
+        *prime = 2;
+        return true;
+    }
+
+    size_t span = sieve->words * 64;
+    for (;;) {
+        while (sieve->position < span) {
+            size_t w = sieve->position >> 6;
+            uint64_t open = ~sieve->bits[w] >> (sieve->position & 63);
+            if (open) {
+                sieve->position += (size_t) __builtin_ctzll(open);
+                *prime = 2 * (sieve->segment * span + sieve->position) + 1;
+                sieve->position++;
+                return true;
+            }
+            sieve->position = (w + 1) << 6;
+        }
+
+        if (sieve->segment + 1 >= sieve->segment_end) {
+            return false;
+        }
+        sieve->segment++;
+        sieve->position = 0;
+        PrimeSegment segment = {
+            sieve->bits,
+            sieve->words,
+            sieve->k_begin,
+            sieve->k_end,
+            sieve->primes,
+            sieve->next,
+            sieve->first,
+            sieve->count,
+            sieve->wheel,
+        };
+        prime_sieve_segment(&segment, sieve->segment);
+    }
+}
+
+void prime_sieve_free(PrimeSieve* sieve) {
+    if (NULL == sieve) {
+        return;
+    }
+
+    free(sieve->bits);
+    free(sieve->primes);
+    free(sieve->next);
+    memset(sieve, 0, sizeof(*sieve));
+}
+
+/**
+ * Parallel Counting
+ *
+ * Each thread takes a contiguous run of segments, seeks its sieving primes once to the start of
+ * the run and then carries them from segment to segment, as the iterator does.
+ */
+
+typedef struct PrimeCountTask {
+    PrimeSegment shape; // bits and next are per thread, taken from `scratch`
+    uint64_t* scratch;
+    uint64_t segment_begin;
+    uint64_t* partials;
+} PrimeCountTask;
+
+static void prime_count_task(void* context, size_t begin, size_t end, size_t thread) {
+    PrimeCountTask* task = context;
+    PrimeSegment s = task->shape;
+    s.bits = task->scratch + thread * (s.words + s.count);
+    s.next = s.bits + s.words;
+
+    uint64_t span = (uint64_t) s.words * 64;
+    prime_sieve_seek(s.primes, s.next, s.count, (task->segment_begin + begin) * span);
+
+    uint64_t total = 0;
+    for (size_t i = begin; i < end; i++) {
+        prime_sieve_segment(&s, task->segment_begin + i);
+        total += prime_segment_count(&s);
+    }
+    task->partials[thread] = total;
+}
+
+bool prime_count(
+    uint64_t low, uint64_t high, ThreadPool* pool, const PrimeSieveOptions* options, uint64_t* count
+) {
+    assert(count != NULL);
+
+    if (high > PRIME_SIEVE_LIMIT) {
+        return false;
+    }
+
+    *count = low <= 2 && 2 < high;
+    if (low >= high || low / 2 >= high / 2) {
+        return true;
+    }
 
+    size_t words;
+    bool wheel;
+    prime_sieve_resolve(options, &words, &wheel);
+    pthread_once(&prime_wheel_once, prime_wheel_initialize);
+
+    size_t primes_count = 0;
+    uint32_t* primes = prime_sieve_base(prime_isqrt(high - 1), &primes_count);
+    size_t threads = thread_pool_size(pool);
+    uint64_t* scratch = malloc(threads * (words + primes_count) * sizeof(uint64_t));
+    uint64_t* partials = calloc(threads, sizeof(uint64_t));
+    if (!primes || !scratch || !partials) {
+        free(primes);
+        free(scratch);
+        free(partials);
+        return false;
+    }
+
+    uint64_t span = (uint64_t) words * 64;
+    uint64_t k_begin = low / 2;
+    uint64_t k_end = high / 2;
+    uint64_t segment_begin = k_begin / span;
+    uint64_t segment_end = (k_end + span - 1) / span;
+
+    PrimeCountTask task = {
+        .shape = {
+            .words = words,
+            .k_begin = k_begin,
+            .k_end = k_end,
+            .primes = primes,
+            .first = prime_sieve_first(primes, primes_count, wheel),
+            .count = primes_count,
+            .wheel = wheel,
+        },
+        .scratch = scratch,
+        .segment_begin = segment_begin,
+        .partials = partials,
+    };
+    thread_pool_parallel_for(
+        pool, (size_t) (segment_end - segment_begin), 1, prime_count_task, &task
+    );
+
+    for (size_t i = 0; i < threads; i++) {
+        *count += partials[i];
+    }
+
+    free(primes);
+    free(scratch);
+    free(partials);
+    return true;
+}
+
+/**
+ * Samples
+ */
+
+PrimeSample* prime_sample_create(uint32_t size) {
+    if (2 > size || size > INT32_MAX) {
+        LOG_ERROR("Prime number sample size must be in [2, INT32_MAX].\n");
+        return NULL;
+    }
+
+    // Counting first sizes the buffer exactly.
+    uint64_t count = 0;
+    if (!prime_count(0, (uint64_t) size + 1, NULL, NULL, &count)) {
+        return NULL;
+    }
+
+    PrimeSieve sieve;
+    PrimeSample* sample = malloc(sizeof(PrimeSample));
+    int32_t* data = malloc(count * sizeof(int32_t));
+    if (!sample || !data || !prime_sieve_create(&sieve, 0, (uint64_t) size + 1, NULL)) {
+        LOG_ERROR("Failed to allocate the prime number sample.\n");
+        free(sample);
+        free(data);
+        return NULL;
+    }
+
+    uint64_t prime;
+    uint32_t j = 0;
+    while (j < count && prime_sieve_next(&sieve, &prime)) {
+        data[j++] = (int32_t) prime;
+    }
+    prime_sieve_free(&sieve);
+
+    sample->data = data;
+    sample->size = j;
     return sample;
 }
 
@@ -0,0 +1,630 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/numeric/random.c
+ * @brief Seedable, splittable pseudo-random generators with explicit state.
+ *
+ * Based on:
+ *  - "Scrambled Linear Pseudorandom Number Generators" by Blackman & Vigna (2021)
+ *    @ref https://prng.di.unimi.it/
+ *  - "PCG: A Family of Simple Fast Space-Efficient Statistically Good Algorithms for Random
+ *    Number Generation" by O'Neill (2014)
+ *    @ref https://www.pcg-random.org/
+ *  - "Parallel Random Numbers: As Easy as 1, 2, 3" by Salmon, Moraes, Dror & Shaw (2011)
+ *    @ref https://doi.org/10.1145/2063384.2063405
+ */
+
+#include "core/cpu.h"
+#include "numeric/random.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+/**
+ * Private Definitions
+ */
+
+__extension__ typedef unsigned __int128 RandomU128;
+
+#define RANDOM_TILE 256 // words converted at a time by the float and double fills
+
+static inline uint64_t random_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Seeds the generators' state words; a bijection, so distinct seeds give distinct states.
+static uint64_t random_splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15u);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+}
+
+static inline float random_to_float(uint32_t bits) {
+    return (float) (bits >> 8) * 0x1.0p-24f;
+}
+
+static inline double random_to_double(uint64_t bits) {
+    return (double) (int64_t) (bits >> 11) * 0x1.0p-53;
+}
+
+/**
+ * xoshiro256**
+ */
+
+static const uint64_t RANDOM_XOSHIRO_JUMP[4] = {
+    0x180EC6D33CFD0ABAu,
+    0xD5A61266F0C9392Cu,
+    0xA9582618E03FC9AAu,
+    0x39ABDC4529B1661Cu,
+};
+
+static const uint64_t RANDOM_XOSHIRO_LONG_JUMP[4] = {
+    0x76E15D3EFEFDCBBFu,
+    0xC5004E441C522FB3u,
+    0x77710069854EE241u,
+    0x39109BB02ACBE635u,
+};
+
+static inline uint64_t random_xoshiro_next(RandomXoshiro* x) {
+    uint64_t* s = x->s;
+    uint64_t result = random_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = random_rotl(s[3], 45);
+    return result;
+}
+
+// Applies the jump polynomial: the state after 2^k steps is a GF(2) combination of the next 256.
+static void random_xoshiro_jump(RandomXoshiro* x, const uint64_t* polynomial) {
+    uint64_t s[4] = {0};
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t b = 0; b < 64; b++) {
+            if (polynomial[i] & ((uint64_t) 1 << b)) {
+                for (size_t j = 0; j < 4; j++) {
+                    s[j] ^= x->s[j];
+                }
+            }
+            random_xoshiro_next(x);
+        }
+    }
+    memcpy(x->s, s, sizeof(s));
+}
+
+/**
+ * PCG64
+ */
+
+#define RANDOM_PCG_MULTIPLIER (((RandomU128) 2549297995355413924u << 64) + 4865540595714422341u)
+
+static inline RandomU128 random_pcg_load(const uint64_t* words) {
+    return ((RandomU128) words[1] << 64) | words[0];
+}
+
+static inline void random_pcg_store(uint64_t* words, RandomU128 value) {
+    words[0] = (uint64_t) value;
+    words[1] = (uint64_t) (value >> 64);
+}
+
+// XSL-RR: fold the halves together, then rotate by the top six bits.
+static inline uint64_t random_pcg_output(RandomU128 state) {
+    uint64_t value = (uint64_t) (state >> 64) ^ (uint64_t) state;
+    unsigned rotation = (unsigned) (state >> 122);
+    return (value >> rotation) | (value << ((0u - rotation) & 63));
+}
+
+// Brown's jump-ahead for LCGs: O(log delta) squarings of the affine step.
+static RandomU128 random_pcg_advance(RandomU128 state, RandomU128 delta, RandomU128 increment) {
+    RandomU128 multiply = 1;
+    RandomU128 add = 0;
+    RandomU128 step_multiply = RANDOM_PCG_MULTIPLIER;
+    RandomU128 step_add = increment;
+
+    while (delta) {
+        if (delta & 1) {
+            multiply *= step_multiply;
+            add = add * step_multiply + step_add;
+        }
+        step_add = (step_multiply + 1) * step_add;
+        step_multiply *= step_multiply;
+        delta >>= 1;
+    }
+    return multiply * state + add;
+}
+
+static void random_pcg_jump(RandomPcg* pcg, unsigned log2_delta) {
+    RandomU128 state = random_pcg_load(pcg->state);
+    RandomU128 increment = random_pcg_load(pcg->increment);
+    state = random_pcg_advance(state, (RandomU128) 1 << log2_delta, increment);
+    random_pcg_store(pcg->state, state);
+}
+
+/**
+ * Philox4x32-10
+ */
+
+#define RANDOM_PHILOX_M0 0xD2511F53u
+#define RANDOM_PHILOX_M1 0xCD9E8D57u
+#define RANDOM_PHILOX_W0 0x9E3779B9u // golden ratio
+#define RANDOM_PHILOX_W1 0xBB67AE85u // sqrt(3) - 1
+#define RANDOM_PHILOX_ROUNDS 10
+
+// Computes `blocks` consecutive blocks from `counter`, which is advanced past them.
+typedef void (*RandomPhiloxBlocks)(
+    const uint32_t* key, uint64_t* counter, uint32_t* output, size_t blocks
+);
+
+static inline void random_philox_increment(uint64_t* counter, uint64_t blocks) {
+    uint64_t low = counter[0];
+    counter[0] += blocks;
+    counter[1] += counter[0] < low;
+}
+
+static void random_philox_block(const uint32_t* key, const uint64_t* counter, uint32_t* output) {
+    uint32_t x0 = (uint32_t) counter[0];
+    uint32_t x1 = (uint32_t) (counter[0] >> 32);
+    uint32_t x2 = (uint32_t) counter[1];
+    uint32_t x3 = (uint32_t) (counter[1] >> 32);
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+
+    for (int r = 0; r < RANDOM_PHILOX_ROUNDS; r++) {
+        uint64_t p0 = (uint64_t) RANDOM_PHILOX_M0 * x0;
+        uint64_t p1 = (uint64_t) RANDOM_PHILOX_M1 * x2;
+        uint32_t y0 = (uint32_t) (p1 >> 32) ^ x1 ^ k0;
+        uint32_t y2 = (uint32_t) (p0 >> 32) ^ x3 ^ k1;
+        x1 = (uint32_t) p1;
+        x3 = (uint32_t) p0;
+        x0 = y0;
+        x2 = y2;
+        k0 += RANDOM_PHILOX_W0;
+        k1 += RANDOM_PHILOX_W1;
+    }
+
+    output[0] = x0;
+    output[1] = x1;
+    output[2] = x2;
+    output[3] = x3;
+}
+
+static void random_philox_blocks_scalar(
+    const uint32_t* key, uint64_t* counter, uint32_t* output, size_t blocks
+) {
+    for (size_t b = 0; b < blocks; b++) {
+        random_philox_block(key, counter, output + 4 * b);
+        random_philox_increment(counter, 1);
+    }
+}
+
+/**
+ * The SIMD kernels hold word w of several blocks in one vector and run the rounds on all of them
+ * at once. A batch needs the low counter word not to wrap inside it, so every lane shares the
+ * upper three words; the rare batch that would wrap goes through the scalar block.
+ */
+
+#if defined(__SSE2__)
+
+// Lane-wise 32x32 -> 64-bit products, split into low and high words.
+static inline void random_mulhilo_sse2(__m128i x, __m128i m, __m128i* lo, __m128i* hi) {
+    const __m128i even = _mm_set_epi32(0, -1, 0, -1);
+    __m128i pe = _mm_mul_epu32(x, m);
+    __m128i po = _mm_mul_epu32(_mm_srli_epi64(x, 32), m);
+    *lo = _mm_or_si128(_mm_and_si128(pe, even), _mm_slli_epi64(po, 32));
+    *hi = _mm_or_si128(_mm_srli_epi64(pe, 32), _mm_andnot_si128(even, po));
+}
+
+static void random_philox_blocks_sse2(
+    const uint32_t* key, uint64_t* counter, uint32_t* output, size_t blocks
+) {
+    const __m128i m0 = _mm_set1_epi32((int) RANDOM_PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int) RANDOM_PHILOX_M1);
+
+    size_t b = 0;
+    while (b + 4 <= blocks) {
+        if ((uint32_t) counter[0] > UINT32_MAX - 3) {
+            random_philox_blocks_scalar(key, counter, output + 4 * b, 1);
+            b++;
+            continue;
+        }
+
+        __m128i x0 = _mm_add_epi32(
+            _mm_set1_epi32((int) (uint32_t) counter[0]), _mm_set_epi32(3, 2, 1, 0)
+        );
+        __m128i x1 = _mm_set1_epi32((int) (uint32_t) (counter[0] >> 32));
+        __m128i x2 = _mm_set1_epi32((int) (uint32_t) counter[1]);
+        __m128i x3 = _mm_set1_epi32((int) (uint32_t) (counter[1] >> 32));
+        uint32_t k0 = key[0];
+        uint32_t k1 = key[1];
+
+        for (int r = 0; r < RANDOM_PHILOX_ROUNDS; r++) {
+            __m128i lo0, hi0, lo1, hi1;
+            random_mulhilo_sse2(x0, m0, &lo0, &hi0);
+            random_mulhilo_sse2(x2, m1, &lo1, &hi1);
+            x0 = _mm_xor_si128(_mm_xor_si128(hi1, x1), _mm_set1_epi32((int) k0));
+            x2 = _mm_xor_si128(_mm_xor_si128(hi0, x3), _mm_set1_epi32((int) k1));
+            x1 = lo1;
+            x3 = lo0;
+            k0 += RANDOM_PHILOX_W0;
+            k1 += RANDOM_PHILOX_W1;
+        }
+
+        // Word-major to block-major.
+        __m128i t0 = _mm_unpacklo_epi32(x0, x1);
+        __m128i t1 = _mm_unpacklo_epi32(x2, x3);
+        __m128i t2 = _mm_unpackhi_epi32(x0, x1);
+        __m128i t3 = _mm_unpackhi_epi32(x2, x3);
+        __m128i* out = (__m128i*) (output + 4 * b);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi64(t2, t3));
+
+        random_philox_increment(counter, 4);
+        b += 4;
+    }
+    random_philox_blocks_scalar(key, counter, output + 4 * b, blocks - b);
+}
+
+#else
+
+    #define random_philox_blocks_sse2 random_philox_blocks_scalar
+
+#endif // __SSE2__
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline void
+random_mulhilo_avx2(__m256i x, __m256i m, __m256i* lo, __m256i* hi) {
+    __m256i pe = _mm256_mul_epu32(x, m);
+    __m256i po = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+    *lo = _mm256_blend_epi32(pe, _mm256_slli_epi64(po, 32), 0xAA);
+    *hi = _mm256_blend_epi32(_mm256_srli_epi64(pe, 32), po, 0xAA);
+}
+
+CPU_TARGET_AVX2 static void random_philox_blocks_avx2(
+    const uint32_t* key, uint64_t* counter, uint32_t* output, size_t blocks
+) {
+    const __m256i m0 = _mm256_set1_epi32((int) RANDOM_PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi32((int) RANDOM_PHILOX_M1);
+
+    size_t b = 0;
+    while (b + 8 <= blocks) {
+        if ((uint32_t) counter[0] > UINT32_MAX - 7) {
+            random_philox_blocks_scalar(key, counter, output + 4 * b, 1);
+            b++;
+            continue;
+        }
+
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i x0 = _mm256_add_epi32(_mm256_set1_epi32((int) (uint32_t) counter[0]), lanes);
+        __m256i x1 = _mm256_set1_epi32((int) (uint32_t) (counter[0] >> 32));
+        __m256i x2 = _mm256_set1_epi32((int) (uint32_t) counter[1]);
+        __m256i x3 = _mm256_set1_epi32((int) (uint32_t) (counter[1] >> 32));
+        uint32_t k0 = key[0];
+        uint32_t k1 = key[1];
+
+        for (int r = 0; r < RANDOM_PHILOX_ROUNDS; r++) {
+            __m256i lo0, hi0, lo1, hi1;
+            random_mulhilo_avx2(x0, m0, &lo0, &hi0);
+            random_mulhilo_avx2(x2, m1, &lo1, &hi1);
+            x0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), _mm256_set1_epi32((int) k0));
+            x2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), _mm256_set1_epi32((int) k1));
+            x1 = lo1;
+            x3 = lo0;
+            k0 += RANDOM_PHILOX_W0;
+            k1 += RANDOM_PHILOX_W1;
+        }
+
+        // Within each 128-bit half, blocks 0-3 (low) and 4-7 (high) come out as in SSE2.
+        __m256i t0 = _mm256_unpacklo_epi32(x0, x1);
+        __m256i t1 = _mm256_unpacklo_epi32(x2, x3);
+        __m256i t2 = _mm256_unpackhi_epi32(x0, x1);
+        __m256i t3 = _mm256_unpackhi_epi32(x2, x3);
+        __m256i b0 = _mm256_unpacklo_epi64(t0, t1); // blocks 0 and 4
+        __m256i b1 = _mm256_unpackhi_epi64(t0, t1); // blocks 1 and 5
+        __m256i b2 = _mm256_unpacklo_epi64(t2, t3); // blocks 2 and 6
+        __m256i b3 = _mm256_unpackhi_epi64(t2, t3); // blocks 3 and 7
+
+        __m256i* out = (__m256i*) (output + 4 * b);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(b0, b1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(b2, b3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(b0, b1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(b2, b3, 0x31));
+
+        random_philox_increment(counter, 8);
+        b += 8;
+    }
+    random_philox_blocks_sse2(key, counter, output + 4 * b, blocks - b);
+}
+
+#endif // CPU_X86
+
+// AVX-512 runs the AVX2 kernel; the rounds are multiply-latency bound either way.
+static const RandomPhiloxBlocks RANDOM_PHILOX_BLOCKS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = random_philox_blocks_scalar,
+    [CPU_LEVEL_SSE2] = random_philox_blocks_sse2,
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = random_philox_blocks_avx2,
+    [CPU_LEVEL_AVX512] = random_philox_blocks_avx2,
+#endif
+};
+
+static void random_philox_refill(RandomPhilox* philox) {
+    random_philox_block(philox->key, philox->counter, philox->buffer);
+    random_philox_increment(philox->counter, 1);
+    philox->index = 0;
+}
+
+static inline uint32_t random_philox_next(RandomPhilox* philox) {
+    if (philox->index >= 4) {
+        random_philox_refill(philox);
+    }
+    return philox->buffer[philox->index++];
+}
+
+static void random_philox_fill(RandomPhilox* philox, uint32_t* output, size_t length) {
+    size_t i = 0;
+    while (i < length && philox->index < 4) {
+        output[i++] = philox->buffer[philox->index++];
+    }
+
+    size_t blocks = (length - i) / 4;
+    RANDOM_PHILOX_BLOCKS[cpu_level()](philox->key, philox->counter, output + i, blocks);
+    i += 4 * blocks;
+
+    while (i < length) {
+        output[i++] = random_philox_next(philox);
+    }
+}
+
+// A partly used block stays partly used: the words left are the same words, `blocks` further on.
+static void random_philox_jump(RandomPhilox* philox, uint64_t blocks) {
+    random_philox_increment(philox->counter, blocks);
+    if (philox->index < 4) {
+        uint64_t current[2] = {philox->counter[0], philox->counter[1]};
+        current[1] -= 0 == current[0];
+        current[0]--;
+        random_philox_block(philox->key, current, philox->buffer);
+    }
+}
+
+/**
+ * Seeding
+ */
+
+void random_seed(Random* random, RandomKind kind, uint64_t seed) {
+    random_stream(random, kind, seed, 0);
+}
+
+void random_stream(Random* random, RandomKind kind, uint64_t seed, uint64_t stream) {
+    assert(random != NULL);
+    assert(kind < RANDOM_KIND_COUNT);
+
+    memset(random, 0, sizeof(*random));
+    random->kind = kind;
+
+    switch (kind) {
+        case RANDOM_XOSHIRO256:
+            for (size_t i = 0; i < 4; i++) {
+                random->xoshiro.s[i] = random_splitmix64(&seed);
+            }
+            for (uint64_t i = 0; i < stream; i++) {
+                random_xoshiro_jump(&random->xoshiro, RANDOM_XOSHIRO_JUMP);
+            }
+            break;
+
+        case RANDOM_PCG64: {
+            // pcg_setseq_128_srandom_r() with initstate = seed and initseq = stream.
+            RandomU128 increment = ((RandomU128) stream << 1) | 1u;
+            RandomU128 state = increment; // one step from 0
+            state += seed;
+            state = state * RANDOM_PCG_MULTIPLIER + increment;
+            random_pcg_store(random->pcg.state, state);
+            random_pcg_store(random->pcg.increment, increment);
+            break;
+        }
+
+        case RANDOM_PHILOX:
+            random->philox.key[0] = (uint32_t) seed;
+            random->philox.key[1] = (uint32_t) (seed >> 32);
+            random->philox.counter[1] = stream;
+            random->philox.index = 4;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void random_jump(Random* random) {
+    assert(random != NULL);
+
+    switch (random->kind) {
+        case RANDOM_XOSHIRO256:
+            random_xoshiro_jump(&random->xoshiro, RANDOM_XOSHIRO_JUMP);
+            break;
+        case RANDOM_PCG64:
+            random_pcg_jump(&random->pcg, 64);
+            break;
+        case RANDOM_PHILOX:
+            random_philox_jump(&random->philox, (uint64_t) 1 << 32);
+            break;
+        default:
+            break;
+    }
+}
+
+void random_long_jump(Random* random) {
+    assert(random != NULL);
+
+    switch (random->kind) {
+        case RANDOM_XOSHIRO256:
+            random_xoshiro_jump(&random->xoshiro, RANDOM_XOSHIRO_LONG_JUMP);
+            break;
+        case RANDOM_PCG64:
+            random_pcg_jump(&random->pcg, 96);
+            break;
+        case RANDOM_PHILOX:
+            random_philox_jump(&random->philox, (uint64_t) 1 << 48);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Draws
+ */
+
+uint64_t random_u64(Random* random) {
+    assert(random != NULL);
+
+    switch (random->kind) {
+        case RANDOM_XOSHIRO256:
+            return random_xoshiro_next(&random->xoshiro);
+        case RANDOM_PCG64: {
+            RandomU128 state = random_pcg_load(random->pcg.state);
+            state = state * RANDOM_PCG_MULTIPLIER + random_pcg_load(random->pcg.increment);
+            random_pcg_store(random->pcg.state, state);
+            return random_pcg_output(state);
+        }
+        case RANDOM_PHILOX: {
+            uint64_t lo = random_philox_next(&random->philox);
+            uint64_t hi = random_philox_next(&random->philox);
+            return lo | hi << 32;
+        }
+        default:
+            return 0;
+    }
+}
+
+uint32_t random_u32(Random* random) {
+    assert(random != NULL);
+
+    if (RANDOM_PHILOX == random->kind) {
+        return random_philox_next(&random->philox);
+    }
+    return (uint32_t) (random_u64(random) >> 32);
+}
+
+float random_float(Random* random) {
+    return random_to_float(random_u32(random));
+}
+
+double random_double(Random* random) {
+    return random_to_double(random_u64(random));
+}
+
+/**
+ * Bulk Fills
+ *
+ * The 64-bit generators keep their state in locals for the whole loop, so it stays in registers;
+ * Philox computes whole blocks straight into the output.
+ */
+
+void random_fill_u64(Random* random, uint64_t* output, size_t length) {
+    assert(random != NULL);
+    assert(output != NULL || 0 == length);
+
+    switch (random->kind) {
+        case RANDOM_XOSHIRO256: {
+            RandomXoshiro x = random->xoshiro;
+            for (size_t i = 0; i < length; i++) {
+                output[i] = random_xoshiro_next(&x);
+            }
+            random->xoshiro = x;
+            break;
+        }
+        case RANDOM_PCG64: {
+            RandomU128 state = random_pcg_load(random->pcg.state);
+            RandomU128 increment = random_pcg_load(random->pcg.increment);
+            for (size_t i = 0; i < length; i++) {
+                state = state * RANDOM_PCG_MULTIPLIER + increment;
+                output[i] = random_pcg_output(state);
+            }
+            random_pcg_store(random->pcg.state, state);
+            break;
+        }
+        case RANDOM_PHILOX: {
+            uint32_t words[2 * RANDOM_TILE];
+            for (size_t i = 0; i < length; i += RANDOM_TILE) {
+                size_t n = length - i < RANDOM_TILE ? length - i : RANDOM_TILE;
+                random_philox_fill(&random->philox, words, 2 * n);
+                for (size_t j = 0; j < n; j++) {
+                    output[i + j] = words[2 * j] | (uint64_t) words[2 * j + 1] << 32;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void random_fill_u32(Random* random, uint32_t* output, size_t length) {
+    assert(random != NULL);
+    assert(output != NULL || 0 == length);
+
+    switch (random->kind) {
+        case RANDOM_XOSHIRO256: {
+            RandomXoshiro x = random->xoshiro;
+            for (size_t i = 0; i < length; i++) {
+                output[i] = (uint32_t) (random_xoshiro_next(&x) >> 32);
+            }
+            random->xoshiro = x;
+            break;
+        }
+        case RANDOM_PCG64: {
+            RandomU128 state = random_pcg_load(random->pcg.state);
+            RandomU128 increment = random_pcg_load(random->pcg.increment);
+            for (size_t i = 0; i < length; i++) {
+                state = state * RANDOM_PCG_MULTIPLIER + increment;
+                output[i] = (uint32_t) (random_pcg_output(state) >> 32);
+            }
+            random_pcg_store(random->pcg.state, state);
+            break;
+        }
+        case RANDOM_PHILOX:
+            random_philox_fill(&random->philox, output, length);
+            break;
+        default:
+            break;
+    }
+}
+
+void random_fill_float(Random* random, float* output, size_t length) {
+    assert(output != NULL || 0 == length);
+
+    uint32_t bits[RANDOM_TILE];
+    for (size_t i = 0; i < length; i += RANDOM_TILE) {
+        size_t n = length - i < RANDOM_TILE ? length - i : RANDOM_TILE;
+        random_fill_u32(random, bits, n);
+        for (size_t j = 0; j < n; j++) {
+            output[i + j] = random_to_float(bits[j]);
+        }
+    }
+}
+
+void random_fill_double(Random* random, double* output, size_t length) {
+    assert(output != NULL || 0 == length);
+
+    uint64_t bits[RANDOM_TILE];
+    for (size_t i = 0; i < length; i += RANDOM_TILE) {
+        size_t n = length - i < RANDOM_TILE ? length - i : RANDOM_TILE;
+        random_fill_u64(random, bits, n);
+        for (size_t j = 0; j < n; j++) {
+            output[i + j] = random_to_double(bits[j]);
+        }
+    }
+}
@@ -0,0 +1,967 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file src/numeric/reduce.c
+ * @brief Reductions and prefix scans over fp32 rows.
+ */
+
+#include "core/cpu.h"
+#include "numeric/reduce.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// What a sum kernel adds up; the norms and moments are sums of transformed elements.
+typedef enum ReduceOp {
+    REDUCE_OP_SUM, // x_i
+    REDUCE_OP_DOT, // x_i * y_i
+    REDUCE_OP_ABS, // |x_i|
+    REDUCE_OP_SQUARE, // x_i^2
+    REDUCE_OP_DEVIATION, // (x_i - shift)^2
+} ReduceOp;
+
+typedef float (*ReduceSum)(
+    ReduceOp op, const float* x, const float* y, float shift, size_t length
+);
+typedef float (*ReduceExtremum)(const float* x, size_t length, bool minimum);
+typedef size_t (*ReduceFind)(const float* x, size_t length, float value);
+typedef float (*ReduceScan)(
+    const float* x, float* output, size_t length, float base, bool exclusive
+);
+
+typedef struct ReduceKernels {
+    ReduceSum naive;
+    ReduceSum kahan;
+    ReduceExtremum extremum; // NaN-skipping min or max; +-INFINITY for an empty or NaN row
+    ReduceFind find; // first index holding `value`, or `length`
+    ReduceScan scan; // output = base + local prefix; returns the local total
+} ReduceKernels;
+
+/**
+ * Shared Helpers
+ */
+
+// y is NULL unless the op reads it, and NULL + i is undefined.
+static inline const float* reduce_offset(const float* y, size_t i) {
+    return y ? y + i : NULL;
+}
+
+// a + b rounded, with the rounding error in *error (Knuth's TwoSum, exact for any a and b).
+static inline float reduce_two_sum(float a, float b, float* error) {
+    float s = a + b;
+    float t = s - a;
+    *error = (a - (s - t)) + (b - t);
+    return s;
+}
+
+static inline void reduce_kahan_step(float* sum, float* carry, float value) {
+    float error;
+    *sum = reduce_two_sum(*sum, value, &error);
+    *carry += error;
+}
+
+// Adds one partial to a running (sum, carry) pair, compensated only in Kahan mode.
+static inline void reduce_accumulate(float* sum, float* carry, float value, ReduceMode mode) {
+    if (REDUCE_KAHAN == mode) {
+        reduce_kahan_step(sum, carry, value);
+    } else {
+        *sum += value;
+    }
+}
+
+static inline float reduce_pick(float value, float best, bool minimum) {
+    return (minimum ? value < best : value > best) ? value : best;
+}
+
+// Scalar Kernels
+
+static inline float reduce_term_scalar(
+    ReduceOp op, const float* x, const float* y, float shift, size_t i
+) {
+    switch (op) {
+        case REDUCE_OP_DOT:
+            return x[i] * y[i];
+        case REDUCE_OP_ABS:
+            return fabsf(x[i]);
+        case REDUCE_OP_SQUARE:
+            return x[i] * x[i];
+        case REDUCE_OP_DEVIATION: {
+            float d = x[i] - shift;
+            return d * d;
+        }
+        default:
+            return x[i];
+    }
+}
+
+static float reduce_naive_scalar(
+    ReduceOp op, const float* x, const float* y, float shift, size_t length
+) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        sum += reduce_term_scalar(op, x, y, shift, i);
+    }
+    return sum;
+}
+
+// Continues a compensated (sum, carry) over the elements in [begin, length).
+static inline void reduce_kahan_from_scalar(
+    ReduceOp op,
+    const float* x,
+    const float* y,
+    float shift,
+    size_t begin,
+    size_t length,
+    float* sum,
+    float* carry
+) {
+    for (size_t i = begin; i < length; i++) {
+        reduce_kahan_step(sum, carry, reduce_term_scalar(op, x, y, shift, i));
+    }
+}
+
+static float reduce_kahan_scalar(
+    ReduceOp op, const float* x, const float* y, float shift, size_t length
+) {
+    float sum = 0.0f;
+    float carry = 0.0f;
+    reduce_kahan_from_scalar(op, x, y, shift, 0, length, &sum, &carry);
+    return sum + carry;
+}
+
+static float reduce_extremum_scalar(const float* x, size_t length, bool minimum) {
+    float best = minimum ? INFINITY : -INFINITY;
+    for (size_t i = 0; i < length; i++) {
+        best = reduce_pick(x[i], best, minimum);
+    }
+    return best;
+}
+
+static size_t reduce_find_scalar(const float* x, size_t length, float value) {
+    for (size_t i = 0; i < length; i++) {
+        if (x[i] == value) {
+            return i;
+        }
+    }
+    return length;
+}
+
+// Scans on from a local running sum; every level finishes its tail here.
+static inline float reduce_scan_from_scalar(
+    const float* x, float* output, size_t length, float base, float local, bool exclusive
+) {
+    for (size_t i = 0; i < length; i++) {
+        float next = local + x[i];
+        output[i] = base + (exclusive ? local : next);
+        local = next;
+    }
+    return local;
+}
+
+static float reduce_scan_scalar(
+    const float* x, float* output, size_t length, float base, bool exclusive
+) {
+    return reduce_scan_from_scalar(x, output, length, base, 0.0f, exclusive);
+}
+
+// SSE2 Kernels
+
+#if defined(__SSE2__)
+
+static inline float reduce_hsum_sse2(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static inline __m128 reduce_term_sse2(
+    ReduceOp op, const float* x, const float* y, __m128 shift, size_t i
+) {
+    __m128 v = _mm_loadu_ps(x + i);
+    switch (op) {
+        case REDUCE_OP_DOT:
+            return _mm_mul_ps(v, _mm_loadu_ps(y + i));
+        case REDUCE_OP_ABS:
+            return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+        case REDUCE_OP_SQUARE:
+            return _mm_mul_ps(v, v);
+        case REDUCE_OP_DEVIATION:
+            v = _mm_sub_ps(v, shift);
+            return _mm_mul_ps(v, v);
+        default:
+            return v;
+    }
+}
+
+static inline __m128 reduce_two_sum_sse2(__m128 a, __m128 b, __m128* error) {
+    __m128 s = _mm_add_ps(a, b);
+    __m128 t = _mm_sub_ps(s, a);
+    *error = _mm_add_ps(_mm_sub_ps(a, _mm_sub_ps(s, t)), _mm_sub_ps(b, t));
+    return s;
+}
+
+static float reduce_naive_sse2(
+    ReduceOp op, const float* x, const float* y, float shift, size_t length
+) {
+    __m128 c = _mm_set1_ps(shift);
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    __m128 s2 = _mm_setzero_ps();
+    __m128 s3 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        s0 = _mm_add_ps(s0, reduce_term_sse2(op, x, y, c, i));
+        s1 = _mm_add_ps(s1, reduce_term_sse2(op, x, y, c, i + 4));
+        s2 = _mm_add_ps(s2, reduce_term_sse2(op, x, y, c, i + 8));
+        s3 = _mm_add_ps(s3, reduce_term_sse2(op, x, y, c, i + 12));
+    }
+    for (; i + 4 <= length; i += 4) {
+        s0 = _mm_add_ps(s0, reduce_term_sse2(op, x, y, c, i));
+    }
+    __m128 sum = _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3));
+    return reduce_hsum_sse2(sum)
+           + reduce_naive_scalar(op, x + i, reduce_offset(y, i), shift, length - i);
+}
+
+static float reduce_kahan_sse2(
+    ReduceOp op, const float* x, const float* y, float shift, size_t length
+) {
+    __m128 c = _mm_set1_ps(shift);
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    __m128 c0 = _mm_setzero_ps();
+    __m128 c1 = _mm_setzero_ps();
+    __m128 e0, e1;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        s0 = reduce_two_sum_sse2(s0, reduce_term_sse2(op, x, y, c, i), &e0);
+        s1 = reduce_two_sum_sse2(s1, reduce_term_sse2(op, x, y, c, i + 4), &e1);
+        c0 = _mm_add_ps(c0, e0);
+        c1 = _mm_add_ps(c1, e1);
+    }
+
+    float lanes[8];
+    _mm_storeu_ps(lanes, s0);
+    _mm_storeu_ps(lanes + 4, s1);
+    float sum = 0.0f;
+    float carry = reduce_hsum_sse2(_mm_add_ps(c0, c1));
+    for (size_t j = 0; j < 8; j++) {
+        reduce_kahan_step(&sum, &carry, lanes[j]);
+    }
+    reduce_kahan_from_scalar(op, x, y, shift, i, length, &sum, &carry);
+    return sum + carry;
+}
+
+// max/min return the second operand when either is NaN, so a NaN element never displaces `best`.
+static float reduce_extremum_sse2(const float* x, size_t length, bool minimum) {
+    __m128 m0 = _mm_set1_ps(minimum ? INFINITY : -INFINITY);
+    __m128 m1 = m0;
+    size_t i = 0;
+    if (minimum) {
+        for (; i + 8 <= length; i += 8) {
+            m0 = _mm_min_ps(_mm_loadu_ps(x + i), m0);
+            m1 = _mm_min_ps(_mm_loadu_ps(x + i + 4), m1);
+        }
+        m0 = _mm_min_ps(m0, m1);
+    } else {
+        for (; i + 8 <= length; i += 8) {
+            m0 = _mm_max_ps(_mm_loadu_ps(x + i), m0);
+            m1 = _mm_max_ps(_mm_loadu_ps(x + i + 4), m1);
+        }
+        m0 = _mm_max_ps(m0, m1);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, m0);
+    float best = reduce_extremum_scalar(x + i, length - i, minimum);
+    for (size_t j = 0; j < 4; j++) {
+        best = reduce_pick(lanes[j], best, minimum);
+    }
+    return best;
+}
+
+static size_t reduce_find_sse2(const float* x, size_t length, float value) {
+    __m128 v = _mm_set1_ps(value);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(x + i), v));
+        if (mask) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + reduce_find_scalar(x + i, length - i, value);
+}
+
+// Inclusive prefix of four lanes in two shifted adds.
+static inline __m128 reduce_prefix_sse2(__m128 v) {
+    v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+    return _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+}
+
+static float reduce_scan_sse2(
+    const float* x, float* output, size_t length, float base, bool exclusive
+) {
+    __m128 b = _mm_set1_ps(base);
+    __m128 running = _mm_setzero_ps(); // local total, in every lane
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 s = _mm_add_ps(reduce_prefix_sse2(_mm_loadu_ps(x + i)), running);
+        __m128 out = s;
+        if (exclusive) {
+            out = _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(s), 4)), running);
+        }
+        running = _mm_shuffle_ps(s, s, 0xFF);
+        _mm_storeu_ps(output + i, _mm_add_ps(b, out));
+    }
+    return reduce_scan_from_scalar(
+        x + i, output + i, length - i, base, _mm_cvtss_f32(running), exclusive
+    );
+}
+
+#else
+
+    #define reduce_naive_sse2 reduce_naive_scalar
+    #define reduce_kahan_sse2 reduce_kahan_scalar
+    #define reduce_extremum_sse2 reduce_extremum_scalar
+    #define reduce_find_sse2 reduce_find_scalar
+    #define reduce_scan_sse2 reduce_scan_scalar
+
+#endif // __SSE2__
+
+// AVX2 Kernels
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline float reduce_hsum_avx2(__m256 v) {
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+CPU_TARGET_AVX2 static inline __m256 reduce_term_avx2(
+    ReduceOp op, const float* x, const float* y, __m256 shift, size_t i
+) {
+    __m256 v = _mm256_loadu_ps(x + i);
+    switch (op) {
+        case REDUCE_OP_DOT:
+            return _mm256_mul_ps(v, _mm256_loadu_ps(y + i));
+        case REDUCE_OP_ABS:
+            return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+        case REDUCE_OP_SQUARE:
+            return _mm256_mul_ps(v, v);
+        case REDUCE_OP_DEVIATION:
+            v = _mm256_sub_ps(v, shift);
+            return _mm256_mul_ps(v, v);
+        default:
+            return v;
+    }
+}
+
+CPU_TARGET_AVX2 static inline __m256 reduce_two_sum_avx2(__m256 a, __m256 b, __m256* error) {
+    __m256 s = _mm256_add_ps(a, b);
+    __m256 t = _mm256_sub_ps(s, a);
+    *error = _mm256_add_ps(_mm256_sub_ps(a, _mm256_sub_ps(s, t)), _mm256_sub_ps(b, t));
+    return s;
+}
+
+CPU_TARGET_AVX2 static float reduce_naive_avx2(
+    ReduceOp op, const float* x, const float* y, float shift, size_t length
+) {
+    __m256 c = _mm256_set1_ps(shift);
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps();
+    __m256 s3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        s0 = _mm256_add_ps(s0, reduce_term_avx2(op, x, y, c, i));
+        s1 = _mm256_add_ps(s1, reduce_term_avx2(op, x, y, c, i + 8));
+        s2 = _mm256_add_ps(s2, reduce_term_avx2(op, x, y, c, i + 16));
+        s3 = _mm256_add_ps(s3, reduce_term_avx2(op, x, y, c, i + 24));
+    }
+    for (; i + 8 <= length; i += 8) {
+        s0 = _mm256_add_ps(s0, reduce_term_avx2(op, x, y, c, i));
+    }
+    __m256 sum = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+    return reduce_hsum_avx2(sum)
+           + reduce_naive_scalar(op, x + i, reduce_offset(y, i), shift, length - i);
+}
+
+CPU_TARGET_AVX2 static float reduce_kahan_avx2(
+    ReduceOp op, const float* x, const float* y, float shift, size_t length
+) {
+    __m256 c = _mm256_set1_ps(shift);
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    __m256 c0 = _mm256_setzero_ps();
+    __m256 c1 = _mm256_setzero_ps();
+    __m256 e0, e1;
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        s0 = reduce_two_sum_avx2(s0, reduce_term_avx2(op, x, y, c, i), &e0);
+        s1 = reduce_two_sum_avx2(s1, reduce_term_avx2(op, x, y, c, i + 8), &e1);
+        c0 = _mm256_add_ps(c0, e0);
+        c1 = _mm256_add_ps(c1, e1);
+    }
+    for (; i + 8 <= length; i += 8) {
+        s0 = reduce_two_sum_avx2(s0, reduce_term_avx2(op, x, y, c, i), &e0);
+        c0 = _mm256_add_ps(c0, e0);
+    }
+
+    float lanes[16];
+    _mm256_storeu_ps(lanes, s0);
+    _mm256_storeu_ps(lanes + 8, s1);
+    float sum = 0.0f;
+    float carry = reduce_hsum_avx2(_mm256_add_ps(c0, c1));
+    for (size_t j = 0; j < 16; j++) {
+        reduce_kahan_step(&sum, &carry, lanes[j]);
+    }
+    reduce_kahan_from_scalar(op, x, y, shift, i, length, &sum, &carry);
+    return sum + carry;
+}
+
+CPU_TARGET_AVX2 static float reduce_extremum_avx2(const float* x, size_t length, bool minimum) {
+    __m256 m0 = _mm256_set1_ps(minimum ? INFINITY : -INFINITY);
+    __m256 m1 = m0;
+    __m256 m2 = m0;
+    __m256 m3 = m0;
+    size_t i = 0;
+    if (minimum) {
+        for (; i + 32 <= length; i += 32) {
+            m0 = _mm256_min_ps(_mm256_loadu_ps(x + i), m0);
+            m1 = _mm256_min_ps(_mm256_loadu_ps(x + i + 8), m1);
+            m2 = _mm256_min_ps(_mm256_loadu_ps(x + i + 16), m2);
+            m3 = _mm256_min_ps(_mm256_loadu_ps(x + i + 24), m3);
+        }
+        m0 = _mm256_min_ps(_mm256_min_ps(m0, m1), _mm256_min_ps(m2, m3));
+    } else {
+        for (; i + 32 <= length; i += 32) {
+            m0 = _mm256_max_ps(_mm256_loadu_ps(x + i), m0);
+            m1 = _mm256_max_ps(_mm256_loadu_ps(x + i + 8), m1);
+            m2 = _mm256_max_ps(_mm256_loadu_ps(x + i + 16), m2);
+            m3 = _mm256_max_ps(_mm256_loadu_ps(x + i + 24), m3);
+        }
+        m0 = _mm256_max_ps(_mm256_max_ps(m0, m1), _mm256_max_ps(m2, m3));
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, m0);
+    float best = reduce_extremum_scalar(x + i, length - i, minimum);
+    for (size_t j = 0; j < 8; j++) {
+        best = reduce_pick(lanes[j], best, minimum);
+    }
+    return best;
+}
+
+CPU_TARGET_AVX2 static size_t reduce_find_avx2(const float* x, size_t length, float value) {
+    __m256 v = _mm256_set1_ps(value);
+    size_t i = 0;
+    // Four vectors per test until a block hits, then one at a time to locate it.
+    for (; i + 32 <= length; i += 32) {
+        __m256 e0 = _mm256_cmp_ps(_mm256_loadu_ps(x + i), v, _CMP_EQ_OQ);
+        __m256 e1 = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 8), v, _CMP_EQ_OQ);
+        __m256 e2 = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 16), v, _CMP_EQ_OQ);
+        __m256 e3 = _mm256_cmp_ps(_mm256_loadu_ps(x + i + 24), v, _CMP_EQ_OQ);
+        if (_mm256_movemask_ps(_mm256_or_ps(_mm256_or_ps(e0, e1), _mm256_or_ps(e2, e3)))) {
+            break;
+        }
+    }
+    for (; i + 8 <= length; i += 8) {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(x + i), v, _CMP_EQ_OQ));
+        if (mask) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + reduce_find_scalar(x + i, length - i, value);
+}
+
+// Inclusive prefix of eight lanes: within each 128-bit half, then the low half's total is added
+// to the high half.
+CPU_TARGET_AVX2 static inline __m256 reduce_prefix_avx2(__m256 v) {
+    v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 4)));
+    v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 8)));
+    __m256 low = _mm256_permute_ps(v, 0xFF);
+    return _mm256_add_ps(v, _mm256_permute2f128_ps(low, low, 0x08));
+}
+
+CPU_TARGET_AVX2 static float reduce_scan_avx2(
+    const float* x, float* output, size_t length, float base, bool exclusive
+) {
+    const __m256i last = _mm256_set1_epi32(7);
+    const __m256i previous = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    __m256 b = _mm256_set1_ps(base);
+    __m256 running = _mm256_setzero_ps(); // local total, in every lane
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256 s = _mm256_add_ps(reduce_prefix_avx2(_mm256_loadu_ps(x + i)), running);
+        __m256 out = s;
+        if (exclusive) {
+            out = _mm256_blend_ps(_mm256_permutevar8x32_ps(s, previous), running, 0x01);
+        }
+        running = _mm256_permutevar8x32_ps(s, last);
+        _mm256_storeu_ps(output + i, _mm256_add_ps(b, out));
+    }
+    return reduce_scan_from_scalar(
+        x + i, output + i, length - i, base, _mm256_cvtss_f32(running), exclusive
+    );
+}
+
+#endif // CPU_X86
+
+// AVX512 reuses the AVX2 kernels: the rows are memory-bound well before 16 lanes would pay off.
+static const ReduceKernels REDUCE_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {
+        reduce_naive_scalar,
+        reduce_kahan_scalar,
+        reduce_extremum_scalar,
+        reduce_find_scalar,
+        reduce_scan_scalar,
+    },
+    [CPU_LEVEL_SSE2] = {
+        reduce_naive_sse2,
+        reduce_kahan_sse2,
+        reduce_extremum_sse2,
+        reduce_find_sse2,
+        reduce_scan_sse2,
+    },
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {
+        reduce_naive_avx2,
+        reduce_kahan_avx2,
+        reduce_extremum_avx2,
+        reduce_find_avx2,
+        reduce_scan_avx2,
+    },
+    [CPU_LEVEL_AVX512] = {
+        reduce_naive_avx2,
+        reduce_kahan_avx2,
+        reduce_extremum_avx2,
+        reduce_find_avx2,
+        reduce_scan_avx2,
+    },
+#endif
+};
+
+static const ReduceKernels* reduce_kernels(void) {
+    return &REDUCE_KERNELS[cpu_level()];
+}
+
+/**
+ * Range Drivers
+ */
+
+// Naive leaves of REDUCE_BLOCK elements, split so that every leaf but the last is full.
+static float reduce_pairwise(
+    const ReduceKernels* kernels,
+    ReduceOp op,
+    const float* x,
+    const float* y,
+    float shift,
+    size_t length
+) {
+    if (length <= REDUCE_BLOCK) {
+        return kernels->naive(op, x, y, shift, length);
+    }
+    size_t half = (length / REDUCE_BLOCK + 1) / 2 * REDUCE_BLOCK;
+    return reduce_pairwise(kernels, op, x, y, shift, half)
+           + reduce_pairwise(kernels, op, x + half, reduce_offset(y, half), shift, length - half);
+}
+
+static float reduce_range(
+    const ReduceKernels* kernels,
+    ReduceOp op,
+    ReduceMode mode,
+    const float* x,
+    const float* y,
+    float shift,
+    size_t length
+) {
+    switch (mode) {
+        case REDUCE_PAIRWISE:
+            return reduce_pairwise(kernels, op, x, y, shift, length);
+        case REDUCE_KAHAN:
+            return kernels->kahan(op, x, y, shift, length);
+        default:
+            return kernels->naive(op, x, y, shift, length);
+    }
+}
+
+// Scans a range from the offset (base + carry); blocked unless naive.
+static void reduce_scan_range(
+    const ReduceKernels* kernels,
+    ReduceMode mode,
+    const float* x,
+    float* output,
+    size_t length,
+    float base,
+    float carry,
+    bool exclusive
+) {
+    size_t block = REDUCE_NAIVE == mode ? length : REDUCE_BLOCK;
+    for (size_t i = 0; i < length; i += block) {
+        size_t n = length - i < block ? length - i : block;
+        float total = kernels->scan(x + i, output + i, n, base + carry, exclusive);
+        reduce_accumulate(&base, &carry, total, mode);
+    }
+}
+
+/**
+ * Parallel Drivers
+ */
+
+// One per range: a sum (or an offset with its carry), an extremum, or a found index.
+typedef struct ReducePartial {
+    float value;
+    float carry;
+    size_t index;
+} ReducePartial;
+
+typedef struct ReduceTask {
+    const ReduceKernels* kernels;
+    const float* x;
+    const float* y;
+    float* output;
+    ReduceOp op;
+    ReduceMode mode;
+    float shift; // the mean for REDUCE_OP_DEVIATION, or the value to find
+    bool minimum;
+    bool exclusive;
+    ReducePartial* partials;
+} ReduceTask;
+
+// Without room for the partials, the loop runs on the caller.
+static ReducePartial* reduce_partials_create(
+    ThreadPool** pool, size_t* threads, ReducePartial* local, ReducePartial empty
+) {
+    *threads = thread_pool_size(*pool);
+    ReducePartial* partials = *threads > 1 ? malloc(*threads * sizeof(ReducePartial)) : NULL;
+    if (!partials) {
+        *pool = NULL;
+        *threads = 1;
+        partials = local;
+    }
+    for (size_t i = 0; i < *threads; i++) {
+        partials[i] = empty; // ranges left idle for short rows
+    }
+    return partials;
+}
+
+static void reduce_partials_free(ReducePartial* partials, ReducePartial* local) {
+    if (partials != local) {
+        free(partials);
+    }
+}
+
+static void reduce_sum_task(void* context, size_t begin, size_t end, size_t thread) {
+    ReduceTask* task = (ReduceTask*) context;
+    task->partials[thread].value = reduce_range(
+        task->kernels,
+        task->op,
+        task->mode,
+        task->x + begin,
+        reduce_offset(task->y, begin),
+        task->shift,
+        end - begin
+    );
+}
+
+static void reduce_extremum_task(void* context, size_t begin, size_t end, size_t thread) {
+    ReduceTask* task = (ReduceTask*) context;
+    task->partials[thread].value = task->kernels->extremum(
+        task->x + begin, end - begin, task->minimum
+    );
+}
+
+static void reduce_find_task(void* context, size_t begin, size_t end, size_t thread) {
+    ReduceTask* task = (ReduceTask*) context;
+    size_t index = task->kernels->find(task->x + begin, end - begin, task->shift);
+    task->partials[thread].index = index < end - begin ? begin + index : SIZE_MAX;
+}
+
+static void reduce_scan_task(void* context, size_t begin, size_t end, size_t thread) {
+    ReduceTask* task = (ReduceTask*) context;
+    reduce_scan_range(
+        task->kernels,
+        task->mode,
+        task->x + begin,
+        task->output + begin,
+        end - begin,
+        task->partials[thread].value,
+        task->partials[thread].carry,
+        task->exclusive
+    );
+}
+
+static float reduce_terms(
+    ThreadPool* pool,
+    ReduceOp op,
+    ReduceMode mode,
+    const float* x,
+    const float* y,
+    float shift,
+    size_t length
+) {
+    ReducePartial local;
+    size_t threads;
+    ReducePartial* partials = reduce_partials_create(
+        &pool, &threads, &local, (ReducePartial) {0.0f, 0.0f, 0}
+    );
+
+    ReduceTask task = {
+        .kernels = reduce_kernels(),
+        .x = x,
+        .y = y,
+        .op = op,
+        .mode = mode,
+        .shift = shift,
+        .partials = partials,
+    };
+    thread_pool_parallel_for(pool, length, REDUCE_GRAIN, reduce_sum_task, &task);
+
+    float sum = 0.0f;
+    float carry = 0.0f;
+    for (size_t i = 0; i < threads; i++) {
+        reduce_accumulate(&sum, &carry, partials[i].value, mode);
+    }
+    reduce_partials_free(partials, &local);
+    return sum + carry;
+}
+
+// +-INFINITY when every element is NaN (or is that infinity).
+static float reduce_extremum(ThreadPool* pool, const float* x, size_t length, bool minimum) {
+    float best = minimum ? INFINITY : -INFINITY;
+    ReducePartial local;
+    size_t threads;
+    ReducePartial* partials = reduce_partials_create(
+        &pool, &threads, &local, (ReducePartial) {best, 0.0f, 0}
+    );
+
+    ReduceTask task = {
+        .kernels = reduce_kernels(),
+        .x = x,
+        .minimum = minimum,
+        .partials = partials,
+    };
+    thread_pool_parallel_for(pool, length, REDUCE_GRAIN, reduce_extremum_task, &task);
+
+    for (size_t i = 0; i < threads; i++) {
+        best = reduce_pick(partials[i].value, best, minimum);
+    }
+    reduce_partials_free(partials, &local);
+    return best;
+}
+
+// First index holding `value`, or `length`.
+static size_t reduce_find(ThreadPool* pool, const float* x, size_t length, float value) {
+    ReducePartial local;
+    size_t threads;
+    ReducePartial* partials = reduce_partials_create(
+        &pool, &threads, &local, (ReducePartial) {0.0f, 0.0f, SIZE_MAX}
+    );
+
+    ReduceTask task = {
+        .kernels = reduce_kernels(),
+        .x = x,
+        .shift = value,
+        .partials = partials,
+    };
+    thread_pool_parallel_for(pool, length, REDUCE_GRAIN, reduce_find_task, &task);
+
+    size_t index = SIZE_MAX;
+    for (size_t i = 0; i < threads; i++) {
+        index = partials[i].index < index ? partials[i].index : index;
+    }
+    reduce_partials_free(partials, &local);
+    return index < length ? index : length;
+}
+
+static float reduce_value(ThreadPool* pool, const float* x, size_t length, bool minimum) {
+    assert(x != NULL);
+    assert(length > 0);
+
+    float best = reduce_extremum(pool, x, length, minimum);
+    if (isinf(best) && reduce_find(pool, x, length, best) == length) {
+        return NAN; // only NaN
+    }
+    return best;
+}
+
+static size_t reduce_index(ThreadPool* pool, const float* x, size_t length, bool minimum) {
+    assert(x != NULL);
+    assert(length > 0);
+
+    size_t index = reduce_find(pool, x, length, reduce_extremum(pool, x, length, minimum));
+    return index < length ? index : 0;
+}
+
+static void reduce_mean_variance(
+    ThreadPool* pool, const float* x, size_t length, ReduceMode mode, float* mean, float* variance
+) {
+    assert(x != NULL);
+    assert(length > 0);
+    assert(mean != NULL && variance != NULL);
+
+    float m = reduce_terms(pool, REDUCE_OP_SUM, mode, x, NULL, 0.0f, length) / (float) length;
+    float squares = reduce_terms(pool, REDUCE_OP_DEVIATION, mode, x, NULL, m, length);
+    *mean = m;
+    *variance = squares / (float) length;
+}
+
+// Range totals first (one range needs none), then every range scans from its offset.
+static void reduce_scan(
+    ThreadPool* pool,
+    const float* x,
+    float* output,
+    size_t length,
+    ReduceMode mode,
+    bool exclusive
+) {
+    assert(x != NULL && output != NULL);
+
+    ReducePartial local;
+    size_t threads;
+    ReducePartial* partials = reduce_partials_create(
+        &pool, &threads, &local, (ReducePartial) {0.0f, 0.0f, 0}
+    );
+
+    ReduceTask task = {
+        .kernels = reduce_kernels(),
+        .x = x,
+        .output = output,
+        .op = REDUCE_OP_SUM,
+        .mode = mode,
+        .exclusive = exclusive,
+        .partials = partials,
+    };
+    if (threads > 1) {
+        thread_pool_parallel_for(pool, length, REDUCE_GRAIN, reduce_sum_task, &task);
+        float sum = 0.0f;
+        float carry = 0.0f;
+        for (size_t i = 0; i < threads; i++) {
+            float total = partials[i].value;
+            partials[i].value = sum;
+            partials[i].carry = carry;
+            reduce_accumulate(&sum, &carry, total, mode);
+        }
+    }
+    thread_pool_parallel_for(pool, length, REDUCE_GRAIN, reduce_scan_task, &task);
+    reduce_partials_free(partials, &local);
+}
+
+/**
+ * Public Functions
+ */
+
+float reduce_sum(const float* x, size_t length, ReduceMode mode) {
+    return reduce_sum_parallel(NULL, x, length, mode);
+}
+
+float reduce_dot(const float* x, const float* y, size_t length, ReduceMode mode) {
+    return reduce_dot_parallel(NULL, x, y, length, mode);
+}
+
+float reduce_norm_l1(const float* x, size_t length, ReduceMode mode) {
+    return reduce_norm_l1_parallel(NULL, x, length, mode);
+}
+
+float reduce_norm_l2(const float* x, size_t length, ReduceMode mode) {
+    return reduce_norm_l2_parallel(NULL, x, length, mode);
+}
+
+void reduce_moments(const float* x, size_t length, ReduceMode mode, float* mean, float* variance) {
+    reduce_mean_variance(NULL, x, length, mode, mean, variance);
+}
+
+float reduce_min(const float* x, size_t length) {
+    return reduce_value(NULL, x, length, true);
+}
+
+float reduce_max(const float* x, size_t length) {
+    return reduce_value(NULL, x, length, false);
+}
+
+size_t reduce_argmin(const float* x, size_t length) {
+    return reduce_index(NULL, x, length, true);
+}
+
+size_t reduce_argmax(const float* x, size_t length) {
+    return reduce_index(NULL, x, length, false);
+}
+
+void reduce_scan_inclusive(const float* x, float* output, size_t length, ReduceMode mode) {
+    reduce_scan(NULL, x, output, length, mode, false);
+}
+
+void reduce_scan_exclusive(const float* x, float* output, size_t length, ReduceMode mode) {
+    reduce_scan(NULL, x, output, length, mode, true);
+}
+
+/**
+ * Public Parallel Functions
+ */
+
+float reduce_sum_parallel(ThreadPool* pool, const float* x, size_t length, ReduceMode mode) {
+    assert(x != NULL);
+    return reduce_terms(pool, REDUCE_OP_SUM, mode, x, NULL, 0.0f, length);
+}
+
+float reduce_dot_parallel(
+    ThreadPool* pool, const float* x, const float* y, size_t length, ReduceMode mode
+) {
+    assert(x != NULL && y != NULL);
+    return reduce_terms(pool, REDUCE_OP_DOT, mode, x, y, 0.0f, length);
+}
+
+float reduce_norm_l1_parallel(ThreadPool* pool, const float* x, size_t length, ReduceMode mode) {
+    assert(x != NULL);
+    return reduce_terms(pool, REDUCE_OP_ABS, mode, x, NULL, 0.0f, length);
+}
+
+float reduce_norm_l2_parallel(ThreadPool* pool, const float* x, size_t length, ReduceMode mode) {
+    assert(x != NULL);
+    return sqrtf(reduce_terms(pool, REDUCE_OP_SQUARE, mode, x, NULL, 0.0f, length));
+}
+
+void reduce_moments_parallel(
+    ThreadPool* pool, const float* x, size_t length, ReduceMode mode, float* mean, float* variance
+) {
+    reduce_mean_variance(pool, x, length, mode, mean, variance);
+}
+
+float reduce_min_parallel(ThreadPool* pool, const float* x, size_t length) {
+    return reduce_value(pool, x, length, true);
+}
+
+float reduce_max_parallel(ThreadPool* pool, const float* x, size_t length) {
+    return reduce_value(pool, x, length, false);
+}
+
+size_t reduce_argmin_parallel(ThreadPool* pool, const float* x, size_t length) {
+    return reduce_index(pool, x, length, true);
+}
+
+size_t reduce_argmax_parallel(ThreadPool* pool, const float* x, size_t length) {
+    return reduce_index(pool, x, length, false);
+}
+
+void reduce_scan_inclusive_parallel(
+    ThreadPool* pool, const float* x, float* output, size_t length, ReduceMode mode
+) {
+    reduce_scan(pool, x, output, length, mode, false);
+}
+
+void reduce_scan_exclusive_parallel(
+    ThreadPool* pool, const float* x, float* output, size_t length, ReduceMode mode
+) {
+    reduce_scan(pool, x, output, length, mode, true);
+}
@@ -0,0 +1,848 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file src/numeric/sparse.c
+ *
+ * @brief Sparse matrices in CSR, CSC and blocked-CSR form, with SpMV and SpMM over fp32.
+ */
+
+#include "core/cpu.h"
+#include "core/memory.h"
+#include "numeric/constant.h"
+#include "numeric/dot.h"
+#include "numeric/sparse.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdalign.h>
+#include <string.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+/**
+ * Private Definitions
+ */
+
+#define SPARSE_ALIGNMENT 64 // value arrays start on a cache line
+#define SPARSE_TILE 256 // values widened at once (1 KiB of fp32); a multiple of BLOCK_SIZE
+#define SPARSE_CHUNKS 4 // row ranges per thread for CSR and BSR, balanced by stored values
+#define SPARSE_GRAIN 64 // rows per scheduling unit of a CSC product
+#define SPARSE_NARROW 16 // BSR blocks narrower than this skip the dot kernels
+
+// Σ values_i · x[indices_i]
+typedef float (*SparseGather)(
+    const float* values, const uint32_t* indices, const float* x, size_t length
+);
+
+// y_i += a · x_i
+typedef void (*SparseAxpy)(float* y, const float* x, float a, size_t length);
+
+typedef struct SparseKernels {
+    SparseGather gather;
+    SparseAxpy axpy;
+} SparseKernels;
+
+// Scalar Kernels
+
+static float sparse_gather_scalar(
+    const float* values, const uint32_t* indices, const float* x, size_t length
+) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        sum += values[i] * x[indices[i]];
+    }
+    return sum;
+}
+
+static void sparse_axpy_scalar(float* y, const float* x, float a, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+// SSE2 Kernels
+
+#if defined(__SSE2__)
+
+static inline float sparse_hsum_sse2(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+// SSE2 has no gather: the lanes are loaded one by one, but two accumulators still overlap the
+// multiplies with the loads.
+static float sparse_gather_sse2(
+    const float* values, const uint32_t* indices, const float* x, size_t length
+) {
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        const uint32_t* k = indices + i;
+        __m128 g0 = _mm_set_ps(x[k[3]], x[k[2]], x[k[1]], x[k[0]]);
+        __m128 g1 = _mm_set_ps(x[k[7]], x[k[6]], x[k[5]], x[k[4]]);
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(values + i), g0));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(values + i + 4), g1));
+    }
+    float tail = sparse_gather_scalar(values + i, indices + i, x, length - i);
+    return sparse_hsum_sse2(_mm_add_ps(s0, s1)) + tail;
+}
+
+static void sparse_axpy_sse2(float* y, const float* x, float a, size_t length) {
+    __m128 s = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(s, _mm_loadu_ps(x + i)));
+        _mm_storeu_ps(y + i, v);
+    }
+    sparse_axpy_scalar(y + i, x + i, a, length - i);
+}
+
+#else
+
+    #define sparse_gather_sse2 sparse_gather_scalar
+    #define sparse_axpy_sse2 sparse_axpy_scalar
+
+#endif // __SSE2__
+
+// AVX2 Kernels
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline float sparse_hsum_avx2(__m256 v) {
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+CPU_TARGET_AVX2 static float sparse_gather_avx2(
+    const float* values, const uint32_t* indices, const float* x, size_t length
+) {
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i k0 = _mm256_loadu_si256((const __m256i*) (indices + i));
+        __m256i k1 = _mm256_loadu_si256((const __m256i*) (indices + i + 8));
+        __m256 g0 = _mm256_i32gather_ps(x, k0, 4);
+        __m256 g1 = _mm256_i32gather_ps(x, k1, 4);
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), g0, s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i + 8), g1, s1);
+    }
+    for (; i + 8 <= length; i += 8) {
+        __m256i k = _mm256_loadu_si256((const __m256i*) (indices + i));
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), _mm256_i32gather_ps(x, k, 4), s0);
+    }
+    float tail = sparse_gather_scalar(values + i, indices + i, x, length - i);
+    return sparse_hsum_avx2(_mm256_add_ps(s0, s1)) + tail;
+}
+
+CPU_TARGET_AVX2 static void sparse_axpy_avx2(float* y, const float* x, float a, size_t length) {
+    __m256 s = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256 v0 = _mm256_fmadd_ps(s, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+        __m256 v1 = _mm256_fmadd_ps(s, _mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8));
+        _mm256_storeu_ps(y + i, v0);
+        _mm256_storeu_ps(y + i + 8, v1);
+    }
+    for (; i + 8 <= length; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(s, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    sparse_axpy_scalar(y + i, x + i, a, length - i);
+}
+
+// AVX512 Kernels
+
+CPU_TARGET_AVX512 static float sparse_gather_avx512(
+    const float* values, const uint32_t* indices, const float* x, size_t length
+) {
+    __m512 s0 = _mm512_setzero_ps();
+    __m512 s1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m512i k0 = _mm512_loadu_si512((const void*) (indices + i));
+        __m512i k1 = _mm512_loadu_si512((const void*) (indices + i + 16));
+        __m512 g0 = _mm512_i32gather_ps(k0, x, 4);
+        __m512 g1 = _mm512_i32gather_ps(k1, x, 4);
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(values + i), g0, s0);
+        s1 = _mm512_fmadd_ps(_mm512_loadu_ps(values + i + 16), g1, s1);
+    }
+    if (i + 16 <= length) {
+        __m512i k = _mm512_loadu_si512((const void*) (indices + i));
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(values + i), _mm512_i32gather_ps(k, x, 4), s0);
+        i += 16;
+    }
+    float tail = sparse_gather_avx2(values + i, indices + i, x, length - i);
+    return _mm512_reduce_add_ps(_mm512_add_ps(s0, s1)) + tail;
+}
+
+#endif // CPU_X86
+
+// AVX512 keeps the AVX2 AXPY: B rows stream from memory well before 16 lanes would pay off.
+static const SparseKernels SPARSE_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {sparse_gather_scalar, sparse_axpy_scalar},
+    [CPU_LEVEL_SSE2] = {sparse_gather_sse2, sparse_axpy_sse2},
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {sparse_gather_avx2, sparse_axpy_avx2},
+    [CPU_LEVEL_AVX512] = {sparse_gather_avx512, sparse_axpy_avx2},
+#endif
+};
+
+/**
+ * Values
+ */
+
+static bool sparse_type_supported(DataTypeId type, size_t block_cols) {
+    switch (type) {
+        case TYPE_FLOAT32:
+        case TYPE_FLOAT16:
+        case TYPE_BFLOAT16:
+        case TYPE_FLOAT8_E4M3:
+        case TYPE_FLOAT8_E5M2:
+            return true;
+        case TYPE_BLOCK_Q8:
+        case TYPE_BLOCK_Q4:
+            return 0 == block_cols % BLOCK_SIZE;
+        default:
+            return false;
+    }
+}
+
+static bool sparse_type_is_block(DataTypeId type) {
+    return TYPE_BLOCK_Q8 == type || TYPE_BLOCK_Q4 == type;
+}
+
+// Address of value `offset`; block formats only ever start at whole blocks.
+static inline const void* sparse_value_at(const SparseMatrix* a, size_t offset) {
+    return (const uint8_t*) a->values + data_type_row_size(a->type, offset);
+}
+
+// Values [offset, offset + length) as fp32: in place for fp32, otherwise widened into `tile`.
+static inline const float* sparse_widen(
+    const SparseMatrix* a, size_t offset, size_t length, float* tile
+) {
+    assert(length <= SPARSE_TILE);
+    if (TYPE_FLOAT32 == a->type) {
+        return (const float*) a->values + offset;
+    }
+    dequantize_row(sparse_value_at(a, offset), tile, length, a->type);
+    return tile;
+}
+
+// One row of a BSR block times the matching stretch of x, without widening where a dot kernel
+// reads the stored type directly.
+static float sparse_block_dot(
+    const SparseMatrix* a, size_t offset, const float* x, const BlockQ8* xq, size_t length
+) {
+    const void* row = sparse_value_at(a, offset);
+    switch (a->type) {
+        case TYPE_FLOAT32:
+            return dot_fp32((const float*) row, x, length);
+        case TYPE_FLOAT16:
+            return dot_fp16_fp32((const uint16_t*) row, x, length);
+        case TYPE_BLOCK_Q8:
+            return dot_block_q8_q8((const BlockQ8*) row, xq, length);
+        case TYPE_BLOCK_Q4:
+            return dot_block_q4_q8((const BlockQ4*) row, xq, length);
+        default:
+            break;
+    }
+
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+    float sum = 0.0f;
+    for (size_t j = 0; j < length; j += SPARSE_TILE) {
+        size_t n = MIN(SPARSE_TILE, length - j);
+        sum += dot_fp32(sparse_widen(a, offset + j, n, tile), x + j, n);
+    }
+    return sum;
+}
+
+/**
+ * Builders
+ */
+
+// Allocates offsets, indices and values once `count` is known, and fills in the shape.
+static bool sparse_create(
+    SparseMatrix* m,
+    SparseFormat format,
+    DataTypeId type,
+    size_t rows,
+    size_t cols,
+    size_t block_rows,
+    size_t block_cols,
+    size_t lines,
+    size_t count
+) {
+    size_t block = block_rows * block_cols;
+    *m = (SparseMatrix) {
+        .format = format,
+        .type = type,
+        .rows = rows,
+        .cols = cols,
+        .block_rows = block_rows,
+        .block_cols = block_cols,
+        .count = count,
+        .stride = block_rows * data_type_row_size(type, block_cols),
+        .offsets = memory_calloc(lines + 1, sizeof(size_t), alignof(size_t)),
+        .indices = memory_alloc(MAX(count, 1) * sizeof(uint32_t), alignof(uint32_t)),
+        .values = memory_alloc(data_type_row_size(type, MAX(count * block, 1)), SPARSE_ALIGNMENT),
+    };
+    if (!m->offsets || !m->indices || !m->values) {
+        sparse_free(m);
+        return false;
+    }
+    return true;
+}
+
+// Stores `count` kept fp32 values in the matrix type, then releases them.
+static bool sparse_store(SparseMatrix* m, float* kept, size_t count) {
+    bool ok = 0 == count || quantize_row(kept, m->values, count, m->type);
+    memory_free(kept);
+    if (!ok) {
+        sparse_free(m);
+    }
+    return ok;
+}
+
+// NaN fails every comparison, so it is kept rather than silently pruned to zero.
+static inline bool sparse_kept(float value, float threshold) {
+    return !(fabsf(value) <= threshold);
+}
+
+static bool sparse_check(
+    SparseMatrix* m, DataTypeId type, size_t rows, size_t cols, size_t block_cols
+) {
+    memset(m, 0, sizeof(*m));
+    return sparse_type_supported(type, block_cols) && rows <= INT32_MAX && cols <= INT32_MAX;
+}
+
+bool sparse_csr_from_dense(
+    SparseMatrix* matrix,
+    DataTypeId type,
+    const float* dense,
+    size_t rows,
+    size_t cols,
+    size_t ld,
+    float threshold
+) {
+    assert(matrix != NULL);
+    assert(dense != NULL || 0 == rows * cols);
+
+    if (!sparse_check(matrix, type, rows, cols, 1)) {
+        return false;
+    }
+
+    size_t count = 0;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            count += sparse_kept(dense[r * ld + c], threshold);
+        }
+    }
+
+    float* kept = memory_alloc(MAX(count, 1) * sizeof(float), alignof(float));
+    if (!kept || !sparse_create(matrix, SPARSE_CSR, type, rows, cols, 1, 1, rows, count)) {
+        memory_free(kept);
+        return false;
+    }
+
+    size_t k = 0;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            float v = dense[r * ld + c];
+            if (sparse_kept(v, threshold)) {
+                matrix->indices[k] = (uint32_t) c;
+                kept[k++] = v;
+            }
+        }
+        matrix->offsets[r + 1] = k;
+    }
+    return sparse_store(matrix, kept, count);
+}
+
+bool sparse_csc_from_dense(
+    SparseMatrix* matrix,
+    DataTypeId type,
+    const float* dense,
+    size_t rows,
+    size_t cols,
+    size_t ld,
+    float threshold
+) {
+    assert(matrix != NULL);
+    assert(dense != NULL || 0 == rows * cols);
+
+    if (!sparse_check(matrix, type, rows, cols, 1)) {
+        return false;
+    }
+
+    size_t count = 0;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            count += sparse_kept(dense[r * ld + c], threshold);
+        }
+    }
+
+    float* kept = memory_alloc(MAX(count, 1) * sizeof(float), alignof(float));
+    if (!kept || !sparse_create(matrix, SPARSE_CSC, type, rows, cols, 1, 1, cols, count)) {
+        memory_free(kept);
+        return false;
+    }
+
+    // Count each column into offsets[c + 1] and sum to column starts in offsets[c]...
+    size_t* offsets = matrix->offsets;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            offsets[c + 1] += sparse_kept(dense[r * ld + c], threshold);
+        }
+    }
+    for (size_t c = 0; c < cols; c++) {
+        offsets[c + 1] += offsets[c];
+    }
+
+    // ...then fill row by row, using offsets[c] as the cursor of column c. Rows arrive in order,
+    // so each column comes out sorted, and every cursor ends on the start of the next column.
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            float v = dense[r * ld + c];
+            if (sparse_kept(v, threshold)) {
+                size_t k = offsets[c]++;
+                matrix->indices[k] = (uint32_t) r;
+                kept[k] = v;
+            }
+        }
+    }
+    memmove(offsets + 1, offsets, cols * sizeof(size_t));
+    offsets[0] = 0;
+    return sparse_store(matrix, kept, count);
+}
+
+static bool sparse_block_kept(
+    const float* dense, size_t ld, size_t block_rows, size_t block_cols, float threshold
+) {
+    for (size_t i = 0; i < block_rows; i++) {
+        for (size_t j = 0; j < block_cols; j++) {
+            if (sparse_kept(dense[i * ld + j], threshold)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool sparse_bsr_from_dense(
+    SparseMatrix* matrix,
+    DataTypeId type,
+    const float* dense,
+    size_t rows,
+    size_t cols,
+    size_t ld,
+    float threshold,
+    size_t block_rows,
+    size_t block_cols
+) {
+    assert(matrix != NULL);
+    assert(dense != NULL || 0 == rows * cols);
+
+    if (!sparse_check(matrix, type, rows, cols, block_cols) || 0 == block_rows
+        || 0 == block_cols || 0 != rows % block_rows || 0 != cols % block_cols) {
+        return false;
+    }
+
+    size_t lines = rows / block_rows;
+    size_t blocks = cols / block_cols;
+    size_t count = 0;
+    for (size_t bi = 0; bi < lines; bi++) {
+        for (size_t bj = 0; bj < blocks; bj++) {
+            const float* block = dense + bi * block_rows * ld + bj * block_cols;
+            count += sparse_block_kept(block, ld, block_rows, block_cols, threshold);
+        }
+    }
+
+    size_t size = block_rows * block_cols;
+    float* kept = memory_alloc(MAX(count * size, 1) * sizeof(float), alignof(float));
+    if (!kept
+        || !sparse_create(
+            matrix, SPARSE_BSR, type, rows, cols, block_rows, block_cols, lines, count
+        )) {
+        memory_free(kept);
+        return false;
+    }
+
+    size_t k = 0;
+    for (size_t bi = 0; bi < lines; bi++) {
+        for (size_t bj = 0; bj < blocks; bj++) {
+            const float* block = dense + bi * block_rows * ld + bj * block_cols;
+            if (sparse_block_kept(block, ld, block_rows, block_cols, threshold)) {
+                for (size_t i = 0; i < block_rows; i++) {
+                    memcpy(
+                        kept + (k * block_rows + i) * block_cols,
+                        block + i * ld,
+                        block_cols * sizeof(float)
+                    );
+                }
+                matrix->indices[k++] = (uint32_t) bj;
+            }
+        }
+        matrix->offsets[bi + 1] = k;
+    }
+    return sparse_store(matrix, kept, count * size);
+}
+
+void sparse_free(SparseMatrix* matrix) {
+    if (matrix) {
+        memory_free(matrix->offsets);
+        memory_free(matrix->indices);
+        memory_free(matrix->values);
+        memset(matrix, 0, sizeof(*matrix));
+    }
+}
+
+void sparse_to_dense(const SparseMatrix* matrix, float* dense, size_t ld) {
+    assert(matrix != NULL);
+    assert(dense != NULL || 0 == matrix->rows * matrix->cols);
+
+    const SparseMatrix* a = matrix;
+    for (size_t r = 0; r < a->rows; r++) {
+        memset(dense + r * ld, 0, a->cols * sizeof(float));
+    }
+
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+    size_t width = a->block_cols;
+    size_t lines = SPARSE_CSC == a->format ? a->cols : a->rows / a->block_rows;
+    for (size_t line = 0; line < lines; line++) {
+        for (size_t k = a->offsets[line]; k < a->offsets[line + 1]; k++) {
+            if (SPARSE_CSR == a->format) {
+                dense[line * ld + a->indices[k]] = *sparse_widen(a, k, 1, tile);
+                continue;
+            }
+            if (SPARSE_CSC == a->format) {
+                dense[a->indices[k] * ld + line] = *sparse_widen(a, k, 1, tile);
+                continue;
+            }
+            for (size_t i = 0; i < a->block_rows; i++) {
+                float* out = dense + (line * a->block_rows + i) * ld + a->indices[k] * width;
+                size_t offset = (k * a->block_rows + i) * width;
+                for (size_t j = 0; j < width; j += SPARSE_TILE) {
+                    size_t n = MIN(SPARSE_TILE, width - j);
+                    memcpy(out + j, sparse_widen(a, offset + j, n, tile), n * sizeof(float));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Products
+ */
+
+typedef struct SparseTask {
+    const SparseKernels* kernels;
+    const SparseMatrix* a;
+    size_t chunks; // value-balanced ranges of rows (CSR) or block rows (BSR)
+    const float* x;
+    const BlockQ8* xq; // x quantized, for the block formats
+    float* y;
+    const float* b;
+    size_t ldb;
+    float* c;
+    size_t ldc;
+    size_t n;
+} SparseTask;
+
+// First line whose values start at or after `target`.
+static size_t sparse_line_at(const size_t* offsets, size_t lines, size_t target) {
+    size_t low = 0;
+    size_t high = lines;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (offsets[mid] < target) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Lines covered by chunks [begin, end): boundaries depend only on the matrix and the chunk count.
+static void sparse_lines(
+    const SparseTask* t, size_t begin, size_t end, size_t* first, size_t* last
+) {
+    const SparseMatrix* a = t->a;
+    size_t lines = a->rows / a->block_rows;
+    size_t low = begin * a->count / t->chunks;
+    size_t high = end * a->count / t->chunks;
+    *first = 0 == begin ? 0 : sparse_line_at(a->offsets, lines, low);
+    *last = t->chunks == end ? lines : sparse_line_at(a->offsets, lines, high);
+}
+
+// Values of CSC column `col` whose rows fall in [first, last), as [*low, *high).
+static void sparse_column_rows(
+    const SparseMatrix* a, size_t col, size_t first, size_t last, size_t* low, size_t* high
+) {
+    size_t start = a->offsets[col];
+    size_t end = a->offsets[col + 1];
+    while (start < end) {
+        size_t mid = start + (end - start) / 2;
+        if (a->indices[mid] < first) {
+            start = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    *low = start;
+    *high = start;
+    end = a->offsets[col + 1];
+    while (*high < end && a->indices[*high] < last) {
+        (*high)++;
+    }
+}
+
+static void sparse_spmv_csr(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const SparseTask* t = (const SparseTask*) context;
+    const SparseMatrix* a = t->a;
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+
+    size_t first;
+    size_t last;
+    sparse_lines(t, begin, end, &first, &last);
+    for (size_t r = first; r < last; r++) {
+        float sum = 0.0f;
+        for (size_t k = a->offsets[r]; k < a->offsets[r + 1]; k += SPARSE_TILE) {
+            size_t n = MIN(SPARSE_TILE, a->offsets[r + 1] - k);
+            const float* v = sparse_widen(a, k, n, tile);
+            sum += t->kernels->gather(v, a->indices + k, t->x, n);
+        }
+        t->y[r] = sum;
+    }
+}
+
+static void sparse_spmv_csc(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const SparseTask* t = (const SparseTask*) context;
+    const SparseMatrix* a = t->a;
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+
+    memset(t->y + begin, 0, (end - begin) * sizeof(float));
+    for (size_t col = 0; col < a->cols; col++) {
+        size_t low;
+        size_t high;
+        sparse_column_rows(a, col, begin, end, &low, &high);
+        float xc = t->x[col];
+        for (size_t k = low; k < high; k += SPARSE_TILE) {
+            size_t n = MIN(SPARSE_TILE, high - k);
+            const float* v = sparse_widen(a, k, n, tile);
+            for (size_t i = 0; i < n; i++) {
+                t->y[a->indices[k + i]] += v[i] * xc;
+            }
+        }
+    }
+}
+
+static void sparse_spmv_bsr(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const SparseTask* t = (const SparseTask*) context;
+    const SparseMatrix* a = t->a;
+    size_t height = a->block_rows;
+    size_t width = a->block_cols;
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+
+    // A kernel call per row of a narrow block costs more than the row, so such blocks are
+    // widened whole and reduced inline.
+    bool narrow = width < SPARSE_NARROW && height * width <= SPARSE_TILE;
+
+    size_t first;
+    size_t last;
+    sparse_lines(t, begin, end, &first, &last);
+    memset(t->y + first * height, 0, (last - first) * height * sizeof(float));
+    for (size_t line = first; line < last; line++) {
+        float* y = t->y + line * height;
+        for (size_t k = a->offsets[line]; k < a->offsets[line + 1]; k++) {
+            size_t col = a->indices[k] * width;
+            if (narrow) {
+                const float* v = sparse_widen(a, k * height * width, height * width, tile);
+                for (size_t i = 0; i < height; i++) {
+                    float sum = 0.0f;
+                    for (size_t j = 0; j < width; j++) {
+                        sum += v[i * width + j] * t->x[col + j];
+                    }
+                    y[i] += sum;
+                }
+                continue;
+            }
+            const BlockQ8* xq = t->xq ? t->xq + col / BLOCK_SIZE : NULL;
+            for (size_t i = 0; i < height; i++) {
+                y[i] += sparse_block_dot(a, (k * height + i) * width, t->x + col, xq, width);
+            }
+        }
+    }
+}
+
+static void sparse_spmm_csr(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const SparseTask* t = (const SparseTask*) context;
+    const SparseMatrix* a = t->a;
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+
+    size_t first;
+    size_t last;
+    sparse_lines(t, begin, end, &first, &last);
+    for (size_t r = first; r < last; r++) {
+        float* c = t->c + r * t->ldc;
+        memset(c, 0, t->n * sizeof(float));
+        for (size_t k = a->offsets[r]; k < a->offsets[r + 1]; k += SPARSE_TILE) {
+            size_t n = MIN(SPARSE_TILE, a->offsets[r + 1] - k);
+            const float* v = sparse_widen(a, k, n, tile);
+            for (size_t i = 0; i < n; i++) {
+                t->kernels->axpy(c, t->b + a->indices[k + i] * t->ldb, v[i], t->n);
+            }
+        }
+    }
+}
+
+static void sparse_spmm_csc(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const SparseTask* t = (const SparseTask*) context;
+    const SparseMatrix* a = t->a;
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+
+    for (size_t r = begin; r < end; r++) {
+        memset(t->c + r * t->ldc, 0, t->n * sizeof(float));
+    }
+    for (size_t col = 0; col < a->cols; col++) {
+        size_t low;
+        size_t high;
+        sparse_column_rows(a, col, begin, end, &low, &high);
+        const float* b = t->b + col * t->ldb;
+        for (size_t k = low; k < high; k += SPARSE_TILE) {
+            size_t n = MIN(SPARSE_TILE, high - k);
+            const float* v = sparse_widen(a, k, n, tile);
+            for (size_t i = 0; i < n; i++) {
+                t->kernels->axpy(t->c + a->indices[k + i] * t->ldc, b, v[i], t->n);
+            }
+        }
+    }
+}
+
+static void sparse_spmm_bsr(void* context, size_t begin, size_t end, size_t thread) {
+    (void) thread;
+    const SparseTask* t = (const SparseTask*) context;
+    const SparseMatrix* a = t->a;
+    size_t height = a->block_rows;
+    size_t width = a->block_cols;
+    alignas(SPARSE_ALIGNMENT) float tile[SPARSE_TILE];
+
+    size_t first;
+    size_t last;
+    sparse_lines(t, begin, end, &first, &last);
+    for (size_t r = first * height; r < last * height; r++) {
+        memset(t->c + r * t->ldc, 0, t->n * sizeof(float));
+    }
+    for (size_t line = first; line < last; line++) {
+        for (size_t k = a->offsets[line]; k < a->offsets[line + 1]; k++) {
+            const float* b = t->b + a->indices[k] * width * t->ldb;
+            for (size_t i = 0; i < height; i++) {
+                float* c = t->c + (line * height + i) * t->ldc;
+                for (size_t j = 0; j < width; j += SPARSE_TILE) {
+                    size_t n = MIN(SPARSE_TILE, width - j);
+                    const float* v = sparse_widen(a, (k * height + i) * width + j, n, tile);
+                    for (size_t jj = 0; jj < n; jj++) {
+                        t->kernels->axpy(c, b + (j + jj) * t->ldb, v[jj], t->n);
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool sparse_spmv(ThreadPool* pool, const SparseMatrix* a, const float* x, float* y) {
+    assert(a != NULL);
+    assert(x != NULL || 0 == a->cols);
+    assert(y != NULL || 0 == a->rows);
+
+    if (0 == a->rows) {
+        return true;
+    }
+
+    SparseTask t = {
+        .kernels = &SPARSE_KERNELS[cpu_level()],
+        .a = a,
+        .chunks = SPARSE_CHUNKS * thread_pool_size(pool),
+        .x = x,
+        .y = y,
+    };
+
+    BlockQ8* xq = NULL;
+    if (sparse_type_is_block(a->type)) {
+        xq = memory_alloc(data_type_row_size(TYPE_BLOCK_Q8, a->cols), alignof(BlockQ8));
+        if (!xq) {
+            return false;
+        }
+        quantize_row_block_q8(x, xq, a->cols);
+        t.xq = xq;
+    }
+
+    switch (a->format) {
+        case SPARSE_CSR:
+            thread_pool_parallel_for(pool, t.chunks, 1, sparse_spmv_csr, &t);
+            break;
+        case SPARSE_CSC:
+            thread_pool_parallel_for(pool, a->rows, SPARSE_GRAIN, sparse_spmv_csc, &t);
+            break;
+        case SPARSE_BSR:
+            thread_pool_parallel_for(pool, t.chunks, 1, sparse_spmv_bsr, &t);
+            break;
+    }
+
+    memory_free(xq);
+    return true;
+}
+
+void sparse_spmm(
+    ThreadPool* pool,
+    const SparseMatrix* a,
+    const float* b,
+    size_t ldb,
+    float* c,
+    size_t ldc,
+    size_t n
+) {
+    assert(a != NULL);
+    assert(b != NULL || 0 == a->cols * n);
+    assert(c != NULL || 0 == a->rows * n);
+
+    if (0 == a->rows || 0 == n) {
+        return;
+    }
+
+    SparseTask t = {
+        .kernels = &SPARSE_KERNELS[cpu_level()],
+        .a = a,
+        .chunks = SPARSE_CHUNKS * thread_pool_size(pool),
+        .b = b,
+        .ldb = ldb,
+        .c = c,
+        .ldc = ldc,
+        .n = n,
+    };
+
+    switch (a->format) {
+        case SPARSE_CSR:
+            thread_pool_parallel_for(pool, t.chunks, 1, sparse_spmm_csr, &t);
+            break;
+        case SPARSE_CSC:
+            thread_pool_parallel_for(pool, a->rows, SPARSE_GRAIN, sparse_spmm_csc, &t);
+            break;
+        case SPARSE_BSR:
+            thread_pool_parallel_for(pool, t.chunks, 1, sparse_spmm_bsr, &t);
+            break;
+    }
+}
@@ -0,0 +1,816 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/numeric/tensor.c
+ *
+ * @brief N-dimensional tensors over DataType with zero-copy views.
+ */
+
+#include "core/memory.h"
+#include "numeric/convert.h"
+#include "numeric/matrix.h"
+#include "numeric/tensor.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Private Definitions
+ */
+
+#define TENSOR_TILE 1024 // elements gathered from a strided row at a time
+#define TENSOR_ROW_WORK 4096 // elements per scheduling unit when rows are spread over a pool
+#define TENSOR_SCALAR_MAX 4 // bytes per element of the largest non-packed type
+
+// Bytes from the first element to element `offset`, which for packed types is a unit boundary.
+static inline size_t tensor_bytes(DataTypeId type, size_t offset) {
+    return offset / data_type_block(type) * data_type_size(type);
+}
+
+static inline bool tensor_is_packed(DataTypeId type) {
+    return data_type_block(type) > 1;
+}
+
+// Row-major strides, with the last axis padded to whole storage units.
+static void tensor_strides(DataTypeId type, size_t rank, const size_t* shape, size_t* stride) {
+    if (0 == rank) {
+        return;
+    }
+
+    size_t block = data_type_block(type);
+    stride[rank - 1] = 1;
+    size_t span = (shape[rank - 1] + block - 1) / block * block;
+    for (size_t i = rank - 1; i-- > 0;) {
+        stride[i] = span;
+        span *= shape[i];
+    }
+}
+
+// Elements of storage behind a contiguous tensor, or SIZE_MAX on overflow.
+static size_t tensor_span(DataTypeId type, size_t rank, const size_t* shape) {
+    size_t block = data_type_block(type);
+    size_t span = 1;
+    for (size_t i = 0; i < rank; i++) {
+        size_t n = i + 1 == rank ? (shape[i] + block - 1) / block * block : shape[i];
+        if (n && span > SIZE_MAX / n) {
+            return SIZE_MAX;
+        }
+        span *= n;
+    }
+    return span;
+}
+
+// A view of `tensor` that does not own anything.
+static Tensor tensor_borrow(const Tensor* tensor) {
+    Tensor view = *tensor;
+    view.storage = NULL;
+    memset(&view.allocator, 0, sizeof(view.allocator));
+    return view;
+}
+
+static bool tensor_same_shape(const Tensor* a, const Tensor* b) {
+    if (a->rank != b->rank) {
+        return false;
+    }
+    for (size_t i = 0; i < a->rank; i++) {
+        if (a->shape[i] != b->shape[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Allocators
+ */
+
+static void* tensor_default_alloc(void* context, size_t size, size_t alignment) {
+    (void) context;
+    return memory_alloc(size, alignment);
+}
+
+static void tensor_default_free(void* context, void* pointer) {
+    (void) context;
+    memory_free(pointer);
+}
+
+static void* tensor_arena_alloc(void* context, size_t size, size_t alignment) {
+    return arena_alloc((Arena*) context, size, alignment);
+}
+
+TensorAllocator tensor_allocator_default(void) {
+    return (TensorAllocator) {tensor_default_alloc, tensor_default_free, NULL};
+}
+
+TensorAllocator tensor_allocator_arena(Arena* arena) {
+    assert(arena != NULL);
+    return (TensorAllocator) {tensor_arena_alloc, NULL, arena};
+}
+
+/**
+ * Lifetime
+ */
+
+bool tensor_create(
+    Tensor* tensor,
+    DataTypeId type,
+    size_t rank,
+    const size_t* shape,
+    const TensorAllocator* allocator
+) {
+    assert(tensor != NULL);
+    assert(shape != NULL || 0 == rank);
+
+    if (type >= TYPE_COUNT || rank > TENSOR_RANK_MAX) {
+        return false;
+    }
+
+    size_t span = tensor_span(type, rank, shape);
+    size_t block = data_type_block(type);
+    if (SIZE_MAX == span || span / block > SIZE_MAX / data_type_size(type)) {
+        return false;
+    }
+
+    Tensor t = tensor_wrap(NULL, type, rank, shape);
+    t.allocator = allocator ? *allocator : tensor_allocator_default();
+
+    size_t bytes = tensor_bytes(type, span);
+    if (bytes) {
+        t.storage = t.allocator.alloc(t.allocator.context, bytes, TENSOR_ALIGNMENT);
+        if (NULL == t.storage) {
+            return false;
+        }
+        memset(t.storage, 0, bytes);
+        t.data = t.storage;
+    }
+
+    *tensor = t;
+    return true;
+}
+
+Tensor tensor_wrap(void* data, DataTypeId type, size_t rank, const size_t* shape) {
+    assert(type < TYPE_COUNT);
+    assert(rank <= TENSOR_RANK_MAX);
+    assert(shape != NULL || 0 == rank);
+
+    Tensor t = {.data = data, .type = type, .rank = rank};
+    for (size_t i = 0; i < rank; i++) {
+        t.shape[i] = shape[i];
+    }
+    tensor_strides(type, rank, shape, t.stride);
+    return t;
+}
+
+void tensor_free(Tensor* tensor) {
+    if (NULL == tensor) {
+        return;
+    }
+
+    if (tensor->storage && tensor->allocator.free) {
+        tensor->allocator.free(tensor->allocator.context, tensor->storage);
+    }
+    tensor->storage = NULL;
+    tensor->data = NULL;
+}
+
+/**
+ * Queries
+ */
+
+size_t tensor_count(const Tensor* tensor) {
+    assert(tensor != NULL);
+
+    size_t count = 1;
+    for (size_t i = 0; i < tensor->rank; i++) {
+        count *= tensor->shape[i];
+    }
+    return count;
+}
+
+bool tensor_is_contiguous(const Tensor* tensor) {
+    assert(tensor != NULL);
+
+    size_t stride[TENSOR_RANK_MAX];
+    tensor_strides(tensor->type, tensor->rank, tensor->shape, stride);
+    for (size_t i = 0; i < tensor->rank; i++) {
+        if (tensor->shape[i] > 1 && tensor->stride[i] != stride[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void* tensor_at(const Tensor* tensor, const size_t* index) {
+    assert(tensor != NULL);
+    assert(index != NULL || 0 == tensor->rank);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < tensor->rank; i++) {
+        assert(index[i] < tensor->shape[i]);
+        offset += index[i] * tensor->stride[i];
+    }
+    return (uint8_t*) tensor->data + tensor_bytes(tensor->type, offset);
+}
+
+/**
+ * Views
+ */
+
+bool tensor_slice(
+    const Tensor* tensor, size_t axis, size_t begin, size_t end, size_t step, Tensor* view
+) {
+    assert(tensor != NULL);
+    assert(view != NULL);
+
+    if (axis >= tensor->rank || begin > end || end > tensor->shape[axis] || 0 == step) {
+        return false;
+    }
+    if (tensor_is_packed(tensor->type) && axis + 1 == tensor->rank
+        && (step != 1 || begin % data_type_block(tensor->type))) {
+        return false;
+    }
+
+    Tensor v = tensor_borrow(tensor);
+    if (begin < end) {
+        v.data = (uint8_t*) v.data + tensor_bytes(v.type, begin * v.stride[axis]);
+    }
+    v.shape[axis] = (end - begin + step - 1) / step;
+    v.stride[axis] *= step;
+
+    *view = v;
+    return true;
+}
+
+bool tensor_transpose(const Tensor* tensor, size_t axis0, size_t axis1, Tensor* view) {
+    assert(tensor != NULL);
+
+    if (axis0 >= tensor->rank || axis1 >= tensor->rank) {
+        return false;
+    }
+
+    size_t axes[TENSOR_RANK_MAX];
+    for (size_t i = 0; i < tensor->rank; i++) {
+        axes[i] = i;
+    }
+    axes[axis0] = axis1;
+    axes[axis1] = axis0;
+    return tensor_permute(tensor, axes, view);
+}
+
+bool tensor_permute(const Tensor* tensor, const size_t* axes, Tensor* view) {
+    assert(tensor != NULL);
+    assert(axes != NULL || 0 == tensor->rank);
+    assert(view != NULL);
+
+    bool seen[TENSOR_RANK_MAX] = {false};
+    for (size_t i = 0; i < tensor->rank; i++) {
+        if (axes[i] >= tensor->rank || seen[axes[i]]) {
+            return false;
+        }
+        seen[axes[i]] = true;
+    }
+    size_t last = tensor->rank - 1;
+    if (tensor_is_packed(tensor->type) && tensor->rank && axes[last] != last) {
+        return false;
+    }
+
+    Tensor v = tensor_borrow(tensor);
+    for (size_t i = 0; i < tensor->rank; i++) {
+        v.shape[i] = tensor->shape[axes[i]];
+        v.stride[i] = tensor->stride[axes[i]];
+    }
+
+    *view = v;
+    return true;
+}
+
+/**
+ * Matches groups of old and new axes with equal products. Each group of old axes must be
+ * contiguous within itself; the new axes of the group then take strides from its innermost
+ * old axis. Axes of length 1 take part in no group.
+ */
+bool tensor_reshape(const Tensor* tensor, size_t rank, const size_t* shape, Tensor* view) {
+    assert(tensor != NULL);
+    assert(shape != NULL || 0 == rank);
+    assert(view != NULL);
+
+    if (rank > TENSOR_RANK_MAX) {
+        return false;
+    }
+
+    size_t count = 1;
+    for (size_t i = 0; i < rank; i++) {
+        count *= shape[i];
+    }
+    if (count != tensor_count(tensor)) {
+        return false;
+    }
+
+    Tensor v = tensor_borrow(tensor);
+    v.rank = rank;
+    for (size_t i = 0; i < rank; i++) {
+        v.shape[i] = shape[i];
+    }
+
+    if (0 == count) {
+        tensor_strides(v.type, rank, shape, v.stride);
+        *view = v;
+        return true;
+    }
+
+    size_t old_shape[TENSOR_RANK_MAX];
+    size_t old_stride[TENSOR_RANK_MAX];
+    size_t old_rank = 0;
+    for (size_t i = 0; i < tensor->rank; i++) {
+        if (tensor->shape[i] != 1) {
+            old_shape[old_rank] = tensor->shape[i];
+            old_stride[old_rank] = tensor->stride[i];
+            old_rank++;
+        }
+    }
+
+    size_t ni = 0;
+    size_t oi = 0;
+    while (ni < rank && oi < old_rank) {
+        size_t np = shape[ni];
+        size_t op = old_shape[oi];
+        size_t nj = ni + 1;
+        size_t oj = oi + 1;
+        while (np != op) {
+            if (np < op) {
+                np *= shape[nj++];
+            } else {
+                op *= old_shape[oj++];
+            }
+        }
+
+        for (size_t ok = oi; ok + 1 < oj; ok++) {
+            if (old_stride[ok] != old_shape[ok + 1] * old_stride[ok + 1]) {
+                return false;
+            }
+        }
+
+        v.stride[nj - 1] = old_stride[oj - 1];
+        for (size_t nk = nj - 1; nk > ni; nk--) {
+            v.stride[nk - 1] = v.stride[nk] * shape[nk];
+        }
+        ni = nj;
+        oi = oj;
+    }
+    for (; ni < rank; ni++) {
+        v.stride[ni] = 1;
+    }
+
+    // Packed rows: the last axis stays unit-stride and every other axis moves whole units.
+    if (tensor_is_packed(v.type)) {
+        size_t block = data_type_block(v.type);
+        if (0 == rank || (v.shape[rank - 1] > 1 && v.stride[rank - 1] != 1)) {
+            return false;
+        }
+        v.stride[rank - 1] = 1;
+        for (size_t i = 0; i + 1 < rank; i++) {
+            if (v.shape[i] > 1 && v.stride[i] % block) {
+                return false;
+            }
+        }
+    }
+
+    *view = v;
+    return true;
+}
+
+bool tensor_broadcast(const Tensor* tensor, size_t rank, const size_t* shape, Tensor* view) {
+    assert(tensor != NULL);
+    assert(shape != NULL || 0 == rank);
+    assert(view != NULL);
+
+    if (rank > TENSOR_RANK_MAX || rank < tensor->rank) {
+        return false;
+    }
+    if (tensor_is_packed(tensor->type)
+        && (0 == tensor->rank || tensor->shape[tensor->rank - 1] != shape[rank - 1])) {
+        return false;
+    }
+
+    Tensor v = tensor_borrow(tensor);
+    v.rank = rank;
+    size_t lead = rank - tensor->rank;
+    for (size_t i = 0; i < rank; i++) {
+        v.shape[i] = shape[i];
+        if (i < lead) {
+            v.stride[i] = 0;
+            continue;
+        }
+
+        size_t j = i - lead;
+        if (tensor->shape[j] == shape[i]) {
+            v.stride[i] = tensor->stride[j];
+        } else if (1 == tensor->shape[j]) {
+            v.stride[i] = 0;
+        } else {
+            return false;
+        }
+    }
+
+    *view = v;
+    return true;
+}
+
+/**
+ * Rows
+ *
+ * Kernels walk a pair of tensors of the same shape one last-axis row at a time. A row's
+ * address comes from its index over the outer axes, so any strides work.
+ */
+
+typedef struct TensorRow {
+    const uint8_t* input;
+    size_t input_stride; // elements along the row
+    uint8_t* output;
+    size_t output_stride;
+    size_t length;
+    size_t thread; // range index of the pool loop, in [0, thread_pool_size())
+} TensorRow;
+
+typedef void (*TensorRowKernel)(void* context, const TensorRow* row);
+
+typedef struct TensorRowTask {
+    const Tensor* input;
+    const Tensor* output;
+    TensorRowKernel kernel;
+    void* context;
+} TensorRowTask;
+
+static size_t tensor_row_offset(const Tensor* tensor, size_t row) {
+    size_t offset = 0;
+    for (size_t i = tensor->rank - 1; i-- > 0;) {
+        offset += row % tensor->shape[i] * tensor->stride[i];
+        row /= tensor->shape[i];
+    }
+    return offset;
+}
+
+static void tensor_rows_task(void* context, size_t begin, size_t end, size_t thread) {
+    const TensorRowTask* task = context;
+    const Tensor* input = task->input;
+    const Tensor* output = task->output;
+    size_t last = input->rank - 1;
+
+    for (size_t r = begin; r < end; r++) {
+        TensorRow row = {
+            .input = (const uint8_t*) input->data
+                     + tensor_bytes(input->type, tensor_row_offset(input, r)),
+            .input_stride = input->stride[last],
+            .output = (uint8_t*) output->data
+                      + tensor_bytes(output->type, tensor_row_offset(output, r)),
+            .output_stride = output->stride[last],
+            .length = input->shape[last],
+            .thread = thread,
+        };
+        task->kernel(task->context, &row);
+    }
+}
+
+// Runs `kernel` over every row of a non-empty pair; rank 0 counts as one row of one element.
+static void tensor_rows_run(
+    ThreadPool* pool,
+    const Tensor* input,
+    const Tensor* output,
+    TensorRowKernel kernel,
+    void* context
+) {
+    if (0 == input->rank) {
+        TensorRow row = {input->data, 1, output->data, 1, 1, 0};
+        kernel(context, &row);
+        return;
+    }
+
+    size_t length = input->shape[input->rank - 1];
+    size_t rows = tensor_count(input) / length;
+    size_t grain = length < TENSOR_ROW_WORK ? TENSOR_ROW_WORK / length : 1;
+
+    TensorRowTask task = {input, output, kernel, context};
+    if (rows <= grain) {
+        tensor_rows_task(&task, 0, rows, 0);
+    } else {
+        thread_pool_parallel_for(pool, rows, grain, tensor_rows_task, &task);
+    }
+}
+
+static void tensor_gather(
+    const uint8_t* input, size_t stride, size_t size, uint8_t* tile, size_t count
+) {
+    for (size_t i = 0; i < count; i++) {
+        memcpy(tile + i * size, input + i * stride * size, size);
+    }
+}
+
+static void tensor_scatter(
+    const uint8_t* tile, uint8_t* output, size_t stride, size_t size, size_t count
+) {
+    for (size_t i = 0; i < count; i++) {
+        memcpy(output + i * stride * size, tile + i * size, size);
+    }
+}
+
+// Row strides (in elements) when the outer axes collapse into a single strided axis.
+static bool tensor_outer_stride(const Tensor* tensor, size_t* stride) {
+    bool found = false;
+    size_t span = 0;
+    *stride = 0;
+    for (size_t i = tensor->rank - 1; i-- > 0;) {
+        if (1 == tensor->shape[i]) {
+            continue;
+        }
+        if (found && tensor->stride[i] != span) {
+            return false;
+        }
+        if (!found) {
+            *stride = tensor->stride[i];
+            found = true;
+        }
+        span = tensor->stride[i] * tensor->shape[i];
+    }
+    return true;
+}
+
+/**
+ * Kernels
+ */
+
+typedef struct TensorConvert {
+    DataTypeId input_type;
+    DataTypeId output_type;
+} TensorConvert;
+
+// Unit-stride sides are converted in place; strided sides go through a tile.
+static void tensor_convert_row(void* context, const TensorRow* row) {
+    const TensorConvert* c = context;
+    size_t input_size = data_type_size(c->input_type);
+    size_t output_size = data_type_size(c->output_type);
+    uint8_t input_tile[TENSOR_TILE * TENSOR_SCALAR_MAX];
+    uint8_t output_tile[TENSOR_TILE * TENSOR_SCALAR_MAX];
+
+    for (size_t i = 0; i < row->length; i += TENSOR_TILE) {
+        size_t n = row->length - i < TENSOR_TILE ? row->length - i : TENSOR_TILE;
+
+        const void* input = row->input + tensor_bytes(c->input_type, i);
+        if (row->input_stride != 1) {
+            const uint8_t* first = row->input + i * row->input_stride * input_size;
+            tensor_gather(first, row->input_stride, input_size, input_tile, n);
+            input = input_tile;
+        }
+
+        void* output = row->output + tensor_bytes(c->output_type, i);
+        if (row->output_stride != 1) {
+            output = output_tile;
+        }
+
+        convert_row(input, c->input_type, output, c->output_type, n);
+
+        if (row->output_stride != 1) {
+            uint8_t* first = row->output + i * row->output_stride * output_size;
+            tensor_scatter(output_tile, first, row->output_stride, output_size, n);
+        }
+    }
+}
+
+bool tensor_convert(ThreadPool* pool, const Tensor* input, Tensor* output) {
+    assert(input != NULL);
+    assert(output != NULL);
+
+    if (!tensor_same_shape(input, output)) {
+        return false;
+    }
+    if (0 == tensor_count(input)) {
+        return true;
+    }
+
+    // Both sides unit-stride with collapsible outer axes: one strided convert_rows() call.
+    size_t last = input->rank - 1;
+    size_t input_stride = 0;
+    size_t output_stride = 0;
+    if (input->rank && 1 == input->stride[last] && 1 == output->stride[last]
+        && tensor_outer_stride(input, &input_stride)
+        && tensor_outer_stride(output, &output_stride)) {
+        size_t length = input->shape[last];
+        return convert_rows(
+            pool,
+            input->data,
+            input->type,
+            tensor_bytes(input->type, input_stride),
+            output->data,
+            output->type,
+            tensor_bytes(output->type, output_stride),
+            tensor_count(input) / length,
+            length
+        );
+    }
+
+    TensorConvert context = {input->type, output->type};
+    tensor_rows_run(pool, input, output, tensor_convert_row, &context);
+    return true;
+}
+
+typedef struct TensorActivate {
+    ActivationFunction function;
+    DataTypeId type;
+} TensorActivate;
+
+static void
+tensor_activate_span(const TensorActivate* a, const void* input, void* output, size_t n) {
+    if (TYPE_FLOAT16 == a->type) {
+        activate_row_fp16(a->function, input, output, n);
+    } else if (TYPE_BFLOAT16 == a->type) {
+        activate_row_bf16(a->function, input, output, n);
+    } else {
+        activate_row(a->function, input, output, n);
+    }
+}
+
+static void tensor_activate_row(void* context, const TensorRow* row) {
+    const TensorActivate* a = context;
+    size_t size = data_type_size(a->type);
+
+    if (1 == row->input_stride && 1 == row->output_stride) {
+        tensor_activate_span(a, row->input, row->output, row->length);
+        return;
+    }
+
+    uint8_t tile[TENSOR_TILE * sizeof(float)];
+    for (size_t i = 0; i < row->length; i += TENSOR_TILE) {
+        size_t n = row->length - i < TENSOR_TILE ? row->length - i : TENSOR_TILE;
+        const uint8_t* input = row->input + i * row->input_stride * size;
+        uint8_t* output = row->output + i * row->output_stride * size;
+        tensor_gather(input, row->input_stride, size, tile, n);
+        tensor_activate_span(a, tile, tile, n);
+        tensor_scatter(tile, output, row->output_stride, size, n);
+    }
+}
+
+bool tensor_activate(ActivationFunction function, const Tensor* input, Tensor* output) {
+    assert(input != NULL);
+    assert(output != NULL);
+
+    if (function >= ACTIVATION_COUNT || input->type != output->type
+        || (TYPE_FLOAT32 != input->type && TYPE_FLOAT16 != input->type
+            && TYPE_BFLOAT16 != input->type)
+        || !tensor_same_shape(input, output)) {
+        return false;
+    }
+    if (0 == tensor_count(input)) {
+        return true;
+    }
+
+    TensorActivate context = {function, input->type};
+    tensor_rows_run(NULL, input, output, tensor_activate_row, &context);
+    return true;
+}
+
+typedef struct TensorSoftmax {
+    ThreadPool* pool; // used inside the row when there is only one
+    float temperature;
+    float* buffer; // one gathered row per thread when the last axis is strided
+} TensorSoftmax;
+
+static void tensor_softmax_row(void* context, const TensorRow* row) {
+    const TensorSoftmax* s = context;
+
+    if (1 == row->input_stride && 1 == row->output_stride) {
+        activate_softmax_parallel(
+            s->pool, (const float*) row->input, (float*) row->output, row->length, s->temperature
+        );
+        return;
+    }
+
+    // The whole row is needed at once, so it is gathered into this thread's buffer.
+    float* buffer = s->buffer + row->thread * row->length;
+    tensor_gather(row->input, row->input_stride, sizeof(float), (uint8_t*) buffer, row->length);
+    activate_softmax_parallel(s->pool, buffer, buffer, row->length, s->temperature);
+    tensor_scatter(
+        (const uint8_t*) buffer, row->output, row->output_stride, sizeof(float), row->length
+    );
+}
+
+bool tensor_softmax(ThreadPool* pool, const Tensor* input, Tensor* output, float temperature) {
+    assert(input != NULL);
+    assert(output != NULL);
+
+    if (TYPE_FLOAT32 != input->type || TYPE_FLOAT32 != output->type || 0 == input->rank
+        || !tensor_same_shape(input, output) || !(temperature > 0.0f)) {
+        return false;
+    }
+    if (0 == tensor_count(input)) {
+        return true;
+    }
+
+    size_t last = input->rank - 1;
+    size_t rows = tensor_count(input) / input->shape[last];
+    ThreadPool* row_pool = rows > 1 ? pool : NULL;
+    TensorSoftmax context = {rows > 1 ? NULL : pool, temperature, NULL};
+
+    // Allocated before any row runs, so a failure leaves `output` untouched.
+    if (1 != input->stride[last] || 1 != output->stride[last]) {
+        size_t bytes = thread_pool_size(row_pool) * input->shape[last] * sizeof(float);
+        context.buffer = memory_alloc(bytes, TENSOR_ALIGNMENT);
+        if (NULL == context.buffer) {
+            return false;
+        }
+    }
+
+    tensor_rows_run(row_pool, input, output, tensor_softmax_row, &context);
+    memory_free(context.buffer);
+    return true;
+}
+
+// A matrix operand as matrix_gemm_fp32() takes it, packing strided rows into `copy`.
+static bool tensor_matrix(const Tensor* tensor, Tensor* copy, const float** data, size_t* ld) {
+    if (tensor->shape[1] <= 1 || 1 == tensor->stride[1]) {
+        *data = tensor->data;
+        *ld = tensor->shape[0] > 1 ? tensor->stride[0] : tensor->shape[1];
+        return true;
+    }
+
+    if (!tensor_create(copy, TYPE_FLOAT32, 2, tensor->shape, NULL)) {
+        return false;
+    }
+    tensor_convert(NULL, tensor, copy);
+    *data = copy->data;
+    *ld = tensor->shape[1];
+    return true;
+}
+
+bool tensor_gemm(ThreadPool* pool, const Tensor* a, const Tensor* b, Tensor* c) {
+    assert(a != NULL);
+    assert(b != NULL);
+    assert(c != NULL);
+
+    if (2 != a->rank || 2 != b->rank || 2 != c->rank || TYPE_FLOAT32 != a->type
+        || TYPE_FLOAT32 != b->type || TYPE_FLOAT32 != c->type) {
+        return false;
+    }
+
+    size_t m = a->shape[0];
+    size_t k = a->shape[1];
+    size_t n = b->shape[1];
+    if (b->shape[0] != k || c->shape[0] != m || c->shape[1] != n) {
+        return false;
+    }
+
+    // C is written through its rows, which must neither interleave nor repeat.
+    size_t ldc = m > 1 ? c->stride[0] : n;
+    if ((n > 1 && 1 != c->stride[1]) || ldc < n) {
+        return false;
+    }
+
+    Tensor a_copy = {0};
+    Tensor b_copy = {0};
+    const float* a_data = NULL;
+    const float* b_data = NULL;
+    size_t lda = 0;
+    size_t ldb = 0;
+    bool ok = tensor_matrix(a, &a_copy, &a_data, &lda) && tensor_matrix(b, &b_copy, &b_data, &ldb)
+              && matrix_gemm_fp32(pool, m, n, k, a_data, lda, b_data, ldb, c->data, ldc);
+
+    tensor_free(&a_copy);
+    tensor_free(&b_copy);
+    return ok;
+}
+
+bool tensor_gemv(ThreadPool* pool, const Tensor* w, const Tensor* x, Tensor* y) {
+    assert(w != NULL);
+    assert(x != NULL);
+    assert(y != NULL);
+
+    if (2 != w->rank || 1 != x->rank || 1 != y->rank || TYPE_FLOAT32 != x->type
+        || TYPE_FLOAT32 != y->type) {
+        return false;
+    }
+
+    size_t rows = w->shape[0];
+    size_t cols = w->shape[1];
+    if (x->shape[0] != cols || y->shape[0] != rows) {
+        return false;
+    }
+
+    size_t stride[2];
+    tensor_strides(w->type, 2, w->shape, stride);
+    if ((rows > 1 && w->stride[0] != stride[0]) || (cols > 1 && w->stride[1] != 1)
+        || (rows > 1 && 1 != y->stride[0])) {
+        return false;
+    }
+
+    Tensor x_copy = {0};
+    const float* x_data = x->data;
+    if (cols > 1 && 1 != x->stride[0]) {
+        if (!tensor_create(&x_copy, TYPE_FLOAT32, 1, x->shape, NULL)) {
+            return false;
+        }
+        tensor_convert(NULL, x, &x_copy);
+        x_data = x_copy.data;
+    }
+
+    bool ok = matrix_gemv(pool, w->type, w->data, rows, cols, x_data, y->data);
+    tensor_free(&x_copy);
+    return ok;
+}
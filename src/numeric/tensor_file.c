@@ -0,0 +1,343 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/numeric/tensor_file.c
+ *
+ * @brief Memory-mapped tensor container for zero-copy loading.
+ *
+ * The format is little-endian and the header and entries are read in place, so this assumes a
+ * little-endian host; on anything else the magic does not match and opening fails cleanly.
+ */
+
+#include "core/logger.h"
+#include "numeric/tensor_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Private Definitions
+ */
+
+// Bytes of a contiguous tensor, or false on overflow.
+static bool tensor_file_bytes(DataTypeId type, size_t rank, const size_t* shape, size_t* bytes) {
+    size_t unit = data_type_size(type);
+    if (rank && shape[rank - 1] > SIZE_MAX / unit - data_type_block(type)) {
+        return false;
+    }
+
+    size_t size = rank ? data_type_row_size(type, shape[rank - 1]) : unit;
+    for (size_t i = 0; i + 1 < rank; i++) {
+        if (shape[i] && size > SIZE_MAX / shape[i]) {
+            return false;
+        }
+        size *= shape[i];
+    }
+    *bytes = size;
+    return true;
+}
+
+static inline size_t tensor_file_align(size_t offset) {
+    return (offset + TENSOR_ALIGNMENT - 1) / TENSOR_ALIGNMENT * TENSOR_ALIGNMENT;
+}
+
+static bool tensor_file_write_all(int fd, const void* buffer, size_t size) {
+    const uint8_t* bytes = buffer;
+    while (size) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= (size_t) written;
+    }
+    return true;
+}
+
+static bool tensor_file_write_zeros(int fd, size_t size) {
+    static const uint8_t zeros[TENSOR_ALIGNMENT] = {0};
+    return tensor_file_write_all(fd, zeros, size);
+}
+
+/**
+ * Writing
+ */
+
+static TensorFileState tensor_file_write_data(int fd, const Tensor* tensor, size_t size) {
+    if (0 == size || tensor_is_contiguous(tensor)) {
+        return tensor_file_write_all(fd, tensor->data, size) ? TENSOR_FILE_SUCCESS
+                                                              : TENSOR_FILE_ERROR_IO;
+    }
+
+    Tensor packed;
+    if (!tensor_create(&packed, tensor->type, tensor->rank, tensor->shape, NULL)) {
+        return TENSOR_FILE_ERROR_MEMORY;
+    }
+    tensor_convert(NULL, tensor, &packed);
+    bool ok = tensor_file_write_all(fd, packed.data, size);
+    tensor_free(&packed);
+    return ok ? TENSOR_FILE_SUCCESS : TENSOR_FILE_ERROR_IO;
+}
+
+TensorFileState tensor_file_write(const char* path, const TensorFileItem* items, size_t count) {
+    if (NULL == path || (NULL == items && count)
+        || count > (SIZE_MAX - sizeof(TensorFileHeader)) / sizeof(TensorFileEntry)) {
+        LOG_ERROR("[TensorFile] Invalid arguments.");
+        return TENSOR_FILE_ERROR_ARGUMENT;
+    }
+
+    size_t table = sizeof(TensorFileHeader) + count * sizeof(TensorFileEntry);
+    TensorFileEntry* entries = calloc(count ? count : 1, sizeof(TensorFileEntry));
+    if (NULL == entries) {
+        return TENSOR_FILE_ERROR_MEMORY;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Tensor* t = items[i].tensor;
+        size_t size = 0;
+        if (NULL == items[i].name || strlen(items[i].name) >= TENSOR_FILE_NAME_MAX || NULL == t
+            || t->type >= TYPE_COUNT || t->rank > TENSOR_RANK_MAX
+            || !tensor_file_bytes(t->type, t->rank, t->shape, &size)
+            || (NULL == t->data && tensor_count(t))) {
+            LOG_ERROR("[TensorFile] Invalid tensor at index %zu.", i);
+            free(entries);
+            return TENSOR_FILE_ERROR_ARGUMENT;
+        }
+
+        TensorFileEntry* e = &entries[i];
+        strcpy(e->name, items[i].name);
+        e->type = t->type;
+        e->rank = (uint32_t) t->rank;
+        for (size_t j = 0; j < t->rank; j++) {
+            e->shape[j] = t->shape[j];
+        }
+        e->offset = offset;
+        e->size = tensor_count(t) ? size : 0;
+        offset = tensor_file_align(offset + e->size);
+    }
+
+    TensorFileHeader header = {
+        .magic = TENSOR_FILE_MAGIC,
+        .version = TENSOR_FILE_VERSION,
+        .count = count,
+        .data_offset = tensor_file_align(table),
+        .data_size = offset,
+    };
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("[TensorFile] Failed to open '%s': %s", path, strerror(errno));
+        free(entries);
+        return TENSOR_FILE_ERROR_IO;
+    }
+
+    TensorFileState state = TENSOR_FILE_SUCCESS;
+    if (!tensor_file_write_all(fd, &header, sizeof(header))
+        || !tensor_file_write_all(fd, entries, count * sizeof(TensorFileEntry))
+        || !tensor_file_write_zeros(fd, header.data_offset - table)) {
+        state = TENSOR_FILE_ERROR_IO;
+    }
+
+    for (size_t i = 0; TENSOR_FILE_SUCCESS == state && i < count; i++) {
+        size_t end = entries[i].offset + entries[i].size;
+        state = tensor_file_write_data(fd, items[i].tensor, entries[i].size);
+        if (TENSOR_FILE_SUCCESS == state
+            && !tensor_file_write_zeros(fd, tensor_file_align(end) - end)) {
+            state = TENSOR_FILE_ERROR_IO;
+        }
+    }
+
+    if (0 != close(fd) && TENSOR_FILE_SUCCESS == state) {
+        state = TENSOR_FILE_ERROR_IO;
+    }
+    if (TENSOR_FILE_ERROR_IO == state) {
+        LOG_ERROR("[TensorFile] Failed to write '%s': %s", path, strerror(errno));
+    }
+
+    free(entries);
+    return state;
+}
+
+/**
+ * Reading
+ */
+
+// Only the header is checked here; entries wait until they are looked up.
+static bool tensor_file_header_valid(const TensorFile* file) {
+    const TensorFileHeader* h = file->header;
+    if (TENSOR_FILE_MAGIC != h->magic || TENSOR_FILE_VERSION != h->version) {
+        return false;
+    }
+
+    size_t room = file->size - sizeof(TensorFileHeader);
+    if (h->count > room / sizeof(TensorFileEntry)) {
+        return false;
+    }
+
+    size_t table = sizeof(TensorFileHeader) + h->count * sizeof(TensorFileEntry);
+    return 0 == h->data_offset % TENSOR_ALIGNMENT && h->data_offset >= table
+           && h->data_offset <= file->size && h->data_size <= file->size - h->data_offset;
+}
+
+TensorFileState tensor_file_open(TensorFile* file, const char* path, TensorFileAdvice advice) {
+    if (NULL == file || NULL == path) {
+        LOG_ERROR("[TensorFile] Invalid arguments.");
+        return TENSOR_FILE_ERROR_ARGUMENT;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("[TensorFile] Failed to open '%s': %s", path, strerror(errno));
+        return TENSOR_FILE_ERROR_IO;
+    }
+
+    struct stat st;
+    if (0 != fstat(fd, &st)) {
+        LOG_ERROR("[TensorFile] Failed to stat '%s': %s", path, strerror(errno));
+        close(fd);
+        return TENSOR_FILE_ERROR_IO;
+    }
+    if ((size_t) st.st_size < sizeof(TensorFileHeader)) {
+        LOG_ERROR("[TensorFile] '%s' is too short to be a tensor file.", path);
+        close(fd);
+        return TENSOR_FILE_ERROR_FORMAT;
+    }
+
+    // The mapping keeps its own reference to the file.
+    size_t size = (size_t) st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map) {
+        LOG_ERROR("[TensorFile] Failed to map '%s': %s", path, strerror(errno));
+        return TENSOR_FILE_ERROR_IO;
+    }
+
+    TensorFile f = {.map = map, .size = size, .header = map};
+    if (!tensor_file_header_valid(&f)) {
+        LOG_ERROR("[TensorFile] '%s' has an invalid header.", path);
+        munmap(map, size);
+        return TENSOR_FILE_ERROR_FORMAT;
+    }
+    f.entries = (const TensorFileEntry*) (f.map + sizeof(TensorFileHeader));
+    f.data = f.map + f.header->data_offset;
+
+    // Hints only; a kernel that ignores them changes nothing but speed.
+    if (TENSOR_FILE_ADVICE_SEQUENTIAL == advice) {
+        madvise(map, size, MADV_SEQUENTIAL);
+    } else if (TENSOR_FILE_ADVICE_WILLNEED == advice) {
+        madvise(map, size, MADV_WILLNEED);
+    }
+
+    *file = f;
+    return TENSOR_FILE_SUCCESS;
+}
+
+void tensor_file_close(TensorFile* file) {
+    if (NULL == file || NULL == file->map) {
+        return;
+    }
+
+    munmap((void*) file->map, file->size);
+    memset(file, 0, sizeof(*file));
+}
+
+size_t tensor_file_count(const TensorFile* file) {
+    assert(file != NULL);
+    return file->header ? (size_t) file->header->count : 0;
+}
+
+const char* tensor_file_name(const TensorFile* file, size_t index) {
+    assert(file != NULL);
+
+    if (index >= tensor_file_count(file)) {
+        return NULL;
+    }
+
+    const char* name = file->entries[index].name;
+    return memchr(name, '\0', TENSOR_FILE_NAME_MAX) ? name : NULL;
+}
+
+bool tensor_file_get(const TensorFile* file, size_t index, Tensor* tensor) {
+    assert(file != NULL);
+    assert(tensor != NULL);
+
+    if (NULL == tensor_file_name(file, index)) {
+        return false;
+    }
+
+    const TensorFileEntry* e = &file->entries[index];
+    if (e->type >= TYPE_COUNT || e->rank > TENSOR_RANK_MAX) {
+        return false;
+    }
+
+    size_t shape[TENSOR_RANK_MAX];
+    size_t count = 1;
+    for (size_t i = 0; i < e->rank; i++) {
+        shape[i] = (size_t) e->shape[i];
+        count *= shape[i];
+    }
+
+    size_t size = 0;
+    if (!tensor_file_bytes(e->type, e->rank, shape, &size)) {
+        return false;
+    }
+    size = count ? size : 0;
+
+    uint64_t data_size = file->header->data_size;
+    if (e->size != size || e->offset % TENSOR_ALIGNMENT || e->offset > data_size
+        || e->size > data_size - e->offset) {
+        return false;
+    }
+
+    *tensor = tensor_wrap((void*) (file->data + e->offset), e->type, e->rank, shape);
+    return true;
+}
+
+bool tensor_file_find(const TensorFile* file, const char* name, Tensor* tensor) {
+    assert(file != NULL);
+    assert(name != NULL);
+
+    for (size_t i = 0; i < tensor_file_count(file); i++) {
+        const char* entry = tensor_file_name(file, i);
+        if (entry && 0 == strcmp(entry, name)) {
+            return tensor_file_get(file, i, tensor);
+        }
+    }
+    return false;
+}
+
+void tensor_file_prefetch(const TensorFile* file, const Tensor* tensor) {
+    assert(file != NULL);
+    assert(tensor != NULL);
+
+    if (0 == tensor_count(tensor)) {
+        return;
+    }
+
+    // From the first element to the end of the storage unit holding the last.
+    size_t last = 0;
+    for (size_t i = 0; i < tensor->rank; i++) {
+        last += (tensor->shape[i] - 1) * tensor->stride[i];
+    }
+    size_t block = data_type_block(tensor->type);
+    size_t end = (last / block + 1) * data_type_size(tensor->type);
+
+    uintptr_t base = (uintptr_t) file->map;
+    uintptr_t first = (uintptr_t) tensor->data;
+    if (first < base || first - base >= file->size) {
+        return;
+    }
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    uintptr_t start = first / page * page;
+    size_t stop = first - base + end < file->size ? first - base + end : file->size;
+    madvise((void*) start, base + stop - start, MADV_WILLNEED);
+}
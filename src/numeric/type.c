@@ -6,13 +6,23 @@
  * @brief API for numeric data types and conversions.
  *
  * Features:
- * - Single and half-precision floating-point support.
+ * - Single, half and 8-bit (FP8 E4M3/E5M2) floating-point support.
  * - 8-bit and 4-bit quantized integer support.
  * - Minimal dependencies with a consistent, extensible design.
  */
 
+#include "core/cpu.h"
+#include "numeric/convert.h"
 #include "numeric/type.h"
 
+#include <float.h>
+
+#if CPU_X86
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
 // Data type management
 
 const DataType* data_type_get(DataTypeId id) {
@@ -33,6 +43,16 @@ const char* data_type_name(DataTypeId id) {
     return type ? type->name : "Unknown";
 }
 
+uint32_t data_type_block(DataTypeId id) {
+    const DataType* type = data_type_get(id);
+    return type && type->block ? type->block : 1;
+}
+
+size_t data_type_row_size(DataTypeId id, size_t length) {
+    size_t block = data_type_block(id);
+    return (length + block - 1) / block * data_type_size(id);
+}
+
 // Scalar Conversions
 
 // 32-bit encoding and decoding
@@ -80,7 +100,7 @@ float dequantize_scalar_fp16(uint16_t bits) {
     const float exp_scale = 0x1.0p-112f;
     const float normalized_value = decode_scalar_fp32((two_w >> 4) + exp_offset) * exp_scale;
 
-    const uint32_t magic_mask = 0x7E000000;
+    const uint32_t magic_mask = 126u << 23;
     const float magic_bias = 0.5f;
     const float denormalized_value = decode_scalar_fp32((two_w >> 17) | magic_mask) - magic_bias;
 
@@ -117,6 +137,144 @@ float dequantize_scalar_bf16(uint16_t bits) {
     return raw.value;
 }
 
+// 8-bit floating-point (OCP FP8)
+
+/**
+ * Decode tables: the fp32 bits of every code. E5M2 entries are the fp16 decoding of `code << 8`
+ * with NaNs quieted.
+ */
+static const uint32_t TYPE_E4M3_FP32[256] = {
+    0x00000000, 0x3B000000, 0x3B800000, 0x3BC00000, 0x3C000000, 0x3C200000, 0x3C400000, 0x3C600000,
+    0x3C800000, 0x3C900000, 0x3CA00000, 0x3CB00000, 0x3CC00000, 0x3CD00000, 0x3CE00000, 0x3CF00000,
+    0x3D000000, 0x3D100000, 0x3D200000, 0x3D300000, 0x3D400000, 0x3D500000, 0x3D600000, 0x3D700000,
+    0x3D800000, 0x3D900000, 0x3DA00000, 0x3DB00000, 0x3DC00000, 0x3DD00000, 0x3DE00000, 0x3DF00000,
+    0x3E000000, 0x3E100000, 0x3E200000, 0x3E300000, 0x3E400000, 0x3E500000, 0x3E600000, 0x3E700000,
+    0x3E800000, 0x3E900000, 0x3EA00000, 0x3EB00000, 0x3EC00000, 0x3ED00000, 0x3EE00000, 0x3EF00000,
+    0x3F000000, 0x3F100000, 0x3F200000, 0x3F300000, 0x3F400000, 0x3F500000, 0x3F600000, 0x3F700000,
+    0x3F800000, 0x3F900000, 0x3FA00000, 0x3FB00000, 0x3FC00000, 0x3FD00000, 0x3FE00000, 0x3FF00000,
+    0x40000000, 0x40100000, 0x40200000, 0x40300000, 0x40400000, 0x40500000, 0x40600000, 0x40700000,
+    0x40800000, 0x40900000, 0x40A00000, 0x40B00000, 0x40C00000, 0x40D00000, 0x40E00000, 0x40F00000,
+    0x41000000, 0x41100000, 0x41200000, 0x41300000, 0x41400000, 0x41500000, 0x41600000, 0x41700000,
+    0x41800000, 0x41900000, 0x41A00000, 0x41B00000, 0x41C00000, 0x41D00000, 0x41E00000, 0x41F00000,
+    0x42000000, 0x42100000, 0x42200000, 0x42300000, 0x42400000, 0x42500000, 0x42600000, 0x42700000,
+    0x42800000, 0x42900000, 0x42A00000, 0x42B00000, 0x42C00000, 0x42D00000, 0x42E00000, 0x42F00000,
+    0x43000000, 0x43100000, 0x43200000, 0x43300000, 0x43400000, 0x43500000, 0x43600000, 0x43700000,
+    0x43800000, 0x43900000, 0x43A00000, 0x43B00000, 0x43C00000, 0x43D00000, 0x43E00000, 0x7FC00000,
+    0x80000000, 0xBB000000, 0xBB800000, 0xBBC00000, 0xBC000000, 0xBC200000, 0xBC400000, 0xBC600000,
+    0xBC800000, 0xBC900000, 0xBCA00000, 0xBCB00000, 0xBCC00000, 0xBCD00000, 0xBCE00000, 0xBCF00000,
+    0xBD000000, 0xBD100000, 0xBD200000, 0xBD300000, 0xBD400000, 0xBD500000, 0xBD600000, 0xBD700000,
+    0xBD800000, 0xBD900000, 0xBDA00000, 0xBDB00000, 0xBDC00000, 0xBDD00000, 0xBDE00000, 0xBDF00000,
+    0xBE000000, 0xBE100000, 0xBE200000, 0xBE300000, 0xBE400000, 0xBE500000, 0xBE600000, 0xBE700000,
+    0xBE800000, 0xBE900000, 0xBEA00000, 0xBEB00000, 0xBEC00000, 0xBED00000, 0xBEE00000, 0xBEF00000,
+    0xBF000000, 0xBF100000, 0xBF200000, 0xBF300000, 0xBF400000, 0xBF500000, 0xBF600000, 0xBF700000,
+    0xBF800000, 0xBF900000, 0xBFA00000, 0xBFB00000, 0xBFC00000, 0xBFD00000, 0xBFE00000, 0xBFF00000,
+    0xC0000000, 0xC0100000, 0xC0200000, 0xC0300000, 0xC0400000, 0xC0500000, 0xC0600000, 0xC0700000,
+    0xC0800000, 0xC0900000, 0xC0A00000, 0xC0B00000, 0xC0C00000, 0xC0D00000, 0xC0E00000, 0xC0F00000,
+    0xC1000000, 0xC1100000, 0xC1200000, 0xC1300000, 0xC1400000, 0xC1500000, 0xC1600000, 0xC1700000,
+    0xC1800000, 0xC1900000, 0xC1A00000, 0xC1B00000, 0xC1C00000, 0xC1D00000, 0xC1E00000, 0xC1F00000,
+    0xC2000000, 0xC2100000, 0xC2200000, 0xC2300000, 0xC2400000, 0xC2500000, 0xC2600000, 0xC2700000,
+    0xC2800000, 0xC2900000, 0xC2A00000, 0xC2B00000, 0xC2C00000, 0xC2D00000, 0xC2E00000, 0xC2F00000,
+    0xC3000000, 0xC3100000, 0xC3200000, 0xC3300000, 0xC3400000, 0xC3500000, 0xC3600000, 0xC3700000,
+    0xC3800000, 0xC3900000, 0xC3A00000, 0xC3B00000, 0xC3C00000, 0xC3D00000, 0xC3E00000, 0xFFC00000,
+};
+
+static const uint32_t TYPE_E5M2_FP32[256] = {
+    0x00000000, 0x37800000, 0x38000000, 0x38400000, 0x38800000, 0x38A00000, 0x38C00000, 0x38E00000,
+    0x39000000, 0x39200000, 0x39400000, 0x39600000, 0x39800000, 0x39A00000, 0x39C00000, 0x39E00000,
+    0x3A000000, 0x3A200000, 0x3A400000, 0x3A600000, 0x3A800000, 0x3AA00000, 0x3AC00000, 0x3AE00000,
+    0x3B000000, 0x3B200000, 0x3B400000, 0x3B600000, 0x3B800000, 0x3BA00000, 0x3BC00000, 0x3BE00000,
+    0x3C000000, 0x3C200000, 0x3C400000, 0x3C600000, 0x3C800000, 0x3CA00000, 0x3CC00000, 0x3CE00000,
+    0x3D000000, 0x3D200000, 0x3D400000, 0x3D600000, 0x3D800000, 0x3DA00000, 0x3DC00000, 0x3DE00000,
+    0x3E000000, 0x3E200000, 0x3E400000, 0x3E600000, 0x3E800000, 0x3EA00000, 0x3EC00000, 0x3EE00000,
+    0x3F000000, 0x3F200000, 0x3F400000, 0x3F600000, 0x3F800000, 0x3FA00000, 0x3FC00000, 0x3FE00000,
+    0x40000000, 0x40200000, 0x40400000, 0x40600000, 0x40800000, 0x40A00000, 0x40C00000, 0x40E00000,
+    0x41000000, 0x41200000, 0x41400000, 0x41600000, 0x41800000, 0x41A00000, 0x41C00000, 0x41E00000,
+    0x42000000, 0x42200000, 0x42400000, 0x42600000, 0x42800000, 0x42A00000, 0x42C00000, 0x42E00000,
+    0x43000000, 0x43200000, 0x43400000, 0x43600000, 0x43800000, 0x43A00000, 0x43C00000, 0x43E00000,
+    0x44000000, 0x44200000, 0x44400000, 0x44600000, 0x44800000, 0x44A00000, 0x44C00000, 0x44E00000,
+    0x45000000, 0x45200000, 0x45400000, 0x45600000, 0x45800000, 0x45A00000, 0x45C00000, 0x45E00000,
+    0x46000000, 0x46200000, 0x46400000, 0x46600000, 0x46800000, 0x46A00000, 0x46C00000, 0x46E00000,
+    0x47000000, 0x47200000, 0x47400000, 0x47600000, 0x7F800000, 0x7FE00000, 0x7FC00000, 0x7FE00000,
+    0x80000000, 0xB7800000, 0xB8000000, 0xB8400000, 0xB8800000, 0xB8A00000, 0xB8C00000, 0xB8E00000,
+    0xB9000000, 0xB9200000, 0xB9400000, 0xB9600000, 0xB9800000, 0xB9A00000, 0xB9C00000, 0xB9E00000,
+    0xBA000000, 0xBA200000, 0xBA400000, 0xBA600000, 0xBA800000, 0xBAA00000, 0xBAC00000, 0xBAE00000,
+    0xBB000000, 0xBB200000, 0xBB400000, 0xBB600000, 0xBB800000, 0xBBA00000, 0xBBC00000, 0xBBE00000,
+    0xBC000000, 0xBC200000, 0xBC400000, 0xBC600000, 0xBC800000, 0xBCA00000, 0xBCC00000, 0xBCE00000,
+    0xBD000000, 0xBD200000, 0xBD400000, 0xBD600000, 0xBD800000, 0xBDA00000, 0xBDC00000, 0xBDE00000,
+    0xBE000000, 0xBE200000, 0xBE400000, 0xBE600000, 0xBE800000, 0xBEA00000, 0xBEC00000, 0xBEE00000,
+    0xBF000000, 0xBF200000, 0xBF400000, 0xBF600000, 0xBF800000, 0xBFA00000, 0xBFC00000, 0xBFE00000,
+    0xC0000000, 0xC0200000, 0xC0400000, 0xC0600000, 0xC0800000, 0xC0A00000, 0xC0C00000, 0xC0E00000,
+    0xC1000000, 0xC1200000, 0xC1400000, 0xC1600000, 0xC1800000, 0xC1A00000, 0xC1C00000, 0xC1E00000,
+    0xC2000000, 0xC2200000, 0xC2400000, 0xC2600000, 0xC2800000, 0xC2A00000, 0xC2C00000, 0xC2E00000,
+    0xC3000000, 0xC3200000, 0xC3400000, 0xC3600000, 0xC3800000, 0xC3A00000, 0xC3C00000, 0xC3E00000,
+    0xC4000000, 0xC4200000, 0xC4400000, 0xC4600000, 0xC4800000, 0xC4A00000, 0xC4C00000, 0xC4E00000,
+    0xC5000000, 0xC5200000, 0xC5400000, 0xC5600000, 0xC5800000, 0xC5A00000, 0xC5C00000, 0xC5E00000,
+    0xC6000000, 0xC6200000, 0xC6400000, 0xC6600000, 0xC6800000, 0xC6A00000, 0xC6C00000, 0xC6E00000,
+    0xC7000000, 0xC7200000, 0xC7400000, 0xC7600000, 0xFF800000, 0xFFE00000, 0xFFC00000, 0xFFE00000,
+};
+
+// Encoding parameters of one FP8 format.
+typedef struct TypeFp8Format {
+    uint32_t mantissa; /**< Mantissa bits */
+    uint32_t rebias; /**< (127 - bias) << mantissa, fp32 to FP8 exponent */
+    uint32_t normal; /**< fp32 bits of the smallest normal value */
+    uint32_t max; /**< Largest finite code */
+    uint32_t inf; /**< Code for infinity (the largest finite code when there is none) */
+    uint32_t nan; /**< Code for NaN */
+    float magic; /**< 2^23 subnormal steps: adding it rounds to a step */
+    const uint32_t* table; /**< Decode table */
+} TypeFp8Format;
+
+static const TypeFp8Format TYPE_E4M3 = {
+    3, 120 << 3, 121u << 23, 0x7E, 0x7E, 0x7F, 0x1.0p+14f, TYPE_E4M3_FP32
+};
+static const TypeFp8Format TYPE_E5M2 = {
+    2, 112 << 2, 113u << 23, 0x7B, 0x7C, 0x7E, 0x1.0p+7f, TYPE_E5M2_FP32
+};
+
+/**
+ * Normal values round to nearest even on the fp32 bits, as quantize_scalar_bf16 does, then
+ * saturate. Subnormals are rounded by the fp32 adder: after adding `magic` the low bits hold
+ * the number of subnormal steps, and a carry out of them lands on the smallest normal code.
+ */
+static inline uint8_t type_encode_fp8(float value, const TypeFp8Format* format) {
+    const uint32_t w = encode_scalar_fp32(value);
+    const uint32_t sign = (w >> 24) & 0x80;
+    const uint32_t abs = w & 0x7FFFFFFF;
+
+    uint32_t code;
+    if (abs > 0x7F800000) {
+        code = format->nan;
+    } else if (abs == 0x7F800000) {
+        code = format->inf;
+    } else if (abs >= format->normal) {
+        const uint32_t shift = 23 - format->mantissa;
+        code = (abs + ((1u << (shift - 1)) - 1) + ((abs >> shift) & 1)) >> shift;
+        code -= format->rebias;
+        code = code > format->max ? format->max : code;
+    } else {
+        float rounded = decode_scalar_fp32(abs) + format->magic;
+        code = encode_scalar_fp32(rounded) - encode_scalar_fp32(format->magic);
+    }
+    return (uint8_t) (sign | code);
+}
+
+uint8_t quantize_scalar_e4m3(float value) {
+    return type_encode_fp8(value, &TYPE_E4M3);
+}
+
+float dequantize_scalar_e4m3(uint8_t bits) {
+    return decode_scalar_fp32(TYPE_E4M3_FP32[bits]);
+}
+
+uint8_t quantize_scalar_e5m2(float value) {
+    return type_encode_fp8(value, &TYPE_E5M2);
+}
+
+float dequantize_scalar_e5m2(uint8_t bits) {
+    return decode_scalar_fp32(TYPE_E5M2_FP32[bits]);
+}
+
 // 8-bit quantization with residual baking
 Q8 quantize_scalar_q8(float value) {
     Q8 q8;
@@ -235,7 +393,7 @@ void dequantize_scalar_q4_reference(Q4 q4, float* a, float* b) {
 
 // Generic interface
 
-// Supports 32, 16, and 8-bit formats. Q4 is excluded.
+// Supports 32, 16, and 8-bit formats, FP8 included. Q4 is excluded.
 bool quantize_scalar(float input, void* output, DataTypeId id) {
     switch (id) {
         case TYPE_FLOAT32:
@@ -262,6 +420,12 @@ bool quantize_scalar(float input, void* output, DataTypeId id) {
                 *out = quantize_scalar_q8(input);
                 break;
             }
+        case TYPE_FLOAT8_E4M3:
+            *(uint8_t*) output = quantize_scalar_e4m3(input);
+            break;
+        case TYPE_FLOAT8_E5M2:
+            *(uint8_t*) output = quantize_scalar_e5m2(input);
+            break;
         default:
             return false;
     }
@@ -283,12 +447,908 @@ bool dequantize_scalar(const void* input, float* output, DataTypeId id) {
         case TYPE_QUANT8:
             *out = dequantize_scalar_q8(*(Q8*) input);
             break;
+        case TYPE_FLOAT8_E4M3:
+            *out = dequantize_scalar_e4m3(*(const uint8_t*) input);
+            break;
+        case TYPE_FLOAT8_E5M2:
+            *out = dequantize_scalar_e5m2(*(const uint8_t*) input);
+            break;
         default:
             return false;
     }
     return true;
 }
 
+// Vector Conversion Kernels
+
+/**
+ * Each fp16/bf16 row conversion has a scalar reference and SIMD variants that are bit-exact
+ * with it, including NaN and subnormal handling. The variant is chosen per call from
+ * TYPE_ROW_KERNELS by the active CPU level; tails shorter than a vector use the scalar path.
+ *
+ * - fp16: F16C (vcvtps2ph/vcvtph2ps) at AVX2 and AVX-512. vcvtps2ph truncates NaN payloads where
+ *   the reference returns a canonical quiet NaN, so NaN lanes are patched. SSE2 emulates the
+ *   reference with the same float and integer operations.
+ * - bf16: widening is a 16-bit shift at every level. Narrowing uses vcvtneps2bf16 when the CPU
+ *   has AVX512_BF16 (its NaN quieting and subnormal flushing match the reference), otherwise the
+ *   reference's round-to-nearest-even add and shift on integer lanes.
+ */
+
+typedef void (*TypeQuantizeRow)(const float* input, uint16_t* output, size_t length);
+typedef void (*TypeDequantizeRow)(const uint16_t* input, float* output, size_t length);
+
+typedef struct TypeRowKernels {
+    TypeQuantizeRow quantize_fp16;
+    TypeDequantizeRow dequantize_fp16;
+    TypeQuantizeRow quantize_bf16;
+    TypeDequantizeRow dequantize_bf16;
+} TypeRowKernels;
+
+static void quantize_row_fp16_scalar(const float* input, uint16_t* output, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        output[i] = quantize_scalar_fp16(input[i]);
+    }
+}
+
+static void dequantize_row_fp16_scalar(const uint16_t* input, float* output, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        output[i] = dequantize_scalar_fp16(input[i]);
+    }
+}
+
+static void quantize_row_bf16_scalar(const float* input, uint16_t* output, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        output[i] = quantize_scalar_bf16(input[i]);
+    }
+}
+
+static void dequantize_row_bf16_scalar(const uint16_t* input, float* output, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        output[i] = dequantize_scalar_bf16(input[i]);
+    }
+}
+
+#if defined(__SSE2__)
+
+// Unsigned 32-bit a > b (SSE2 only compares signed).
+static inline __m128i type_cmpgt_epu32_sse2(__m128i a, __m128i b) {
+    const __m128i flip = _mm_set1_epi32((int) 0x80000000);
+    return _mm_cmpgt_epi32(_mm_xor_si128(a, flip), _mm_xor_si128(b, flip));
+}
+
+static inline __m128i type_select_sse2(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Packs the low halves of eight 32-bit lanes; sign extension keeps packs_epi32 from saturating.
+static inline __m128i type_pack_lo16_sse2(__m128i a, __m128i b) {
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+}
+
+// Lane-wise quantize_scalar_fp16; results are in the low 16 bits of each lane.
+static inline __m128i type_fp32_to_fp16_sse2(__m128 value) {
+    const __m128 scale_to_inf = _mm_set1_ps(0x1.0p+112f);
+    const __m128 scale_to_zero = _mm_set1_ps(0x1.0p-110f);
+    const __m128i min_bias = _mm_set1_epi32(0x71000000);
+
+    __m128i w = _mm_castps_si128(value);
+    __m128 magnitude = _mm_castsi128_ps(_mm_and_si128(w, _mm_set1_epi32(0x7FFFFFFF)));
+    __m128 base = _mm_mul_ps(_mm_mul_ps(magnitude, scale_to_inf), scale_to_zero);
+
+    __m128i shl1_w = _mm_add_epi32(w, w);
+    __m128i sign = _mm_and_si128(w, _mm_set1_epi32((int) 0x80000000));
+    __m128i bias = _mm_and_si128(shl1_w, _mm_set1_epi32((int) 0xFF000000));
+    bias = type_select_sse2(type_cmpgt_epu32_sse2(min_bias, bias), min_bias, bias);
+
+    __m128i magic = _mm_add_epi32(_mm_srli_epi32(bias, 1), _mm_set1_epi32(0x07800000));
+    __m128i bits = _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(magic), base));
+    __m128i exp_bits = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(0x00007C00));
+    __m128i mantissa_bits = _mm_and_si128(bits, _mm_set1_epi32(0x00000FFF));
+    __m128i nonsign = _mm_add_epi32(exp_bits, mantissa_bits);
+
+    __m128i nan = type_cmpgt_epu32_sse2(shl1_w, _mm_set1_epi32((int) 0xFF000000));
+    nonsign = type_select_sse2(nan, _mm_set1_epi32(0x7E00), nonsign);
+    return _mm_or_si128(_mm_srli_epi32(sign, 16), nonsign);
+}
+
+// Lane-wise dequantize_scalar_fp16 on `w = half << 16`.
+static inline __m128 type_fp16_to_fp32_sse2(__m128i w) {
+    __m128i sign = _mm_and_si128(w, _mm_set1_epi32((int) 0x80000000));
+    __m128i two_w = _mm_add_epi32(w, w);
+
+    __m128i exp_offset = _mm_set1_epi32(0xE0 << 23);
+    __m128 normalized = _mm_mul_ps(
+        _mm_castsi128_ps(_mm_add_epi32(_mm_srli_epi32(two_w, 4), exp_offset)),
+        _mm_set1_ps(0x1.0p-112f)
+    );
+
+    __m128i magic_mask = _mm_set1_epi32(126 << 23);
+    __m128 denormalized = _mm_sub_ps(
+        _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(two_w, 17), magic_mask)), _mm_set1_ps(0.5f)
+    );
+
+    __m128i denormal = type_cmpgt_epu32_sse2(_mm_set1_epi32(1 << 27), two_w);
+    __m128i result = type_select_sse2(
+        denormal, _mm_castps_si128(denormalized), _mm_castps_si128(normalized)
+    );
+    return _mm_castsi128_ps(_mm_or_si128(sign, result));
+}
+
+// Lane-wise quantize_scalar_bf16; results are in the low 16 bits of each lane.
+static inline __m128i type_fp32_to_bf16_sse2(__m128i w) {
+    __m128i magnitude = _mm_and_si128(w, _mm_set1_epi32(0x7FFFFFFF));
+    __m128i nan = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7F800000));
+    __m128i subnormal = _mm_cmpeq_epi32(
+        _mm_and_si128(w, _mm_set1_epi32(0x7F800000)), _mm_setzero_si128()
+    );
+
+    __m128i lsb = _mm_and_si128(_mm_srli_epi32(w, 16), _mm_set1_epi32(1));
+    __m128i rounded = _mm_add_epi32(w, _mm_add_epi32(_mm_set1_epi32(0x7FFF), lsb));
+    rounded = _mm_srli_epi32(rounded, 16);
+
+    __m128i quiet = _mm_or_si128(_mm_srli_epi32(w, 16), _mm_set1_epi32(0x40));
+    __m128i flushed = _mm_srli_epi32(_mm_and_si128(w, _mm_set1_epi32((int) 0x80000000)), 16);
+
+    __m128i result = type_select_sse2(subnormal, flushed, rounded);
+    return type_select_sse2(nan, quiet, result);
+}
+
+static void quantize_row_fp16_sse2(const float* input, uint16_t* output, size_t length) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i lo = type_fp32_to_fp16_sse2(_mm_loadu_ps(input + i));
+        __m128i hi = type_fp32_to_fp16_sse2(_mm_loadu_ps(input + i + 4));
+        _mm_storeu_si128((__m128i*) (output + i), type_pack_lo16_sse2(lo, hi));
+    }
+    quantize_row_fp16_scalar(input + i, output + i, length - i);
+}
+
+static void dequantize_row_fp16_sse2(const uint16_t* input, float* output, size_t length) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i h = _mm_loadu_si128((const __m128i*) (input + i));
+        _mm_storeu_ps(output + i, type_fp16_to_fp32_sse2(_mm_unpacklo_epi16(zero, h)));
+        _mm_storeu_ps(output + i + 4, type_fp16_to_fp32_sse2(_mm_unpackhi_epi16(zero, h)));
+    }
+    dequantize_row_fp16_scalar(input + i, output + i, length - i);
+}
+
+static void quantize_row_bf16_sse2(const float* input, uint16_t* output, size_t length) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i lo = type_fp32_to_bf16_sse2(_mm_loadu_si128((const __m128i*) (input + i)));
+        __m128i hi = type_fp32_to_bf16_sse2(_mm_loadu_si128((const __m128i*) (input + i + 4)));
+        _mm_storeu_si128((__m128i*) (output + i), type_pack_lo16_sse2(lo, hi));
+    }
+    quantize_row_bf16_scalar(input + i, output + i, length - i);
+}
+
+static void dequantize_row_bf16_sse2(const uint16_t* input, float* output, size_t length) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i h = _mm_loadu_si128((const __m128i*) (input + i));
+        _mm_storeu_si128((__m128i*) (output + i), _mm_unpacklo_epi16(zero, h));
+        _mm_storeu_si128((__m128i*) (output + i + 4), _mm_unpackhi_epi16(zero, h));
+    }
+    dequantize_row_bf16_scalar(input + i, output + i, length - i);
+}
+
+#else
+    #define quantize_row_fp16_sse2 quantize_row_fp16_scalar
+    #define dequantize_row_fp16_sse2 dequantize_row_fp16_scalar
+    #define quantize_row_bf16_sse2 quantize_row_bf16_scalar
+    #define dequantize_row_bf16_sse2 dequantize_row_bf16_scalar
+#endif // __SSE2__
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static void
+quantize_row_fp16_avx2(const float* input, uint16_t* output, size_t length) {
+    const __m128i sign_mask = _mm_set1_epi16((short) 0x8000);
+    const __m128i quiet_nan = _mm_set1_epi16(0x7E00);
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256 x = _mm256_loadu_ps(input + i);
+        __m128i h = _mm256_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT);
+
+        __m256i unordered = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+        __m128i nan = _mm_packs_epi32(
+            _mm256_castsi256_si128(unordered), _mm256_extracti128_si256(unordered, 1)
+        );
+        __m128i canonical = _mm_or_si128(_mm_and_si128(h, sign_mask), quiet_nan);
+        _mm_storeu_si128((__m128i*) (output + i), _mm_blendv_epi8(h, canonical, nan));
+    }
+    quantize_row_fp16_scalar(input + i, output + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+dequantize_row_fp16_avx2(const uint16_t* input, float* output, size_t length) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i h = _mm_loadu_si128((const __m128i*) (input + i));
+        _mm256_storeu_ps(output + i, _mm256_cvtph_ps(h));
+    }
+    dequantize_row_fp16_scalar(input + i, output + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+quantize_row_bf16_avx2(const float* input, uint16_t* output, size_t length) {
+    const __m256i magnitude_mask = _mm256_set1_epi32(0x7FFFFFFF);
+    const __m256i exponent_mask = _mm256_set1_epi32(0x7F800000);
+    const __m256i sign_mask = _mm256_set1_epi32((int) 0x80000000);
+    const __m256i round = _mm256_set1_epi32(0x7FFF);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i quiet = _mm256_set1_epi32(0x40);
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i w = _mm256_loadu_si256((const __m256i*) (input + i));
+
+        __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(w, magnitude_mask), exponent_mask);
+        __m256i subnormal = _mm256_cmpeq_epi32(
+            _mm256_and_si256(w, exponent_mask), _mm256_setzero_si256()
+        );
+
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(w, 16), one);
+        __m256i result = _mm256_srli_epi32(_mm256_add_epi32(w, _mm256_add_epi32(round, lsb)), 16);
+        __m256i flushed = _mm256_srli_epi32(_mm256_and_si256(w, sign_mask), 16);
+        result = _mm256_blendv_epi8(result, flushed, subnormal);
+        result = _mm256_blendv_epi8(result, _mm256_or_si256(_mm256_srli_epi32(w, 16), quiet), nan);
+
+        // Every lane is at most 0xFFFF, so the unsigned pack cannot saturate.
+        __m128i packed = _mm_packus_epi32(
+            _mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1)
+        );
+        _mm_storeu_si128((__m128i*) (output + i), packed);
+    }
+    quantize_row_bf16_scalar(input + i, output + i, length - i);
+}
+
+CPU_TARGET_AVX2 static void
+dequantize_row_bf16_avx2(const uint16_t* input, float* output, size_t length) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (input + i)));
+        _mm256_storeu_si256((__m256i*) (output + i), _mm256_slli_epi32(h, 16));
+    }
+    dequantize_row_bf16_scalar(input + i, output + i, length - i);
+}
+
+CPU_TARGET_AVX512 static void
+quantize_row_fp16_avx512(const float* input, uint16_t* output, size_t length) {
+    const __m256i sign_mask = _mm256_set1_epi16((short) 0x8000);
+    const __m256i quiet_nan = _mm256_set1_epi16(0x7E00);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m512 x = _mm512_loadu_ps(input + i);
+        __m256i h = _mm512_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT);
+        __mmask16 nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+        __m256i canonical = _mm256_or_si256(_mm256_and_si256(h, sign_mask), quiet_nan);
+        _mm256_storeu_si256((__m256i*) (output + i), _mm256_mask_blend_epi16(nan, h, canonical));
+    }
+    quantize_row_fp16_scalar(input + i, output + i, length - i);
+}
+
+CPU_TARGET_AVX512 static void
+dequantize_row_fp16_avx512(const uint16_t* input, float* output, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i h = _mm256_loadu_si256((const __m256i*) (input + i));
+        _mm512_storeu_ps(output + i, _mm512_cvtph_ps(h));
+    }
+    dequantize_row_fp16_scalar(input + i, output + i, length - i);
+}
+
+CPU_TARGET_AVX512 static void
+dequantize_row_bf16_avx512(const uint16_t* input, float* output, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m512i h = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) (input + i)));
+        _mm512_storeu_si512(output + i, _mm512_slli_epi32(h, 16));
+    }
+    dequantize_row_bf16_scalar(input + i, output + i, length - i);
+}
+
+CPU_TARGET_AVX512_BF16 static void
+quantize_row_bf16_avx512_bf16(const float* input, uint16_t* output, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(input + i));
+        _mm256_storeu_si256((__m256i*) (output + i), (__m256i) h);
+    }
+    quantize_row_bf16_scalar(input + i, output + i, length - i);
+}
+
+#endif // CPU_X86
+
+static const TypeRowKernels TYPE_ROW_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {
+        quantize_row_fp16_scalar,
+        dequantize_row_fp16_scalar,
+        quantize_row_bf16_scalar,
+        dequantize_row_bf16_scalar,
+    },
+    [CPU_LEVEL_SSE2] = {
+        quantize_row_fp16_sse2,
+        dequantize_row_fp16_sse2,
+        quantize_row_bf16_sse2,
+        dequantize_row_bf16_sse2,
+    },
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {
+        quantize_row_fp16_avx2,
+        dequantize_row_fp16_avx2,
+        quantize_row_bf16_avx2,
+        dequantize_row_bf16_avx2,
+    },
+    [CPU_LEVEL_AVX512] = {
+        quantize_row_fp16_avx512,
+        dequantize_row_fp16_avx512,
+        quantize_row_bf16_avx2, // replaced by the BF16 kernel when the CPU has one
+        dequantize_row_bf16_avx512,
+    },
+#endif
+};
+
+// FP8 Row Kernels
+
+/**
+ * Every variant encodes with the integer rounding of type_encode_fp8 and decodes through the
+ * same table, so they are bit-exact with the scalar codecs. Kernels take the multiplier of the
+ * scaled forms; the plain forms pass 1, which leaves every value, NaN bits included, unchanged.
+ *
+ * - Encoding: SSE2 and AVX2 run type_encode_fp8 lane-wise. AVX-512 reuses AVX2.
+ * - Decoding: AVX2 and AVX-512 gather from the table. SSE2 has no gather, so it reads the table
+ *   one byte at a time, as the scalar path does.
+ */
+
+typedef void (*TypeEncodeFp8)(
+    const float* input, uint8_t* output, size_t length, float factor, const TypeFp8Format* format
+);
+typedef void (*TypeDecodeFp8)(
+    const uint8_t* input, float* output, size_t length, float factor, const uint32_t* table
+);
+
+typedef struct TypeFp8Kernels {
+    TypeEncodeFp8 encode;
+    TypeDecodeFp8 decode;
+} TypeFp8Kernels;
+
+static void type_encode_fp8_scalar(
+    const float* input, uint8_t* output, size_t length, float factor, const TypeFp8Format* format
+) {
+    for (size_t i = 0; i < length; i++) {
+        output[i] = type_encode_fp8(input[i] * factor, format);
+    }
+}
+
+static void type_decode_fp8_scalar(
+    const uint8_t* input, float* output, size_t length, float factor, const uint32_t* table
+) {
+    for (size_t i = 0; i < length; i++) {
+        output[i] = decode_scalar_fp32(table[input[i]]) * factor;
+    }
+}
+
+#if defined(__SSE2__)
+
+// Lane-wise type_encode_fp8; results are in the low 8 bits of each lane.
+static inline __m128i type_fp32_to_fp8_sse2(__m128 value, const TypeFp8Format* format) {
+    const __m128i exponent = _mm_set1_epi32(0x7F800000);
+    const __m128i shift = _mm_cvtsi32_si128((int) (23 - format->mantissa));
+    const __m128 magic = _mm_set1_ps(format->magic);
+
+    __m128i w = _mm_castps_si128(value);
+    __m128i sign = _mm_and_si128(_mm_srli_epi32(w, 24), _mm_set1_epi32(0x80));
+    __m128i abs = _mm_and_si128(w, _mm_set1_epi32(0x7FFFFFFF));
+
+    __m128i lsb = _mm_and_si128(_mm_srl_epi32(abs, shift), _mm_set1_epi32(1));
+    __m128i round = _mm_set1_epi32((int) ((1u << (22 - format->mantissa)) - 1));
+    __m128i normal = _mm_srl_epi32(_mm_add_epi32(abs, _mm_add_epi32(round, lsb)), shift);
+    normal = _mm_sub_epi32(normal, _mm_set1_epi32((int) format->rebias));
+    __m128i max = _mm_set1_epi32((int) format->max);
+    normal = type_select_sse2(_mm_cmpgt_epi32(normal, max), max, normal);
+
+    __m128 rounded = _mm_add_ps(_mm_castsi128_ps(abs), magic);
+    __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(rounded), _mm_castps_si128(magic));
+
+    __m128i tiny = _mm_cmpgt_epi32(_mm_set1_epi32((int) format->normal), abs);
+    __m128i code = type_select_sse2(tiny, subnormal, normal);
+    code = type_select_sse2(
+        _mm_cmpeq_epi32(abs, exponent), _mm_set1_epi32((int) format->inf), code
+    );
+    code = type_select_sse2(
+        _mm_cmpgt_epi32(abs, exponent), _mm_set1_epi32((int) format->nan), code
+    );
+    return _mm_or_si128(code, sign);
+}
+
+static void type_encode_fp8_sse2(
+    const float* input, uint8_t* output, size_t length, float factor, const TypeFp8Format* format
+) {
+    const __m128 f = _mm_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i q[4];
+        for (size_t k = 0; k < 4; k++) {
+            __m128 x = _mm_mul_ps(_mm_loadu_ps(input + i + k * 4), f);
+            q[k] = type_fp32_to_fp8_sse2(x, format);
+        }
+        // Every lane is at most 0xFF, so neither pack saturates.
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+        _mm_storeu_si128((__m128i*) (output + i), packed);
+    }
+    type_encode_fp8_scalar(input + i, output + i, length - i, factor, format);
+}
+
+#else
+    #define type_encode_fp8_sse2 type_encode_fp8_scalar
+#endif // __SSE2__
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline __m256i
+type_fp32_to_fp8_avx2(__m256 value, const TypeFp8Format* format) {
+    const __m256i exponent = _mm256_set1_epi32(0x7F800000);
+    const __m128i shift = _mm_cvtsi32_si128((int) (23 - format->mantissa));
+    const __m256 magic = _mm256_set1_ps(format->magic);
+
+    __m256i w = _mm256_castps_si256(value);
+    __m256i sign = _mm256_and_si256(_mm256_srli_epi32(w, 24), _mm256_set1_epi32(0x80));
+    __m256i abs = _mm256_and_si256(w, _mm256_set1_epi32(0x7FFFFFFF));
+
+    __m256i lsb = _mm256_and_si256(_mm256_srl_epi32(abs, shift), _mm256_set1_epi32(1));
+    __m256i round = _mm256_set1_epi32((int) ((1u << (22 - format->mantissa)) - 1));
+    __m256i normal = _mm256_srl_epi32(_mm256_add_epi32(abs, _mm256_add_epi32(round, lsb)), shift);
+    normal = _mm256_sub_epi32(normal, _mm256_set1_epi32((int) format->rebias));
+    normal = _mm256_min_epi32(normal, _mm256_set1_epi32((int) format->max));
+
+    __m256 rounded = _mm256_add_ps(_mm256_castsi256_ps(abs), magic);
+    __m256i subnormal = _mm256_sub_epi32(_mm256_castps_si256(rounded), _mm256_castps_si256(magic));
+
+    __m256i tiny = _mm256_cmpgt_epi32(_mm256_set1_epi32((int) format->normal), abs);
+    __m256i code = _mm256_blendv_epi8(normal, subnormal, tiny);
+    code = _mm256_blendv_epi8(
+        code, _mm256_set1_epi32((int) format->inf), _mm256_cmpeq_epi32(abs, exponent)
+    );
+    code = _mm256_blendv_epi8(
+        code, _mm256_set1_epi32((int) format->nan), _mm256_cmpgt_epi32(abs, exponent)
+    );
+    return _mm256_or_si256(code, sign);
+}
+
+CPU_TARGET_AVX2 static void type_encode_fp8_avx2(
+    const float* input, uint8_t* output, size_t length, float factor, const TypeFp8Format* format
+) {
+    const __m256 f = _mm256_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i lo = type_fp32_to_fp8_avx2(_mm256_mul_ps(_mm256_loadu_ps(input + i), f), format);
+        __m256i hi = type_fp32_to_fp8_avx2(
+            _mm256_mul_ps(_mm256_loadu_ps(input + i + 8), f), format
+        );
+        __m128i lo16 = _mm_packs_epi32(_mm256_castsi256_si128(lo), _mm256_extracti128_si256(lo, 1));
+        __m128i hi16 = _mm_packs_epi32(_mm256_castsi256_si128(hi), _mm256_extracti128_si256(hi, 1));
+        _mm_storeu_si128((__m128i*) (output + i), _mm_packus_epi16(lo16, hi16));
+    }
+    type_encode_fp8_scalar(input + i, output + i, length - i, factor, format);
+}
+
+CPU_TARGET_AVX2 static void type_decode_fp8_avx2(
+    const uint8_t* input, float* output, size_t length, float factor, const uint32_t* table
+) {
+    const __m256 f = _mm256_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (input + i)));
+        __m256i bits = _mm256_i32gather_epi32((const int*) table, index, 4);
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_castsi256_ps(bits), f));
+    }
+    type_decode_fp8_scalar(input + i, output + i, length - i, factor, table);
+}
+
+CPU_TARGET_AVX512 static void type_decode_fp8_avx512(
+    const uint8_t* input, float* output, size_t length, float factor, const uint32_t* table
+) {
+    const __m512 f = _mm512_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m512i index = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*) (input + i)));
+        __m512i bits = _mm512_i32gather_epi32(index, (const int*) table, 4);
+        _mm512_storeu_ps(output + i, _mm512_mul_ps(_mm512_castsi512_ps(bits), f));
+    }
+    type_decode_fp8_scalar(input + i, output + i, length - i, factor, table);
+}
+
+#endif // CPU_X86
+
+static const TypeFp8Kernels TYPE_FP8_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {type_encode_fp8_scalar, type_decode_fp8_scalar},
+    [CPU_LEVEL_SSE2] = {type_encode_fp8_sse2, type_decode_fp8_scalar},
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {type_encode_fp8_avx2, type_decode_fp8_avx2},
+    [CPU_LEVEL_AVX512] = {type_encode_fp8_avx2, type_decode_fp8_avx512},
+#endif
+};
+
+// Block Quantization Kernels
+
+/**
+ * Every variant computes the block scale with the same scalar code and rounds `x / step` with
+ * round-to-nearest-even, so SIMD output is bit-exact with the scalar path. Kernels process
+ * whole blocks; the public functions pad a partial last block.
+ */
+
+typedef void (*TypeQuantizeBlocksQ8)(const float* input, BlockQ8* output, size_t blocks);
+typedef void (*TypeDequantizeBlocksQ8)(const BlockQ8* input, float* output, size_t blocks);
+typedef void (*TypeQuantizeBlocksQ4)(const float* input, BlockQ4* output, size_t blocks);
+typedef void (*TypeDequantizeBlocksQ4)(const BlockQ4* input, float* output, size_t blocks);
+
+typedef struct TypeBlockKernels {
+    TypeQuantizeBlocksQ8 quantize_q8;
+    TypeDequantizeBlocksQ8 dequantize_q8;
+    TypeQuantizeBlocksQ4 quantize_q4;
+    TypeDequantizeBlocksQ4 dequantize_q4;
+} TypeBlockKernels;
+
+// Round to nearest, ties to even, for |x| < 2^22; matches cvtps2dq under the default MXCSR.
+static inline int32_t type_round(float x) {
+    const float magic = 0x1.8p23f;
+    return (int32_t) ((x + magic) - magic);
+}
+
+static inline int32_t type_clamp(int32_t x, int32_t lo, int32_t hi) {
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+// Stores the Q8 step for a block with largest magnitude `amax` and returns its reciprocal.
+static inline float type_block_scale_q8(float amax, uint16_t* scale) {
+    float d = amax / 127.0f;
+    *scale = quantize_scalar_fp16(d);
+    return d != 0.0f ? 1.0f / d : 0.0f;
+}
+
+// Stores the Q4 step for a block with extremes `min` and `max` and returns its reciprocal.
+static inline float type_block_scale_q4(float min, float max, uint16_t* scale) {
+    float m = -min > max ? min : max; // largest magnitude, keeping its sign
+    float d = m != 0.0f ? m / -8.0f : 0.0f;
+    *scale = quantize_scalar_fp16(d);
+    return d != 0.0f ? 1.0f / d : 0.0f;
+}
+
+static void quantize_blocks_q8_scalar(const float* input, BlockQ8* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        const float* x = input + b * BLOCK_SIZE;
+
+        float amax = 0.0f;
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            float a = fabsf(x[i]);
+            amax = a > amax ? a : amax;
+        }
+
+        float id = type_block_scale_q8(amax, &output[b].scale);
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            output[b].quants[i] = (int8_t) type_clamp(type_round(x[i] * id), -128, 127);
+        }
+    }
+}
+
+static void dequantize_blocks_q8_scalar(const BlockQ8* input, float* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        float d = dequantize_scalar_fp16(input[b].scale);
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            output[b * BLOCK_SIZE + i] = (float) input[b].quants[i] * d;
+        }
+    }
+}
+
+static void quantize_blocks_q4_scalar(const float* input, BlockQ4* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        const float* x = input + b * BLOCK_SIZE;
+
+        float min = 0.0f;
+        float max = 0.0f;
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            min = x[i] < min ? x[i] : min;
+            max = x[i] > max ? x[i] : max;
+        }
+
+        float id = type_block_scale_q4(min, max, &output[b].scale);
+        for (size_t i = 0; i < Q4_NIBBLES; i++) {
+            int32_t lo = type_clamp(type_round(x[i] * id) + 8, 0, 15);
+            int32_t hi = type_clamp(type_round(x[i + Q4_NIBBLES] * id) + 8, 0, 15);
+            output[b].nibbles[i] = (uint8_t) (lo | (hi << 4));
+        }
+    }
+}
+
+static void dequantize_blocks_q4_scalar(const BlockQ4* input, float* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        float d = dequantize_scalar_fp16(input[b].scale);
+        float* y = output + b * BLOCK_SIZE;
+        for (size_t i = 0; i < Q4_NIBBLES; i++) {
+            uint8_t n = input[b].nibbles[i];
+            y[i] = (float) ((int32_t) (n & 0x0F) - 8) * d;
+            y[i + Q4_NIBBLES] = (float) ((int32_t) (n >> 4) - 8) * d;
+        }
+    }
+}
+
+#if defined(__SSE2__)
+
+static inline float type_hmax_sse2(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static inline float type_hmin_sse2(__m128 v) {
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+// Sign-extends 16 int8 lanes and stores them as floats scaled by `d`.
+static inline void type_store_int8_sse2(float* y, __m128i v, __m128 d) {
+    __m128i w[2] = {
+        _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8),
+        _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8),
+    };
+    for (size_t k = 0; k < 2; k++) {
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w[k], w[k]), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w[k], w[k]), 16);
+        _mm_storeu_ps(y + k * 8, _mm_mul_ps(_mm_cvtepi32_ps(lo), d));
+        _mm_storeu_ps(y + k * 8 + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), d));
+    }
+}
+
+// Biases eight int16 steps by 8 and clamps them to a nibble.
+static inline __m128i type_nibble_sse2(__m128i q) {
+    q = _mm_add_epi16(q, _mm_set1_epi16(8));
+    return _mm_min_epi16(_mm_max_epi16(q, _mm_setzero_si128()), _mm_set1_epi16(15));
+}
+
+// Packs 32 int32 steps (elements 0-7, 8-15, 16-23, 24-31) into 16 nibble pairs.
+static inline __m128i type_pack_nibbles_sse2(__m128i q0, __m128i q1, __m128i q2, __m128i q3) {
+    __m128i lo = _mm_packus_epi16(
+        type_nibble_sse2(_mm_packs_epi32(q0, q1)), _mm_setzero_si128()
+    );
+    __m128i hi = _mm_packus_epi16(
+        type_nibble_sse2(_mm_packs_epi32(q2, q3)), _mm_setzero_si128()
+    );
+    // Each byte is at most 0x0F, so the 16-bit shift cannot carry into the next byte.
+    return _mm_or_si128(lo, _mm_slli_epi16(hi, 4));
+}
+
+static void quantize_blocks_q8_sse2(const float* input, BlockQ8* output, size_t blocks) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for (size_t b = 0; b < blocks; b++) {
+        const float* x = input + b * BLOCK_SIZE;
+
+        __m128 v[8];
+        __m128 amax = _mm_setzero_ps();
+        for (size_t k = 0; k < 8; k++) {
+            v[k] = _mm_loadu_ps(x + k * 4);
+            amax = _mm_max_ps(amax, _mm_andnot_ps(sign, v[k]));
+        }
+
+        __m128 id = _mm_set1_ps(type_block_scale_q8(type_hmax_sse2(amax), &output[b].scale));
+        for (size_t k = 0; k < 8; k += 4) {
+            __m128i q0 = _mm_cvtps_epi32(_mm_mul_ps(v[k], id));
+            __m128i q1 = _mm_cvtps_epi32(_mm_mul_ps(v[k + 1], id));
+            __m128i q2 = _mm_cvtps_epi32(_mm_mul_ps(v[k + 2], id));
+            __m128i q3 = _mm_cvtps_epi32(_mm_mul_ps(v[k + 3], id));
+            __m128i q = _mm_packs_epi16(_mm_packs_epi32(q0, q1), _mm_packs_epi32(q2, q3));
+            _mm_storeu_si128((__m128i*) (output[b].quants + k * 4), q);
+        }
+    }
+}
+
+static void dequantize_blocks_q8_sse2(const BlockQ8* input, float* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        __m128 d = _mm_set1_ps(dequantize_scalar_fp16(input[b].scale));
+        float* y = output + b * BLOCK_SIZE;
+        type_store_int8_sse2(y, _mm_loadu_si128((const __m128i*) input[b].quants), d);
+        type_store_int8_sse2(y + 16, _mm_loadu_si128((const __m128i*) (input[b].quants + 16)), d);
+    }
+}
+
+static void quantize_blocks_q4_sse2(const float* input, BlockQ4* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        const float* x = input + b * BLOCK_SIZE;
+
+        __m128 v[8];
+        __m128 min = _mm_setzero_ps();
+        __m128 max = _mm_setzero_ps();
+        for (size_t k = 0; k < 8; k++) {
+            v[k] = _mm_loadu_ps(x + k * 4);
+            min = _mm_min_ps(min, v[k]);
+            max = _mm_max_ps(max, v[k]);
+        }
+
+        float scale = type_block_scale_q4(type_hmin_sse2(min), type_hmax_sse2(max), &output[b].scale);
+        __m128 id = _mm_set1_ps(scale);
+
+        __m128i q[8];
+        for (size_t k = 0; k < 8; k++) {
+            q[k] = _mm_cvtps_epi32(_mm_mul_ps(v[k], id));
+        }
+        __m128i lo = type_pack_nibbles_sse2(q[0], q[1], q[4], q[5]);
+        __m128i hi = type_pack_nibbles_sse2(q[2], q[3], q[6], q[7]);
+        _mm_storeu_si128((__m128i*) output[b].nibbles, _mm_unpacklo_epi64(lo, hi));
+    }
+}
+
+static void dequantize_blocks_q4_sse2(const BlockQ4* input, float* output, size_t blocks) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i bias = _mm_set1_epi8(8);
+    for (size_t b = 0; b < blocks; b++) {
+        __m128 d = _mm_set1_ps(dequantize_scalar_fp16(input[b].scale));
+        __m128i v = _mm_loadu_si128((const __m128i*) input[b].nibbles);
+        __m128i lo = _mm_sub_epi8(_mm_and_si128(v, mask), bias);
+        __m128i hi = _mm_sub_epi8(_mm_and_si128(_mm_srli_epi16(v, 4), mask), bias);
+        type_store_int8_sse2(output + b * BLOCK_SIZE, lo, d);
+        type_store_int8_sse2(output + b * BLOCK_SIZE + Q4_NIBBLES, hi, d);
+    }
+}
+
+#else
+    #define quantize_blocks_q8_sse2 quantize_blocks_q8_scalar
+    #define dequantize_blocks_q8_sse2 dequantize_blocks_q8_scalar
+    #define quantize_blocks_q4_sse2 quantize_blocks_q4_scalar
+    #define dequantize_blocks_q4_sse2 dequantize_blocks_q4_scalar
+#endif // __SSE2__
+
+#if CPU_X86
+
+CPU_TARGET_AVX2 static inline float type_hmax_avx2(__m256 v) {
+    __m128 h = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_max_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+CPU_TARGET_AVX2 static inline float type_hmin_avx2(__m256 v) {
+    __m128 h = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_min_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+CPU_TARGET_AVX2 static void
+quantize_blocks_q8_avx2(const float* input, BlockQ8* output, size_t blocks) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (size_t b = 0; b < blocks; b++) {
+        const float* x = input + b * BLOCK_SIZE;
+        __m256 v0 = _mm256_loadu_ps(x);
+        __m256 v1 = _mm256_loadu_ps(x + 8);
+        __m256 v2 = _mm256_loadu_ps(x + 16);
+        __m256 v3 = _mm256_loadu_ps(x + 24);
+
+        __m256 amax = _mm256_max_ps(
+            _mm256_max_ps(_mm256_andnot_ps(sign, v0), _mm256_andnot_ps(sign, v1)),
+            _mm256_max_ps(_mm256_andnot_ps(sign, v2), _mm256_andnot_ps(sign, v3))
+        );
+        __m256 id = _mm256_set1_ps(type_block_scale_q8(type_hmax_avx2(amax), &output[b].scale));
+
+        __m256i q0 = _mm256_cvtps_epi32(_mm256_mul_ps(v0, id));
+        __m256i q1 = _mm256_cvtps_epi32(_mm256_mul_ps(v1, id));
+        __m256i q2 = _mm256_cvtps_epi32(_mm256_mul_ps(v2, id));
+        __m256i q3 = _mm256_cvtps_epi32(_mm256_mul_ps(v3, id));
+
+        // The packs work per 128-bit lane; the permute restores element order.
+        __m256i q = _mm256_packs_epi16(_mm256_packs_epi32(q0, q1), _mm256_packs_epi32(q2, q3));
+        _mm256_storeu_si256((__m256i*) output[b].quants, _mm256_permutevar8x32_epi32(q, order));
+    }
+}
+
+CPU_TARGET_AVX2 static void
+dequantize_blocks_q8_avx2(const BlockQ8* input, float* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        __m256 d = _mm256_set1_ps(dequantize_scalar_fp16(input[b].scale));
+        for (size_t k = 0; k < BLOCK_SIZE; k += 8) {
+            __m128i q = _mm_loadl_epi64((const __m128i*) (input[b].quants + k));
+            __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(q));
+            _mm256_storeu_ps(output + b * BLOCK_SIZE + k, _mm256_mul_ps(v, d));
+        }
+    }
+}
+
+CPU_TARGET_AVX2 static void
+quantize_blocks_q4_avx2(const float* input, BlockQ4* output, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        const float* x = input + b * BLOCK_SIZE;
+        __m256 v0 = _mm256_loadu_ps(x);
+        __m256 v1 = _mm256_loadu_ps(x + 8);
+        __m256 v2 = _mm256_loadu_ps(x + 16);
+        __m256 v3 = _mm256_loadu_ps(x + 24);
+
+        __m256 zero = _mm256_setzero_ps();
+        __m256 min = _mm256_min_ps(
+            _mm256_min_ps(_mm256_min_ps(zero, v0), v1), _mm256_min_ps(v2, v3)
+        );
+        __m256 max = _mm256_max_ps(
+            _mm256_max_ps(_mm256_max_ps(zero, v0), v1), _mm256_max_ps(v2, v3)
+        );
+        float scale = type_block_scale_q4(type_hmin_avx2(min), type_hmax_avx2(max), &output[b].scale);
+        __m256 id = _mm256_set1_ps(scale);
+
+        __m256i q0 = _mm256_cvtps_epi32(_mm256_mul_ps(v0, id));
+        __m256i q1 = _mm256_cvtps_epi32(_mm256_mul_ps(v1, id));
+        __m256i q2 = _mm256_cvtps_epi32(_mm256_mul_ps(v2, id));
+        __m256i q3 = _mm256_cvtps_epi32(_mm256_mul_ps(v3, id));
+
+        __m128i lo = type_pack_nibbles_sse2(
+            _mm256_castsi256_si128(q0),
+            _mm256_extracti128_si256(q0, 1),
+            _mm256_castsi256_si128(q2),
+            _mm256_extracti128_si256(q2, 1)
+        );
+        __m128i hi = type_pack_nibbles_sse2(
+            _mm256_castsi256_si128(q1),
+            _mm256_extracti128_si256(q1, 1),
+            _mm256_castsi256_si128(q3),
+            _mm256_extracti128_si256(q3, 1)
+        );
+        _mm_storeu_si128((__m128i*) output[b].nibbles, _mm_unpacklo_epi64(lo, hi));
+    }
+}
+
+CPU_TARGET_AVX2 static void
+dequantize_blocks_q4_avx2(const BlockQ4* input, float* output, size_t blocks) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i bias = _mm_set1_epi8(8);
+    for (size_t b = 0; b < blocks; b++) {
+        __m256 d = _mm256_set1_ps(dequantize_scalar_fp16(input[b].scale));
+        __m128i v = _mm_loadu_si128((const __m128i*) input[b].nibbles);
+        __m128i lo = _mm_sub_epi8(_mm_and_si128(v, mask), bias);
+        __m128i hi = _mm_sub_epi8(_mm_and_si128(_mm_srli_epi16(v, 4), mask), bias);
+
+        float* y = output + b * BLOCK_SIZE;
+        __m128i parts[4] = {lo, _mm_srli_si128(lo, 8), hi, _mm_srli_si128(hi, 8)};
+        for (size_t k = 0; k < 4; k++) {
+            __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(parts[k]));
+            _mm256_storeu_ps(y + k * 8, _mm256_mul_ps(f, d));
+        }
+    }
+}
+
+#endif // CPU_X86
+
+static const TypeBlockKernels TYPE_BLOCK_KERNELS[CPU_LEVEL_COUNT] = {
+    [CPU_LEVEL_SCALAR] = {
+        quantize_blocks_q8_scalar,
+        dequantize_blocks_q8_scalar,
+        quantize_blocks_q4_scalar,
+        dequantize_blocks_q4_scalar,
+    },
+    [CPU_LEVEL_SSE2] = {
+        quantize_blocks_q8_sse2,
+        dequantize_blocks_q8_sse2,
+        quantize_blocks_q4_sse2,
+        dequantize_blocks_q4_sse2,
+    },
+#if CPU_X86
+    [CPU_LEVEL_AVX2] = {
+        quantize_blocks_q8_avx2,
+        dequantize_blocks_q8_avx2,
+        quantize_blocks_q4_avx2,
+        dequantize_blocks_q4_avx2,
+    },
+    [CPU_LEVEL_AVX512] = {
+        quantize_blocks_q8_avx2,
+        dequantize_blocks_q8_avx2,
+        quantize_blocks_q4_avx2,
+        dequantize_blocks_q4_avx2,
+    },
+#endif
+};
+
 // Vector Conversions (1D arrays)
 
 // Half-precision floating-point quantization
@@ -297,9 +1357,7 @@ void quantize_row_fp16(const float* input, uint16_t* output, size_t length) {
     assert(output != NULL);
     assert(length > 0);
 
-    for (size_t i = 0; i < length; i++) {
-        output[i] = quantize_scalar_fp16(input[i]);
-    }
+    TYPE_ROW_KERNELS[cpu_level()].quantize_fp16(input, output, length);
 }
 
 void dequantize_row_fp16(const uint16_t* input, float* output, size_t length) {
@@ -307,9 +1365,7 @@ void dequantize_row_fp16(const uint16_t* input, float* output, size_t length) {
     assert(output != NULL);
     assert(length > 0);
 
-    for (size_t i = 0; i < length; i++) {
-        output[i] = dequantize_scalar_fp16(input[i]);
-    }
+    TYPE_ROW_KERNELS[cpu_level()].dequantize_fp16(input, output, length);
 }
 
 // Google brain floating-point quantization
@@ -318,9 +1374,13 @@ void quantize_row_bf16(const float* input, uint16_t* output, size_t length) {
     assert(output != NULL);
     assert(length > 0);
 
-    for (size_t i = 0; i < length; i++) {
-        output[i] = quantize_scalar_bf16(input[i]);
+#if CPU_X86
+    if (cpu_has(CPU_FEATURE_AVX512_BF16)) {
+        quantize_row_bf16_avx512_bf16(input, output, length);
+        return;
     }
+#endif
+    TYPE_ROW_KERNELS[cpu_level()].quantize_bf16(input, output, length);
 }
 
 void dequantize_row_bf16(const uint16_t* input, float* output, size_t length) {
@@ -328,9 +1388,81 @@ void dequantize_row_bf16(const uint16_t* input, float* output, size_t length) {
     assert(output != NULL);
     assert(length > 0);
 
+    TYPE_ROW_KERNELS[cpu_level()].dequantize_bf16(input, output, length);
+}
+
+// 8-bit floating-point (OCP FP8)
+void quantize_row_e4m3(const float* input, uint8_t* output, size_t length) {
+    quantize_row_e4m3_scaled(input, output, length, 1.0f);
+}
+
+void dequantize_row_e4m3(const uint8_t* input, float* output, size_t length) {
+    dequantize_row_e4m3_scaled(input, output, length, 1.0f);
+}
+
+void quantize_row_e5m2(const float* input, uint8_t* output, size_t length) {
+    quantize_row_e5m2_scaled(input, output, length, 1.0f);
+}
+
+void dequantize_row_e5m2(const uint8_t* input, float* output, size_t length) {
+    dequantize_row_e5m2_scaled(input, output, length, 1.0f);
+}
+
+void quantize_row_e4m3_scaled(const float* input, uint8_t* output, size_t length, float scale) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+    assert(scale >= FLT_MIN && isfinite(scale));
+
+    TYPE_FP8_KERNELS[cpu_level()].encode(input, output, length, 1.0f / scale, &TYPE_E4M3);
+}
+
+void dequantize_row_e4m3_scaled(const uint8_t* input, float* output, size_t length, float scale) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+    assert(scale >= FLT_MIN && isfinite(scale));
+
+    TYPE_FP8_KERNELS[cpu_level()].decode(input, output, length, scale, TYPE_E4M3.table);
+}
+
+void quantize_row_e5m2_scaled(const float* input, uint8_t* output, size_t length, float scale) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+    assert(scale >= FLT_MIN && isfinite(scale));
+
+    TYPE_FP8_KERNELS[cpu_level()].encode(input, output, length, 1.0f / scale, &TYPE_E5M2);
+}
+
+void dequantize_row_e5m2_scaled(const uint8_t* input, float* output, size_t length, float scale) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+    assert(scale >= FLT_MIN && isfinite(scale));
+
+    TYPE_FP8_KERNELS[cpu_level()].decode(input, output, length, scale, TYPE_E5M2.table);
+}
+
+// The scale is kept normal so that its reciprocal stays finite, as the scaled rows require.
+static float type_row_scale_fp8(const float* input, size_t length, float max) {
+    assert(input != NULL);
+    assert(length > 0);
+
+    float amax = 0.0f;
     for (size_t i = 0; i < length; i++) {
-        output[i] = dequantize_scalar_bf16(input[i]);
+        float a = fabsf(input[i]);
+        amax = a > amax && a != INFINITY ? a : amax; // NaN compares false
     }
+    return amax > 0.0f ? fmaxf(amax / max, FLT_MIN) : 1.0f;
+}
+
+float quantize_row_scale_e4m3(const float* input, size_t length) {
+    return type_row_scale_fp8(input, length, FP8_E4M3_MAX);
+}
+
+float quantize_row_scale_e5m2(const float* input, size_t length) {
+    return type_row_scale_fp8(input, length, FP8_E5M2_MAX);
 }
 
 // 8-bit integer quantization
@@ -378,25 +1510,81 @@ void dequantize_row_q4(const Q4Row input, float* output, size_t length) {
     }
 }
 
+// Block quantization
+void quantize_row_block_q8(const float* input, BlockQ8* output, size_t length) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+
+    size_t blocks = length / BLOCK_SIZE;
+    TYPE_BLOCK_KERNELS[cpu_level()].quantize_q8(input, output, blocks);
+
+    size_t tail = length % BLOCK_SIZE;
+    if (tail) {
+        float padded[BLOCK_SIZE] = {0};
+        memcpy(padded, input + blocks * BLOCK_SIZE, tail * sizeof(float));
+        quantize_blocks_q8_scalar(padded, output + blocks, 1);
+    }
+}
+
+void dequantize_row_block_q8(const BlockQ8* input, float* output, size_t length) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+
+    size_t blocks = length / BLOCK_SIZE;
+    TYPE_BLOCK_KERNELS[cpu_level()].dequantize_q8(input, output, blocks);
+
+    size_t tail = length % BLOCK_SIZE;
+    if (tail) {
+        float padded[BLOCK_SIZE];
+        dequantize_blocks_q8_scalar(input + blocks, padded, 1);
+        memcpy(output + blocks * BLOCK_SIZE, padded, tail * sizeof(float));
+    }
+}
+
+void quantize_row_block_q4(const float* input, BlockQ4* output, size_t length) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+
+    size_t blocks = length / BLOCK_SIZE;
+    TYPE_BLOCK_KERNELS[cpu_level()].quantize_q4(input, output, blocks);
+
+    size_t tail = length % BLOCK_SIZE;
+    if (tail) {
+        float padded[BLOCK_SIZE] = {0};
+        memcpy(padded, input + blocks * BLOCK_SIZE, tail * sizeof(float));
+        quantize_blocks_q4_scalar(padded, output + blocks, 1);
+    }
+}
+
+void dequantize_row_block_q4(const BlockQ4* input, float* output, size_t length) {
+    assert(input != NULL);
+    assert(output != NULL);
+    assert(length > 0);
+
+    size_t blocks = length / BLOCK_SIZE;
+    TYPE_BLOCK_KERNELS[cpu_level()].dequantize_q4(input, output, blocks);
+
+    size_t tail = length % BLOCK_SIZE;
+    if (tail) {
+        float padded[BLOCK_SIZE];
+        dequantize_blocks_q4_scalar(input + blocks, padded, 1);
+        memcpy(output + blocks * BLOCK_SIZE, padded, tail * sizeof(float));
+    }
+}
+
 // Generic interface
 
-// Supports 32, 16, and 8-bit formats. Q4 is excluded.
+// Supports every type; the conversion engine picks the row kernel.
 bool quantize_row(const float* input, void* output, size_t length, DataTypeId id) {
     assert(input != NULL);
     assert(output != NULL);
     assert(length > 0);
     assert(id < TYPE_COUNT);
 
-    size_t stride = data_type_size(id);
-    assert(stride > 0);
-
-    for (size_t i = 0; i < length; ++i) {
-        void* dst = (uint8_t*) output + i * stride;
-        if (!quantize_scalar(input[i], dst, id)) {
-            return false;
-        }
-    }
-    return true;
+    return convert_row(input, TYPE_FLOAT32, output, id, length);
 }
 
 bool dequantize_row(const void* input, float* output, size_t length, DataTypeId id) {
@@ -405,14 +1593,42 @@ bool dequantize_row(const void* input, float* output, size_t length, DataTypeId
     assert(length > 0);
     assert(id < TYPE_COUNT);
 
-    size_t stride = data_type_size(id);
-    assert(stride > 0);
+    return convert_row(input, id, output, TYPE_FLOAT32, length);
+}
 
-    for (size_t i = 0; i < length; ++i) {
-        const void* src = (const uint8_t*) input + i * stride;
-        if (!dequantize_scalar(src, &output[i], id)) {
-            return false;
-        }
+// Round-trip error
+
+bool quantize_row_error(const float* input, size_t length, DataTypeId id, QuantizeError* error) {
+    assert(input != NULL);
+    assert(error != NULL);
+    assert(length > 0);
+
+    size_t bytes = data_type_row_size(id, length);
+    void* quantized = memory_alloc(bytes, data_type_get(id) ? TYPES[id].alignment : 1);
+    float* restored = memory_alloc(length * sizeof(float), alignof(float));
+    if (!quantized || !restored || !quantize_row(input, quantized, length, id)
+        || !dequantize_row(quantized, restored, length, id)) {
+        memory_free(quantized);
+        memory_free(restored);
+        return false;
     }
+
+    double max_abs = 0.0;
+    double squared_error = 0.0;
+    double squared_input = 0.0;
+    for (size_t i = 0; i < length; i++) {
+        double e = fabs((double) restored[i] - (double) input[i]);
+        max_abs = e > max_abs ? e : max_abs;
+        squared_error += e * e;
+        squared_input += (double) input[i] * (double) input[i];
+    }
+
+    error->max_abs = max_abs;
+    error->rmse = sqrt(squared_error / (double) length);
+    error->relative_rmse = squared_input > 0.0 ? sqrt(squared_error / squared_input) : 0.0;
+    error->bytes = bytes;
+
+    memory_free(quantized);
+    memory_free(restored);
     return true;
 }
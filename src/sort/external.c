@@ -0,0 +1,877 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/sort/external.c
+ * @brief External merge sort for fixed-size record files larger than memory.
+ *
+ * Every stream (input, run or output) owns two aligned buffers and an optional worker thread.
+ * Readers keep one buffer in flight while the caller consumes the other; writers hand a full
+ * buffer to the worker and keep filling the second one. Runs live in unlinked temporary files
+ * so they are reclaimed by the kernel even if the process dies mid-sort.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE // O_DIRECT
+#endif
+
+#include "core/logger.h"
+#include "core/memory.h"
+#include "sort/external.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Private Definitions
+ */
+
+// Logical block size required for O_DIRECT buffers, offsets and lengths.
+#define EXTERNAL_SORT_BLOCK 4096
+
+typedef struct ExternalWorker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t* data; // Job buffer
+    size_t length; // Job length in bytes
+    off_t offset; // Job file offset
+    ssize_t result; // Bytes transferred or -1
+    int fd;
+    bool direct; // fd has O_DIRECT set
+    bool write; // Job direction
+    bool pending; // Job submitted and not yet complete
+    bool quit;
+    bool running; // Background thread is alive
+} ExternalWorker;
+
+typedef struct ExternalReader {
+    ExternalWorker worker;
+    uint8_t* buffer[2];
+    size_t capacity; // Bytes per buffer
+    size_t length; // Valid bytes in the front buffer
+    size_t cursor; // Consumed bytes in the front buffer
+    size_t requested; // Bytes expected from the in-flight read
+    off_t offset; // File offset of the next read
+    off_t end; // File offset one past the last byte
+    int front;
+    bool error;
+} ExternalReader;
+
+typedef struct ExternalWriter {
+    ExternalWorker worker;
+    uint8_t* buffer[2];
+    size_t capacity; // Bytes per buffer
+    size_t length; // Filled bytes in the front buffer
+    size_t submitted; // Bytes handed to the in-flight write
+    off_t offset; // File offset of the next write
+    int front;
+    bool error;
+} ExternalWriter;
+
+typedef struct ExternalRun {
+    int fd;
+    off_t length;
+} ExternalRun;
+
+typedef struct ExternalLoserTree {
+    size_t* node; // node[0] holds the winner, node[1..count-1] hold losers
+    const uint8_t** key; // Current record per leaf, NULL once exhausted
+    size_t count;
+    ExternalSortCompare compare;
+} ExternalLoserTree;
+
+typedef struct ExternalContext {
+    const ExternalSortConfig* config;
+    const char* temp_dir;
+    size_t capacity; // Bytes per I/O buffer
+    size_t fan_in; // Effective fan-in
+    bool direct; // Use O_DIRECT where the filesystem allows it
+    ExternalRun* runs;
+    size_t run_count;
+    size_t run_capacity;
+} ExternalContext;
+
+/**
+ * Private Functions: Raw I/O
+ */
+
+static bool external_set_direct(int fd, bool enable) {
+#ifdef O_DIRECT
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0) {
+        return false;
+    }
+    flags = enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+    return 0 == fcntl(fd, F_SETFL, flags);
+#else
+    (void) fd;
+    return !enable;
+#endif
+}
+
+static ssize_t external_read_full(int fd, uint8_t* data, size_t length, off_t offset, bool direct) {
+    size_t total = 0;
+    while (total < length) {
+        ssize_t n = pread(fd, data + total, length - total, offset + (off_t) total);
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return -1;
+        }
+        total += (size_t) n;
+        // A short direct read leaves an unaligned offset; it only happens at end of file.
+        if (0 == n || direct) {
+            break;
+        }
+    }
+    return (ssize_t) total;
+}
+
+static ssize_t
+external_write_full(int fd, const uint8_t* data, size_t length, off_t offset, bool direct) {
+    size_t total = 0;
+    while (total < length) {
+        size_t chunk = length - total;
+        if (direct && 0 != chunk % EXTERNAL_SORT_BLOCK) {
+            // Write the aligned prefix directly, then finish the tail through the page cache.
+            chunk -= chunk % EXTERNAL_SORT_BLOCK;
+            if (0 == chunk) {
+                external_set_direct(fd, false);
+                direct = false;
+                continue;
+            }
+        }
+
+        ssize_t n = pwrite(fd, data + total, chunk, offset + (off_t) total);
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return -1;
+        }
+        total += (size_t) n;
+    }
+    return (ssize_t) total;
+}
+
+static ssize_t external_worker_execute(ExternalWorker* worker) {
+    if (worker->write) {
+        return external_write_full(
+            worker->fd, worker->data, worker->length, worker->offset, worker->direct
+        );
+    }
+    return external_read_full(
+        worker->fd, worker->data, worker->length, worker->offset, worker->direct
+    );
+}
+
+/**
+ * Private Functions: Background Worker
+ */
+
+static void* external_worker_main(void* arg) {
+    ExternalWorker* worker = (ExternalWorker*) arg;
+
+    pthread_mutex_lock(&worker->lock);
+    for (;;) {
+        while (!worker->pending && !worker->quit) {
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        }
+        if (!worker->pending) {
+            break; // quit with no outstanding job
+        }
+
+        pthread_mutex_unlock(&worker->lock);
+        ssize_t result = external_worker_execute(worker);
+        pthread_mutex_lock(&worker->lock);
+
+        worker->result = result;
+        worker->pending = false;
+        pthread_cond_broadcast(&worker->cond);
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    return NULL;
+}
+
+static void external_worker_init(ExternalWorker* worker, int fd, bool direct, bool threaded) {
+    memset(worker, 0, sizeof(ExternalWorker));
+    worker->fd = fd;
+    worker->direct = direct;
+
+    if (!threaded) {
+        return;
+    }
+
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    if (0 == pthread_create(&worker->thread, NULL, external_worker_main, worker)) {
+        worker->running = true;
+    } else {
+        // Degrade to synchronous I/O rather than failing the sort.
+        pthread_cond_destroy(&worker->cond);
+        pthread_mutex_destroy(&worker->lock);
+    }
+}
+
+static void external_worker_submit(
+    ExternalWorker* worker, bool write, uint8_t* data, size_t length, off_t offset
+) {
+    if (!worker->running) {
+        worker->write = write;
+        worker->data = data;
+        worker->length = length;
+        worker->offset = offset;
+        worker->result = external_worker_execute(worker);
+        return;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    worker->write = write;
+    worker->data = data;
+    worker->length = length;
+    worker->offset = offset;
+    worker->pending = true;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+static ssize_t external_worker_wait(ExternalWorker* worker) {
+    if (!worker->running) {
+        return worker->result;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    while (worker->pending) {
+        pthread_cond_wait(&worker->cond, &worker->lock);
+    }
+    ssize_t result = worker->result;
+    pthread_mutex_unlock(&worker->lock);
+    return result;
+}
+
+static void external_worker_free(ExternalWorker* worker) {
+    if (!worker->running) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    worker->quit = true;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+
+    pthread_join(worker->thread, NULL);
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->lock);
+    worker->running = false;
+}
+
+/**
+ * Private Functions: Buffered Streams
+ */
+
+static bool external_buffers_alloc(uint8_t* buffer[2], size_t capacity) {
+    buffer[0] = memory_alloc(capacity, EXTERNAL_SORT_BLOCK);
+    buffer[1] = memory_alloc(capacity, EXTERNAL_SORT_BLOCK);
+    if (!buffer[0] || !buffer[1]) {
+        memory_free(buffer[0]);
+        memory_free(buffer[1]);
+        buffer[0] = buffer[1] = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void external_reader_prefetch(ExternalReader* reader) {
+    size_t remaining = (size_t) (reader->end - reader->offset);
+    size_t length = remaining < reader->capacity ? remaining : reader->capacity;
+    size_t request = length;
+    if (reader->worker.direct) {
+        // Direct reads must cover whole blocks; the kernel stops at end of file.
+        request = (size_t) memory_align_up(length, EXTERNAL_SORT_BLOCK);
+    }
+
+    reader->requested = length;
+    external_worker_submit(
+        &reader->worker, false, reader->buffer[reader->front ^ 1], request, reader->offset
+    );
+    reader->offset += (off_t) length;
+}
+
+static bool external_reader_fill(ExternalReader* reader) {
+    ssize_t result = external_worker_wait(&reader->worker);
+    if (result < 0 || (size_t) result < reader->requested) {
+        LOG_ERROR("[ExternalSort] Short read (expected=%zu, got=%zd)", reader->requested, result);
+        reader->error = true;
+        reader->length = reader->cursor = 0;
+        return false;
+    }
+
+    reader->front ^= 1;
+    reader->length = reader->requested;
+    reader->cursor = 0;
+
+    if (0 == reader->length) {
+        return false; // end of stream
+    }
+
+    external_reader_prefetch(reader);
+    return true;
+}
+
+static bool external_reader_open(
+    ExternalReader* reader, int fd, off_t length, size_t capacity, bool direct, bool threaded
+) {
+    memset(reader, 0, sizeof(ExternalReader));
+    if (!external_buffers_alloc(reader->buffer, capacity)) {
+        return false;
+    }
+
+    direct = direct && external_set_direct(fd, true);
+    external_worker_init(&reader->worker, fd, direct, threaded);
+
+    reader->capacity = capacity;
+    reader->end = length;
+    reader->front = 1; // first prefetch lands in buffer 0
+    external_reader_prefetch(reader);
+    external_reader_fill(reader);
+    return !reader->error;
+}
+
+static const uint8_t* external_reader_peek(ExternalReader* reader) {
+    if (reader->cursor == reader->length && !external_reader_fill(reader)) {
+        return NULL;
+    }
+    return reader->buffer[reader->front] + reader->cursor;
+}
+
+// Copies up to `length` bytes into `dst`, returning the number of bytes copied.
+static size_t external_reader_read(ExternalReader* reader, uint8_t* dst, size_t length) {
+    size_t total = 0;
+    while (total < length) {
+        const uint8_t* src = external_reader_peek(reader);
+        if (!src) {
+            break;
+        }
+        size_t available = reader->length - reader->cursor;
+        size_t chunk = (length - total) < available ? (length - total) : available;
+        memcpy(dst + total, src, chunk);
+        reader->cursor += chunk;
+        total += chunk;
+    }
+    return total;
+}
+
+static void external_reader_close(ExternalReader* reader) {
+    external_worker_wait(&reader->worker);
+    external_worker_free(&reader->worker);
+    memory_free(reader->buffer[0]);
+    memory_free(reader->buffer[1]);
+    reader->buffer[0] = reader->buffer[1] = NULL;
+}
+
+static bool
+external_writer_open(ExternalWriter* writer, int fd, size_t capacity, bool direct, bool threaded) {
+    memset(writer, 0, sizeof(ExternalWriter));
+    if (!external_buffers_alloc(writer->buffer, capacity)) {
+        return false;
+    }
+
+    direct = direct && external_set_direct(fd, true);
+    external_worker_init(&writer->worker, fd, direct, threaded);
+    writer->capacity = capacity;
+    return true;
+}
+
+static void external_writer_flush(ExternalWriter* writer) {
+    ssize_t result = external_worker_wait(&writer->worker);
+    if (result < 0 || (size_t) result != writer->submitted) {
+        writer->error = true;
+    }
+
+    writer->submitted = writer->length;
+    external_worker_submit(
+        &writer->worker, true, writer->buffer[writer->front], writer->length, writer->offset
+    );
+    writer->offset += (off_t) writer->length;
+    writer->front ^= 1;
+    writer->length = 0;
+}
+
+static void external_writer_write(ExternalWriter* writer, const uint8_t* src, size_t length) {
+    while (length > 0) {
+        if (writer->length == writer->capacity) {
+            external_writer_flush(writer);
+        }
+        size_t room = writer->capacity - writer->length;
+        size_t chunk = length < room ? length : room;
+        memcpy(writer->buffer[writer->front] + writer->length, src, chunk);
+        writer->length += chunk;
+        src += chunk;
+        length -= chunk;
+    }
+}
+
+// Flushes pending data and releases the buffers. Returns false on any write failure.
+static bool external_writer_close(ExternalWriter* writer) {
+    if (writer->length > 0) {
+        external_writer_flush(writer);
+    }
+
+    ssize_t result = external_worker_wait(&writer->worker);
+    if (result < 0 || (size_t) result != writer->submitted) {
+        writer->error = true;
+    }
+
+    external_worker_free(&writer->worker);
+    memory_free(writer->buffer[0]);
+    memory_free(writer->buffer[1]);
+    writer->buffer[0] = writer->buffer[1] = NULL;
+    return !writer->error;
+}
+
+/**
+ * Private Functions: Loser Tree
+ */
+
+// Leaf `count` is a sentinel that beats every record while the tree is being built.
+static bool external_tree_less(const ExternalLoserTree* tree, size_t a, size_t b) {
+    if (a == tree->count) {
+        return true;
+    }
+    if (b == tree->count) {
+        return false;
+    }
+    if (!tree->key[a]) {
+        return false; // exhausted runs lose to everything
+    }
+    if (!tree->key[b]) {
+        return true;
+    }
+
+    int cmp = tree->compare(tree->key[a], tree->key[b]);
+    return cmp != 0 ? cmp < 0 : a < b; // ties resolve by run order
+}
+
+// Replays the matches on the path from `leaf` to the root.
+static void external_tree_adjust(ExternalLoserTree* tree, size_t leaf) {
+    size_t winner = leaf;
+    for (size_t t = (leaf + tree->count) / 2; t > 0; t /= 2) {
+        if (external_tree_less(tree, tree->node[t], winner)) {
+            size_t tmp = tree->node[t];
+            tree->node[t] = winner;
+            winner = tmp;
+        }
+    }
+    tree->node[0] = winner;
+}
+
+static void external_tree_build(ExternalLoserTree* tree) {
+    for (size_t t = 0; t < tree->count; t++) {
+        tree->node[t] = tree->count;
+    }
+    for (size_t leaf = tree->count; leaf-- > 0;) {
+        external_tree_adjust(tree, leaf);
+    }
+}
+
+/**
+ * Private Functions: Runs
+ */
+
+static int external_temp_open(ExternalContext* ctx) {
+    static const char name[] = "/external-sort-XXXXXX";
+    size_t dir_length = strlen(ctx->temp_dir);
+    char* path = malloc(dir_length + sizeof(name));
+    if (!path) {
+        return -1;
+    }
+    memcpy(path, ctx->temp_dir, dir_length);
+    memcpy(path + dir_length, name, sizeof(name));
+
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path); // anonymous: reclaimed on close
+    } else {
+        LOG_ERROR("[ExternalSort] Failed to create run in '%s': %s", ctx->temp_dir, strerror(errno));
+    }
+
+    free(path);
+    return fd;
+}
+
+static bool external_run_push(ExternalContext* ctx, int fd, off_t length) {
+    if (ctx->run_count == ctx->run_capacity) {
+        size_t capacity = ctx->run_capacity ? ctx->run_capacity * 2 : 16;
+        ExternalRun* runs = realloc(ctx->runs, capacity * sizeof(ExternalRun));
+        if (!runs) {
+            return false;
+        }
+        ctx->runs = runs;
+        ctx->run_capacity = capacity;
+    }
+    ctx->runs[ctx->run_count++] = (ExternalRun){.fd = fd, .length = length};
+    return true;
+}
+
+static ExternalSortState external_spill(ExternalContext* ctx, const uint8_t* chunk, size_t length) {
+    int fd = external_temp_open(ctx);
+    if (fd < 0) {
+        return EXTERNAL_SORT_ERROR_IO;
+    }
+
+    ExternalWriter writer;
+    if (!external_writer_open(&writer, fd, ctx->capacity, ctx->direct, ctx->config->use_threads)) {
+        close(fd);
+        return EXTERNAL_SORT_ERROR_MEMORY;
+    }
+    external_writer_write(&writer, chunk, length);
+
+    if (!external_writer_close(&writer)) {
+        close(fd);
+        return EXTERNAL_SORT_ERROR_IO;
+    }
+
+    if (!external_run_push(ctx, fd, (off_t) length)) {
+        close(fd);
+        return EXTERNAL_SORT_ERROR_MEMORY;
+    }
+    return EXTERNAL_SORT_SUCCESS;
+}
+
+// Sorts budget-sized chunks of the input and spills each one as a run.
+static ExternalSortState external_generate_runs(ExternalContext* ctx, int fd, off_t size) {
+    const ExternalSortConfig* config = ctx->config;
+    size_t record_size = config->record_size;
+
+    // Input and run streams are double buffered; the remainder of the budget holds the chunk.
+    size_t chunk_bytes = config->memory_budget - 4 * ctx->capacity;
+    chunk_bytes -= chunk_bytes % record_size;
+    if ((off_t) chunk_bytes > size) {
+        chunk_bytes = (size_t) size;
+    }
+    if (0 == chunk_bytes) {
+        return EXTERNAL_SORT_SUCCESS; // empty input
+    }
+
+    uint8_t* chunk = memory_alloc(chunk_bytes, EXTERNAL_SORT_BLOCK);
+    if (!chunk) {
+        return EXTERNAL_SORT_ERROR_MEMORY;
+    }
+
+    ExternalSortState state = EXTERNAL_SORT_SUCCESS;
+    uint8_t* mapping = NULL;
+    ExternalReader reader = {0};
+
+    if (config->use_mmap) {
+        mapping = mmap(NULL, (size_t) size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == mapping) {
+            LOG_WARN("[ExternalSort] mmap failed, falling back to read: %s", strerror(errno));
+            mapping = NULL;
+        } else {
+            madvise(mapping, (size_t) size, MADV_SEQUENTIAL);
+        }
+    }
+
+    if (!mapping
+        && !external_reader_open(&reader, fd, size, ctx->capacity, ctx->direct, config->use_threads)) {
+        state = reader.buffer[0] ? EXTERNAL_SORT_ERROR_IO : EXTERNAL_SORT_ERROR_MEMORY;
+        goto cleanup;
+    }
+
+    for (off_t offset = 0; offset < size;) {
+        size_t length = chunk_bytes;
+        if ((off_t) length > size - offset) {
+            length = (size_t) (size - offset);
+        }
+
+        if (mapping) {
+            memcpy(chunk, mapping + offset, length);
+            // Pages behind the cursor will not be touched again.
+            madvise(
+                mapping + memory_align_down((uintptr_t) offset, EXTERNAL_SORT_BLOCK),
+                memory_align_down(length, EXTERNAL_SORT_BLOCK),
+                MADV_DONTNEED
+            );
+        } else if (external_reader_read(&reader, chunk, length) != length) {
+            state = EXTERNAL_SORT_ERROR_IO;
+            break;
+        }
+
+        qsort(chunk, length / record_size, record_size, config->compare);
+
+        state = external_spill(ctx, chunk, length);
+        if (EXTERNAL_SORT_SUCCESS != state) {
+            break;
+        }
+        offset += (off_t) length;
+    }
+
+cleanup:
+    if (mapping) {
+        munmap(mapping, (size_t) size);
+    } else if (reader.buffer[0]) {
+        external_reader_close(&reader);
+    }
+    memory_free(chunk);
+    return state;
+}
+
+// Merges `count` runs into `out_fd` and returns the number of bytes written through `length`.
+static ExternalSortState external_merge(
+    ExternalContext* ctx, const ExternalRun* runs, size_t count, int out_fd, off_t* length
+) {
+    const ExternalSortConfig* config = ctx->config;
+    size_t record_size = config->record_size;
+
+    ExternalReader* readers = calloc(count ? count : 1, sizeof(ExternalReader));
+    size_t* node = calloc(count ? count : 1, sizeof(size_t));
+    const uint8_t** key = calloc(count ? count : 1, sizeof(uint8_t*));
+    if (!readers || !node || !key) {
+        free(readers);
+        free(node);
+        free(key);
+        return EXTERNAL_SORT_ERROR_MEMORY;
+    }
+
+    ExternalSortState state = EXTERNAL_SORT_SUCCESS;
+    ExternalWriter writer;
+    bool writer_open = false;
+    size_t opened = 0;
+
+    for (; opened < count; opened++) {
+        if (!external_reader_open(
+                &readers[opened],
+                runs[opened].fd,
+                runs[opened].length,
+                ctx->capacity,
+                ctx->direct,
+                config->use_threads
+            )) {
+            state = readers[opened].buffer[0] ? EXTERNAL_SORT_ERROR_IO : EXTERNAL_SORT_ERROR_MEMORY;
+            if (readers[opened].buffer[0]) {
+                opened++; // close this one too
+            }
+            goto cleanup;
+        }
+        key[opened] = external_reader_peek(&readers[opened]);
+    }
+
+    if (!external_writer_open(&writer, out_fd, ctx->capacity, ctx->direct, config->use_threads)) {
+        state = EXTERNAL_SORT_ERROR_MEMORY;
+        goto cleanup;
+    }
+    writer_open = true;
+
+    ExternalLoserTree tree = {
+        .node = node,
+        .key = key,
+        .count = count,
+        .compare = config->compare,
+    };
+    external_tree_build(&tree);
+
+    off_t written = 0;
+    while (count > 0 && key[node[0]]) {
+        size_t winner = node[0];
+        external_writer_write(&writer, key[winner], record_size);
+        written += (off_t) record_size;
+
+        readers[winner].cursor += record_size;
+        key[winner] = external_reader_peek(&readers[winner]);
+        if (!key[winner] && readers[winner].error) {
+            state = EXTERNAL_SORT_ERROR_IO;
+            break;
+        }
+        external_tree_adjust(&tree, winner);
+    }
+    *length = written;
+
+cleanup:
+    if (writer_open && !external_writer_close(&writer) && EXTERNAL_SORT_SUCCESS == state) {
+        state = EXTERNAL_SORT_ERROR_IO;
+    }
+    for (size_t i = 0; i < opened; i++) {
+        external_reader_close(&readers[i]);
+    }
+    free(readers);
+    free(node);
+    free(key);
+    return state;
+}
+
+// Merges groups of `fan_in` runs until at most `fan_in` remain.
+static ExternalSortState external_merge_passes(ExternalContext* ctx) {
+    while (ctx->run_count > ctx->fan_in) {
+        ExternalRun* runs = ctx->runs;
+        size_t count = ctx->run_count;
+
+        ctx->runs = NULL;
+        ctx->run_count = ctx->run_capacity = 0;
+
+        ExternalSortState state = EXTERNAL_SORT_SUCCESS;
+        size_t i = 0;
+        for (; i < count && EXTERNAL_SORT_SUCCESS == state; i += ctx->fan_in) {
+            size_t group = (count - i) < ctx->fan_in ? (count - i) : ctx->fan_in;
+
+            int fd = external_temp_open(ctx);
+            if (fd < 0) {
+                state = EXTERNAL_SORT_ERROR_IO;
+                break;
+            }
+
+            off_t length = 0;
+            state = external_merge(ctx, &runs[i], group, fd, &length);
+            if (EXTERNAL_SORT_SUCCESS == state && !external_run_push(ctx, fd, length)) {
+                state = EXTERNAL_SORT_ERROR_MEMORY;
+            }
+            if (EXTERNAL_SORT_SUCCESS != state) {
+                close(fd);
+            }
+
+            for (size_t j = i; j < i + group; j++) {
+                close(runs[j].fd);
+            }
+        }
+
+        for (; i < count; i++) {
+            close(runs[i].fd);
+        }
+        free(runs);
+
+        if (EXTERNAL_SORT_SUCCESS != state) {
+            return state;
+        }
+    }
+    return EXTERNAL_SORT_SUCCESS;
+}
+
+static size_t external_gcd(size_t a, size_t b) {
+    while (b) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * Public Functions
+ */
+
+ExternalSortConfig external_sort_config(size_t record_size, ExternalSortCompare compare) {
+    return (ExternalSortConfig){
+        .compare = compare,
+        .record_size = record_size,
+        .memory_budget = EXTERNAL_SORT_MEMORY_BUDGET,
+        .io_buffer_size = EXTERNAL_SORT_IO_BUFFER,
+        .fan_in = EXTERNAL_SORT_FAN_IN,
+        .temp_dir = NULL,
+        .use_mmap = false,
+        .use_direct_io = false,
+        .use_threads = true,
+    };
+}
+
+ExternalSortState external_sort_file(
+    const char* input_path, const char* output_path, const ExternalSortConfig* config
+) {
+    if (!input_path || !output_path || !config || !config->compare || 0 == config->record_size
+        || config->fan_in < 2 || 0 == config->io_buffer_size) {
+        LOG_ERROR("[ExternalSort] Invalid arguments.");
+        return EXTERNAL_SORT_ERROR_ARGUMENT;
+    }
+
+    ExternalContext ctx = {.config = config};
+    ctx.temp_dir = config->temp_dir ? config->temp_dir : getenv("TMPDIR");
+    if (!ctx.temp_dir || !*ctx.temp_dir) {
+        ctx.temp_dir = "/tmp";
+    }
+
+    // Buffers hold whole records; direct I/O additionally needs whole blocks.
+    size_t record_size = config->record_size;
+    size_t unit = record_size;
+    ctx.direct = config->use_direct_io;
+    if (ctx.direct) {
+        size_t lcm = record_size / external_gcd(record_size, EXTERNAL_SORT_BLOCK)
+                     * EXTERNAL_SORT_BLOCK;
+        if (lcm <= config->io_buffer_size) {
+            unit = lcm;
+        } else {
+            LOG_WARN("[ExternalSort] Record size %zu is incompatible with O_DIRECT.", record_size);
+            ctx.direct = false;
+        }
+    }
+    ctx.capacity = config->io_buffer_size / unit * unit;
+    if (ctx.capacity < unit) {
+        ctx.capacity = unit;
+    }
+
+    // Run generation needs 4 buffers plus a chunk; merging needs 2 per run plus 2 for output.
+    if (config->memory_budget < 6 * ctx.capacity) {
+        LOG_ERROR(
+            "[ExternalSort] Memory budget %zu is below 6 I/O buffers of %zu bytes.",
+            config->memory_budget,
+            ctx.capacity
+        );
+        return EXTERNAL_SORT_ERROR_ARGUMENT;
+    }
+    ctx.fan_in = config->memory_budget / (2 * ctx.capacity) - 1;
+    if (ctx.fan_in > config->fan_in) {
+        ctx.fan_in = config->fan_in;
+    }
+
+    int in_fd = open(input_path, O_RDONLY);
+    if (in_fd < 0) {
+        LOG_ERROR("[ExternalSort] Failed to open '%s': %s", input_path, strerror(errno));
+        return EXTERNAL_SORT_ERROR_IO;
+    }
+
+    struct stat st;
+    if (0 != fstat(in_fd, &st)) {
+        close(in_fd);
+        return EXTERNAL_SORT_ERROR_IO;
+    }
+    if (0 != (size_t) st.st_size % record_size) {
+        LOG_ERROR(
+            "[ExternalSort] Input size %jd is not a multiple of %zu.", (intmax_t) st.st_size, record_size
+        );
+        close(in_fd);
+        return EXTERNAL_SORT_ERROR_FORMAT;
+    }
+
+    ExternalSortState state = external_generate_runs(&ctx, in_fd, st.st_size);
+    close(in_fd);
+
+    if (EXTERNAL_SORT_SUCCESS == state) {
+        state = external_merge_passes(&ctx);
+    }
+
+    if (EXTERNAL_SORT_SUCCESS == state) {
+        int out_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out_fd < 0) {
+            LOG_ERROR("[ExternalSort] Failed to open '%s': %s", output_path, strerror(errno));
+            state = EXTERNAL_SORT_ERROR_IO;
+        } else {
+            off_t length = 0;
+            state = external_merge(&ctx, ctx.runs, ctx.run_count, out_fd, &length);
+            if (0 != close(out_fd) && EXTERNAL_SORT_SUCCESS == state) {
+                state = EXTERNAL_SORT_ERROR_IO;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < ctx.run_count; i++) {
+        close(ctx.runs[i].fd);
+    }
+    free(ctx.runs);
+    return state;
+}
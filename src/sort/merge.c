@@ -0,0 +1,697 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/sort/merge.c
+ * @brief Stable, adaptive natural merge sort (timsort-style) for fixed-size records.
+ *
+ * @ref Tim Peters, "listsort.txt", CPython Objects/
+ * @ref de Gouw et al., "OpenJDK's java.utils.Collection.sort() is broken" (2015), for the
+ * corrected run stack invariant.
+ */
+
+#include "core/memory.h"
+#include "sort/merge.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Runs shorter than this are extended with binary insertion sort.
+#define MERGE_MIN_RUN 32
+
+// Initial number of consecutive wins before a merge switches to galloping.
+#define MERGE_MIN_GALLOP 7
+
+// Enough pending runs for 2^64 elements under the stack invariants.
+#define MERGE_MAX_PENDING 85
+
+typedef struct MergeRun {
+    size_t base; // Index of the first record
+    size_t length; // Number of records
+} MergeRun;
+
+typedef struct MergeState {
+    uint8_t* base;
+    size_t size;
+    MergeSortCompare compare;
+
+    uint8_t* buffer;
+    size_t buffer_count; // Records that fit in the buffer
+    size_t buffer_limit; // Records the buffer may grow to (0 for caller-owned buffers)
+
+    size_t min_gallop;
+    MergeRun run[MERGE_MAX_PENDING];
+    size_t runs;
+} MergeState;
+
+/**
+ * Private Functions: Record Primitives
+ */
+
+static inline uint8_t* merge_at(const MergeState* ms, uint8_t* p, ptrdiff_t i) {
+    return p + i * (ptrdiff_t) ms->size;
+}
+
+static inline bool merge_less(const MergeState* ms, const uint8_t* a, const uint8_t* b) {
+    return ms->compare(a, b) < 0;
+}
+
+static inline void merge_copy(const MergeState* ms, uint8_t* dst, const uint8_t* src, size_t n) {
+    memcpy(dst, src, n * ms->size);
+}
+
+static inline void merge_move(const MergeState* ms, uint8_t* dst, const uint8_t* src, size_t n) {
+    memmove(dst, src, n * ms->size);
+}
+
+static void merge_swap(const MergeState* ms, uint8_t* a, uint8_t* b) {
+    for (size_t i = 0; i < ms->size; i++) {
+        uint8_t t = a[i];
+        a[i] = b[i];
+        b[i] = t;
+    }
+}
+
+// Reverses `n` records starting at `p`.
+static void merge_reverse(const MergeState* ms, uint8_t* p, size_t n) {
+    if (n < 2) {
+        return;
+    }
+    uint8_t* lo = p;
+    uint8_t* hi = merge_at(ms, p, (ptrdiff_t) n - 1);
+    while (lo < hi) {
+        merge_swap(ms, lo, hi);
+        lo += ms->size;
+        hi -= ms->size;
+    }
+}
+
+// Exchanges the `na` records at `p` with the `nb` records that follow them.
+static void merge_rotate(const MergeState* ms, uint8_t* p, size_t na, size_t nb) {
+    merge_reverse(ms, p, na);
+    merge_reverse(ms, merge_at(ms, p, (ptrdiff_t) na), nb);
+    merge_reverse(ms, p, na + nb);
+}
+
+// Makes room for `n` records, growing an owned buffer when allowed.
+static bool merge_reserve(MergeState* ms, size_t n) {
+    if (n <= ms->buffer_count) {
+        return true;
+    }
+    if (n > ms->buffer_limit) {
+        return false;
+    }
+
+    // Grow geometrically so a long sequence of merges reallocates O(log n) times.
+    size_t count = ms->buffer_count * 2 > n ? ms->buffer_count * 2 : n;
+    if (count > ms->buffer_limit) {
+        count = ms->buffer_limit;
+    }
+
+    uint8_t* buffer = memory_alloc(count * ms->size, alignof(max_align_t));
+    if (!buffer) {
+        ms->buffer_limit = ms->buffer_count; // stop trying; rotate instead
+        return false;
+    }
+
+    memory_free(ms->buffer);
+    ms->buffer = buffer;
+    ms->buffer_count = count;
+    return true;
+}
+
+/**
+ * Private Functions: Galloping Search
+ *
+ * Both searches start at `hint` and probe at offsets 1, 3, 7, ... before finishing with a
+ * binary search, so a key near the hint is found in O(log distance) comparisons.
+ */
+
+// Leftmost insertion point of `key` in sorted `a[0..n)`: a[k - 1] < key <= a[k].
+static size_t
+merge_gallop_left(const MergeState* ms, const uint8_t* key, uint8_t* a, size_t n, size_t hint) {
+    ptrdiff_t ofs = 1;
+    ptrdiff_t last = 0;
+    ptrdiff_t h = (ptrdiff_t) hint;
+    uint8_t* p = merge_at(ms, a, h);
+
+    if (merge_less(ms, p, key)) {
+        // a[hint] < key: gallop right until a[hint + last] < key <= a[hint + ofs].
+        ptrdiff_t max = (ptrdiff_t) n - h;
+        while (ofs < max && merge_less(ms, merge_at(ms, p, ofs), key)) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > max) {
+            ofs = max;
+        }
+        last += h;
+        ofs += h;
+    } else {
+        // key <= a[hint]: gallop left until a[hint - ofs] < key <= a[hint - last].
+        ptrdiff_t max = h + 1;
+        while (ofs < max && !merge_less(ms, merge_at(ms, p, -ofs), key)) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > max) {
+            ofs = max;
+        }
+        ptrdiff_t k = last;
+        last = h - ofs;
+        ofs = h - k;
+    }
+
+    // a[last] < key <= a[ofs], with last possibly -1.
+    last++;
+    while (last < ofs) {
+        ptrdiff_t m = last + ((ofs - last) >> 1);
+        if (merge_less(ms, merge_at(ms, a, m), key)) {
+            last = m + 1;
+        } else {
+            ofs = m;
+        }
+    }
+    return (size_t) ofs;
+}
+
+// Rightmost insertion point of `key` in sorted `a[0..n)`: a[k - 1] <= key < a[k].
+static size_t
+merge_gallop_right(const MergeState* ms, const uint8_t* key, uint8_t* a, size_t n, size_t hint) {
+    ptrdiff_t ofs = 1;
+    ptrdiff_t last = 0;
+    ptrdiff_t h = (ptrdiff_t) hint;
+    uint8_t* p = merge_at(ms, a, h);
+
+    if (merge_less(ms, key, p)) {
+        // key < a[hint]: gallop left until a[hint - ofs] <= key < a[hint - last].
+        ptrdiff_t max = h + 1;
+        while (ofs < max && merge_less(ms, key, merge_at(ms, p, -ofs))) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > max) {
+            ofs = max;
+        }
+        ptrdiff_t k = last;
+        last = h - ofs;
+        ofs = h - k;
+    } else {
+        // a[hint] <= key: gallop right until a[hint + last] <= key < a[hint + ofs].
+        ptrdiff_t max = (ptrdiff_t) n - h;
+        while (ofs < max && !merge_less(ms, key, merge_at(ms, p, ofs))) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > max) {
+            ofs = max;
+        }
+        last += h;
+        ofs += h;
+    }
+
+    // a[last] <= key < a[ofs], with last possibly -1.
+    last++;
+    while (last < ofs) {
+        ptrdiff_t m = last + ((ofs - last) >> 1);
+        if (merge_less(ms, key, merge_at(ms, a, m))) {
+            ofs = m;
+        } else {
+            last = m + 1;
+        }
+    }
+    return (size_t) ofs;
+}
+
+/**
+ * Private Functions: Runs
+ */
+
+// Length of the run starting at `lo`; strictly descending runs are reversed in place.
+static size_t merge_count_run(const MergeState* ms, uint8_t* lo, size_t n) {
+    if (n < 2) {
+        return n;
+    }
+
+    size_t i = 2;
+    if (merge_less(ms, merge_at(ms, lo, 1), lo)) {
+        // Strictly descending, so reversing cannot reorder equal records.
+        while (i < n && merge_less(ms, merge_at(ms, lo, (ptrdiff_t) i), merge_at(ms, lo, (ptrdiff_t) i - 1))) {
+            i++;
+        }
+        merge_reverse(ms, lo, i);
+    } else {
+        while (i < n && !merge_less(ms, merge_at(ms, lo, (ptrdiff_t) i), merge_at(ms, lo, (ptrdiff_t) i - 1))) {
+            i++;
+        }
+    }
+    return i;
+}
+
+// Sorts `lo[0..n)` given that `lo[0..sorted)` is already sorted.
+static void merge_binary_insertion(MergeState* ms, uint8_t* lo, size_t n, size_t sorted) {
+    // The merge buffer is idle during run formation, so it can hold the pivot.
+    bool spare = merge_reserve(ms, 1);
+
+    for (size_t i = sorted; i < n; i++) {
+        uint8_t* pivot = merge_at(ms, lo, (ptrdiff_t) i);
+
+        // Rightmost position keeps equal records in input order.
+        size_t left = 0;
+        size_t right = i;
+        while (left < right) {
+            size_t mid = left + ((right - left) >> 1);
+            if (merge_less(ms, pivot, merge_at(ms, lo, (ptrdiff_t) mid))) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
+        }
+
+        if (left == i) {
+            continue;
+        }
+
+        uint8_t* dst = merge_at(ms, lo, (ptrdiff_t) left);
+        if (spare) {
+            merge_copy(ms, ms->buffer, pivot, 1);
+            merge_move(ms, merge_at(ms, dst, 1), dst, i - left);
+            merge_copy(ms, dst, ms->buffer, 1);
+        } else {
+            merge_rotate(ms, dst, i - left, 1);
+        }
+    }
+}
+
+static size_t merge_min_run(size_t n) {
+    size_t r = 0;
+    while (n >= MERGE_MIN_RUN * 2) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/**
+ * Private Functions: Merging
+ */
+
+/**
+ * Merges `a[0..na)` with the adjacent `b[0..nb)`, with `na <= nb` and `na` records of buffer.
+ *
+ * Requires b[0] < a[0] and b[nb - 1] < a[na - 1] (established by trimming with gallops), so the
+ * first output comes from B and the last from A.
+ */
+static void merge_lo(MergeState* ms, uint8_t* a, size_t na, uint8_t* b, size_t nb) {
+    size_t size = ms->size;
+    uint8_t* dest = a;
+    merge_copy(ms, ms->buffer, a, na);
+    a = ms->buffer;
+
+    merge_copy(ms, dest, b, 1);
+    dest += size;
+    b += size;
+    if (0 == --nb) {
+        goto succeed;
+    }
+    if (1 == na) {
+        goto copy_b;
+    }
+
+    size_t min_gallop = ms->min_gallop;
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        // One record at a time until a side wins min_gallop times in a row.
+        for (;;) {
+            if (merge_less(ms, b, a)) {
+                merge_copy(ms, dest, b, 1);
+                dest += size;
+                b += size;
+                bcount++;
+                acount = 0;
+                if (0 == --nb) {
+                    goto succeed;
+                }
+                if (bcount >= min_gallop) {
+                    break;
+                }
+            } else {
+                merge_copy(ms, dest, a, 1);
+                dest += size;
+                a += size;
+                acount++;
+                bcount = 0;
+                if (1 == --na) {
+                    goto copy_b;
+                }
+                if (acount >= min_gallop) {
+                    break;
+                }
+            }
+        }
+
+        // Galloping: copy whole stretches while they stay long.
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            ms->min_gallop = min_gallop;
+
+            size_t k = merge_gallop_right(ms, b, a, na, 0);
+            acount = k;
+            if (k) {
+                merge_copy(ms, dest, a, k);
+                dest += k * size;
+                a += k * size;
+                na -= k;
+                if (1 == na) {
+                    goto copy_b;
+                }
+                if (0 == na) {
+                    goto succeed; // unreachable for a consistent comparator
+                }
+            }
+            merge_copy(ms, dest, b, 1);
+            dest += size;
+            b += size;
+            if (0 == --nb) {
+                goto succeed;
+            }
+
+            k = merge_gallop_left(ms, a, b, nb, 0);
+            bcount = k;
+            if (k) {
+                merge_move(ms, dest, b, k);
+                dest += k * size;
+                b += k * size;
+                nb -= k;
+                if (0 == nb) {
+                    goto succeed;
+                }
+            }
+            merge_copy(ms, dest, a, 1);
+            dest += size;
+            a += size;
+            if (1 == --na) {
+                goto copy_b;
+            }
+        } while (acount >= MERGE_MIN_GALLOP || bcount >= MERGE_MIN_GALLOP);
+        min_gallop++;
+        ms->min_gallop = min_gallop;
+    }
+
+succeed:
+    if (na) {
+        merge_copy(ms, dest, a, na);
+    }
+    return;
+
+copy_b:
+    // The last record of A belongs after everything left in B.
+    merge_move(ms, dest, b, nb);
+    merge_copy(ms, dest + nb * size, a, 1);
+}
+
+/**
+ * Merges `a[0..na)` with the adjacent `b[0..nb)`, with `nb <= na` and `nb` records of buffer.
+ *
+ * Same preconditions as merge_lo, but fills the destination from the right.
+ */
+static void merge_hi(MergeState* ms, uint8_t* a, size_t na, uint8_t* b, size_t nb) {
+    size_t size = ms->size;
+    uint8_t* base_a = a;
+    uint8_t* base_b = ms->buffer;
+    uint8_t* dest = b + (nb - 1) * size;
+    merge_copy(ms, ms->buffer, b, nb);
+    b = base_b + (nb - 1) * size;
+    a += (na - 1) * size;
+
+    merge_copy(ms, dest, a, 1);
+    dest -= size;
+    a -= size;
+    if (0 == --na) {
+        goto succeed;
+    }
+    if (1 == nb) {
+        goto copy_a;
+    }
+
+    size_t min_gallop = ms->min_gallop;
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        for (;;) {
+            if (merge_less(ms, b, a)) {
+                merge_copy(ms, dest, a, 1);
+                dest -= size;
+                a -= size;
+                acount++;
+                bcount = 0;
+                if (0 == --na) {
+                    goto succeed;
+                }
+                if (acount >= min_gallop) {
+                    break;
+                }
+            } else {
+                merge_copy(ms, dest, b, 1);
+                dest -= size;
+                b -= size;
+                bcount++;
+                acount = 0;
+                if (1 == --nb) {
+                    goto copy_a;
+                }
+                if (bcount >= min_gallop) {
+                    break;
+                }
+            }
+        }
+
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            ms->min_gallop = min_gallop;
+
+            size_t k = na - merge_gallop_right(ms, b, base_a, na, na - 1);
+            acount = k;
+            if (k) {
+                dest -= k * size;
+                a -= k * size;
+                merge_move(ms, dest + size, a + size, k);
+                na -= k;
+                if (0 == na) {
+                    goto succeed;
+                }
+            }
+            merge_copy(ms, dest, b, 1);
+            dest -= size;
+            b -= size;
+            if (1 == --nb) {
+                goto copy_a;
+            }
+
+            k = nb - merge_gallop_left(ms, a, base_b, nb, nb - 1);
+            bcount = k;
+            if (k) {
+                dest -= k * size;
+                b -= k * size;
+                merge_copy(ms, dest + size, b + size, k);
+                nb -= k;
+                if (1 == nb) {
+                    goto copy_a;
+                }
+                if (0 == nb) {
+                    goto succeed; // unreachable for a consistent comparator
+                }
+            }
+            merge_copy(ms, dest, a, 1);
+            dest -= size;
+            a -= size;
+            if (0 == --na) {
+                goto succeed;
+            }
+        } while (acount >= MERGE_MIN_GALLOP || bcount >= MERGE_MIN_GALLOP);
+        min_gallop++;
+        ms->min_gallop = min_gallop;
+    }
+
+succeed:
+    if (nb) {
+        merge_copy(ms, dest - (nb - 1) * size, base_b, nb);
+    }
+    return;
+
+copy_a:
+    // The first record of B belongs before everything left in A.
+    dest -= na * size;
+    a -= na * size;
+    merge_move(ms, dest + size, a + size, na);
+    merge_copy(ms, dest, b, 1);
+}
+
+// Stably merges the adjacent sorted ranges `a[0..na)` and `a[na..na + nb)`.
+static void merge_runs(MergeState* ms, uint8_t* a, size_t na, size_t nb) {
+    if (0 == na || 0 == nb) {
+        return;
+    }
+
+    uint8_t* b = merge_at(ms, a, (ptrdiff_t) na);
+
+    // Records of A already below B[0], and of B already above A's last, stay put.
+    size_t k = merge_gallop_right(ms, b, a, na, 0);
+    a = merge_at(ms, a, (ptrdiff_t) k);
+    na -= k;
+    if (0 == na) {
+        return;
+    }
+    nb = merge_gallop_left(ms, merge_at(ms, a, (ptrdiff_t) na - 1), b, nb, nb - 1);
+    if (0 == nb) {
+        return;
+    }
+
+    size_t shorter = na <= nb ? na : nb;
+    if (merge_reserve(ms, shorter)) {
+        if (na <= nb) {
+            merge_lo(ms, a, na, b, nb);
+        } else {
+            merge_hi(ms, a, na, b, nb);
+        }
+        return;
+    }
+
+    // Buffer too small: split the longer side in half, rotate, and merge the two halves.
+    size_t na1;
+    size_t nb1;
+    if (na >= nb) {
+        na1 = na / 2;
+        nb1 = merge_gallop_left(ms, merge_at(ms, a, (ptrdiff_t) na1), b, nb, 0);
+    } else {
+        nb1 = nb / 2;
+        na1 = merge_gallop_right(ms, merge_at(ms, b, (ptrdiff_t) nb1), a, na, 0);
+    }
+
+    merge_rotate(ms, merge_at(ms, a, (ptrdiff_t) na1), na - na1, nb1);
+    merge_runs(ms, a, na1, nb1);
+    merge_runs(ms, merge_at(ms, a, (ptrdiff_t) (na1 + nb1)), na - na1, nb - nb1);
+}
+
+// Merges pending runs i and i + 1.
+static void merge_pending(MergeState* ms, size_t i) {
+    MergeRun a = ms->run[i];
+    MergeRun b = ms->run[i + 1];
+
+    ms->run[i].length = a.length + b.length;
+    if (i == ms->runs - 3) {
+        ms->run[i + 1] = ms->run[i + 2];
+    }
+    ms->runs--;
+
+    merge_runs(ms, merge_at(ms, ms->base, (ptrdiff_t) a.base), a.length, b.length);
+}
+
+// Restores the stack invariants: len[n-2] > len[n-1] + len[n] and len[n-1] > len[n].
+static void merge_collapse(MergeState* ms) {
+    MergeRun* p = ms->run;
+    while (ms->runs > 1) {
+        size_t n = ms->runs - 2;
+        if ((n > 0 && p[n - 1].length <= p[n].length + p[n + 1].length)
+            || (n > 1 && p[n - 2].length <= p[n - 1].length + p[n].length)) {
+            if (p[n - 1].length < p[n + 1].length) {
+                n--;
+            }
+            merge_pending(ms, n);
+        } else if (p[n].length <= p[n + 1].length) {
+            merge_pending(ms, n);
+        } else {
+            break;
+        }
+    }
+}
+
+static void merge_force_collapse(MergeState* ms) {
+    MergeRun* p = ms->run;
+    while (ms->runs > 1) {
+        size_t n = ms->runs - 2;
+        if (n > 0 && p[n - 1].length < p[n + 1].length) {
+            n--;
+        }
+        merge_pending(ms, n);
+    }
+}
+
+static void merge_sort_state(MergeState* ms, size_t count) {
+    size_t min_run = merge_min_run(count);
+    size_t lo = 0;
+
+    while (lo < count) {
+        uint8_t* p = merge_at(ms, ms->base, (ptrdiff_t) lo);
+        size_t remaining = count - lo;
+        size_t n = merge_count_run(ms, p, remaining);
+
+        // Extend short natural runs to min_run with insertion sort.
+        if (n < min_run) {
+            size_t forced = remaining < min_run ? remaining : min_run;
+            merge_binary_insertion(ms, p, forced, n);
+            n = forced;
+        }
+
+        ms->run[ms->runs++] = (MergeRun){.base = lo, .length = n};
+        merge_collapse(ms);
+        lo += n;
+    }
+
+    merge_force_collapse(ms);
+}
+
+/**
+ * Public Functions
+ */
+
+void merge_sort(void* base, size_t count, size_t size, MergeSortCompare compare) {
+    assert(base != NULL || 0 == count);
+    assert(size > 0);
+    assert(compare != NULL);
+
+    if (count < 2) {
+        return;
+    }
+
+    MergeState ms = {
+        .base = (uint8_t*) base,
+        .size = size,
+        .compare = compare,
+        .buffer_limit = count / 2,
+        .min_gallop = MERGE_MIN_GALLOP,
+    };
+
+    merge_sort_state(&ms, count);
+    memory_free(ms.buffer);
+}
+
+void merge_sort_buffer(
+    void* base, size_t count, size_t size, MergeSortCompare compare, void* buffer, size_t buffer_size
+) {
+    assert(base != NULL || 0 == count);
+    assert(size > 0);
+    assert(compare != NULL);
+    assert(buffer != NULL || 0 == buffer_size);
+
+    if (count < 2) {
+        return;
+    }
+
+    MergeState ms = {
+        .base = (uint8_t*) base,
+        .size = size,
+        .compare = compare,
+        .buffer = (uint8_t*) buffer,
+        .buffer_count = buffer_size / size,
+        .buffer_limit = 0,
+        .min_gallop = MERGE_MIN_GALLOP,
+    };
+
+    merge_sort_state(&ms, count);
+}
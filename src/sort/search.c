@@ -0,0 +1,232 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/sort/search.c
+ * @brief Cache-friendly static search layouts for sorted `int32_t` arrays.
+ *
+ * @ref Khuong and Morin, "Array Layouts for Comparison-Based Searching" (2017)
+ * @ref https://en.algorithmica.org/hpc/data-structures/s-tree/
+ */
+
+#include "core/memory.h"
+#include "sort/search.h"
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// Keys are allocated on cache-line boundaries so one prefetch or node load hits one line.
+#define SEARCH_ALIGNMENT 64
+
+// A prefetch of `keys + k * SEARCH_PREFETCH` fetches the 16 descendants four levels below `k`.
+#define SEARCH_PREFETCH 16
+
+/**
+ * Private Functions: Eytzinger
+ */
+
+// In-order traversal of the implicit tree assigns the sorted keys to BFS slots.
+static void
+search_eytzinger_build(SearchEytzinger* tree, const int32_t* sorted, size_t* next, size_t k) {
+    if (k > tree->count) {
+        return;
+    }
+    search_eytzinger_build(tree, sorted, next, 2 * k);
+    tree->keys[k] = sorted[*next];
+    tree->ranks[k] = (uint32_t) *next;
+    (*next)++;
+    search_eytzinger_build(tree, sorted, next, 2 * k + 1);
+}
+
+/**
+ * The descent records every turn in the bits of `k`: a right turn appends a 1. The answer is the
+ * last node where we went left, recovered by stripping the trailing right turns and that left
+ * turn. Running off the tree with only right turns leaves 0, meaning no key qualified.
+ */
+static inline size_t search_eytzinger_resolve(const SearchEytzinger* tree, size_t k) {
+    k >>= __builtin_ctzll(~(unsigned long long) k) + 1;
+    return k ? tree->ranks[k] : tree->count;
+}
+
+/**
+ * Private Functions: S-tree
+ */
+
+static inline size_t search_tree_child(size_t k, size_t i) {
+    return k * (SEARCH_TREE_BLOCK + 1) + i + 1;
+}
+
+static void search_tree_build(SearchTree* tree, const int32_t* sorted, size_t* next, size_t k) {
+    if (k >= tree->blocks) {
+        return;
+    }
+    for (size_t i = 0; i <= SEARCH_TREE_BLOCK; i++) {
+        search_tree_build(tree, sorted, next, search_tree_child(k, i));
+        if (i < SEARCH_TREE_BLOCK) {
+            size_t slot = k * SEARCH_TREE_BLOCK + i;
+            if (*next < tree->count) {
+                tree->keys[slot] = sorted[*next];
+                tree->ranks[slot] = (uint32_t) *next;
+                (*next)++;
+            } else {
+                tree->keys[slot] = INT32_MAX;
+                tree->ranks[slot] = (uint32_t) tree->count;
+            }
+        }
+    }
+}
+
+// Number of keys in the node less than `key` (lower) or less than or equal to `key` (upper).
+static inline size_t search_tree_rank(const int32_t* node, int32_t key, bool upper) {
+#if defined(__SSE2__)
+    __m128i x = _mm_set1_epi32(key);
+    __m128i v0 = _mm_load_si128((const __m128i*) node);
+    __m128i v1 = _mm_load_si128((const __m128i*) node + 1);
+    __m128i v2 = _mm_load_si128((const __m128i*) node + 2);
+    __m128i v3 = _mm_load_si128((const __m128i*) node + 3);
+
+    __m128i c0, c1, c2, c3;
+    if (upper) {
+        // node > key; everything else is <= key.
+        c0 = _mm_cmpgt_epi32(v0, x);
+        c1 = _mm_cmpgt_epi32(v1, x);
+        c2 = _mm_cmpgt_epi32(v2, x);
+        c3 = _mm_cmpgt_epi32(v3, x);
+    } else {
+        // node < key.
+        c0 = _mm_cmpgt_epi32(x, v0);
+        c1 = _mm_cmpgt_epi32(x, v1);
+        c2 = _mm_cmpgt_epi32(x, v2);
+        c3 = _mm_cmpgt_epi32(x, v3);
+    }
+
+    // Saturating packs keep the all-ones/all-zeros lanes, giving one mask bit per key.
+    __m128i packed = _mm_packs_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+    size_t bits = (size_t) __builtin_popcount((unsigned) _mm_movemask_epi8(packed));
+    return upper ? SEARCH_TREE_BLOCK - bits : bits;
+#else
+    size_t n = 0;
+    for (size_t i = 0; i < SEARCH_TREE_BLOCK; i++) {
+        n += upper ? node[i] <= key : node[i] < key;
+    }
+    return n;
+#endif
+}
+
+static inline size_t search_tree_descend(const SearchTree* tree, int32_t key, bool upper) {
+    // Remember the slot and read its rank once at the end; ranks live in separate lines.
+    size_t slot = SIZE_MAX;
+    size_t k = 0;
+    while (k < tree->blocks) {
+        size_t i = search_tree_rank(tree->keys + k * SEARCH_TREE_BLOCK, key, upper);
+        slot = i < SEARCH_TREE_BLOCK ? k * SEARCH_TREE_BLOCK + i : slot;
+        k = search_tree_child(k, i);
+    }
+    return SIZE_MAX == slot ? tree->count : tree->ranks[slot];
+}
+
+/**
+ * Public Functions: Eytzinger
+ */
+
+SearchEytzinger* search_eytzinger_create(const int32_t* sorted, size_t count) {
+    if ((!sorted && count > 0) || count >= UINT32_MAX) {
+        return NULL;
+    }
+
+    SearchEytzinger* tree = memory_alloc(sizeof(SearchEytzinger), alignof(SearchEytzinger));
+    if (!tree) {
+        return NULL;
+    }
+
+    tree->count = count;
+    tree->keys = memory_alloc((count + 1) * sizeof(int32_t), SEARCH_ALIGNMENT);
+    tree->ranks = memory_alloc((count + 1) * sizeof(uint32_t), alignof(uint32_t));
+    if (!tree->keys || !tree->ranks) {
+        search_eytzinger_free(tree);
+        return NULL;
+    }
+
+    tree->keys[0] = INT32_MIN;
+    tree->ranks[0] = (uint32_t) count;
+
+    size_t next = 0;
+    search_eytzinger_build(tree, sorted, &next, 1);
+    return tree;
+}
+
+void search_eytzinger_free(SearchEytzinger* tree) {
+    if (tree) {
+        memory_free(tree->keys);
+        memory_free(tree->ranks);
+        memory_free(tree);
+    }
+}
+
+size_t search_eytzinger_lower_bound(const SearchEytzinger* tree, int32_t key) {
+    const int32_t* keys = tree->keys;
+    size_t n = tree->count;
+    size_t k = 1;
+    while (k <= n) {
+        __builtin_prefetch(keys + k * SEARCH_PREFETCH);
+        k = 2 * k + (keys[k] < key);
+    }
+    return search_eytzinger_resolve(tree, k);
+}
+
+size_t search_eytzinger_upper_bound(const SearchEytzinger* tree, int32_t key) {
+    const int32_t* keys = tree->keys;
+    size_t n = tree->count;
+    size_t k = 1;
+    while (k <= n) {
+        __builtin_prefetch(keys + k * SEARCH_PREFETCH);
+        k = 2 * k + (keys[k] <= key);
+    }
+    return search_eytzinger_resolve(tree, k);
+}
+
+/**
+ * Public Functions: S-tree
+ */
+
+SearchTree* search_tree_create(const int32_t* sorted, size_t count) {
+    if ((!sorted && count > 0) || count >= UINT32_MAX) {
+        return NULL;
+    }
+
+    SearchTree* tree = memory_alloc(sizeof(SearchTree), alignof(SearchTree));
+    if (!tree) {
+        return NULL;
+    }
+
+    tree->count = count;
+    tree->blocks = (count + SEARCH_TREE_BLOCK - 1) / SEARCH_TREE_BLOCK;
+
+    size_t slots = (tree->blocks ? tree->blocks : 1) * SEARCH_TREE_BLOCK;
+    tree->keys = memory_alloc(slots * sizeof(int32_t), SEARCH_ALIGNMENT);
+    tree->ranks = memory_alloc(slots * sizeof(uint32_t), alignof(uint32_t));
+    if (!tree->keys || !tree->ranks) {
+        search_tree_free(tree);
+        return NULL;
+    }
+
+    size_t next = 0;
+    search_tree_build(tree, sorted, &next, 0);
+    return tree;
+}
+
+void search_tree_free(SearchTree* tree) {
+    if (tree) {
+        memory_free(tree->keys);
+        memory_free(tree->ranks);
+        memory_free(tree);
+    }
+}
+
+size_t search_tree_lower_bound(const SearchTree* tree, int32_t key) {
+    return search_tree_descend(tree, key, false);
+}
+
+size_t search_tree_upper_bound(const SearchTree* tree, int32_t key) {
+    return search_tree_descend(tree, key, true);
+}
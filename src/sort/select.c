@@ -0,0 +1,510 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/sort/select.c
+ * @brief Selection, partial sorting and index sorting for float score arrays.
+ */
+
+#include "core/memory.h"
+#include "sort/select.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// Ranges at or below this size are finished with insertion sort.
+#define SELECT_INSERTION_THRESHOLD 16
+
+// Radix width for argsort: 3 passes of 11 bits cover a 32-bit key.
+#define SELECT_RADIX_BITS 11
+#define SELECT_RADIX_SIZE (1u << SELECT_RADIX_BITS)
+#define SELECT_RADIX_MASK (SELECT_RADIX_SIZE - 1)
+#define SELECT_RADIX_PASSES 3
+
+/**
+ * Private Functions: Range Primitives
+ *
+ * Every primitive operates on `key[lo..hi)` and mirrors swaps into `index` when it is not NULL,
+ * so the same code serves in-place selection and argpartition.
+ */
+
+static inline void select_swap(float* key, uint32_t* index, size_t a, size_t b) {
+    float k = key[a];
+    key[a] = key[b];
+    key[b] = k;
+    if (index) {
+        uint32_t i = index[a];
+        index[a] = index[b];
+        index[b] = i;
+    }
+}
+
+static void select_insertion(float* key, uint32_t* index, size_t lo, size_t hi) {
+    for (size_t i = lo + 1; i < hi; i++) {
+        float k = key[i];
+        uint32_t x = index ? index[i] : 0;
+        size_t j = i;
+        while (j > lo && key[j - 1] > k) {
+            key[j] = key[j - 1];
+            if (index) {
+                index[j] = index[j - 1];
+            }
+            j--;
+        }
+        key[j] = k;
+        if (index) {
+            index[j] = x;
+        }
+    }
+}
+
+// Maintains the max-heap property for the subtree at `root` of the heap stored at `key[lo..)`.
+static void select_sift_down(float* key, uint32_t* index, size_t lo, size_t n, size_t root) {
+    for (;;) {
+        size_t largest = root;
+        size_t left = 2 * root + 1;
+        size_t right = left + 1;
+
+        if (left < n && key[lo + left] > key[lo + largest]) {
+            largest = left;
+        }
+        if (right < n && key[lo + right] > key[lo + largest]) {
+            largest = right;
+        }
+        if (largest == root) {
+            return;
+        }
+
+        select_swap(key, index, lo + root, lo + largest);
+        root = largest;
+    }
+}
+
+// Worst-case fallback once the partition depth budget is exhausted.
+static void select_heapsort(float* key, uint32_t* index, size_t lo, size_t hi) {
+    size_t n = hi - lo;
+    for (size_t i = n / 2; i-- > 0;) {
+        select_sift_down(key, index, lo, n, i);
+    }
+    for (size_t i = n - 1; i > 0; i--) {
+        select_swap(key, index, lo, lo + i);
+        select_sift_down(key, index, lo, i, 0);
+    }
+}
+
+// Median-of-three Hoare partition. Returns the final position of the pivot.
+static size_t select_partition(float* key, uint32_t* index, size_t lo, size_t hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    size_t last = hi - 1;
+
+    // Order key[lo] <= key[mid] <= key[last]; key[last] then bounds the left scan.
+    if (key[mid] < key[lo]) {
+        select_swap(key, index, mid, lo);
+    }
+    if (key[last] < key[lo]) {
+        select_swap(key, index, last, lo);
+    }
+    if (key[last] < key[mid]) {
+        select_swap(key, index, last, mid);
+    }
+
+    // Park the median at lo, where it bounds the right scan.
+    select_swap(key, index, lo, mid);
+    float pivot = key[lo];
+
+    size_t i = lo;
+    size_t j = hi;
+    for (;;) {
+        do {
+            i++;
+        } while (key[i] < pivot);
+        do {
+            j--;
+        } while (key[j] > pivot);
+        if (i >= j) {
+            break;
+        }
+        select_swap(key, index, i, j);
+    }
+
+    select_swap(key, index, lo, j);
+    return j;
+}
+
+static size_t select_depth_limit(size_t n) {
+    size_t depth = 0;
+    while (n > 1) {
+        n >>= 1;
+        depth += 2;
+    }
+    return depth;
+}
+
+static void select_introselect(float* key, uint32_t* index, size_t lo, size_t hi, size_t nth) {
+    size_t depth = select_depth_limit(hi - lo);
+
+    while (hi - lo > SELECT_INSERTION_THRESHOLD) {
+        if (0 == depth--) {
+            select_heapsort(key, index, lo, hi);
+            return;
+        }
+
+        size_t p = select_partition(key, index, lo, hi);
+        if (p == nth) {
+            return;
+        }
+        if (nth < p) {
+            hi = p;
+        } else {
+            lo = p + 1;
+        }
+    }
+
+    select_insertion(key, index, lo, hi);
+}
+
+static void select_introsort(float* key, uint32_t* index, size_t lo, size_t hi, size_t depth) {
+    while (hi - lo > SELECT_INSERTION_THRESHOLD) {
+        if (0 == depth--) {
+            select_heapsort(key, index, lo, hi);
+            return;
+        }
+
+        // Recurse into the smaller side to bound the stack at O(log n).
+        size_t p = select_partition(key, index, lo, hi);
+        if (p - lo < hi - p) {
+            select_introsort(key, index, lo, p, depth);
+            lo = p + 1;
+        } else {
+            select_introsort(key, index, p + 1, hi, depth);
+            hi = p;
+        }
+    }
+
+    select_insertion(key, index, lo, hi);
+}
+
+/**
+ * Private Functions: Top-K Heap
+ */
+
+// `a` ranks below `b`: smaller value, or equal value with a later index.
+static inline bool select_top_k_worse(const SelectTopK* top, size_t a, size_t b) {
+    float va = top->values[a];
+    float vb = top->values[b];
+    return va < vb || (va == vb && top->indices[a] > top->indices[b]);
+}
+
+static inline void select_top_k_swap(SelectTopK* top, size_t a, size_t b) {
+    select_swap(top->values, top->indices, a, b);
+}
+
+static void select_top_k_sift_down(SelectTopK* top, size_t n, size_t root) {
+    for (;;) {
+        size_t worst = root;
+        size_t left = 2 * root + 1;
+        size_t right = left + 1;
+
+        if (left < n && select_top_k_worse(top, left, worst)) {
+            worst = left;
+        }
+        if (right < n && select_top_k_worse(top, right, worst)) {
+            worst = right;
+        }
+        if (worst == root) {
+            return;
+        }
+
+        select_top_k_swap(top, root, worst);
+        root = worst;
+    }
+}
+
+static void select_top_k_insert(SelectTopK* top, float value, uint32_t index) {
+    size_t child = top->count++;
+    top->values[child] = value;
+    top->indices[child] = index;
+
+    while (child > 0) {
+        size_t parent = (child - 1) / 2;
+        if (!select_top_k_worse(top, child, parent)) {
+            break;
+        }
+        select_top_k_swap(top, child, parent);
+        child = parent;
+    }
+}
+
+// Admits `value` if it beats the current threshold of a full heap.
+static inline void select_top_k_offer(SelectTopK* top, float value, uint32_t index) {
+    if (value > top->values[0]) {
+        top->values[0] = value;
+        top->indices[0] = index;
+        select_top_k_sift_down(top, top->count, 0);
+    }
+}
+
+/**
+ * Private Functions: Radix
+ */
+
+// Maps a float to an unsigned key with the same ordering.
+static inline uint32_t select_radix_key(float value, SelectOrder order) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits ^= (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+    return SELECT_DESCENDING == order ? ~bits : bits;
+}
+
+/**
+ * Public Functions: In-place Selection
+ */
+
+float select_nth_float(float* data, size_t length, size_t nth) {
+    assert(data != NULL);
+    assert(nth < length);
+
+    select_introselect(data, NULL, 0, length, nth);
+    return data[nth];
+}
+
+void select_partial_sort_float(float* data, size_t length, size_t k) {
+    assert(data != NULL);
+
+    if (k > length) {
+        k = length;
+    }
+    if (0 == k) {
+        return;
+    }
+
+    if (k < length) {
+        select_introselect(data, NULL, 0, length, k - 1);
+    }
+    select_introsort(data, NULL, 0, k, select_depth_limit(k));
+}
+
+/**
+ * Public Functions: Streaming Top-K
+ */
+
+SelectTopK* select_top_k_create(size_t k) {
+    if (0 == k || k > UINT32_MAX) {
+        return NULL;
+    }
+
+    SelectTopK* top = memory_alloc(sizeof(SelectTopK), alignof(SelectTopK));
+    if (!top) {
+        return NULL;
+    }
+
+    top->values = memory_alloc(k * sizeof(float), alignof(float));
+    top->indices = memory_alloc(k * sizeof(uint32_t), alignof(uint32_t));
+    if (!top->values || !top->indices) {
+        select_top_k_free(top);
+        return NULL;
+    }
+
+    top->capacity = k;
+    top->count = 0;
+    return top;
+}
+
+void select_top_k_free(SelectTopK* top) {
+    if (top) {
+        memory_free(top->values);
+        memory_free(top->indices);
+        memory_free(top);
+    }
+}
+
+void select_top_k_reset(SelectTopK* top) {
+    if (top) {
+        top->count = 0;
+    }
+}
+
+void select_top_k_push(SelectTopK* top, const float* data, size_t length, size_t offset) {
+    assert(top != NULL);
+    assert(data != NULL || 0 == length);
+
+    size_t i = 0;
+
+    // Fill phase: every value is admitted until the heap holds k entries.
+    for (; i < length && top->count < top->capacity; i++) {
+        select_top_k_insert(top, data[i], (uint32_t) (offset + i));
+    }
+
+#if defined(__SSE2__)
+    // Threshold phase: compare 16 values per step and only walk blocks with a candidate.
+    for (; i + 16 <= length; i += 16) {
+        __m128 threshold = _mm_set1_ps(top->values[0]);
+        __m128 m0 = _mm_cmpgt_ps(_mm_loadu_ps(data + i), threshold);
+        __m128 m1 = _mm_cmpgt_ps(_mm_loadu_ps(data + i + 4), threshold);
+        __m128 m2 = _mm_cmpgt_ps(_mm_loadu_ps(data + i + 8), threshold);
+        __m128 m3 = _mm_cmpgt_ps(_mm_loadu_ps(data + i + 12), threshold);
+        __m128 any = _mm_or_ps(_mm_or_ps(m0, m1), _mm_or_ps(m2, m3));
+        if (0 == _mm_movemask_ps(any)) {
+            continue;
+        }
+        for (size_t j = i; j < i + 16; j++) {
+            select_top_k_offer(top, data[j], (uint32_t) (offset + j));
+        }
+    }
+#endif
+
+    for (; i < length; i++) {
+        select_top_k_offer(top, data[i], (uint32_t) (offset + i));
+    }
+}
+
+size_t select_top_k_finish(SelectTopK* top, uint32_t* indices, float* values) {
+    assert(top != NULL);
+
+    // Heapsort on a min-heap leaves the best entry at position 0.
+    size_t count = top->count;
+    for (size_t n = count; n > 1; n--) {
+        select_top_k_swap(top, 0, n - 1);
+        select_top_k_sift_down(top, n - 1, 0);
+    }
+
+    if (indices) {
+        memcpy(indices, top->indices, count * sizeof(uint32_t));
+    }
+    if (values) {
+        memcpy(values, top->values, count * sizeof(float));
+    }
+
+    top->count = 0;
+    return count;
+}
+
+size_t select_top_k_float(
+    const float* data, size_t length, size_t k, uint32_t* indices, float* values
+) {
+    assert(data != NULL || 0 == length);
+
+    if (k > length) {
+        k = length;
+    }
+    if (0 == k) {
+        return 0;
+    }
+
+    SelectTopK* top = select_top_k_create(k);
+    if (!top) {
+        return 0;
+    }
+
+    select_top_k_push(top, data, length, 0);
+    size_t count = select_top_k_finish(top, indices, values);
+    select_top_k_free(top);
+    return count;
+}
+
+/**
+ * Public Functions: Index Selection
+ */
+
+bool select_argpartition_float(
+    const float* data, size_t length, size_t kth, uint32_t* indices, SelectOrder order
+) {
+    if (!data || !indices || kth >= length || length > UINT32_MAX) {
+        return false;
+    }
+
+    // Partition a scratch copy of the keys; negation turns descending into ascending.
+    float* key = memory_alloc(length * sizeof(float), alignof(float));
+    if (!key) {
+        return false;
+    }
+
+    float sign = SELECT_DESCENDING == order ? -1.0f : 1.0f;
+    for (size_t i = 0; i < length; i++) {
+        key[i] = sign * data[i];
+        indices[i] = (uint32_t) i;
+    }
+
+    select_introselect(key, indices, 0, length, kth);
+    memory_free(key);
+    return true;
+}
+
+bool select_argsort_float(const float* data, size_t length, uint32_t* indices, SelectOrder order) {
+    if (!data || !indices || length > UINT32_MAX) {
+        return false;
+    }
+    if (length < 2) {
+        if (1 == length) {
+            indices[0] = 0;
+        }
+        return true;
+    }
+
+    uint32_t* key[2] = {
+        memory_alloc(length * sizeof(uint32_t), alignof(uint32_t)),
+        memory_alloc(length * sizeof(uint32_t), alignof(uint32_t)),
+    };
+    uint32_t* scratch = memory_alloc(length * sizeof(uint32_t), alignof(uint32_t));
+    uint32_t* histogram = memory_calloc(
+        SELECT_RADIX_PASSES * SELECT_RADIX_SIZE, sizeof(uint32_t), alignof(uint32_t)
+    );
+    if (!key[0] || !key[1] || !scratch || !histogram) {
+        memory_free(key[0]);
+        memory_free(key[1]);
+        memory_free(scratch);
+        memory_free(histogram);
+        return false;
+    }
+
+    // One read of the input builds every pass histogram.
+    for (size_t i = 0; i < length; i++) {
+        uint32_t k = select_radix_key(data[i], order);
+        key[0][i] = k;
+        indices[i] = (uint32_t) i;
+        for (uint32_t pass = 0; pass < SELECT_RADIX_PASSES; pass++) {
+            histogram[pass * SELECT_RADIX_SIZE + ((k >> (pass * SELECT_RADIX_BITS)) & SELECT_RADIX_MASK)]++;
+        }
+    }
+
+    uint32_t* index[2] = {indices, scratch};
+    int src = 0;
+
+    for (uint32_t pass = 0; pass < SELECT_RADIX_PASSES; pass++) {
+        uint32_t* count = histogram + pass * SELECT_RADIX_SIZE;
+        uint32_t shift = pass * SELECT_RADIX_BITS;
+
+        // A digit shared by every key leaves the order unchanged.
+        if (count[(key[src][0] >> shift) & SELECT_RADIX_MASK] == length) {
+            continue;
+        }
+
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < SELECT_RADIX_SIZE; b++) {
+            uint32_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+
+        int dst = src ^ 1;
+        for (size_t i = 0; i < length; i++) {
+            uint32_t k = key[src][i];
+            uint32_t slot = count[(k >> shift) & SELECT_RADIX_MASK]++;
+            key[dst][slot] = k;
+            index[dst][slot] = index[src][i];
+        }
+        src = dst;
+    }
+
+    if (index[src] != indices) {
+        memcpy(indices, index[src], length * sizeof(uint32_t));
+    }
+
+    memory_free(key[0]);
+    memory_free(key[1]);
+    memory_free(scratch);
+    memory_free(histogram);
+    return true;
+}
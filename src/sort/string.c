@@ -0,0 +1,270 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/sort/string.c
+ * @brief Sorting of null-terminated byte strings (paths, tokens, UTF-8 text).
+ */
+
+#include "core/memory.h"
+#include "sort/string.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Ranges at or below this size are finished with insertion sort.
+#define STRING_INSERTION_THRESHOLD 12
+
+// Radix buckets below this size are handed to multikey quicksort.
+#define STRING_RADIX_THRESHOLD 64
+
+typedef struct StringJob {
+    size_t begin; // Offset of the bucket in the string array
+    size_t count; // Number of strings in the bucket
+    size_t depth; // Length of the prefix shared by the whole bucket
+} StringJob;
+
+typedef struct StringStack {
+    StringJob* jobs;
+    size_t count;
+    size_t capacity;
+} StringStack;
+
+/**
+ * Private Functions
+ */
+
+static inline uint8_t string_byte(const char* s, size_t depth) {
+    return (uint8_t) s[depth];
+}
+
+static inline void string_swap(char** s, uint8_t* cache, size_t a, size_t b) {
+    char* t = s[a];
+    s[a] = s[b];
+    s[b] = t;
+    uint8_t c = cache[a];
+    cache[a] = cache[b];
+    cache[b] = c;
+}
+
+// Length of the common prefix of `a` and `b`.
+static size_t string_common(const char* a, const char* b) {
+    size_t n = 0;
+    while (a[n] && a[n] == b[n]) {
+        n++;
+    }
+    return n;
+}
+
+// Strings in `s` share `depth` leading bytes; strcmp orders the rest as unsigned bytes.
+static void string_insertion(char** s, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; i++) {
+        char* key = s[i];
+        size_t j = i;
+        while (j > 0 && strcmp(s[j - 1] + depth, key + depth) > 0) {
+            s[j] = s[j - 1];
+            j--;
+        }
+        s[j] = key;
+    }
+}
+
+static inline uint8_t string_median(uint8_t a, uint8_t b, uint8_t c) {
+    if (a < b) {
+        return b < c ? b : (a < c ? c : a);
+    }
+    return a < c ? a : (b < c ? c : b);
+}
+
+/**
+ * @brief Multikey quicksort with a per-string byte cache.
+ *
+ * `cache[i]` mirrors `s[i][depth]` when `cached` is true. The less and greater partitions keep
+ * their depth, so their cache stays valid and the bytes are never fetched twice.
+ */
+static void string_multikey(char** s, uint8_t* cache, size_t n, size_t depth, bool cached) {
+    while (n > STRING_INSERTION_THRESHOLD) {
+        if (!cached) {
+            for (size_t i = 0; i < n; i++) {
+                cache[i] = string_byte(s[i], depth);
+            }
+        }
+
+        uint8_t pivot = string_median(cache[0], cache[n / 2], cache[n - 1]);
+
+        // Three-way partition: [0, lt) < pivot, [lt, gt) == pivot, [gt, n) > pivot.
+        size_t lt = 0;
+        size_t gt = n;
+        for (size_t i = 0; i < gt;) {
+            uint8_t c = cache[i];
+            if (c < pivot) {
+                string_swap(s, cache, lt++, i++);
+            } else if (c > pivot) {
+                string_swap(s, cache, i, --gt);
+            } else {
+                i++;
+            }
+        }
+
+        string_multikey(s, cache, lt, depth, true);
+        string_multikey(s + gt, cache + gt, n - gt, depth, true);
+
+        if (0 == pivot) {
+            return; // the equal partition holds identical, fully consumed strings
+        }
+
+        s += lt;
+        cache += lt;
+        n = gt - lt;
+        depth++;
+        cached = false;
+    }
+
+    string_insertion(s, n, depth);
+}
+
+static bool string_stack_push(StringStack* stack, size_t begin, size_t count, size_t depth) {
+    if (stack->count == stack->capacity) {
+        size_t capacity = stack->capacity ? stack->capacity * 2 : 64;
+        StringJob* jobs = realloc(stack->jobs, capacity * sizeof(StringJob));
+        if (!jobs) {
+            return false;
+        }
+        stack->jobs = jobs;
+        stack->capacity = capacity;
+    }
+    stack->jobs[stack->count++] = (StringJob){begin, count, depth};
+    return true;
+}
+
+/**
+ * Public Functions
+ */
+
+bool string_sort_multikey(char** strings, size_t count) {
+    if (!strings) {
+        return false;
+    }
+    if (count < 2) {
+        return true;
+    }
+
+    uint8_t* cache = memory_alloc(count, alignof(max_align_t));
+    if (!cache) {
+        return false;
+    }
+
+    string_multikey(strings, cache, count, 0, false);
+    memory_free(cache);
+    return true;
+}
+
+bool string_sort_radix(char** strings, size_t count, size_t* lcp) {
+    if (!strings) {
+        return false;
+    }
+    if (lcp && count > 0) {
+        lcp[0] = 0;
+    }
+    if (count < 2) {
+        return true;
+    }
+
+    uint8_t* cache = memory_alloc(count, alignof(max_align_t));
+    char** scratch = memory_alloc(count * sizeof(char*), alignof(char*));
+    StringStack stack = {0};
+    if (!cache || !scratch || !string_stack_push(&stack, 0, count, 0)) {
+        memory_free(cache);
+        memory_free(scratch);
+        free(stack.jobs);
+        return false;
+    }
+
+    size_t bucket[256];
+    size_t offset[256];
+
+    while (stack.count > 0) {
+        StringJob job = stack.jobs[--stack.count];
+        char** s = strings + job.begin;
+        uint8_t* c = cache + job.begin;
+        size_t n = job.count;
+        size_t depth = job.depth;
+
+        if (n < STRING_RADIX_THRESHOLD) {
+            string_multikey(s, c, n, depth, false);
+            if (lcp) {
+                for (size_t i = 1; i < n; i++) {
+                    lcp[job.begin + i] = depth + string_common(s[i - 1] + depth, s[i] + depth);
+                }
+            }
+            continue;
+        }
+
+        // Fetch and count one byte per string, skipping levels the whole bucket shares.
+        for (;;) {
+            memset(bucket, 0, sizeof(bucket));
+            for (size_t i = 0; i < n; i++) {
+                uint8_t b = string_byte(s[i], depth);
+                c[i] = b;
+                bucket[b]++;
+            }
+            if (bucket[c[0]] != n || 0 == c[0]) {
+                break;
+            }
+            depth++;
+        }
+
+        if (bucket[0] == n) {
+            // Every string ended here: they are all identical.
+            if (lcp) {
+                for (size_t i = 1; i < n; i++) {
+                    lcp[job.begin + i] = depth;
+                }
+            }
+            continue;
+        }
+
+        size_t sum = 0;
+        for (size_t b = 0; b < 256; b++) {
+            offset[b] = sum;
+            sum += bucket[b];
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            scratch[offset[c[i]]++] = s[i];
+        }
+        memcpy(s, scratch, n * sizeof(char*));
+
+        // offset[b] now marks the end of bucket b.
+        bool first = true;
+        for (size_t b = 0; b < 256; b++) {
+            if (0 == bucket[b]) {
+                continue;
+            }
+
+            size_t begin = job.begin + offset[b] - bucket[b];
+            if (lcp) {
+                if (!first) {
+                    lcp[begin] = depth;
+                }
+                if (0 == b) {
+                    for (size_t i = 1; i < bucket[b]; i++) {
+                        lcp[begin + i] = depth;
+                    }
+                }
+            }
+            first = false;
+
+            if (0 != b && bucket[b] > 1 && !string_stack_push(&stack, begin, bucket[b], depth + 1)) {
+                memory_free(cache);
+                memory_free(scratch);
+                free(stack.jobs);
+                return false;
+            }
+        }
+    }
+
+    memory_free(cache);
+    memory_free(scratch);
+    free(stack.jobs);
+    return true;
+}
@@ -0,0 +1,38 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file src/test/bench.c
+ */
+
+#include "test/bench.h"
+
+#include <stdio.h>
+#include <time.h>
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+void bench_print(const char* label, double seconds, size_t iterations, double work, const char* unit) {
+    static const char* prefix[] = {"", "K", "M", "G", "T"};
+
+    double per_iteration = iterations ? seconds / (double) iterations : 0.0;
+    double rate = seconds > 0.0 ? work * (double) iterations / seconds : 0.0;
+
+    size_t scale = 0;
+    while (rate >= 1000.0 && scale < 4) {
+        rate /= 1000.0;
+        scale++;
+    }
+
+    printf(
+        "%-40s %10.3f us/iter %10.3f %s%s/s\n",
+        label,
+        per_iteration * 1e6,
+        rate,
+        prefix[scale],
+        unit
+    );
+}
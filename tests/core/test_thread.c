@@ -0,0 +1,141 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/core/test_thread.c
+ */
+
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREAD_MAX 8
+
+/**
+ * @name Parallel For
+ * {@
+ */
+
+typedef struct TestThreadLoop {
+    size_t threads; // 0 runs without a pool
+    size_t count;
+    size_t grain;
+} TestThreadLoop;
+
+typedef struct TestThreadVisit {
+    uint8_t* hits; // per index
+    size_t begin[THREAD_MAX];
+    size_t end[THREAD_MAX];
+    size_t calls[THREAD_MAX];
+} TestThreadVisit;
+
+static void test_thread_visit(void* context, size_t begin, size_t end, size_t thread) {
+    TestThreadVisit* visit = (TestThreadVisit*) context;
+    visit->begin[thread] = begin;
+    visit->end[thread] = end;
+    visit->calls[thread]++;
+    for (size_t i = begin; i < end; i++) {
+        visit->hits[i]++;
+    }
+}
+
+int test_group_thread_parallel_for(TestUnit* unit) {
+    const TestThreadLoop* data = (const TestThreadLoop*) unit->data;
+    ThreadPool* pool = data->threads ? thread_pool_create(data->threads) : NULL;
+    size_t size = thread_pool_size(pool);
+    size_t grain = data->grain ? data->grain : 1;
+
+    // Several loops on one pool, so workers are reused across generations.
+    for (size_t round = 0; round < 16; round++) {
+        TestThreadVisit visit = {0};
+        visit.hits = calloc(data->count + 1, 1);
+
+        thread_pool_parallel_for(pool, data->count, data->grain, test_thread_visit, &visit);
+
+        size_t wrong = 0;
+        for (size_t i = 0; i < data->count; i++) {
+            wrong += visit.hits[i] != 1;
+        }
+
+        // Ranges are called at most once, ordered by thread, contiguous and grain-aligned.
+        size_t next = 0;
+        bool ordered = true;
+        for (size_t t = 0; t < THREAD_MAX; t++) {
+            if (0 == visit.calls[t]) {
+                continue;
+            }
+            ordered &= t < size && 1 == visit.calls[t] && visit.begin[t] == next;
+            ordered &= 0 == visit.begin[t] % grain;
+            ordered &= visit.end[t] == data->count || 0 == visit.end[t] % grain;
+            next = visit.end[t];
+        }
+        ordered &= next == data->count;
+
+        free(visit.hits);
+
+        ASSERT(
+            0 == wrong && ordered,
+            "[TestThreadParallelFor] threads=%zu, count=%zu, grain=%zu, round=%zu, wrong=%zu, "
+            "ordered=%d",
+            data->threads,
+            data->count,
+            data->grain,
+            round,
+            wrong,
+            ordered
+        );
+    }
+
+    thread_pool_free(pool);
+    return 0;
+}
+
+int test_suite_thread_parallel_for(void) {
+    TestThreadLoop data[] = {
+        {0, 0, 1},
+        {0, 100, 7},
+        {1, 100, 0},
+        {2, 1, 1},
+        {2, 1000, 16},
+        {3, 5, 1},
+        {3, 10, 4},
+        {4, 1000, 1},
+        {8, 3, 1},
+        {8, 1003, 32},
+        {THREAD_MAX, 100000, 64},
+    };
+
+    size_t count = sizeof(data) / sizeof(TestThreadLoop);
+    TestUnit units[sizeof(data) / sizeof(TestThreadLoop)];
+    for (size_t i = 0; i < count; i++) {
+        units[i].data = &data[i];
+    }
+
+    TestGroup group = {
+        .name = "thread_parallel_for",
+        .count = count,
+        .units = units,
+        .run = test_group_thread_parallel_for,
+    };
+
+    return test_group_run(&group);
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"thread_parallel_for", test_suite_thread_parallel_for},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,580 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_activation.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/activation.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Every 4099th fp32 bit pattern (about 1M inputs, NaNs and infinities included), so a run covers
+// every exponent and both signs. The documented bounds come from the full 2^32 sweep.
+#define ACTIVATION_STRIDE 4099u
+
+// Odd, so every vector width leaves a tail.
+#define ACTIVATION_CHUNK 4093
+
+typedef void (*TestActivationRow)(const float* input, float* output, size_t length);
+
+typedef struct TestActivation {
+    const char* name;
+    TestActivationRow row;
+    double (*reference)(double x);
+    double max_ulp;
+} TestActivation;
+
+static double reference_exp(double x) {
+    return exp(x);
+}
+
+static double reference_relu(double x) {
+    return x > 0.0 ? x : 0.0;
+}
+
+static double reference_sigmoid(double x) {
+    return 1.0 / (1.0 + exp(-x));
+}
+
+static double reference_tanh(double x) {
+    return tanh(x);
+}
+
+static double reference_silu(double x) {
+    return x < -1000.0 ? 0.0 : x / (1.0 + exp(-x));
+}
+
+static double reference_gelu(double x) {
+    return x < -1000.0 ? 0.0 : 0.5 * x * erfc(-x / sqrt(2.0));
+}
+
+// x * sigmoid(2u) rather than 0.5 x (1 + tanh(u)), which cancels for negative x.
+static double reference_gelu_tanh(double x) {
+    if (x < -1000.0) {
+        return 0.0;
+    }
+    double u = sqrt(2.0 / M_PI) * (x + 0.044715 * x * x * x);
+    return x / (1.0 + exp(-2.0 * u));
+}
+
+// Bounds from the table in numeric/activation.h (worst level).
+static const TestActivation activation_cases[] = {
+    {"exp", activate_exp_row, reference_exp, 1.01},
+    {"relu", activate_relu_row, reference_relu, 0.0},
+    {"sigmoid", activate_sigmoid_row, reference_sigmoid, 2.83},
+    {"tanh", activate_tanh_row, reference_tanh, 1.33},
+    {"silu", activate_silu_row, reference_silu, 3.69},
+    {"gelu", activate_gelu_row, reference_gelu, 5.84},
+    {"gelu_tanh", activate_gelu_tanh_row, reference_gelu_tanh, 4.64},
+};
+
+#define ACTIVATION_CASE_COUNT (sizeof(activation_cases) / sizeof(TestActivation))
+
+/**
+ * Error of `got` in units in the last place of the exact result `expected`. Subnormal results
+ * use the subnormal spacing; results past FLT_MAX must be infinite, and NaN must give NaN.
+ */
+static double activation_ulp_error(double expected, float got) {
+    if (isnan(expected) || isnan(got)) {
+        return isnan(expected) && isnan(got) ? 0.0 : HUGE_VAL;
+    }
+
+    float rounded = (float) expected;
+    if (isinf(rounded) || isinf(got)) {
+        return rounded == got ? 0.0 : HUGE_VAL;
+    }
+
+    double magnitude = fabs(expected);
+    int exponent = magnitude < (double) FLT_MIN ? -126 : ilogb(magnitude);
+    return fabs((double) got - expected) / ldexp(1.0, exponent - 23);
+}
+
+int test_group_activation_row(TestUnit* unit) {
+    const TestActivation* test = (const TestActivation*) unit->data;
+
+    float* input = malloc(ACTIVATION_CHUNK * sizeof(float));
+    float* output = malloc(ACTIVATION_CHUNK * sizeof(float));
+    float* in_place = malloc(ACTIVATION_CHUNK * sizeof(float));
+
+    int result = 0;
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+        cpu_level_set((CpuLevel) level);
+
+        double worst = 0.0;
+        float worst_input = 0.0f;
+        size_t mismatched = 0; // in-place results that differ from out-of-place ones
+
+        uint64_t bits = 0;
+        while (bits < (1ull << 32)) {
+            size_t n = 0;
+            for (; n < ACTIVATION_CHUNK && bits < (1ull << 32); n++, bits += ACTIVATION_STRIDE) {
+                uint32_t pattern = (uint32_t) bits;
+                memcpy(&input[n], &pattern, sizeof(float));
+            }
+
+            test->row(input, output, n);
+            memcpy(in_place, input, n * sizeof(float));
+            test->row(in_place, in_place, n);
+
+            for (size_t i = 0; i < n; i++) {
+                double error = activation_ulp_error(test->reference((double) input[i]), output[i]);
+                if (error > worst) {
+                    worst = error;
+                    worst_input = input[i];
+                }
+                mismatched += 0 != memcmp(&output[i], &in_place[i], sizeof(float));
+            }
+        }
+
+        const char* name = cpu_level_name((CpuLevel) level);
+        if (worst > test->max_ulp || mismatched > 0) {
+            LOG_ERROR(
+                "[TestActivation] %s, level=%s, max ulp=%.3f at x=%a (bound %.2f), in-place "
+                "mismatches=%zu",
+                test->name,
+                name,
+                worst,
+                (double) worst_input,
+                test->max_ulp,
+                mismatched
+            );
+            result = 1;
+            break;
+        }
+        LOG_INFO(
+            "[TestActivation] %s, level=%s, max ulp=%.3f at x=%a",
+            test->name,
+            name,
+            worst,
+            (double) worst_input
+        );
+    }
+
+    cpu_level_set(cpu_level_detected());
+    free(input);
+    free(output);
+    free(in_place);
+    return result;
+}
+
+int test_suite_activation_row(void) {
+    TestUnit units[ACTIVATION_CASE_COUNT];
+    for (size_t i = 0; i < ACTIVATION_CASE_COUNT; i++) {
+        units[i].data = &activation_cases[i];
+    }
+
+    TestGroup group = {
+        .name = "activation_row",
+        .count = ACTIVATION_CASE_COUNT,
+        .units = units,
+        .run = test_group_activation_row,
+    };
+
+    return test_group_run(&group);
+}
+
+// The row kernels in enum order, to cross-check the fp16 tables.
+static const TestActivationRow activation_rows[ACTIVATION_COUNT] = {
+    [ACTIVATION_RELU] = activate_relu_row,
+    [ACTIVATION_SIGMOID] = activate_sigmoid_row,
+    [ACTIVATION_TANH] = activate_tanh_row,
+    [ACTIVATION_SILU] = activate_silu_row,
+    [ACTIVATION_GELU] = activate_gelu_row,
+    [ACTIVATION_GELU_TANH] = activate_gelu_tanh_row,
+};
+
+/**
+ * Over every half, the table must agree with the fp32 kernel rounded to fp16 to within one fp16
+ * step (the two round differently near ties), and `activate_row()` with the named kernel exactly.
+ */
+int test_group_activation_fp16(TestUnit* unit) {
+    ActivationFunction function = *(const ActivationFunction*) unit->data;
+
+    uint16_t* halves = malloc(65536 * sizeof(uint16_t));
+    uint16_t* table = malloc(65536 * sizeof(uint16_t));
+    uint16_t* rounded = malloc(65536 * sizeof(uint16_t));
+    float* widened = malloc(65536 * sizeof(float));
+    float* expected = malloc(65536 * sizeof(float));
+
+    for (uint32_t i = 0; i < 65536; i++) {
+        halves[i] = (uint16_t) i;
+    }
+    dequantize_row_fp16(halves, widened, 65536);
+
+    activate_row_fp16(function, halves, table, 65536);
+    activation_rows[function](widened, expected, 65536);
+    quantize_row_fp16(expected, rounded, 65536);
+    activate_row(function, widened, widened, 65536); // in place
+
+    size_t far = 0;
+    size_t dispatch = 0;
+    size_t first = 0;
+    for (uint32_t i = 0; i < 65536; i++) {
+        bool nan = (table[i] & 0x7FFF) > 0x7C00;
+        bool nan_expected = (rounded[i] & 0x7FFF) > 0x7C00;
+        int32_t step = abs((int32_t) table[i] - (int32_t) rounded[i]);
+        // ±0 are one step apart across the sign boundary.
+        bool zeros = 0 == (table[i] & 0x7FFF) && 0 == (rounded[i] & 0x7FFF);
+        if (nan != nan_expected || (!nan && !zeros && step > 1)) {
+            if (0 == far++) {
+                first = i;
+            }
+        }
+        dispatch += 0 != memcmp(&widened[i], &expected[i], sizeof(float));
+    }
+
+    ASSERT(
+        0 == far && 0 == dispatch,
+        "[TestActivation] fp16 function=%d, table entries off by more than one step=%zu (first "
+        "0x%04zx: 0x%04x vs 0x%04x), activate_row mismatches=%zu",
+        (int) function,
+        far,
+        first,
+        table[first],
+        rounded[first],
+        dispatch
+    );
+
+    // In place through the table.
+    activate_row_fp16(function, halves, halves, 65536);
+    ASSERT(
+        0 == memcmp(halves, table, 65536 * sizeof(uint16_t)),
+        "[TestActivation] fp16 function=%d, in-place result differs",
+        (int) function
+    );
+
+    free(halves);
+    free(table);
+    free(rounded);
+    free(widened);
+    free(expected);
+    return 0;
+}
+
+int test_suite_activation_fp16(void) {
+    static const ActivationFunction functions[ACTIVATION_COUNT] = {
+        ACTIVATION_RELU,
+        ACTIVATION_SIGMOID,
+        ACTIVATION_TANH,
+        ACTIVATION_SILU,
+        ACTIVATION_GELU,
+        ACTIVATION_GELU_TANH,
+    };
+
+    TestUnit units[ACTIVATION_COUNT];
+    for (size_t i = 0; i < ACTIVATION_COUNT; i++) {
+        units[i].data = &functions[i];
+    }
+
+    TestGroup group = {
+        .name = "activation_fp16",
+        .count = ACTIVATION_COUNT,
+        .units = units,
+        .run = test_group_activation_fp16,
+    };
+
+    return test_group_run(&group);
+}
+
+typedef void (*TestActivationHalfRow)(
+    ActivationFunction function, const uint16_t* input, uint16_t* output, size_t length
+);
+
+typedef struct TestActivationHalf {
+    const char* name;
+    TestActivationHalfRow table;
+    TestActivationHalfRow fused;
+    void (*widen)(const uint16_t* input, float* output, size_t length);
+    void (*narrow)(const float* input, uint16_t* output, size_t length);
+    uint16_t exponent; // all-ones exponent, to tell NaNs apart
+} TestActivationHalf;
+
+static const TestActivationHalf activation_halves[] = {
+    {"fp16", activate_row_fp16, activate_row_fp16_fused, dequantize_row_fp16, quantize_row_fp16,
+     0x7C00},
+    {"bf16", activate_row_bf16, activate_row_bf16_fused, dequantize_row_bf16, quantize_row_bf16,
+     0x7F80},
+};
+
+/**
+ * At every level, the fused row must equal widen, activate and narrow done as three passes bit
+ * for bit; the rows start one half in so the vector bodies are misaligned and every tail width
+ * is hit. The bf16 tables get the same one-step check as the fp16 ones above.
+ */
+int test_group_activation_half(TestUnit* unit) {
+    ActivationFunction function = *(const ActivationFunction*) unit->data;
+
+    uint16_t* halves = malloc(65536 * sizeof(uint16_t));
+    uint16_t* fused = malloc(65536 * sizeof(uint16_t));
+    uint16_t* staged = malloc(65536 * sizeof(uint16_t));
+    float* widened = malloc(65536 * sizeof(float));
+    for (uint32_t i = 0; i < 65536; i++) {
+        halves[i] = (uint16_t) i;
+    }
+
+    int result = 0;
+    for (size_t t = 0; t < sizeof(activation_halves) / sizeof(TestActivationHalf); t++) {
+        const TestActivationHalf* half = &activation_halves[t];
+
+        for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected(); level++) {
+            cpu_level_set((CpuLevel) level);
+            for (size_t offset = 1; offset <= 17; offset += 16) {
+                size_t n = 65536 - offset;
+                half->fused(function, halves + offset, fused, n);
+                half->widen(halves + offset, widened, n);
+                activate_row(function, widened, widened, n);
+                half->narrow(widened, staged, n);
+
+                if (0 != memcmp(fused, staged, n * sizeof(uint16_t))) {
+                    LOG_ERROR(
+                        "[TestActivation] %s fused function=%d, level=%s differs from the "
+                        "three-pass row",
+                        half->name,
+                        (int) function,
+                        cpu_level_name((CpuLevel) level)
+                    );
+                    result = 1;
+                }
+            }
+        }
+        cpu_level_set(cpu_level_detected());
+
+        // The table against the fused row, which is the rounded fp32 kernel.
+        half->table(function, halves, staged, 65536);
+        half->fused(function, halves, fused, 65536);
+        size_t far = 0;
+        for (uint32_t i = 0; i < 65536; i++) {
+            bool nan = (staged[i] & 0x7FFF) > half->exponent;
+            bool nan_expected = (fused[i] & 0x7FFF) > half->exponent;
+            int32_t step = abs((int32_t) staged[i] - (int32_t) fused[i]);
+            bool zeros = 0 == (staged[i] & 0x7FFF) && 0 == (fused[i] & 0x7FFF);
+            far += nan != nan_expected || (!nan && !zeros && step > 1);
+        }
+        if (far) {
+            LOG_ERROR(
+                "[TestActivation] %s table function=%d, entries off by more than one step=%zu",
+                half->name,
+                (int) function,
+                far
+            );
+            result = 1;
+        }
+    }
+
+    free(halves);
+    free(fused);
+    free(staged);
+    free(widened);
+    return result;
+}
+
+int test_suite_activation_half(void) {
+    static const ActivationFunction functions[ACTIVATION_COUNT] = {
+        ACTIVATION_RELU,
+        ACTIVATION_SIGMOID,
+        ACTIVATION_TANH,
+        ACTIVATION_SILU,
+        ACTIVATION_GELU,
+        ACTIVATION_GELU_TANH,
+    };
+
+    TestUnit units[ACTIVATION_COUNT];
+    for (size_t i = 0; i < ACTIVATION_COUNT; i++) {
+        units[i].data = &functions[i];
+    }
+
+    TestGroup group = {
+        .name = "activation_half",
+        .count = ACTIVATION_COUNT,
+        .units = units,
+        .run = test_group_activation_half,
+    };
+
+    return test_group_run(&group);
+}
+
+/**
+ * @name Softmax
+ * {@
+ */
+
+typedef struct TestSoftmax {
+    size_t length;
+    float temperature;
+} TestSoftmax;
+
+// One element, tails of every vector width, several threading chunks.
+static const TestSoftmax softmax_cases[] = {
+    {1, 1.0f},
+    {7, 1.0f},
+    {33, 0.7f},
+    {1000, 2.5f},
+    {262144 + 5, 1.0f},
+    {262144 + 5, 0.7f},
+};
+
+#define SOFTMAX_CASE_COUNT (sizeof(softmax_cases) / sizeof(TestSoftmax))
+
+// Largest error of `output` against the double reference: relative for probabilities, absolute
+// (scaled by 1 + |expected|) for logarithm-probabilities.
+static double softmax_error(
+    const float* input, const float* output, size_t length, float temperature, bool logarithm
+) {
+    double max = -INFINITY;
+    for (size_t i = 0; i < length; i++) {
+        double z = (double) input[i] / (double) temperature;
+        max = z > max ? z : max;
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < length; i++) {
+        sum += exp((double) input[i] / (double) temperature - max);
+    }
+
+    double worst = 0.0;
+    for (size_t i = 0; i < length; i++) {
+        double z = (double) input[i] / (double) temperature - max;
+        double expected = logarithm ? z - log(sum) : exp(z) / sum;
+        double error = fabs((double) output[i] - expected);
+        error /= logarithm ? 1.0 + fabs(expected) : expected;
+        worst = error > worst ? error : worst;
+    }
+    return worst;
+}
+
+static void softmax_run(
+    ThreadPool* pool,
+    const float* input,
+    float* output,
+    size_t length,
+    float temperature,
+    bool logarithm
+) {
+    if (pool) {
+        logarithm ? activate_log_softmax_parallel(pool, input, output, length, temperature)
+            : activate_softmax_parallel(pool, input, output, length, temperature);
+    } else {
+        logarithm ? activate_log_softmax_temperature(input, output, length, temperature)
+            : activate_softmax_temperature(input, output, length, temperature);
+    }
+}
+
+/**
+ * Serial, in-place and 4-thread results must match the double reference at every level; the
+ * in-place result must equal the serial one bit for bit, and the threaded result must not vary
+ * between runs.
+ */
+int test_group_activation_softmax(TestUnit* unit) {
+    const TestSoftmax* test = (const TestSoftmax*) unit->data;
+    size_t length = test->length;
+
+    float* input = malloc(length * sizeof(float));
+    float* serial = malloc(length * sizeof(float));
+    float* in_place = malloc(length * sizeof(float));
+    float* threaded = malloc(length * sizeof(float));
+    float* again = malloc(length * sizeof(float));
+    ThreadPool* pool = thread_pool_create(4);
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        input[i] = (lehmer_generate_float() - 0.5f) * 20.0f;
+    }
+
+    int result = 0;
+    for (int level = CPU_LEVEL_SCALAR; level <= (int) cpu_level_detected() && !result; level++) {
+        cpu_level_set((CpuLevel) level);
+
+        for (int logarithm = 0; logarithm < 2; logarithm++) {
+            softmax_run(NULL, input, serial, length, test->temperature, logarithm);
+            memcpy(in_place, input, length * sizeof(float));
+            softmax_run(NULL, in_place, in_place, length, test->temperature, logarithm);
+            softmax_run(pool, input, threaded, length, test->temperature, logarithm);
+            softmax_run(pool, input, again, length, test->temperature, logarithm);
+
+            float t = test->temperature;
+            double serial_error = softmax_error(input, serial, length, t, logarithm);
+            double threaded_error = softmax_error(input, threaded, length, t, logarithm);
+            bool same = 0 == memcmp(serial, in_place, length * sizeof(float));
+            bool stable = 0 == memcmp(threaded, again, length * sizeof(float));
+
+            const char* name = cpu_level_name((CpuLevel) level);
+            if (serial_error > 1e-5 || threaded_error > 1e-5 || !same || !stable) {
+                LOG_ERROR(
+                    "[TestSoftmax] length=%zu, T=%.2f, level=%s, log=%d, error=%g, threaded=%g, "
+                    "in-place %s, threaded runs %s",
+                    length,
+                    (double) test->temperature,
+                    name,
+                    logarithm,
+                    serial_error,
+                    threaded_error,
+                    same ? "matches" : "differs",
+                    stable ? "match" : "differ"
+                );
+                result = 1;
+                break;
+            }
+            LOG_INFO(
+                "[TestSoftmax] length=%zu, T=%.2f, level=%s, log=%d, error=%g, threaded=%g",
+                length,
+                (double) test->temperature,
+                name,
+                logarithm,
+                serial_error,
+                threaded_error
+            );
+        }
+    }
+
+    cpu_level_set(cpu_level_detected());
+    thread_pool_free(pool);
+    free(input);
+    free(serial);
+    free(in_place);
+    free(threaded);
+    free(again);
+    return result;
+}
+
+int test_suite_activation_softmax(void) {
+    TestUnit units[SOFTMAX_CASE_COUNT];
+    for (size_t i = 0; i < SOFTMAX_CASE_COUNT; i++) {
+        units[i].data = &softmax_cases[i];
+    }
+
+    TestGroup group = {
+        .name = "activation_softmax",
+        .count = SOFTMAX_CASE_COUNT,
+        .units = units,
+        .run = test_group_activation_softmax,
+    };
+
+    return test_group_run(&group);
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"activation_row", test_suite_activation_row},
+        {"activation_fp16", test_suite_activation_fp16},
+        {"activation_half", test_suite_activation_half},
+        {"activation_softmax", test_suite_activation_softmax},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
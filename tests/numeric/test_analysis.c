@@ -0,0 +1,450 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file tests/numeric/test_analysis.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/analysis.h"
+#include "numeric/distribution.h"
+#include "numeric/type.h"
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANALYSIS_COUNT 10007 // not a multiple of any vector width or tile
+#define ANALYSIS_PARALLEL_COUNT 100003 // several ranges of ANALYSIS_GRAIN
+
+// The comparison rule spelled out in double, independent of the kernels.
+static bool analysis_expected_close(float a, float b, float relative, float absolute) {
+    if (a == b) {
+        return true;
+    }
+    if (isnan(a) || isnan(b) || isinf(a) || isinf(b)) {
+        return false;
+    }
+    double magnitude = fmax(fabs((double) a), fabs((double) b));
+    double tolerance = fmax((double) relative * magnitude, (double) absolute);
+    return fabs((double) a - (double) b) <= tolerance;
+}
+
+static bool analysis_relative_close(double value, double expected, double tolerance) {
+    return fabs(value - expected) <= tolerance * fmax(fabs(expected), 1e-300);
+}
+
+/**
+ * @name Comparison
+ * {@
+ */
+
+int test_analysis_close(void) {
+    float* a = malloc(ANALYSIS_COUNT * sizeof(float));
+    float* b = malloc(ANALYSIS_COUNT * sizeof(float));
+    ASSERT(a && b, "[TestAnalysisClose] allocation failed");
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 7);
+    random_fill_normal(&r, a, ANALYSIS_COUNT, 0.0f, 4.0f);
+    for (size_t i = 0; i < ANALYSIS_COUNT; i++) {
+        // Relative offsets straddle the 1e-3 tolerance; every 13th pair is an edge case.
+        b[i] = a[i] * (1.0f + (random_float(&r) - 0.5f) * 4e-3f);
+        switch (i % 13) {
+            case 0:
+                b[i] = a[i];
+                break;
+            case 1:
+                a[i] = b[i] = INFINITY;
+                break;
+            case 2:
+                a[i] = -INFINITY;
+                break;
+            case 3:
+                b[i] = NAN;
+                break;
+            case 4:
+                a[i] = b[i] = NAN;
+                break;
+            case 5:
+                a[i] = 1e-7f;
+                b[i] = -1e-7f; // only the absolute tolerance covers values near zero
+                break;
+            default:
+                break;
+        }
+    }
+
+    const float relative = 1e-3f;
+    const float absolute = 1e-6f;
+    size_t expected = 0;
+    size_t first = ANALYSIS_COUNT;
+    for (size_t i = 0; i < ANALYSIS_COUNT; i++) {
+        bool close = analysis_expected_close(a[i], b[i], relative, absolute);
+        expected += close;
+        first = (!close && first == ANALYSIS_COUNT) ? i : first;
+    }
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        const char* name = cpu_level_name(level);
+
+        size_t count = analysis_close_count(a, b, ANALYSIS_COUNT, relative, absolute);
+        ASSERT(
+            expected == count,
+            "[TestAnalysisClose] %s: count=%zu, expected=%zu",
+            name,
+            count,
+            expected
+        );
+
+        size_t far = analysis_find_far(a, b, ANALYSIS_COUNT, relative, absolute);
+        ASSERT(first == far, "[TestAnalysisClose] %s: far=%zu, expected=%zu", name, far, first);
+
+        // Rows that match up to one far pair placed in the vector body and in the tail.
+        for (size_t at = 0; at < 40; at += 3) {
+            float x[40];
+            float y[40];
+            for (size_t i = 0; i < 40; i++) {
+                x[i] = y[i] = (float) i - 20.0f;
+            }
+            y[at] += 1.0f;
+            far = analysis_find_far(x, y, 40, relative, absolute);
+            ASSERT(at == far, "[TestAnalysisClose] %s: far=%zu, expected=%zu", name, far, at);
+            count = analysis_close_count(x, y, 40, relative, absolute);
+            ASSERT(39 == count, "[TestAnalysisClose] %s: count=%zu, expected=39", name, count);
+        }
+        ASSERT(0 == analysis_find_far(a, b, 0, relative, absolute), "[TestAnalysisClose] empty");
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(a);
+    free(b);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Error Statistics
+ * {@
+ */
+
+int test_analysis_ulp(void) {
+    const float tiny = FLT_TRUE_MIN;
+    ASSERT(0 == analysis_ulp_distance(0.0f, -0.0f), "[TestAnalysisUlp] signed zeros");
+    ASSERT(1 == analysis_ulp_distance(1.0f, nextafterf(1.0f, 2.0f)), "[TestAnalysisUlp] next");
+    ASSERT(1 == analysis_ulp_distance(1.0f, nextafterf(1.0f, 0.0f)), "[TestAnalysisUlp] prior");
+    ASSERT(2 == analysis_ulp_distance(-tiny, tiny), "[TestAnalysisUlp] across zero");
+    ASSERT(
+        1 == analysis_ulp_distance(FLT_MAX, INFINITY), "[TestAnalysisUlp] largest to infinity"
+    );
+    ASSERT(
+        0xFF000000u == analysis_ulp_distance(-INFINITY, INFINITY),
+        "[TestAnalysisUlp] infinity to infinity"
+    );
+    ASSERT(UINT32_MAX == analysis_ulp_distance(NAN, 1.0f), "[TestAnalysisUlp] NaN");
+    ASSERT(
+        (1u << 23) == analysis_ulp_distance(1.0f, 2.0f), "[TestAnalysisUlp] one binade apart"
+    );
+    return 0;
+}
+
+int test_analysis_stats(void) {
+    float* x = malloc(ANALYSIS_COUNT * sizeof(float));
+    float* y = malloc(ANALYSIS_COUNT * sizeof(float));
+    ASSERT(x && y, "[TestAnalysisStats] allocation failed");
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 11);
+    random_fill_uniform(&r, x, ANALYSIS_COUNT, 1.0f, 2.0f);
+
+    AnalysisStats stats;
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        const char* name = cpu_level_name(level);
+
+        // An exact copy.
+        analysis_compare(NULL, x, x, ANALYSIS_COUNT, &stats);
+        ASSERT(
+            0.0 == stats.max_abs && 0.0 == stats.rmse && isinf(stats.snr_db) && stats.snr_db > 0.0
+                && 1.0 == stats.cosine && ANALYSIS_COUNT == stats.ulp[0] && 0 == stats.ulp_max,
+            "[TestAnalysisStats] %s: copy max_abs=%g snr=%g cosine=%g",
+            name,
+            stats.max_abs,
+            stats.snr_db,
+            stats.cosine
+        );
+
+        // One step up everywhere: every pair one ULP apart, and the moments computed in double.
+        double error = 0.0;
+        double reference = 0.0;
+        double max_abs = 0.0;
+        for (size_t i = 0; i < ANALYSIS_COUNT; i++) {
+            y[i] = nextafterf(x[i], 4.0f);
+            double e = (double) y[i] - (double) x[i];
+            error += e * e;
+            reference += (double) x[i] * (double) x[i];
+            max_abs = fmax(max_abs, fabs(e));
+        }
+        analysis_compare(NULL, x, y, ANALYSIS_COUNT, &stats);
+        double rmse = sqrt(error / ANALYSIS_COUNT);
+        double snr = 10.0 * log10(reference / error);
+        ASSERT(
+            max_abs == stats.max_abs && analysis_relative_close(stats.rmse, rmse, 1e-12)
+                && analysis_relative_close(stats.snr_db, snr, 1e-12),
+            "[TestAnalysisStats] %s: max_abs=%g (%g) rmse=%g (%g) snr=%g (%g)",
+            name,
+            stats.max_abs,
+            max_abs,
+            stats.rmse,
+            rmse,
+            stats.snr_db,
+            snr
+        );
+        ASSERT(
+            ANALYSIS_COUNT == stats.ulp[1] && 1 == stats.ulp_max
+                && 1 == analysis_ulp_percentile(&stats, 0.5),
+            "[TestAnalysisStats] %s: ulp[1]=%zu ulp_max=%u",
+            name,
+            stats.ulp[1],
+            stats.ulp_max
+        );
+
+        // A negated row points the other way; NaN is set aside and skipped by max_abs.
+        for (size_t i = 0; i < ANALYSIS_COUNT; i++) {
+            y[i] = -x[i];
+        }
+        analysis_compare(NULL, x, y, ANALYSIS_COUNT, &stats);
+        ASSERT(
+            analysis_relative_close(stats.cosine, -1.0, 1e-12) && 0 == stats.ulp[0],
+            "[TestAnalysisStats] %s: cosine=%g",
+            name,
+            stats.cosine
+        );
+        y[5] = NAN;
+        analysis_compare(NULL, x, y, ANALYSIS_COUNT, &stats);
+        ASSERT(
+            1 == stats.unordered && isnan(stats.rmse) && stats.max_abs >= 2.0,
+            "[TestAnalysisStats] %s: unordered=%zu rmse=%g max_abs=%g",
+            name,
+            stats.unordered,
+            stats.rmse,
+            stats.max_abs
+        );
+    }
+    cpu_level_set(cpu_level_detected());
+
+    // A zero reference has no signal; two zero rows point the same way.
+    float zeros[8] = {0};
+    float ones[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+    analysis_compare(NULL, zeros, ones, 8, &stats);
+    ASSERT(
+        isinf(stats.snr_db) && stats.snr_db < 0.0 && 0.0 == stats.cosine,
+        "[TestAnalysisStats] zero reference snr=%g cosine=%g",
+        stats.snr_db,
+        stats.cosine
+    );
+    analysis_compare(NULL, zeros, zeros, 8, &stats);
+    ASSERT(1.0 == stats.cosine, "[TestAnalysisStats] zero rows cosine=%g", stats.cosine);
+
+    free(x);
+    free(y);
+    return 0;
+}
+
+int test_analysis_parallel(void) {
+    float* x = malloc(ANALYSIS_PARALLEL_COUNT * sizeof(float));
+    float* y = malloc(ANALYSIS_PARALLEL_COUNT * sizeof(float));
+    ThreadPool* pool = thread_pool_create(4);
+    ASSERT(x && y && pool, "[TestAnalysisParallel] allocation failed");
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 13);
+    random_fill_normal(&r, x, ANALYSIS_PARALLEL_COUNT, 0.0f, 1.0f);
+    for (size_t i = 0; i < ANALYSIS_PARALLEL_COUNT; i++) {
+        y[i] = dequantize_scalar_bf16(quantize_scalar_bf16(x[i]));
+    }
+
+    AnalysisStats serial;
+    AnalysisStats parallel;
+    analysis_compare(NULL, x, y, ANALYSIS_PARALLEL_COUNT, &serial);
+    analysis_compare(pool, x, y, ANALYSIS_PARALLEL_COUNT, &parallel);
+
+    // Ranges change the order of the double sums only; counts and extrema match exactly.
+    size_t failures = 0;
+    failures += serial.max_abs != parallel.max_abs;
+    failures += serial.ulp_max != parallel.ulp_max;
+    failures += !analysis_relative_close(parallel.rmse, serial.rmse, 1e-12);
+    failures += !analysis_relative_close(parallel.snr_db, serial.snr_db, 1e-12);
+    failures += !analysis_relative_close(parallel.cosine, serial.cosine, 1e-12);
+    for (size_t k = 0; k < ANALYSIS_ULP_BINS; k++) {
+        failures += serial.ulp[k] != parallel.ulp[k];
+    }
+
+    // bf16 keeps 8 significant bits, so no pair is more than half of 2^16 ULPs apart.
+    failures += serial.ulp_max > (1u << 15);
+
+    AnalysisStats again;
+    analysis_compare(pool, x, y, ANALYSIS_PARALLEL_COUNT, &again);
+    failures += again.rmse != parallel.rmse || again.cosine != parallel.cosine;
+
+    thread_pool_free(pool);
+    free(x);
+    free(y);
+    ASSERT(0 == failures, "[TestAnalysisParallel] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Round Trips
+ * {@
+ */
+
+int test_analysis_round_trip(void) {
+    float* x = malloc(ANALYSIS_COUNT * sizeof(float));
+    ASSERT(x, "[TestAnalysisRoundTrip] allocation failed");
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 17);
+    analysis_fill(&r, x, ANALYSIS_COUNT, ANALYSIS_NORMAL, 1.0f);
+
+    AnalysisReport report;
+    ASSERT(
+        analysis_round_trip(NULL, x, ANALYSIS_COUNT, TYPE_FLOAT32, 2, &report),
+        "[TestAnalysisRoundTrip] fp32 failed"
+    );
+    ASSERT(
+        0.0 == report.stats.max_abs && 32.0 == report.bits_per_value
+            && report.quantize_seconds >= 0.0 && report.dequantize_seconds >= 0.0,
+        "[TestAnalysisRoundTrip] fp32 max_abs=%g bits=%g",
+        report.stats.max_abs,
+        report.bits_per_value
+    );
+
+    // Half-precision rounding stays within half an ULP of the narrow format.
+    ASSERT(
+        analysis_round_trip(NULL, x, ANALYSIS_COUNT, TYPE_FLOAT16, 1, &report),
+        "[TestAnalysisRoundTrip] fp16 failed"
+    );
+    ASSERT(
+        16.0 == report.bits_per_value && report.stats.cosine > 0.99999,
+        "[TestAnalysisRoundTrip] fp16 bits=%g cosine=%g",
+        report.bits_per_value,
+        report.stats.cosine
+    );
+
+    // Every quantized type agrees with quantize_row_error() and loses accuracy with its bits.
+    const DataTypeId types[] = {
+        TYPE_BFLOAT16,
+        TYPE_QUANT8,
+        TYPE_BLOCK_Q8,
+        TYPE_FLOAT8_E4M3,
+        TYPE_BLOCK_Q4,
+        TYPE_QUANT4,
+    };
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        DataTypeId id = types[t];
+        QuantizeError error;
+        ASSERT(
+            analysis_round_trip(NULL, x, ANALYSIS_COUNT, id, 1, &report)
+                && quantize_row_error(x, ANALYSIS_COUNT, id, &error),
+            "[TestAnalysisRoundTrip] %s failed",
+            data_type_name(id)
+        );
+        ASSERT(
+            report.bytes == error.bytes && report.stats.max_abs == error.max_abs
+                && analysis_relative_close(report.stats.rmse, error.rmse, 1e-9),
+            "[TestAnalysisRoundTrip] %s: rmse=%g (%g) max_abs=%g (%g)",
+            data_type_name(id),
+            report.stats.rmse,
+            error.rmse,
+            report.stats.max_abs,
+            error.max_abs
+        );
+        ASSERT(
+            report.stats.snr_db > 5.0 && report.stats.cosine > 0.9,
+            "[TestAnalysisRoundTrip] %s: snr=%g cosine=%g",
+            data_type_name(id),
+            report.stats.snr_db,
+            report.stats.cosine
+        );
+    }
+
+    ASSERT(
+        !analysis_round_trip(NULL, x, ANALYSIS_COUNT, TYPE_COUNT, 1, &report)
+            && !analysis_round_trip(NULL, x, 0, TYPE_FLOAT16, 1, &report),
+        "[TestAnalysisRoundTrip] accepted an unknown type or an empty row"
+    );
+
+    free(x);
+    return 0;
+}
+
+int test_analysis_fill(void) {
+    float* x = malloc(ANALYSIS_PARALLEL_COUNT * sizeof(float));
+    ASSERT(x, "[TestAnalysisFill] allocation failed");
+
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 19);
+    for (AnalysisDistribution d = ANALYSIS_UNIFORM; d < ANALYSIS_DISTRIBUTION_COUNT; d++) {
+        analysis_fill(&r, x, ANALYSIS_PARALLEL_COUNT, d, 2.0f);
+        double sum = 0.0;
+        double squares = 0.0;
+        double largest = 0.0;
+        for (size_t i = 0; i < ANALYSIS_PARALLEL_COUNT; i++) {
+            sum += (double) x[i];
+            squares += (double) x[i] * (double) x[i];
+            largest = fmax(largest, fabs((double) x[i]));
+        }
+        double mean = sum / ANALYSIS_PARALLEL_COUNT;
+        double variance = squares / ANALYSIS_PARALLEL_COUNT - mean * mean;
+
+        // Uniform on [-2, 2) has variance 4/3; the outliers lift the normal variance well above 4.
+        double expected = ANALYSIS_UNIFORM == d ? 4.0 / 3.0 : 4.0;
+        bool spread = ANALYSIS_OUTLIER == d ? variance > 8.0 && largest > 64.0
+                                            : fabs(variance - expected) < 0.05 * expected;
+        ASSERT(
+            fabs(mean) < 0.05 && spread,
+            "[TestAnalysisFill] %s: mean=%g variance=%g largest=%g",
+            analysis_distribution_name(d),
+            mean,
+            variance,
+            largest
+        );
+    }
+    ASSERT(
+        0 == strcmp("unknown", analysis_distribution_name(ANALYSIS_DISTRIBUTION_COUNT)),
+        "[TestAnalysisFill] name of an unknown distribution"
+    );
+
+    free(x);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"analysis_close", test_analysis_close},
+        {"analysis_ulp", test_analysis_ulp},
+        {"analysis_stats", test_analysis_stats},
+        {"analysis_parallel", test_analysis_parallel},
+        {"analysis_round_trip", test_analysis_round_trip},
+        {"analysis_fill", test_analysis_fill},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
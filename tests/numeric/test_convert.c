@@ -0,0 +1,531 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_convert.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/convert.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Several tiles plus a tail that is odd and not a multiple of any vector width or block.
+#define CONVERT_LENGTH 3001
+#define CONVERT_RANDOM_COUNT 100003
+
+static const CpuLevel convert_levels[] = {
+    CPU_LEVEL_SCALAR,
+    CPU_LEVEL_SSE2,
+    CPU_LEVEL_AVX2,
+    CPU_LEVEL_AVX512,
+};
+
+#define CONVERT_LEVEL_COUNT (sizeof(convert_levels) / sizeof(CpuLevel))
+
+typedef struct ConvertRange {
+    DataTypeId id;
+    int64_t lo;
+    int64_t hi;
+} ConvertRange;
+
+static const ConvertRange convert_ranges[] = {
+    {TYPE_INT32, INT32_MIN, INT32_MAX},
+    {TYPE_INT16, INT16_MIN, INT16_MAX},
+    {TYPE_INT8, INT8_MIN, INT8_MAX},
+    {TYPE_UINT32, 0, UINT32_MAX},
+    {TYPE_UINT16, 0, UINT16_MAX},
+    {TYPE_UINT8, 0, UINT8_MAX},
+    {TYPE_CHAR, 0, UINT8_MAX},
+    {TYPE_BOOL, 0, 1},
+};
+
+#define CONVERT_RANGE_COUNT (sizeof(convert_ranges) / sizeof(ConvertRange))
+
+static const ConvertRange* convert_range(DataTypeId id) {
+    for (size_t i = 0; i < CONVERT_RANGE_COUNT; i++) {
+        if (convert_ranges[i].id == id) {
+            return &convert_ranges[i];
+        }
+    }
+    return NULL;
+}
+
+static int64_t convert_read(const void* row, DataTypeId id, size_t i) {
+    switch (id) {
+        case TYPE_INT32:
+            return ((const int32_t*) row)[i];
+        case TYPE_INT16:
+            return ((const int16_t*) row)[i];
+        case TYPE_INT8:
+            return ((const int8_t*) row)[i];
+        case TYPE_UINT32:
+            return ((const uint32_t*) row)[i];
+        case TYPE_UINT16:
+            return ((const uint16_t*) row)[i];
+        case TYPE_BOOL:
+            return ((const uint8_t*) row)[i] != 0;
+        default:
+            return ((const uint8_t*) row)[i];
+    }
+}
+
+// Independent of the library: round in double, then saturate.
+static int64_t convert_expected(float x, const ConvertRange* range) {
+    if (TYPE_BOOL == range->id) {
+        return x != 0.0f;
+    }
+    if (isnan(x)) {
+        return 0;
+    }
+    double r = nearbyint((double) x);
+    return r < (double) range->lo ? range->lo : (r > (double) range->hi ? range->hi : (int64_t) r);
+}
+
+static float convert_random_float(void) {
+    uint32_t bits = (uint32_t) lehmer_generate_int32() ^ ((uint32_t) lehmer_generate_int32() << 16);
+    int exponent = (int) (bits % 40) - 4; // mostly in and around the integer ranges
+    float x = ldexpf(lehmer_generate_float(), exponent);
+    if (bits & 0x100) {
+        x = nearbyintf(x * 2.0f) * 0.5f; // halfway cases
+    }
+    return bits & 0x200 ? -x : x;
+}
+
+// QuantBits has a padding byte, so Q8 and Q4 rows are compared by field.
+static bool convert_same(const void* a, const void* b, DataTypeId id, size_t length) {
+    if (TYPE_QUANT8 == id || TYPE_QUANT4 == id) {
+        const QuantBits* x = a;
+        const QuantBits* y = b;
+        size_t count = data_type_row_size(id, length) / sizeof(QuantBits);
+        for (size_t i = 0; i < count; i++) {
+            if (x[i].bits != y[i].bits || x[i].scalar != y[i].scalar) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return 0 == memcmp(a, b, data_type_row_size(id, length));
+}
+
+/**
+ * @name fp32 Codecs
+ * {@
+ */
+
+int test_group_convert_codec(TestUnit* unit) {
+    CpuLevel level = *(const CpuLevel*) unit->data;
+    if (level > cpu_level_detected()) {
+        LOG_INFO("[TestConvertCodec] level=%s not supported, skipped", cpu_level_name(level));
+        return 0;
+    }
+
+    const float specials[] = {
+        NAN,          -NAN,          HUGE_VALF,     -HUGE_VALF,    0.0f,          -0.0f,
+        FLT_MIN,      -FLT_MIN,      0x1.0p-149f,   0.5f,          1.5f,          2.5f,
+        -0.5f,        -1.5f,         -2.5f,         126.5f,        127.5f,        128.0f,
+        -128.5f,      -129.0f,       254.5f,        255.5f,        256.0f,        32766.5f,
+        32767.5f,     32768.0f,      -32768.5f,     -32769.0f,     65534.5f,      65535.5f,
+        65536.0f,     2147483520.0f, 0x1.0p31f,     -0x1.0p31f,    -2147483904.0f, 4294967040.0f,
+        0x1.0p32f,    0x1.0p40f,     -0x1.0p40f,    FLT_MAX,       -FLT_MAX,      16777217.0f,
+    };
+    size_t special_count = sizeof(specials) / sizeof(specials[0]);
+    size_t n = special_count + CONVERT_RANDOM_COUNT;
+
+    float* input = malloc((n + 1) * sizeof(float));
+    uint8_t* encoded = malloc(n * sizeof(uint32_t));
+    float* decoded = malloc(n * sizeof(float));
+
+    memcpy(input + 1, specials, sizeof(specials));
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = special_count; i < n; i++) {
+        input[i + 1] = convert_random_float();
+    }
+
+    cpu_level_set(level);
+
+    size_t failures = 0;
+    for (size_t r = 0; r < CONVERT_RANGE_COUNT; r++) {
+        const ConvertRange* range = &convert_ranges[r];
+        size_t encode_errors = 0;
+        size_t decode_errors = 0;
+
+        // Offset by one element so vector loads are misaligned.
+        convert_row(input + 1, TYPE_FLOAT32, encoded, range->id, n);
+        for (size_t i = 0; i < n; i++) {
+            int64_t got = convert_read(encoded, range->id, i);
+            int64_t expected = convert_expected(input[i + 1], range);
+            if (got != expected && encode_errors++ < 4) {
+                LOG_ERROR(
+                    "[TestConvertCodec] %s: x=%a, expected=%lld, got=%lld",
+                    data_type_name(range->id),
+                    (double) input[i + 1],
+                    (long long) expected,
+                    (long long) got
+                );
+            }
+        }
+
+        // Random raw bytes; bool reads any non-zero byte as true.
+        for (size_t i = 0; i < n * data_type_size(range->id); i++) {
+            encoded[i] = (uint8_t) lehmer_generate_int32();
+        }
+        convert_row(encoded, range->id, decoded, TYPE_FLOAT32, n);
+        for (size_t i = 0; i < n; i++) {
+            decode_errors += decoded[i] != (float) convert_read(encoded, range->id, i);
+        }
+
+        if (encode_errors || decode_errors) {
+            LOG_ERROR(
+                "[TestConvertCodec] level=%s, %s: encode errors=%zu, decode errors=%zu",
+                cpu_level_name(level),
+                data_type_name(range->id),
+                encode_errors,
+                decode_errors
+            );
+            failures++;
+        }
+    }
+
+    cpu_level_set(cpu_level_detected());
+    free(input);
+    free(encoded);
+    free(decoded);
+
+    ASSERT(
+        0 == failures,
+        "[TestConvertCodec] level=%s, %zu types failed",
+        cpu_level_name(level),
+        failures
+    );
+
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Type Pairs
+ * {@
+ */
+
+typedef struct ConvertRows {
+    uint8_t* rows[TYPE_COUNT]; // one source row per type
+    size_t length;
+} ConvertRows;
+
+// Source rows span each type's range so that conversions saturate.
+static ConvertRows convert_rows_generate(size_t length) {
+    ConvertRows data = {.length = length};
+    float* values = malloc(length * sizeof(float));
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        values[i] = convert_random_float();
+    }
+    values[0] = 0x1.0p31f;
+    values[1] = -1.0f;
+    values[2] = 0.0f;
+
+    // The floating and quantized rows stay finite: block scales are fp16.
+    float* finite = malloc(length * sizeof(float));
+    for (size_t i = 0; i < length; i++) {
+        finite[i] = fmaxf(fminf(values[i], 60000.0f), -60000.0f);
+    }
+
+    for (int id = 0; id < TYPE_COUNT; id++) {
+        DataTypeId type = (DataTypeId) id;
+        data.rows[id] = calloc(1, data_type_row_size(type, length));
+        const float* source = convert_range(type) ? values : finite;
+        convert_row(source, TYPE_FLOAT32, data.rows[id], type, length);
+    }
+    // 32-bit integers above 2^24 that fp32 cannot hold.
+    int32_t* i32 = (int32_t*) data.rows[TYPE_INT32];
+    uint32_t* u32 = (uint32_t*) data.rows[TYPE_UINT32];
+    for (size_t i = 0; i < length; i += 7) {
+        i32[i] = (int32_t) ((uint32_t) lehmer_generate_int32() << 1 | 1);
+        u32[i] = (uint32_t) lehmer_generate_int32() << 1 | 1;
+    }
+
+    free(values);
+    free(finite);
+    return data;
+}
+
+static void convert_rows_release(ConvertRows* data) {
+    for (int id = 0; id < TYPE_COUNT; id++) {
+        free(data->rows[id]);
+    }
+}
+
+/**
+ * Expected output of one pair, computed at the scalar level: a copy for equal types, exact
+ * saturation for integer pairs, otherwise the two halves through fp32.
+ */
+static void convert_pair_expected(
+    const ConvertRows* data, DataTypeId input_type, DataTypeId output_type, void* expected
+) {
+    size_t length = data->length;
+    const uint8_t* input = data->rows[input_type];
+    const ConvertRange* in = convert_range(input_type);
+    const ConvertRange* out = convert_range(output_type);
+
+    if (input_type == output_type) {
+        memcpy(expected, input, data_type_row_size(input_type, length));
+    } else if (in && out) {
+        for (size_t i = 0; i < length; i++) {
+            int64_t v = convert_read(input, input_type, i);
+            if (TYPE_BOOL == output_type) {
+                v = v != 0;
+            } else {
+                v = v < out->lo ? out->lo : (v > out->hi ? out->hi : v);
+            }
+            switch (data_type_size(output_type)) {
+                case 4:
+                    ((uint32_t*) expected)[i] = (uint32_t) v;
+                    break;
+                case 2:
+                    ((uint16_t*) expected)[i] = (uint16_t) v;
+                    break;
+                default:
+                    ((uint8_t*) expected)[i] = (uint8_t) v;
+                    break;
+            }
+        }
+    } else {
+        float* values = malloc(length * sizeof(float));
+        convert_row(input, input_type, values, TYPE_FLOAT32, length);
+        convert_row(values, TYPE_FLOAT32, expected, output_type, length);
+        free(values);
+    }
+}
+
+int test_group_convert_pairs(TestUnit* unit) {
+    CpuLevel level = *(const CpuLevel*) unit->data;
+    if (level > cpu_level_detected()) {
+        LOG_INFO("[TestConvertPairs] level=%s not supported, skipped", cpu_level_name(level));
+        return 0;
+    }
+
+    ConvertRows data = convert_rows_generate(CONVERT_LENGTH);
+    size_t capacity = data_type_row_size(TYPE_BLOCK_Q8, CONVERT_LENGTH) + sizeof(uint32_t)
+                      * CONVERT_LENGTH;
+    uint8_t* expected = calloc(1, capacity);
+    uint8_t* got = calloc(1, capacity);
+
+    size_t failures = 0;
+    for (int i = 0; i < TYPE_COUNT; i++) {
+        for (int o = 0; o < TYPE_COUNT; o++) {
+            DataTypeId input_type = (DataTypeId) i;
+            DataTypeId output_type = (DataTypeId) o;
+
+            cpu_level_set(CPU_LEVEL_SCALAR);
+            convert_pair_expected(&data, input_type, output_type, expected);
+
+            cpu_level_set(level);
+            bool ok = convert_row(data.rows[i], input_type, got, output_type, CONVERT_LENGTH);
+            if (!ok || !convert_same(expected, got, output_type, CONVERT_LENGTH)) {
+                LOG_ERROR(
+                    "[TestConvertPairs] level=%s, %s -> %s mismatch",
+                    cpu_level_name(level),
+                    data_type_name(input_type),
+                    data_type_name(output_type)
+                );
+                failures++;
+            }
+        }
+    }
+
+    cpu_level_set(cpu_level_detected());
+    convert_rows_release(&data);
+    free(expected);
+    free(got);
+
+    ASSERT(
+        0 == failures,
+        "[TestConvertPairs] level=%s, %zu of %d pairs failed",
+        cpu_level_name(level),
+        failures,
+        TYPE_COUNT * TYPE_COUNT
+    );
+
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Strided Rows
+ * {@
+ */
+
+#define CONVERT_STRIDED_ROWS 37
+#define CONVERT_LONG_LENGTH 300001 // several scheduling chunks
+#define CONVERT_PAD 64 // bytes between rows, which must stay untouched
+
+static const DataTypeId convert_strided_pairs[][2] = {
+    {TYPE_FLOAT32, TYPE_BLOCK_Q4},
+    {TYPE_FLOAT16, TYPE_INT8},
+    {TYPE_BLOCK_Q8, TYPE_BFLOAT16},
+    {TYPE_INT32, TYPE_UINT16},
+    {TYPE_QUANT4, TYPE_FLOAT32},
+    {TYPE_UINT8, TYPE_BOOL},
+};
+
+#define CONVERT_STRIDED_COUNT (sizeof(convert_strided_pairs) / sizeof(convert_strided_pairs[0]))
+
+int test_convert_rows(void) {
+    ThreadPool* pool = thread_pool_create(4);
+    size_t failures = 0;
+
+    for (size_t p = 0; p < CONVERT_STRIDED_COUNT; p++) {
+        DataTypeId input_type = convert_strided_pairs[p][0];
+        DataTypeId output_type = convert_strided_pairs[p][1];
+
+        // Strided rows, serial and threaded.
+        ConvertRows data = convert_rows_generate(CONVERT_LENGTH);
+        size_t input_stride = data_type_row_size(input_type, CONVERT_LENGTH) + CONVERT_PAD;
+        size_t output_row = data_type_row_size(output_type, CONVERT_LENGTH);
+        size_t output_stride = output_row + CONVERT_PAD;
+
+        uint8_t* input = malloc(input_stride * CONVERT_STRIDED_ROWS);
+        uint8_t* expected = malloc(output_row);
+        uint8_t* got = malloc(output_stride * CONVERT_STRIDED_ROWS);
+        for (size_t r = 0; r < CONVERT_STRIDED_ROWS; r++) {
+            // Rotating the source row by whole storage units gives every row different contents.
+            size_t bytes = input_stride - CONVERT_PAD;
+            size_t unit = data_type_size(input_type);
+            size_t shift = r % (bytes / unit) * unit;
+            memcpy(input + r * input_stride, data.rows[input_type] + shift, bytes - shift);
+            memcpy(input + r * input_stride + bytes - shift, data.rows[input_type], shift);
+        }
+
+        for (int threaded = 0; threaded < 2; threaded++) {
+            memset(got, 0xA5, output_stride * CONVERT_STRIDED_ROWS);
+            convert_rows(
+                threaded ? pool : NULL,
+                input,
+                input_type,
+                input_stride,
+                got,
+                output_type,
+                output_stride,
+                CONVERT_STRIDED_ROWS,
+                CONVERT_LENGTH
+            );
+
+            for (size_t r = 0; r < CONVERT_STRIDED_ROWS; r++) {
+                const uint8_t* row = input + r * input_stride;
+                convert_row(row, input_type, expected, output_type, CONVERT_LENGTH);
+                bool same = convert_same(
+                    expected, got + r * output_stride, output_type, CONVERT_LENGTH
+                );
+                for (size_t b = 0; b < CONVERT_PAD; b++) {
+                    same &= 0xA5 == got[r * output_stride + output_row + b];
+                }
+                if (!same) {
+                    LOG_ERROR(
+                        "[TestConvertRows] %s -> %s, row=%zu, threaded=%d mismatch",
+                        data_type_name(input_type),
+                        data_type_name(output_type),
+                        r,
+                        threaded
+                    );
+                    failures++;
+                    break;
+                }
+            }
+        }
+
+        convert_rows_release(&data);
+        free(input);
+        free(expected);
+        free(got);
+
+        // One long row split into chunks over the pool.
+        data = convert_rows_generate(CONVERT_LONG_LENGTH);
+        output_row = data_type_row_size(output_type, CONVERT_LONG_LENGTH);
+        expected = calloc(1, output_row);
+        got = calloc(1, output_row);
+
+        convert_row(data.rows[input_type], input_type, expected, output_type, CONVERT_LONG_LENGTH);
+        convert_rows(
+            pool,
+            data.rows[input_type],
+            input_type,
+            0,
+            got,
+            output_type,
+            0,
+            1,
+            CONVERT_LONG_LENGTH
+        );
+        if (!convert_same(expected, got, output_type, CONVERT_LONG_LENGTH)) {
+            LOG_ERROR(
+                "[TestConvertRows] %s -> %s, long row mismatch",
+                data_type_name(input_type),
+                data_type_name(output_type)
+            );
+            failures++;
+        }
+
+        convert_rows_release(&data);
+        free(expected);
+        free(got);
+    }
+
+    thread_pool_free(pool);
+
+    ASSERT(0 == failures, "[TestConvertRows] %zu cases failed", failures);
+
+    return 0;
+}
+
+/** @} */
+
+static int convert_level_suite_run(const char* name, TestUnitHook run) {
+    TestUnit units[CONVERT_LEVEL_COUNT];
+    for (size_t i = 0; i < CONVERT_LEVEL_COUNT; i++) {
+        units[i].data = &convert_levels[i];
+    }
+
+    TestGroup group = {
+        .name = name,
+        .count = CONVERT_LEVEL_COUNT,
+        .units = units,
+        .run = run,
+    };
+
+    return test_group_run(&group);
+}
+
+int test_suite_convert_codec(void) {
+    return convert_level_suite_run("convert_codec", test_group_convert_codec);
+}
+
+int test_suite_convert_pairs(void) {
+    return convert_level_suite_run("convert_pairs", test_group_convert_pairs);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"convert_codec", test_suite_convert_codec},
+        {"convert_pairs", test_suite_convert_pairs},
+        {"convert_rows", test_convert_rows},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,400 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_distribution.c
+ */
+
+#include "core/logger.h"
+#include "core/cpu.h"
+#include "test/unit.h"
+#include "numeric/activation.h"
+#include "numeric/distribution.h"
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DISTRIBUTION_SAMPLES 200000
+
+// Sample mean and variance.
+static void distribution_moments(const float* x, size_t n, double* mean, double* variance) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (double) x[i];
+    }
+    *mean = sum / (double) n;
+
+    double squares = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = (double) x[i] - *mean;
+        squares += d * d;
+    }
+    *variance = squares / (double) (n - 1);
+}
+
+/**
+ * @name Uniform
+ * {@
+ */
+
+int test_distribution_uniform(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 1);
+
+    // Every residue of a small bound within 5% of its share.
+    enum { BOUND = 7 };
+    static uint32_t values[DISTRIBUTION_SAMPLES];
+    size_t counts[BOUND] = {0};
+    random_fill_bounded(&r, values, DISTRIBUTION_SAMPLES, BOUND);
+    for (size_t i = 0; i < DISTRIBUTION_SAMPLES; i++) {
+        failures += values[i] >= BOUND;
+        counts[values[i] % BOUND]++;
+    }
+    for (size_t i = 0; i < BOUND; i++) {
+        failures += fabs((double) counts[i] * BOUND / DISTRIBUTION_SAMPLES - 1.0) > 0.05;
+    }
+
+    // A bound just above 2^31 rejects almost half of the raw draws.
+    uint32_t wide = 0x80000001u;
+    uint32_t above = 0;
+    for (size_t i = 0; i < 10000; i++) {
+        uint32_t v = random_bounded_u32(&r, wide);
+        failures += v >= wide;
+        above += v >= 0x40000000u;
+    }
+    failures += fabs(above / 10000.0 - 0.5) > 0.03;
+
+    failures += 0 != random_bounded_u32(&r, 1) || 0 != random_bounded_u64(&r, 1);
+    for (size_t i = 0; i < 1000; i++) {
+        failures += random_bounded_u64(&r, UINT64_MAX) == UINT64_MAX;
+        int64_t v = random_range(&r, INT64_MIN, INT64_MIN + 3);
+        failures += v < INT64_MIN || v >= INT64_MIN + 3;
+        v = random_range(&r, -5, 5);
+        failures += v < -5 || v >= 5;
+    }
+
+    int32_t* ranged = (int32_t*) values;
+    random_fill_range(&r, ranged, 1000, -3, 4);
+    for (size_t i = 0; i < 1000; i++) {
+        failures += ranged[i] < -3 || ranged[i] >= 4;
+    }
+    random_fill_range(&r, ranged, 1000, INT32_MIN, INT32_MAX);
+    for (size_t i = 0; i < 1000; i++) {
+        failures += INT32_MAX == ranged[i];
+    }
+
+    static float uniform[DISTRIBUTION_SAMPLES];
+    random_fill_uniform(&r, uniform, DISTRIBUTION_SAMPLES, -2.0f, 6.0f);
+    for (size_t i = 0; i < DISTRIBUTION_SAMPLES; i++) {
+        failures += uniform[i] < -2.0f || uniform[i] >= 6.0f;
+    }
+    double mean, variance;
+    distribution_moments(uniform, DISTRIBUTION_SAMPLES, &mean, &variance);
+    failures += fabs(mean - 2.0) > 0.03 || fabs(variance - 64.0 / 12.0) > 0.05;
+
+    // Rounding up to `high` is clamped.
+    random_fill_uniform(&r, uniform, 1000, 1.0f, 1.0f + 0x1.0p-23f);
+    for (size_t i = 0; i < 1000; i++) {
+        failures += 1.0f != uniform[i];
+    }
+
+    // Bounds further apart than FLT_MAX still spread over the whole range.
+    random_fill_uniform(&r, uniform, 1000, -FLT_MAX, FLT_MAX);
+    float lowest = FLT_MAX;
+    float highest = -FLT_MAX;
+    for (size_t i = 0; i < 1000; i++) {
+        failures += !isfinite(uniform[i]);
+        lowest = fminf(lowest, uniform[i]);
+        highest = fmaxf(highest, uniform[i]);
+    }
+    failures += lowest > -0.9f * FLT_MAX || highest < 0.9f * FLT_MAX;
+
+    ASSERT(0 == failures, "[TestDistributionUniform] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Normal and Exponential
+ * {@
+ */
+
+int test_distribution_normal(void) {
+    size_t failures = 0;
+    static float x[DISTRIBUTION_SAMPLES];
+    double mean, variance;
+
+    Random r, s;
+    random_seed(&r, RANDOM_XOSHIRO256, 2);
+
+    // Single draws: moments and the two-sided tail beyond 3 sigma (0.27%).
+    size_t tail = 0;
+    size_t beyond_r = 0;
+    for (size_t i = 0; i < DISTRIBUTION_SAMPLES; i++) {
+        double v = random_normal(&r);
+        x[i] = (float) v;
+        tail += fabs(v) > 3.0;
+        beyond_r += fabs(v) > 3.442619855899;
+    }
+    distribution_moments(x, DISTRIBUTION_SAMPLES, &mean, &variance);
+    failures += fabs(mean) > 0.01 || fabs(variance - 1.0) > 0.015;
+    failures += fabs((double) tail / DISTRIBUTION_SAMPLES - 0.0027) > 0.0006;
+    failures += 0 == beyond_r;
+
+    // Fills are deterministic and scaled.
+    static float y[DISTRIBUTION_SAMPLES];
+    random_fill_normal(&r, x, DISTRIBUTION_SAMPLES, 3.0f, 0.5f);
+    random_seed(&s, RANDOM_XOSHIRO256, 2);
+    for (size_t i = 0; i < DISTRIBUTION_SAMPLES; i++) {
+        random_normal(&s);
+    }
+    random_fill_normal(&s, y, DISTRIBUTION_SAMPLES, 3.0f, 0.5f);
+    failures += 0 != memcmp(x, y, sizeof(x));
+    distribution_moments(x, DISTRIBUTION_SAMPLES, &mean, &variance);
+    failures += fabs(mean - 3.0) > 0.005 || fabs(variance - 0.25) > 0.004;
+
+    // Exponential: mean and variance 1 / rate and 1 / rate^2.
+    double sum = 0.0;
+    for (size_t i = 0; i < DISTRIBUTION_SAMPLES; i++) {
+        double v = random_exponential(&r);
+        failures += v < 0.0;
+        sum += v;
+    }
+    failures += fabs(sum / DISTRIBUTION_SAMPLES - 1.0) > 0.01;
+    random_fill_exponential(&r, x, DISTRIBUTION_SAMPLES, 4.0f);
+    distribution_moments(x, DISTRIBUTION_SAMPLES, &mean, &variance);
+    failures += fabs(mean - 0.25) > 0.003 || fabs(variance - 0.0625) > 0.002;
+
+    ASSERT(0 == failures, "[TestDistributionNormal] failures=%zu", failures);
+    return 0;
+}
+
+int test_distribution_box_muller(void) {
+    size_t failures = 0;
+    enum { N = 4099 }; // odd, so the last tile has an unpaired output
+
+    static float expect[N];
+    static float got[N];
+    Random r;
+
+    cpu_level_set(CPU_LEVEL_SCALAR);
+    random_seed(&r, RANDOM_PHILOX, 3);
+    random_fill_normal_box_muller(&r, expect, N, 1.0f, 2.0f);
+
+    double mean, variance;
+    distribution_moments(expect, N, &mean, &variance);
+    failures += fabs(mean - 1.0) > 0.1 || fabs(variance - 4.0) > 0.3;
+
+    // Every level agrees with scalar up to rounding of the polynomials.
+    for (CpuLevel level = CPU_LEVEL_SSE2; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        random_seed(&r, RANDOM_PHILOX, 3);
+        random_fill_normal_box_muller(&r, got, N, 1.0f, 2.0f);
+        for (size_t i = 0; i < N; i++) {
+            failures += fabsf(got[i] - expect[i]) > 1e-5f * (1.0f + fabsf(expect[i]));
+        }
+    }
+    cpu_level_set(cpu_level_detected());
+
+    // Moments over a large fill; 24-bit uniforms cap |x| at about 5.77.
+    static float x[DISTRIBUTION_SAMPLES];
+    random_seed(&r, RANDOM_PCG64, 3);
+    random_fill_normal_box_muller(&r, x, DISTRIBUTION_SAMPLES, 0.0f, 1.0f);
+    distribution_moments(x, DISTRIBUTION_SAMPLES, &mean, &variance);
+    failures += fabs(mean) > 0.01 || fabs(variance - 1.0) > 0.015;
+    for (size_t i = 0; i < DISTRIBUTION_SAMPLES; i++) {
+        failures += !(fabsf(x[i]) < 5.8f);
+    }
+
+    ASSERT(0 == failures, "[TestDistributionBoxMuller] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Sampling
+ * {@
+ */
+
+int test_distribution_shuffle(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PCG64, 4);
+
+    // A permutation, whatever the element size.
+    enum { N = 1000 };
+    uint32_t items[N];
+    for (uint32_t i = 0; i < N; i++) {
+        items[i] = i;
+    }
+    random_shuffle(&r, items, N, sizeof(uint32_t));
+    bool seen[N] = {false};
+    size_t fixed = 0;
+    for (size_t i = 0; i < N; i++) {
+        failures += items[i] >= N || seen[items[i]];
+        seen[items[i] % N] = true;
+        fixed += items[i] == i;
+    }
+    failures += fixed > 10;
+
+    char wide[5][100];
+    for (size_t i = 0; i < 5; i++) {
+        memset(wide[i], 'a' + (int) i, sizeof(wide[i]));
+    }
+    random_shuffle(&r, wide, 5, sizeof(wide[0]));
+    unsigned mask = 0;
+    for (size_t i = 0; i < 5; i++) {
+        failures += wide[i][0] != wide[i][99];
+        mask |= 1u << (wide[i][0] - 'a');
+    }
+    failures += 0x1F != mask;
+
+    // All six orders of three elements are equally likely.
+    size_t orders[6] = {0};
+    for (size_t t = 0; t < 60000; t++) {
+        uint8_t v[3] = {0, 1, 2};
+        random_shuffle(&r, v, 3, 1);
+        orders[v[0] * 2 + (v[1] > v[2])]++;
+    }
+    for (size_t i = 0; i < 6; i++) {
+        failures += fabs((double) orders[i] / 10000.0 - 1.0) > 0.05;
+    }
+
+    random_shuffle(&r, NULL, 0, 4);
+    random_shuffle(&r, items, 1, 4);
+
+    ASSERT(0 == failures, "[TestDistributionShuffle] failures=%zu", failures);
+    return 0;
+}
+
+int test_distribution_reservoir(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_XOSHIRO256, 5);
+
+    uint16_t input[20];
+    for (uint16_t i = 0; i < 20; i++) {
+        input[i] = i;
+    }
+
+    // Fewer items than slots: all of them, in order.
+    uint16_t sample[25];
+    failures += 20 != random_reservoir(&r, input, 20, sizeof(uint16_t), sample, 25);
+    failures += 0 != memcmp(sample, input, sizeof(input));
+    failures += 0 != random_reservoir(&r, input, 20, sizeof(uint16_t), sample, 0);
+
+    // Every item is kept with probability k / count, and never twice.
+    size_t kept[20] = {0};
+    enum { TRIALS = 40000, K = 5 };
+    for (size_t t = 0; t < TRIALS; t++) {
+        failures += K != random_reservoir(&r, input, 20, sizeof(uint16_t), sample, K);
+        uint32_t mask = 0;
+        for (size_t i = 0; i < K; i++) {
+            failures += sample[i] >= 20 || (mask >> sample[i] & 1u);
+            mask |= 1u << (sample[i] % 20);
+            kept[sample[i] % 20]++;
+        }
+    }
+    for (size_t i = 0; i < 20; i++) {
+        failures += fabs((double) kept[i] / TRIALS - 0.25) > 0.01;
+    }
+
+    // A long stream: the sample is spread over all of it.
+    enum { LONG = 1000000 };
+    uint32_t* stream = malloc(LONG * sizeof(uint32_t));
+    for (uint32_t i = 0; i < LONG; i++) {
+        stream[i] = i;
+    }
+    uint32_t picks[1000];
+    random_reservoir(&r, stream, LONG, sizeof(uint32_t), picks, 1000);
+    double mean = 0.0;
+    for (size_t i = 0; i < 1000; i++) {
+        mean += picks[i] / 1000.0;
+    }
+    failures += fabs(mean / LONG - 0.5) > 0.03;
+    free(stream);
+
+    ASSERT(0 == failures, "[TestDistributionReservoir] failures=%zu", failures);
+    return 0;
+}
+
+int test_distribution_categorical(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 6);
+
+    float logits[10] = {1.0f, 2.0f, 0.5f, -1.0f, 3.0f, 0.0f, -INFINITY, 2.5f, 1.5f, -0.5f};
+    float probabilities[10];
+    activate_softmax(logits, probabilities, 10);
+
+    RandomAlias table;
+    failures += !random_alias_create(&table, probabilities, 10);
+
+    static uint32_t samples[DISTRIBUTION_SAMPLES];
+    random_fill_categorical(&r, &table, samples, DISTRIBUTION_SAMPLES);
+    size_t counts[10] = {0};
+    for (size_t i = 0; i < DISTRIBUTION_SAMPLES; i++) {
+        failures += samples[i] >= 10;
+        counts[samples[i] % 10]++;
+    }
+    for (size_t i = 0; i < 10; i++) {
+        double share = (double) counts[i] / DISTRIBUTION_SAMPLES;
+        failures += fabs(share - (double) probabilities[i]) > 0.005;
+    }
+    failures += 0 != counts[6];
+
+    for (size_t i = 0; i < 1000; i++) {
+        failures += 6 == random_alias_sample(&r, &table);
+    }
+    random_alias_free(&table);
+    failures += NULL != table.probability;
+
+    // Unnormalized weights.
+    float weights[3] = {1.0f, 0.0f, 3.0f};
+    failures += !random_alias_create(&table, weights, 3);
+    size_t third = 0;
+    for (size_t i = 0; i < 40000; i++) {
+        uint32_t v = random_alias_sample(&r, &table);
+        failures += 1 == v;
+        third += 2 == v;
+    }
+    failures += fabs(third / 40000.0 - 0.75) > 0.01;
+    random_alias_free(&table);
+
+    float bad[2] = {1.0f, -1.0f};
+    failures += random_alias_create(&table, bad, 2);
+    bad[1] = NAN;
+    failures += random_alias_create(&table, bad, 2);
+    bad[0] = bad[1] = 0.0f;
+    failures += random_alias_create(&table, bad, 2);
+    failures += random_alias_create(&table, bad, 0);
+
+    ASSERT(0 == failures, "[TestDistributionCategorical] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"distribution_uniform", test_distribution_uniform},
+        {"distribution_normal", test_distribution_normal},
+        {"distribution_box_muller", test_distribution_box_muller},
+        {"distribution_shuffle", test_distribution_shuffle},
+        {"distribution_reservoir", test_distribution_reservoir},
+        {"distribution_categorical", test_distribution_categorical},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,199 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_dot.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/dot.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Not a multiple of BLOCK_SIZE or any vector width, so tails and padded blocks are exercised.
+#define DOT_LENGTH (BLOCK_SIZE * 1024 + 13)
+
+typedef struct TestDot {
+    CpuLevel level;
+    uint32_t masked; // features hidden to reach the non-VNNI kernels
+} TestDot;
+
+static const TestDot dot_configs[] = {
+    {CPU_LEVEL_SCALAR, 0},
+    {CPU_LEVEL_SSE2, 0},
+    {CPU_LEVEL_AVX2, CPU_FEATURE_AVX_VNNI},
+    {CPU_LEVEL_AVX2, 0},
+    {CPU_LEVEL_AVX512, CPU_FEATURE_AVX_VNNI | CPU_FEATURE_AVX512_VNNI},
+    {CPU_LEVEL_AVX512, 0},
+};
+
+#define DOT_CONFIG_COUNT (sizeof(dot_configs) / sizeof(TestDot))
+
+typedef struct TestDotRows {
+    float* x;
+    float* y;
+    BlockQ8* x8;
+    BlockQ4* x4;
+    BlockQ8* y8;
+    uint16_t* x16;
+} TestDotRows;
+
+// y is x plus as much noise again, so x · y is large and relative errors are meaningful.
+static TestDotRows dot_rows_create(void) {
+    size_t blocks = (DOT_LENGTH + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    TestDotRows rows = {
+        .x = malloc(DOT_LENGTH * sizeof(float)),
+        .y = malloc(DOT_LENGTH * sizeof(float)),
+        .x8 = malloc(blocks * sizeof(BlockQ8)),
+        .x4 = malloc(blocks * sizeof(BlockQ4)),
+        .y8 = malloc(blocks * sizeof(BlockQ8)),
+        .x16 = malloc(DOT_LENGTH * sizeof(uint16_t)),
+    };
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < DOT_LENGTH; i++) {
+        rows.x[i] = (lehmer_generate_float() - 0.5f) * 8.0f;
+        rows.y[i] = rows.x[i] + (lehmer_generate_float() - 0.5f) * 8.0f;
+    }
+
+    quantize_row_block_q8(rows.x, rows.x8, DOT_LENGTH);
+    quantize_row_block_q4(rows.x, rows.x4, DOT_LENGTH);
+    quantize_row_block_q8(rows.y, rows.y8, DOT_LENGTH);
+    quantize_row_fp16(rows.x, rows.x16, DOT_LENGTH);
+    return rows;
+}
+
+static void dot_rows_free(TestDotRows* rows) {
+    free(rows->x);
+    free(rows->y);
+    free(rows->x8);
+    free(rows->x4);
+    free(rows->y8);
+    free(rows->x16);
+}
+
+// Exact dot of two rows in double, plus Σ|x·y| to scale the rounding tolerance.
+static double dot_reference(const float* x, const float* y, size_t length, double* magnitude) {
+    double sum = 0.0;
+    *magnitude = 0.0;
+    for (size_t i = 0; i < length; i++) {
+        sum += (double) x[i] * (double) y[i];
+        *magnitude += fabs((double) x[i] * (double) y[i]);
+    }
+    return sum;
+}
+
+/**
+ * Each kernel must match the exact dot of the values it actually sees (the dequantized rows) to
+ * fp32 accumulation error, and the fp32 dot of the original rows to quantization error.
+ */
+int test_group_dot(TestUnit* unit) {
+    const TestDot* config = (const TestDot*) unit->data;
+    if (config->level > cpu_level_detected()) {
+        LOG_INFO("[TestDot] level=%s not supported, skipped", cpu_level_name(config->level));
+        return 0;
+    }
+
+    TestDotRows rows = dot_rows_create();
+    float* xd = malloc(DOT_LENGTH * sizeof(float));
+    float* yd = malloc(DOT_LENGTH * sizeof(float));
+
+    double m;
+    double exact = dot_reference(rows.x, rows.y, DOT_LENGTH, &m);
+
+    dequantize_row_block_q8(rows.y8, yd, DOT_LENGTH);
+
+    cpu_level_set(config->level);
+    cpu_features_mask(config->masked);
+    double q8 = dot_block_q8_q8(rows.x8, rows.y8, DOT_LENGTH);
+    double q4 = dot_block_q4_q8(rows.x4, rows.y8, DOT_LENGTH);
+    double f16 = dot_fp16_fp32(rows.x16, rows.y, DOT_LENGTH);
+    cpu_features_mask(0);
+    cpu_level_set(cpu_level_detected());
+
+    double m8, m4, m16;
+    dequantize_row_block_q8(rows.x8, xd, DOT_LENGTH);
+    double e8 = dot_reference(xd, yd, DOT_LENGTH, &m8);
+    dequantize_row_block_q4(rows.x4, xd, DOT_LENGTH);
+    double e4 = dot_reference(xd, yd, DOT_LENGTH, &m4);
+    dequantize_row_fp16(rows.x16, xd, DOT_LENGTH);
+    double e16 = dot_reference(xd, rows.y, DOT_LENGTH, &m16);
+
+    free(xd);
+    free(yd);
+    dot_rows_free(&rows);
+
+    const char* name = cpu_level_name(config->level);
+    const char* vnni = config->masked || config->level < CPU_LEVEL_AVX2 ? "off" : "on";
+
+    ASSERT(
+        fabs(q8 - e8) <= 1e-5 * m8 && fabs(q4 - e4) <= 1e-5 * m4 && fabs(f16 - e16) <= 1e-5 * m16,
+        "[TestDot] level=%s, vnni=%s, q8=%.9g (%.9g), q4=%.9g (%.9g), fp16=%.9g (%.9g)",
+        name,
+        vnni,
+        q8,
+        e8,
+        q4,
+        e4,
+        f16,
+        e16
+    );
+
+    double r8 = fabs(q8 - exact) / fabs(exact);
+    double r4 = fabs(q4 - exact) / fabs(exact);
+    double r16 = fabs(f16 - exact) / fabs(exact);
+    ASSERT(
+        r8 < 1e-2 && r4 < 1e-1 && r16 < 1e-3,
+        "[TestDot] level=%s, vnni=%s, relative error vs fp32: q8=%g, q4=%g, fp16=%g",
+        name,
+        vnni,
+        r8,
+        r4,
+        r16
+    );
+
+    LOG_INFO(
+        "[TestDot] level=%s, vnni=%s, relative error vs fp32: q8=%g, q4=%g, fp16=%g",
+        name,
+        vnni,
+        r8,
+        r4,
+        r16
+    );
+
+    return 0;
+}
+
+int test_suite_dot(void) {
+    TestUnit units[DOT_CONFIG_COUNT];
+    for (size_t i = 0; i < DOT_CONFIG_COUNT; i++) {
+        units[i].data = &dot_configs[i];
+    }
+
+    TestGroup group = {
+        .name = "dot",
+        .count = DOT_CONFIG_COUNT,
+        .units = units,
+        .run = test_group_dot,
+    };
+
+    return test_group_run(&group);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"dot", test_suite_dot},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
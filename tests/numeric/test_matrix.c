@@ -0,0 +1,289 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_matrix.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/matrix.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const CpuLevel matrix_levels[] = {
+    CPU_LEVEL_SCALAR,
+    CPU_LEVEL_SSE2,
+    CPU_LEVEL_AVX2,
+    CPU_LEVEL_AVX512,
+};
+
+#define MATRIX_LEVEL_COUNT (sizeof(matrix_levels) / sizeof(CpuLevel))
+
+static void matrix_fill(float* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        values[i] = lehmer_generate_float() * 2.0f - 1.0f;
+    }
+}
+
+/**
+ * @name GEMM
+ * {@
+ */
+
+typedef struct TestMatrixShape {
+    size_t m;
+    size_t n;
+    size_t k;
+} TestMatrixShape;
+
+// Edge tiles in both directions, k past one packed block, n past one packed B block.
+static const TestMatrixShape matrix_shapes[] = {
+    {1, 1, 1},
+    {7, 5, 3},
+    {12, 32, 256},
+    {37, 53, 301},
+    {100, 70, 513},
+    {5, 4200, 9},
+};
+
+// Checks one product against a double reference; pad columns of C must stay untouched.
+static bool matrix_gemm_check(ThreadPool* pool, TestMatrixShape s, size_t* wrong) {
+    size_t lda = s.k + 3;
+    size_t ldb = s.n + 5;
+    size_t ldc = s.n + 2;
+    float* a = malloc(s.m * lda * sizeof(float));
+    float* b = malloc(s.k * ldb * sizeof(float));
+    float* c = malloc(s.m * ldc * sizeof(float));
+
+    lehmer_initialize(LEHMER_SEED);
+    matrix_fill(a, s.m * lda);
+    matrix_fill(b, s.k * ldb);
+    for (size_t i = 0; i < s.m * ldc; i++) {
+        c[i] = -1000.0f;
+    }
+
+    bool ok = matrix_gemm_fp32(pool, s.m, s.n, s.k, a, lda, b, ldb, c, ldc);
+
+    *wrong = 0;
+    for (size_t i = 0; i < s.m; i++) {
+        for (size_t j = 0; j < ldc; j++) {
+            if (j >= s.n) {
+                *wrong += c[i * ldc + j] != -1000.0f;
+                continue;
+            }
+            double sum = 0.0, magnitude = 0.0;
+            for (size_t p = 0; p < s.k; p++) {
+                double v = (double) a[i * lda + p] * (double) b[p * ldb + j];
+                sum += v;
+                magnitude += fabs(v);
+            }
+            double tolerance = 2.0 * (double) s.k * 0x1.0p-24 * magnitude + 1e-30;
+            *wrong += fabs((double) c[i * ldc + j] - sum) > tolerance;
+        }
+    }
+
+    free(a);
+    free(b);
+    free(c);
+    return ok;
+}
+
+int test_group_matrix_gemm(TestUnit* unit) {
+    CpuLevel level = *(const CpuLevel*) unit->data;
+    if (level > cpu_level_detected()) {
+        LOG_INFO("[TestMatrixGemm] level=%s not supported, skipped", cpu_level_name(level));
+        return 0;
+    }
+
+    ThreadPool* pool = thread_pool_create(3);
+    cpu_level_set(level);
+
+    size_t failures = 0;
+    for (size_t s = 0; s < sizeof(matrix_shapes) / sizeof(TestMatrixShape); s++) {
+        for (size_t t = 0; t < 2; t++) {
+            size_t wrong;
+            bool ok = matrix_gemm_check(0 == t ? NULL : pool, matrix_shapes[s], &wrong);
+            if (!ok || wrong) {
+                LOG_ERROR(
+                    "[TestMatrixGemm] level=%s, m=%zu, n=%zu, k=%zu, threads=%zu, ok=%d, wrong=%zu",
+                    cpu_level_name(level),
+                    matrix_shapes[s].m,
+                    matrix_shapes[s].n,
+                    matrix_shapes[s].k,
+                    thread_pool_size(0 == t ? NULL : pool),
+                    ok,
+                    wrong
+                );
+                failures++;
+            }
+        }
+    }
+
+    cpu_level_set(cpu_level_detected());
+    thread_pool_free(pool);
+
+    ASSERT(0 == failures, "[TestMatrixGemm] level=%s, failures=%zu", cpu_level_name(level), failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name GEMV
+ * {@
+ */
+
+#define MATRIX_GEMV_ROWS 67
+#define MATRIX_GEMV_COLS (BLOCK_SIZE * 31 + 5)
+
+static const DataTypeId matrix_gemv_types[] = {
+    TYPE_FLOAT32,
+    TYPE_FLOAT16,
+    TYPE_BLOCK_Q8,
+    TYPE_BLOCK_Q4,
+};
+
+/**
+ * Each output must match the exact dot of the weights and input the kernel sees: the row
+ * dequantized, and for the block formats `x` quantized to Q8.
+ */
+static size_t matrix_gemv_check(ThreadPool* pool, DataTypeId type) {
+    size_t stride = data_type_row_size(type, MATRIX_GEMV_COLS);
+    float* dense = malloc(MATRIX_GEMV_ROWS * MATRIX_GEMV_COLS * sizeof(float));
+    uint8_t* w = malloc(MATRIX_GEMV_ROWS * stride);
+    float* x = malloc(MATRIX_GEMV_COLS * sizeof(float));
+    float* xd = malloc(MATRIX_GEMV_COLS * sizeof(float));
+    float* wd = malloc(MATRIX_GEMV_COLS * sizeof(float));
+    float* y = malloc(MATRIX_GEMV_ROWS * sizeof(float));
+    BlockQ8* xq = malloc(data_type_row_size(TYPE_BLOCK_Q8, MATRIX_GEMV_COLS));
+
+    lehmer_initialize(LEHMER_SEED);
+    matrix_fill(dense, MATRIX_GEMV_ROWS * MATRIX_GEMV_COLS);
+    matrix_fill(x, MATRIX_GEMV_COLS);
+    for (size_t r = 0; r < MATRIX_GEMV_ROWS; r++) {
+        quantize_row(dense + r * MATRIX_GEMV_COLS, w + r * stride, MATRIX_GEMV_COLS, type);
+    }
+
+    bool ok = matrix_gemv(pool, type, w, MATRIX_GEMV_ROWS, MATRIX_GEMV_COLS, x, y);
+
+    bool block = TYPE_BLOCK_Q8 == type || TYPE_BLOCK_Q4 == type;
+    if (block) {
+        quantize_row_block_q8(x, xq, MATRIX_GEMV_COLS);
+        dequantize_row_block_q8(xq, xd, MATRIX_GEMV_COLS);
+    } else {
+        memcpy(xd, x, MATRIX_GEMV_COLS * sizeof(float));
+    }
+
+    size_t wrong = ok ? 0 : MATRIX_GEMV_ROWS;
+    for (size_t r = 0; ok && r < MATRIX_GEMV_ROWS; r++) {
+        dequantize_row(w + r * stride, wd, MATRIX_GEMV_COLS, type);
+        double sum = 0.0, magnitude = 0.0;
+        for (size_t j = 0; j < MATRIX_GEMV_COLS; j++) {
+            double v = (double) wd[j] * (double) xd[j];
+            sum += v;
+            magnitude += fabs(v);
+        }
+        wrong += fabs((double) y[r] - sum) > 1e-5 * magnitude;
+    }
+
+    free(dense);
+    free(w);
+    free(x);
+    free(xd);
+    free(wd);
+    free(y);
+    free(xq);
+    return wrong;
+}
+
+int test_group_matrix_gemv(TestUnit* unit) {
+    CpuLevel level = *(const CpuLevel*) unit->data;
+    if (level > cpu_level_detected()) {
+        LOG_INFO("[TestMatrixGemv] level=%s not supported, skipped", cpu_level_name(level));
+        return 0;
+    }
+
+    ThreadPool* pool = thread_pool_create(3);
+    cpu_level_set(level);
+
+    size_t failures = 0;
+    for (size_t i = 0; i < sizeof(matrix_gemv_types) / sizeof(DataTypeId); i++) {
+        for (size_t t = 0; t < 2; t++) {
+            size_t wrong = matrix_gemv_check(0 == t ? NULL : pool, matrix_gemv_types[i]);
+            if (wrong) {
+                LOG_ERROR(
+                    "[TestMatrixGemv] level=%s, type=%s, threads=%zu, wrong=%zu",
+                    cpu_level_name(level),
+                    data_type_name(matrix_gemv_types[i]),
+                    thread_pool_size(0 == t ? NULL : pool),
+                    wrong
+                );
+                failures++;
+            }
+        }
+    }
+
+    cpu_level_set(cpu_level_detected());
+    thread_pool_free(pool);
+
+    // Unsupported weight types are rejected.
+    float x = 1.0f, y = 0.0f;
+    int8_t w = 1;
+    bool rejected = !matrix_gemv(NULL, TYPE_INT8, &w, 1, 1, &x, &y);
+
+    ASSERT(
+        0 == failures && rejected,
+        "[TestMatrixGemv] level=%s, failures=%zu, rejected=%d",
+        cpu_level_name(level),
+        failures,
+        rejected
+    );
+    return 0;
+}
+
+/** @} */
+
+static int matrix_level_suite_run(const char* name, TestUnitHook run) {
+    TestUnit units[MATRIX_LEVEL_COUNT];
+    for (size_t i = 0; i < MATRIX_LEVEL_COUNT; i++) {
+        units[i].data = &matrix_levels[i];
+    }
+
+    TestGroup group = {
+        .name = name,
+        .count = MATRIX_LEVEL_COUNT,
+        .units = units,
+        .run = run,
+    };
+
+    return test_group_run(&group);
+}
+
+int test_suite_matrix_gemm(void) {
+    return matrix_level_suite_run("matrix_gemm", test_group_matrix_gemm);
+}
+
+int test_suite_matrix_gemv(void) {
+    return matrix_level_suite_run("matrix_gemv", test_group_matrix_gemv);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"matrix_gemm", test_suite_matrix_gemm},
+        {"matrix_gemv", test_suite_matrix_gemv},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,314 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file tests/numeric/test_modular.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/distribution.h"
+#include "numeric/modular.h"
+#include "numeric/prime.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MODULAR_COUNT 1003 // not a multiple of the vector width
+
+static const uint32_t MODULI[] = {
+    2,
+    3,
+    7,
+    65536,
+    (1u << 30) + 1,
+    MODULAR_PRIME_469762049,
+    MODULAR_PRIME_998244353,
+    MODULAR_PRIME_2013265921,
+    MODULAR_LIMIT - 1,
+};
+
+// Residues below m, with both ends of the range represented.
+static void modular_fill(Random* r, uint32_t* x, size_t count, uint32_t m) {
+    random_fill_bounded(r, x, count, m);
+    x[0] = 0;
+    x[1] = m - 1;
+}
+
+/**
+ * @name Reduction
+ * {@
+ */
+
+int test_modular_reduction(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 7);
+
+    ModularBarrett barrett;
+    ModularMontgomery montgomery;
+    failures += modular_barrett_create(&barrett, 1);
+    failures += modular_barrett_create(&barrett, MODULAR_LIMIT);
+    failures += modular_montgomery_create(&montgomery, 65536);
+    failures += modular_montgomery_create(&montgomery, MODULAR_LIMIT + 1);
+
+    for (size_t i = 0; i < sizeof(MODULI) / sizeof(uint32_t); i++) {
+        uint32_t m = MODULI[i];
+        failures += !modular_barrett_create(&barrett, m);
+        bool odd = modular_montgomery_create(&montgomery, m);
+        failures += odd != (m > 2 && (m & 1));
+
+        for (size_t j = 0; j < 10000; j++) {
+            uint32_t a = j < 2 ? m - 1 : random_bounded_u32(&r, m);
+            uint32_t b = j < 1 ? m - 1 : random_bounded_u32(&r, m);
+            uint32_t expected = (uint32_t) ((uint64_t) a * b % m);
+            failures += modular_barrett_multiply(&barrett, a, b) != expected;
+            if (odd) {
+                uint32_t ma = modular_montgomery_to(&montgomery, a);
+                uint32_t mb = modular_montgomery_to(&montgomery, b);
+                uint32_t product = modular_montgomery_multiply(&montgomery, ma, mb);
+                failures += modular_montgomery_from(&montgomery, product) != expected;
+                failures += modular_montgomery_multiply(&montgomery, ma, b) != expected;
+            }
+        }
+    }
+
+    ASSERT(0 == failures, "[TestModularReduction] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Arrays
+ * {@
+ */
+
+int test_modular_arrays(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 11);
+
+    uint32_t* a = malloc(MODULAR_COUNT * sizeof(uint32_t));
+    uint32_t* b = malloc(MODULAR_COUNT * sizeof(uint32_t));
+    uint32_t* c = malloc(MODULAR_COUNT * sizeof(uint32_t));
+    uint32_t* d = malloc(MODULAR_COUNT * sizeof(uint32_t));
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        for (size_t i = 0; i < sizeof(MODULI) / sizeof(uint32_t); i++) {
+            uint32_t m = MODULI[i];
+            modular_fill(&r, a, MODULAR_COUNT, m);
+            modular_fill(&r, b, MODULAR_COUNT, m);
+            b[2] = m - 1; // a + b at its largest
+            a[2] = m - 1;
+
+            modular_add(a, b, c, MODULAR_COUNT, m);
+            for (size_t j = 0; j < MODULAR_COUNT; j++) {
+                failures += c[j] != (uint32_t) (((uint64_t) a[j] + b[j]) % m);
+            }
+            modular_sub(a, b, c, MODULAR_COUNT, m);
+            for (size_t j = 0; j < MODULAR_COUNT; j++) {
+                failures += c[j] != (uint32_t) (((uint64_t) a[j] + m - b[j]) % m);
+            }
+
+            ModularBarrett barrett;
+            modular_barrett_create(&barrett, m);
+            modular_mul_barrett(&barrett, a, b, c, MODULAR_COUNT);
+            for (size_t j = 0; j < MODULAR_COUNT; j++) {
+                failures += c[j] != (uint32_t) ((uint64_t) a[j] * b[j] % m);
+            }
+
+            ModularMontgomery montgomery;
+            if (!modular_montgomery_create(&montgomery, m)) {
+                continue;
+            }
+            modular_to_montgomery(&montgomery, a, d, MODULAR_COUNT);
+            modular_mul_montgomery(&montgomery, d, b, c, MODULAR_COUNT);
+            for (size_t j = 0; j < MODULAR_COUNT; j++) {
+                failures += c[j] != (uint32_t) ((uint64_t) a[j] * b[j] % m);
+            }
+            modular_from_montgomery(&montgomery, d, c, MODULAR_COUNT);
+            for (size_t j = 0; j < MODULAR_COUNT; j++) {
+                failures += c[j] != a[j];
+            }
+
+            // In place.
+            modular_add(a, b, a, MODULAR_COUNT, m);
+            modular_sub(a, b, a, MODULAR_COUNT, m);
+            for (size_t j = 0; j < MODULAR_COUNT; j++) {
+                failures += c[j] != a[j];
+            }
+        }
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(a);
+    free(b);
+    free(c);
+    free(d);
+    ASSERT(0 == failures, "[TestModularArrays] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name NTT
+ * {@
+ */
+
+static size_t modular_reverse(size_t i, size_t size) {
+    size_t r = 0;
+    for (size_t bit = 1; bit < size; bit <<= 1) {
+        r = (r << 1) | (i & 1);
+        i >>= 1;
+    }
+    return r;
+}
+
+int test_modular_ntt(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 13);
+
+    ModularNtt ntt;
+    failures += modular_ntt_create(&ntt, 998244352, 8); // even
+    failures += modular_ntt_create(&ntt, 998244355, 2); // odd, composite
+    failures += modular_ntt_create(&ntt, MODULAR_PRIME_998244353, 12); // not a power of two
+    failures += modular_ntt_create(&ntt, MODULAR_PRIME_998244353, 1 << 24); // 2^24 !| p - 1
+    failures += modular_ntt_create(&ntt, MODULAR_PRIME_998244353, 0);
+
+    uint32_t moduli[] = {MODULAR_PRIME_998244353, MODULAR_PRIME_2013265921, 257};
+    size_t sizes[] = {1, 2, 8, 16, 64, 256};
+    uint32_t x[256];
+    uint32_t y[256];
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        for (size_t i = 0; i < sizeof(moduli) / sizeof(uint32_t); i++) {
+            uint32_t p = moduli[i];
+            for (size_t s = 0; s < sizeof(sizes) / sizeof(size_t); s++) {
+                size_t n = sizes[s];
+                if (!modular_ntt_create(&ntt, p, n)) {
+                    failures++;
+                    continue;
+                }
+                modular_fill(&r, x, n > 2 ? n : 2, p);
+                memcpy(y, x, n * sizeof(uint32_t));
+                modular_ntt_forward(&ntt, y);
+
+                // X_k = sum x_j w^jk for the transform's own primitive n-th root w, which sits at
+                // bit-reversed position k.
+                uint32_t w = n >= 4 ? modular_montgomery_from(&ntt.context, ntt.roots[n / 2 + 1])
+                                    : p - 1;
+                failures += n >= 2 && p - 1 != prime_modular_exponent(w, n / 2, p);
+                for (size_t k = 0; k < n; k++) {
+                    uint64_t sum = 0;
+                    for (size_t j = 0; j < n; j++) {
+                        uint64_t twiddle = prime_modular_exponent(w, (j * k) % n, p);
+                        sum = (sum + x[j] * twiddle) % p;
+                    }
+                    failures += y[modular_reverse(k, n)] != sum;
+                }
+
+                modular_ntt_inverse(&ntt, y);
+                for (size_t j = 0; j < n; j++) {
+                    failures += y[j] != x[j];
+                }
+                modular_ntt_free(&ntt);
+            }
+        }
+    }
+    cpu_level_set(cpu_level_detected());
+
+    ASSERT(0 == failures, "[TestModularNtt] failures=%zu", failures);
+    return 0;
+}
+
+static size_t modular_check_convolve(Random* r, size_t a_count, size_t b_count, uint32_t p) {
+    size_t failures = 0;
+    uint32_t* a = malloc(a_count * sizeof(uint32_t));
+    uint32_t* b = malloc(b_count * sizeof(uint32_t));
+    uint32_t* c = malloc((a_count + b_count) * sizeof(uint32_t));
+    random_fill_bounded(r, a, a_count, UINT32_MAX); // unreduced on purpose
+    random_fill_bounded(r, b, b_count, UINT32_MAX);
+
+    failures += !modular_convolve(a, a_count, b, b_count, c, p);
+    for (size_t k = 0; k + 1 < a_count + b_count; k++) {
+        uint64_t sum = 0;
+        size_t low = k >= b_count ? k - b_count + 1 : 0;
+        for (size_t i = low; i < a_count && i <= k; i++) {
+            sum = (sum + (uint64_t) (a[i] % p) * (b[k - i] % p)) % p;
+        }
+        failures += c[k] != sum;
+    }
+
+    free(a);
+    free(b);
+    free(c);
+    return failures;
+}
+
+int test_modular_convolve(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 17);
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        failures += modular_check_convolve(&r, 1, 1, MODULAR_PRIME_998244353);
+        failures += modular_check_convolve(&r, 5, 300, MODULAR_PRIME_998244353);
+        failures += modular_check_convolve(&r, 33, 33, MODULAR_PRIME_998244353);
+        failures += modular_check_convolve(&r, 100, 77, MODULAR_PRIME_2013265921);
+        failures += modular_check_convolve(&r, 1000, 1500, MODULAR_PRIME_469762049);
+        failures += modular_check_convolve(&r, 20, 20, 1000); // direct, any modulus
+    }
+    cpu_level_set(cpu_level_detected());
+
+    // Two ramps: the true integer coefficients stay below p, so the result is exact.
+    uint32_t a[64] = {0};
+    uint32_t b[64] = {0};
+    uint32_t c[127];
+    uint32_t p = MODULAR_PRIME_998244353;
+    for (size_t i = 0; i < 64; i++) {
+        a[i] = (uint32_t) i + 1;
+        b[i] = 64 - (uint32_t) i;
+    }
+    failures += !modular_convolve(a, 64, b, 64, c, p);
+    for (size_t k = 0; k < 127; k++) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < 64; i++) {
+            sum += k >= i && k - i < 64 ? (uint64_t) a[i] * b[k - i] : 0;
+        }
+        failures += c[k] != sum;
+    }
+
+    // A product whose size does not divide p - 1 fails without touching the output.
+    c[0] = 12345;
+    failures += modular_convolve(a, 64, b, 64, c, 1000003) || 12345 != c[0];
+    failures += !modular_convolve(a, 0, b, 64, c, p) || 12345 != c[0];
+
+    ASSERT(0 == failures, "[TestModularConvolve] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"modular_reduction", test_modular_reduction},
+        {"modular_arrays", test_modular_arrays},
+        {"modular_ntt", test_modular_ntt},
+        {"modular_convolve", test_modular_convolve},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,301 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file tests/numeric/test_normalize.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/distribution.h"
+#include "numeric/normalize.h"
+#include "numeric/type.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NORMALIZE_COUNT 1237 // several half tiles, not a multiple of any vector width
+#define NORMALIZE_ROWS 37
+#define NORMALIZE_EPSILON 1e-5f
+
+// Double-precision reference over the values the kernel actually reads.
+static void normalize_reference(
+    const float* x,
+    double* y,
+    const float* weight,
+    const float* bias,
+    size_t length,
+    bool centered
+) {
+    double mean = 0.0;
+    if (centered) {
+        for (size_t i = 0; i < length; i++) {
+            mean += (double) x[i];
+        }
+        mean /= (double) length;
+    }
+    double squares = 0.0;
+    for (size_t i = 0; i < length; i++) {
+        squares += ((double) x[i] - mean) * ((double) x[i] - mean);
+    }
+    double scale = 1.0 / sqrt(squares / (double) length + (double) NORMALIZE_EPSILON);
+    for (size_t i = 0; i < length; i++) {
+        double v = ((double) x[i] - mean) * scale;
+        v *= weight ? (double) weight[i] : 1.0;
+        y[i] = v + (bias ? (double) bias[i] : 0.0);
+    }
+}
+
+// Counts elements further than `tolerance` relative to max(|expected|, 1).
+static size_t normalize_mismatches(
+    const float* actual, const double* expected, size_t length, double tolerance
+) {
+    size_t failures = 0;
+    for (size_t i = 0; i < length; i++) {
+        double magnitude = fabs(expected[i]) > 1.0 ? fabs(expected[i]) : 1.0;
+        failures += !(fabs((double) actual[i] - expected[i]) <= tolerance * magnitude);
+    }
+    return failures;
+}
+
+/**
+ * @name Single Precision
+ * {@
+ */
+
+int test_normalize_fp32(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 7);
+
+    float* x = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* far = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* weight = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* bias = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* y = malloc(NORMALIZE_COUNT * sizeof(float));
+    double* expected = malloc(NORMALIZE_COUNT * sizeof(double));
+    random_fill_normal(&r, x, NORMALIZE_COUNT, 0.5f, 2.0f);
+    random_fill_normal(&r, far, NORMALIZE_COUNT, 1000.0f, 1.0f); // E[x^2] - E[x]^2 cancels here
+    random_fill_uniform(&r, weight, NORMALIZE_COUNT, 0.5f, 1.5f);
+    random_fill_uniform(&r, bias, NORMALIZE_COUNT, -1.0f, 1.0f);
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+
+        // Every odd length up to a few vectors exercises the tails.
+        for (size_t length = 1; length <= 67; length += 2) {
+            normalize_rms(x, y, weight, length, NORMALIZE_EPSILON);
+            normalize_reference(x, expected, weight, NULL, length, false);
+            failures += normalize_mismatches(y, expected, length, 1e-5);
+
+            normalize_layer(x, y, weight, bias, length, NORMALIZE_EPSILON);
+            normalize_reference(x, expected, weight, bias, length, true);
+            failures += normalize_mismatches(y, expected, length, 1e-4);
+        }
+
+        normalize_rms(x, y, NULL, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        normalize_reference(x, expected, NULL, NULL, NORMALIZE_COUNT, false);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 1e-5);
+
+        normalize_layer(x, y, NULL, NULL, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        normalize_reference(x, expected, NULL, NULL, NORMALIZE_COUNT, true);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 1e-4);
+
+        // The far row keeps unit variance; only the shifted statistics recover it.
+        normalize_layer(far, y, weight, bias, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        normalize_reference(far, expected, weight, bias, NORMALIZE_COUNT, true);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 1e-3);
+
+        // In place matches out of place.
+        memcpy(y, x, NORMALIZE_COUNT * sizeof(float));
+        normalize_layer(y, y, weight, bias, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        normalize_reference(x, expected, weight, bias, NORMALIZE_COUNT, true);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 1e-4);
+
+        // A single element has no spread: LayerNorm yields the bias alone.
+        normalize_layer(x, y, NULL, bias, 1, NORMALIZE_EPSILON);
+        failures += bias[0] != y[0];
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(x);
+    free(far);
+    free(weight);
+    free(bias);
+    free(y);
+    free(expected);
+    ASSERT(0 == failures, "[TestNormalizeFp32] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Half Precision
+ * {@
+ */
+
+int test_normalize_half(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 11);
+
+    float* x = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* weight = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* bias = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* wide = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* y = malloc(NORMALIZE_COUNT * sizeof(float));
+    double* expected = malloc(NORMALIZE_COUNT * sizeof(double));
+    uint16_t* fp16 = malloc(NORMALIZE_COUNT * sizeof(uint16_t));
+    uint16_t* bf16 = malloc(NORMALIZE_COUNT * sizeof(uint16_t));
+    uint16_t* half = malloc(NORMALIZE_COUNT * sizeof(uint16_t));
+    random_fill_normal(&r, x, NORMALIZE_COUNT, 3.0f, 2.0f);
+    random_fill_uniform(&r, weight, NORMALIZE_COUNT, 0.5f, 1.5f);
+    random_fill_uniform(&r, bias, NORMALIZE_COUNT, -1.0f, 1.0f);
+    quantize_row_fp16(x, fp16, NORMALIZE_COUNT);
+    quantize_row_bf16(x, bf16, NORMALIZE_COUNT);
+
+    // Outputs are held to a rounding of the narrow type around the reference of the widened row.
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+
+        dequantize_row_fp16(fp16, wide, NORMALIZE_COUNT);
+        normalize_rms_fp16(fp16, half, weight, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        dequantize_row_fp16(half, y, NORMALIZE_COUNT);
+        normalize_reference(wide, expected, weight, NULL, NORMALIZE_COUNT, false);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 1e-3);
+
+        normalize_layer_fp16(fp16, half, weight, bias, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        dequantize_row_fp16(half, y, NORMALIZE_COUNT);
+        normalize_reference(wide, expected, weight, bias, NORMALIZE_COUNT, true);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 1e-3);
+
+        dequantize_row_bf16(bf16, wide, NORMALIZE_COUNT);
+        normalize_rms_bf16(bf16, half, weight, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        dequantize_row_bf16(half, y, NORMALIZE_COUNT);
+        normalize_reference(wide, expected, weight, NULL, NORMALIZE_COUNT, false);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 8e-3);
+
+        // In place across tiles.
+        memcpy(half, bf16, NORMALIZE_COUNT * sizeof(uint16_t));
+        normalize_layer_bf16(half, half, weight, bias, NORMALIZE_COUNT, NORMALIZE_EPSILON);
+        dequantize_row_bf16(half, y, NORMALIZE_COUNT);
+        normalize_reference(wide, expected, weight, bias, NORMALIZE_COUNT, true);
+        failures += normalize_mismatches(y, expected, NORMALIZE_COUNT, 8e-3);
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(x);
+    free(weight);
+    free(bias);
+    free(wide);
+    free(y);
+    free(expected);
+    free(fp16);
+    free(bf16);
+    free(half);
+    ASSERT(0 == failures, "[TestNormalizeHalf] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Batches
+ * {@
+ */
+
+int test_normalize_rows(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 13);
+
+    const size_t count = NORMALIZE_ROWS * NORMALIZE_COUNT;
+    float* x = malloc(count * sizeof(float));
+    float* weight = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* bias = malloc(NORMALIZE_COUNT * sizeof(float));
+    float* expected = malloc(count * sizeof(float));
+    float* y = malloc(count * sizeof(float));
+    uint16_t* half = malloc(count * sizeof(uint16_t));
+    uint16_t* half_expected = malloc(count * sizeof(uint16_t));
+    uint16_t* half_y = malloc(count * sizeof(uint16_t));
+    random_fill_normal(&r, x, count, 0.0f, 4.0f);
+    random_fill_uniform(&r, weight, NORMALIZE_COUNT, 0.5f, 1.5f);
+    random_fill_uniform(&r, bias, NORMALIZE_COUNT, -1.0f, 1.0f);
+    quantize_row_bf16(x, half, count);
+
+    ThreadPool* single = thread_pool_create(1);
+    ThreadPool* pool = thread_pool_create(4);
+    ThreadPool* pools[] = {NULL, single, pool};
+
+    // Each batched row matches the row function bit for bit, whichever pool runs it.
+    for (size_t row = 0; row < NORMALIZE_ROWS; row++) {
+        size_t offset = row * NORMALIZE_COUNT;
+        normalize_layer(x + offset, expected + offset, weight, bias, NORMALIZE_COUNT, 1e-6f);
+        normalize_rms_bf16(half + offset, half_expected + offset, weight, NORMALIZE_COUNT, 1e-6f);
+    }
+    for (size_t p = 0; p < sizeof(pools) / sizeof(ThreadPool*); p++) {
+        failures += !normalize_layer_rows(
+            pools[p], TYPE_FLOAT32, x, y, weight, bias, NORMALIZE_ROWS, NORMALIZE_COUNT, 1e-6f
+        );
+        failures += 0 != memcmp(y, expected, count * sizeof(float));
+
+        failures += !normalize_rms_rows(
+            pools[p], TYPE_BFLOAT16, half, half_y, weight, NORMALIZE_ROWS, NORMALIZE_COUNT, 1e-6f
+        );
+        failures += 0 != memcmp(half_y, half_expected, count * sizeof(uint16_t));
+    }
+
+    // fp16 batches agree with their rows too.
+    quantize_row_fp16(x, half, count);
+    for (size_t row = 0; row < NORMALIZE_ROWS; row++) {
+        size_t offset = row * NORMALIZE_COUNT;
+        normalize_layer_fp16(
+            half + offset, half_expected + offset, NULL, bias, NORMALIZE_COUNT, 1e-6f
+        );
+    }
+    failures += !normalize_layer_rows(
+        pool, TYPE_FLOAT16, half, half_y, NULL, bias, NORMALIZE_ROWS, NORMALIZE_COUNT, 1e-6f
+    );
+    failures += 0 != memcmp(half_y, half_expected, count * sizeof(uint16_t));
+
+    // Types without a float row are refused.
+    failures += normalize_rms_rows(pool, TYPE_INT8, x, y, NULL, 1, NORMALIZE_COUNT, 1e-6f);
+    failures += normalize_layer_rows(
+        pool, TYPE_BLOCK_Q8, x, y, NULL, NULL, 1, NORMALIZE_COUNT, 1e-6f
+    );
+
+    thread_pool_free(single);
+    thread_pool_free(pool);
+    free(x);
+    free(weight);
+    free(bias);
+    free(expected);
+    free(y);
+    free(half);
+    free(half_expected);
+    free(half_y);
+    ASSERT(0 == failures, "[TestNormalizeRows] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"normalize_fp32", test_normalize_fp32},
+        {"normalize_half", test_normalize_half},
+        {"normalize_rows", test_normalize_rows},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,307 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file tests/numeric/test_prime.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/prime.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static bool prime_trial(uint64_t n) {
+    if (n < 2) {
+        return false;
+    }
+    if (n % 2 == 0) {
+        return n == 2;
+    }
+    for (uint64_t d = 3; d * d <= n; d += 2) {
+        if (n % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Iterates [low, high) and compares every number against trial division.
+static size_t prime_check_range(uint64_t low, uint64_t high, const PrimeSieveOptions* options) {
+    size_t failures = 0;
+    PrimeSieve sieve;
+    if (!prime_sieve_create(&sieve, low, high, options)) {
+        return 1;
+    }
+
+    uint64_t expected = low;
+    uint64_t prime;
+    size_t found = 0;
+    while (prime_sieve_next(&sieve, &prime)) {
+        for (; expected < prime; expected++) {
+            failures += prime_trial(expected);
+        }
+        failures += !prime_trial(prime) || prime < low || prime >= high;
+        expected = prime + 1;
+        found++;
+    }
+    for (; expected < high; expected++) {
+        failures += prime_trial(expected);
+    }
+    prime_sieve_free(&sieve);
+
+    uint64_t count = 0;
+    failures += !prime_count(low, high, NULL, options, &count) || count != found;
+    return failures;
+}
+
+/**
+ * @name Sieve
+ * {@
+ */
+
+int test_prime_sieve(void) {
+    size_t failures = 0;
+
+    // Segments of one word and of an odd byte count exercise the carry between segments.
+    PrimeSieveOptions options[] = {
+        {0, true},
+        {0, false},
+        {8, true},
+        {8, false},
+        {100, true},
+    };
+
+    for (size_t i = 0; i < sizeof(options) / sizeof(PrimeSieveOptions); i++) {
+        failures += prime_check_range(0, 20000, &options[i]);
+        failures += prime_check_range(1, 3, &options[i]);
+        failures += prime_check_range(2, 3, &options[i]);
+        failures += prime_check_range(3, 4, &options[i]);
+        failures += prime_check_range(9, 26, &options[i]);
+        failures += prime_check_range(12345, 13579, &options[i]);
+        failures += prime_check_range(1000000000, 1000010000, &options[i]);
+    }
+    failures += prime_check_range(0, 100000, NULL);
+
+    // Empty ranges are valid and yield nothing.
+    uint64_t ranges[][2] = {{0, 0}, {0, 2}, {10, 5}, {24, 29}, {8, 9}};
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        PrimeSieve sieve;
+        uint64_t prime;
+        failures += !prime_sieve_create(&sieve, ranges[i][0], ranges[i][1], NULL);
+        failures += prime_sieve_next(&sieve, &prime);
+        prime_sieve_free(&sieve);
+    }
+
+    PrimeSieve sieve;
+    failures += prime_sieve_create(&sieve, 0, PRIME_SIEVE_LIMIT + 1, NULL);
+
+    ASSERT(0 == failures, "[TestPrimeSieve] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Count
+ * {@
+ */
+
+int test_prime_count(void) {
+    size_t failures = 0;
+
+    // pi(10^k) from the published tables.
+    const uint64_t pi[][2] = {
+        {10, 4},
+        {100, 25},
+        {1000, 168},
+        {1000000, 78498},
+        {10000000, 664579},
+        {100000000, 5761455},
+    };
+
+    ThreadPool* pool = thread_pool_create(4);
+    PrimeSieveOptions plain = {0, false};
+    for (size_t i = 0; i < sizeof(pi) / sizeof(pi[0]); i++) {
+        uint64_t count = 0;
+        failures += !prime_count(0, pi[i][0], NULL, NULL, &count) || count != pi[i][1];
+        failures += !prime_count(0, pi[i][0], pool, NULL, &count) || count != pi[i][1];
+        failures += !prime_count(0, pi[i][0], pool, &plain, &count) || count != pi[i][1];
+    }
+
+    // Split ranges add up.
+    uint64_t left = 0;
+    uint64_t right = 0;
+    failures += !prime_count(0, 4000037, pool, NULL, &left);
+    failures += !prime_count(4000037, 10000000, pool, NULL, &right);
+    failures += left + right != 664579;
+    thread_pool_free(pool);
+
+    ASSERT(0 == failures, "[TestPrimeCount] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Sample
+ * {@
+ */
+
+int test_prime_sample(void) {
+    size_t failures = 0;
+
+    PrimeSample* sample = prime_sample_create(1000);
+    failures += NULL == sample || 168 != sample->size;
+    if (sample) {
+        failures += 2 != sample->data[0] || 997 != sample->data[sample->size - 1];
+        for (uint32_t i = 0; i < sample->size; i++) {
+            failures += !prime_trial((uint64_t) sample->data[i]);
+        }
+        prime_sample_free(sample);
+    }
+
+    // `size` itself is included.
+    sample = prime_sample_create(7);
+    failures += NULL == sample || 4 != sample->size || 7 != sample->data[3];
+    prime_sample_free(sample);
+
+    sample = prime_sample_create(2);
+    failures += NULL == sample || 1 != sample->size || 2 != sample->data[0];
+    prime_sample_free(sample);
+
+    ASSERT(0 == failures, "[TestPrimeSample] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Miller-Rabin
+ * {@
+ */
+
+int test_prime_miller_rabin(void) {
+    size_t failures = 0;
+
+    // Every n below 2^20, and windows at the 2^32 boundary, against the sieve.
+    const uint64_t windows[][2] = {
+        {0, 1 << 20},
+        {UINT32_MAX - 100000, (uint64_t) UINT32_MAX + 100000},
+        {1000000000000, 1000000010000},
+    };
+    for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+        PrimeSieve sieve;
+        uint64_t prime;
+        failures += !prime_sieve_create(&sieve, windows[i][0], windows[i][1], NULL);
+        bool more = prime_sieve_next(&sieve, &prime);
+        for (uint64_t n = windows[i][0]; n < windows[i][1]; n++) {
+            bool expected = more && n == prime;
+            failures += prime_miller_rabin(n) != expected;
+            if (expected) {
+                more = prime_sieve_next(&sieve, &prime);
+            }
+        }
+        prime_sieve_free(&sieve);
+    }
+
+    // Strong pseudoprimes to the smallest bases, Carmichael numbers and semiprimes near 2^64.
+    const uint64_t composites[] = {
+        561,
+        1105,
+        2047,
+        3215031751,
+        4759123141,
+        2152302898747,
+        3474749660383,
+        341550071728321,
+        3825123056546413051,
+        4294967291ull * 4294967279ull,
+        UINT64_MAX,
+    };
+    for (size_t i = 0; i < sizeof(composites) / sizeof(uint64_t); i++) {
+        failures += prime_miller_rabin(composites[i]);
+    }
+
+    const uint64_t primes[] = {
+        4294967291,
+        4294967311,
+        2305843009213693951, // 2^61 - 1
+        9223372036854775783, // 2^63 - 25
+        18446744073709551557u, // 2^64 - 59
+    };
+    for (size_t i = 0; i < sizeof(primes) / sizeof(uint64_t); i++) {
+        failures += !prime_miller_rabin(primes[i]);
+    }
+
+    failures += 1 != prime_modular_exponent(2, 0, 7) || 0 != prime_modular_exponent(5, 0, 1);
+    failures += 1 != prime_modular_exponent(3, 4294967310, 4294967311); // Fermat
+    failures += 1 != prime_modular_exponent(2, 18446744073709551556u, 18446744073709551557u);
+
+    failures += 2 != prime_next(0) || 2 != prime_next(2) || 3 != prime_next(3);
+    failures += 1009 != prime_next(1000) || 4294967311 != prime_next(4294967292);
+    failures += 18446744073709551557u != prime_next(18446744073709551534u); // past 2^64 - 83
+    failures += 0 != prime_next(18446744073709551558u) || 0 != prime_next(UINT64_MAX);
+
+    ASSERT(0 == failures, "[TestPrimeMillerRabin] failures=%zu", failures);
+    return 0;
+}
+
+int test_prime_miller_rabin_batch(void) {
+    size_t failures = 0;
+
+    // Mixed widths, so the vector blocks, the 64-bit fallback and the screen interleave.
+    enum { COUNT = 30011 };
+    uint64_t* n = malloc(COUNT * sizeof(uint64_t));
+    bool* prime = malloc(COUNT * sizeof(bool));
+    for (size_t i = 0; i < COUNT; i++) {
+        switch (i % 3) {
+            case 0:
+                n[i] = i;
+                break;
+            case 1:
+                n[i] = UINT32_MAX - 2 * i;
+                break;
+            default:
+                n[i] = 3825123056546413051 - 2 * i;
+                break;
+        }
+    }
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        prime_miller_rabin_batch(n, prime, COUNT);
+        for (size_t i = 0; i < COUNT; i++) {
+            failures += prime[i] != prime_miller_rabin(n[i]);
+        }
+    }
+    cpu_level_set(cpu_level_detected());
+    prime_miller_rabin_batch(NULL, NULL, 0);
+
+    free(n);
+    free(prime);
+    ASSERT(0 == failures, "[TestPrimeMillerRabinBatch] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"prime_sieve", test_prime_sieve},
+        {"prime_count", test_prime_count},
+        {"prime_sample", test_prime_sample},
+        {"prime_miller_rabin", test_prime_miller_rabin},
+        {"prime_miller_rabin_batch", test_prime_miller_rabin_batch},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,273 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_random.c
+ */
+
+#include "core/logger.h"
+#include "core/cpu.h"
+#include "test/unit.h"
+#include "numeric/random.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const RandomKind RANDOM_KINDS[] = {RANDOM_XOSHIRO256, RANDOM_PCG64, RANDOM_PHILOX};
+static const size_t RANDOM_KINDS_COUNT = sizeof(RANDOM_KINDS) / sizeof(RandomKind);
+
+__extension__ typedef unsigned __int128 PcgU128;
+
+// Compares live generator state; padding and spent Philox words may differ.
+static bool random_equal(const Random* a, const Random* b) {
+    if (a->kind != b->kind) {
+        return false;
+    }
+    switch (a->kind) {
+        case RANDOM_XOSHIRO256:
+            return 0 == memcmp(&a->xoshiro, &b->xoshiro, sizeof(RandomXoshiro));
+        case RANDOM_PCG64:
+            return 0 == memcmp(&a->pcg, &b->pcg, sizeof(RandomPcg));
+        default: {
+            const RandomPhilox* p = &a->philox;
+            const RandomPhilox* q = &b->philox;
+            bool equal = 0 == memcmp(p->key, q->key, sizeof(p->key))
+                         && 0 == memcmp(p->counter, q->counter, sizeof(p->counter))
+                         && p->index == q->index;
+            // Words already drawn are dead.
+            for (uint32_t i = p->index; equal && i < 4; i++) {
+                equal = p->buffer[i] == q->buffer[i];
+            }
+            return equal;
+        }
+    }
+}
+
+/**
+ * @name Known Answers
+ * {@
+ */
+
+// The reference step from the xoshiro256** paper.
+static uint64_t xoshiro_reference(uint64_t* s) {
+    uint64_t x = s[1] * 5;
+    uint64_t result = ((x << 7) | (x >> 57)) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+int test_random_known_answers(void) {
+    size_t failures = 0;
+    Random r;
+
+    // splitmix64 from seed 0 gives 0xE220A8397B1DCDAF first.
+    random_seed(&r, RANDOM_XOSHIRO256, 0);
+    failures += 0xE220A8397B1DCDAFu != r.xoshiro.s[0];
+    uint64_t s[4];
+    memcpy(s, r.xoshiro.s, sizeof(s));
+    for (size_t i = 0; i < 1000; i++) {
+        failures += xoshiro_reference(s) != random_u64(&r);
+    }
+
+    // pcg-c, check-pcg64: pcg64_srandom_r(&rng, 42u, 54u).
+    static const uint64_t pcg[] = {
+        0x86B1DA1D72062B68u,
+        0x1304AA46C9853D39u,
+        0xA3670E9E0DD50358u,
+        0xF9090E529A7DAE00u,
+        0xC85B9FD837996F2Cu,
+        0x606121F8E3919196u,
+    };
+    random_stream(&r, RANDOM_PCG64, 42, 54);
+    for (size_t i = 0; i < sizeof(pcg) / sizeof(uint64_t); i++) {
+        failures += pcg[i] != random_u64(&r);
+    }
+
+    // Random123 kat_vectors for philox4x32_10.
+    static const struct {
+        uint64_t counter[2];
+        uint32_t key[2];
+        uint32_t expect[4];
+    } philox[] = {
+        {{0, 0}, {0, 0}, {0x6627E8D5u, 0xE169C58Du, 0xBC57AC4Cu, 0x9B00DBD8u}},
+        {{UINT64_MAX, UINT64_MAX},
+         {UINT32_MAX, UINT32_MAX},
+         {0x408F276Du, 0x41C83B0Eu, 0xA20BC7C6u, 0x6D5451FDu}},
+        {{0x85A308D3243F6A88u, 0x0370734413198A2Eu},
+         {0xA4093822u, 0x299F31D0u},
+         {0xD16CFE09u, 0x94FDCCEBu, 0x5001E420u, 0x24126EA1u}},
+    };
+    for (size_t i = 0; i < sizeof(philox) / sizeof(philox[0]); i++) {
+        uint64_t seed = philox[i].key[0] | (uint64_t) philox[i].key[1] << 32;
+        random_stream(&r, RANDOM_PHILOX, seed, philox[i].counter[1]);
+        r.philox.counter[0] = philox[i].counter[0];
+        for (size_t j = 0; j < 4; j++) {
+            failures += philox[i].expect[j] != random_u32(&r);
+        }
+    }
+
+    ASSERT(0 == failures, "[TestRandomKnownAnswers] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Bulk Fills
+ * {@
+ */
+
+int test_random_fill(void) {
+    size_t failures = 0;
+    enum { N = 1031 }; // spans whole SIMD batches, partial blocks and tiles
+
+    static uint32_t u32[N];
+    static uint64_t u64[N];
+    static float f32[N];
+    static double f64[N];
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+
+        for (size_t k = 0; k < RANDOM_KINDS_COUNT; k++) {
+            for (size_t offset = 0; offset < 4; offset++) {
+                Random a, b;
+                random_stream(&a, RANDOM_KINDS[k], 7, 3);
+                // Leaves Philox partway through a block so the fill starts from the buffer.
+                for (size_t i = 0; i < offset; i++) {
+                    random_u32(&a);
+                }
+                b = a;
+
+                size_t n = N - offset;
+                random_fill_u32(&a, u32, n);
+                for (size_t i = 0; i < n; i++) {
+                    failures += u32[i] != random_u32(&b);
+                }
+                random_fill_u64(&a, u64, n);
+                for (size_t i = 0; i < n; i++) {
+                    failures += u64[i] != random_u64(&b);
+                }
+                random_fill_float(&a, f32, n);
+                for (size_t i = 0; i < n; i++) {
+                    failures += f32[i] != random_float(&b) || f32[i] < 0.0f || f32[i] >= 1.0f;
+                }
+                random_fill_double(&a, f64, n);
+                for (size_t i = 0; i < n; i++) {
+                    failures += f64[i] != random_double(&b) || f64[i] < 0.0 || f64[i] >= 1.0;
+                }
+                failures += !random_equal(&a, &b);
+            }
+        }
+
+        // Batches that would wrap the low counter word fall back to single blocks.
+        Random a, b;
+        random_seed(&a, RANDOM_PHILOX, 11);
+        a.philox.counter[0] = UINT32_MAX - 5;
+        b = a;
+        random_fill_u32(&a, u32, 64);
+        for (size_t i = 0; i < 64; i++) {
+            failures += u32[i] != random_u32(&b);
+        }
+        failures += !random_equal(&a, &b);
+    }
+    cpu_level_set(cpu_level_detected());
+
+    ASSERT(0 == failures, "[TestRandomFill] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Jumps and Streams
+ * {@
+ */
+
+int test_random_jump(void) {
+    size_t failures = 0;
+
+    // Jumps are linear maps of the state, so they commute with drawing.
+    for (size_t k = 0; k < RANDOM_KINDS_COUNT; k++) {
+        Random a, b;
+        random_seed(&a, RANDOM_KINDS[k], 99);
+        random_u32(&a);
+        b = a;
+
+        random_u64(&a);
+        random_jump(&a);
+        random_jump(&b);
+        random_u64(&b);
+        failures += !random_equal(&a, &b);
+
+        random_u32(&a);
+        random_long_jump(&a);
+        random_long_jump(&b);
+        random_u32(&b);
+        failures += !random_equal(&a, &b);
+    }
+
+    // Neighbouring streams share no prefix.
+    for (size_t k = 0; k < RANDOM_KINDS_COUNT; k++) {
+        Random a, b;
+        random_stream(&a, RANDOM_KINDS[k], 99, 0);
+        random_stream(&b, RANDOM_KINDS[k], 99, 1);
+        for (size_t i = 0; i < 8; i++) {
+            failures += random_u64(&a) == random_u64(&b);
+        }
+    }
+
+    // PCG: the 2^k-step map of the LCG is its one-step affine map squared k times.
+    Random pcg;
+    random_stream(&pcg, RANDOM_PCG64, 1, 2);
+    for (unsigned k = 64; k <= 96; k += 32) {
+        PcgU128 state = ((PcgU128) pcg.pcg.state[1] << 64) | pcg.pcg.state[0];
+        PcgU128 multiply = ((PcgU128) 2549297995355413924u << 64) + 4865540595714422341u;
+        PcgU128 add = ((PcgU128) pcg.pcg.increment[1] << 64) | pcg.pcg.increment[0];
+        for (unsigned i = 0; i < k; i++) {
+            add = add * multiply + add;
+            multiply *= multiply;
+        }
+        state = state * multiply + add;
+
+        64 == k ? random_jump(&pcg) : random_long_jump(&pcg);
+        failures += (uint64_t) state != pcg.pcg.state[0];
+        failures += (uint64_t) (state >> 64) != pcg.pcg.state[1];
+    }
+
+    // Philox: a jump is a counter addition of 2^32 blocks, carried into the high word.
+    Random philox;
+    random_stream(&philox, RANDOM_PHILOX, 5, 17);
+    philox.philox.counter[0] = UINT64_MAX - 3;
+    random_jump(&philox);
+    failures += (((uint64_t) 1 << 32) - 4) != philox.philox.counter[0];
+    failures += 18 != philox.philox.counter[1];
+    random_long_jump(&philox);
+    failures += ((((uint64_t) 1 << 32) - 4) + ((uint64_t) 1 << 48)) != philox.philox.counter[0];
+
+    ASSERT(0 == failures, "[TestRandomJump] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"random_known_answers", test_random_known_answers},
+        {"random_fill", test_random_fill},
+        {"random_jump", test_random_jump},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
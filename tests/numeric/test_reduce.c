@@ -0,0 +1,359 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file tests/numeric/test_reduce.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/distribution.h"
+#include "numeric/reduce.h"
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define REDUCE_COUNT 10007 // not a multiple of any vector width or block
+#define REDUCE_PARALLEL_COUNT 100003 // several ranges of REDUCE_GRAIN
+
+static const ReduceMode MODES[] = {REDUCE_NAIVE, REDUCE_PAIRWISE, REDUCE_KAHAN};
+
+// Naive and pairwise sums are held to a fraction of Σ|t|; Kahan to a couple of roundings of S.
+static bool reduce_close(ReduceMode mode, float value, double expected, double magnitude) {
+    double error = fabs((double) value - expected);
+    if (REDUCE_KAHAN == mode) {
+        return error <= 2.0 * (double) FLT_EPSILON * fabs(expected) + 1e-9 * magnitude;
+    }
+    return error <= 1e-4 * magnitude;
+}
+
+// Scans round within a block before the offset is added, so Kahan is held to Σ|t| as well.
+static bool reduce_scan_close(ReduceMode mode, float value, double expected, double magnitude) {
+    double error = fabs((double) value - expected);
+    return error <= (REDUCE_KAHAN == mode ? 1e-6 : 1e-4) * magnitude;
+}
+
+/**
+ * @name Sums
+ * {@
+ */
+
+int test_reduce_sums(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 3);
+
+    float* x = malloc(REDUCE_COUNT * sizeof(float));
+    float* y = malloc(REDUCE_COUNT * sizeof(float));
+    random_fill_normal(&r, x, REDUCE_COUNT, 0.5f, 2.0f);
+    random_fill_uniform(&r, y, REDUCE_COUNT, -1.0f, 1.0f);
+    float* ones = malloc(REDUCE_COUNT * sizeof(float));
+    for (size_t i = 0; i < REDUCE_COUNT; i++) {
+        ones[i] = 1.0f;
+    }
+    ones[0] = 16777216.0f;
+
+    double sum = 0.0, sum_abs = 0.0, dot = 0.0, dot_abs = 0.0, squares = 0.0;
+    for (size_t i = 0; i < REDUCE_COUNT; i++) {
+        sum += (double) x[i];
+        sum_abs += fabs((double) x[i]);
+        dot += (double) x[i] * (double) y[i];
+        dot_abs += fabs((double) x[i] * (double) y[i]);
+        squares += (double) x[i] * (double) x[i];
+    }
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        for (size_t m = 0; m < sizeof(MODES) / sizeof(ReduceMode); m++) {
+            ReduceMode mode = MODES[m];
+            failures += !reduce_close(mode, reduce_sum(x, REDUCE_COUNT, mode), sum, sum_abs);
+            failures += !reduce_close(mode, reduce_dot(x, y, REDUCE_COUNT, mode), dot, dot_abs);
+            failures += !reduce_close(
+                mode, reduce_norm_l1(x, REDUCE_COUNT, mode), sum_abs, sum_abs
+            );
+            failures += !reduce_close(
+                mode, reduce_norm_l2(x, REDUCE_COUNT, mode), sqrt(squares), sqrt(squares)
+            );
+
+            // Short rows reach only the tails.
+            for (size_t n = 0; n < 40; n++) {
+                double partial = 0.0;
+                double magnitude = 0.0;
+                for (size_t i = 0; i < n; i++) {
+                    partial += (double) x[i];
+                    magnitude += fabs((double) x[i]);
+                }
+                failures += !reduce_close(mode, reduce_sum(x, n, mode), partial, magnitude);
+            }
+        }
+
+        // 2^24 absorbs every 1 added to it one at a time; compensation recovers them exactly.
+        float expected = 16777216.0f + (REDUCE_COUNT - 1);
+        failures += expected != reduce_sum(ones, REDUCE_COUNT, REDUCE_KAHAN);
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(x);
+    free(y);
+    free(ones);
+    ASSERT(0 == failures, "[TestReduceSums] failures=%zu", failures);
+    return 0;
+}
+
+int test_reduce_moments(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 5);
+
+    // Far from zero, where a one-pass E[x^2] - E[x]^2 would cancel away the variance.
+    float* x = malloc(REDUCE_COUNT * sizeof(float));
+    random_fill_uniform(&r, x, REDUCE_COUNT, 1000.0f, 1001.0f);
+    double mean = 0.0;
+    for (size_t i = 0; i < REDUCE_COUNT; i++) {
+        mean += (double) x[i];
+    }
+    mean /= REDUCE_COUNT;
+    double variance = 0.0;
+    for (size_t i = 0; i < REDUCE_COUNT; i++) {
+        variance += ((double) x[i] - mean) * ((double) x[i] - mean);
+    }
+    variance /= REDUCE_COUNT;
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        for (size_t m = 0; m < sizeof(MODES) / sizeof(ReduceMode); m++) {
+            float mu, sigma2;
+            reduce_moments(x, REDUCE_COUNT, MODES[m], &mu, &sigma2);
+            failures += fabs((double) mu - mean) > 1e-3;
+            failures += fabs((double) sigma2 - variance) > 1e-3 * variance;
+        }
+        float mu, sigma2;
+        reduce_moments(x, 1, REDUCE_NAIVE, &mu, &sigma2);
+        failures += mu != x[0] || sigma2 != 0.0f;
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(x);
+    ASSERT(0 == failures, "[TestReduceMoments] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Extrema
+ * {@
+ */
+
+int test_reduce_extrema(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 7);
+
+    float* x = malloc(REDUCE_COUNT * sizeof(float));
+    random_fill_uniform(&r, x, REDUCE_COUNT, -1.0f, 1.0f);
+    x[5] = NAN; // skipped, even ahead of the extrema
+    x[1000] = 3.0f;
+    x[7000] = 3.0f; // tie: the first wins
+    x[REDUCE_COUNT - 1] = -2.0f; // in the scalar tail
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        failures += 3.0f != reduce_max(x, REDUCE_COUNT) || 1000 != reduce_argmax(x, REDUCE_COUNT);
+        failures += -2.0f != reduce_min(x, REDUCE_COUNT);
+        failures += REDUCE_COUNT - 1 != reduce_argmin(x, REDUCE_COUNT);
+
+        // Every prefix, so the extremum lands in each lane and tail position.
+        for (size_t n = 1; n < 70; n++) {
+            size_t expected = 0;
+            for (size_t i = 1; i < n; i++) {
+                expected = x[i] > x[expected] || isnan(x[expected]) ? i : expected;
+            }
+            failures += expected != reduce_argmax(x, n) || x[expected] != reduce_max(x, n);
+        }
+
+        // Only NaN, and infinities that look like the empty extremum.
+        float nan[40];
+        for (size_t i = 0; i < 40; i++) {
+            nan[i] = NAN;
+        }
+        failures += !isnan(reduce_max(nan, 40)) || 0 != reduce_argmax(nan, 40);
+        failures += !isnan(reduce_min(nan, 40)) || 0 != reduce_argmin(nan, 40);
+        nan[33] = -INFINITY;
+        failures += -INFINITY != reduce_max(nan, 40) || 33 != reduce_argmax(nan, 40);
+        failures += -INFINITY != reduce_min(nan, 40) || 33 != reduce_argmin(nan, 40);
+    }
+    cpu_level_set(cpu_level_detected());
+
+    free(x);
+    ASSERT(0 == failures, "[TestReduceExtrema] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Scans
+ * {@
+ */
+
+int test_reduce_scans(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 11);
+
+    // Small integers keep every prefix exact, so all modes and levels must match exactly.
+    int32_t* digits = malloc(REDUCE_COUNT * sizeof(int32_t));
+    float* x = malloc(REDUCE_COUNT * sizeof(float));
+    float* output = malloc(REDUCE_COUNT * sizeof(float));
+    random_fill_range(&r, digits, REDUCE_COUNT, -9, 10);
+
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        for (size_t m = 0; m < sizeof(MODES) / sizeof(ReduceMode); m++) {
+            for (size_t i = 0; i < REDUCE_COUNT; i++) {
+                x[i] = (float) digits[i];
+            }
+            reduce_scan_inclusive(x, output, REDUCE_COUNT, MODES[m]);
+            int32_t prefix = 0;
+            for (size_t i = 0; i < REDUCE_COUNT; i++) {
+                prefix += digits[i];
+                failures += (float) prefix != output[i];
+            }
+
+            reduce_scan_exclusive(x, x, REDUCE_COUNT, MODES[m]); // in place
+            prefix = 0;
+            for (size_t i = 0; i < REDUCE_COUNT; i++) {
+                failures += (float) prefix != x[i];
+                prefix += digits[i];
+            }
+        }
+    }
+
+    // Fractions round; the compensated offsets keep late prefixes close.
+    random_fill_uniform(&r, x, REDUCE_COUNT, 0.0f, 1.0f);
+    for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+        cpu_level_set(level);
+        for (size_t m = 0; m < sizeof(MODES) / sizeof(ReduceMode); m++) {
+            reduce_scan_inclusive(x, output, REDUCE_COUNT, MODES[m]);
+            double prefix = 0.0;
+            for (size_t i = 0; i < REDUCE_COUNT; i++) {
+                prefix += (double) x[i];
+                failures += !reduce_scan_close(MODES[m], output[i], prefix, prefix);
+            }
+        }
+    }
+    cpu_level_set(cpu_level_detected());
+    reduce_scan_inclusive(x, output, 0, REDUCE_KAHAN);
+
+    free(digits);
+    free(x);
+    free(output);
+    ASSERT(0 == failures, "[TestReduceScans] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Parallel
+ * {@
+ */
+
+int test_reduce_parallel(void) {
+    size_t failures = 0;
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 13);
+
+    float* x = malloc(REDUCE_PARALLEL_COUNT * sizeof(float));
+    float* a = malloc(REDUCE_PARALLEL_COUNT * sizeof(float));
+    float* b = malloc(REDUCE_PARALLEL_COUNT * sizeof(float));
+    random_fill_normal(&r, x, REDUCE_PARALLEL_COUNT, 0.0f, 1.0f);
+    x[REDUCE_PARALLEL_COUNT - 10] = 100.0f;
+    x[REDUCE_PARALLEL_COUNT - 5] = 100.0f;
+    x[3 * REDUCE_GRAIN + 1] = -100.0f;
+
+    double sum = 0.0;
+    double magnitude = 0.0;
+    for (size_t i = 0; i < REDUCE_PARALLEL_COUNT; i++) {
+        sum += (double) x[i];
+        magnitude += fabs((double) x[i]);
+    }
+
+    ThreadPool* single = thread_pool_create(1);
+    ThreadPool* pool = thread_pool_create(4);
+    for (size_t m = 0; m < sizeof(MODES) / sizeof(ReduceMode); m++) {
+        ReduceMode mode = MODES[m];
+        float serial = reduce_sum(x, REDUCE_PARALLEL_COUNT, mode);
+        float parallel = reduce_sum_parallel(pool, x, REDUCE_PARALLEL_COUNT, mode);
+
+        // A fixed pool size repeats bit for bit; one thread is the serial result.
+        failures += parallel != reduce_sum_parallel(pool, x, REDUCE_PARALLEL_COUNT, mode);
+        failures += serial != reduce_sum_parallel(single, x, REDUCE_PARALLEL_COUNT, mode);
+        failures += !reduce_close(mode, parallel, sum, magnitude);
+
+        float dot = reduce_dot_parallel(pool, x, x, REDUCE_PARALLEL_COUNT, mode);
+        float l2 = reduce_norm_l2_parallel(pool, x, REDUCE_PARALLEL_COUNT, mode);
+        failures += dot != reduce_dot_parallel(pool, x, x, REDUCE_PARALLEL_COUNT, mode);
+        failures += fabsf(l2 * l2 - dot) > 1e-4f * dot;
+        failures += reduce_norm_l1_parallel(pool, x, REDUCE_PARALLEL_COUNT, mode)
+                    != reduce_norm_l1_parallel(pool, x, REDUCE_PARALLEL_COUNT, mode);
+
+        float mean, variance, serial_mean, serial_variance;
+        reduce_moments_parallel(pool, x, REDUCE_PARALLEL_COUNT, mode, &mean, &variance);
+        reduce_moments(x, REDUCE_PARALLEL_COUNT, mode, &serial_mean, &serial_variance);
+        failures += fabsf(mean - serial_mean) > 1e-5f;
+        failures += fabsf(variance - serial_variance) > 1e-4f * serial_variance;
+
+        reduce_scan_inclusive_parallel(pool, x, a, REDUCE_PARALLEL_COUNT, mode);
+        reduce_scan_inclusive_parallel(pool, x, b, REDUCE_PARALLEL_COUNT, mode);
+        double prefix = 0.0;
+        double total = 0.0;
+        for (size_t i = 0; i < REDUCE_PARALLEL_COUNT; i++) {
+            failures += a[i] != b[i];
+            prefix += (double) x[i];
+            total += fabs((double) x[i]);
+            failures += !reduce_scan_close(mode, a[i], prefix, total);
+        }
+        reduce_scan_exclusive_parallel(pool, x, b, REDUCE_PARALLEL_COUNT, mode);
+        failures += 0.0f != b[0];
+    }
+
+    failures += 100.0f != reduce_max_parallel(pool, x, REDUCE_PARALLEL_COUNT);
+    size_t index = reduce_argmax_parallel(pool, x, REDUCE_PARALLEL_COUNT);
+    failures += REDUCE_PARALLEL_COUNT - 10 != index;
+    failures += -100.0f != reduce_min_parallel(pool, x, REDUCE_PARALLEL_COUNT);
+    failures += 3 * REDUCE_GRAIN + 1 != reduce_argmin_parallel(pool, x, REDUCE_PARALLEL_COUNT);
+    failures += reduce_argmax(x, 1000) != reduce_argmax_parallel(pool, x, 1000);
+
+    thread_pool_free(single);
+    thread_pool_free(pool);
+    free(x);
+    free(a);
+    free(b);
+    ASSERT(0 == failures, "[TestReduceParallel] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"reduce_sums", test_reduce_sums},
+        {"reduce_moments", test_reduce_moments},
+        {"reduce_extrema", test_reduce_extrema},
+        {"reduce_scans", test_reduce_scans},
+        {"reduce_parallel", test_reduce_parallel},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,436 @@
+/**
+ * Copyright © 2024 Austin Berrio
+ *
+ * @file tests/numeric/test_sparse.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "numeric/random.h"
+#include "numeric/sparse.h"
+#include "numeric/type.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPARSE_DENSITY 0.1f // fraction of nonzero elements
+#define SPARSE_PAD 3 // extra columns past every row of a dense operand
+
+typedef struct TestSparseShape {
+    size_t rows;
+    size_t cols;
+    size_t block_rows;
+    size_t block_cols;
+} TestSparseShape;
+
+// Odd sizes, blocks narrower and wider than a vector, and rows past one widening tile.
+static const TestSparseShape sparse_shapes[] = {
+    {37, 53, 1, 1},
+    {64, 96, 4, 8},
+    {128, 160, 2, 32},
+    {8, 1024, 1, 64},
+};
+
+#define SPARSE_SHAPE_COUNT (sizeof(sparse_shapes) / sizeof(TestSparseShape))
+
+static const DataTypeId sparse_types[] = {
+    TYPE_FLOAT32,
+    TYPE_FLOAT16,
+    TYPE_BFLOAT16,
+    TYPE_FLOAT8_E4M3,
+    TYPE_FLOAT8_E5M2,
+    TYPE_BLOCK_Q8,
+    TYPE_BLOCK_Q4,
+};
+
+#define SPARSE_TYPE_COUNT (sizeof(sparse_types) / sizeof(DataTypeId))
+
+// Row-major rows x cols with leading dimension cols + SPARSE_PAD and about 10% nonzeros.
+static float* sparse_dense_create(Random* r, size_t rows, size_t cols) {
+    size_t ld = cols + SPARSE_PAD;
+    float* dense = malloc(rows * ld * sizeof(float));
+    if (dense) {
+        for (size_t i = 0; i < rows * ld; i++) {
+            dense[i] = random_float(r) < SPARSE_DENSITY ? random_float(r) * 4.0f - 2.0f : 0.0f;
+        }
+    }
+    return dense;
+}
+
+static bool sparse_build(
+    SparseMatrix* m,
+    SparseFormat format,
+    DataTypeId type,
+    const float* dense,
+    TestSparseShape s,
+    float threshold
+) {
+    size_t ld = s.cols + SPARSE_PAD;
+    switch (format) {
+        case SPARSE_CSR:
+            return sparse_csr_from_dense(m, type, dense, s.rows, s.cols, ld, threshold);
+        case SPARSE_CSC:
+            return sparse_csc_from_dense(m, type, dense, s.rows, s.cols, ld, threshold);
+        case SPARSE_BSR:
+            return sparse_bsr_from_dense(
+                m, type, dense, s.rows, s.cols, ld, threshold, s.block_rows, s.block_cols
+            );
+    }
+    return false;
+}
+
+// Stored values as fp32: the reference every product is checked against.
+static float* sparse_expected(const SparseMatrix* m) {
+    float* dense = malloc(m->rows * m->cols * sizeof(float));
+    if (dense) {
+        sparse_to_dense(m, dense, m->cols);
+    }
+    return dense;
+}
+
+/**
+ * @name Builders
+ * {@
+ */
+
+int test_sparse_build(void) {
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 3);
+
+    for (size_t si = 0; si < SPARSE_SHAPE_COUNT; si++) {
+        TestSparseShape s = sparse_shapes[si];
+        size_t ld = s.cols + SPARSE_PAD;
+        float* dense = sparse_dense_create(&r, s.rows, s.cols);
+        float* restored = malloc(s.rows * ld * sizeof(float));
+        ASSERT(dense && restored, "[TestSparseBuild] allocation failed");
+
+        size_t nonzero = 0;
+        for (size_t i = 0; i < s.rows; i++) {
+            for (size_t j = 0; j < s.cols; j++) {
+                nonzero += 0.0f != dense[i * ld + j];
+            }
+        }
+
+        // fp32 storage restores the matrix exactly, padding columns untouched.
+        for (SparseFormat format = SPARSE_CSR; format <= SPARSE_BSR; format++) {
+            SparseMatrix m;
+            ASSERT(
+                sparse_build(&m, format, TYPE_FLOAT32, dense, s, 0.0f),
+                "[TestSparseBuild] format=%d %zux%zu failed",
+                (int) format,
+                s.rows,
+                s.cols
+            );
+
+            size_t lines = SPARSE_CSC == format ? s.cols : s.rows / m.block_rows;
+            size_t stored = SPARSE_BSR == format ? m.count * s.block_rows * s.block_cols : m.count;
+            ASSERT(
+                m.offsets[0] == 0 && m.offsets[lines] == m.count && stored >= nonzero
+                    && (SPARSE_BSR == format || m.count == nonzero),
+                "[TestSparseBuild] format=%d count=%zu nonzero=%zu",
+                (int) format,
+                m.count,
+                nonzero
+            );
+            for (size_t line = 0; line < lines; line++) {
+                for (size_t k = m.offsets[line]; k + 1 < m.offsets[line + 1]; k++) {
+                    ASSERT(
+                        m.indices[k] < m.indices[k + 1],
+                        "[TestSparseBuild] format=%d line %zu not sorted",
+                        (int) format,
+                        line
+                    );
+                }
+            }
+
+            for (size_t i = 0; i < s.rows * ld; i++) {
+                restored[i] = -7.0f;
+            }
+            sparse_to_dense(&m, restored, ld);
+            for (size_t i = 0; i < s.rows; i++) {
+                ASSERT(
+                    0 == memcmp(restored + i * ld, dense + i * ld, s.cols * sizeof(float))
+                        && -7.0f == restored[i * ld + s.cols],
+                    "[TestSparseBuild] format=%d row %zu differs",
+                    (int) format,
+                    i
+                );
+            }
+            sparse_free(&m);
+            ASSERT(NULL == m.values && 0 == m.count, "[TestSparseBuild] free left state behind");
+        }
+
+        // A threshold keeps only the larger magnitudes.
+        SparseMatrix m;
+        ASSERT(
+            sparse_build(&m, SPARSE_CSR, TYPE_FLOAT32, dense, s, 1.0f),
+            "[TestSparseBuild] threshold failed"
+        );
+        const float* values = (const float*) m.values;
+        for (size_t k = 0; k < m.count; k++) {
+            ASSERT(fabsf(values[k]) > 1.0f, "[TestSparseBuild] kept %g", (double) values[k]);
+        }
+        sparse_free(&m);
+
+        free(dense);
+        free(restored);
+    }
+
+    // Unsupported value types and shapes leave nothing behind.
+    float dense[64 * 64] = {0};
+    SparseMatrix m;
+    ASSERT(
+        !sparse_csr_from_dense(&m, TYPE_INT8, dense, 64, 64, 64, 0.0f) && NULL == m.offsets,
+        "[TestSparseBuild] accepted int8 values"
+    );
+    ASSERT(
+        !sparse_csc_from_dense(&m, TYPE_BLOCK_Q8, dense, 64, 64, 64, 0.0f),
+        "[TestSparseBuild] accepted Q8 values for CSC"
+    );
+    ASSERT(
+        !sparse_bsr_from_dense(&m, TYPE_BLOCK_Q4, dense, 64, 64, 64, 0.0f, 4, 16),
+        "[TestSparseBuild] accepted Q4 blocks narrower than BLOCK_SIZE"
+    );
+    ASSERT(
+        !sparse_bsr_from_dense(&m, TYPE_FLOAT32, dense, 64, 60, 64, 0.0f, 4, 8),
+        "[TestSparseBuild] accepted columns that are not a multiple of the block"
+    );
+
+    // An all-zero matrix stores nothing and multiplies to zero.
+    ASSERT(
+        sparse_csr_from_dense(&m, TYPE_FLOAT16, dense, 64, 64, 64, 0.0f) && 0 == m.count,
+        "[TestSparseBuild] zero matrix count=%zu",
+        m.count
+    );
+    float x[64];
+    float y[64];
+    for (size_t i = 0; i < 64; i++) {
+        x[i] = 1.0f;
+        y[i] = 5.0f;
+    }
+    ASSERT(sparse_spmv(NULL, &m, x, y), "[TestSparseBuild] zero matrix spmv failed");
+    for (size_t i = 0; i < 64; i++) {
+        ASSERT(0.0f == y[i], "[TestSparseBuild] zero matrix y[%zu]=%g", i, (double) y[i]);
+    }
+    sparse_free(&m);
+    sparse_free(NULL);
+
+    // A NaN is kept whatever the threshold and reaches its output row, as in a dense product.
+    dense[3 * 64 + 5] = NAN;
+    SparseMatrix kept[3];
+    bool built = sparse_csr_from_dense(&kept[0], TYPE_FLOAT32, dense, 64, 64, 64, 1.0f);
+    built = sparse_csc_from_dense(&kept[1], TYPE_FLOAT32, dense, 64, 64, 64, 1.0f) && built;
+    built = sparse_bsr_from_dense(&kept[2], TYPE_FLOAT32, dense, 64, 64, 64, 1.0f, 4, 4) && built;
+    ASSERT(built, "[TestSparseBuild] NaN matrix failed");
+    for (size_t f = 0; f < 3; f++) {
+        ASSERT(1 == kept[f].count, "[TestSparseBuild] format=%zu dropped the NaN", f);
+        ASSERT(sparse_spmv(NULL, &kept[f], x, y), "[TestSparseBuild] NaN spmv failed");
+        for (size_t i = 0; i < 64; i++) {
+            ASSERT(
+                (3 == i) == (0 != isnan(y[i])),
+                "[TestSparseBuild] format=%zu NaN y[%zu]=%g",
+                f,
+                i,
+                (double) y[i]
+            );
+        }
+        sparse_free(&kept[f]);
+    }
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Products
+ * {@
+ */
+
+// Checks y = A · x for one matrix against a double product with its stored values.
+static bool sparse_spmv_check(const SparseMatrix* m, const float* x, size_t* wrong) {
+    float* expected = sparse_expected(m);
+    float* y = malloc(m->rows * sizeof(float));
+    bool ok = expected && y && sparse_spmv(NULL, m, x, y);
+
+    // Block formats multiply with a Q8 copy of x, each element off by at most max|x| / 254
+    // (max|x| is 1 here), so that much of Σ |a_ij| is allowed on top of rounding.
+    bool block = TYPE_BLOCK_Q8 == m->type || TYPE_BLOCK_Q4 == m->type;
+    for (size_t i = 0; ok && i < m->rows; i++) {
+        double sum = 0.0;
+        double magnitude = 0.0;
+        double weight = 0.0;
+        for (size_t j = 0; j < m->cols; j++) {
+            double a = (double) expected[i * m->cols + j];
+            sum += a * (double) x[j];
+            magnitude += fabs(a * (double) x[j]);
+            weight += fabs(a);
+        }
+        double tolerance = 1e-5 * magnitude + (block ? weight / 254.0 : 0.0) + 1e-6;
+        *wrong += fabs((double) y[i] - sum) > tolerance;
+    }
+    free(expected);
+    free(y);
+    return ok;
+}
+
+// Checks C = A · B; the pad columns of C must keep their sentinel.
+static bool sparse_spmm_check(const SparseMatrix* m, const float* b, size_t n, size_t* wrong) {
+    size_t ldb = n + SPARSE_PAD;
+    size_t ldc = n + SPARSE_PAD;
+    float* expected = sparse_expected(m);
+    float* c = malloc(m->rows * ldc * sizeof(float));
+    if (!expected || !c) {
+        free(expected);
+        free(c);
+        return false;
+    }
+    for (size_t i = 0; i < m->rows * ldc; i++) {
+        c[i] = -7.0f;
+    }
+
+    sparse_spmm(NULL, m, b, ldb, c, ldc, n);
+    for (size_t i = 0; i < m->rows; i++) {
+        for (size_t j = 0; j < n; j++) {
+            double sum = 0.0;
+            double magnitude = 0.0;
+            for (size_t k = 0; k < m->cols; k++) {
+                double t = (double) expected[i * m->cols + k] * (double) b[k * ldb + j];
+                sum += t;
+                magnitude += fabs(t);
+            }
+            *wrong += fabs((double) c[i * ldc + j] - sum) > 1e-5 * magnitude + 1e-6;
+        }
+        *wrong += -7.0f != c[i * ldc + n];
+    }
+    free(expected);
+    free(c);
+    return true;
+}
+
+int test_sparse_products(void) {
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 5);
+
+    for (size_t si = 0; si < SPARSE_SHAPE_COUNT; si++) {
+        TestSparseShape s = sparse_shapes[si];
+        float* dense = sparse_dense_create(&r, s.rows, s.cols);
+        float* x = malloc(s.cols * sizeof(float));
+        size_t n = 19; // one AVX2 pair of lanes, one more vector and a tail
+        float* b = malloc(s.cols * (n + SPARSE_PAD) * sizeof(float));
+        ASSERT(dense && x && b, "[TestSparseProducts] allocation failed");
+        for (size_t i = 0; i < s.cols; i++) {
+            x[i] = random_float(&r) * 2.0f - 1.0f;
+        }
+        for (size_t i = 0; i < s.cols * (n + SPARSE_PAD); i++) {
+            b[i] = random_float(&r) * 2.0f - 1.0f;
+        }
+
+        for (size_t ti = 0; ti < SPARSE_TYPE_COUNT; ti++) {
+            DataTypeId type = sparse_types[ti];
+            for (SparseFormat format = SPARSE_CSR; format <= SPARSE_BSR; format++) {
+                SparseMatrix m;
+                if (!sparse_build(&m, format, type, dense, s, 0.0f)) {
+                    // Only the block formats may refuse, and only outside whole-block BSR.
+                    bool block = TYPE_BLOCK_Q8 == type || TYPE_BLOCK_Q4 == type;
+                    ASSERT(
+                        block && (SPARSE_BSR != format || 0 != s.block_cols % BLOCK_SIZE),
+                        "[TestSparseProducts] %s format=%d refused",
+                        data_type_name(type),
+                        (int) format
+                    );
+                    continue;
+                }
+
+                for (CpuLevel level = CPU_LEVEL_SCALAR; level <= cpu_level_detected(); level++) {
+                    cpu_level_set(level);
+                    size_t wrong = 0;
+                    bool ok = sparse_spmv_check(&m, x, &wrong);
+                    ok = sparse_spmm_check(&m, b, n, &wrong) && ok;
+                    ASSERT(
+                        ok && 0 == wrong,
+                        "[TestSparseProducts] %s %s format=%d %zux%zu: wrong=%zu",
+                        cpu_level_name(level),
+                        data_type_name(type),
+                        (int) format,
+                        s.rows,
+                        s.cols,
+                        wrong
+                    );
+                }
+                cpu_level_set(cpu_level_detected());
+                sparse_free(&m);
+            }
+        }
+
+        free(dense);
+        free(x);
+        free(b);
+    }
+    return 0;
+}
+
+// Every output row belongs to one thread, so any pool gives the serial result bit for bit.
+int test_sparse_parallel(void) {
+    Random r;
+    random_seed(&r, RANDOM_PHILOX, 9);
+    TestSparseShape s = {512, 384, 4, 32};
+    size_t n = 24;
+    float* dense = sparse_dense_create(&r, s.rows, s.cols);
+    float* x = malloc(s.cols * sizeof(float));
+    float* b = malloc(s.cols * (n + SPARSE_PAD) * sizeof(float));
+    float* serial = malloc(s.rows * n * sizeof(float));
+    float* parallel = malloc(s.rows * n * sizeof(float));
+    ThreadPool* pool = thread_pool_create(4);
+    ASSERT(dense && x && b && serial && parallel && pool, "[TestSparseParallel] allocation failed");
+    for (size_t i = 0; i < s.cols; i++) {
+        x[i] = random_float(&r) - 0.5f;
+    }
+    for (size_t i = 0; i < s.cols * (n + SPARSE_PAD); i++) {
+        b[i] = random_float(&r) - 0.5f;
+    }
+
+    size_t failures = 0;
+    for (SparseFormat format = SPARSE_CSR; format <= SPARSE_BSR; format++) {
+        SparseMatrix m;
+        DataTypeId type = SPARSE_BSR == format ? TYPE_BLOCK_Q8 : TYPE_FLOAT16;
+        ASSERT(sparse_build(&m, format, type, dense, s, 0.0f), "[TestSparseParallel] build");
+
+        failures += !sparse_spmv(NULL, &m, x, serial);
+        failures += !sparse_spmv(pool, &m, x, parallel);
+        failures += 0 != memcmp(serial, parallel, s.rows * sizeof(float));
+
+        sparse_spmm(NULL, &m, b, n + SPARSE_PAD, serial, n, n);
+        sparse_spmm(pool, &m, b, n + SPARSE_PAD, parallel, n, n);
+        failures += 0 != memcmp(serial, parallel, s.rows * n * sizeof(float));
+        sparse_free(&m);
+    }
+
+    thread_pool_free(pool);
+    free(dense);
+    free(x);
+    free(b);
+    free(serial);
+    free(parallel);
+    ASSERT(0 == failures, "[TestSparseParallel] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"sparse_build", test_sparse_build},
+        {"sparse_products", test_sparse_products},
+        {"sparse_parallel", test_sparse_parallel},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
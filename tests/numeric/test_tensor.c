@@ -0,0 +1,374 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_tensor.c
+ */
+
+#include "core/logger.h"
+#include "core/thread.h"
+#include "test/unit.h"
+#include "allocator/arena.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/matrix.h"
+#include "numeric/tensor.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void tensor_fill(Tensor* t) {
+    float* values = t->data;
+    for (size_t i = 0; i < tensor_count(t); i++) {
+        values[i] = lehmer_generate_float() * 2.0f - 1.0f;
+    }
+}
+
+static float tensor_get(const Tensor* t, size_t i, size_t j) {
+    size_t index[2] = {i, j};
+    return *(const float*) tensor_at(t, index);
+}
+
+/**
+ * @name Layout
+ * {@
+ */
+
+int test_tensor_create(void) {
+    size_t shape[3] = {3, 5, 7};
+    size_t failures = 0;
+
+    Tensor t;
+    failures += !tensor_create(&t, TYPE_FLOAT32, 3, shape, NULL);
+    failures += 0 != (uintptr_t) t.data % TENSOR_ALIGNMENT;
+    failures += 105 != tensor_count(&t) || 35 != t.stride[0] || 7 != t.stride[1];
+    failures += 1 != t.stride[2] || !tensor_is_contiguous(&t);
+    for (size_t i = 0; i < tensor_count(&t); i++) {
+        failures += 0.0f != ((float*) t.data)[i];
+    }
+    tensor_free(&t);
+    failures += NULL != t.data;
+
+    // Packed rows are padded to whole blocks.
+    size_t rows[2] = {4, BLOCK_SIZE + 1};
+    failures += !tensor_create(&t, TYPE_BLOCK_Q8, 2, rows, NULL);
+    failures += 2 * BLOCK_SIZE != t.stride[0];
+    size_t index[2] = {1, BLOCK_SIZE};
+    uint8_t* unit = tensor_at(&t, index);
+    failures += unit != (uint8_t*) t.data + 3 * sizeof(BlockQ8);
+    tensor_free(&t);
+
+    // Arena storage is released with the arena.
+    Arena* arena = arena_create(1 << 16);
+    TensorAllocator allocator = tensor_allocator_arena(arena);
+    failures += !tensor_create(&t, TYPE_FLOAT16, 3, shape, &allocator);
+    failures += 0 != (uintptr_t) t.data % TENSOR_ALIGNMENT;
+    tensor_free(&t);
+    arena_free(arena);
+
+    failures += tensor_create(&t, TYPE_COUNT, 3, shape, NULL);
+    size_t huge[2] = {SIZE_MAX / 2, 4};
+    failures += tensor_create(&t, TYPE_FLOAT32, 2, huge, NULL);
+
+    ASSERT(0 == failures, "[TestTensorCreate] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Views
+ * {@
+ */
+
+int test_tensor_views(void) {
+    size_t shape[3] = {2, 3, 4};
+    float values[24];
+    for (size_t i = 0; i < 24; i++) {
+        values[i] = (float) i;
+    }
+
+    Tensor t = tensor_wrap(values, TYPE_FLOAT32, 3, shape);
+    size_t failures = 0;
+
+    // values[i][j][k] = 12i + 4j + k
+    Tensor s;
+    failures += !tensor_slice(&t, 2, 1, 4, 2, &s);
+    size_t at[3] = {1, 2, 1};
+    failures += 2 != s.shape[2] || 23.0f != *(float*) tensor_at(&s, at);
+    failures += tensor_is_contiguous(&s);
+    failures += tensor_slice(&t, 2, 3, 5, 1, &s) || tensor_slice(&t, 3, 0, 1, 1, &s);
+
+    Tensor p;
+    size_t axes[3] = {2, 0, 1};
+    failures += !tensor_permute(&t, axes, &p);
+    size_t pt[3] = {3, 1, 2};
+    failures += 4 != p.shape[0] || 23.0f != *(float*) tensor_at(&p, pt);
+    size_t bad[3] = {0, 0, 1};
+    failures += tensor_permute(&t, bad, &p);
+
+    Tensor tr;
+    failures += !tensor_transpose(&t, 0, 1, &tr);
+    size_t trt[3] = {2, 1, 3};
+    failures += 23.0f != *(float*) tensor_at(&tr, trt) || tensor_is_contiguous(&tr);
+
+    // Merging the outer axes of a contiguous tensor works; merging transposed axes does not.
+    Tensor r;
+    size_t merged[2] = {6, 4};
+    failures += !tensor_reshape(&t, 2, merged, &r) || 21.0f != tensor_get(&r, 5, 1);
+    size_t split[4] = {2, 3, 2, 2};
+    failures += !tensor_reshape(&t, 4, split, &r);
+    size_t rt[4] = {1, 1, 1, 0};
+    failures += 18.0f != *(float*) tensor_at(&r, rt);
+    failures += tensor_reshape(&tr, 2, merged, &r);
+    size_t ones[5] = {1, 6, 1, 4, 1};
+    failures += !tensor_reshape(&t, 5, ones, &r) || !tensor_is_contiguous(&r);
+
+    // A slice of rows keeps its inner axes contiguous, so those still merge.
+    Tensor rows;
+    failures += !tensor_slice(&t, 1, 1, 3, 1, &rows);
+    size_t flat[2] = {2, 8};
+    failures += !tensor_reshape(&rows, 2, flat, &r) || 20.0f != tensor_get(&r, 1, 4);
+    failures += tensor_reshape(&rows, 1, (size_t[]) {16}, &r);
+
+    Tensor b;
+    size_t wide[4] = {5, 2, 3, 4};
+    failures += !tensor_broadcast(&t, 4, wide, &b) || 0 != b.stride[0];
+    size_t bt[4] = {4, 1, 2, 3};
+    failures += 23.0f != *(float*) tensor_at(&b, bt);
+    Tensor column = tensor_wrap(values, TYPE_FLOAT32, 2, (size_t[]) {3, 1});
+    size_t grid[2] = {3, 5};
+    failures += !tensor_broadcast(&column, 2, grid, &b) || 2.0f != tensor_get(&b, 2, 4);
+    failures += tensor_broadcast(&t, 2, grid, &b);
+
+    // Packed types keep their last axis in place.
+    size_t qshape[2] = {4, 2 * BLOCK_SIZE};
+    Tensor q;
+    tensor_create(&q, TYPE_BLOCK_Q4, 2, qshape, NULL);
+    failures += tensor_transpose(&q, 0, 1, &r) || !tensor_slice(&q, 0, 1, 4, 2, &r);
+    failures += !tensor_slice(&q, 1, BLOCK_SIZE, 2 * BLOCK_SIZE, 1, &r);
+    failures += tensor_slice(&q, 1, 1, 2 * BLOCK_SIZE, 1, &r);
+    failures += !tensor_reshape(&q, 3, (size_t[]) {2, 2, 2 * BLOCK_SIZE}, &r);
+    failures += !tensor_reshape(&q, 2, (size_t[]) {8, BLOCK_SIZE}, &r);
+    failures += tensor_reshape(&q, 2, (size_t[]) {2 * BLOCK_SIZE, 4}, &r);
+    tensor_free(&q);
+
+    ASSERT(0 == failures, "[TestTensorViews] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Kernels
+ * {@
+ */
+
+// Strided views against the same kernels run on contiguous copies.
+int test_tensor_convert(void) {
+    ThreadPool* pool = thread_pool_create(3);
+    size_t shape[2] = {37, 1500};
+    size_t failures = 0;
+
+    Tensor a, h, back;
+    tensor_create(&a, TYPE_FLOAT32, 2, shape, NULL);
+    tensor_create(&h, TYPE_FLOAT16, 2, shape, NULL);
+    lehmer_initialize(LEHMER_SEED);
+    tensor_fill(&a);
+
+    // Contiguous both sides: one convert_rows() call.
+    failures += !tensor_convert(pool, &a, &h);
+    for (size_t i = 0; i < tensor_count(&a); i++) {
+        uint16_t expected = quantize_scalar_fp16(((float*) a.data)[i]);
+        failures += expected != ((uint16_t*) h.data)[i];
+    }
+
+    // Transposed input lands transposed in a contiguous output.
+    Tensor at;
+    tensor_transpose(&h, 0, 1, &at);
+    size_t tshape[2] = {1500, 37};
+    tensor_create(&back, TYPE_FLOAT32, 2, tshape, NULL);
+    failures += !tensor_convert(pool, &at, &back);
+    for (size_t i = 0; i < 1500; i++) {
+        for (size_t j = 0; j < 37; j++) {
+            uint16_t bits = ((uint16_t*) h.data)[j * 1500 + i];
+            failures += dequantize_scalar_fp16(bits) != tensor_get(&back, i, j);
+        }
+    }
+
+    // A broadcast row fills every row of the output.
+    Tensor row, wide, filled;
+    tensor_slice(&a, 0, 4, 5, 1, &row);
+    tensor_broadcast(&row, 2, shape, &wide);
+    tensor_create(&filled, TYPE_FLOAT32, 2, shape, NULL);
+    failures += !tensor_convert(NULL, &wide, &filled);
+    for (size_t i = 0; i < 37; i++) {
+        failures += 0 != memcmp(
+            (float*) filled.data + i * 1500, (float*) a.data + 4 * 1500, 1500 * sizeof(float)
+        );
+    }
+    failures += tensor_convert(NULL, &a, &back);
+
+    tensor_free(&a);
+    tensor_free(&filled);
+    tensor_free(&h);
+    tensor_free(&back);
+    thread_pool_free(pool);
+
+    ASSERT(0 == failures, "[TestTensorConvert] failures=%zu", failures);
+    return 0;
+}
+
+int test_tensor_activate(void) {
+    size_t shape[2] = {9, 2100};
+    size_t failures = 0;
+
+    Tensor a, out;
+    tensor_create(&a, TYPE_FLOAT32, 2, shape, NULL);
+    tensor_create(&out, TYPE_FLOAT32, 2, shape, NULL);
+    lehmer_initialize(LEHMER_SEED);
+    tensor_fill(&a);
+
+    // Every other column, written into every other column.
+    Tensor in_view, out_view;
+    tensor_slice(&a, 1, 0, 2100, 2, &in_view);
+    tensor_slice(&out, 1, 1, 2100, 2, &out_view);
+    failures += !tensor_activate(ACTIVATION_SILU, &in_view, &out_view);
+
+    float* expected = malloc(1050 * sizeof(float));
+    float* gathered = malloc(1050 * sizeof(float));
+    for (size_t i = 0; i < 9; i++) {
+        for (size_t j = 0; j < 1050; j++) {
+            gathered[j] = tensor_get(&a, i, 2 * j);
+        }
+        activate_row(ACTIVATION_SILU, gathered, expected, 1050);
+        for (size_t j = 0; j < 1050; j++) {
+            failures += expected[j] != tensor_get(&out, i, 2 * j + 1);
+            failures += 0.0f != tensor_get(&out, i, 2 * j);
+        }
+    }
+    failures += tensor_activate(ACTIVATION_SILU, &a, &in_view);
+
+    // Softmax over transposed rows matches softmax over the packed columns.
+    Tensor column, result;
+    tensor_transpose(&a, 0, 1, &column);
+    tensor_create(&result, TYPE_FLOAT32, 2, (size_t[]) {2100, 9}, NULL);
+    failures += !tensor_softmax(NULL, &column, &result, 0.5f);
+    for (size_t j = 0; j < 2100; j += 97) {
+        for (size_t i = 0; i < 9; i++) {
+            gathered[i] = tensor_get(&a, i, j);
+        }
+        activate_softmax_temperature(gathered, expected, 9, 0.5f);
+        for (size_t i = 0; i < 9; i++) {
+            failures += fabsf(expected[i] - tensor_get(&result, j, i)) > 1e-6f;
+        }
+    }
+    failures += tensor_softmax(NULL, &a, &result, 1.0f);
+
+    // Across a pool each thread gathers into its own row buffer; rows match the serial run.
+    ThreadPool* pool = thread_pool_create(3);
+    Tensor pooled;
+    tensor_create(&pooled, TYPE_FLOAT32, 2, (size_t[]) {2100, 9}, NULL);
+    failures += !tensor_softmax(pool, &column, &pooled, 0.5f);
+    failures += 0 != memcmp(result.data, pooled.data, 2100 * 9 * sizeof(float));
+    tensor_free(&pooled);
+    thread_pool_free(pool);
+
+    free(expected);
+    free(gathered);
+    tensor_free(&a);
+    tensor_free(&out);
+    tensor_free(&result);
+
+    ASSERT(0 == failures, "[TestTensorActivate] failures=%zu", failures);
+    return 0;
+}
+
+int test_tensor_matrix(void) {
+    ThreadPool* pool = thread_pool_create(3);
+    size_t m = 23, n = 41, k = 67;
+    size_t failures = 0;
+
+    // C = A · Bᵀ with B stored as n x k.
+    Tensor a, b, c, bt;
+    tensor_create(&a, TYPE_FLOAT32, 2, (size_t[]) {m, k}, NULL);
+    tensor_create(&b, TYPE_FLOAT32, 2, (size_t[]) {n, k}, NULL);
+    tensor_create(&c, TYPE_FLOAT32, 2, (size_t[]) {m, n}, NULL);
+    lehmer_initialize(LEHMER_SEED);
+    tensor_fill(&a);
+    tensor_fill(&b);
+    tensor_transpose(&b, 0, 1, &bt);
+
+    failures += !tensor_gemm(pool, &a, &bt, &c);
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            double sum = 0.0, magnitude = 0.0;
+            for (size_t p = 0; p < k; p++) {
+                double v = (double) tensor_get(&a, i, p) * (double) tensor_get(&b, j, p);
+                sum += v;
+                magnitude += fabs(v);
+            }
+            double tolerance = 2.0 * (double) k * 0x1.0p-24 * magnitude;
+            failures += fabs((double) tensor_get(&c, i, j) - sum) > tolerance;
+        }
+    }
+
+    Tensor ct;
+    tensor_transpose(&c, 0, 1, &ct);
+    failures += tensor_gemm(pool, &a, &bt, &ct) || tensor_gemm(pool, &a, &b, &c);
+
+    // y = W · x with Q8 weights and x read from a column of A.
+    Tensor w, x, y;
+    tensor_create(&w, TYPE_BLOCK_Q8, 2, (size_t[]) {n, m}, NULL);
+    tensor_create(&y, TYPE_FLOAT32, 1, (size_t[]) {n}, NULL);
+    tensor_convert(NULL, &ct, &w);
+    tensor_slice(&a, 1, 3, 4, 1, &x);
+    tensor_reshape(&x, 1, (size_t[]) {m}, &x);
+    failures += 1 == x.stride[0];
+    failures += !tensor_gemv(pool, &w, &x, &y);
+
+    float* column = malloc(m * sizeof(float));
+    float* expected = malloc(n * sizeof(float));
+    for (size_t i = 0; i < m; i++) {
+        column[i] = tensor_get(&a, i, 3);
+    }
+    matrix_gemv(NULL, TYPE_BLOCK_Q8, w.data, n, m, column, expected);
+    failures += 0 != memcmp(expected, y.data, n * sizeof(float));
+
+    Tensor ws;
+    tensor_slice(&w, 0, 0, n, 2, &ws);
+    failures += tensor_gemv(pool, &ws, &x, &y);
+
+    free(column);
+    free(expected);
+    tensor_free(&a);
+    tensor_free(&b);
+    tensor_free(&c);
+    tensor_free(&w);
+    tensor_free(&y);
+    thread_pool_free(pool);
+
+    ASSERT(0 == failures, "[TestTensorMatrix] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"tensor_create", test_tensor_create},
+        {"tensor_views", test_tensor_views},
+        {"tensor_convert", test_tensor_convert},
+        {"tensor_activate", test_tensor_activate},
+        {"tensor_matrix", test_tensor_matrix},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
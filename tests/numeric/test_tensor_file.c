@@ -0,0 +1,208 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_tensor_file.c
+ */
+
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+#include "numeric/tensor.h"
+#include "numeric/tensor_file.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TENSOR_FILE_PATH "test_tensor_file.bin"
+
+static void tensor_file_fill(void* data, size_t bytes) {
+    uint8_t* out = data;
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (uint8_t) lehmer_generate_int32();
+    }
+}
+
+// Overwrites `size` bytes at `offset` of the test file.
+static bool tensor_file_patch(long offset, const void* bytes, size_t size) {
+    FILE* file = fopen(TENSOR_FILE_PATH, "r+b");
+    if (!file) {
+        return false;
+    }
+    bool ok = 0 == fseek(file, offset, SEEK_SET) && 1 == fwrite(bytes, size, 1, file);
+    return 0 == fclose(file) && ok;
+}
+
+/**
+ * @name Round Trip
+ * {@
+ */
+
+int test_tensor_file_roundtrip(void) {
+    size_t failures = 0;
+    lehmer_initialize(LEHMER_SEED);
+
+    Tensor weights, blocks, matrix, scalar, empty;
+    tensor_create(&weights, TYPE_FLOAT32, 3, (size_t[]) {2, 3, 5}, NULL);
+    tensor_create(&blocks, TYPE_BLOCK_Q8, 2, (size_t[]) {3, BLOCK_SIZE + 7}, NULL);
+    tensor_create(&matrix, TYPE_FLOAT16, 2, (size_t[]) {7, 9}, NULL);
+    tensor_create(&scalar, TYPE_INT32, 0, NULL, NULL);
+    tensor_create(&empty, TYPE_INT8, 2, (size_t[]) {0, 5}, NULL);
+    tensor_file_fill(weights.data, 30 * sizeof(float));
+    tensor_file_fill(blocks.data, 3 * data_type_row_size(TYPE_BLOCK_Q8, BLOCK_SIZE + 7));
+    tensor_file_fill(matrix.data, 63 * sizeof(uint16_t));
+    *(int32_t*) scalar.data = -17;
+
+    // The transposed view is written packed.
+    Tensor transposed;
+    tensor_transpose(&matrix, 0, 1, &transposed);
+
+    TensorFileItem items[] = {
+        {"weights", &weights},
+        {"blocks", &blocks},
+        {"transposed", &transposed},
+        {"scalar", &scalar},
+        {"empty", &empty},
+    };
+    size_t count = sizeof(items) / sizeof(TensorFileItem);
+    failures += TENSOR_FILE_SUCCESS != tensor_file_write(TENSOR_FILE_PATH, items, count);
+
+    TensorFile file;
+    TensorFileState state = tensor_file_open(&file, TENSOR_FILE_PATH, TENSOR_FILE_ADVICE_WILLNEED);
+    ASSERT(TENSOR_FILE_SUCCESS == state, "[TestTensorFileRoundTrip] open failed (%d)", state);
+    failures += count != tensor_file_count(&file);
+
+    for (size_t i = 0; i < count; i++) {
+        const char* name = tensor_file_name(&file, i);
+        failures += NULL == name || 0 != strcmp(name, items[i].name);
+
+        Tensor t;
+        failures += !tensor_file_get(&file, i, &t) || t.type != items[i].tensor->type;
+        failures += 0 != (uintptr_t) t.data % TENSOR_ALIGNMENT;
+        failures += t.rank != items[i].tensor->rank || !tensor_is_contiguous(&t);
+        for (size_t j = 0; j < t.rank; j++) {
+            failures += t.shape[j] != items[i].tensor->shape[j];
+        }
+        failures += NULL != t.storage;
+        tensor_file_prefetch(&file, &t);
+    }
+
+    Tensor t;
+    failures += !tensor_file_find(&file, "weights", &t);
+    failures += 0 != memcmp(t.data, weights.data, 30 * sizeof(float));
+    failures += !tensor_file_find(&file, "blocks", &t);
+    size_t block_bytes = 3 * data_type_row_size(TYPE_BLOCK_Q8, BLOCK_SIZE + 7);
+    failures += 0 != memcmp(t.data, blocks.data, block_bytes);
+    failures += !tensor_file_find(&file, "scalar", &t) || -17 != *(int32_t*) t.data;
+    failures += !tensor_file_find(&file, "empty", &t) || 0 != tensor_count(&t);
+
+    failures += !tensor_file_find(&file, "transposed", &t);
+    for (size_t i = 0; i < 9; i++) {
+        for (size_t j = 0; j < 7; j++) {
+            size_t index[2] = {i, j};
+            uint16_t got = *(uint16_t*) tensor_at(&t, index);
+            failures += got != ((uint16_t*) matrix.data)[j * 9 + i];
+        }
+    }
+
+    failures += tensor_file_find(&file, "missing", &t) || NULL != tensor_file_name(&file, count);
+
+    tensor_file_close(&file);
+    failures += NULL != file.map;
+
+    tensor_free(&weights);
+    tensor_free(&blocks);
+    tensor_free(&matrix);
+    tensor_free(&scalar);
+    tensor_free(&empty);
+    remove(TENSOR_FILE_PATH);
+
+    ASSERT(0 == failures, "[TestTensorFileRoundTrip] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Validation
+ * {@
+ */
+
+int test_tensor_file_validation(void) {
+    size_t failures = 0;
+
+    float values[12] = {0};
+    Tensor a = tensor_wrap(values, TYPE_FLOAT32, 2, (size_t[]) {3, 4});
+    TensorFileItem items[] = {{"a", &a}, {"b", &a}};
+
+    char long_name[TENSOR_FILE_NAME_MAX + 1];
+    memset(long_name, 'x', TENSOR_FILE_NAME_MAX);
+    long_name[TENSOR_FILE_NAME_MAX] = '\0';
+    TensorFileItem bad = {long_name, &a};
+    failures += TENSOR_FILE_ERROR_ARGUMENT != tensor_file_write(TENSOR_FILE_PATH, &bad, 1);
+
+    TensorFile file;
+    failures += TENSOR_FILE_ERROR_IO
+                != tensor_file_open(&file, "missing_tensor_file.bin", TENSOR_FILE_ADVICE_NORMAL);
+
+    // A malformed entry only fails when it is looked up.
+    tensor_file_write(TENSOR_FILE_PATH, items, 2);
+    uint64_t offset = 8;
+    size_t entry = sizeof(TensorFileHeader) + sizeof(TensorFileEntry);
+    tensor_file_patch((long) (entry + offsetof(TensorFileEntry, offset)), &offset, 8);
+    failures += TENSOR_FILE_SUCCESS
+                != tensor_file_open(&file, TENSOR_FILE_PATH, TENSOR_FILE_ADVICE_SEQUENTIAL);
+    Tensor t;
+    failures += !tensor_file_get(&file, 0, &t) || tensor_file_get(&file, 1, &t);
+    tensor_file_close(&file);
+
+    // Entries whose size disagrees with their shape are rejected too.
+    tensor_file_write(TENSOR_FILE_PATH, items, 2);
+    uint64_t shape = 5;
+    tensor_file_patch((long) (entry + offsetof(TensorFileEntry, shape)), &shape, 8);
+    tensor_file_open(&file, TENSOR_FILE_PATH, TENSOR_FILE_ADVICE_NORMAL);
+    failures += tensor_file_find(&file, "b", &t) || !tensor_file_find(&file, "a", &t);
+    tensor_file_close(&file);
+
+    // Header problems fail at open.
+    tensor_file_write(TENSOR_FILE_PATH, items, 2);
+    uint32_t magic = 0x12345678;
+    tensor_file_patch(0, &magic, 4);
+    failures += TENSOR_FILE_ERROR_FORMAT
+                != tensor_file_open(&file, TENSOR_FILE_PATH, TENSOR_FILE_ADVICE_NORMAL);
+
+    tensor_file_write(TENSOR_FILE_PATH, items, 2);
+    uint64_t count = 1000;
+    tensor_file_patch(offsetof(TensorFileHeader, count), &count, 8);
+    failures += TENSOR_FILE_ERROR_FORMAT
+                != tensor_file_open(&file, TENSOR_FILE_PATH, TENSOR_FILE_ADVICE_NORMAL);
+
+    FILE* stub = fopen(TENSOR_FILE_PATH, "wb");
+    fclose(stub);
+    failures += TENSOR_FILE_ERROR_FORMAT
+                != tensor_file_open(&file, TENSOR_FILE_PATH, TENSOR_FILE_ADVICE_NORMAL);
+
+    remove(TENSOR_FILE_PATH);
+
+    ASSERT(0 == failures, "[TestTensorFileValidation] failures=%zu", failures);
+    return 0;
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"tensor_file_roundtrip", test_tensor_file_roundtrip},
+        {"tensor_file_validation", test_tensor_file_validation},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,653 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/numeric/test_type.c
+ */
+
+#include "core/cpu.h"
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/convert.h"
+#include "numeric/lehmer.h"
+#include "numeric/type.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Not a multiple of any vector width, so every kernel also runs its scalar tail.
+#define TYPE_RANDOM_COUNT 1000003
+
+typedef struct TestTypeRow {
+    float* input; // fp32 values
+    uint16_t* halves; // every 16-bit pattern
+    size_t count;
+} TestTypeRow;
+
+static float type_float(uint32_t bits) {
+    return decode_scalar_fp32(bits);
+}
+
+static uint32_t type_random_bits(void) {
+    return (uint32_t) lehmer_generate_int32() ^ ((uint32_t) lehmer_generate_int32() << 16);
+}
+
+/**
+ * Rounding boundaries of both 16-bit formats: each representable value, its fp32 neighbours,
+ * and the exact midpoint to the next value with its neighbours; then NaN payloads, signed
+ * zeros, fp32 subnormals and random bit patterns.
+ */
+static TestTypeRow type_row_generate(void) {
+    TestTypeRow row = {0};
+    size_t capacity = 65536 * 12 + TYPE_RANDOM_COUNT + 64;
+    row.input = malloc(capacity * sizeof(float));
+    row.halves = malloc(65536 * sizeof(uint16_t));
+
+    for (uint32_t h = 0; h < 65536; h++) {
+        row.halves[h] = (uint16_t) h;
+
+        uint32_t fp16 = encode_scalar_fp32(dequantize_scalar_fp16((uint16_t) h));
+        uint32_t bf16 = h << 16;
+        uint32_t fp16_mid = fp16 + (1u << 12); // half an fp16 ulp (normal range)
+        uint32_t bf16_mid = bf16 + (1u << 15); // half a bf16 ulp
+
+        uint32_t anchors[] = {fp16, bf16, fp16_mid, bf16_mid};
+        for (size_t a = 0; a < 4; a++) {
+            row.input[row.count++] = type_float(anchors[a] - 1);
+            row.input[row.count++] = type_float(anchors[a]);
+            row.input[row.count++] = type_float(anchors[a] + 1);
+        }
+    }
+
+    uint32_t specials[] = {
+        0x00000000, 0x80000000, 0x00000001, 0x807FFFFF, 0x7F800000, 0xFF800000, 0x7F800001,
+        0x7FBFFFFF, 0x7FC00000, 0xFFC00001, 0x7FFFFFFF, 0x477FF000, 0x477FEFFF, 0x33000000,
+        0x33000001, 0x7F7FFFFF, 0x7F7F8000, 0xFF7F8000,
+    };
+    for (size_t i = 0; i < sizeof(specials) / sizeof(specials[0]); i++) {
+        row.input[row.count++] = type_float(specials[i]);
+    }
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < TYPE_RANDOM_COUNT; i++) {
+        row.input[row.count++] = type_float(type_random_bits());
+    }
+
+    return row;
+}
+
+static void type_row_release(TestTypeRow* row) {
+    free(row->input);
+    free(row->halves);
+}
+
+static bool type_same_bits(const float* a, const float* b, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (encode_scalar_fp32(a[i]) != encode_scalar_fp32(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const CpuLevel type_levels[] = {
+    CPU_LEVEL_SCALAR,
+    CPU_LEVEL_SSE2,
+    CPU_LEVEL_AVX2,
+    CPU_LEVEL_AVX512,
+};
+
+#define TYPE_LEVEL_COUNT (sizeof(type_levels) / sizeof(CpuLevel))
+
+/**
+ * @name Scalar Reference
+ * {@
+ */
+
+int test_type_scalar_fp16(void) {
+    // Smallest and largest subnormal, smallest normal.
+    ASSERT(
+        dequantize_scalar_fp16(0x0001) == 0x1.0p-24f && dequantize_scalar_fp16(0x03FF) == 0x1.FF8p-15f
+            && dequantize_scalar_fp16(0x0400) == 0x1.0p-14f,
+        "[TestTypeScalarFp16] subnormal decoding"
+    );
+
+    // Every non-NaN half survives a round trip.
+    for (uint32_t h = 0; h < 65536; h++) {
+        if ((h & 0x7C00) == 0x7C00 && (h & 0x03FF)) {
+            continue;
+        }
+        uint16_t back = quantize_scalar_fp16(dequantize_scalar_fp16((uint16_t) h));
+        ASSERT(back == h, "[TestTypeScalarFp16] half=0x%04x, round trip=0x%04x", h, back);
+    }
+
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Row Kernels
+ * {@
+ */
+
+int test_group_type_row(TestUnit* unit) {
+    CpuLevel level = *(const CpuLevel*) unit->data;
+    if (level > cpu_level_detected()) {
+        LOG_INFO("[TestTypeRow] level=%s not supported, skipped", cpu_level_name(level));
+        return 0;
+    }
+
+    TestTypeRow row = type_row_generate();
+    uint16_t* expected = malloc(row.count * sizeof(uint16_t));
+    uint16_t* got = malloc(row.count * sizeof(uint16_t));
+    float* expected_float = malloc(65536 * sizeof(float));
+    float* got_float = malloc(65536 * sizeof(float));
+
+    cpu_level_set(level);
+
+    // Offset by one element so vector loads and stores are misaligned.
+    size_t n = row.count - 1;
+    size_t mismatches[4] = {0};
+
+    for (size_t i = 0; i < n; i++) {
+        expected[i] = quantize_scalar_fp16(row.input[i + 1]);
+    }
+    quantize_row_fp16(row.input + 1, got, n);
+    for (size_t i = 0; i < n; i++) {
+        mismatches[0] += expected[i] != got[i];
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        expected[i] = quantize_scalar_bf16(row.input[i + 1]);
+    }
+    quantize_row_bf16(row.input + 1, got, n);
+    for (size_t i = 0; i < n; i++) {
+        mismatches[1] += expected[i] != got[i];
+    }
+
+    for (size_t i = 0; i < 65535; i++) {
+        expected_float[i] = dequantize_scalar_fp16(row.halves[i + 1]);
+    }
+    dequantize_row_fp16(row.halves + 1, got_float, 65535);
+    mismatches[2] = !type_same_bits(expected_float, got_float, 65535);
+
+    for (size_t i = 0; i < 65535; i++) {
+        expected_float[i] = dequantize_scalar_bf16(row.halves[i + 1]);
+    }
+    dequantize_row_bf16(row.halves + 1, got_float, 65535);
+    mismatches[3] = !type_same_bits(expected_float, got_float, 65535);
+
+    cpu_level_set(cpu_level_detected());
+
+    free(expected);
+    free(got);
+    free(expected_float);
+    free(got_float);
+    type_row_release(&row);
+
+    ASSERT(
+        0 == mismatches[0] + mismatches[1] + mismatches[2] + mismatches[3],
+        "[TestTypeRow] level=%s, fp16=%zu, bf16=%zu, fp16 decode=%zu, bf16 decode=%zu",
+        cpu_level_name(level),
+        mismatches[0],
+        mismatches[1],
+        mismatches[2],
+        mismatches[3]
+    );
+
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Block Quantization
+ * {@
+ */
+
+// Not a multiple of BLOCK_SIZE, so the padded tail block is exercised too.
+#define TYPE_BLOCK_LENGTH (BLOCK_SIZE * 4096 + 7)
+
+// Blocks of varying magnitude, plus all-zero, one-hot and constant blocks.
+static float* type_block_generate(void) {
+    float* input = malloc(TYPE_BLOCK_LENGTH * sizeof(float));
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t b = 0; b * BLOCK_SIZE < TYPE_BLOCK_LENGTH; b++) {
+        float magnitude = ldexpf(1.0f, (int) (lehmer_generate_int32() % 21) - 10);
+        for (size_t i = b * BLOCK_SIZE; i < (b + 1) * BLOCK_SIZE && i < TYPE_BLOCK_LENGTH; i++) {
+            float x = (lehmer_generate_float() - 0.5f) * 2.0f * magnitude;
+            switch (b % 16) {
+                case 1:
+                    x = 0.0f;
+                    break;
+                case 2:
+                    x = i % BLOCK_SIZE == 5 ? -magnitude : 0.0f;
+                    break;
+                case 3:
+                    x = magnitude;
+                    break;
+                default:
+                    break;
+            }
+            input[i] = x;
+        }
+    }
+    return input;
+}
+
+int test_group_type_block(TestUnit* unit) {
+    CpuLevel level = *(const CpuLevel*) unit->data;
+    if (level > cpu_level_detected()) {
+        LOG_INFO("[TestTypeBlock] level=%s not supported, skipped", cpu_level_name(level));
+        return 0;
+    }
+
+    size_t blocks = (TYPE_BLOCK_LENGTH + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    float* input = type_block_generate();
+    BlockQ8* q8[2] = {malloc(blocks * sizeof(BlockQ8)), malloc(blocks * sizeof(BlockQ8))};
+    BlockQ4* q4[2] = {malloc(blocks * sizeof(BlockQ4)), malloc(blocks * sizeof(BlockQ4))};
+    float* output[2] = {
+        malloc(TYPE_BLOCK_LENGTH * sizeof(float)), malloc(TYPE_BLOCK_LENGTH * sizeof(float))
+    };
+
+    // Index 0 holds the scalar reference, index 1 the kernels under test.
+    size_t mismatches[4] = {0};
+    for (size_t k = 0; k < 2; k++) {
+        cpu_level_set(0 == k ? CPU_LEVEL_SCALAR : level);
+        quantize_row_block_q8(input, q8[k], TYPE_BLOCK_LENGTH);
+        quantize_row_block_q4(input, q4[k], TYPE_BLOCK_LENGTH);
+    }
+    mismatches[0] = 0 != memcmp(q8[0], q8[1], blocks * sizeof(BlockQ8));
+    mismatches[1] = 0 != memcmp(q4[0], q4[1], blocks * sizeof(BlockQ4));
+
+    for (size_t k = 0; k < 2; k++) {
+        cpu_level_set(0 == k ? CPU_LEVEL_SCALAR : level);
+        dequantize_row_block_q8(q8[0], output[k], TYPE_BLOCK_LENGTH);
+    }
+    mismatches[2] = !type_same_bits(output[0], output[1], TYPE_BLOCK_LENGTH);
+
+    for (size_t k = 0; k < 2; k++) {
+        cpu_level_set(0 == k ? CPU_LEVEL_SCALAR : level);
+        dequantize_row_block_q4(q4[0], output[k], TYPE_BLOCK_LENGTH);
+    }
+    mismatches[3] = !type_same_bits(output[0], output[1], TYPE_BLOCK_LENGTH);
+
+    cpu_level_set(cpu_level_detected());
+
+    free(input);
+    for (size_t k = 0; k < 2; k++) {
+        free(q8[k]);
+        free(q4[k]);
+        free(output[k]);
+    }
+
+    ASSERT(
+        0 == mismatches[0] + mismatches[1] + mismatches[2] + mismatches[3],
+        "[TestTypeBlock] level=%s, q8=%zu, q4=%zu, q8 decode=%zu, q4 decode=%zu",
+        cpu_level_name(level),
+        mismatches[0],
+        mismatches[1],
+        mismatches[2],
+        mismatches[3]
+    );
+
+    return 0;
+}
+
+int test_type_block_error(void) {
+    float* input = type_block_generate();
+    float* output = malloc(TYPE_BLOCK_LENGTH * sizeof(float));
+    size_t blocks = (TYPE_BLOCK_LENGTH + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    BlockQ8* q8 = malloc(blocks * sizeof(BlockQ8));
+    BlockQ4* q4 = malloc(blocks * sizeof(BlockQ4));
+
+    // Per-element bounds: half a step for Q8; for Q4 the element opposite the extreme clamps to
+    // 7 steps instead of 8. Both allow for the scale's fp16 rounding, which is absolute (2^-25)
+    // once the scale falls into the fp16 subnormal range.
+    quantize_row_block_q8(input, q8, TYPE_BLOCK_LENGTH);
+    dequantize_row_block_q8(q8, output, TYPE_BLOCK_LENGTH);
+    size_t q8_violations = 0;
+    for (size_t i = 0; i < TYPE_BLOCK_LENGTH; i++) {
+        size_t b = i / BLOCK_SIZE;
+        float amax = 0.0f;
+        for (size_t j = b * BLOCK_SIZE; j < (b + 1) * BLOCK_SIZE && j < TYPE_BLOCK_LENGTH; j++) {
+            amax = fmaxf(amax, fabsf(input[j]));
+        }
+        q8_violations += fabsf(output[i] - input[i]) > amax / 254.0f + amax * 0x1.0p-10f + 127.0f * 0x1.0p-25f;
+    }
+
+    quantize_row_block_q4(input, q4, TYPE_BLOCK_LENGTH);
+    dequantize_row_block_q4(q4, output, TYPE_BLOCK_LENGTH);
+    size_t q4_violations = 0;
+    for (size_t i = 0; i < TYPE_BLOCK_LENGTH; i++) {
+        size_t b = i / BLOCK_SIZE;
+        float amax = 0.0f;
+        for (size_t j = b * BLOCK_SIZE; j < (b + 1) * BLOCK_SIZE && j < TYPE_BLOCK_LENGTH; j++) {
+            amax = fmaxf(amax, fabsf(input[j]));
+        }
+        q4_violations += fabsf(output[i] - input[i]) > amax / 8.0f + amax * 0x1.0p-8f + 8.0f * 0x1.0p-25f;
+    }
+
+    QuantizeError e8 = {0};
+    QuantizeError e4 = {0};
+    bool ok = quantize_row_error(input, TYPE_BLOCK_LENGTH, TYPE_BLOCK_Q8, &e8)
+              && quantize_row_error(input, TYPE_BLOCK_LENGTH, TYPE_BLOCK_Q4, &e4);
+
+    free(input);
+    free(output);
+    free(q8);
+    free(q4);
+
+    ASSERT(
+        ok && 0 == q8_violations && 0 == q4_violations && e8.bytes == blocks * 34
+            && e4.bytes == blocks * 18 && e8.relative_rmse < 0.01 && e4.relative_rmse < 0.15,
+        "[TestTypeBlockError] q8: violations=%zu, rel_rmse=%g, bytes=%zu; "
+        "q4: violations=%zu, rel_rmse=%g, bytes=%zu",
+        q8_violations,
+        e8.relative_rmse,
+        e8.bytes,
+        q4_violations,
+        e4.relative_rmse,
+        e4.bytes
+    );
+
+    LOG_INFO(
+        "[TestTypeBlockError] q8 rel_rmse=%g (%.2fx smaller than fp32), q4 rel_rmse=%g (%.2fx)",
+        e8.relative_rmse,
+        (double) (TYPE_BLOCK_LENGTH * sizeof(float)) / (double) e8.bytes,
+        e4.relative_rmse,
+        (double) (TYPE_BLOCK_LENGTH * sizeof(float)) / (double) e4.bytes
+    );
+
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name 8-bit Floating-Point
+ * {@
+ */
+
+typedef struct TypeFp8Spec {
+    const char* name;
+    int mantissa;
+    int bias;
+    uint8_t max; // largest finite code
+    uint8_t inf; // code for infinity
+    uint8_t nan; // code for NaN
+    uint8_t (*quantize)(float);
+    float (*dequantize)(uint8_t);
+} TypeFp8Spec;
+
+static const TypeFp8Spec type_fp8_specs[] = {
+    {"e4m3", 3, 7, 0x7E, 0x7E, 0x7F, quantize_scalar_e4m3, dequantize_scalar_e4m3},
+    {"e5m2", 2, 15, 0x7B, 0x7C, 0x7E, quantize_scalar_e5m2, dequantize_scalar_e5m2},
+};
+
+#define TYPE_FP8_COUNT (sizeof(type_fp8_specs) / sizeof(TypeFp8Spec))
+
+// Independent of the library: the value of a finite code from its fields.
+static double type_fp8_value(const TypeFp8Spec* spec, uint32_t code) {
+    int exponent = (int) (code & 0x7F) >> spec->mantissa;
+    int mantissa = (int) code & ((1 << spec->mantissa) - 1);
+    double value = exponent ? ldexp(1.0 + ldexp(mantissa, -spec->mantissa), exponent - spec->bias)
+                            : ldexp(mantissa, 1 - spec->bias - spec->mantissa);
+    return code & 0x80 ? -value : value;
+}
+
+// Codes above infinity (or above the largest finite code, when there is no infinity) are NaN.
+static bool type_fp8_is_nan(const TypeFp8Spec* spec, uint32_t code) {
+    return (code & 0x7F) > spec->inf;
+}
+
+// Round to nearest even over the finite codes by bisection, then saturate.
+static uint8_t type_fp8_expected(const TypeFp8Spec* spec, float x) {
+    uint8_t sign = signbit(x) ? 0x80 : 0;
+    if (isnan(x)) {
+        return sign | spec->nan;
+    }
+    if (isinf(x)) {
+        return sign | spec->inf;
+    }
+
+    double a = fabs((double) x);
+    uint32_t lo = 0;
+    uint32_t hi = spec->max;
+    while (lo < hi) { // largest code whose value is at most a
+        uint32_t mid = (lo + hi + 1) / 2;
+        if (type_fp8_value(spec, mid) <= a) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (lo == spec->max) {
+        return sign | spec->max;
+    }
+
+    double midpoint = (type_fp8_value(spec, lo) + type_fp8_value(spec, lo + 1)) / 2.0;
+    uint32_t code = a < midpoint ? lo : (a > midpoint ? lo + 1 : lo + (lo & 1));
+    return (uint8_t) (sign | code);
+}
+
+int test_type_scalar_fp8(void) {
+    TestTypeRow row = type_row_generate();
+
+    for (size_t s = 0; s < TYPE_FP8_COUNT; s++) {
+        const TypeFp8Spec* spec = &type_fp8_specs[s];
+
+        // Every code decodes to its value and every non-NaN code survives a round trip.
+        for (uint32_t code = 0; code < 256; code++) {
+            float value = spec->dequantize((uint8_t) code);
+            if (type_fp8_is_nan(spec, code)) {
+                ASSERT(isnan(value), "[TestTypeScalarFp8] %s: 0x%02x is not NaN", spec->name, code);
+                continue;
+            }
+            double expected = (code & 0x7F) == spec->inf && spec->inf != spec->max
+                                  ? (code & 0x80 ? -HUGE_VAL : HUGE_VAL)
+                                  : type_fp8_value(spec, code);
+            uint8_t back = spec->quantize(value);
+            ASSERT(
+                (double) value == expected && back == code,
+                "[TestTypeScalarFp8] %s: code=0x%02x, value=%a, round trip=0x%02x",
+                spec->name,
+                code,
+                (double) value,
+                back
+            );
+        }
+
+        // Rounding boundaries of every code, then the 16-bit boundaries and random bits.
+        size_t failures = 0;
+        for (uint32_t code = 0; code < spec->max; code++) {
+            float mid = (float) ((type_fp8_value(spec, code) + type_fp8_value(spec, code + 1)) / 2);
+            uint32_t bits = encode_scalar_fp32(mid);
+            for (uint32_t b = bits - 1; b <= bits + 1; b++) {
+                float x = type_float(b);
+                failures += spec->quantize(x) != type_fp8_expected(spec, x);
+                failures += spec->quantize(-x) != type_fp8_expected(spec, -x);
+            }
+        }
+        for (size_t i = 0; i < row.count; i++) {
+            failures += spec->quantize(row.input[i]) != type_fp8_expected(spec, row.input[i]);
+        }
+        ASSERT(0 == failures, "[TestTypeScalarFp8] %s: %zu encodings", spec->name, failures);
+    }
+
+    // Saturation, and E5M2 as the top byte of an fp16.
+    ASSERT(
+        0x7E == quantize_scalar_e4m3(1.0e6f) && 0xFE == quantize_scalar_e4m3(-INFINITY)
+            && 0x7B == quantize_scalar_e5m2(65504.0f) && 0xFC == quantize_scalar_e5m2(-INFINITY)
+            && 0xFF == quantize_scalar_e4m3(-NAN) && 0x7E == quantize_scalar_e5m2(NAN),
+        "[TestTypeScalarFp8] saturation"
+    );
+    for (uint32_t code = 0; code < 256; code++) {
+        if (!type_fp8_is_nan(&type_fp8_specs[1], code)) {
+            float half = dequantize_scalar_fp16((uint16_t) (code << 8));
+            ASSERT(
+                half == dequantize_scalar_e5m2((uint8_t) code),
+                "[TestTypeScalarFp8] e5m2 0x%02x differs from fp16",
+                code
+            );
+        }
+    }
+
+    type_row_release(&row);
+    return 0;
+}
+
+int test_group_type_fp8(TestUnit* unit) {
+    CpuLevel level = *(const CpuLevel*) unit->data;
+    if (level > cpu_level_detected()) {
+        LOG_INFO("[TestTypeFp8] level=%s not supported, skipped", cpu_level_name(level));
+        return 0;
+    }
+
+    TestTypeRow row = type_row_generate();
+    size_t n = row.count - 1;
+    uint8_t* bytes = malloc(n + 1);
+    uint8_t* got = malloc(n);
+    float* expected_float = malloc(n * sizeof(float));
+    float* got_float = malloc(n * sizeof(float));
+    uint16_t* halves = malloc(65536 * sizeof(uint16_t));
+    for (size_t i = 0; i < n + 1; i++) {
+        bytes[i] = (uint8_t) i;
+    }
+    const float scale = 0.375f; // not a power of two, so 1 / scale rounds
+
+    cpu_level_set(level);
+
+    // Offset by one element so vector loads and stores are misaligned.
+    size_t mismatches[4] = {0};
+    for (size_t s = 0; s < TYPE_FP8_COUNT; s++) {
+        const TypeFp8Spec* spec = &type_fp8_specs[s];
+        bool e4m3 = 0 == s;
+
+        (e4m3 ? quantize_row_e4m3 : quantize_row_e5m2)(row.input + 1, got, n);
+        for (size_t i = 0; i < n; i++) {
+            mismatches[0] += spec->quantize(row.input[i + 1]) != got[i];
+        }
+
+        (e4m3 ? dequantize_row_e4m3 : dequantize_row_e5m2)(bytes + 1, got_float, n);
+        for (size_t i = 0; i < n; i++) {
+            expected_float[i] = spec->dequantize(bytes[i + 1]);
+        }
+        mismatches[1] += !type_same_bits(expected_float, got_float, n);
+
+        (e4m3 ? quantize_row_e4m3_scaled : quantize_row_e5m2_scaled)(row.input + 1, got, n, scale);
+        for (size_t i = 0; i < n; i++) {
+            mismatches[2] += spec->quantize(row.input[i + 1] * (1.0f / scale)) != got[i];
+        }
+        (e4m3 ? dequantize_row_e4m3_scaled : dequantize_row_e5m2_scaled)(
+            bytes + 1, got_float, n, scale
+        );
+        for (size_t i = 0; i < n; i++) {
+            expected_float[i] = spec->dequantize(bytes[i + 1]) * scale;
+        }
+        mismatches[2] += !type_same_bits(expected_float, got_float, n);
+
+        // fp16 rows encode as their values do.
+        DataTypeId type = e4m3 ? TYPE_FLOAT8_E4M3 : TYPE_FLOAT8_E5M2;
+        convert_row(row.halves, TYPE_FLOAT16, got, type, 65536);
+        for (size_t h = 0; h < 65536; h++) {
+            mismatches[3] += spec->quantize(dequantize_scalar_fp16((uint16_t) h)) != got[h];
+        }
+    }
+
+    // A scaled row spans the format: its largest magnitude lands on the largest finite code.
+    float row_scale = quantize_row_scale_e4m3(row.input + 1, 4096);
+    quantize_row_e4m3_scaled(row.input + 1, got, 4096, row_scale);
+    uint8_t top = 0;
+    for (size_t i = 0; i < 4096; i++) {
+        top = (got[i] & 0x7F) > top && (got[i] & 0x7F) != 0x7F ? got[i] & 0x7F : top;
+    }
+    mismatches[2] += 0x7E != top;
+
+    // A row of tiny values gets the smallest normal scale, whose reciprocal keeps zeros zero.
+    const float tiny[2] = {0.0f, 1e-40f};
+    uint8_t tiny_codes[2];
+    float tiny_scale = quantize_row_scale_e4m3(tiny, 2);
+    quantize_row_e4m3_scaled(tiny, tiny_codes, 2, tiny_scale);
+    mismatches[2] += FLT_MIN != tiny_scale || 0x00 != tiny_codes[0] || 0x00 == tiny_codes[1]
+                     || type_fp8_is_nan(&type_fp8_specs[0], tiny_codes[1]);
+
+    // E5M2 widens to fp16 by a shift.
+    convert_row(bytes, TYPE_FLOAT8_E5M2, halves, TYPE_FLOAT16, 256);
+    for (size_t code = 0; code < 256; code++) {
+        mismatches[3] += !type_fp8_is_nan(&type_fp8_specs[1], (uint32_t) code)
+                         && halves[code] != (uint16_t) (code << 8);
+    }
+
+    cpu_level_set(cpu_level_detected());
+
+    free(bytes);
+    free(got);
+    free(expected_float);
+    free(got_float);
+    free(halves);
+    type_row_release(&row);
+
+    ASSERT(
+        0 == mismatches[0] + mismatches[1] + mismatches[2] + mismatches[3],
+        "[TestTypeFp8] level=%s, encode=%zu, decode=%zu, scaled=%zu, fp16=%zu",
+        cpu_level_name(level),
+        mismatches[0],
+        mismatches[1],
+        mismatches[2],
+        mismatches[3]
+    );
+
+    return 0;
+}
+
+/** @} */
+
+static int type_level_suite_run(const char* name, TestUnitHook run) {
+    TestUnit units[TYPE_LEVEL_COUNT];
+    for (size_t i = 0; i < TYPE_LEVEL_COUNT; i++) {
+        units[i].data = &type_levels[i];
+    }
+
+    TestGroup group = {
+        .name = name,
+        .count = TYPE_LEVEL_COUNT,
+        .units = units,
+        .run = run,
+    };
+
+    return test_group_run(&group);
+}
+
+int test_suite_type_row(void) {
+    return type_level_suite_run("type_row", test_group_type_row);
+}
+
+int test_suite_type_block(void) {
+    return type_level_suite_run("type_block", test_group_type_block);
+}
+
+int test_suite_type_fp8(void) {
+    return type_level_suite_run("type_fp8", test_group_type_fp8);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"type_scalar_fp16", test_type_scalar_fp16},
+        {"type_row", test_suite_type_row},
+        {"type_block", test_suite_type_block},
+        {"type_block_error", test_type_block_error},
+        {"type_scalar_fp8", test_type_scalar_fp8},
+        {"type_fp8", test_suite_type_fp8},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,178 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/sort/test_external.c
+ */
+
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "sort/external.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct ExternalRecord {
+    uint32_t key;
+    uint32_t sequence;
+} ExternalRecord;
+
+static int external_record_compare(const void* a, const void* b) {
+    uint32_t ka = ((const ExternalRecord*) a)->key;
+    uint32_t kb = ((const ExternalRecord*) b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// Writes `count` records with random keys, returning false on failure.
+static bool external_write_input(const char* path, size_t count, uint32_t key_range) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < count; i++) {
+        ExternalRecord record = {
+            .key = (uint32_t) lehmer_generate_int32() % key_range,
+            .sequence = (uint32_t) i,
+        };
+        if (1 != fwrite(&record, sizeof(record), 1, file)) {
+            fclose(file);
+            return false;
+        }
+    }
+    return 0 == fclose(file);
+}
+
+/**
+ * @name External Sort File
+ * {@
+ */
+
+typedef struct TestExternalSort {
+    const char* label;
+    size_t count;
+    uint32_t key_range;
+    size_t memory_budget;
+    size_t io_buffer_size;
+    size_t fan_in;
+    bool use_mmap;
+    bool use_direct_io;
+    bool use_threads;
+} TestExternalSort;
+
+int test_group_external_sort(TestUnit* unit) {
+    TestExternalSort* data = (TestExternalSort*) unit->data;
+
+    const char* input = "test_external_input.bin";
+    const char* output = "test_external_output.bin";
+
+    ASSERT(
+        external_write_input(input, data->count, data->key_range),
+        "[TestExternalSort] unit=%zu, label=%s, failed to write input",
+        unit->index,
+        data->label
+    );
+
+    ExternalSortConfig config = external_sort_config(sizeof(ExternalRecord), external_record_compare);
+    config.memory_budget = data->memory_budget;
+    config.io_buffer_size = data->io_buffer_size;
+    config.fan_in = data->fan_in;
+    config.temp_dir = ".";
+    config.use_mmap = data->use_mmap;
+    config.use_direct_io = data->use_direct_io;
+    config.use_threads = data->use_threads;
+
+    ExternalSortState state = external_sort_file(input, output, &config);
+    ASSERT(
+        EXTERNAL_SORT_SUCCESS == state,
+        "[TestExternalSort] unit=%zu, label=%s, expected=%d, got=%d",
+        unit->index,
+        data->label,
+        EXTERNAL_SORT_SUCCESS,
+        state
+    );
+
+    FILE* file = fopen(output, "rb");
+    ASSERT(file, "[TestExternalSort] unit=%zu, label=%s, missing output", unit->index, data->label);
+
+    // Every input sequence number must appear exactly once, in key order.
+    uint8_t* seen = calloc(data->count ? data->count : 1, 1);
+    ExternalRecord previous = {0};
+    ExternalRecord record;
+    size_t count = 0;
+    bool ordered = true;
+    bool unique = true;
+    while (1 == fread(&record, sizeof(record), 1, file)) {
+        if (count > 0 && record.key < previous.key) {
+            ordered = false;
+        }
+        if (record.sequence >= data->count || seen[record.sequence]++) {
+            unique = false;
+        }
+        previous = record;
+        count++;
+    }
+    fclose(file);
+    free(seen);
+    remove(input);
+    remove(output);
+
+    ASSERT(
+        count == data->count && ordered && unique,
+        "[TestExternalSort] unit=%zu, label=%s, count=%zu/%zu, ordered=%d, unique=%d",
+        unit->index,
+        data->label,
+        count,
+        data->count,
+        ordered,
+        unique
+    );
+
+    return 0;
+}
+
+int test_suite_external_sort(void) {
+    static TestExternalSort data[] = {
+        {"empty", 0, 16, 1 << 16, 1 << 12, 4, false, false, true},
+        {"single run", 1000, 1 << 20, 1 << 20, 1 << 12, 4, false, false, true},
+        {"multi pass", 100000, 1 << 20, 1 << 16, 1 << 12, 4, false, false, true},
+        {"duplicates", 100000, 16, 1 << 16, 1 << 12, 8, false, false, true},
+        {"synchronous", 50000, 1 << 20, 1 << 16, 1 << 12, 3, false, false, false},
+        {"mmap", 100000, 1 << 20, 1 << 16, 1 << 12, 4, true, false, true},
+        {"direct", 100000, 1 << 20, 1 << 17, 1 << 13, 4, false, true, true},
+        {"odd buffer", 30011, 1 << 20, 1 << 16, 1000, 5, false, false, true},
+    };
+
+    size_t count = sizeof(data) / sizeof(TestExternalSort);
+    TestUnit units[count];
+    for (size_t i = 0; i < count; i++) {
+        units[i].data = &data[i];
+    }
+
+    TestGroup group = {
+        .name = "external_sort",
+        .count = count,
+        .units = units,
+        .run = test_group_external_sort,
+    };
+
+    return test_group_run(&group);
+}
+
+/** @} */
+
+int main(void) {
+    TestSuite suites[] = {
+        {"external_sort", test_suite_external_sort},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
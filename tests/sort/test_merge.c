@@ -0,0 +1,186 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/sort/test_merge.c
+ */
+
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "sort/merge.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Records carry their input position so stability can be checked after sorting.
+typedef struct MergeRecord {
+    uint32_t key;
+    uint32_t position;
+} MergeRecord;
+
+typedef enum MergePattern {
+    MERGE_PATTERN_RANDOM,
+    MERGE_PATTERN_SORTED,
+    MERGE_PATTERN_REVERSED,
+    MERGE_PATTERN_NEARLY_SORTED,
+    MERGE_PATTERN_APPEND, // sorted prefix with a random tail
+    MERGE_PATTERN_SAWTOOTH, // many alternating ascending and descending runs
+} MergePattern;
+
+typedef struct TestMerge {
+    const char* label;
+    size_t count;
+    uint32_t range;
+    MergePattern pattern;
+} TestMerge;
+
+static int merge_key_compare(const void* a, const void* b) {
+    uint32_t ka = ((const MergeRecord*) a)->key;
+    uint32_t kb = ((const MergeRecord*) b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+static MergeRecord* merge_generate(const TestMerge* data) {
+    MergeRecord* records = malloc((data->count ? data->count : 1) * sizeof(MergeRecord));
+    lehmer_initialize(LEHMER_SEED);
+
+    for (size_t i = 0; i < data->count; i++) {
+        uint32_t key = (uint32_t) lehmer_generate_int32() % data->range;
+        switch (data->pattern) {
+            case MERGE_PATTERN_SORTED:
+                key = (uint32_t) (i * data->range / data->count);
+                break;
+            case MERGE_PATTERN_REVERSED:
+                key = (uint32_t) ((data->count - i) * data->range / data->count);
+                break;
+            case MERGE_PATTERN_NEARLY_SORTED:
+                key = 0 == key % 16 ? key : (uint32_t) (i * data->range / data->count);
+                break;
+            case MERGE_PATTERN_APPEND:
+                key = i < data->count * 9 / 10 ? (uint32_t) (i * data->range / data->count) : key;
+                break;
+            case MERGE_PATTERN_SAWTOOTH:
+                key = (uint32_t) ((i / 100) % 2 ? 100 - i % 100 : i % 100) % data->range;
+                break;
+            default:
+                break;
+        }
+        records[i] = (MergeRecord){key, (uint32_t) i};
+    }
+
+    return records;
+}
+
+// Sorted by key, and equal keys keep their input order.
+static bool merge_is_stable(const MergeRecord* records, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (records[i - 1].key > records[i].key) {
+            return false;
+        }
+        if (records[i - 1].key == records[i].key
+            && records[i - 1].position > records[i].position) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static TestMerge merge_cases[] = {
+    {"empty", 0, 100, MERGE_PATTERN_RANDOM},
+    {"single", 1, 100, MERGE_PATTERN_RANDOM},
+    {"small", 31, 8, MERGE_PATTERN_RANDOM},
+    {"random", 20000, 1 << 20, MERGE_PATTERN_RANDOM},
+    {"duplicates", 20000, 7, MERGE_PATTERN_RANDOM},
+    {"sorted", 20000, 1000, MERGE_PATTERN_SORTED},
+    {"reversed", 20000, 1000, MERGE_PATTERN_REVERSED},
+    {"nearly sorted", 20000, 1 << 16, MERGE_PATTERN_NEARLY_SORTED},
+    {"append", 20000, 1 << 16, MERGE_PATTERN_APPEND},
+    {"sawtooth", 20000, 101, MERGE_PATTERN_SAWTOOTH},
+};
+
+#define MERGE_CASE_COUNT (sizeof(merge_cases) / sizeof(TestMerge))
+
+// Buffer capacities in records; SIZE_MAX selects the allocating entry point.
+static size_t merge_buffer_records = 0;
+
+/**
+ * @name Merge Sort
+ * {@
+ */
+
+int test_group_merge_sort(TestUnit* unit) {
+    TestMerge* data = (TestMerge*) unit->data;
+
+    MergeRecord* records = merge_generate(data);
+    if (SIZE_MAX == merge_buffer_records) {
+        merge_sort(records, data->count, sizeof(MergeRecord), merge_key_compare);
+    } else {
+        size_t size = merge_buffer_records * sizeof(MergeRecord);
+        void* buffer = size ? malloc(size) : NULL;
+        merge_sort_buffer(records, data->count, sizeof(MergeRecord), merge_key_compare, buffer, size);
+        free(buffer);
+    }
+
+    bool stable = merge_is_stable(records, data->count);
+    free(records);
+
+    ASSERT(
+        stable,
+        "[TestMergeSort] unit=%zu, label=%s, count=%zu, buffer=%zu, stable=%d",
+        unit->index,
+        data->label,
+        data->count,
+        merge_buffer_records,
+        stable
+    );
+
+    return 0;
+}
+
+/** @} */
+
+static int merge_suite_run(const char* name, size_t buffer_records) {
+    TestUnit units[MERGE_CASE_COUNT];
+    for (size_t i = 0; i < MERGE_CASE_COUNT; i++) {
+        units[i].data = &merge_cases[i];
+    }
+
+    TestGroup group = {
+        .name = name,
+        .count = MERGE_CASE_COUNT,
+        .units = units,
+        .run = test_group_merge_sort,
+    };
+
+    merge_buffer_records = buffer_records;
+    return test_group_run(&group);
+}
+
+int test_suite_merge_sort(void) {
+    return merge_suite_run("merge_sort", SIZE_MAX);
+}
+
+int test_suite_merge_sort_bounded(void) {
+    return merge_suite_run("merge_sort_buffer(64)", 64);
+}
+
+int test_suite_merge_sort_unbuffered(void) {
+    return merge_suite_run("merge_sort_buffer(0)", 0);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"merge_sort", test_suite_merge_sort},
+        {"merge_sort_bounded", test_suite_merge_sort_bounded},
+        {"merge_sort_unbuffered", test_suite_merge_sort_unbuffered},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
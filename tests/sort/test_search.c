@@ -0,0 +1,195 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/sort/test_search.c
+ */
+
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "sort/search.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct TestSearch {
+    const char* label;
+    size_t count;
+    uint32_t range; // 0 draws from the full int32_t range
+} TestSearch;
+
+static int search_compare(const void* a, const void* b) {
+    int32_t ka = *(const int32_t*) a;
+    int32_t kb = *(const int32_t*) b;
+    return (ka > kb) - (ka < kb);
+}
+
+static int32_t search_draw(uint32_t range) {
+    uint32_t bits = (uint32_t) lehmer_generate_int32() ^ ((uint32_t) lehmer_generate_int32() << 16);
+    return range ? (int32_t) (bits % range) - (int32_t) (range / 2) : (int32_t) bits;
+}
+
+static int32_t* search_generate(const TestSearch* data) {
+    int32_t* keys = malloc((data->count ? data->count : 1) * sizeof(int32_t));
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < data->count; i++) {
+        keys[i] = search_draw(data->range);
+    }
+    if (data->count > 2) {
+        keys[0] = INT32_MIN;
+        keys[1] = INT32_MAX;
+    }
+    qsort(keys, data->count, sizeof(int32_t), search_compare);
+    return keys;
+}
+
+static size_t search_reference(const int32_t* keys, size_t count, int32_t key, bool upper) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (upper ? keys[mid] <= key : keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Probes every stored key, its neighbours, the extremes and random values.
+static bool search_verify(
+    const int32_t* keys,
+    size_t count,
+    const void* layout,
+    size_t (*lower)(const void*, int32_t),
+    size_t (*upper)(const void*, int32_t)
+) {
+    size_t probes = count * 3 + 1000;
+    for (size_t i = 0; i < probes; i++) {
+        int32_t key;
+        if (i < count * 3) {
+            int64_t k = (int64_t) keys[i / 3] + (int64_t) (i % 3) - 1;
+            key = k < INT32_MIN ? INT32_MIN : k > INT32_MAX ? INT32_MAX : (int32_t) k;
+        } else if (i == count * 3) {
+            key = INT32_MIN;
+        } else if (i == count * 3 + 1) {
+            key = INT32_MAX;
+        } else {
+            key = search_draw(0);
+        }
+
+        if (lower(layout, key) != search_reference(keys, count, key, false)
+            || upper(layout, key) != search_reference(keys, count, key, true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t search_eytzinger_lower(const void* layout, int32_t key) {
+    return search_eytzinger_lower_bound(layout, key);
+}
+
+static size_t search_eytzinger_upper(const void* layout, int32_t key) {
+    return search_eytzinger_upper_bound(layout, key);
+}
+
+static size_t search_tree_lower(const void* layout, int32_t key) {
+    return search_tree_lower_bound(layout, key);
+}
+
+static size_t search_tree_upper(const void* layout, int32_t key) {
+    return search_tree_upper_bound(layout, key);
+}
+
+static TestSearch search_cases[] = {
+    {"empty", 0, 100},
+    {"single", 1, 100},
+    {"partial node", 15, 100},
+    {"full node", 16, 100},
+    {"two levels", 17 * 16, 1000},
+    {"duplicates", 5000, 10},
+    {"random", 100000, 0},
+};
+
+#define SEARCH_CASE_COUNT (sizeof(search_cases) / sizeof(TestSearch))
+
+/**
+ * @name Static Search Layouts
+ * {@
+ */
+
+int test_group_search_eytzinger(TestUnit* unit) {
+    TestSearch* data = (TestSearch*) unit->data;
+
+    int32_t* keys = search_generate(data);
+    SearchEytzinger* tree = search_eytzinger_create(keys, data->count);
+    bool ok = tree
+              && search_verify(
+                  keys, data->count, tree, search_eytzinger_lower, search_eytzinger_upper
+              );
+    search_eytzinger_free(tree);
+    free(keys);
+
+    ASSERT(ok, "[TestSearchEytzinger] unit=%zu, label=%s", unit->index, data->label);
+
+    return 0;
+}
+
+int test_group_search_tree(TestUnit* unit) {
+    TestSearch* data = (TestSearch*) unit->data;
+
+    int32_t* keys = search_generate(data);
+    SearchTree* tree = search_tree_create(keys, data->count);
+    bool ok = tree
+              && search_verify(keys, data->count, tree, search_tree_lower, search_tree_upper);
+    search_tree_free(tree);
+    free(keys);
+
+    ASSERT(ok, "[TestSearchTree] unit=%zu, label=%s", unit->index, data->label);
+
+    return 0;
+}
+
+/** @} */
+
+static int search_suite_run(const char* name, TestUnitHook run) {
+    TestUnit units[SEARCH_CASE_COUNT];
+    for (size_t i = 0; i < SEARCH_CASE_COUNT; i++) {
+        units[i].data = &search_cases[i];
+    }
+
+    TestGroup group = {
+        .name = name,
+        .count = SEARCH_CASE_COUNT,
+        .units = units,
+        .run = run,
+    };
+
+    return test_group_run(&group);
+}
+
+int test_suite_search_eytzinger(void) {
+    return search_suite_run("search_eytzinger", test_group_search_eytzinger);
+}
+
+int test_suite_search_tree(void) {
+    return search_suite_run("search_tree", test_group_search_tree);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"search_eytzinger", test_suite_search_eytzinger},
+        {"search_tree", test_suite_search_tree},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,297 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/sort/test_select.c
+ */
+
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "sort/select.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int select_float_compare(const void* a, const void* b) {
+    float fa = *(const float*) a;
+    float fb = *(const float*) b;
+    return (fa > fb) - (fa < fb);
+}
+
+// Fills `data` with values in [0, range), so small ranges produce many ties.
+static void select_fill(float* data, size_t length, uint32_t range) {
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (float) (lehmer_generate_int32() % range) - (float) range / 2;
+    }
+}
+
+typedef struct TestSelect {
+    size_t length;
+    size_t k;
+    uint32_t range;
+} TestSelect;
+
+static TestSelect select_cases[] = {
+    {1, 0, 100},
+    {2, 1, 100},
+    {17, 8, 100},
+    {1000, 0, 1000000},
+    {1000, 999, 1000000},
+    {4096, 40, 1000000},
+    {4096, 40, 3}, // heavy duplicates
+    {32768, 1000, 1 << 20},
+};
+
+#define SELECT_CASE_COUNT (sizeof(select_cases) / sizeof(TestSelect))
+
+/**
+ * @name Select Nth and Partial Sort
+ * {@
+ */
+
+int test_group_select_nth(TestUnit* unit) {
+    TestSelect* data = (TestSelect*) unit->data;
+
+    float* values = malloc(data->length * sizeof(float));
+    float* sorted = malloc(data->length * sizeof(float));
+    select_fill(values, data->length, data->range);
+    memcpy(sorted, values, data->length * sizeof(float));
+    qsort(sorted, data->length, sizeof(float), select_float_compare);
+
+    float nth = select_nth_float(values, data->length, data->k);
+
+    bool partitioned = true;
+    for (size_t i = 0; i < data->length; i++) {
+        if ((i < data->k && values[i] > nth) || (i > data->k && values[i] < nth)) {
+            partitioned = false;
+        }
+    }
+
+    float expected = sorted[data->k];
+    free(values);
+    free(sorted);
+
+    ASSERT(
+        nth == expected && partitioned,
+        "[TestSelectNth] unit=%zu, length=%zu, k=%zu, expected=%f, got=%f, partitioned=%d",
+        unit->index,
+        data->length,
+        data->k,
+        (double) expected,
+        (double) nth,
+        partitioned
+    );
+
+    return 0;
+}
+
+int test_group_select_partial_sort(TestUnit* unit) {
+    TestSelect* data = (TestSelect*) unit->data;
+
+    size_t k = data->k + 1;
+    float* values = malloc(data->length * sizeof(float));
+    float* sorted = malloc(data->length * sizeof(float));
+    select_fill(values, data->length, data->range);
+    memcpy(sorted, values, data->length * sizeof(float));
+    qsort(sorted, data->length, sizeof(float), select_float_compare);
+
+    select_partial_sort_float(values, data->length, k);
+    int diff = memcmp(values, sorted, k * sizeof(float));
+    free(values);
+    free(sorted);
+
+    ASSERT(
+        0 == diff,
+        "[TestSelectPartialSort] unit=%zu, length=%zu, k=%zu, prefix mismatch",
+        unit->index,
+        data->length,
+        k
+    );
+
+    return 0;
+}
+
+/** @} */
+
+/**
+ * @name Top-K, Argsort and Argpartition
+ * {@
+ */
+
+int test_group_select_top_k(TestUnit* unit) {
+    TestSelect* data = (TestSelect*) unit->data;
+
+    size_t k = data->k + 1;
+    float* values = malloc(data->length * sizeof(float));
+    uint32_t* order = malloc(data->length * sizeof(uint32_t));
+    uint32_t* indices = malloc(k * sizeof(uint32_t));
+    float* top = malloc(k * sizeof(float));
+    select_fill(values, data->length, data->range);
+
+    // Stable descending argsort is the reference: ties favor the earlier index.
+    bool sorted = select_argsort_float(values, data->length, order, SELECT_DESCENDING);
+    size_t count = select_top_k_float(values, data->length, k, indices, top);
+
+    bool match = sorted && count == k;
+    for (size_t i = 0; match && i < k; i++) {
+        match = indices[i] == order[i] && top[i] == values[order[i]];
+    }
+
+    // The streaming interface must agree when fed in uneven blocks.
+    SelectTopK* stream = select_top_k_create(k);
+    for (size_t offset = 0; offset < data->length; offset += 37) {
+        size_t length = data->length - offset < 37 ? data->length - offset : 37;
+        select_top_k_push(stream, values + offset, length, offset);
+    }
+    size_t streamed = select_top_k_finish(stream, indices, NULL);
+    select_top_k_free(stream);
+    for (size_t i = 0; match && i < k; i++) {
+        match = indices[i] == order[i];
+    }
+
+    free(values);
+    free(order);
+    free(indices);
+    free(top);
+
+    ASSERT(
+        match && streamed == k,
+        "[TestSelectTopK] unit=%zu, length=%zu, k=%zu, count=%zu, streamed=%zu",
+        unit->index,
+        data->length,
+        k,
+        count,
+        streamed
+    );
+
+    return 0;
+}
+
+int test_group_select_argsort(TestUnit* unit) {
+    TestSelect* data = (TestSelect*) unit->data;
+
+    float* values = malloc(data->length * sizeof(float));
+    uint32_t* indices = malloc(data->length * sizeof(uint32_t));
+    select_fill(values, data->length, data->range);
+
+    bool ok = select_argsort_float(values, data->length, indices, SELECT_ASCENDING);
+    bool stable = true;
+    for (size_t i = 1; ok && i < data->length; i++) {
+        float a = values[indices[i - 1]];
+        float b = values[indices[i]];
+        if (a > b || (a == b && indices[i - 1] > indices[i])) {
+            stable = false;
+        }
+    }
+
+    free(values);
+    free(indices);
+
+    ASSERT(
+        ok && stable,
+        "[TestSelectArgsort] unit=%zu, length=%zu, ok=%d, stable=%d",
+        unit->index,
+        data->length,
+        ok,
+        stable
+    );
+
+    return 0;
+}
+
+int test_group_select_argpartition(TestUnit* unit) {
+    TestSelect* data = (TestSelect*) unit->data;
+
+    float* values = malloc(data->length * sizeof(float));
+    float* sorted = malloc(data->length * sizeof(float));
+    uint32_t* indices = malloc(data->length * sizeof(uint32_t));
+    select_fill(values, data->length, data->range);
+    memcpy(sorted, values, data->length * sizeof(float));
+    qsort(sorted, data->length, sizeof(float), select_float_compare);
+
+    bool ok = select_argpartition_float(values, data->length, data->k, indices, SELECT_DESCENDING);
+
+    // Descending kth value is the (length - 1 - k)th ascending value.
+    float pivot = values[indices[data->k]];
+    float expected = sorted[data->length - 1 - data->k];
+    bool partitioned = true;
+    for (size_t i = 0; i < data->length; i++) {
+        float v = values[indices[i]];
+        if ((i < data->k && v < pivot) || (i > data->k && v > pivot)) {
+            partitioned = false;
+        }
+    }
+
+    free(values);
+    free(sorted);
+    free(indices);
+
+    ASSERT(
+        ok && partitioned && pivot == expected,
+        "[TestSelectArgpartition] unit=%zu, length=%zu, k=%zu, expected=%f, got=%f",
+        unit->index,
+        data->length,
+        data->k,
+        (double) expected,
+        (double) pivot
+    );
+
+    return 0;
+}
+
+/** @} */
+
+static int select_suite_run(const char* name, TestUnitHook run) {
+    TestUnit units[SELECT_CASE_COUNT];
+    for (size_t i = 0; i < SELECT_CASE_COUNT; i++) {
+        units[i].data = &select_cases[i];
+    }
+
+    TestGroup group = {
+        .name = name,
+        .count = SELECT_CASE_COUNT,
+        .units = units,
+        .run = run,
+    };
+
+    return test_group_run(&group);
+}
+
+int test_suite_select_nth(void) {
+    return select_suite_run("select_nth_float", test_group_select_nth);
+}
+
+int test_suite_select_partial_sort(void) {
+    return select_suite_run("select_partial_sort_float", test_group_select_partial_sort);
+}
+
+int test_suite_select_top_k(void) {
+    return select_suite_run("select_top_k_float", test_group_select_top_k);
+}
+
+int test_suite_select_argsort(void) {
+    return select_suite_run("select_argsort_float", test_group_select_argsort);
+}
+
+int test_suite_select_argpartition(void) {
+    return select_suite_run("select_argpartition_float", test_group_select_argpartition);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"select_nth_float", test_suite_select_nth},
+        {"select_partial_sort_float", test_suite_select_partial_sort},
+        {"select_top_k_float", test_suite_select_top_k},
+        {"select_argsort_float", test_suite_select_argsort},
+        {"select_argpartition_float", test_suite_select_argpartition},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}
@@ -0,0 +1,198 @@
+/**
+ * Copyright © 2023 Austin Berrio
+ *
+ * @file tests/sort/test_string.c
+ */
+
+#include "core/logger.h"
+#include "test/unit.h"
+#include "numeric/lehmer.h"
+#include "sort/string.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int string_compare(const void* a, const void* b) {
+    return strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+typedef struct TestStringSort {
+    const char* label;
+    size_t count;
+    size_t alphabet; // Number of fragments to draw from
+    size_t parts; // Maximum fragments per string
+} TestStringSort;
+
+// Path-like and multi-byte fragments produce long shared prefixes and non-ASCII bytes.
+static const char* string_fragments[] = {
+    "/usr/",
+    "/usr/lib/",
+    "include/",
+    "a",
+    "b",
+    "ab",
+    "Γεια",
+    "こんにちは",
+    "\xF0\x9F\x98\x80", // U+1F600
+    "z",
+    "~",
+    "",
+};
+
+static char** string_generate(const TestStringSort* data) {
+    size_t alphabet = data->alphabet;
+    if (alphabet > sizeof(string_fragments) / sizeof(string_fragments[0])) {
+        alphabet = sizeof(string_fragments) / sizeof(string_fragments[0]);
+    }
+
+    char** strings = malloc((data->count ? data->count : 1) * sizeof(char*));
+    lehmer_initialize(LEHMER_SEED);
+    for (size_t i = 0; i < data->count; i++) {
+        char buffer[512] = {0};
+        size_t parts = (size_t) lehmer_generate_int32() % (data->parts + 1);
+        for (size_t p = 0; p < parts; p++) {
+            strcat(buffer, string_fragments[(size_t) lehmer_generate_int32() % alphabet]);
+        }
+        strings[i] = strdup(buffer);
+    }
+    return strings;
+}
+
+static void string_release(char** strings, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(strings[i]);
+    }
+    free(strings);
+}
+
+static bool string_is_sorted(char** strings, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (strcmp(strings[i - 1], strings[i]) > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static TestStringSort string_cases[] = {
+    {"empty", 0, 12, 4},
+    {"single", 1, 12, 4},
+    {"small", 10, 12, 4},
+    {"duplicates", 5000, 2, 2},
+    {"paths", 5000, 3, 20},
+    {"mixed utf-8", 20000, 12, 8},
+    {"long prefixes", 2000, 1, 30},
+};
+
+#define STRING_CASE_COUNT (sizeof(string_cases) / sizeof(TestStringSort))
+
+/**
+ * @name String Sort
+ * {@
+ */
+
+int test_group_string_sort_multikey(TestUnit* unit) {
+    TestStringSort* data = (TestStringSort*) unit->data;
+
+    char** strings = string_generate(data);
+    bool ok = string_sort_multikey(strings, data->count);
+    bool sorted = string_is_sorted(strings, data->count);
+    string_release(strings, data->count);
+
+    ASSERT(
+        ok && sorted,
+        "[TestStringSortMultikey] unit=%zu, label=%s, ok=%d, sorted=%d",
+        unit->index,
+        data->label,
+        ok,
+        sorted
+    );
+
+    return 0;
+}
+
+int test_group_string_sort_radix(TestUnit* unit) {
+    TestStringSort* data = (TestStringSort*) unit->data;
+
+    char** strings = string_generate(data);
+    char** expected = malloc((data->count ? data->count : 1) * sizeof(char*));
+    size_t* lcp = malloc((data->count ? data->count : 1) * sizeof(size_t));
+    memcpy(expected, strings, data->count * sizeof(char*));
+    qsort(expected, data->count, sizeof(char*), string_compare);
+
+    bool ok = string_sort_radix(strings, data->count, lcp);
+
+    bool match = true;
+    bool lcp_match = data->count == 0 || 0 == lcp[0];
+    for (size_t i = 0; i < data->count; i++) {
+        if (0 != strcmp(strings[i], expected[i])) {
+            match = false;
+        }
+        if (i > 0) {
+            size_t n = 0;
+            while (strings[i][n] && strings[i][n] == strings[i - 1][n]) {
+                n++;
+            }
+            if (lcp[i] != n) {
+                lcp_match = false;
+            }
+        }
+    }
+
+    free(expected);
+    free(lcp);
+    string_release(strings, data->count);
+
+    ASSERT(
+        ok && match && lcp_match,
+        "[TestStringSortRadix] unit=%zu, label=%s, ok=%d, match=%d, lcp=%d",
+        unit->index,
+        data->label,
+        ok,
+        match,
+        lcp_match
+    );
+
+    return 0;
+}
+
+/** @} */
+
+static int string_suite_run(const char* name, TestUnitHook run) {
+    TestUnit units[STRING_CASE_COUNT];
+    for (size_t i = 0; i < STRING_CASE_COUNT; i++) {
+        units[i].data = &string_cases[i];
+    }
+
+    TestGroup group = {
+        .name = name,
+        .count = STRING_CASE_COUNT,
+        .units = units,
+        .run = run,
+    };
+
+    return test_group_run(&group);
+}
+
+int test_suite_string_sort_multikey(void) {
+    return string_suite_run("string_sort_multikey", test_group_string_sort_multikey);
+}
+
+int test_suite_string_sort_radix(void) {
+    return string_suite_run("string_sort_radix", test_group_string_sort_radix);
+}
+
+int main(void) {
+    TestSuite suites[] = {
+        {"string_sort_multikey", test_suite_string_sort_multikey},
+        {"string_sort_radix", test_suite_string_sort_radix},
+    };
+
+    int result = 0;
+    size_t count = sizeof(suites) / sizeof(TestSuite);
+    for (size_t i = 0; i < count; i++) {
+        result |= test_suite_run(&suites[i]);
+    }
+    return result;
+}